@@ -0,0 +1,849 @@
+/*
+   GameRiff - Framework for creating various video game services
+   Offline content cooker
+   Copyright (C) 2011, Shaun Leach.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are
+   met:
+  
+       * Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+       * Redistributions in binary form must reproduce the above
+   copyright notice, this list of conditions and the following disclaimer
+   in the documentation and/or other materials provided with the
+   distribution.
+  
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "Pch.h"
+#include "SchemaGen.h"
+
+LOG_DEFINE_MODULE(Cook);
+
+//////////////////////////////////////////////////////
+//
+// Converts a tree of XML object files into binary files in a mirrored tree.
+//  Reflected types register themselves through static initializers, so the
+//  classes that can be cooked are the ones linked into this executable.
+//
+// Sources that hash the same as on the last run, and whose output still
+//  exists, are skipped. Files are cooked in parallel.
+//
+// With -migrate, XML files that needed versioning, conversion functions or
+//  aliases to load are saved again in place at the current versions and
+//  names, so they take the direct path at load time. Files that were saved
+//  by a newer build or reference unregistered classes are left alone.
+//
+// With -schema, the layout of every linked type is written out, and 
+//  -generate turns a schema into a standalone header that loads cooked 
+//  files without the reflection runtime.
+//
+// With -pack, every file below a directory goes into one pack file keyed by
+//  its relative path, optionally compressed, for mounting at load time. 
+//  -dict trains a dictionary on a sample of the files and compresses each 
+//  against it, which suits many small files far better than -lz4.
+//
+
+//////////////////////////////////////////////////////
+//
+// Internal constants
+//
+
+static const uint32     s_manifestMagic     = 0x4B4F4F43;   // "COOK"
+
+// Bump when the cooked output changes for the same source, such as a new 
+//  binary format, to force a full cook
+static const uint32     s_manifestVersion   = 1;
+
+static const chargr   * s_manifestName      = L"cook.manifest";
+static const unsigned   s_readChunkSize     = 64 * 1024;
+static const unsigned   s_maxThreads        = 64;
+
+// Dictionaries train on at most this much of the files going in the pack
+static const unsigned   s_maxDictSamples    = 16 * 1024 * 1024;
+
+#define COOK_MEM_FLAGS  MemFlags(MEM_ARENA_DEFAULT, MEM_CAT_FILEIO)
+
+//////////////////////////////////////////////////////
+//
+// Internal types
+//
+
+enum ECookResult {
+    COOK_RESULT_PENDING,
+    COOK_RESULT_COOKED,     // Written out, cooked or migrated
+    COOK_RESULT_SKIPPED,    // Already up to date
+    COOK_RESULT_FAILED,
+};
+
+// Sorted by path hash
+struct ManifestEntry {
+    uint64      pathHash;
+    uint64      sourceHash;
+};
+
+struct CookFile {
+    unsigned        pathOffset;
+    uint64          pathHash;
+    uint64          sourceHash;
+    ECookResult     result;
+};
+
+struct CookContext {
+    CookContext() :
+        sourceRoot(NULL),
+        targetRoot(NULL),
+        force(false),
+        migrate(false),
+        paths(NULL),
+        pathsUsed(0),
+        pathsCapacity(0),
+        files(NULL),
+        numFiles(0),
+        filesCapacity(0),
+        manifest(NULL),
+        manifestCount(0),
+        nextFile(0),
+        numCooked(0),
+        numSkipped(0),
+        numFailed(0),
+        numOldVersions(0),
+        numAliasedClasses(0),
+        numAliasedMembers(0),
+        numConvertedMembers(0),
+        numDeprecatedMembers(0),
+        numUnknownMembers(0)
+    {
+    }
+    ~CookContext() {
+        if (paths != NULL) 
+            delete [] paths;
+        if (files != NULL) 
+            delete [] files;
+        if (manifest != NULL) 
+            delete [] manifest;
+    }
+
+    const chargr      * sourceRoot;
+    const chargr      * targetRoot;
+    bool                force;
+    bool                migrate;
+
+    // Relative source paths, packed one after another
+    chargr            * paths;
+    unsigned            pathsUsed;
+    unsigned            pathsCapacity;
+
+    CookFile          * files;
+    unsigned            numFiles;
+    unsigned            filesCapacity;
+
+    ManifestEntry     * manifest;
+    unsigned            manifestCount;
+
+    volatile int32      nextFile;
+    volatile int32      numCooked;
+    volatile int32      numSkipped;
+    volatile int32      numFailed;
+
+    // Totals of what migration changed
+    volatile int32      numOldVersions;
+    volatile int32      numAliasedClasses;
+    volatile int32      numAliasedMembers;
+    volatile int32      numConvertedMembers;
+    volatile int32      numDeprecatedMembers;
+    volatile int32      numUnknownMembers;
+};
+
+//////////////////////////////////////////////////////
+//
+// Internal functions
+//
+
+//====================================================
+template <typename t_type>
+static void GrowArray(t_type ** array, unsigned * capacity, unsigned count, unsigned needed) {
+    if (needed <= *capacity) 
+        return;
+
+    unsigned newCapacity = *capacity == 0 ? 1024 : 2 * *capacity;
+    while (newCapacity < needed) 
+        newCapacity *= 2;
+
+    t_type * newArray = new(COOK_MEM_FLAGS) t_type[newCapacity];
+    for (unsigned i = 0; i < count; i++) 
+        newArray[i] = (*array)[i];
+
+    if (*array != NULL) 
+        delete [] *array;
+    *array      = newArray;
+    *capacity   = newCapacity;
+}
+
+//====================================================
+static int CompareManifestEntry(const void * lhs, const void * rhs) {
+    uint64 lhsHash = reinterpret_cast<const ManifestEntry *>(lhs)->pathHash;
+    uint64 rhsHash = reinterpret_cast<const ManifestEntry *>(rhs)->pathHash;
+    if (lhsHash < rhsHash) 
+        return -1;
+    return lhsHash > rhsHash ? 1 : 0;
+}
+
+//====================================================
+static const ManifestEntry * FindManifestEntry(const CookContext * context, uint64 pathHash) {
+    unsigned low  = 0;
+    unsigned high = context->manifestCount;
+    while (low < high) {
+        unsigned mid = (low + high) / 2;
+        const ManifestEntry & entry = context->manifest[mid];
+        if (entry.pathHash == pathHash) 
+            return &entry;
+        if (entry.pathHash < pathHash) 
+            low = mid + 1;
+        else
+            high = mid;
+    }
+
+    return NULL;
+}
+
+//====================================================
+static void AddFile(CookContext * context, const chargr * path, unsigned len) {
+    GrowArray(&context->paths, &context->pathsCapacity, context->pathsUsed, context->pathsUsed + len + 1);
+    GrowArray(&context->files, &context->filesCapacity, context->numFiles, context->numFiles + 1);
+
+    CookFile & file = context->files[context->numFiles++];
+    file.pathOffset = context->pathsUsed;
+    file.pathHash   = HashString64(path).GetValue();
+    file.sourceHash = 0;
+    file.result     = COOK_RESULT_PENDING;
+
+    StrCopy(context->paths + context->pathsUsed, len + 1, path);
+    context->pathsUsed += len + 1;
+}
+
+//====================================================
+static void GatherFile(const chargr * path, bool isDirectory, void * param) {
+    CookContext * context = reinterpret_cast<CookContext *>(param);
+
+    // Directories are seen before their contents, so the target tree exists
+    //  before any worker writes into it
+    if (isDirectory) {
+        if (context->targetRoot == NULL) 
+            return;
+
+        chargr targetPath[FILE_PATH_LENGTH];
+        StrPrintf(targetPath, FILE_PATH_LENGTH, L"%s/%s", context->targetRoot, path);
+        FileCreateDirectory(targetPath);
+        return;
+    }
+
+    unsigned len = StrLen(path, FILE_PATH_LENGTH);
+    if (len < 4 || StrICmp(path + len - 4, L".xml", 4) != 0) 
+        return;
+
+    AddFile(context, path, len);
+}
+
+//====================================================
+static void GatherPackFile(const chargr * path, bool isDirectory, void * param) {
+    if (isDirectory) 
+        return;
+
+    CookContext * context = reinterpret_cast<CookContext *>(param);
+    AddFile(context, path, StrLen(path, FILE_PATH_LENGTH));
+}
+
+//====================================================
+static bool HashSource(const chargr * path, byte * buffer, uint64 * hash) {
+    IRawStreamPtr stream = StreamOpenFile(path);
+    if (stream == NULL) 
+        return false;
+
+    Hash64 contents;
+    EStreamError result = STREAM_ERROR_OK;
+    while (result == STREAM_ERROR_OK) {
+        unsigned bytesRead = 0;
+        result = stream->ReadBytes(buffer, s_readChunkSize, &bytesRead);
+        if (bytesRead > 0) 
+            contents = HashData64(buffer, bytesRead, contents);
+    }
+
+    *hash = contents.GetValue();
+    return result == STREAM_ERROR_EOF;
+}
+
+//====================================================
+static ECookResult CookToBinary(const chargr * sourcePath, const chargr * targetPath) {
+    IStructuredTextStreamPtr source = StreamOpenXML(sourcePath);
+    if (source == NULL) 
+        return COOK_RESULT_FAILED;
+
+    ReflClass * inst = ReflLibrary::Deserialize(source, MemFlags(MEM_ARENA_DEFAULT, MEM_CAT_REFLECTION));
+    if (inst == NULL) 
+        return COOK_RESULT_FAILED;
+
+    bool result = false;
+    IRawStreamPtr target = StreamCreateFile(targetPath);
+    if (target != NULL) {
+        DataStream stream(target);
+        result = ReflLibrary::Serialize(&stream, inst);
+    }
+
+    ReflLibrary::DestroyGraph(inst);
+    return result ? COOK_RESULT_COOKED : COOK_RESULT_FAILED;
+}
+
+//====================================================
+static void CookWorker(void * param) {
+    CookContext * context = reinterpret_cast<CookContext *>(param);
+    byte * buffer = new(COOK_MEM_FLAGS) byte[s_readChunkSize];
+
+    for (;;) {
+        int32 index = AtomicIncrement(&context->nextFile) - 1;
+        if (index >= static_cast<int32>(context->numFiles)) 
+            break;
+
+        CookFile & file = context->files[index];
+        const chargr * path = context->paths + file.pathOffset;
+
+        chargr sourcePath[FILE_PATH_LENGTH];
+        StrPrintf(sourcePath, FILE_PATH_LENGTH, L"%s/%s", context->sourceRoot, path);
+
+        // Same relative path with the extension swapped
+        chargr targetPath[FILE_PATH_LENGTH];
+        StrPrintf(targetPath, FILE_PATH_LENGTH, L"%s/%s", context->targetRoot, path);
+        unsigned targetLen = StrLen(targetPath, FILE_PATH_LENGTH);
+        StrCopy(targetPath + targetLen - 3, 4, L"bin");
+
+        if (!HashSource(sourcePath, buffer, &file.sourceHash)) 
+            file.result = COOK_RESULT_FAILED;
+        else {
+            const ManifestEntry * entry = FindManifestEntry(context, file.pathHash);
+            if (!context->force && entry != NULL && entry->sourceHash == file.sourceHash && FileExists(targetPath)) 
+                file.result = COOK_RESULT_SKIPPED;
+            else
+                file.result = CookToBinary(sourcePath, targetPath);
+        }
+
+        if (file.result == COOK_RESULT_COOKED) 
+            AtomicIncrement(&context->numCooked);
+        else if (file.result == COOK_RESULT_SKIPPED) 
+            AtomicIncrement(&context->numSkipped);
+        else {
+            AtomicIncrement(&context->numFailed);
+            LOG(LOG_PRIORITY_ERROR, "Failed to cook %s", sourcePath);
+        }
+    }
+
+    delete [] buffer;
+}
+
+//====================================================
+static bool NeedsMigration(const ReflLoadReport & report) {
+    return report.oldVersions       > 0 
+        || report.aliasedClasses    > 0 
+        || report.aliasedMembers    > 0 
+        || report.convertedMembers  > 0 
+        || report.deprecatedMembers > 0 
+        || report.unknownMembers    > 0;
+}
+
+//====================================================
+static ECookResult MigrateFile(const chargr * path, bool force, ReflLoadReport * report) {
+    ReflClass * inst = NULL;
+    {
+        IStructuredTextStreamPtr source = StreamOpenXML(path);
+        if (source == NULL) 
+            return COOK_RESULT_FAILED;
+
+        inst = ReflLibrary::Deserialize(source, MemFlags(MEM_ARENA_DEFAULT, MEM_CAT_REFLECTION), report);
+        if (inst == NULL) 
+            return COOK_RESULT_FAILED;
+    }
+
+    // Saving would lose data that this build doesn't understand
+    ECookResult result = COOK_RESULT_SKIPPED;
+    if (report->newerVersions > 0 || report->unknownClasses > 0) {
+        LOG(LOG_PRIORITY_WARN, "Not migrating %s, it has newer versions or unregistered classes", path);
+        result = COOK_RESULT_FAILED;
+    }
+    else if (force || NeedsMigration(*report)) {
+        result = COOK_RESULT_FAILED;
+        IStructuredTextStreamPtr target = StreamCreateXML(path);
+        if (target != NULL && ReflLibrary::Serialize(target, inst) && target->Save() == STREAM_ERROR_OK) 
+            result = COOK_RESULT_COOKED;
+    }
+
+    ReflLibrary::DestroyGraph(inst);
+    return result;
+}
+
+//====================================================
+static void MigrateWorker(void * param) {
+    CookContext * context = reinterpret_cast<CookContext *>(param);
+
+    for (;;) {
+        int32 index = AtomicIncrement(&context->nextFile) - 1;
+        if (index >= static_cast<int32>(context->numFiles)) 
+            break;
+
+        CookFile & file = context->files[index];
+        chargr sourcePath[FILE_PATH_LENGTH];
+        StrPrintf(sourcePath, FILE_PATH_LENGTH, L"%s/%s", context->sourceRoot, context->paths + file.pathOffset);
+
+        ReflLoadReport report;
+        file.result = MigrateFile(sourcePath, context->force, &report);
+        if (file.result == COOK_RESULT_SKIPPED) {
+            AtomicIncrement(&context->numSkipped);
+            continue;
+        }
+        else if (file.result == COOK_RESULT_FAILED) {
+            AtomicIncrement(&context->numFailed);
+            LOG(LOG_PRIORITY_ERROR, "Failed to migrate %s", sourcePath);
+            continue;
+        }
+
+        AtomicIncrement(&context->numCooked);
+        AtomicAdd(&context->numOldVersions,         report.oldVersions);
+        AtomicAdd(&context->numAliasedClasses,      report.aliasedClasses);
+        AtomicAdd(&context->numAliasedMembers,      report.aliasedMembers);
+        AtomicAdd(&context->numConvertedMembers,    report.convertedMembers);
+        AtomicAdd(&context->numDeprecatedMembers,   report.deprecatedMembers);
+        AtomicAdd(&context->numUnknownMembers,      report.unknownMembers);
+
+        printf(
+            "Migrated %S: %u old versions, %u aliased classes, %u aliased members, %u conversions, %u deprecated members, %u dropped members\n", 
+            sourcePath, 
+            report.oldVersions, 
+            report.aliasedClasses, 
+            report.aliasedMembers, 
+            report.convertedMembers, 
+            report.deprecatedMembers, 
+            report.unknownMembers
+        );
+    }
+}
+
+//====================================================
+static void ReadManifest(CookContext * context) {
+    chargr manifestPath[FILE_PATH_LENGTH];
+    StrPrintf(manifestPath, FILE_PATH_LENGTH, L"%s/%s", context->targetRoot, s_manifestName);
+
+    IRawStreamPtr rawStream = StreamOpenFile(manifestPath);
+    if (rawStream == NULL) 
+        return;
+
+    DataStream stream(rawStream);
+    uint32 magic    = 0;
+    uint32 version  = 0;
+    uint32 count    = 0;
+    stream.Read(magic);
+    stream.Read(version);
+    stream.Read(count);
+    if (magic != s_manifestMagic || version != s_manifestVersion) {
+        LOG(LOG_PRIORITY_INFO, "Cook manifest %s is out of date", manifestPath);
+        return;
+    }
+
+    ManifestEntry * entries = new(COOK_MEM_FLAGS) ManifestEntry[count];
+    if (stream.ReadBytes(entries, count * sizeof(ManifestEntry)) != STREAM_ERROR_OK) {
+        LOG(LOG_PRIORITY_WARN, "Cook manifest %s is truncated", manifestPath);
+        delete [] entries;
+        return;
+    }
+
+    context->manifest       = entries;
+    context->manifestCount  = count;
+}
+
+//====================================================
+static bool WriteManifest(const CookContext * context) {
+    // Failed files are left out so they're retried next time
+    ManifestEntry * entries = new(COOK_MEM_FLAGS) ManifestEntry[context->numFiles + 1];
+    uint32 count = 0;
+    for (unsigned i = 0; i < context->numFiles; i++) {
+        const CookFile & file = context->files[i];
+        if (file.result != COOK_RESULT_COOKED && file.result != COOK_RESULT_SKIPPED) 
+            continue;
+
+        entries[count].pathHash     = file.pathHash;
+        entries[count].sourceHash   = file.sourceHash;
+        count++;
+    }
+    qsort(entries, count, sizeof(ManifestEntry), CompareManifestEntry);
+
+    chargr manifestPath[FILE_PATH_LENGTH];
+    StrPrintf(manifestPath, FILE_PATH_LENGTH, L"%s/%s", context->targetRoot, s_manifestName);
+
+    bool result = false;
+    IRawStreamPtr rawStream = StreamCreateFile(manifestPath);
+    if (rawStream != NULL) {
+        DataStream stream(rawStream);
+        stream.Write<uint32>(s_manifestMagic);
+        stream.Write<uint32>(s_manifestVersion);
+        stream.Write<uint32>(count);
+        result = stream.WriteBytes(entries, count * sizeof(ManifestEntry)) == STREAM_ERROR_OK;
+        result = stream.Flush() == STREAM_ERROR_OK && result;
+    }
+
+    delete [] entries;
+    return result;
+}
+
+//====================================================
+static void TrimTrailingSeparator(chargr * path) {
+    unsigned len = StrLen(path, FILE_PATH_LENGTH);
+    while (len > 1 && (path[len - 1] == L'/' || path[len - 1] == L'\\')) 
+        path[--len] = 0;
+}
+
+//====================================================
+static void PrintUsage() {
+    printf("Usage: cook <sourceDir> <targetDir> [-j threads] [-force]\n");
+    printf("       cook -migrate <contentDir> [-j threads] [-force]\n");
+    printf("       cook -schema <schema.xml>\n");
+    printf("       cook -generate <schema.xml> <header.h>\n");
+    printf("       cook -pack <contentDir> <pack> [-lz4] [-dict] [-dictsize bytes] [-crc] [-align bytes]\n");
+}
+
+//====================================================
+static int RunSchema(int argc, char * argv[]) {
+    bool generate = StrCmp(argv[1], "-generate", 10) == 0;
+    if (argc != (generate ? 4 : 3)) {
+        PrintUsage();
+        return 1;
+    }
+
+    chargr schemaPath[FILE_PATH_LENGTH];
+    StrUtf8ConvertToCharGr(argv[2], schemaPath, FILE_PATH_LENGTH);
+
+    LogInit();
+    ReflInitialize();
+
+    bool result = false;
+    if (generate) {
+        chargr headerPath[FILE_PATH_LENGTH];
+        StrUtf8ConvertToCharGr(argv[3], headerPath, FILE_PATH_LENGTH);
+        result = SchemaGenerate(schemaPath, headerPath);
+        if (!result) 
+            printf("Failed to generate %S from %S\n", headerPath, schemaPath);
+    }
+    else {
+        result = SchemaExport(schemaPath);
+        if (!result) 
+            printf("Failed to write schema %S\n", schemaPath);
+    }
+
+    LogClose();
+    return result ? 0 : 1;
+}
+
+//====================================================
+static bool PackSourceFile(IPackWriterPtr writer, const chargr * sourcePath, const chargr * path, EPackCompression compression, unsigned flags) {
+    EFileResult result;
+    IMappedFilePtr file = FileOpenMapped(sourcePath, FILE_MAP_HINT_SEQUENTIAL, &result);
+    if (result != FILE_RESULT_OK || file->GetSize() > 0xffffffffULL) 
+        return false;
+
+    unsigned size = static_cast<unsigned>(file->GetSize());
+    if (size == 0) 
+        return writer->AddEntry(path, NULL, 0, compression, flags) == STREAM_ERROR_OK;
+
+    IFileViewPtr view = file->MapView(0, size);
+    if (view == NULL || view->GetSize() != size) 
+        return false;
+    return writer->AddEntry(path, view->GetData(), size, compression, flags) == STREAM_ERROR_OK;
+}
+
+//====================================================
+static bool ReadSourceFile(const chargr * sourcePath, byte * buffer, unsigned size) {
+    EFileResult result;
+    IMappedFilePtr file = FileOpenMapped(sourcePath, FILE_MAP_HINT_SEQUENTIAL, &result);
+    if (result != FILE_RESULT_OK || file->GetSize() != size) 
+        return false;
+
+    IFileViewPtr view = file->MapView(0, size);
+    if (view == NULL || view->GetSize() != size) 
+        return false;
+    memcpy(buffer, view->GetData(), size);
+    return true;
+}
+
+//====================================================
+// Samples the files small enough to be compressed against the dictionary,
+//  spread evenly over the pack when they don't all fit
+static ILZ4DictionaryPtr TrainPackDictionary(CookContext * context, unsigned dictSize) {
+    unsigned * sizes = new(COOK_MEM_FLAGS) unsigned[context->numFiles + 1];
+    uint64 total = 0;
+    for (unsigned i = 0; i < context->numFiles; i++) {
+        chargr sourcePath[FILE_PATH_LENGTH];
+        StrPrintf(sourcePath, FILE_PATH_LENGTH, L"%s/%s", context->sourceRoot, context->paths + context->files[i].pathOffset);
+
+        EFileResult result;
+        IMappedFilePtr file = FileOpenMapped(sourcePath, FILE_MAP_HINT_NONE, &result);
+        sizes[i] = 0;
+        if (result == FILE_RESULT_OK && file->GetSize() <= PACK_DICT_MAX_ENTRY_SIZE) 
+            sizes[i] = static_cast<unsigned>(file->GetSize());
+        total += sizes[i];
+    }
+
+    unsigned budget     = total < s_maxDictSamples ? static_cast<unsigned>(total) : s_maxDictSamples;
+    unsigned stride     = static_cast<unsigned>(total / s_maxDictSamples) + 1;
+    byte * samples      = new(COOK_MEM_FLAGS) byte[budget + 1];
+    unsigned * used     = new(COOK_MEM_FLAGS) unsigned[context->numFiles + 1];
+    unsigned numSamples = 0;
+    unsigned sampled    = 0;
+    for (unsigned i = 0; i < context->numFiles; i += stride) {
+        if (sizes[i] == 0 || sizes[i] > budget - sampled) 
+            continue;
+
+        chargr sourcePath[FILE_PATH_LENGTH];
+        StrPrintf(sourcePath, FILE_PATH_LENGTH, L"%s/%s", context->sourceRoot, context->paths + context->files[i].pathOffset);
+        if (!ReadSourceFile(sourcePath, samples + sampled, sizes[i])) 
+            continue;
+
+        used[numSamples++]  = sizes[i];
+        sampled            += sizes[i];
+    }
+
+    ILZ4DictionaryPtr dictionary = StreamTrainLZ4Dictionary(samples, used, numSamples, dictSize);
+    delete [] used;
+    delete [] samples;
+    delete [] sizes;
+    return dictionary;
+}
+
+//====================================================
+static int RunPack(int argc, char * argv[]) {
+    if (argc < 4) {
+        PrintUsage();
+        return 1;
+    }
+
+    chargr sourceRoot[FILE_PATH_LENGTH];
+    chargr packPath[FILE_PATH_LENGTH];
+    StrUtf8ConvertToCharGr(argv[2], sourceRoot, FILE_PATH_LENGTH);
+    StrUtf8ConvertToCharGr(argv[3], packPath, FILE_PATH_LENGTH);
+    TrimTrailingSeparator(sourceRoot);
+
+    EPackCompression compression = PACK_COMPRESSION_NONE;
+    unsigned flags = 0;
+    unsigned alignment = PACK_DEFAULT_ALIGNMENT;
+    unsigned dictSize = STREAM_LZ4_DICT_SIZE;
+    for (int arg = 4; arg < argc; arg++) {
+        if (StrCmp(argv[arg], "-lz4", 5) == 0) 
+            compression = PACK_COMPRESSION_LZ4;
+        else if (StrCmp(argv[arg], "-dict", 6) == 0) 
+            compression = PACK_COMPRESSION_LZ4_DICT;
+        else if (StrCmp(argv[arg], "-dictsize", 10) == 0 && arg + 1 < argc) 
+            dictSize = atoi(argv[++arg]);
+        else if (StrCmp(argv[arg], "-crc", 5) == 0) 
+            flags |= PACK_ENTRY_CHECKED;
+        else if (StrCmp(argv[arg], "-align", 7) == 0 && arg + 1 < argc) 
+            alignment = atoi(argv[++arg]);
+        else {
+            PrintUsage();
+            return 1;
+        }
+    }
+
+    if (alignment < 1) 
+        alignment = 1;
+
+    LogInit();
+
+    CookContext context;
+    context.sourceRoot = sourceRoot;
+    if (FileFindRecursive(sourceRoot, GatherPackFile, &context) == FILE_RESULT_DOESNT_EXIST) {
+        printf("Source directory %S doesn't exist\n", sourceRoot);
+        LogClose();
+        return 1;
+    }
+
+    IPackWriterPtr writer = StreamCreatePack(packPath, alignment);
+    if (writer == NULL) {
+        printf("Failed to create pack %S\n", packPath);
+        LogClose();
+        return 1;
+    }
+
+    // Entries fall back to plain LZ4 when there's nothing to train on
+    if (compression == PACK_COMPRESSION_LZ4_DICT) 
+        writer->SetDictionary(TrainPackDictionary(&context, dictSize));
+
+    unsigned numFailed = 0;
+    for (unsigned i = 0; i < context.numFiles; i++) {
+        const chargr * path = context.paths + context.files[i].pathOffset;
+        chargr sourcePath[FILE_PATH_LENGTH];
+        StrPrintf(sourcePath, FILE_PATH_LENGTH, L"%s/%s", sourceRoot, path);
+        if (!PackSourceFile(writer, sourcePath, path, compression, flags)) {
+            LOG(LOG_PRIORITY_ERROR, "Failed to pack %s", sourcePath);
+            numFailed++;
+        }
+    }
+
+    EStreamError result = writer->Close();
+    writer = IPackWriterPtr(NULL);
+    if (result == STREAM_ERROR_BADDATA) 
+        printf("Two paths in %S hash the same\n", sourceRoot);
+
+    // Reopened to report what was stored, which also checks the pack loads
+    IPackFilePtr pack = result == STREAM_ERROR_OK ? StreamOpenPack(packPath) : IPackFilePtr(NULL);
+    if (pack == NULL) {
+        printf("Failed to write pack %S\n", packPath);
+        LogClose();
+        return 1;
+    }
+
+    uint64 rawSize  = 0;
+    uint64 size     = 0;
+    for (unsigned i = 0; i < pack->GetNumEntries(); i++) {
+        rawSize += pack->GetEntry(i)->rawSize;
+        size    += pack->GetEntry(i)->size;
+    }
+
+    // The dictionary is stored once and counts toward the pack's size
+    ILZ4DictionaryPtr dictionary = pack->GetDictionary();
+    if (dictionary != NULL) 
+        size += dictionary->GetSize();
+
+    printf(
+        "%u files: %u packed, %u failed, %llu bytes stored in %llu\n", 
+        context.numFiles, 
+        pack->GetNumEntries(), 
+        numFailed, 
+        rawSize, 
+        size
+    );
+    if (dictionary != NULL) 
+        printf("Dictionary of %u bytes\n", dictionary->GetSize());
+
+    LogClose();
+    return numFailed > 0 ? 1 : 0;
+}
+
+//////////////////////////////////////////////////////
+//
+// Main
+//
+
+//====================================================
+int main(int argc, char * argv[]) {
+    chargr sourceRoot[FILE_PATH_LENGTH];
+    chargr targetRoot[FILE_PATH_LENGTH];
+    unsigned numThreads = ThreadNumCores();
+    bool force   = false;
+    bool migrate = argc > 1 && StrCmp(argv[1], "-migrate", 9) == 0;
+
+    if (argc < 3) {
+        PrintUsage();
+        return 1;
+    }
+
+    if (StrCmp(argv[1], "-schema", 8) == 0 || StrCmp(argv[1], "-generate", 10) == 0) 
+        return RunSchema(argc, argv);
+    if (StrCmp(argv[1], "-pack", 6) == 0) 
+        return RunPack(argc, argv);
+
+    // Migration rewrites the source tree in place, so there's no target
+    StrUtf8ConvertToCharGr(argv[migrate ? 2 : 1], sourceRoot, FILE_PATH_LENGTH);
+    TrimTrailingSeparator(sourceRoot);
+    if (!migrate) {
+        StrUtf8ConvertToCharGr(argv[2], targetRoot, FILE_PATH_LENGTH);
+        TrimTrailingSeparator(targetRoot);
+    }
+
+    for (int arg = 3; arg < argc; arg++) {
+        if (StrCmp(argv[arg], "-force", 7) == 0) 
+            force = true;
+        else if (StrCmp(argv[arg], "-j", 3) == 0 && arg + 1 < argc) 
+            numThreads = atoi(argv[++arg]);
+        else {
+            PrintUsage();
+            return 1;
+        }
+    }
+
+    if (numThreads < 1) 
+        numThreads = 1;
+    else if (numThreads > s_maxThreads) 
+        numThreads = s_maxThreads;
+
+    LogInit();
+    ReflInitialize();
+
+    CookContext context;
+    context.sourceRoot  = sourceRoot;
+    context.targetRoot  = migrate ? NULL : targetRoot;
+    context.force       = force;
+    context.migrate     = migrate;
+
+    if (!migrate) 
+        FileCreateDirectory(targetRoot);
+    if (FileFindRecursive(sourceRoot, GatherFile, &context) == FILE_RESULT_DOESNT_EXIST) {
+        printf("Source directory %S doesn't exist\n", sourceRoot);
+        LogClose();
+        return 1;
+    }
+
+    if (!force && !migrate) 
+        ReadManifest(&context);
+
+    // The main thread works alongside the others
+    ThreadFunc worker = migrate ? MigrateWorker : CookWorker;
+    IThreadPtr threads[s_maxThreads];
+    for (unsigned i = 1; i < numThreads; i++) 
+        threads[i] = ThreadCreate(worker, &context);
+    worker(&context);
+    for (unsigned i = 1; i < numThreads; i++) {
+        if (threads[i] != NULL) 
+            threads[i]->Join();
+    }
+
+    if (migrate) {
+        printf(
+            "%u files: %d migrated, %d up to date, %d failed\n", 
+            context.numFiles, 
+            context.numCooked, 
+            context.numSkipped, 
+            context.numFailed
+        );
+        printf(
+            "Changed %d old versions, %d aliased classes, %d aliased members, %d conversions, %d deprecated members, %d dropped members\n", 
+            context.numOldVersions, 
+            context.numAliasedClasses, 
+            context.numAliasedMembers, 
+            context.numConvertedMembers, 
+            context.numDeprecatedMembers, 
+            context.numUnknownMembers
+        );
+    }
+    else {
+        if (!WriteManifest(&context)) 
+            LOG(LOG_PRIORITY_ERROR, "Failed to write cook manifest in %s", targetRoot);
+
+        printf(
+            "%u files: %d cooked, %d up to date, %d failed\n", 
+            context.numFiles, 
+            context.numCooked, 
+            context.numSkipped, 
+            context.numFailed
+        );
+    }
+
+    LogClose();
+    return context.numFailed > 0 ? 1 : 0;
+}
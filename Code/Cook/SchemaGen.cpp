@@ -0,0 +1,767 @@
+/*
+   GameRiff - Framework for creating various video game services
+   Reflection schema export and loader generation
+   Copyright (C) 2011, Shaun Leach.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are
+   met:
+  
+       * Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+       * Redistributions in binary form must reproduce the above
+   copyright notice, this list of conditions and the following disclaimer
+   in the documentation and/or other materials provided with the
+   distribution.
+  
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "Pch.h"
+#include "SchemaGen.h"
+
+LOG_DEFINE_MODULE(Cook);
+
+//////////////////////////////////////////////////////
+//
+// The schema lists every reflected type with the exact layout of its 
+//  binary blocks. Generated headers mirror it with plain structs and one
+//  reader per type that expects each header, record and size in order, 
+//  so loading is straight line code without hash lookups or virtual calls.
+//  Blocks that don't match exactly fail the load, and the content has to 
+//  be cooked again with a regenerated header.
+//
+
+//////////////////////////////////////////////////////
+//
+// Internal constants
+//
+
+static const unsigned   s_maxNameLength     = 256;
+static const unsigned   s_maxKindLength     = 16;
+static const unsigned   s_blockHeaderSize   = 3 * sizeof(uint32);
+
+#define SCHEMA_MEM_FLAGS  MemFlags(MEM_ARENA_DEFAULT, MEM_CAT_FILEIO)
+
+//////////////////////////////////////////////////////
+//
+// Internal types
+//
+
+// Names are stored as C++ identifiers
+struct SchemaMember {
+    charsys         name[s_maxNameLength];
+    chargr          kind[s_maxKindLength];
+    charsys         target[s_maxNameLength];
+    uint32          hash;
+    uint32          typeHash;
+    uint32          targetHash;
+    unsigned        size;
+    unsigned        binarySize;
+    unsigned        bitWidth;
+    bool            isSigned;
+};
+
+struct SchemaParent {
+    charsys         name[s_maxNameLength];
+    uint32          hash;
+};
+
+struct SchemaType {
+    charsys         name[s_maxNameLength];
+    uint32          hash;
+    bool            isEnum;
+    bool            emitted;
+    unsigned        version;
+    unsigned        binarySize;
+    uint32          bitfieldLayout;
+    unsigned        bitfieldBits;
+    unsigned        firstParent;
+    unsigned        numParents;
+    unsigned        firstMember;
+    unsigned        numMembers;
+};
+
+struct Schema {
+    Schema() :
+        binaryMagic(0),
+        binaryVersion(0),
+        nullObject(0),
+        bitfieldName(0),
+        bitfieldType(0),
+        types(NULL),
+        numTypes(0),
+        parents(NULL),
+        numParents(0),
+        members(NULL),
+        numMembers(0)
+    {
+    }
+    ~Schema() {
+        if (types != NULL) 
+            delete [] types;
+        if (parents != NULL) 
+            delete [] parents;
+        if (members != NULL) 
+            delete [] members;
+    }
+
+    uint32          binaryMagic;
+    uint32          binaryVersion;
+    uint32          nullObject;
+    uint32          bitfieldName;
+    uint32          bitfieldType;
+
+    // When the arrays are NULL, reading only counts the entries
+    SchemaType    * types;
+    unsigned        numTypes;
+    SchemaParent  * parents;
+    unsigned        numParents;
+    SchemaMember  * members;
+    unsigned        numMembers;
+};
+
+// C++ declaration of a member with a fixed binary layout
+struct FieldDecl {
+    const charsys * type;
+    unsigned        count;
+};
+
+//////////////////////////////////////////////////////
+//
+// Internal functions
+//
+
+//====================================================
+static void ReadName(IStructuredTextStreamPtr stream, const chargr * attribute, charsys * name) {
+    chargr value[s_maxNameLength];
+    value[0] = 0;
+    stream->ReadNodeAttribute(attribute, StrLen(attribute, 32), value, s_maxNameLength);
+
+    // Namespaced and templated names become plain identifiers
+    unsigned len = StrLen(value, s_maxNameLength);
+    for (unsigned i = 0; i < len; i++) {
+        chargr c = value[i];
+        bool valid = (c >= L'a' && c <= L'z') || (c >= L'A' && c <= L'Z') || (c >= L'0' && c <= L'9') || c == L'_';
+        name[i] = valid ? static_cast<charsys>(c) : '_';
+    }
+    name[len] = 0;
+}
+
+//====================================================
+static uint32 ReadHex(IStructuredTextStreamPtr stream, const chargr * attribute) {
+    chargr value[32];
+    uint32 result = 0;
+    if (stream->ReadNodeAttribute(attribute, StrLen(attribute, 32), value, 32) == STREAM_ERROR_OK) 
+        StrReadValue(value, 32, L"%x", &result);
+    return result;
+}
+
+//====================================================
+static unsigned ReadUnsigned(IStructuredTextStreamPtr stream, const chargr * attribute) {
+    chargr value[32];
+    unsigned result = 0;
+    if (stream->ReadNodeAttribute(attribute, StrLen(attribute, 32), value, 32) == STREAM_ERROR_OK) 
+        StrReadValue(value, 32, L"%u", &result);
+    return result;
+}
+
+//====================================================
+static void ReadSchemaMember(IStructuredTextStreamPtr stream, SchemaMember * member) {
+    ReadName(stream, L"Name", member->name);
+    ReadName(stream, L"Target", member->target);
+    member->kind[0] = 0;
+    stream->ReadNodeAttribute(L"Kind", 4, member->kind, s_maxKindLength);
+    member->hash        = ReadHex(stream, L"Hash");
+    member->typeHash    = ReadHex(stream, L"TypeHash");
+    member->targetHash  = ReadHex(stream, L"TargetHash");
+    member->size        = ReadUnsigned(stream, L"Size");
+    member->binarySize  = ReadUnsigned(stream, L"BinarySize");
+    member->bitWidth    = ReadUnsigned(stream, L"BitWidth");
+
+    chargr isSigned[8];
+    member->isSigned = stream->ReadNodeAttribute(L"Signed", 6, isSigned, 8) == STREAM_ERROR_OK && StrCmp(isSigned, L"true", 5) == 0;
+}
+
+//====================================================
+static void ReadSchemaType(IStructuredTextStreamPtr stream, Schema * schema) {
+    SchemaType * type = schema->types != NULL ? &schema->types[schema->numTypes] : NULL;
+    if (type != NULL) {
+        chargr kind[s_maxKindLength];
+        kind[0] = 0;
+        stream->ReadNodeAttribute(L"Kind", 4, kind, s_maxKindLength);
+
+        ReadName(stream, L"Name", type->name);
+        type->hash              = ReadHex(stream, L"Hash");
+        type->isEnum            = StrCmp(kind, L"enum", 5) == 0;
+        type->emitted           = false;
+        type->version           = ReadUnsigned(stream, L"Version");
+        type->binarySize        = ReadUnsigned(stream, L"BinarySize");
+        type->bitfieldLayout    = ReadHex(stream, L"BitfieldLayout");
+        type->bitfieldBits      = ReadUnsigned(stream, L"BitfieldBits");
+        type->firstParent       = schema->numParents;
+        type->numParents        = 0;
+        type->firstMember       = schema->numMembers;
+        type->numMembers        = 0;
+    }
+    schema->numTypes++;
+
+    if (stream->ReadChildNode() == STREAM_ERROR_NODEDOESNTEXIST) 
+        return;
+
+    do {
+        chargr nodeName[32];
+        stream->ReadNodeName(nodeName, 32);
+        if (StrCmp(nodeName, L"Parent", 7) == 0) {
+            if (type != NULL) {
+                SchemaParent & parent = schema->parents[schema->numParents];
+                ReadName(stream, L"Name", parent.name);
+                parent.hash = ReadHex(stream, L"Hash");
+                type->numParents++;
+            }
+            schema->numParents++;
+        }
+        else if (StrCmp(nodeName, L"Member", 7) == 0) {
+            if (type != NULL) {
+                ReadSchemaMember(stream, &schema->members[schema->numMembers]);
+                type->numMembers++;
+            }
+            schema->numMembers++;
+        }
+    } while (stream->ReadNextNode() != STREAM_ERROR_NODEDOESNTEXIST);
+
+    stream->ReadParentNode();
+}
+
+//====================================================
+static bool ReadSchema(const chargr * schemaPath, Schema * schema) {
+    IStructuredTextStreamPtr stream = StreamOpenXML(schemaPath);
+    if (stream == NULL) 
+        return false;
+
+    chargr nodeName[32];
+    stream->ReadNodeName(nodeName, 32);
+    if (StrCmp(nodeName, L"Schema", 7) != 0 || ReadUnsigned(stream, L"Version") != 1) {
+        LOG(LOG_PRIORITY_ERROR, "%s isn't a version 1 reflection schema", schemaPath);
+        return false;
+    }
+
+    schema->binaryMagic     = ReadHex(stream, L"BinaryMagic");
+    schema->binaryVersion   = ReadUnsigned(stream, L"BinaryVersion");
+    schema->nullObject      = ReadHex(stream, L"NullObject");
+    schema->bitfieldName    = ReadHex(stream, L"BitfieldName");
+    schema->bitfieldType    = ReadHex(stream, L"BitfieldType");
+
+    schema->numTypes    = 0;
+    schema->numParents  = 0;
+    schema->numMembers  = 0;
+    if (stream->ReadChildNode() == STREAM_ERROR_NODEDOESNTEXIST) 
+        return true;
+
+    do {
+        chargr typeName[32];
+        stream->ReadNodeName(typeName, 32);
+        if (StrCmp(typeName, L"Type", 5) == 0) 
+            ReadSchemaType(stream, schema);
+    } while (stream->ReadNextNode() != STREAM_ERROR_NODEDOESNTEXIST);
+
+    return true;
+}
+
+//====================================================
+static SchemaType * FindType(Schema * schema, uint32 hash) {
+    for (unsigned type = 0; type < schema->numTypes; type++) {
+        if (schema->types[type].hash == hash) 
+            return &schema->types[type];
+    }
+    return NULL;
+}
+
+//====================================================
+static bool IsDerivedFrom(Schema * schema, const SchemaType * type, uint32 baseHash) {
+    if (type->hash == baseHash) 
+        return true;
+
+    for (unsigned parent = type->firstParent; parent < type->firstParent + type->numParents; parent++) {
+        const SchemaType * parentType = FindType(schema, schema->parents[parent].hash);
+        if (parentType != NULL && IsDerivedFrom(schema, parentType, baseHash)) 
+            return true;
+    }
+    return false;
+}
+
+//====================================================
+// Falls back to raw bytes when the kind has no fixed declaration or the
+//  cooked size doesn't match it
+static FieldDecl GetFieldDecl(const SchemaMember & member) {
+    struct KindDecl {
+        const chargr  * kind;
+        const charsys * type;
+        unsigned        size;
+        unsigned        count;
+    };
+    static const KindDecl s_kinds[] = {
+        { L"bool",          "bool",         1,  1 },
+        { L"int8",          "int8_t",       1,  1 },
+        { L"uint8",         "uint8_t",      1,  1 },
+        { L"int16",         "int16_t",      2,  1 },
+        { L"uint16",        "uint16_t",     2,  1 },
+        { L"int32",         "int32_t",      4,  1 },
+        { L"uint32",        "uint32_t",     4,  1 },
+        { L"int64",         "int64_t",      8,  1 },
+        { L"uint64",        "uint64_t",     8,  1 },
+        { L"int128",        "int64_t",      8,  2 },
+        { L"uint128",       "uint64_t",     8,  2 },
+        { L"float16",       "uint16_t",     2,  1 },
+        { L"float32",       "float",        4,  1 },
+        { L"color",         "float",        4,  4 },
+        { L"angle",         "float",        4,  1 },
+        { L"percentage",    "float",        4,  1 },
+        { L"eulers",        "float",        4,  3 },
+        { L"vec3",          "float",        4,  3 },
+        { L"vec4",          "float",        4,  4 },
+        { L"quaternion",    "float",        4,  4 },
+    };
+
+    FieldDecl decl = { "uint8_t", member.size };
+    for (unsigned i = 0; i < sizeof(s_kinds) / sizeof(s_kinds[0]); i++) {
+        const KindDecl & kind = s_kinds[i];
+        if (StrCmp(member.kind, kind.kind, s_maxKindLength) == 0 && kind.size * kind.count == member.size) {
+            decl.type   = kind.type;
+            decl.count  = kind.count;
+            return decl;
+        }
+    }
+
+    if (StrCmp(member.kind, L"enum", 5) == 0) {
+        static const charsys * s_enumTypes[] = { NULL, "int8_t", "int16_t", NULL, "int32_t", NULL, NULL, NULL, "int64_t" };
+        if (member.size <= 8 && s_enumTypes[member.size] != NULL) {
+            decl.type   = s_enumTypes[member.size];
+            decl.count  = 1;
+        }
+    }
+    return decl;
+}
+
+//====================================================
+static void Emit(IRawStreamPtr stream, const charsys * format, ...) {
+    charsys line[1024];
+    va_list args;
+    va_start(args, format);
+    int len = StrPrintfV(line, 1024, format, args);
+    va_end(args);
+
+    if (len > 0) 
+        stream->WriteBytes(line, len, NULL);
+}
+
+//====================================================
+static void EmitText(IRawStreamPtr stream, const charsys * text) {
+    stream->WriteBytes(text, StrLen(text, 0xffffffff), NULL);
+}
+
+//====================================================
+static void EmitPreamble(IRawStreamPtr stream, const Schema & schema) {
+    EmitText(stream, 
+        "// Generated by cook -generate from a reflection schema, don't edit.\n"
+        "//  Loads cooked binary files without the reflection runtime. Blocks\n"
+        "//  have to match the schema exactly, so regenerate after reflected types\n"
+        "//  change and cook the content again.\n"
+        "\n"
+        "#pragma once\n"
+        "\n"
+        "#include <stddef.h>\n"
+        "#include <stdint.h>\n"
+        "#include <string.h>\n"
+        "\n"
+        "namespace GRSchema {\n"
+        "\n"
+    );
+    Emit(stream, "static const uint32_t BINARY_MAGIC    = 0x%08x;\n", schema.binaryMagic);
+    Emit(stream, "static const uint32_t BINARY_VERSION  = %u;\n", schema.binaryVersion);
+    Emit(stream, "static const uint32_t NULL_OBJECT     = 0x%08x;\n", schema.nullObject);
+    Emit(stream, "static const uint32_t BITFIELD_NAME   = 0x%08x;\n", schema.bitfieldName);
+    Emit(stream, "static const uint32_t BITFIELD_TYPE   = 0x%08x;\n", schema.bitfieldType);
+    EmitText(stream, 
+        "\n"
+        "struct Reader {\n"
+        "    const uint8_t     * cursor;\n"
+        "    const uint8_t     * end;\n"
+        "    void             ** objects;\n"
+        "    const uint32_t    * types;\n"
+        "    uint32_t            numObjects;\n"
+        "    bool                ok;\n"
+        "};\n"
+        "\n"
+        "struct File {\n"
+        "    void             ** objects;\n"
+        "    uint32_t          * types;\n"
+        "    uint32_t            numObjects;\n"
+        "};\n"
+        "\n"
+        "// Reads after a failure do nothing, so readers don't branch\n"
+        "inline void ReadBytes(Reader & r, void * dest, size_t count) {\n"
+        "    if (!r.ok || static_cast<size_t>(r.end - r.cursor) < count) {\n"
+        "        r.ok = false;\n"
+        "        return;\n"
+        "    }\n"
+        "    memcpy(dest, r.cursor, count);\n"
+        "    r.cursor += count;\n"
+        "}\n"
+        "\n"
+        "inline uint32_t ReadU32(Reader & r) {\n"
+        "    uint32_t value = 0;\n"
+        "    ReadBytes(r, &value, sizeof(value));\n"
+        "    return value;\n"
+        "}\n"
+        "\n"
+        "inline void Expect(Reader & r, uint32_t expected) {\n"
+        "    if (ReadU32(r) != expected) \n"
+        "        r.ok = false;\n"
+        "}\n"
+        "\n"
+        "inline void ExpectBlock(Reader & r, uint32_t type, uint32_t version, uint32_t size, uint32_t numParents) {\n"
+        "    Expect(r, type);\n"
+        "    Expect(r, version);\n"
+        "    Expect(r, size);\n"
+        "    Expect(r, numParents);\n"
+        "}\n"
+        "\n"
+        "inline void ExpectRecord(Reader & r, uint32_t name, uint32_t type, uint32_t size) {\n"
+        "    Expect(r, name);\n"
+        "    Expect(r, type);\n"
+        "    Expect(r, size);\n"
+        "}\n"
+        "\n"
+        "inline void * ReadObject(Reader & r, uint32_t * type) {\n"
+        "    uint32_t id = ReadU32(r);\n"
+        "    *type = 0;\n"
+        "    if (!r.ok || id == NULL_OBJECT) \n"
+        "        return NULL;\n"
+        "    if (id >= r.numObjects) {\n"
+        "        r.ok = false;\n"
+        "        return NULL;\n"
+        "    }\n"
+        "    *type = r.types[id];\n"
+        "    return r.objects[id];\n"
+        "}\n"
+        "\n"
+        "// Bits are numbered from the low bit of the first byte\n"
+        "inline uint64_t ReadBits(const uint8_t * data, unsigned bit, unsigned width, bool isSigned) {\n"
+        "    data += bit / 8;\n"
+        "    bit  %= 8;\n"
+        "    uint64_t value = 0;\n"
+        "    unsigned bytes = (bit + width + 7) / 8;\n"
+        "    for (unsigned i = 0; i < bytes; i++) {\n"
+        "        int shift = static_cast<int>(i * 8) - static_cast<int>(bit);\n"
+        "        uint64_t bits = data[i];\n"
+        "        value |= shift >= 0 ? bits << shift : bits >> -shift;\n"
+        "    }\n"
+        "    if (width < 64) {\n"
+        "        value &= (1ULL << width) - 1;\n"
+        "        if (isSigned && (value >> (width - 1)) != 0) \n"
+        "            value |= ~0ULL << width;\n"
+        "    }\n"
+        "    return value;\n"
+        "}\n"
+        "\n"
+    );
+}
+
+//====================================================
+static void EmitMemberDecl(IRawStreamPtr stream, Schema * schema, const SchemaMember & member) {
+    if (StrCmp(member.kind, L"bitfield", 9) == 0) {
+        Emit(stream, "    %s %s : %u;\n", member.isSigned ? "int64_t" : "uint64_t", member.name, member.bitWidth);
+    }
+    else if (StrCmp(member.kind, L"class", 6) == 0 && FindType(schema, member.targetHash) != NULL) {
+        Emit(stream, "    %s %s;\n", member.target, member.name);
+    }
+    else if (StrCmp(member.kind, L"pointer", 8) == 0) {
+        if (FindType(schema, member.targetHash) != NULL) 
+            Emit(stream, "    %s * %s;\n", member.target, member.name);
+        else
+            Emit(stream, "    void * %s;\n", member.name);
+    }
+    else if (StrCmp(member.kind, L"class", 6) == 0) {
+        Emit(stream, "    uint8_t %s[%u];\n", member.name, member.binarySize);
+    }
+    else {
+        FieldDecl decl = GetFieldDecl(member);
+        if (decl.count == 1) 
+            Emit(stream, "    %s %s;\n", decl.type, member.name);
+        else
+            Emit(stream, "    %s %s[%u];\n", decl.type, member.name, decl.count);
+    }
+}
+
+//====================================================
+// Bases and by value members are declared before the types that contain them
+static void EmitStruct(IRawStreamPtr stream, Schema * schema, SchemaType * type) {
+    if (type->emitted || type->isEnum) 
+        return;
+    type->emitted = true;
+
+    for (unsigned parent = type->firstParent; parent < type->firstParent + type->numParents; parent++) {
+        SchemaType * parentType = FindType(schema, schema->parents[parent].hash);
+        if (parentType != NULL) 
+            EmitStruct(stream, schema, parentType);
+    }
+    for (unsigned member = type->firstMember; member < type->firstMember + type->numMembers; member++) {
+        const SchemaMember & memberDesc = schema->members[member];
+        SchemaType * target = FindType(schema, memberDesc.targetHash);
+        if (target != NULL && StrCmp(memberDesc.kind, L"class", 6) == 0) 
+            EmitStruct(stream, schema, target);
+    }
+
+    Emit(stream, "struct %s", type->name);
+    for (unsigned parent = type->firstParent; parent < type->firstParent + type->numParents; parent++) 
+        Emit(stream, "%s public %s", parent == type->firstParent ? " :" : ",", schema->parents[parent].name);
+    Emit(stream, " {\n");
+    Emit(stream, "    static const uint32_t TYPE        = 0x%08x;\n", type->hash);
+    Emit(stream, "    static const uint32_t VERSION     = %u;\n", type->version);
+    Emit(stream, "    static const uint32_t BINARY_SIZE = %u;\n", type->binarySize);
+    if (type->numMembers > 0) 
+        Emit(stream, "\n");
+    for (unsigned member = type->firstMember; member < type->firstMember + type->numMembers; member++) 
+        EmitMemberDecl(stream, schema, schema->members[member]);
+    Emit(stream, "};\n\n");
+}
+
+//====================================================
+static void EmitCast(IRawStreamPtr stream, Schema * schema, const SchemaType & base) {
+    Emit(stream, "inline %s * Cast%s(void * inst, uint32_t type) {\n", base.name, base.name);
+    Emit(stream, "    switch (type) {\n");
+    for (unsigned type = 0; type < schema->numTypes; type++) {
+        const SchemaType & derived = schema->types[type];
+        if (derived.isEnum || !IsDerivedFrom(schema, &derived, base.hash)) 
+            continue;
+        if (derived.hash == base.hash) 
+            Emit(stream, "        case %s::TYPE: return static_cast<%s *>(inst);\n", base.name, base.name);
+        else
+            Emit(stream, "        case %s::TYPE: return static_cast<%s *>(static_cast<%s *>(inst));\n", derived.name, base.name, derived.name);
+    }
+    Emit(stream, "        default: return NULL;\n");
+    Emit(stream, "    }\n");
+    Emit(stream, "}\n\n");
+}
+
+//====================================================
+static void EmitMemberRead(IRawStreamPtr stream, Schema * schema, const SchemaMember & member) {
+    const SchemaType * target = FindType(schema, member.targetHash);
+    bool isClass    = StrCmp(member.kind, L"class", 6) == 0;
+    bool isPointer  = StrCmp(member.kind, L"pointer", 8) == 0;
+    unsigned size   = isPointer ? static_cast<unsigned>(sizeof(uint32)) : member.binarySize;
+
+    Emit(stream, "    ExpectRecord(r, 0x%08x, 0x%08x, %u);\n", member.hash, member.typeHash, size);
+    if (isClass && target != NULL) {
+        Emit(stream, "    Read%s(r, &inst->%s);\n", target->name, member.name);
+    }
+    else if (isPointer) {
+        Emit(stream, "    object = ReadObject(r, &objectType);\n");
+        if (target != NULL) 
+            Emit(stream, "    inst->%s = object != NULL ? Cast%s(object, objectType) : NULL;\n", member.name, target->name);
+        else
+            Emit(stream, "    inst->%s = object;\n", member.name);
+    }
+    else
+        Emit(stream, "    ReadBytes(r, &inst->%s, %u);\n", member.name, size);
+}
+
+//====================================================
+static void EmitRead(IRawStreamPtr stream, Schema * schema, const SchemaType & type) {
+    unsigned numBitfields = 0;
+    bool hasPointers = false;
+    for (unsigned member = type.firstMember; member < type.firstMember + type.numMembers; member++) {
+        if (StrCmp(schema->members[member].kind, L"bitfield", 9) == 0) 
+            numBitfields++;
+        else if (StrCmp(schema->members[member].kind, L"pointer", 8) == 0) 
+            hasPointers = true;
+    }
+    unsigned numRecords = type.numMembers - numBitfields + (numBitfields > 0 ? 1 : 0);
+
+    Emit(stream, "inline void Read%s(Reader & r, %s * inst) {\n", type.name, type.name);
+    Emit(stream, "    ExpectBlock(r, %s::TYPE, %s::VERSION, %s::BINARY_SIZE - %u, %u);\n", type.name, type.name, type.name, s_blockHeaderSize, type.numParents);
+    for (unsigned parent = type.firstParent; parent < type.firstParent + type.numParents; parent++) {
+        const SchemaParent & parentDesc = schema->parents[parent];
+        Emit(stream, "    Read%s(r, static_cast<%s *>(inst));\n", parentDesc.name, parentDesc.name);
+    }
+    Emit(stream, "    Expect(r, %u);\n", numRecords);
+
+    if (hasPointers) {
+        Emit(stream, "    void * object = NULL;\n");
+        Emit(stream, "    uint32_t objectType = 0;\n");
+    }
+    for (unsigned member = type.firstMember; member < type.firstMember + type.numMembers; member++) {
+        if (StrCmp(schema->members[member].kind, L"bitfield", 9) != 0) 
+            EmitMemberRead(stream, schema, schema->members[member]);
+    }
+
+    // Bitfields are packed one after another in declaration order
+    if (numBitfields > 0) {
+        unsigned bytes = (type.bitfieldBits + 7) / 8;
+        Emit(stream, "    ExpectRecord(r, BITFIELD_NAME, BITFIELD_TYPE, %u);\n", static_cast<unsigned>(sizeof(uint32)) + bytes);
+        Emit(stream, "    Expect(r, 0x%08x);\n", type.bitfieldLayout);
+        Emit(stream, "    uint8_t bits[%u] = { 0 };\n", bytes);
+        Emit(stream, "    ReadBytes(r, bits, %u);\n", bytes);
+
+        unsigned bit = 0;
+        for (unsigned member = type.firstMember; member < type.firstMember + type.numMembers; member++) {
+            const SchemaMember & memberDesc = schema->members[member];
+            if (StrCmp(memberDesc.kind, L"bitfield", 9) != 0) 
+                continue;
+            Emit(stream, "    inst->%s = ReadBits(bits, %u, %u, %s);\n", memberDesc.name, bit, memberDesc.bitWidth, memberDesc.isSigned ? "true" : "false");
+            bit += memberDesc.bitWidth;
+        }
+    }
+    Emit(stream, "}\n\n");
+}
+
+//====================================================
+static void EmitFileFunctions(IRawStreamPtr stream, const Schema & schema) {
+    Emit(stream, "inline void * Create(uint32_t type) {\n    switch (type) {\n");
+    for (unsigned type = 0; type < schema.numTypes; type++) {
+        if (!schema.types[type].isEnum) 
+            Emit(stream, "        case %s::TYPE: return new %s();\n", schema.types[type].name, schema.types[type].name);
+    }
+    Emit(stream, "        default: return NULL;\n    }\n}\n\n");
+
+    Emit(stream, "inline void Destroy(void * inst, uint32_t type) {\n    switch (type) {\n");
+    for (unsigned type = 0; type < schema.numTypes; type++) {
+        if (!schema.types[type].isEnum) 
+            Emit(stream, "        case %s::TYPE: delete static_cast<%s *>(inst); break;\n", schema.types[type].name, schema.types[type].name);
+    }
+    Emit(stream, "        default: break;\n    }\n}\n\n");
+
+    Emit(stream, "inline void ReadBlock(Reader & r, void * inst, uint32_t type) {\n    switch (type) {\n");
+    for (unsigned type = 0; type < schema.numTypes; type++) {
+        if (!schema.types[type].isEnum) 
+            Emit(stream, "        case %s::TYPE: Read%s(r, static_cast<%s *>(inst)); break;\n", schema.types[type].name, schema.types[type].name, schema.types[type].name);
+    }
+    Emit(stream, "        default: r.ok = false; break;\n    }\n}\n\n");
+
+    EmitText(stream, 
+        "inline void FreeFile(File * file) {\n"
+        "    for (uint32_t i = 0; i < file->numObjects && file->objects != NULL; i++) \n"
+        "        Destroy(file->objects[i], file->types[i]);\n"
+        "    delete [] file->objects;\n"
+        "    delete [] file->types;\n"
+        "    file->objects       = NULL;\n"
+        "    file->types         = NULL;\n"
+        "    file->numObjects    = 0;\n"
+        "}\n"
+        "\n"
+        "// Every object is created before any block is read, so pointers are\n"
+        "//  resolved as they're read. The root is the first object.\n"
+        "inline bool LoadFile(const void * data, size_t size, File * file) {\n"
+        "    Reader r;\n"
+        "    r.cursor    = static_cast<const uint8_t *>(data);\n"
+        "    r.end       = r.cursor + size;\n"
+        "    r.ok        = true;\n"
+        "\n"
+        "    Expect(r, BINARY_MAGIC);\n"
+        "    Expect(r, BINARY_VERSION);\n"
+        "    uint32_t numObjects = ReadU32(r);\n"
+        "    file->objects       = NULL;\n"
+        "    file->types         = NULL;\n"
+        "    file->numObjects    = 0;\n"
+        "    if (!r.ok || numObjects > static_cast<size_t>(r.end - r.cursor) / sizeof(uint32_t)) \n"
+        "        return false;\n"
+        "\n"
+        "    file->objects       = new void *[numObjects];\n"
+        "    file->types         = new uint32_t[numObjects];\n"
+        "    file->numObjects    = numObjects;\n"
+        "    for (uint32_t i = 0; i < numObjects; i++) {\n"
+        "        file->types[i]      = ReadU32(r);\n"
+        "        file->objects[i]    = Create(file->types[i]);\n"
+        "        if (file->objects[i] == NULL) \n"
+        "            r.ok = false;\n"
+        "    }\n"
+        "\n"
+        "    r.objects       = file->objects;\n"
+        "    r.types         = file->types;\n"
+        "    r.numObjects    = numObjects;\n"
+        "    for (uint32_t i = 0; i < numObjects && r.ok; i++) \n"
+        "        ReadBlock(r, file->objects[i], file->types[i]);\n"
+        "\n"
+        "    if (!r.ok) \n"
+        "        FreeFile(file);\n"
+        "    return r.ok;\n"
+        "}\n"
+        "\n"
+        "} // namespace GRSchema\n"
+    );
+}
+
+//////////////////////////////////////////////////////
+//
+// External functions
+//
+
+//====================================================
+bool SchemaExport(const chargr * schemaPath) {
+    IStructuredTextStreamPtr stream = StreamCreateXML(schemaPath);
+    if (stream == NULL) 
+        return false;
+
+    if (!ReflLibrary::ExportSchema(stream)) 
+        return false;
+    return stream->Save() == STREAM_ERROR_OK;
+}
+
+//====================================================
+bool SchemaGenerate(const chargr * schemaPath, const chargr * headerPath) {
+    // Count the entries, then read them into arrays of that size
+    Schema schema;
+    if (!ReadSchema(schemaPath, &schema)) 
+        return false;
+
+    schema.types    = new(SCHEMA_MEM_FLAGS) SchemaType[schema.numTypes];
+    schema.parents  = new(SCHEMA_MEM_FLAGS) SchemaParent[schema.numParents];
+    schema.members  = new(SCHEMA_MEM_FLAGS) SchemaMember[schema.numMembers];
+    if (!ReadSchema(schemaPath, &schema)) 
+        return false;
+
+    IRawStreamPtr stream = StreamCreateFile(headerPath);
+    if (stream == NULL) 
+        return false;
+
+    EmitPreamble(stream, schema);
+
+    for (unsigned type = 0; type < schema.numTypes; type++) {
+        if (!schema.types[type].isEnum) 
+            Emit(stream, "struct %s;\n", schema.types[type].name);
+    }
+    Emit(stream, "\n");
+
+    for (unsigned type = 0; type < schema.numTypes; type++) 
+        EmitStruct(stream, &schema, &schema.types[type]);
+
+    for (unsigned type = 0; type < schema.numTypes; type++) {
+        if (!schema.types[type].isEnum) 
+            EmitCast(stream, &schema, schema.types[type]);
+    }
+
+    for (unsigned type = 0; type < schema.numTypes; type++) {
+        if (!schema.types[type].isEnum) 
+            Emit(stream, "inline void Read%s(Reader & r, %s * inst);\n", schema.types[type].name, schema.types[type].name);
+    }
+    Emit(stream, "\n");
+
+    for (unsigned type = 0; type < schema.numTypes; type++) {
+        if (!schema.types[type].isEnum) 
+            EmitRead(stream, &schema, schema.types[type]);
+    }
+
+    EmitFileFunctions(stream, schema);
+    return true;
+}
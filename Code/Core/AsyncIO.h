@@ -0,0 +1,92 @@
+/*
+   GameRiff - Framework for creating various video game services
+   Interface for asynchronous file reads
+   Copyright (C) 2011, Shaun Leach.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are
+   met:
+  
+       * Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+       * Redistributions in binary form must reproduce the above
+   copyright notice, this list of conditions and the following disclaimer
+   in the documentation and/or other materials provided with the
+   distribution.
+  
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#pragma once
+
+enum EAsyncIOBackend {
+    ASYNC_IO_BACKEND_THREADS,   // Blocking reads on the engine's threads
+    ASYNC_IO_BACKEND_NATIVE,    // The platform's own async reads, the threads only finish them
+};
+
+// Defaults for AsyncIOCreate
+const unsigned ASYNC_IO_DEFAULT_THREADS = 2;
+const unsigned ASYNC_IO_DEFAULT_PENDING = 64;
+
+// Read only file opened for an engine's reads
+class IAsyncFile : public RefCounted {
+public:
+    virtual ~IAsyncFile() { }
+
+    virtual uint64 GetSize() const = 0;
+};
+
+DECLARE_SMARTPTR(IAsyncFile);
+
+struct AsyncRead;
+typedef void (*AsyncReadFunc)(AsyncRead * read);
+
+// Owned by the caller, and left alone along with its buffer and file from 
+//  when it's submitted until it's done
+struct AsyncRead {
+    // Set before submitting
+    uint64          offset;
+    byte          * buffer;
+    unsigned        size;
+    AsyncReadFunc   callback;   // Run on an engine thread, NULL to finish through Poll and Wait
+    void          * param;
+
+    // Set by the engine, done last
+    EFileResult     result;     // FILE_RESULT_EOF when the end of the file cut the read short
+    unsigned        bytesRead;
+    volatile int32  done;
+};
+
+class IAsyncIO : public RefCounted {
+public:
+    virtual ~IAsyncIO() { }
+
+    virtual IAsyncFilePtr OpenFile(const chargr * filename, EFileResult * result) = 0;
+
+    // Blocks while the most reads the engine was made for are in flight
+    virtual void Submit(IAsyncFilePtr file, AsyncRead * read) = 0;
+
+    // Finished reads that have no callback, in the order they finished. 
+    //  Poll returns up to max of them without waiting, Wait waits for the 
+    //  first.
+    virtual unsigned Poll(AsyncRead ** reads, unsigned max) = 0;
+    virtual unsigned Wait(AsyncRead ** reads, unsigned max) = 0;
+};
+
+DECLARE_SMARTPTR(IAsyncIO);
+
+// Releasing the engine waits for the reads in flight. Reads that finish 
+//  through Poll and Wait have to be collected before they can be reused.
+IAsyncIOPtr AsyncIOCreate();
+IAsyncIOPtr AsyncIOCreate(EAsyncIOBackend backend, unsigned numThreads, unsigned maxPending);
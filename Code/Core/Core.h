@@ -50,3 +50,6 @@
 #include "Str.h"
 #include "File.h"
 #include "Log.h"
+#include "Thread.h"
+#include "AsyncIO.h"
+#include "Timer.h"
@@ -30,20 +30,85 @@
 enum EFileResult {
     FILE_RESULT_OK,
     FILE_RESULT_DOESNT_EXIST,
-    FILE_RESULT_FAIL
+    FILE_RESULT_FAIL,
+    FILE_RESULT_EOF
+};
+
+enum EFileMode {
+    FILE_MODE_READ,
+    FILE_MODE_WRITE,
 };
 
 class IRawFile : public RefCounted {
 public:
+    virtual ~IRawFile() { }
+
     virtual void Close() = 0;
 
     virtual EFileResult Flush() = 0;
 
+    virtual EFileResult Read(byte * buffer, unsigned len, unsigned * bytesRead) = 0;
+
     virtual EFileResult Write(const chargr * string, unsigned len) = 0;
     virtual EFileResult Write(const byte * buffer, unsigned len) = 0;
 };
 
 DECLARE_SMARTPTR(IRawFile);
 
+// Opens a text file for writing
 IRawFilePtr FileOpenRaw(const chargr * filename, EFileResult * result);
 
+// Opens a binary file for reading or writing
+IRawFilePtr FileOpenRaw(const chargr * filename, EFileMode mode, EFileResult * result);
+
+// Access hints for mapped files, combined as flags. Platforms ignore hints
+//  they have no support for.
+enum EFileMapHint {
+    FILE_MAP_HINT_NONE          = 0,
+    FILE_MAP_HINT_SEQUENTIAL    = 1 << 0,   // Read ahead aggressively
+    FILE_MAP_HINT_RANDOM        = 1 << 1,   // Don't read ahead
+    FILE_MAP_HINT_WILLNEED      = 1 << 2,   // Start paging views in as they are mapped
+    FILE_MAP_HINT_HUGEPAGES     = 1 << 3,   // Back views with huge pages
+};
+
+// Read only window into a mapped file. The memory stays valid until the 
+//  last reference to the view goes away.
+class IFileView : public RefCounted {
+public:
+    virtual ~IFileView() { }
+
+    virtual const byte * GetData() const = 0;
+    virtual unsigned GetSize() const = 0;
+    virtual uint64 GetOffset() const = 0;
+};
+
+DECLARE_SMARTPTR(IFileView);
+
+class IMappedFile : public RefCounted {
+public:
+    virtual ~IMappedFile() { }
+
+    virtual uint64 GetSize() const = 0;
+
+    // Views are cut short at the end of the file and are NULL past it. 
+    //  Offsets and sizes need no alignment, though a view that would span
+    //  more than 4GB once aligned is cut short too.
+    virtual IFileViewPtr MapView(uint64 offset, unsigned size) = 0;
+};
+
+DECLARE_SMARTPTR(IMappedFile);
+
+// Maps a binary file for reading, hints are EFileMapHint flags
+IMappedFilePtr FileOpenMapped(const chargr * filename, unsigned hints, EFileResult * result);
+
+const unsigned FILE_PATH_LENGTH = 260;
+
+// Called for every file and directory below the root. Paths are relative to
+//  the root and use '/' separators, directories are visited before their
+//  contents.
+typedef void (*FileFindFunc)(const chargr * path, bool isDirectory, void * param);
+EFileResult FileFindRecursive(const chargr * root, FileFindFunc func, void * param);
+
+bool FileExists(const chargr * filename);
+EFileResult FileCreateDirectory(const chargr * path);
+
@@ -40,11 +40,12 @@ static chargr * s_logPriorities[] = {
     L"Error"
 };
 
+// Formatting buffers are per thread so worker threads can log
 static const unsigned s_formatLength = 1024;
-static chargr s_localFormat[s_formatLength];
+static THREADLOCAL chargr s_localFormat[s_formatLength];
 
 static const unsigned s_bufferLength = 2048;
-static chargr s_stringBuffer[s_bufferLength];
+static THREADLOCAL chargr s_stringBuffer[s_bufferLength];
 
 static IRawFilePtr s_errorLog    = NULL;
 static IRawFilePtr s_warnLog     = NULL;
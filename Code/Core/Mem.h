@@ -57,6 +57,8 @@ enum EMemCategory {
     MEM_CAT_STRING,
     MEM_CAT_TEST,
     MEM_CAT_XML,
+    MEM_CAT_REFLECTION,
+    MEM_CAT_JSON,
 };
 
 enum EMemFlags {
@@ -63,6 +63,10 @@ private:
 template <typename t_type>
 class SmartPtr {
 public:
+    SmartPtr() :
+        m_ptr(NULL)
+    {
+    }
     SmartPtr(t_type * ptr) :
         m_ptr(ptr)
     {
@@ -92,7 +96,7 @@ public:
         return *this;
     }
 
-    t_type * operator->() {
+    t_type * operator->() const {
         ASSERTGR(m_ptr != NULL);
         return m_ptr;
     }
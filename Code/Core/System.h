@@ -41,6 +41,7 @@
 
     #include <wctype.h>
     #include <stddef.h>
+    #include <new>
 
 #elif defined(PS3)
 
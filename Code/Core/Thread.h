@@ -0,0 +1,74 @@
+/*
+   GameRiff - Framework for creating various video game services
+   Interface for threads and atomic operations
+   Copyright (C) 2011, Shaun Leach.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are
+   met:
+  
+       * Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+       * Redistributions in binary form must reproduce the above
+   copyright notice, this list of conditions and the following disclaimer
+   in the documentation and/or other materials provided with the
+   distribution.
+  
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+typedef void (*ThreadFunc)(void * param);
+
+class IThread : public RefCounted {
+public:
+    virtual ~IThread() { }
+
+    // Blocks until the thread function returns
+    virtual void Join() = 0;
+};
+
+DECLARE_SMARTPTR(IThread);
+
+IThreadPtr ThreadCreate(ThreadFunc func, void * param);
+
+// Counting semaphore. Wait blocks until the count is above zero and takes 
+//  one, Signal adds to the count and wakes that many waiters.
+class ISemaphore : public RefCounted {
+public:
+    virtual ~ISemaphore() { }
+
+    virtual void Signal(unsigned count) = 0;
+    virtual void Wait() = 0;
+};
+
+DECLARE_SMARTPTR(ISemaphore);
+
+ISemaphorePtr SemaphoreCreate(unsigned initialCount);
+
+// Number of hardware threads, at least one
+unsigned ThreadNumCores();
+
+// Gives up the rest of the time slice to another ready thread
+void ThreadYield();
+
+// Both return the new value
+int32 AtomicIncrement(volatile int32 * value);
+int32 AtomicAdd(volatile int32 * value, int32 add);
+
+// Exchanges return the previous value and are full memory barriers
+int32 AtomicExchange(volatile int32 * value, int32 exchange);
+int32 AtomicCompareExchange(volatile int32 * value, int32 exchange, int32 comparand);
+void * AtomicExchangePointer(void * volatile * value, void * exchange);
+void * AtomicCompareExchangePointer(void * volatile * value, void * exchange, void * comparand);
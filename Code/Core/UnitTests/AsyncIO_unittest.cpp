@@ -0,0 +1,154 @@
+/*
+   GameRiff - Framework for creating various video game services
+   Async I/O unit tests
+   Copyright (C) 2011, Shaun Leach.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are
+   met:
+  
+       * Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+       * Redistributions in binary form must reproduce the above
+   copyright notice, this list of conditions and the following disclaimer
+   in the documentation and/or other materials provided with the
+   distribution.
+  
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include <gtest/gtest.h>
+
+#include "Pch.h"
+
+static const unsigned s_asyncFileSize   = 100000;
+static const unsigned s_asyncReadSize   = 4096;
+static const unsigned s_asyncNumReads   = 24;
+
+//====================================================
+static byte AsyncFileByte(unsigned offset) {
+    return static_cast<byte>((offset * 31) ^ (offset >> 9));
+}
+
+//====================================================
+static void WriteAsyncFile() {
+    byte * data = new byte[s_asyncFileSize];
+    for (unsigned i = 0; i < s_asyncFileSize; i++) 
+        data[i] = AsyncFileByte(i);
+
+    EFileResult result;
+    IRawFilePtr file = FileOpenRaw(L"testAsync.bin", FILE_MODE_WRITE, &result);
+    ASSERT_EQ(FILE_RESULT_OK, result);
+    EXPECT_EQ(FILE_RESULT_OK, file->Write(data, s_asyncFileSize));
+    delete [] data;
+}
+
+//====================================================
+static bool CheckAsyncRead(const AsyncRead & read) {
+    for (unsigned i = 0; i < read.bytesRead; i++) {
+        if (read.buffer[i] != AsyncFileByte(static_cast<unsigned>(read.offset) + i)) 
+            return false;
+    }
+    return true;
+}
+
+//====================================================
+static void OnAsyncRead(AsyncRead * read) {
+    ISemaphorePtr * finished = reinterpret_cast<ISemaphorePtr *>(read->param);
+    (*finished)->Signal(1);
+}
+
+//====================================================
+TEST(AsyncIOTest, TestReads) {
+    WriteAsyncFile();
+
+    const EAsyncIOBackend backends[] = { ASYNC_IO_BACKEND_THREADS, ASYNC_IO_BACKEND_NATIVE };
+    for (unsigned b = 0; b < 2; b++) {
+        // Fewer slots than reads, so submitting has to wait for some
+        IAsyncIOPtr io = AsyncIOCreate(backends[b], 3, 8);
+        ASSERT_TRUE(io != NULL);
+
+        EFileResult result;
+        EXPECT_EQ(true, io->OpenFile(L"missingAsync.bin", &result) == NULL);
+        EXPECT_EQ(FILE_RESULT_DOESNT_EXIST, result);
+
+        IAsyncFilePtr file = io->OpenFile(L"testAsync.bin", &result);
+        ASSERT_TRUE(file != NULL);
+        EXPECT_EQ(s_asyncFileSize, file->GetSize());
+
+        // Callbacks, with the last read cut short by the end of the file
+        byte * buffers = new byte[s_asyncNumReads * s_asyncReadSize];
+        AsyncRead reads[s_asyncNumReads];
+        ISemaphorePtr finished = SemaphoreCreate(0);
+        for (unsigned i = 0; i < s_asyncNumReads; i++) {
+            AsyncRead & read    = reads[i];
+            read.offset         = (s_asyncNumReads - 1 - i) * 4321;
+            read.buffer         = buffers + i * s_asyncReadSize;
+            read.size           = s_asyncReadSize;
+            read.callback       = OnAsyncRead;
+            read.param          = &finished;
+            if (i == 0) 
+                read.offset = s_asyncFileSize - 100;
+            io->Submit(file, &read);
+        }
+        for (unsigned i = 0; i < s_asyncNumReads; i++) 
+            finished->Wait();
+
+        for (unsigned i = 0; i < s_asyncNumReads; i++) {
+            EXPECT_EQ(1, reads[i].done);
+            EXPECT_EQ(i == 0 ? FILE_RESULT_EOF : FILE_RESULT_OK, reads[i].result);
+            EXPECT_EQ(i == 0 ? 100 : s_asyncReadSize, reads[i].bytesRead);
+            EXPECT_EQ(true, CheckAsyncRead(reads[i]));
+        }
+
+        // Polling, with a read past the end of the file
+        AsyncRead * done[s_asyncNumReads];
+        EXPECT_EQ(0, io->Poll(done, s_asyncNumReads));
+        for (unsigned i = 0; i < s_asyncNumReads; i++) {
+            reads[i].callback   = NULL;
+            reads[i].offset     = i == 0 ? s_asyncFileSize + 10 : i * 3333;
+            memset(reads[i].buffer, 0, s_asyncReadSize);
+            io->Submit(file, &reads[i]);
+        }
+
+        unsigned numDone = 0;
+        while (numDone < s_asyncNumReads) {
+            unsigned count = io->Wait(done + numDone, s_asyncNumReads - numDone);
+            EXPECT_LT(0, count);
+            numDone += count;
+        }
+        EXPECT_EQ(0, io->Poll(done, s_asyncNumReads));
+
+        unsigned seen = 0;
+        for (unsigned i = 0; i < s_asyncNumReads; i++) {
+            unsigned index = static_cast<unsigned>(done[i] - reads);
+            ASSERT_LT(index, s_asyncNumReads);
+            seen |= 1 << index;
+            EXPECT_EQ(1, done[i]->done);
+            EXPECT_EQ(index == 0 ? FILE_RESULT_EOF : FILE_RESULT_OK, done[i]->result);
+            EXPECT_EQ(index == 0 ? 0 : s_asyncReadSize, done[i]->bytesRead);
+            EXPECT_EQ(true, CheckAsyncRead(*done[i]));
+        }
+        EXPECT_EQ((1u << s_asyncNumReads) - 1, seen);
+
+        // Released with reads in flight, which it waits for
+        for (unsigned i = 0; i < s_asyncNumReads; i++) 
+            io->Submit(file, &reads[i]);
+        io = IAsyncIOPtr(NULL);
+        for (unsigned i = 0; i < s_asyncNumReads; i++) 
+            EXPECT_EQ(1, reads[i].done);
+
+        delete [] buffers;
+    }
+}
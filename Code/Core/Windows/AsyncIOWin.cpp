@@ -0,0 +1,388 @@
+/*
+   GameRiff - Framework for creating various video game services
+   Asynchronous file reads through an I/O completion port
+   Copyright (C) 2011, Shaun Leach.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are
+   met:
+  
+       * Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+       * Redistributions in binary form must reproduce the above
+   copyright notice, this list of conditions and the following disclaimer
+   in the documentation and/or other materials provided with the
+   distribution.
+  
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include "Pch.h"
+
+//////////////////////////////////////////////////////
+//
+// Internal implementation
+//
+
+#define ASYNC_MEM_FLAGS (MemFlags(MEM_ARENA_DEFAULT, MEM_CAT_FILEIO))
+
+// Completion keys of the packets on an engine's port
+enum EAsyncKey {
+    ASYNC_KEY_STOP,             // Ends one thread
+    ASYNC_KEY_SUBMIT,           // Read waiting for a thread to do it
+    ASYNC_KEY_NATIVE,           // Overlapped read that finished
+    ASYNC_KEY_FAILED,           // Overlapped read that failed as it started
+};
+
+// A read in flight. The port hands back the OVERLAPPED, so it comes first.
+struct AsyncOp {
+    OVERLAPPED          overlapped;
+    AsyncRead         * read;
+    HANDLE              handle;
+    EFileResult         error;      // For ASYNC_KEY_FAILED
+    volatile int32      busy;
+};
+
+class AsyncFile : public IAsyncFile {
+public:
+    AsyncFile(const void * owner);
+    ~AsyncFile();
+
+    EFileResult Open(const chargr * filename, bool native, HANDLE port);
+
+    virtual uint64 GetSize() const;
+
+    HANDLE GetHandle() const { return m_handle; }
+    const void * GetOwner() const { return m_owner; }
+
+private:
+    const void    * m_owner;
+    HANDLE          m_handle;
+    uint64          m_size;
+};
+
+class AsyncIO : public IAsyncIO {
+public:
+    AsyncIO(EAsyncIOBackend backend, unsigned numThreads, unsigned maxPending);
+    ~AsyncIO();
+
+    bool Init();
+
+    virtual IAsyncFilePtr OpenFile(const chargr * filename, EFileResult * result);
+    virtual void Submit(IAsyncFilePtr file, AsyncRead * read);
+    virtual unsigned Poll(AsyncRead ** reads, unsigned max);
+    virtual unsigned Wait(AsyncRead ** reads, unsigned max);
+
+private:
+    static void IOThread(void * param);
+
+    AsyncOp * AcquireOp();
+    unsigned Collect(AsyncRead ** reads, unsigned max, bool wait);
+    void ReadBlocking(AsyncOp * op);
+    void Finish(AsyncOp * op, EFileResult result, unsigned bytesRead);
+
+private:
+    EAsyncIOBackend m_backend;
+    HANDLE          m_port;         // Submitted reads, finished overlapped reads and stops
+    HANDLE          m_completed;    // Finished reads waiting for Poll and Wait
+    IThreadPtr    * m_threads;
+    unsigned        m_numThreads;
+    unsigned        m_numStarted;
+    AsyncOp       * m_ops;
+    unsigned        m_maxPending;
+    ISemaphorePtr   m_free;         // Counts the ops not in flight
+    volatile int32  m_nextOp;
+};
+
+//====================================================
+static void SetOffset(OVERLAPPED * overlapped, uint64 offset) {
+    memset(overlapped, 0, sizeof(*overlapped));
+    overlapped->Offset      = static_cast<DWORD>(offset);
+    overlapped->OffsetHigh  = static_cast<DWORD>(offset >> 32);
+}
+
+//====================================================
+static EFileResult ConvertReadError(DWORD error) {
+    return error == ERROR_HANDLE_EOF ? FILE_RESULT_EOF : FILE_RESULT_FAIL;
+}
+
+//====================================================
+AsyncFile::AsyncFile(const void * owner) :
+    m_owner(owner),
+    m_handle(INVALID_HANDLE_VALUE),
+    m_size(0)
+{
+}
+
+//====================================================
+AsyncFile::~AsyncFile() {
+    if (m_handle != INVALID_HANDLE_VALUE) 
+        CloseHandle(m_handle);
+}
+
+//====================================================
+EFileResult AsyncFile::Open(const chargr * filename, bool native, HANDLE port) {
+    DWORD flags = FILE_ATTRIBUTE_NORMAL;
+    if (native) 
+        flags |= FILE_FLAG_OVERLAPPED;
+
+    m_handle = CreateFileW(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, flags, NULL);
+    if (m_handle == INVALID_HANDLE_VALUE) 
+        return FILE_RESULT_DOESNT_EXIST;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(m_handle, &size)) 
+        return FILE_RESULT_FAIL;
+    m_size = static_cast<uint64>(size.QuadPart);
+
+    // Overlapped reads of the file finish on the engine's port
+    if (native && CreateIoCompletionPort(m_handle, port, ASYNC_KEY_NATIVE, 0) == NULL) 
+        return FILE_RESULT_FAIL;
+    return FILE_RESULT_OK;
+}
+
+//====================================================
+uint64 AsyncFile::GetSize() const {
+    return m_size;
+}
+
+//====================================================
+AsyncIO::AsyncIO(EAsyncIOBackend backend, unsigned numThreads, unsigned maxPending) :
+    m_backend(backend),
+    m_port(NULL),
+    m_completed(NULL),
+    m_threads(NULL),
+    m_numThreads(numThreads),
+    m_numStarted(0),
+    m_ops(NULL),
+    m_maxPending(maxPending),
+    m_nextOp(0)
+{
+    ASSERTMSGGR(numThreads > 0, "Async I/O needs a thread");
+    ASSERTMSGGR(maxPending > 0, "Async I/O needs room for a read");
+    m_threads = new(ASYNC_MEM_FLAGS) IThreadPtr[numThreads];
+    m_ops = new(ASYNC_MEM_FLAGS) AsyncOp[maxPending];
+    memset(m_ops, 0, maxPending * sizeof(AsyncOp));
+}
+
+//====================================================
+AsyncIO::~AsyncIO() {
+    // Every op back in the free count means nothing is left in flight
+    if (m_free != NULL) {
+        for (unsigned i = 0; i < m_maxPending; i++) 
+            m_free->Wait();
+    }
+
+    for (unsigned i = 0; i < m_numStarted; i++) 
+        PostQueuedCompletionStatus(m_port, 0, ASYNC_KEY_STOP, NULL);
+    for (unsigned i = 0; i < m_numStarted; i++) 
+        m_threads[i]->Join();
+    delete [] m_threads;
+
+    if (m_completed != NULL) 
+        CloseHandle(m_completed);
+    if (m_port != NULL) 
+        CloseHandle(m_port);
+    delete [] m_ops;
+}
+
+//====================================================
+bool AsyncIO::Init() {
+    m_port      = CreateIoCompletionPort(INVALID_HANDLE_VALUE, NULL, 0, 0);
+    m_completed = CreateIoCompletionPort(INVALID_HANDLE_VALUE, NULL, 0, 0);
+    if (m_port == NULL || m_completed == NULL) 
+        return false;
+
+    m_free = SemaphoreCreate(m_maxPending);
+    if (m_free == NULL) 
+        return false;
+
+    for (; m_numStarted < m_numThreads; m_numStarted++) {
+        m_threads[m_numStarted] = ThreadCreate(IOThread, this);
+        if (m_threads[m_numStarted] == NULL) 
+            return false;
+    }
+
+    return true;
+}
+
+//====================================================
+AsyncOp * AsyncIO::AcquireOp() {
+    m_free->Wait();
+
+    // The free count promises an op, so the search always ends
+    for (;;) {
+        unsigned start = static_cast<unsigned>(AtomicIncrement(&m_nextOp));
+        for (unsigned i = 0; i < m_maxPending; i++) {
+            AsyncOp * op = &m_ops[(start + i) % m_maxPending];
+            if (AtomicCompareExchange(&op->busy, 1, 0) == 0) 
+                return op;
+        }
+    }
+}
+
+//====================================================
+void AsyncIO::Finish(AsyncOp * op, EFileResult result, unsigned bytesRead) {
+    AsyncRead * read        = op->read;
+    AsyncReadFunc callback  = read->callback;
+    read->result            = result;
+    read->bytesRead         = bytesRead;
+
+    op->read = NULL;
+    AtomicExchange(&op->busy, 0);
+    m_free->Signal(1);
+
+    // Callers may reuse the read once it's done, so only its address is 
+    //  used after that unless there's a callback
+    AtomicExchange(&read->done, 1);
+    if (callback != NULL) 
+        callback(read);
+    else
+        PostQueuedCompletionStatus(m_completed, 0, reinterpret_cast<ULONG_PTR>(read), NULL);
+}
+
+//====================================================
+// Reads on files opened without FILE_FLAG_OVERLAPPED block, and take their 
+//  offset from the OVERLAPPED
+void AsyncIO::ReadBlocking(AsyncOp * op) {
+    AsyncRead * read    = op->read;
+    EFileResult result  = FILE_RESULT_OK;
+    unsigned total      = 0;
+    while (total < read->size) {
+        SetOffset(&op->overlapped, read->offset + total);
+        DWORD bytes = 0;
+        if (!ReadFile(op->handle, read->buffer + total, read->size - total, &bytes, &op->overlapped)) {
+            result = ConvertReadError(GetLastError());
+            break;
+        }
+        if (bytes == 0) {
+            result = FILE_RESULT_EOF;
+            break;
+        }
+        total += bytes;
+    }
+
+    Finish(op, result, total);
+}
+
+//====================================================
+void AsyncIO::IOThread(void * param) {
+    AsyncIO * io = reinterpret_cast<AsyncIO *>(param);
+    for (;;) {
+        DWORD bytes             = 0;
+        ULONG_PTR key           = 0;
+        OVERLAPPED * overlapped = NULL;
+        BOOL success = GetQueuedCompletionStatus(io->m_port, &bytes, &key, &overlapped, INFINITE);
+        if (overlapped == NULL) 
+            break;
+
+        AsyncOp * op = reinterpret_cast<AsyncOp *>(overlapped);
+        if (key == ASYNC_KEY_SUBMIT) 
+            io->ReadBlocking(op);
+        else if (key == ASYNC_KEY_FAILED) 
+            io->Finish(op, op->error, 0);
+        else if (!success) 
+            io->Finish(op, ConvertReadError(GetLastError()), bytes);
+        else
+            io->Finish(op, bytes < op->read->size ? FILE_RESULT_EOF : FILE_RESULT_OK, bytes);
+    }
+}
+
+//====================================================
+IAsyncFilePtr AsyncIO::OpenFile(const chargr * filename, EFileResult * result) {
+    AsyncFile * file = new(ASYNC_MEM_FLAGS) AsyncFile(this);
+
+    *result = file->Open(filename, m_backend == ASYNC_IO_BACKEND_NATIVE, m_port);
+    if (*result != FILE_RESULT_OK) {
+        delete file;
+        file = NULL;
+    }
+
+    return IAsyncFilePtr(file);
+}
+
+//====================================================
+void AsyncIO::Submit(IAsyncFilePtr file, AsyncRead * read) {
+    const AsyncFile * asyncFile = static_cast<const AsyncFile *>(file.operator->());
+    ASSERTMSGGR(asyncFile->GetOwner() == this, "File was opened by another engine");
+    read->result    = FILE_RESULT_OK;
+    read->bytesRead = 0;
+    read->done      = 0;
+
+    AsyncOp * op    = AcquireOp();
+    op->read        = read;
+    op->handle      = asyncFile->GetHandle();
+    if (m_backend != ASYNC_IO_BACKEND_NATIVE) {
+        PostQueuedCompletionStatus(m_port, 0, ASYNC_KEY_SUBMIT, &op->overlapped);
+        return;
+    }
+
+    // Reads that fail as they start don't reach the port on their own, and
+    //  are sent there so they finish on a thread like the rest
+    SetOffset(&op->overlapped, read->offset);
+    if (!ReadFile(op->handle, read->buffer, read->size, NULL, &op->overlapped)) {
+        DWORD error = GetLastError();
+        if (error != ERROR_IO_PENDING) {
+            op->error = ConvertReadError(error);
+            PostQueuedCompletionStatus(m_port, 0, ASYNC_KEY_FAILED, &op->overlapped);
+        }
+    }
+}
+
+//====================================================
+unsigned AsyncIO::Collect(AsyncRead ** reads, unsigned max, bool wait) {
+    unsigned count = 0;
+    while (count < max) {
+        DWORD bytes             = 0;
+        ULONG_PTR key           = 0;
+        OVERLAPPED * overlapped = NULL;
+        DWORD timeout = wait && count == 0 ? INFINITE : 0;
+        if (!GetQueuedCompletionStatus(m_completed, &bytes, &key, &overlapped, timeout)) 
+            break;
+        reads[count++] = reinterpret_cast<AsyncRead *>(key);
+    }
+
+    return count;
+}
+
+//====================================================
+unsigned AsyncIO::Poll(AsyncRead ** reads, unsigned max) {
+    return Collect(reads, max, false);
+}
+
+//====================================================
+unsigned AsyncIO::Wait(AsyncRead ** reads, unsigned max) {
+    return Collect(reads, max, true);
+}
+
+//////////////////////////////////////////////////////
+//
+// External Functions
+//
+
+//====================================================
+IAsyncIOPtr AsyncIOCreate() {
+    return AsyncIOCreate(ASYNC_IO_BACKEND_NATIVE, ASYNC_IO_DEFAULT_THREADS, ASYNC_IO_DEFAULT_PENDING);
+}
+
+//====================================================
+IAsyncIOPtr AsyncIOCreate(EAsyncIOBackend backend, unsigned numThreads, unsigned maxPending) {
+    AsyncIO * io = new(ASYNC_MEM_FLAGS) AsyncIO(backend, numThreads, maxPending);
+    if (!io->Init()) {
+        delete io;
+        io = NULL;
+    }
+
+    return IAsyncIOPtr(io);
+}
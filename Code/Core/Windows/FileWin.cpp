@@ -37,11 +37,13 @@
 class RawFile : public IRawFile {
 public:
     RawFile();
+    ~RawFile();
 
-    EFileResult Open(const chargr * filename);
+    EFileResult Open(const chargr * filename, const charsys * mode);
 
     virtual void Close();
     virtual EFileResult Flush();
+    virtual EFileResult Read(byte * buffer, unsigned len, unsigned * bytesRead);
     virtual EFileResult Write(const chargr * string, unsigned len);
     virtual EFileResult Write(const byte * buffer, unsigned len);
 
@@ -59,6 +61,11 @@ RawFile::RawFile() :
 {
 }
 
+//====================================================
+RawFile::~RawFile() {
+    Close();
+}
+
 //====================================================
 void RawFile::Close() {
     if (m_file != NULL) 
@@ -81,18 +88,37 @@ EFileResult RawFile::Flush() {
 }
 
 //====================================================
-EFileResult RawFile::Open(const chargr * filename) {
+EFileResult RawFile::Open(const chargr * filename, const charsys * mode) {
     EFileResult result = FILE_RESULT_OK;
 
     charsys utf8Filename[256];
     StrConvertToUtf8(filename, utf8Filename, 256);
-    fopen_s(&m_file, utf8Filename, "w");
+    fopen_s(&m_file, utf8Filename, mode);
     if (m_file == NULL) 
         result = ConvertSysError();
 
     return result;
 }
 
+//====================================================
+EFileResult RawFile::Read(byte * buffer, unsigned len, unsigned * bytesRead) {
+    EFileResult result = FILE_RESULT_DOESNT_EXIST;
+    size_t bytes = 0;
+    if (m_file != NULL) {
+        bytes = fread(buffer, 1, len, m_file);
+        if (bytes == len) 
+            result = FILE_RESULT_OK;
+        else if (feof(m_file)) 
+            result = FILE_RESULT_EOF;
+        else
+            result = ConvertSysError();
+    }
+
+    if (bytesRead != NULL) 
+        *bytesRead = static_cast<unsigned>(bytes);
+    return result;
+}
+
 //====================================================
 EFileResult RawFile::Write(const chargr * string, unsigned len) {
     EFileResult result = FILE_RESULT_DOESNT_EXIST;
@@ -121,16 +147,227 @@ EFileResult RawFile::Write(const byte * buffer, unsigned len) {
     return result;
 }
 
+class MappedFile : public IMappedFile {
+public:
+    MappedFile();
+    ~MappedFile();
+
+    EFileResult Open(const chargr * filename, unsigned hints);
+
+    virtual uint64 GetSize() const;
+    virtual IFileViewPtr MapView(uint64 offset, unsigned size);
+
+private:
+    HANDLE      m_file;
+    HANDLE      m_mapping;      // NULL for empty files, they can't be mapped
+    uint64      m_size;
+    unsigned    m_granularity;
+};
+
+class FileView : public IFileView {
+public:
+    FileView(IMappedFilePtr file, void * base, unsigned skip, uint64 offset, unsigned size);
+    ~FileView();
+
+    virtual const byte * GetData() const;
+    virtual unsigned GetSize() const;
+    virtual uint64 GetOffset() const;
+
+private:
+    IMappedFilePtr  m_file;     // Keeps the mapping alive as long as the view
+    void          * m_base;
+    unsigned        m_skip;     // From the aligned base to the requested offset
+    uint64          m_offset;
+    unsigned        m_size;
+};
+
+//====================================================
+MappedFile::MappedFile() :
+    m_file(INVALID_HANDLE_VALUE),
+    m_mapping(NULL),
+    m_size(0),
+    m_granularity(0)
+{
+}
+
+//====================================================
+MappedFile::~MappedFile() {
+    if (m_mapping != NULL) 
+        CloseHandle(m_mapping);
+    if (m_file != INVALID_HANDLE_VALUE) 
+        CloseHandle(m_file);
+}
+
+//====================================================
+EFileResult MappedFile::Open(const chargr * filename, unsigned hints) {
+    // Windows reads ahead through the file cache, which mapped views share. 
+    //  It has no huge pages for file mappings and prefetches on first touch.
+    DWORD flags = FILE_ATTRIBUTE_NORMAL;
+    if (hints & FILE_MAP_HINT_SEQUENTIAL) 
+        flags |= FILE_FLAG_SEQUENTIAL_SCAN;
+    else if (hints & FILE_MAP_HINT_RANDOM) 
+        flags |= FILE_FLAG_RANDOM_ACCESS;
+
+    m_file = CreateFileW(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, flags, NULL);
+    if (m_file == INVALID_HANDLE_VALUE) 
+        return FILE_RESULT_DOESNT_EXIST;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(m_file, &size)) 
+        return FILE_RESULT_FAIL;
+    m_size = static_cast<uint64>(size.QuadPart);
+
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    m_granularity = info.dwAllocationGranularity;
+
+    if (m_size == 0) 
+        return FILE_RESULT_OK;
+
+    m_mapping = CreateFileMappingW(m_file, NULL, PAGE_READONLY, 0, 0, NULL);
+    return m_mapping != NULL ? FILE_RESULT_OK : FILE_RESULT_FAIL;
+}
+
+//====================================================
+uint64 MappedFile::GetSize() const {
+    return m_size;
+}
+
+//====================================================
+IFileViewPtr MappedFile::MapView(uint64 offset, unsigned size) {
+    if (offset >= m_size) 
+        return IFileViewPtr(NULL);
+    if (size > m_size - offset) 
+        size = static_cast<unsigned>(m_size - offset);
+
+    // Views have to start on the allocation granularity, and the skip to the
+    //  requested offset has to fit in the view's size along with the data
+    unsigned skip   = static_cast<unsigned>(offset % m_granularity);
+    uint64 base     = offset - skip;
+    if (size > 0xffffffff - skip) 
+        size = 0xffffffff - skip;
+    void * memory   = MapViewOfFile(
+        m_mapping, 
+        FILE_MAP_READ, 
+        static_cast<DWORD>(base >> 32), 
+        static_cast<DWORD>(base), 
+        skip + size
+    );
+    if (memory == NULL) 
+        return IFileViewPtr(NULL);
+
+    return IFileViewPtr(new(MemFlags(MEM_ARENA_DEFAULT, MEM_CAT_FILEIO)) FileView(this, memory, skip, offset, size));
+}
+
+//====================================================
+FileView::FileView(IMappedFilePtr file, void * base, unsigned skip, uint64 offset, unsigned size) :
+    m_file(file),
+    m_base(base),
+    m_skip(skip),
+    m_offset(offset),
+    m_size(size)
+{
+}
+
+//====================================================
+FileView::~FileView() {
+    UnmapViewOfFile(m_base);
+}
+
+//====================================================
+const byte * FileView::GetData() const {
+    return reinterpret_cast<const byte *>(m_base) + m_skip;
+}
+
+//====================================================
+unsigned FileView::GetSize() const {
+    return m_size;
+}
+
+//====================================================
+uint64 FileView::GetOffset() const {
+    return m_offset;
+}
+
+//====================================================
+static EFileResult FindFiles(
+    const chargr  * root, 
+    chargr        * path, 
+    unsigned        pathLen, 
+    FileFindFunc    func, 
+    void          * param
+) {
+    chargr pattern[FILE_PATH_LENGTH];
+    if (pathLen > 0) 
+        StrPrintf(pattern, FILE_PATH_LENGTH, L"%s/%s/*", root, path);
+    else
+        StrPrintf(pattern, FILE_PATH_LENGTH, L"%s/*", root);
+
+    WIN32_FIND_DATAW data;
+    HANDLE find = FindFirstFileW(pattern, &data);
+    if (find == INVALID_HANDLE_VALUE) 
+        return FILE_RESULT_DOESNT_EXIST;
+
+    EFileResult result = FILE_RESULT_OK;
+    do {
+        if (StrCmp(data.cFileName, L".", 2) == 0 || StrCmp(data.cFileName, L"..", 3) == 0) 
+            continue;
+
+        unsigned nameLen = StrLen(data.cFileName, FILE_PATH_LENGTH);
+        if (pathLen + nameLen + 2 > FILE_PATH_LENGTH) {
+            result = FILE_RESULT_FAIL;
+            continue;
+        }
+
+        // Extend the relative path in place and trim it again afterwards
+        unsigned childLen = pathLen;
+        if (childLen > 0) 
+            path[childLen++] = L'/';
+        StrCopy(path + childLen, FILE_PATH_LENGTH - childLen, data.cFileName);
+        childLen += nameLen;
+
+        bool isDirectory = (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
+        func(path, isDirectory, param);
+        if (isDirectory && FindFiles(root, path, childLen, func, param) == FILE_RESULT_FAIL) 
+            result = FILE_RESULT_FAIL;
+
+        path[pathLen] = 0;
+    } while (FindNextFileW(find, &data));
+
+    FindClose(find);
+    return result;
+}
+
 //////////////////////////////////////////////////////
 //
 // External Functions
 //
 
+//====================================================
+EFileResult FileCreateDirectory(const chargr * path) {
+    if (CreateDirectoryW(path, NULL) || GetLastError() == ERROR_ALREADY_EXISTS) 
+        return FILE_RESULT_OK;
+    return FILE_RESULT_FAIL;
+}
+
+//====================================================
+bool FileExists(const chargr * filename) {
+    return GetFileAttributesW(filename) != INVALID_FILE_ATTRIBUTES;
+}
+
+//====================================================
+EFileResult FileFindRecursive(const chargr * root, FileFindFunc func, void * param) {
+    chargr path[FILE_PATH_LENGTH];
+    path[0] = 0;
+    return FindFiles(root, path, 0, func, param);
+}
+
+//====================================================
 IRawFilePtr FileOpenRaw(const chargr * filename, EFileResult * result) {
 
     RawFile * file = new(MemFlags(MEM_ARENA_DEFAULT, MEM_CAT_FILEIO)) RawFile;
 
-    *result = file->Open(filename);
+    *result = file->Open(filename, "w");
     if (*result != FILE_RESULT_OK) {
         delete file;
         file = NULL;
@@ -139,3 +376,31 @@ IRawFilePtr FileOpenRaw(const chargr * filename, EFileResult * result) {
     return IRawFilePtr(file);
 }
 
+//====================================================
+IRawFilePtr FileOpenRaw(const chargr * filename, EFileMode mode, EFileResult * result) {
+
+    RawFile * file = new(MemFlags(MEM_ARENA_DEFAULT, MEM_CAT_FILEIO)) RawFile;
+
+    *result = file->Open(filename, mode == FILE_MODE_READ ? "rb" : "wb");
+    if (*result != FILE_RESULT_OK) {
+        delete file;
+        file = NULL;
+    }
+
+    return IRawFilePtr(file);
+}
+
+
+//====================================================
+IMappedFilePtr FileOpenMapped(const chargr * filename, unsigned hints, EFileResult * result) {
+
+    MappedFile * file = new(MemFlags(MEM_ARENA_DEFAULT, MEM_CAT_FILEIO)) MappedFile;
+
+    *result = file->Open(filename, hints);
+    if (*result != FILE_RESULT_OK) {
+        delete file;
+        file = NULL;
+    }
+
+    return IMappedFilePtr(file);
+}
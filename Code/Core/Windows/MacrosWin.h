@@ -73,6 +73,24 @@
     #define TOWSTR_NORELEASE(str)    TOWCHAR(#str)
 #endif
 
+//////////////////////////////////////////////////////
+//
+// Convert a symbol to a string for non-gold builds
+//
+
+#ifdef GOLD
+    #define TOWSTR_NOGOLD(str)    NULL
+#else
+    #define TOWSTR_NOGOLD(str)    TOWCHAR(#str)
+#endif
+
+//////////////////////////////////////////////////////
+//
+// Per thread storage for statics
+//
+
+#define THREADLOCAL    __declspec(thread)
+
 //////////////////////////////////////////////////////
 //
 // Used as a reminder that code is untested
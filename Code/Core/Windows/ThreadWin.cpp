@@ -0,0 +1,200 @@
+/*
+   GameRiff - Framework for creating various video game services
+   Windows implementation of threads and atomic operations
+   Copyright (C) 2011, Shaun Leach.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are
+   met:
+  
+       * Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+       * Redistributions in binary form must reproduce the above
+   copyright notice, this list of conditions and the following disclaimer
+   in the documentation and/or other materials provided with the
+   distribution.
+  
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "Pch.h"
+
+//////////////////////////////////////////////////////
+//
+// Internal implementation
+//
+
+class Thread : public IThread {
+public:
+    Thread(ThreadFunc func, void * param);
+    ~Thread();
+
+    bool Start();
+
+    virtual void Join();
+
+private:
+    static DWORD WINAPI ThreadProc(LPVOID param);
+
+private:
+    ThreadFunc  m_func;
+    void      * m_param;
+    HANDLE      m_handle;
+};
+
+//====================================================
+Thread::Thread(ThreadFunc func, void * param) :
+    m_func(func),
+    m_param(param),
+    m_handle(NULL)
+{
+}
+
+//====================================================
+Thread::~Thread() {
+    Join();
+}
+
+//====================================================
+void Thread::Join() {
+    if (m_handle != NULL) {
+        WaitForSingleObject(m_handle, INFINITE);
+        CloseHandle(m_handle);
+    }
+    m_handle = NULL;
+}
+
+//====================================================
+bool Thread::Start() {
+    m_handle = CreateThread(NULL, 0, ThreadProc, this, 0, NULL);
+    return m_handle != NULL;
+}
+
+//====================================================
+DWORD WINAPI Thread::ThreadProc(LPVOID param) {
+    Thread * thread = reinterpret_cast<Thread *>(param);
+    thread->m_func(thread->m_param);
+    return 0;
+}
+
+class Semaphore : public ISemaphore {
+public:
+    Semaphore();
+    ~Semaphore();
+
+    bool Create(unsigned initialCount);
+
+    virtual void Signal(unsigned count);
+    virtual void Wait();
+
+private:
+    HANDLE m_handle;
+};
+
+//====================================================
+Semaphore::Semaphore() :
+    m_handle(NULL)
+{
+}
+
+//====================================================
+Semaphore::~Semaphore() {
+    if (m_handle != NULL) 
+        CloseHandle(m_handle);
+}
+
+//====================================================
+bool Semaphore::Create(unsigned initialCount) {
+    m_handle = CreateSemaphoreW(NULL, initialCount, 0x7fffffff, NULL);
+    return m_handle != NULL;
+}
+
+//====================================================
+void Semaphore::Signal(unsigned count) {
+    if (count > 0) 
+        ReleaseSemaphore(m_handle, count, NULL);
+}
+
+//====================================================
+void Semaphore::Wait() {
+    WaitForSingleObject(m_handle, INFINITE);
+}
+
+//////////////////////////////////////////////////////
+//
+// External Functions
+//
+
+//====================================================
+int32 AtomicAdd(volatile int32 * value, int32 add) {
+    return InterlockedExchangeAdd(reinterpret_cast<volatile LONG *>(value), add) + add;
+}
+
+//====================================================
+int32 AtomicCompareExchange(volatile int32 * value, int32 exchange, int32 comparand) {
+    return InterlockedCompareExchange(reinterpret_cast<volatile LONG *>(value), exchange, comparand);
+}
+
+//====================================================
+void * AtomicCompareExchangePointer(void * volatile * value, void * exchange, void * comparand) {
+    return InterlockedCompareExchangePointer(value, exchange, comparand);
+}
+
+//====================================================
+int32 AtomicExchange(volatile int32 * value, int32 exchange) {
+    return InterlockedExchange(reinterpret_cast<volatile LONG *>(value), exchange);
+}
+
+//====================================================
+void * AtomicExchangePointer(void * volatile * value, void * exchange) {
+    return InterlockedExchangePointer(value, exchange);
+}
+
+//====================================================
+int32 AtomicIncrement(volatile int32 * value) {
+    return InterlockedIncrement(reinterpret_cast<volatile LONG *>(value));
+}
+
+//====================================================
+IThreadPtr ThreadCreate(ThreadFunc func, void * param) {
+    Thread * thread = new(MemFlags(MEM_ARENA_DEFAULT, MEM_CAT_UNCATEGORIZED)) Thread(func, param);
+    if (!thread->Start()) {
+        delete thread;
+        thread = NULL;
+    }
+
+    return IThreadPtr(thread);
+}
+
+//====================================================
+ISemaphorePtr SemaphoreCreate(unsigned initialCount) {
+    Semaphore * semaphore = new(MemFlags(MEM_ARENA_DEFAULT, MEM_CAT_UNCATEGORIZED)) Semaphore;
+    if (!semaphore->Create(initialCount)) {
+        delete semaphore;
+        semaphore = NULL;
+    }
+
+    return ISemaphorePtr(semaphore);
+}
+
+//====================================================
+unsigned ThreadNumCores() {
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors > 0 ? info.dwNumberOfProcessors : 1;
+}
+
+//====================================================
+void ThreadYield() {
+    SwitchToThread();
+}
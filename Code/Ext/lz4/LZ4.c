@@ -119,12 +119,12 @@ int LZ4_compressCtx(void** ctx,
         struct refTables *srt = (struct refTables *) (*ctx);
         BYTE**  HashTable;
 
-        BYTE    *ip = source,      /* input pointer */ 
-                        *anchor = source,
-                        *iend = source + isize,
+        BYTE    *ip = (BYTE*)source,      /* input pointer */ 
+                        *anchor = (BYTE*)source,
+                        *iend = (BYTE*)source + isize,
                         *ilimit = iend - MINMATCH - 1;
 
-        BYTE    *op = dest,  /* output pointer */
+        BYTE    *op = (BYTE*)dest,  /* output pointer */
                         *ref,
                         *orun, *l_end;
         
@@ -207,7 +207,7 @@ int LZ4_compressCtx(void** ctx,
 
         // End
 
-        return op-dest;
+        return op-(BYTE*)dest;
 }
 
 
@@ -220,10 +220,10 @@ int LZ4_decode ( char* source,
                                  int isize)
 {       
         // Local Variables
-        BYTE    *ip = source,      
-                        *iend = source + isize;
+        BYTE    *ip = (BYTE*)source,      
+                        *iend = (BYTE*)source + isize;
 
-        BYTE    *op = dest, 
+        BYTE    *op = (BYTE*)dest, 
                         *ref, *cpy,
                         runcode;
         
@@ -274,6 +274,6 @@ int LZ4_decode ( char* source,
         }
 
         // end of decoding
-        return op-dest;
+        return op-(BYTE*)dest;
 }
 
@@ -0,0 +1,235 @@
+/*
+   GameRiff - Framework for creating various video game services
+   CRC32C checksums
+   Copyright (C) 2011, Shaun Leach.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are
+   met:
+  
+       * Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+       * Redistributions in binary form must reproduce the above
+   copyright notice, this list of conditions and the following disclaimer
+   in the documentation and/or other materials provided with the
+   distribution.
+  
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include "Pch.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+    #define CRC32C_USE_SSE42
+    #include <nmmintrin.h>
+    #ifdef _MSC_VER
+        #include <intrin.h>
+    #else
+        #include <cpuid.h>
+    #endif
+#endif
+
+namespace NSCrc32c {
+
+//////////////////////////////////////////////////////
+//
+// Constants
+//
+
+// Castagnoli polynomial, bit reversed
+static const uint32     s_polynomial        = 0x82f63b78;
+
+// Bytes in each of the three lanes checksummed side by side
+static const unsigned   s_laneSize          = 2048;
+
+//////////////////////////////////////////////////////
+//
+// Internal
+//
+
+// Tables for eight bytes at a time. Table n holds the crc of each byte 
+//  followed by n zero bytes. The shift tables move a crc past a lane of 
+//  zero bytes, a byte of it at a time.
+class Crc32cTables {
+public:
+    Crc32cTables();
+
+    uint32 table[8][256];
+    uint32 shift[4][256];
+};
+
+//====================================================
+Crc32cTables::Crc32cTables() {
+    for (unsigned i = 0; i < 256; i++) {
+        uint32 crc = i;
+        for (unsigned bit = 0; bit < 8; bit++) 
+            crc = (crc >> 1) ^ (s_polynomial & (0 - (crc & 1)));
+        table[0][i] = crc;
+    }
+
+    for (unsigned n = 1; n < 8; n++) {
+        for (unsigned i = 0; i < 256; i++) 
+            table[n][i] = (table[n - 1][i] >> 8) ^ table[0][table[n - 1][i] & 0xff];
+    }
+
+    // Shifting is linear, so only each bit is run through the zeros
+    uint32 bits[32];
+    for (unsigned bit = 0; bit < 32; bit++) {
+        uint32 crc = 1u << bit;
+        for (unsigned i = 0; i < s_laneSize; i++) 
+            crc = table[0][crc & 0xff] ^ (crc >> 8);
+        bits[bit] = crc;
+    }
+
+    for (unsigned n = 0; n < 4; n++) {
+        for (unsigned i = 0; i < 256; i++) {
+            uint32 crc = 0;
+            for (unsigned bit = 0; bit < 8; bit++) {
+                if (i & (1 << bit)) 
+                    crc ^= bits[8 * n + bit];
+            }
+            shift[n][i] = crc;
+        }
+    }
+}
+
+static const Crc32cTables s_tables;
+
+//====================================================
+static uint32 Crc32cTable(const byte * data, unsigned length, uint32 crc) {
+    const uint32 (* table)[256] = s_tables.table;
+    for (; length >= 8; data += 8, length -= 8) {
+        uint32 low;
+        uint32 high;
+        memcpy(&low, data, sizeof(low));
+        memcpy(&high, data + 4, sizeof(high));
+        low ^= crc;
+        crc = table[7][low & 0xff]  ^ table[6][(low >> 8) & 0xff]  ^ table[5][(low >> 16) & 0xff]  ^ table[4][low >> 24]
+            ^ table[3][high & 0xff] ^ table[2][(high >> 8) & 0xff] ^ table[1][(high >> 16) & 0xff] ^ table[0][high >> 24];
+    }
+
+    for (; length > 0; data++, length--) 
+        crc = table[0][(crc ^ *data) & 0xff] ^ (crc >> 8);
+    return crc;
+}
+
+#ifdef CRC32C_USE_SSE42
+
+// The instruction is used behind a check of the CPU, so only the function 
+//  that uses it is built for SSE4.2
+#ifdef __GNUC__
+    #define CRC32C_TARGET_SSE42 __attribute__((target("sse4.2")))
+#else
+    #define CRC32C_TARGET_SSE42
+#endif
+
+//====================================================
+static bool HasSse42() {
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 1);
+    return (info[2] & (1 << 20)) != 0;
+#else
+    unsigned eax, ebx, ecx, edx;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) 
+        return false;
+    return (ecx & (1 << 20)) != 0;
+#endif
+}
+
+static const bool s_hasSse42 = HasSse42();
+
+//====================================================
+static uint32 ShiftLane(uint32 crc) {
+    const uint32 (* shift)[256] = s_tables.shift;
+    return shift[0][crc & 0xff] ^ shift[1][(crc >> 8) & 0xff] ^ shift[2][(crc >> 16) & 0xff] ^ shift[3][crc >> 24];
+}
+
+//====================================================
+CRC32C_TARGET_SSE42 static inline uint32 Crc32cWord(uint32 crc, const byte * data) {
+#if defined(_M_X64) || defined(__x86_64__)
+    uint64 word;
+    memcpy(&word, data, sizeof(word));
+    return static_cast<uint32>(_mm_crc32_u64(crc, word));
+#else
+    uint32 low;
+    uint32 high;
+    memcpy(&low, data, sizeof(low));
+    memcpy(&high, data + 4, sizeof(high));
+    return _mm_crc32_u32(_mm_crc32_u32(crc, low), high);
+#endif
+}
+
+//====================================================
+// Each crc instruction waits on the last, so three lanes are run at once to
+//  keep the unit busy and their crcs are joined by shifting past the lanes
+//  that follow them
+CRC32C_TARGET_SSE42 static uint32 Crc32cSse42(const byte * data, unsigned length, uint32 crc) {
+    for (; length >= 3 * s_laneSize; data += 3 * s_laneSize, length -= 3 * s_laneSize) {
+        uint32 crc0 = crc;
+        uint32 crc1 = 0;
+        uint32 crc2 = 0;
+        for (unsigned i = 0; i < s_laneSize; i += 8) {
+            crc0 = Crc32cWord(crc0, data + i);
+            crc1 = Crc32cWord(crc1, data + s_laneSize + i);
+            crc2 = Crc32cWord(crc2, data + 2 * s_laneSize + i);
+        }
+
+        crc = ShiftLane(crc0) ^ crc1;
+        crc = ShiftLane(crc) ^ crc2;
+    }
+
+#if defined(_M_X64) || defined(__x86_64__)
+    uint64 crc64 = crc;
+    for (; length >= 8; data += 8, length -= 8) {
+        uint64 word;
+        memcpy(&word, data, sizeof(word));
+        crc64 = _mm_crc32_u64(crc64, word);
+    }
+    crc = static_cast<uint32>(crc64);
+#endif
+
+    for (; length >= 4; data += 4, length -= 4) {
+        uint32 word;
+        memcpy(&word, data, sizeof(word));
+        crc = _mm_crc32_u32(crc, word);
+    }
+    for (; length > 0; data++, length--) 
+        crc = _mm_crc32_u8(crc, *data);
+    return crc;
+}
+
+#endif
+
+} // namespace NSCrc32c
+
+//////////////////////////////////////////////////////
+//
+// External functions
+//
+
+//====================================================
+uint32 HashCrc32c(const void * data, unsigned length) {
+    return HashCrc32c(data, length, 0);
+}
+
+//====================================================
+uint32 HashCrc32c(const void * data, unsigned length, uint32 crc) {
+    const byte * bytes = reinterpret_cast<const byte *>(data);
+#ifdef CRC32C_USE_SSE42
+    if (NSCrc32c::s_hasSse42) 
+        return ~NSCrc32c::Crc32cSse42(bytes, length, ~crc);
+#endif
+    return ~NSCrc32c::Crc32cTable(bytes, length, ~crc);
+}
@@ -81,6 +81,13 @@ Hash64::Hash64(const void * data, unsigned length) {
     m_hash = NSLookup3::Lookup3Hash64(data, length, INIT_A, INIT_B);
 }
 
+//====================================================
+Hash64::Hash64(const void * data, unsigned length, const Hash64 & seed) {
+    uint32 seedA = static_cast<uint32>(seed.m_hash);
+    uint32 seedB = static_cast<uint32>(seed.m_hash >> 32);
+    m_hash = NSLookup3::Lookup3Hash64(data, length, INIT_A ^ seedA, INIT_B ^ seedB);
+}
+
 //====================================================
 Hash32::Hash32(const charsys * str) {
     m_hash = NSLookup3::Lookup3HashString32(str, INIT_A);
@@ -148,6 +155,26 @@ Hash32 HashString32(
     return Hash32(str);
 }
 
+//====================================================
+Hash64 HashUtf8String64(
+    const charsys * str,
+    unsigned        length
+) {
+    Hash64 hash;
+    hash.m_hash = NSLookup3::Lookup3HashUtf8String64(str, length, INIT_A, INIT_B);
+    return hash;
+}
+
+//====================================================
+Hash32 HashUtf8String32(
+    const charsys * str,
+    unsigned        length
+) {
+    Hash32 hash;
+    hash.m_hash = static_cast<uint32>(NSLookup3::Lookup3HashUtf8String64(str, length, INIT_A, 0));
+    return hash;
+}
+
 //====================================================
 Hash64 HashData64(
     const void    * data,
@@ -156,6 +183,15 @@ Hash64 HashData64(
     return Hash64(data, length);
 }
 
+//====================================================
+Hash64 HashData64(
+    const void    * data,
+    unsigned        length,
+    const Hash64  & seed
+) {
+    return Hash64(data, length, seed);
+}
+
 //====================================================
 Hash32 HashData32(
     const void    * data,
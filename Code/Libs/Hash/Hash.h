@@ -43,6 +43,7 @@ public:
     Hash64(const chargr * str, uint64 hash);
     Hash64(const charsys * str, uint64 hash);
     Hash64(const void * data, unsigned length);
+    Hash64(const void * data, unsigned length, const Hash64 & seed);
 
     bool operator == (const Hash64 rhs) const {
         return m_hash == rhs.m_hash;
@@ -50,7 +51,13 @@ public:
     bool operator != (const Hash64 rhs) const {
         return m_hash != rhs.m_hash;
     }
+
+    uint64 GetValue() const {
+        return m_hash;
+    }
 private:
+    friend Hash64 HashUtf8String64(const charsys * str, unsigned length);
+
     uint64 m_hash;
 };
 
@@ -72,7 +79,13 @@ public:
     bool operator != (const Hash32 rhs) const {
         return m_hash != rhs.m_hash;
     }
+
+    uint32 GetValue() const {
+        return m_hash;
+    }
 private:
+    friend Hash32 HashUtf8String32(const charsys * str, unsigned length);
+
     uint32 m_hash;
 };
 
@@ -95,13 +108,52 @@ Hash32 HashString32(
     const charsys * str
 );
 
+//
+// Hashes UTF-8 text the same as HashString of the chargr string it decodes
+//  to, without decoding it first. The text needs no terminator.
+//
+Hash64 HashUtf8String64(
+    const charsys * str,
+    unsigned        length
+);
+
+Hash32 HashUtf8String32(
+    const charsys * str,
+    unsigned        length
+);
+
 Hash64 HashData64(
     const void    * data,
     unsigned        length
 );
 
+//
+// Continues a previous hash, used for hashing data that isn't contiguous
+//
+Hash64 HashData64(
+    const void    * data,
+    unsigned        length,
+    const Hash64  & seed
+);
+
 Hash32 HashData32(
     const void    * data,
     unsigned        length
 );
 
+//
+// CRC32C checksum, using the SSE4.2 instruction when the CPU has it. Meant 
+//  for catching corrupt data rather than identifying it. The seeded version
+//  continues a previous checksum.
+//
+uint32 HashCrc32c(
+    const void    * data,
+    unsigned        length
+);
+
+uint32 HashCrc32c(
+    const void    * data,
+    unsigned        length,
+    uint32          crc
+);
+
@@ -152,6 +152,62 @@ wchar_t GetWCharInsensitive(wchar_t c) {
     return c;
 }
 
+//====================================================
+// Walks UTF-8 text as the wchar_t units it decodes to, characters outside
+//  of the basic plane are surrogate pairs where wchar_t is 16 bits
+class Utf8Units {
+public:
+    Utf8Units(const char * key, unsigned length) :
+        m_pos(reinterpret_cast<const unsigned char *>(key)),
+        m_end(reinterpret_cast<const unsigned char *>(key) + length),
+        m_low(0)
+    {
+    }
+
+    bool Done() const {
+        return m_pos == m_end && m_low == 0;
+    }
+
+    uint32 Next() {
+        if (m_low != 0) {
+            uint32 low = m_low;
+            m_low = 0;
+            return low;
+        }
+
+        uint32 code = *m_pos++;
+        unsigned extra = 0;
+        if (code >= 0xf0) {
+            code &= 0x07;
+            extra = 3;
+        }
+        else if (code >= 0xe0) {
+            code &= 0x0f;
+            extra = 2;
+        }
+        else if (code >= 0xc0) {
+            code &= 0x1f;
+            extra = 1;
+        }
+        for (; extra > 0 && m_pos < m_end; extra--) 
+            code = (code << 6) | (*m_pos++ & 0x3f);
+
+        if (sizeof(wchar_t) == 2 && code >= 0x10000) {
+            code -= 0x10000;
+            m_low = 0xdc00 | (code & 0x3ff);
+            return 0xd800 | (code >> 10);
+        }
+        if ('A' <= code && code <= 'Z') 
+            return 'a' + (code - 'A');
+        return code;
+    }
+
+private:
+    const unsigned char   * m_pos;
+    const unsigned char   * m_end;
+    uint32                  m_low;
+};
+
 //////////////////////////////////////////////////////
 //
 // External Functions
@@ -569,4 +625,52 @@ uint32 Lookup3HashString32(
     return (0xffffffff & Lookup3HashString64(key, pc, 0));
 }
 
+//====================================================
+uint64 Lookup3HashUtf8String64(
+    const char        * key,       /* the key to hash */
+    unsigned            length,    /* length of the key in bytes */
+    uint32              pc,        /* IN: primary initval */
+    uint32              pb
+) {
+    uint32 a,b,c;                                          /* internal state */
+
+    // The length is in wchar_t units, so the text is walked twice
+    unsigned units = 0;
+    for (Utf8Units count(key, length); !count.Done(); count.Next()) 
+        units++;
+
+    /* Set up the internal state */
+    a = b = c = 0xdeadbeef + ((uint32)units) + pc;
+    c += pb;
+
+    Utf8Units unit(key, length);
+
+    /*--------------- all but the last block: affect some 32 bits of (a,b,c) */
+    while (units > 6) {
+        a += unit.Next();
+        a += unit.Next()<<16;
+        b += unit.Next();
+        b += unit.Next()<<16;
+        c += unit.Next();
+        c += unit.Next()<<16;
+        mix(a,b,c);
+        units -= 6;
+    }
+
+    /*-------------------------------- last block: affect all 32 bits of (c) */
+    if (units == 0) 
+        return c;
+
+    uint32 last[6] = { 0, 0, 0, 0, 0, 0 };
+    for (unsigned i = 0; i < units; i++) 
+        last[i] = unit.Next();
+    a += last[0] + (last[1]<<16);
+    b += last[2] + (last[3]<<16);
+    c += last[4] + (last[5]<<16);
+
+    final(a,b,c);
+
+    return(uint64) c | ((uint64) b) << 32;
+}
+
 } // namespace NSLookup3
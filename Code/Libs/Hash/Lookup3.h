@@ -71,6 +71,14 @@ uint32 Lookup3HashString32(
     uint32          initval
 );
 
+// Same as the wchar_t versions over the string the UTF-8 decodes to
+uint64 Lookup3HashUtf8String64(
+    const char    * key,       /* the key to hash */
+    unsigned        length,    /* length of the key in bytes */
+    uint32          pc,        /* IN: primary initval, OUT: primary hash */
+    uint32          pb
+);
+
 uint64 Lookup3HashString64(
     const wchar_t * key,       /* the key to hash */
     uint32          pc,        /* IN: primary initval, OUT: primary hash */
@@ -63,4 +63,56 @@ TEST(HashDataTest, TestUniqueness32) {
     EXPECT_NE(HashData32(DATA_FILE1, LEN_FILE1), HashData32(DATA_FILE2, LEN_FILE2));
 }
 
+TEST(HashDataTest, TestSeeded64) {
+    Hash64 seedA = HashData64(DATA_A, LEN_A);
+    Hash64 seedB = HashData64(DATA_B, LEN_B);
 
+    EXPECT_EQ(HashData64(DATA_1, LEN_1, seedA), HashData64(DATA_1, LEN_1, seedA));
+
+    EXPECT_NE(HashData64(DATA_1, LEN_1, seedA), HashData64(DATA_1, LEN_1, seedB));
+    EXPECT_NE(HashData64(DATA_1, LEN_1, seedA), HashData64(DATA_1, LEN_1));
+    EXPECT_NE(HashData64(DATA_1, LEN_1, seedA), HashData64(DATA_2, LEN_2, seedA));
+}
+
+
+// One bit at a time, straight from the definition
+static uint32 Crc32cBitwise(const byte * data, unsigned length) {
+    uint32 crc = 0xffffffff;
+    for (unsigned i = 0; i < length; i++) {
+        crc ^= data[i];
+        for (unsigned bit = 0; bit < 8; bit++) 
+            crc = (crc >> 1) ^ (0x82f63b78 & (0 - (crc & 1)));
+    }
+    return ~crc;
+}
+
+TEST(HashDataTest, TestCrc32c) {
+    // Check value from the standard
+    EXPECT_EQ(0xe3069283, HashCrc32c("123456789", 9));
+    EXPECT_EQ(0u, HashCrc32c(NULL, 0));
+
+    // Every alignment and split gives the checksum of the whole
+    byte data[256];
+    for (unsigned i = 0; i < 256; i++) 
+        data[i] = static_cast<byte>(i * 167 + 13);
+    for (unsigned start = 0; start < 8; start++) {
+        for (unsigned length = 0; start + length <= 256; length += 7) {
+            uint32 expected = Crc32cBitwise(data + start, length);
+            unsigned split  = length / 3;
+            EXPECT_EQ(expected, HashCrc32c(data + start, length));
+            EXPECT_EQ(expected, HashCrc32c(data + start + split, length - split, HashCrc32c(data + start, split)));
+        }
+    }
+
+    // Long enough to be checksummed in lanes, with some left over
+    const unsigned longLength = 50000;
+    byte * longData = new byte[longLength];
+    for (unsigned i = 0; i < longLength; i++) 
+        longData[i] = static_cast<byte>((i * 2654435761u) >> 13);
+    for (unsigned length = longLength - 20; length <= longLength; length += 5) {
+        uint32 expected = Crc32cBitwise(longData, length);
+        EXPECT_EQ(expected, HashCrc32c(longData, length));
+        EXPECT_EQ(expected, HashCrc32c(longData + 1001, length - 1001, HashCrc32c(longData, 1001)));
+    }
+    delete [] longData;
+}
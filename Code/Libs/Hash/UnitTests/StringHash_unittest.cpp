@@ -71,3 +71,16 @@ TEST(StringHashTest, TestWideChar) {
 
     EXPECT_NE(HashString64("art/planets/textures/gasGiant1.dds"), HashString64(L"art/planets/textures/gasGiant1.dds"));
 }
+
+TEST(StringHashTest, TestUtf8) {
+    EXPECT_EQ(HashString32(L""), HashUtf8String32("", 0));
+    EXPECT_EQ(HashString32(L"DataMember"), HashUtf8String32("datamember", 10));
+    EXPECT_EQ(HashString64(L"art/planets/textures/gasGiant1.dds"), HashUtf8String64("art/planets/textures/gasGiant1.dds", 34));
+
+    // Only the given length is hashed
+    EXPECT_EQ(HashString32(L"Type"), HashUtf8String32("Type='uint32'", 4));
+
+    // Multibyte characters hash as the characters they decode to
+    EXPECT_EQ(HashString32(L"caf\x00e9 \x20ac"), HashUtf8String32("caf\xc3\xa9 \xe2\x82\xac", 9));
+    EXPECT_EQ(HashString64(L"caf\x00e9 \x20ac"), HashUtf8String64("caf\xc3\xa9 \xe2\x82\xac", 9));
+}
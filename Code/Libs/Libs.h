@@ -41,6 +41,10 @@
     #define USES_LIBS_HASH
 #endif
 
+#ifdef USES_LIBS_STREAM
+    #define USES_LIBS_HASH
+#endif
+
 //////////////////////////////////////////////////////
 //
 // Includes
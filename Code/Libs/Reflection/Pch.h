@@ -29,9 +29,11 @@
 
 #pragma once
 
+#include <math.h>
 #include <stdlib.h>
 #include <wchar.h>
 #include <stdio.h>
+#include <string.h>
 
 #define USES_LIBS_MATH
 #define USES_LIBS_REFLECTION
@@ -29,6 +29,12 @@
 
 #include "Pch.h"
 
+// Numeric conversions are vectorized where SSE2 is always available
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+    #include <emmintrin.h>
+    #define REFL_SSE2
+#endif
+
 LOG_DEFINE_MODULE(Reflection);
 
 //////////////////////////////////////////////////////
@@ -56,6 +62,7 @@ enum EReflIndex {
     REFL_INDEX_FIXED_ARRAY,
     REFL_INDEX_VAR_ARRAY,
     REFL_INDEX_POINTER,
+    REFL_INDEX_BITFIELD,
     REFL_INDEX_COLOR,
     REFL_INDEX_ANGLE,
     REFL_INDEX_PERCENTAGE,
@@ -66,8 +73,39 @@ enum EReflIndex {
     REFL_INDEX_ENDTYPE,
 };
 
+// Binary files start with the magic, format version and object count
+static const uint32 s_binaryMagic       = 0x42525247; // 'GRRB'
+static const uint32 s_binaryVersion     = 1;
+static const uint32 s_nullObjectId      = 0xffffffff;
+static const uint32 s_batchMagic        = 0x48435442; // 'BTCH'
+static const unsigned s_batchAlignment  = 16;
+static const uint64 s_maxBatchBytes     = 1024 * 1024 * 1024;
+
+// Chunk versions of chunked files, objects chunks use the binary version
+static const uint32 s_chunkStringsVersion   = 1;
+static const uint32 s_chunkSchemaVersion    = 1;
+static const uint64 s_maxChunkStrings       = 64 * 1024 * 1024;
+
+// Bitfields of a class are packed into one binary record under this name
+static const ReflHash s_bitfieldRecordName(L"<bitfields>");
+static const unsigned s_maxBitfieldBytes = 64;
+
+// Largest old value handed to a conversion function
+static const unsigned s_maxConversionBytes = 16;
+
+// Node and attribute names of text files, loads dispatch on their hashes
+static const ReflHash s_classNode(L"Class");
+static const ReflHash s_dataMemberNode(L"DataMember");
+static const ReflHash s_baseClassNode(L"BaseClass");
+static const ReflHash s_nameAttribute(L"Name");
+static const ReflHash s_typeAttribute(L"Type");
+
+// Bump when the exported schema layout changes
+static const unsigned s_schemaVersion   = 1;
+
 static ReflTypeDesc  * s_descHead  = NULL;
 static ReflAlias      * s_classAliasHead = NULL;
+static ReflPrototype  * s_prototypeHead = NULL;
 
 ReflHash ReflClass::s_classType(TOWSTR(ReflClass));
 
@@ -79,12 +117,15 @@ ReflHash ReflClass::s_classType(TOWSTR(ReflClass));
 typedef void (*ToStringFunc)(const ReflMember * desc, const byte * data, const chargr * format, chargr * str, unsigned len);
 typedef void (*FromStringFunc)(const ReflMember * desc, byte * data, const chargr * format, const chargr * str, unsigned len);
 
+static bool IsIntegerType(ReflHash typeHash);
+
 struct TypeDesc {
     TypeDesc() {
         // Empty constructor seen as the table will have already 
         //   been initialized in the function below by the time
-        //   the global constructor is called.
-        typeHash = ReflHash(m_typeName);
+        //   the global constructor is called. Programs without any
+        //   reflected members never fill it in.
+        typeHash = m_typeName != NULL ? ReflHash(m_typeName) : ReflHash();
     }
 
     TypeDesc(
@@ -118,11 +159,22 @@ struct TypeDesc {
         bool result = false;
         if (m_index == REFL_INDEX_ENUM) 
             result = givenType == memberType;
+        else if (m_index == REFL_INDEX_BITFIELD) {
+            // Flags that used to be separate bool or integer members still load
+            result = givenType == typeHash || givenType == memberType || IsIntegerType(givenType);
+        }
         else
             result = givenType == typeHash;
         return result;
     }
 
+    // Values stay UTF-8 in the stream until they're parsed here
+    void FromView(const ReflMember * member, byte * data, const StreamTextView & value) const {
+        chargr str[256];
+        StreamViewToCharGr(value, str, 256);
+        fromString(member, data, format, str, 256);
+    }
+
     ReflHash        typeHash;
     unsigned        typeSize;
     const chargr  * format;
@@ -136,11 +188,685 @@ private:
 
 static TypeDesc s_typeDesc[REFL_INDEX_ENDTYPE];
 
+//====================================================
+static bool IsIntegerType(ReflHash typeHash) {
+    for (unsigned i = REFL_INDEX_BOOL; i <= REFL_INDEX_UINT64; i++) {
+        if (s_typeDesc[i].typeHash == typeHash) 
+            return true;
+    }
+    return false;
+}
+
+#define REFL_MEM_FLAGS      (MemFlags(MEM_ARENA_GLOBAL, MEM_CAT_REFLECTION))
+#define REFL_TEMP_MEM_FLAGS (MemFlags(MEM_ARENA_TRANSIENT, MEM_CAT_REFLECTION))
+
+//////////////////////////////////////////////////////
+//
+// Hash-consing table for shared instances. Open addressing with linear 
+//  probing, keyed by content hash.
+//
+
+struct SharedInstance {
+    SharedInstance() :
+        inst(NULL),
+        refCount(0)
+    {
+    }
+
+    Hash64      contentHash;
+    ReflClass * inst;
+    unsigned    refCount;
+};
+
+static SharedInstance * s_sharedInstances   = NULL;
+static unsigned         s_sharedCapacity    = 0;
+static unsigned         s_sharedCount       = 0;
+
+//====================================================
+template<typename t_type>
+static void GrowArray(t_type ** array, unsigned * capacity, unsigned count) {
+    if (count < *capacity) 
+        return;
+
+    unsigned newCapacity = *capacity == 0 ? 32 : 2 * *capacity;
+    t_type * newArray = new(REFL_TEMP_MEM_FLAGS) t_type[newCapacity];
+    for (unsigned i = 0; i < count; i++) 
+        newArray[i] = (*array)[i];
+
+    if (*array != NULL) 
+        delete [] *array;
+    *array      = newArray;
+    *capacity   = newCapacity;
+}
+
+//////////////////////////////////////////////////////
+//
+// Object graph writing. Every object reachable from the root gets an id in
+//  the order it's first referenced, and is written once in id order.
+//
+
+class ReflGraphWriter {
+public:
+    ReflGraphWriter() :
+        m_objects(NULL),
+        m_slots(NULL),
+        m_numObjects(0),
+        m_capacity(0)
+    {
+    }
+    ~ReflGraphWriter() {
+        if (m_objects != NULL) 
+            delete [] m_objects;
+        if (m_slots != NULL) 
+            delete [] m_slots;
+    }
+
+    uint32 AddObject(const ReflClass * inst) {
+        if (inst == NULL) 
+            return s_nullObjectId;
+
+        if (m_numObjects == m_capacity) 
+            Grow();
+
+        unsigned mask = 2 * m_capacity - 1;
+        unsigned slot = HashPointer(inst) & mask;
+        for (; m_slots[slot] != 0; slot = (slot + 1) & mask) {
+            uint32 id = m_slots[slot] - 1;
+            if (m_objects[id] == inst) 
+                return id;
+        }
+
+        uint32 id       = m_numObjects++;
+        m_objects[id]   = inst;
+        m_slots[slot]   = id + 1;
+        return id;
+    }
+
+    unsigned NumObjects() const {
+        return m_numObjects;
+    }
+    const ReflClass * GetObject(unsigned id) const {
+        return m_objects[id];
+    }
+
+private:
+    static unsigned HashPointer(const void * ptr) {
+        size_t value = reinterpret_cast<size_t>(ptr) >> 4;
+        return static_cast<unsigned>(value * 2654435761u);
+    }
+
+    void Grow() {
+        GrowArray(&m_objects, &m_capacity, m_numObjects);
+
+        // Slots are kept at most half full, and store id + 1 so zero is empty
+        if (m_slots != NULL) 
+            delete [] m_slots;
+        m_slots = new(REFL_TEMP_MEM_FLAGS) uint32[2 * m_capacity];
+        memset(m_slots, 0, 2 * m_capacity * sizeof(uint32));
+
+        unsigned mask = 2 * m_capacity - 1;
+        for (unsigned id = 0; id < m_numObjects; id++) {
+            unsigned slot = HashPointer(m_objects[id]) & mask;
+            while (m_slots[slot] != 0) 
+                slot = (slot + 1) & mask;
+            m_slots[slot] = id + 1;
+        }
+    }
+
+    const ReflClass  ** m_objects;
+    uint32            * m_slots;
+    unsigned            m_numObjects;
+    unsigned            m_capacity;
+};
+
+//////////////////////////////////////////////////////
+//
+// Accumulates member values into a content hash. Values are staged so
+//  the hash function runs over a few large blocks instead of every member.
+//  Pointer targets are numbered in the order they're first reached, so a
+//  graph hashes the same wherever it's loaded and cycles end. Hashers can
+//  also keep the bytes they hash, so instances with equal hashes can be
+//  compared member for member.
+//
+
+class ReflContentHasher {
+public:
+    ReflContentHasher() :
+        m_used(0),
+        m_kept(NULL),
+        m_keptSize(0),
+        m_keptCapacity(0),
+        m_keep(false)
+    {
+    }
+    ~ReflContentHasher() {
+        if (m_kept != NULL) 
+            delete [] m_kept;
+    }
+
+    void Add(const void * data, unsigned len) {
+        if (m_keep) 
+            Keep(data, len);
+
+        if (m_used + len > sizeof(m_buffer)) 
+            Flush();
+
+        if (len > sizeof(m_buffer)) 
+            m_hash = HashData64(data, len, m_hash);
+        else {
+            memcpy(m_buffer + m_used, data, len);
+            m_used += len;
+        }
+    }
+
+    uint32 AddObject(const ReflClass * inst) {
+        return m_graph.AddObject(inst);
+    }
+
+    unsigned NumObjects() const {
+        return m_graph.NumObjects();
+    }
+    const ReflClass * GetObject(unsigned id) const {
+        return m_graph.GetObject(id);
+    }
+
+    Hash64 GetHash() {
+        Flush();
+        return m_hash;
+    }
+
+    // Must be set before anything is added
+    void KeepContents() {
+        ASSERTGR(m_keptSize == 0 && m_used == 0);
+        m_keep = true;
+    }
+    bool SameContents(const ReflContentHasher & other) const {
+        ASSERTGR(m_keep && other.m_keep);
+        return m_keptSize == other.m_keptSize && memcmp(m_kept, other.m_kept, m_keptSize) == 0;
+    }
+
+private:
+    void Keep(const void * data, unsigned len) {
+        if (m_keptSize + len > m_keptCapacity) {
+            unsigned capacity = m_keptCapacity == 0 ? sizeof(m_buffer) : m_keptCapacity;
+            while (capacity < m_keptSize + len) 
+                capacity *= 2;
+
+            byte * kept = new(REFL_TEMP_MEM_FLAGS) byte[capacity];
+            if (m_kept != NULL) {
+                memcpy(kept, m_kept, m_keptSize);
+                delete [] m_kept;
+            }
+            m_kept          = kept;
+            m_keptCapacity  = capacity;
+        }
+
+        memcpy(m_kept + m_keptSize, data, len);
+        m_keptSize += len;
+    }
+
+
+    void Flush() {
+        if (m_used > 0) {
+            m_hash = HashData64(m_buffer, m_used, m_hash);
+            m_used = 0;
+        }
+    }
+
+    byte            m_buffer[256];
+    unsigned        m_used;
+    Hash64          m_hash;
+    ReflGraphWriter m_graph;
+    byte          * m_kept;
+    unsigned        m_keptSize;
+    unsigned        m_keptCapacity;
+    bool            m_keep;
+};
+
+//////////////////////////////////////////////////////
+//
+// Object graph reading. Pointers to objects that haven't been loaded yet
+//  are patched in Finish, after which deferred finalization runs so 
+//  finalization functions see restored references.
+//
+
+class ReflGraphReader {
+public:
+    ReflGraphReader() :
+        m_objects(NULL),
+        m_numObjects(0),
+        m_objectCapacity(0),
+        m_fixups(NULL),
+        m_numFixups(0),
+        m_fixupCapacity(0),
+        m_finalize(NULL),
+        m_numFinalize(0),
+        m_finalizeCapacity(0)
+#ifndef GOLD
+      , m_conversions(NULL),
+        m_numConversions(0),
+        m_conversionCapacity(0)
+#endif
+    {
+    }
+    ~ReflGraphReader() {
+        if (m_objects != NULL) 
+            delete [] m_objects;
+        if (m_fixups != NULL) 
+            delete [] m_fixups;
+        if (m_finalize != NULL) 
+            delete [] m_finalize;
+#ifndef GOLD
+        if (m_conversions != NULL) 
+            delete [] m_conversions;
+#endif
+    }
+
+    // Unknown types still take an id, pointers to them are restored as NULL
+    void AddObject(const ReflTypeDesc * desc, void * inst) {
+        GrowArray(&m_objects, &m_objectCapacity, m_numObjects);
+        m_objects[m_numObjects].desc = desc;
+        m_objects[m_numObjects].inst = inst;
+        m_numObjects++;
+    }
+
+    void ResolvePointer(void ** field, uint32 id, ReflHash pointeeHash) {
+        *field = NULL;
+        if (id == s_nullObjectId) 
+            return;
+
+        if (id < m_numObjects) {
+            *field = CastObject(id, pointeeHash);
+            return;
+        }
+
+        GrowArray(&m_fixups, &m_fixupCapacity, m_numFixups);
+        m_fixups[m_numFixups].field         = field;
+        m_fixups[m_numFixups].id            = id;
+        m_fixups[m_numFixups].pointeeHash   = pointeeHash;
+        m_numFixups++;
+    }
+
+    void DeferFinalize(const ReflTypeDesc * desc, void * inst) {
+        GrowArray(&m_finalize, &m_finalizeCapacity, m_numFinalize);
+        m_finalize[m_numFinalize].desc = desc;
+        m_finalize[m_numFinalize].inst = inst;
+        m_numFinalize++;
+    }
+
+#ifndef GOLD
+    // Batch conversions wait for the whole file so each member converts 
+    //  every old value in one call
+    void DeferConversion(const ReflMember * member, ReflHash oldType, const byte * value, byte * field) {
+        GrowArray(&m_conversions, &m_conversionCapacity, m_numConversions);
+        Conversion & conversion = m_conversions[m_numConversions++];
+        memcpy(conversion.value, value, s_maxConversionBytes);
+        conversion.member   = member;
+        conversion.oldType  = oldType;
+        conversion.field    = field;
+    }
+#endif
+
+    void Finish() {
+#ifndef GOLD
+        ConvertDeferred();
+#endif
+
+        for (unsigned i = 0; i < m_numFixups; i++) {
+            const Fixup & fixup = m_fixups[i];
+            if (fixup.id < m_numObjects) 
+                *fixup.field = CastObject(fixup.id, fixup.pointeeHash);
+            else
+                LOG(LOG_PRIORITY_WARN, "Pointer to missing object %u", fixup.id);
+        }
+
+        for (unsigned i = 0; i < m_numFinalize; i++) 
+            m_finalize[i].desc->FinalizeInst(m_finalize[i].inst);
+
+        m_numFixups     = 0;
+        m_numFinalize   = 0;
+    }
+
+    unsigned NumObjects() const {
+        return m_numObjects;
+    }
+    ReflClass * GetObject(unsigned id) const {
+        const Object & object = m_objects[id];
+        if (object.desc == NULL) 
+            return NULL;
+        return reinterpret_cast<ReflClass *>(object.desc->CastTo(object.inst, object.desc->GetHash(), ReflClass::GetReflType()));
+    }
+
+private:
+#ifndef GOLD
+    // Old values come first, so a run of conversions is a strided array
+    struct Conversion {
+        byte                    value[s_maxConversionBytes];
+        const ReflMember      * member;
+        ReflHash                oldType;
+        byte                  * field;
+    };
+
+    static int CompareConversions(const void * lhs, const void * rhs) {
+        const Conversion * lhsConversion = reinterpret_cast<const Conversion *>(lhs);
+        const Conversion * rhsConversion = reinterpret_cast<const Conversion *>(rhs);
+        if (lhsConversion->member != rhsConversion->member) 
+            return lhsConversion->member < rhsConversion->member ? -1 : 1;
+        if (lhsConversion->oldType != rhsConversion->oldType) 
+            return lhsConversion->oldType.GetValue() < rhsConversion->oldType.GetValue() ? -1 : 1;
+
+        // Keep file order within a run
+        return lhsConversion->field < rhsConversion->field ? -1 : (lhsConversion->field > rhsConversion->field ? 1 : 0);
+    }
+
+    void ConvertDeferred() {
+        qsort(m_conversions, m_numConversions, sizeof(Conversion), CompareConversions);
+
+        unsigned first = 0;
+        while (first < m_numConversions) {
+            const Conversion & conversion = m_conversions[first];
+            unsigned end = first + 1;
+            while (end < m_numConversions && m_conversions[end].member == conversion.member && m_conversions[end].oldType == conversion.oldType) 
+                end++;
+
+            // Convert into a packed array and scatter it to the members
+            unsigned count  = end - first;
+            unsigned size   = conversion.member->GetSize();
+            byte * values   = new(REFL_TEMP_MEM_FLAGS) byte[count * size];
+            conversion.member->ConvertValues(conversion.oldType, conversion.value, sizeof(Conversion), values, size, count);
+            for (unsigned i = 0; i < count; i++) 
+                memcpy(m_conversions[first + i].field, values + i * size, size);
+            delete [] values;
+
+            first = end;
+        }
+
+        m_numConversions = 0;
+    }
+#endif
+
+    void * CastObject(uint32 id, ReflHash pointeeHash) const {
+        const Object & object = m_objects[id];
+        if (object.desc == NULL) 
+            return NULL;
+
+        void * ptr = object.desc->CastTo(object.inst, object.desc->GetHash(), pointeeHash);
+        if (ptr == NULL) 
+            LOG(LOG_PRIORITY_WARN, "Object %u of type %S doesn't match the pointer type", id, object.desc->GetTypeName());
+        return ptr;
+    }
+
+    struct Object {
+        const ReflTypeDesc    * desc;
+        void                  * inst;
+    };
+
+    struct Fixup {
+        void                 ** field;
+        uint32                  id;
+        ReflHash                pointeeHash;
+    };
+
+    Object    * m_objects;
+    unsigned    m_numObjects;
+    unsigned    m_objectCapacity;
+
+    Fixup     * m_fixups;
+    unsigned    m_numFixups;
+    unsigned    m_fixupCapacity;
+
+    Object    * m_finalize;
+    unsigned    m_numFinalize;
+    unsigned    m_finalizeCapacity;
+
+#ifndef GOLD
+    Conversion    * m_conversions;
+    unsigned        m_numConversions;
+    unsigned        m_conversionCapacity;
+#endif
+};
+
+// Text serialization reaches the current graph through these, per thread
+//  so separate files can be loaded in parallel
+#ifndef GOLD
+static THREADLOCAL ReflGraphWriter * s_graphWriter = NULL;
+static THREADLOCAL ReflGraphReader * s_graphReader = NULL;
+static THREADLOCAL ReflLoadReport  * s_loadReport  = NULL;
+
+struct TempBinding {
+    const ReflMember  * member;
+    void              * data;
+};
+
+static const unsigned s_maxTempBindings = 32;
+static THREADLOCAL TempBinding s_tempBindings[s_maxTempBindings];
+static THREADLOCAL unsigned    s_numTempBindings = 0;
+#endif
+
+//////////////////////////////////////////////////////
+//
+// Binary loads place every object of a file in one block. The object table
+//  comes first and the header sits right before the root, so the block can
+//  be found from the root alone.
+//
+
+struct BatchObject {
+    const ReflTypeDesc    * desc;
+    unsigned                offset;
+};
+
+struct BatchHeader {
+    uint32                  magic;
+    unsigned                numObjects;
+    BatchObject           * objects;
+};
+
+//////////////////////////////////////////////////////
+//
+// Dense metadata tables built by ReflInitialize, one array per field. Binary
+//  serialization only walks these, so it never follows descriptor lists or
+//  touches names. Types are sorted by hash, and each type's parents, members
+//  and member aliases are contiguous ranges. Deprecated members are never
+//  written, so they aren't in the tables. A type's bitfields are written
+//  as one record, the layout hash detects data cooked with other widths.
+//
+
+enum EMetadataTypeFlags {
+    METADATA_TYPE_FINALIZE          = 1 << 0,
+    METADATA_TYPE_MANUAL_VERSIONING = 1 << 1,
+};
+
+struct MetadataTables {
+    byte                  * block;
+    unsigned                bytes;
+
+    unsigned                numTypes;
+    unsigned                numParents;
+    unsigned                numMembers;
+    unsigned                numAliases;
+
+    const ReflTypeDesc   ** typeDesc;
+    uint32                * typeHash;
+    uint32                * typeVersion;
+    uint32                * typeBinarySize;
+    uint32                * typeFirstParent;
+    uint32                * typeFirstMember;
+    uint32                * typeFirstAlias;
+    uint32                * typeBitfieldLayout;
+    uint16                * typeNumParents;
+    uint16                * typeNumMembers;
+    uint16                * typeNumAliases;
+    uint16                * typeNumBitfields;
+    uint16                * typeBitfieldBits;
+    uint8                 * typeFlags;
+
+    uint32                * parentType;
+    uint32                * parentOffset;
+
+    uint32                * memberName;
+    uint32                * memberType;
+    uint32                * memberOffset;
+    uint32                * memberSize;
+    uint32                * memberTarget;       // Type of class members and pointees
+    uint8                 * memberIndex;
+    uint8                 * memberBitOffset;
+    uint8                 * memberBitWidth;
+
+    uint32                * aliasOld;
+    uint32                * aliasNew;
+
+    unsigned                numClassAliases;
+    uint32                * classAliasOld;
+    uint32                * classAliasType;
+};
+
+static const uint32 s_invalidMetadataIndex = 0xffffffff;
+
+// Tables are replaced whole when batches of types come and go. Library 
+//  calls pin the published tables for their thread by recording the epoch 
+//  they started in, and replaced tables are only freed once every thread
+//  pinned before the swap has let go. Lookups never take a lock.
+struct MetadataReader {
+    MetadataReader    * next;
+    volatile int32      epoch;      // Zero while not pinned
+    unsigned            depth;
+};
+
+static MetadataTables * volatile    s_publishedMetadata = NULL;
+static THREADLOCAL MetadataTables * s_metadata          = NULL;
+static volatile int32               s_metadataEpoch     = 1;
+static MetadataReader * volatile    s_metadataReaders   = NULL;
+static THREADLOCAL MetadataReader * s_metadataReader    = NULL;
+
+// Registration is rare and serialized by a spin lock. Types registered 
+//  after ReflInitialize wait in the pending lists for RegisterTypeBatch,
+//  and a batch being finalized is only visible to the registering thread.
+static volatile int32               s_registrationLock  = 0;
+static ReflTypeDesc               * s_pendingDescHead   = NULL;
+static ReflAlias                  * s_pendingAliasHead  = NULL;
+static THREADLOCAL ReflTypeDesc   * s_stagingDescHead   = NULL;
+static THREADLOCAL ReflAlias      * s_stagingAliasHead  = NULL;
+
+struct ReflTypeBatch {
+    ReflTypeDesc     ** descs;
+    unsigned            numDescs;
+    ReflAlias        ** aliases;
+    unsigned            numAliases;
+};
+
+class MetadataScope {
+public:
+    MetadataScope();
+    ~MetadataScope();
+};
+
+//////////////////////////////////////////////////////
+//
+// Telemetry counts into a hash table owned by each thread, so counting 
+//  needs no locks or atomics. Dumps sum the tables of every thread and 
+//  resets are picked up by each thread the next time it counts. Times 
+//  exclude nested class blocks.
+//
+
+#ifdef REFL_TELEMETRY
+enum ETelemetryCounter {
+    TELEMETRY_OBJECTS_LOADED,
+    TELEMETRY_OBJECTS_SAVED,
+    TELEMETRY_MEMBERS_LOADED,
+    TELEMETRY_MEMBERS_SAVED,
+    TELEMETRY_BYTES_LOADED,
+    TELEMETRY_BYTES_SAVED,
+    TELEMETRY_CONVERSIONS,
+    TELEMETRY_ALIAS_HITS,
+    TELEMETRY_LOAD_TICKS,
+    TELEMETRY_SAVE_TICKS,
+    TELEMETRY_COUNTERS
+};
+
+static const unsigned s_telemetrySlots = 1024;  // Power of two
+
+struct TelemetrySlot {
+    uint32      typeHash;   // Zero while unused
+    uint64      counters[TELEMETRY_COUNTERS];
+};
+
+struct TelemetryTable {
+    TelemetryTable    * next;
+    int32               generation;
+    TelemetrySlot       slots[s_telemetrySlots];
+};
+
+class TelemetryScope {
+public:
+    TelemetryScope(uint32 typeHash, ETelemetryCounter ticksCounter);
+    ~TelemetryScope();
+
+    TelemetrySlot * GetSlot() {
+        return m_slot;
+    }
+
+private:
+    TelemetrySlot     * m_slot;
+    ETelemetryCounter   m_ticksCounter;
+    uint64              m_start;
+    uint64              m_childTicks;
+    TelemetryScope    * m_parent;
+};
+
+static TelemetryTable * volatile    s_telemetryTables       = NULL;
+static volatile int32               s_telemetryGeneration   = 0;
+static THREADLOCAL TelemetryTable * s_telemetryTable        = NULL;
+static THREADLOCAL TelemetryScope * s_telemetryScope        = NULL;
+
+static void TelemetryCount(uint32 typeHash, ETelemetryCounter counter, uint64 count);
+static void TelemetryCountCurrent(ETelemetryCounter counter, uint64 count);
+
+    #define REFL_TELEMETRY_COUNT(typeHash, counter, count)      TelemetryCount(typeHash, counter, count)
+    #define REFL_TELEMETRY_COUNT_CURRENT(counter, count)        TelemetryCountCurrent(counter, count)
+    #define REFL_TELEMETRY_SCOPE(typeHash, ticksCounter)        TelemetryScope telemetryScope(typeHash, ticksCounter)
+#else
+    #define REFL_TELEMETRY_COUNT(typeHash, counter, count)
+    #define REFL_TELEMETRY_COUNT_CURRENT(counter, count)
+    #define REFL_TELEMETRY_SCOPE(typeHash, ticksCounter)
+#endif
+
+static bool ReadMetadataBlock(DataStream * stream, ReflGraphReader * reader, unsigned type, byte * inst);
+
 //////////////////////////////////////////////////////
 //
 // Internal Functions
 //
 
+//====================================================
+// Bits are numbered from the low bit of the first byte, which matches how
+//  the compiler lays out bitfields on little endian targets
+static uint64 ReadBits(const byte * data, unsigned bitOffset, unsigned width) {
+    uint64 value = 0;
+    unsigned bytes = (bitOffset + width + 7) / 8;
+    for (unsigned i = 0; i < bytes; i++) {
+        int shift = static_cast<int>(i * 8) - static_cast<int>(bitOffset);
+        uint64 bits = data[i];
+        value |= shift >= 0 ? bits << shift : bits >> -shift;
+    }
+
+    if (width < 64) 
+        value &= (1ULL << width) - 1;
+    return value;
+}
+
+//====================================================
+static void WriteBits(byte * data, unsigned bitOffset, unsigned width, uint64 value) {
+    uint64 mask = width < 64 ? (1ULL << width) - 1 : ~0ULL;
+    unsigned bytes = (bitOffset + width + 7) / 8;
+    for (unsigned i = 0; i < bytes; i++) {
+        int shift = static_cast<int>(i * 8) - static_cast<int>(bitOffset);
+        byte byteMask   = static_cast<byte>(shift >= 0 ? mask >> shift : mask << -shift);
+        byte byteValue  = static_cast<byte>(shift >= 0 ? value >> shift : value << -shift);
+        data[i] = (data[i] & ~byteMask) | (byteValue & byteMask);
+    }
+}
+
+#ifndef GOLD
 //====================================================
 template<EReflIndex t_reflType, typename t_dataType>
 void ConvertToString(const ReflMember * , const byte * data, const chargr * format, chargr * string, unsigned len) {
@@ -149,178 +875,1495 @@ void ConvertToString(const ReflMember * , const byte * data, const chargr * form
 }
 
 //====================================================
-template<>
-void ConvertToString<REFL_INDEX_BOOL, bool>(const ReflMember * , const byte * data, const chargr * format, chargr * string, unsigned len) {
-    StrPrintf(string, len, L"%s", *((bool *) data) ? L"true" : L"false");
+template<>
+void ConvertToString<REFL_INDEX_BOOL, bool>(const ReflMember * , const byte * data, const chargr * format, chargr * string, unsigned len) {
+    StrPrintf(string, len, L"%s", *((bool *) data) ? L"true" : L"false");
+}
+
+//====================================================
+template<>
+void ConvertToString<REFL_INDEX_INT8, int8>(const ReflMember * , const byte * data, const chargr * format, chargr * string, unsigned len) {
+    int value = *(reinterpret_cast<const int8 *>(data));
+    StrPrintf(string, len, L"%d", value);
+}
+
+//====================================================
+template<>
+void ConvertToString<REFL_INDEX_UINT8, uint8>(const ReflMember * , const byte * data, const chargr * format, chargr * string, unsigned len) {
+    unsigned value = *(reinterpret_cast<const uint8 *>(data));
+    StrPrintf(string, len, L"%u", value);
+}
+
+//====================================================
+template<>
+void ConvertToString<REFL_INDEX_ENUM, char>(const ReflMember * memberDesc, const byte * data, const chargr * format, chargr * string, unsigned len) {
+    int64 idata = 0;
+    switch (memberDesc->GetSize()) {
+        case sizeof(char):
+            idata = *reinterpret_cast<const int8 *>(data);
+            break;
+        case sizeof(short):
+            idata = *reinterpret_cast<const int16 *>(data);
+            break;
+        case sizeof(int):
+            idata = *reinterpret_cast<const int32 *>(data);
+            break;
+        case sizeof(int64):
+            idata = *reinterpret_cast<const int64 *>(data);
+            break;
+    }
+    const ReflTypeDesc * enumDesc = ReflLibrary::GetClassDesc(memberDesc->TypeHash());
+    ASSERTMSGGR(enumDesc != NULL, "Unregistered enum type");
+    const ReflTypeDesc::EnumValue * enumValue = enumDesc->GetEnumValue(idata);
+    if (enumValue != NULL) 
+        StrPrintf(string, len, L"%s", enumValue->name);
+    else {
+        ASSERTMSGGR(false, "Unhandled enum value");
+        //Need to log a message here?
+    }
+}
+
+//====================================================
+template<>
+void ConvertToString<REFL_INDEX_BITFIELD, char>(const ReflMember * memberDesc, const byte * data, const chargr * format, chargr * string, unsigned len) {
+    // Data points at the first byte of the field, so read with a zero offset
+    int64 value = memberDesc->ReadBitfield(data - memberDesc->GetOffset(), 0);
+
+    const ReflTypeDesc * enumDesc = ReflLibrary::GetClassDesc(memberDesc->TypeHash());
+    if (enumDesc != NULL && enumDesc->IsEnumType()) {
+        const ReflTypeDesc::EnumValue * enumValue = enumDesc->GetEnumValue(value);
+        if (enumValue != NULL) 
+            StrPrintf(string, len, L"%s", enumValue->name);
+        else
+            ASSERTMSGGR(false, "Unhandled enum value");
+    }
+    else if (memberDesc->GetBitWidth() == 1) 
+        StrPrintf(string, len, L"%s", value != 0 ? L"true" : L"false");
+    else
+        StrPrintf(string, len, L"%lld", value);
+}
+
+//====================================================
+template<>
+void ConvertToString<REFL_INDEX_PERCENTAGE, float>(const ReflMember * , const byte * data, const chargr * format, chargr * string, unsigned len) {
+    StrPrintf(string, len, L"%3.3f", 100.0f * (*((float *) data)));
+}
+
+//====================================================
+template<>
+void ConvertToString<REFL_INDEX_ANGLE, float>(const ReflMember * , const byte * data, const chargr * format, chargr * string, unsigned len) {
+    float * fdata = (float *) data;
+    StrPrintf(string, len, L"%3.3f", MathRadiansToDegrees(*fdata));
+}
+
+//====================================================
+template<EReflIndex t_reflType, typename t_dataType>
+void ConvertFromString(const ReflMember * , byte * data, const chargr * format, const chargr * string, unsigned len) {
+    ASSERTMSGGR(format != NULL, "Need to handle this type via specialization");
+    StrReadValue(string, len, format, (t_dataType *) data);
+}
+
+//====================================================
+template<>
+void ConvertFromString<REFL_INDEX_BOOL, bool>(const ReflMember * , byte * data, const chargr * , const chargr * string, unsigned len) {
+    if (StrICmp(string, "true", 4) == 0) 
+        *((bool *) data) = true;
+    else
+        *((bool *) data) = false;
+}
+
+//====================================================
+template<>
+void ConvertFromString<REFL_INDEX_INT8, int8>(const ReflMember * , byte * data, const chargr * , const chargr * string, unsigned len) {
+    int value;
+    StrReadValue(string, len, L"%d", &value);
+    *(reinterpret_cast<int8 *>(data)) = value;
+}
+
+//====================================================
+template<>
+void ConvertFromString<REFL_INDEX_UINT8, uint8>(const ReflMember * , byte * data, const chargr * , const chargr * string, unsigned len) {
+    unsigned value;
+    StrReadValue(string, len, L"%u", &value);
+    *(reinterpret_cast<uint8 *>(data)) = value;
+}
+
+//====================================================
+template<>
+void ConvertFromString<REFL_INDEX_ENUM, char>(const ReflMember * memberDesc, byte * data, const chargr * , const chargr * string, unsigned len) {
+    const ReflTypeDesc * enumDesc = ReflLibrary::GetClassDesc(memberDesc->TypeHash());
+    ASSERTMSGGR(enumDesc != NULL, "Unregistered enum type");
+    const ReflTypeDesc::EnumValue * enumValue = enumDesc->GetEnumValue(string, len);
+    if (enumValue != NULL) {
+        switch (memberDesc->GetSize()) {
+            case sizeof(char):
+                *reinterpret_cast<int8 *>(data) = static_cast<int8>(enumValue->value);
+                break;
+            case sizeof(short):
+                *reinterpret_cast<int16 *>(data) = static_cast<int16>(enumValue->value);
+                break;
+            case sizeof(int):
+                *reinterpret_cast<int32 *>(data) = static_cast<int32>(enumValue->value);
+                break;
+            case sizeof(int64):
+                *reinterpret_cast<int64 *>(data) = static_cast<int64>(enumValue->value);
+                break;
+        }
+    }
+    else {
+        ASSERTMSGGR(false, "Unregistered enum value");
+    }
+}
+
+//====================================================
+template<>
+void ConvertFromString<REFL_INDEX_BITFIELD, char>(const ReflMember * memberDesc, byte * data, const chargr * , const chargr * string, unsigned len) {
+    int64 value = 0;
+    const ReflTypeDesc * enumDesc = ReflLibrary::GetClassDesc(memberDesc->TypeHash());
+    if (enumDesc != NULL && enumDesc->IsEnumType()) {
+        const ReflTypeDesc::EnumValue * enumValue = enumDesc->GetEnumValue(string, len);
+        if (enumValue != NULL) 
+            value = enumValue->value;
+        else
+            ASSERTMSGGR(false, "Unregistered enum value");
+    }
+    else if (StrICmp(string, L"true", 4) == 0) 
+        value = 1;
+    else if (StrICmp(string, L"false", 5) != 0) 
+        StrReadValue(string, len, L"%lld", &value);
+
+    memberDesc->WriteBitfield(data - memberDesc->GetOffset(), 0, value);
+}
+
+//====================================================
+template<>
+void ConvertFromString<REFL_INDEX_PERCENTAGE, float>(const ReflMember * , byte * data, const chargr * , const chargr * string, unsigned len) {
+    float * fdata = (float *) data;
+    StrReadValue(string, len, L"%f", fdata);
+    *fdata /= 100.0f;
+}
+
+//====================================================
+template<>
+void ConvertFromString<REFL_INDEX_ANGLE, float>(const ReflMember * , byte * data, const chargr * , const chargr * string, unsigned len) {
+    float * fdata = (float *) data;
+    StrReadValue(string, len, L"%f", fdata);
+    *fdata = MathDegreesToRadians(*fdata);
+}
+
+//====================================================
+/*template<>
+void ConvertFromString<REFL_INDEX_CHAR>(byte * data, const chargr * string, unsigned len) {
+    swscanf(string, L"%c", (char *) data);
+}*/
+#endif
+
+//====================================================
+static void HashGraph(ReflContentHasher * hasher, const ReflTypeDesc * rootDesc, const void * root) {
+    hasher->AddObject(reinterpret_cast<const ReflClass *>(rootDesc->CastTo(root, rootDesc->GetHash(), ReflClass::GetReflType())));
+    rootDesc->HashMembers(hasher, root, 0);
+
+    // Objects reached through pointers get the next id as they're hashed
+    for (unsigned id = 1; id < hasher->NumObjects(); id++) {
+        ReflClass * object = const_cast<ReflClass *>(hasher->GetObject(id));
+        const ReflTypeDesc * desc = ReflLibrary::GetClassDesc(object);
+        ASSERTMSGGR(desc != NULL, "Unregistered class type");
+        desc->HashMembers(hasher, desc->CastTo(object, ReflClass::GetReflType(), desc->GetHash()), 0);
+    }
+}
+
+//====================================================
+static unsigned FindSharedSlot(Hash64 contentHash, const ReflClass * inst) {
+    // Stops at an empty slot when the instance isn't in the table
+    unsigned mask = s_sharedCapacity - 1;
+    unsigned slot = static_cast<unsigned>(contentHash.GetValue()) & mask;
+    while (s_sharedInstances[slot].inst != NULL && s_sharedInstances[slot].inst != inst) 
+        slot = (slot + 1) & mask;
+
+    return slot;
+}
+
+#ifndef GOLD
+//====================================================
+static bool SharedContentsMatch(const ReflClass * inst, const ReflContentHasher & contents) {
+    const ReflTypeDesc * desc = ReflLibrary::GetClassDesc(inst);
+    ReflContentHasher instContents;
+    instContents.KeepContents();
+    HashGraph(&instContents, desc, desc->CastTo(inst, ReflClass::GetReflType(), desc->GetHash()));
+
+    return instContents.SameContents(contents);
+}
+
+//====================================================
+static unsigned FindSharedSlot(Hash64 contentHash, const ReflContentHasher & contents) {
+    // Equal hashes don't guarantee equal contents, so matches are compared
+    //  and probing goes on past ones that differ
+    unsigned mask = s_sharedCapacity - 1;
+    unsigned slot = static_cast<unsigned>(contentHash.GetValue()) & mask;
+    for (; s_sharedInstances[slot].inst != NULL; slot = (slot + 1) & mask) {
+        const SharedInstance & entry = s_sharedInstances[slot];
+        if (entry.contentHash == contentHash && SharedContentsMatch(entry.inst, contents)) 
+            break;
+    }
+
+    return slot;
+}
+
+//====================================================
+static void GrowSharedTable() {
+    SharedInstance * oldTable   = s_sharedInstances;
+    unsigned oldCapacity        = s_sharedCapacity;
+
+    s_sharedCapacity    = oldCapacity == 0 ? 64 : 2 * oldCapacity;
+    s_sharedInstances   = new(REFL_MEM_FLAGS) SharedInstance[s_sharedCapacity];
+
+    for (unsigned i = 0; i < oldCapacity; i++) {
+        if (oldTable[i].inst != NULL) 
+            s_sharedInstances[FindSharedSlot(oldTable[i].contentHash, oldTable[i].inst)] = oldTable[i];
+    }
+
+    if (oldTable != NULL) 
+        delete [] oldTable;
+}
+#endif
+
+//====================================================
+static void RemoveSharedSlot(unsigned slot) {
+    // Shift the following entries back so probe sequences stay unbroken
+    unsigned mask = s_sharedCapacity - 1;
+    unsigned hole = slot;
+    for (unsigned next = (hole + 1) & mask; s_sharedInstances[next].inst != NULL; next = (next + 1) & mask) {
+        unsigned home = static_cast<unsigned>(s_sharedInstances[next].contentHash.GetValue()) & mask;
+        if (((next - home) & mask) >= ((next - hole) & mask)) {
+            s_sharedInstances[hole] = s_sharedInstances[next];
+            hole = next;
+        }
+    }
+
+    s_sharedInstances[hole] = SharedInstance();
+    s_sharedCount--;
+}
+
+//====================================================
+static unsigned AlignBatch(unsigned size) {
+    return (size + s_batchAlignment - 1) & ~(s_batchAlignment - 1);
+}
+
+//====================================================
+static void DestroyBatchBlock(BatchHeader * header) {
+    byte * block = reinterpret_cast<byte *>(header->objects);
+    for (unsigned i = header->numObjects; i > 0; i--) {
+        const BatchObject & object = header->objects[i - 1];
+        if (object.desc != NULL) 
+            object.desc->Destruct(block + object.offset);
+    }
+
+    delete [] block;
+}
+
+//====================================================
+static void * CastToObjectBase(const ReflClass * inst, const ReflTypeDesc * desc) {
+    ReflClass * refl = const_cast<ReflClass *>(inst);
+    return desc->CastTo(refl, ReflClass::GetReflType(), desc->GetHash());
+}
+
+//====================================================
+static void DestroyInst(ReflClass * inst) {
+    const ReflTypeDesc * desc = ReflLibrary::GetClassDesc(inst);
+    desc->Destroy(CastToObjectBase(inst, desc));
+}
+
+#ifndef GOLD
+//====================================================
+static void * FindTempBinding(const ReflMember * member) {
+    for (unsigned i = 0; i < s_numTempBindings; i++) {
+        if (s_tempBindings[i].member == member) 
+            return s_tempBindings[i].data;
+    }
+    return NULL;
+}
+#endif
+
+//====================================================
+static ReflHash HashFromValue(uint32 value) {
+    // Precomputed hash, there's no string to check it against
+    if (value == 0) 
+        return ReflHash();
+    return ReflHash(static_cast<const chargr *>(NULL), value);
+}
+
+//====================================================
+template<typename t_type>
+static t_type * CarveArray(byte ** cursor, unsigned count) {
+    t_type * array = reinterpret_cast<t_type *>(*cursor);
+    *cursor += count * sizeof(t_type);
+    return array;
+}
+
+//====================================================
+static int CompareTypeHash(const void * lhs, const void * rhs) {
+    uint32 lhsHash = (*reinterpret_cast<const ReflTypeDesc * const *>(lhs))->GetHash().GetValue();
+    uint32 rhsHash = (*reinterpret_cast<const ReflTypeDesc * const *>(rhs))->GetHash().GetValue();
+    if (lhsHash < rhsHash) 
+        return -1;
+    return lhsHash > rhsHash ? 1 : 0;
+}
+
+//====================================================
+static unsigned FindMetadataType(uint32 typeHash) {
+    unsigned low     = 0;
+    unsigned high    = s_metadata->numTypes;
+    while (low < high) {
+        unsigned mid = (low + high) / 2;
+        if (s_metadata->typeHash[mid] < typeHash) 
+            low = mid + 1;
+        else
+            high = mid;
+    }
+    if (low < s_metadata->numTypes && s_metadata->typeHash[low] == typeHash) 
+        return low;
+
+    for (unsigned alias = 0; alias < s_metadata->numClassAliases; alias++) {
+        if (s_metadata->classAliasOld[alias] == typeHash) 
+            return s_metadata->classAliasType[alias];
+    }
+
+    return s_invalidMetadataIndex;
+}
+
+//====================================================
+static unsigned FindMetadataMember(unsigned type, uint32 nameHash) {
+    unsigned first  = s_metadata->typeFirstMember[type];
+    unsigned end    = first + s_metadata->typeNumMembers[type];
+    for (unsigned member = first; member < end; member++) {
+        if (s_metadata->memberName[member] == nameHash) 
+            return member;
+    }
+
+    unsigned firstAlias = s_metadata->typeFirstAlias[type];
+    unsigned endAlias   = firstAlias + s_metadata->typeNumAliases[type];
+    for (unsigned alias = firstAlias; alias < endAlias; alias++) {
+        if (s_metadata->aliasOld[alias] != nameHash) 
+            continue;
+
+        for (unsigned member = first; member < end; member++) {
+            if (s_metadata->memberName[member] == s_metadata->aliasNew[alias]) 
+                return member;
+        }
+    }
+
+    return s_invalidMetadataIndex;
+}
+
+//====================================================
+static unsigned MetadataBinarySize(unsigned type) {
+    if (s_metadata->typeBinarySize[type] != 0) 
+        return s_metadata->typeBinarySize[type];
+
+    // Type hash, version, size, parent count and member count
+    unsigned size = 5 * sizeof(uint32);
+    unsigned firstParent = s_metadata->typeFirstParent[type];
+    for (unsigned parent = firstParent; parent < firstParent + s_metadata->typeNumParents[type]; parent++) 
+        size += MetadataBinarySize(s_metadata->parentType[parent]);
+
+    // Name hash, type hash and payload size precede each payload
+    unsigned firstMember = s_metadata->typeFirstMember[type];
+    for (unsigned member = firstMember; member < firstMember + s_metadata->typeNumMembers[type]; member++) {
+        if (s_metadata->memberIndex[member] == REFL_INDEX_BITFIELD) 
+            continue;
+
+        size += 3 * sizeof(uint32);
+        if (s_metadata->memberIndex[member] == REFL_INDEX_CLASS) 
+            size += MetadataBinarySize(s_metadata->memberTarget[member]);
+        else if (s_metadata->memberIndex[member] == REFL_INDEX_POINTER) 
+            size += sizeof(uint32);
+        else
+            size += s_metadata->memberSize[member];
+    }
+
+    // Bitfields share one record, the layout hash and then the packed bits
+    if (s_metadata->typeNumBitfields[type] > 0) 
+        size += 4 * sizeof(uint32) + (s_metadata->typeBitfieldBits[type] + 7) / 8;
+
+    s_metadata->typeBinarySize[type] = size;
+    return size;
+}
+
+//====================================================
+static MetadataReader * GetMetadataReader() {
+    if (s_metadataReader != NULL) 
+        return s_metadataReader;
+
+    // Readers are never freed, exited threads leave theirs unpinned
+    MetadataReader * reader = new(REFL_MEM_FLAGS) MetadataReader;
+    reader->epoch = 0;
+    reader->depth = 0;
+    for (;;) {
+        MetadataReader * head = s_metadataReaders;
+        reader->next = head;
+        if (AtomicCompareExchangePointer((void * volatile *) &s_metadataReaders, reader, head) == head) 
+            break;
+    }
+
+    s_metadataReader = reader;
+    return reader;
+}
+
+//====================================================
+static void PinMetadata() {
+    MetadataReader * reader = GetMetadataReader();
+    if (reader->depth++ != 0) 
+        return;
+
+    // The epoch is visible before the tables are read, so a publisher that
+    //  swaps after this point waits for us.
+    AtomicExchange(&reader->epoch, s_metadataEpoch);
+    s_metadata = s_publishedMetadata;
+}
+
+//====================================================
+static void UnpinMetadata() {
+    MetadataReader * reader = s_metadataReader;
+    ASSERTGR(reader != NULL && reader->depth != 0);
+    if (--reader->depth != 0) 
+        return;
+
+    s_metadata = NULL;
+    AtomicExchange(&reader->epoch, 0);
+}
+
+//====================================================
+MetadataScope::MetadataScope() {
+    PinMetadata();
+}
+
+//====================================================
+MetadataScope::~MetadataScope() {
+    UnpinMetadata();
+}
+
+#ifdef REFL_TELEMETRY
+//====================================================
+static TelemetrySlot * FindTelemetrySlot(uint32 typeHash) {
+    TelemetryTable * table = s_telemetryTable;
+    if (table == NULL) {
+        // Tables are never freed, exited threads keep their counts
+        table = new(REFL_MEM_FLAGS) TelemetryTable;
+        memset(table, 0, sizeof(*table));
+        table->generation = s_telemetryGeneration;
+        for (;;) {
+            TelemetryTable * head = s_telemetryTables;
+            table->next = head;
+            if (AtomicCompareExchangePointer((void * volatile *) &s_telemetryTables, table, head) == head) 
+                break;
+        }
+        s_telemetryTable = table;
+    }
+    else if (table->generation != s_telemetryGeneration) {
+        memset(table->slots, 0, sizeof(table->slots));
+        table->generation = s_telemetryGeneration;
+    }
+
+    unsigned mask = s_telemetrySlots - 1;
+    for (unsigned probe = 0; probe < s_telemetrySlots; probe++) {
+        TelemetrySlot * slot = &table->slots[(typeHash + probe) & mask];
+        if (slot->typeHash == typeHash) 
+            return slot;
+        if (slot->typeHash == 0) {
+            slot->typeHash = typeHash;
+            return slot;
+        }
+    }
+
+    // Full, drop the counts
+    return NULL;
+}
+
+//====================================================
+// Slowest types first
+static int CompareTelemetryTime(const void * lhs, const void * rhs) {
+    const ReflTypeTelemetry * lhsTelemetry = reinterpret_cast<const ReflTypeTelemetry *>(lhs);
+    const ReflTypeTelemetry * rhsTelemetry = reinterpret_cast<const ReflTypeTelemetry *>(rhs);
+    uint64 lhsTime = lhsTelemetry->loadNanoseconds + lhsTelemetry->saveNanoseconds;
+    uint64 rhsTime = rhsTelemetry->loadNanoseconds + rhsTelemetry->saveNanoseconds;
+    if (lhsTime > rhsTime) 
+        return -1;
+    return lhsTime < rhsTime ? 1 : 0;
+}
+
+//====================================================
+static void TelemetryCount(uint32 typeHash, ETelemetryCounter counter, uint64 count) {
+    TelemetrySlot * slot = FindTelemetrySlot(typeHash);
+    if (slot != NULL) 
+        slot->counters[counter] += count;
+}
+
+//====================================================
+// Counts against the type whose block is being read or written
+static void TelemetryCountCurrent(ETelemetryCounter counter, uint64 count) {
+    if (s_telemetryScope != NULL && s_telemetryScope->GetSlot() != NULL) 
+        s_telemetryScope->GetSlot()->counters[counter] += count;
+}
+
+//====================================================
+TelemetryScope::TelemetryScope(uint32 typeHash, ETelemetryCounter ticksCounter) :
+    m_slot(FindTelemetrySlot(typeHash)),
+    m_ticksCounter(ticksCounter),
+    m_childTicks(0),
+    m_parent(s_telemetryScope)
+{
+    s_telemetryScope = this;
+    m_start = TimerGetTicks();
+}
+
+//====================================================
+TelemetryScope::~TelemetryScope() {
+    uint64 ticks = TimerGetTicks() - m_start;
+    if (m_slot != NULL) 
+        m_slot->counters[m_ticksCounter] += ticks - m_childTicks;
+    if (m_parent != NULL) 
+        m_parent->m_childTicks += ticks;
+    s_telemetryScope = m_parent;
+}
+#endif
+
+//====================================================
+static void LockRegistration() {
+    while (AtomicCompareExchange(&s_registrationLock, 1, 0) != 0) 
+        ThreadYield();
+}
+
+//====================================================
+static void UnlockRegistration() {
+    AtomicExchange(&s_registrationLock, 0);
+}
+
+//====================================================
+static void FreeMetadata(MetadataTables * tables) {
+    delete [] tables->block;
+    delete tables;
+}
+
+//====================================================
+// Lookups made while building resolve against the new tables
+static MetadataTables * BuildMetadata() {
+    MetadataScope scope;
+    MetadataTables * prevMetadata = s_metadata;
+    s_metadata = new(REFL_MEM_FLAGS) MetadataTables;
+    memset(s_metadata, 0, sizeof(*s_metadata));
+
+    unsigned numClassAliases = 0;
+    for (const ReflAlias * alias = s_classAliasHead; alias != NULL; alias = alias->next) 
+        numClassAliases++;
+
+    for (const ReflTypeDesc * desc = s_descHead; desc != NULL; desc = desc->GetNext()) {
+        s_metadata->numTypes++;
+        for (const ReflTypeDesc::Parent * parent = desc->GetParents(); parent != NULL; parent = parent->next) 
+            s_metadata->numParents++;
+        for (const ReflMember * member = desc->GetLocalMembers(); member != NULL; member = member->GetNext()) {
+            if (!member->IsDeprecated()) 
+                s_metadata->numMembers++;
+        }
+        for (const ReflAlias * alias = desc->GetMemberAliases(); alias != NULL; alias = alias->next) 
+            s_metadata->numAliases++;
+    }
+
+    // Widest fields first so every array stays aligned
+    unsigned numTypes   = s_metadata->numTypes;
+    s_metadata->bytes    = numTypes * (sizeof(const ReflTypeDesc *) + 7 * sizeof(uint32) + 5 * sizeof(uint16) + sizeof(uint8));
+    s_metadata->bytes   += s_metadata->numParents * 2 * sizeof(uint32);
+    s_metadata->bytes   += s_metadata->numMembers * (5 * sizeof(uint32) + 3 * sizeof(uint8));
+    s_metadata->bytes   += s_metadata->numAliases * 2 * sizeof(uint32);
+    s_metadata->bytes   += numClassAliases * 2 * sizeof(uint32);
+    s_metadata->block    = new(REFL_MEM_FLAGS) byte[s_metadata->bytes];
+
+    byte * cursor = s_metadata->block;
+    s_metadata->typeDesc         = CarveArray<const ReflTypeDesc *>(&cursor, numTypes);
+    s_metadata->typeHash         = CarveArray<uint32>(&cursor, numTypes);
+    s_metadata->typeVersion      = CarveArray<uint32>(&cursor, numTypes);
+    s_metadata->typeBinarySize   = CarveArray<uint32>(&cursor, numTypes);
+    s_metadata->typeFirstParent  = CarveArray<uint32>(&cursor, numTypes);
+    s_metadata->typeFirstMember  = CarveArray<uint32>(&cursor, numTypes);
+    s_metadata->typeFirstAlias   = CarveArray<uint32>(&cursor, numTypes);
+    s_metadata->typeBitfieldLayout = CarveArray<uint32>(&cursor, numTypes);
+    s_metadata->parentType       = CarveArray<uint32>(&cursor, s_metadata->numParents);
+    s_metadata->parentOffset     = CarveArray<uint32>(&cursor, s_metadata->numParents);
+    s_metadata->memberName       = CarveArray<uint32>(&cursor, s_metadata->numMembers);
+    s_metadata->memberType       = CarveArray<uint32>(&cursor, s_metadata->numMembers);
+    s_metadata->memberOffset     = CarveArray<uint32>(&cursor, s_metadata->numMembers);
+    s_metadata->memberSize       = CarveArray<uint32>(&cursor, s_metadata->numMembers);
+    s_metadata->memberTarget     = CarveArray<uint32>(&cursor, s_metadata->numMembers);
+    s_metadata->aliasOld         = CarveArray<uint32>(&cursor, s_metadata->numAliases);
+    s_metadata->aliasNew         = CarveArray<uint32>(&cursor, s_metadata->numAliases);
+    s_metadata->classAliasOld    = CarveArray<uint32>(&cursor, numClassAliases);
+    s_metadata->classAliasType   = CarveArray<uint32>(&cursor, numClassAliases);
+    s_metadata->typeNumParents   = CarveArray<uint16>(&cursor, numTypes);
+    s_metadata->typeNumMembers   = CarveArray<uint16>(&cursor, numTypes);
+    s_metadata->typeNumAliases   = CarveArray<uint16>(&cursor, numTypes);
+    s_metadata->typeNumBitfields = CarveArray<uint16>(&cursor, numTypes);
+    s_metadata->typeBitfieldBits = CarveArray<uint16>(&cursor, numTypes);
+    s_metadata->typeFlags        = CarveArray<uint8>(&cursor, numTypes);
+    s_metadata->memberIndex      = CarveArray<uint8>(&cursor, s_metadata->numMembers);
+    s_metadata->memberBitOffset  = CarveArray<uint8>(&cursor, s_metadata->numMembers);
+    s_metadata->memberBitWidth   = CarveArray<uint8>(&cursor, s_metadata->numMembers);
+    ASSERTGR(cursor == s_metadata->block + s_metadata->bytes);
+
+    // Every type has to be sorted before members can refer to them
+    unsigned type = 0;
+    for (const ReflTypeDesc * desc = s_descHead; desc != NULL; desc = desc->GetNext()) 
+        s_metadata->typeDesc[type++] = desc;
+    qsort(s_metadata->typeDesc, numTypes, sizeof(const ReflTypeDesc *), CompareTypeHash);
+    for (type = 0; type < numTypes; type++) 
+        s_metadata->typeHash[type] = s_metadata->typeDesc[type]->GetHash().GetValue();
+
+    for (const ReflAlias * alias = s_classAliasHead; alias != NULL; alias = alias->next) {
+        unsigned aliasIndex = s_metadata->numClassAliases;
+        s_metadata->classAliasOld[aliasIndex]   = alias->oldHash.GetValue();
+        s_metadata->classAliasType[aliasIndex]  = FindMetadataType(alias->newHash.GetValue());
+        s_metadata->numClassAliases++;
+    }
+
+    unsigned parentIndex    = 0;
+    unsigned memberIndex    = 0;
+    unsigned aliasIndex     = 0;
+    for (type = 0; type < numTypes; type++) {
+        const ReflTypeDesc * desc = s_metadata->typeDesc[type];
+        s_metadata->typeVersion[type]    = desc->GetVersion();
+        s_metadata->typeBinarySize[type] = 0;
+        s_metadata->typeFlags[type]      = 0;
+        if (desc->HasFinalizationFunc()) 
+            s_metadata->typeFlags[type] |= METADATA_TYPE_FINALIZE;
+        if (desc->HasManualVersioning()) 
+            s_metadata->typeFlags[type] |= METADATA_TYPE_MANUAL_VERSIONING;
+
+        s_metadata->typeFirstParent[type] = parentIndex;
+        for (const ReflTypeDesc::Parent * parent = desc->GetParents(); parent != NULL; parent = parent->next) {
+            s_metadata->parentType[parentIndex]      = FindMetadataType(parent->parentHash.GetValue());
+            ASSERTMSGGR(s_metadata->parentType[parentIndex] != s_invalidMetadataIndex, "Parent of %s was unregistered", desc->GetTypeName());
+            s_metadata->parentOffset[parentIndex]    = parent->baseOffset;
+            parentIndex++;
+        }
+        s_metadata->typeNumParents[type] = static_cast<uint16>(parentIndex - s_metadata->typeFirstParent[type]);
+
+        ReflContentHasher layout;
+        unsigned numBitfields   = 0;
+        unsigned bitfieldBits   = 0;
+
+        s_metadata->typeFirstMember[type] = memberIndex;
+        for (const ReflMember * member = desc->GetLocalMembers(); member != NULL; member = member->GetNext()) {
+            if (member->IsDeprecated()) 
+                continue;
+
+            if (member->IsBitfield()) {
+                uint32 entry[2] = { member->NameHash().GetValue(), member->GetBitWidth() };
+                layout.Add(entry, sizeof(entry));
+                numBitfields++;
+                bitfieldBits += member->GetBitWidth();
+            }
+
+            uint32 target = s_invalidMetadataIndex;
+            if (member->TypeIndex() == REFL_INDEX_CLASS) 
+                target = FindMetadataType(member->TypeHash().GetValue());
+            else if (member->TypeIndex() == REFL_INDEX_POINTER) 
+                target = FindMetadataType(member->PointeeTypeHash().GetValue());
+
+            s_metadata->memberName[memberIndex]      = member->NameHash().GetValue();
+            s_metadata->memberType[memberIndex]      = member->TypeHash().GetValue();
+            s_metadata->memberOffset[memberIndex]    = member->GetOffset();
+            s_metadata->memberSize[memberIndex]      = member->GetSize();
+            s_metadata->memberTarget[memberIndex]    = target;
+            s_metadata->memberIndex[memberIndex]     = static_cast<uint8>(member->TypeIndex());
+            s_metadata->memberBitOffset[memberIndex] = static_cast<uint8>(member->GetBitOffset());
+            s_metadata->memberBitWidth[memberIndex]  = static_cast<uint8>(member->GetBitWidth());
+            memberIndex++;
+        }
+        s_metadata->typeNumMembers[type] = static_cast<uint16>(memberIndex - s_metadata->typeFirstMember[type]);
+
+        ASSERTMSGGR(bitfieldBits <= s_maxBitfieldBytes * 8, "Too many bitfield bits in class(%s)", desc->GetTypeName());
+        s_metadata->typeBitfieldLayout[type] = static_cast<uint32>(layout.GetHash().GetValue());
+        s_metadata->typeNumBitfields[type]   = static_cast<uint16>(numBitfields);
+        s_metadata->typeBitfieldBits[type]   = static_cast<uint16>(bitfieldBits);
+
+        s_metadata->typeFirstAlias[type] = aliasIndex;
+        for (const ReflAlias * alias = desc->GetMemberAliases(); alias != NULL; alias = alias->next) {
+            s_metadata->aliasOld[aliasIndex] = alias->oldHash.GetValue();
+            s_metadata->aliasNew[aliasIndex] = alias->newHash.GetValue();
+            aliasIndex++;
+        }
+        s_metadata->typeNumAliases[type] = static_cast<uint16>(aliasIndex - s_metadata->typeFirstAlias[type]);
+    }
+
+    for (type = 0; type < numTypes; type++) 
+        MetadataBinarySize(type);
+
+    MetadataTables * tables = s_metadata;
+    s_metadata = prevMetadata;
+    return tables;
+}
+
+//====================================================
+// Swaps in new tables and frees the old ones once no thread can still be 
+//  reading them. Called with the registration lock held.
+static void PublishMetadata(MetadataTables * tables) {
+    ASSERTMSGGR(s_metadataReader == NULL || s_metadataReader->depth == 0, "Publishing reflection metadata while reading it");
+
+    MetadataTables * prevTables = (MetadataTables *) AtomicExchangePointer((void * volatile *) &s_publishedMetadata, tables);
+    int32 epoch = AtomicIncrement(&s_metadataEpoch);
+    if (prevTables == NULL) 
+        return;
+
+    for (MetadataReader * reader = s_metadataReaders; reader != NULL; reader = reader->next) {
+        for (;;) {
+            int32 readerEpoch = reader->epoch;
+            if (readerEpoch == 0 || readerEpoch >= epoch) 
+                break;
+            ThreadYield();
+        }
+    }
+
+    FreeMetadata(prevTables);
+}
+
+//====================================================
+static unsigned NameBytes(const chargr * name) {
+    // Gold builds don't store names
+    if (name == NULL || name[0] == 0) 
+        return 0;
+    return (StrLen(name, 256) + 1) * sizeof(chargr);
+}
+
+//====================================================
+static const ReflClass * ReadMetadataPointer(unsigned member, const byte * base) {
+    void * target = *reinterpret_cast<void * const *>(base + s_metadata->memberOffset[member]);
+    if (target == NULL) 
+        return NULL;
+
+    const ReflTypeDesc * pointeeDesc = s_metadata->typeDesc[s_metadata->memberTarget[member]];
+    return reinterpret_cast<const ReflClass *>(pointeeDesc->CastTo(target, pointeeDesc->GetHash(), ReflClass::GetReflType()));
+}
+
+//====================================================
+static void GatherMetadataPointers(ReflGraphWriter * writer, unsigned type, const byte * base) {
+    unsigned firstParent = s_metadata->typeFirstParent[type];
+    for (unsigned parent = firstParent; parent < firstParent + s_metadata->typeNumParents[type]; parent++) 
+        GatherMetadataPointers(writer, s_metadata->parentType[parent], base + s_metadata->parentOffset[parent]);
+
+    unsigned firstMember = s_metadata->typeFirstMember[type];
+    for (unsigned member = firstMember; member < firstMember + s_metadata->typeNumMembers[type]; member++) {
+        if (s_metadata->memberIndex[member] == REFL_INDEX_CLASS) 
+            GatherMetadataPointers(writer, s_metadata->memberTarget[member], base + s_metadata->memberOffset[member]);
+        else if (s_metadata->memberIndex[member] == REFL_INDEX_POINTER) 
+            writer->AddObject(ReadMetadataPointer(member, base));
+    }
+}
+
+//====================================================
+static void MarkSchemaType(bool * used, unsigned type) {
+    if (used[type]) 
+        return;
+    used[type] = true;
+
+    unsigned firstParent = s_metadata->typeFirstParent[type];
+    for (unsigned parent = firstParent; parent < firstParent + s_metadata->typeNumParents[type]; parent++) 
+        MarkSchemaType(used, s_metadata->parentType[parent]);
+
+    unsigned firstMember = s_metadata->typeFirstMember[type];
+    for (unsigned member = firstMember; member < firstMember + s_metadata->typeNumMembers[type]; member++) {
+        if (s_metadata->memberIndex[member] == REFL_INDEX_CLASS) 
+            MarkSchemaType(used, s_metadata->memberTarget[member]);
+    }
+}
+
+//====================================================
+static void ReadMetadataMember(
+    DataStream        * stream, 
+    ReflGraphReader   * reader,
+    unsigned            member, 
+    uint32              typeHash, 
+    unsigned            size, 
+    byte              * base
+) {
+    byte * field = base + s_metadata->memberOffset[member];
+    if (s_metadata->memberIndex[member] == REFL_INDEX_BITFIELD) {
+        // Written before the flag was packed into a bitfield
+        bool integerType = typeHash == s_metadata->memberType[member] || IsIntegerType(HashFromValue(typeHash));
+        if (integerType && size <= sizeof(uint64)) {
+            REFL_TELEMETRY_COUNT_CURRENT(TELEMETRY_CONVERSIONS, typeHash != s_metadata->memberType[member] ? 1 : 0);
+            byte value[sizeof(uint64)] = { 0 };
+            stream->ReadBytes(value, size);
+            WriteBits(field, s_metadata->memberBitOffset[member], s_metadata->memberBitWidth[member], ReadBits(value, 0, 64));
+        }
+        else {
+            LOG(LOG_PRIORITY_INFO, "Skipping binary member(%x) that can't be packed into a bitfield", s_metadata->memberName[member]);
+            stream->Skip(size);
+        }
+        return;
+    }
+
+    if (typeHash != s_metadata->memberType[member]) {
+        // Binary data is cooked, so conversions are done when cooking from text
+        LOG(LOG_PRIORITY_INFO, "Skipping binary member(%x) that changed type", s_metadata->memberName[member]);
+        stream->Skip(size);
+        return;
+    }
+
+    if (s_metadata->memberIndex[member] == REFL_INDEX_CLASS) {
+        ReadMetadataBlock(stream, reader, s_metadata->memberTarget[member], field);
+    }
+    else if (s_metadata->memberIndex[member] == REFL_INDEX_POINTER) {
+        uint32 id = s_nullObjectId;
+        stream->Read(id);
+
+        uint32 pointeeHash = s_metadata->typeHash[s_metadata->memberTarget[member]];
+        reader->ResolvePointer(reinterpret_cast<void **>(field), id, HashFromValue(pointeeHash));
+    }
+    else if (size == s_metadata->memberSize[member]) {
+        stream->ReadBytes(field, size);
+    }
+    else {
+        LOG(LOG_PRIORITY_INFO, "Skipping binary member(%x) that changed size", s_metadata->memberName[member]);
+        stream->Skip(size);
+    }
+}
+
+//====================================================
+static void ReadMetadataBitfields(DataStream * stream, unsigned type, byte * base, unsigned size) {
+    uint32 layout = 0;
+    stream->Read(layout);
+
+    unsigned bytes = (s_metadata->typeBitfieldBits[type] + 7) / 8;
+    if (layout != s_metadata->typeBitfieldLayout[type] || size != sizeof(uint32) + bytes) {
+        LOG(LOG_PRIORITY_WARN, "Bitfields of class(%x) changed and the data needs to be cooked again", s_metadata->typeHash[type]);
+        stream->Skip(size - sizeof(uint32));
+        return;
+    }
+
+    byte packed[s_maxBitfieldBytes];
+    const byte * bits = stream->ReadInPlace(bytes);
+    if (bits == NULL) {
+        stream->ReadBytes(packed, bytes);
+        bits = packed;
+    }
+
+    unsigned bit            = 0;
+    unsigned firstMember    = s_metadata->typeFirstMember[type];
+    for (unsigned member = firstMember; member < firstMember + s_metadata->typeNumMembers[type]; member++) {
+        if (s_metadata->memberIndex[member] != REFL_INDEX_BITFIELD) 
+            continue;
+
+        unsigned width = s_metadata->memberBitWidth[member];
+        uint64 value = ReadBits(bits + bit / 8, bit % 8, width);
+        WriteBits(base + s_metadata->memberOffset[member], s_metadata->memberBitOffset[member], width, value);
+        bit += width;
+    }
+}
+
+//====================================================
+static bool ReadMetadataContents(
+    DataStream        * stream, 
+    ReflGraphReader   * reader,
+    unsigned            type, 
+    byte              * inst, 
+    unsigned            version,
+    unsigned            size
+) {
+    // Bytes are counted against the type owning each record, nested class
+    //  blocks count their own
+    REFL_TELEMETRY_SCOPE(s_metadata->typeHash[type], TELEMETRY_LOAD_TICKS);
+    REFL_TELEMETRY_COUNT(s_metadata->typeHash[type], TELEMETRY_OBJECTS_LOADED, 1);
+    REFL_TELEMETRY_COUNT(s_metadata->typeHash[type], TELEMETRY_BYTES_LOADED, 2 * sizeof(uint32));
+
+    if (version != s_metadata->typeVersion[type] && (s_metadata->typeFlags[type] & METADATA_TYPE_MANUAL_VERSIONING)) {
+        // Manual versioning functions read text, the data has to be cooked again
+        LOG(LOG_PRIORITY_WARN, "Binary data for class(%x) is version %u and needs to be cooked again", s_metadata->typeHash[type], version);
+        stream->Skip(size);
+        return false;
+    }
+
+    uint32 numParents = 0;
+    stream->Read(numParents);
+    for (unsigned i = 0; i < numParents; i++) {
+        uint32 parentHash       = 0;
+        uint32 parentVersion    = 0;
+        uint32 parentSize       = 0;
+        stream->Read(parentHash);
+        stream->Read(parentVersion);
+        if (stream->Read(parentSize) != STREAM_ERROR_OK) 
+            return false;
+
+        unsigned parentType = FindMetadataType(parentHash);
+        unsigned parent     = s_metadata->typeFirstParent[type];
+        unsigned endParent  = parent + s_metadata->typeNumParents[type];
+        while (parent < endParent && s_metadata->parentType[parent] != parentType) 
+            parent++;
+
+        if (parentType != s_invalidMetadataIndex && parent < endParent) {
+            REFL_TELEMETRY_COUNT(s_metadata->typeHash[parentType], TELEMETRY_ALIAS_HITS, parentHash != s_metadata->typeHash[parentType] ? 1 : 0);
+            REFL_TELEMETRY_COUNT(s_metadata->typeHash[parentType], TELEMETRY_BYTES_LOADED, 3 * sizeof(uint32));
+            ReadMetadataContents(stream, reader, parentType, inst + s_metadata->parentOffset[parent], parentVersion, parentSize);
+        }
+        else
+            stream->Skip(parentSize);
+    }
+
+    uint32 numMembers = 0;
+    if (stream->Read(numMembers) != STREAM_ERROR_OK) 
+        return false;
+
+    for (unsigned i = 0; i < numMembers; i++) {
+        uint32 nameHash     = 0;
+        uint32 typeHash     = 0;
+        uint32 memberSize   = 0;
+        stream->Read(nameHash);
+        stream->Read(typeHash);
+        if (stream->Read(memberSize) != STREAM_ERROR_OK) 
+            return false;
+
+        if (nameHash == s_bitfieldRecordName.GetValue()) {
+            REFL_TELEMETRY_COUNT(s_metadata->typeHash[type], TELEMETRY_MEMBERS_LOADED, s_metadata->typeNumBitfields[type]);
+            REFL_TELEMETRY_COUNT(s_metadata->typeHash[type], TELEMETRY_BYTES_LOADED, 3 * sizeof(uint32) + memberSize);
+            ReadMetadataBitfields(stream, type, inst, memberSize);
+            continue;
+        }
+
+        unsigned member = FindMetadataMember(type, nameHash);
+        if (member != s_invalidMetadataIndex) {
+            REFL_TELEMETRY_COUNT(s_metadata->typeHash[type], TELEMETRY_MEMBERS_LOADED, 1);
+            REFL_TELEMETRY_COUNT(s_metadata->typeHash[type], TELEMETRY_ALIAS_HITS, nameHash != s_metadata->memberName[member] ? 1 : 0);
+            REFL_TELEMETRY_COUNT(
+                s_metadata->typeHash[type], 
+                TELEMETRY_BYTES_LOADED, 
+                3 * sizeof(uint32) + (s_metadata->memberIndex[member] == REFL_INDEX_CLASS ? 0 : memberSize)
+            );
+            ReadMetadataMember(stream, reader, member, typeHash, memberSize, inst);
+        }
+        else
+            stream->Skip(memberSize);
+    }
+
+    return true;
+}
+
+//====================================================
+static bool ReadMetadataBlockContents(
+    DataStream        * stream, 
+    ReflGraphReader   * reader,
+    unsigned            type, 
+    byte              * inst, 
+    uint32              typeHash,
+    uint32              version,
+    uint32              size
+) {
+    if (FindMetadataType(typeHash) != type) {
+        LOG(LOG_PRIORITY_WARN, "Binary class block doesn't match class(%x)", s_metadata->typeHash[type]);
+        stream->Skip(size);
+        return false;
+    }
+    REFL_TELEMETRY_COUNT(s_metadata->typeHash[type], TELEMETRY_ALIAS_HITS, typeHash != s_metadata->typeHash[type] ? 1 : 0);
+    REFL_TELEMETRY_COUNT(s_metadata->typeHash[type], TELEMETRY_BYTES_LOADED, 3 * sizeof(uint32));
+
+    if (!ReadMetadataContents(stream, reader, type, inst, version, size)) 
+        return false;
+
+    // Finalization waits until every reference in the file is restored
+    if (s_metadata->typeFlags[type] & METADATA_TYPE_FINALIZE) 
+        reader->DeferFinalize(s_metadata->typeDesc[type], inst);
+
+    return true;
+}
+
+//====================================================
+static bool ReadMetadataBlock(DataStream * stream, ReflGraphReader * reader, unsigned type, byte * inst) {
+    uint32 typeHash = 0;
+    uint32 version  = 0;
+    uint32 size     = 0;
+    stream->Read(typeHash);
+    stream->Read(version);
+    if (stream->Read(size) != STREAM_ERROR_OK) 
+        return false;
+
+    return ReadMetadataBlockContents(stream, reader, type, inst, typeHash, version, size);
+}
+
+//====================================================
+static bool WriteMetadataBitfields(DataStream * stream, unsigned type, const byte * base) {
+    unsigned bytes = (s_metadata->typeBitfieldBits[type] + 7) / 8;
+    byte packed[s_maxBitfieldBytes];
+    memset(packed, 0, bytes);
+
+    unsigned bit            = 0;
+    unsigned firstMember    = s_metadata->typeFirstMember[type];
+    for (unsigned member = firstMember; member < firstMember + s_metadata->typeNumMembers[type]; member++) {
+        if (s_metadata->memberIndex[member] != REFL_INDEX_BITFIELD) 
+            continue;
+
+        unsigned width = s_metadata->memberBitWidth[member];
+        uint64 value = ReadBits(base + s_metadata->memberOffset[member], s_metadata->memberBitOffset[member], width);
+        WriteBits(packed + bit / 8, bit % 8, width, value);
+        bit += width;
+    }
+
+    stream->Write<uint32>(s_bitfieldRecordName.GetValue());
+    stream->Write<uint32>(ReflTypeBitfield.GetValue());
+    stream->Write<uint32>(sizeof(uint32) + bytes);
+    stream->Write<uint32>(s_metadata->typeBitfieldLayout[type]);
+    REFL_TELEMETRY_COUNT(s_metadata->typeHash[type], TELEMETRY_BYTES_SAVED, sizeof(uint32) + bytes);
+    return stream->WriteBytes(packed, bytes) == STREAM_ERROR_OK;
+}
+
+//====================================================
+static bool WriteMetadataBlock(DataStream * stream, ReflGraphWriter * writer, unsigned type, const byte * inst) {
+    unsigned numParents     = s_metadata->typeNumParents[type];
+    unsigned numMembers     = s_metadata->typeNumMembers[type];
+    unsigned numBitfields   = s_metadata->typeNumBitfields[type];
+    unsigned numRecords     = numMembers - numBitfields + (numBitfields > 0 ? 1 : 0);
+
+    // Class members and parents count their own blocks
+    REFL_TELEMETRY_SCOPE(s_metadata->typeHash[type], TELEMETRY_SAVE_TICKS);
+    REFL_TELEMETRY_COUNT(s_metadata->typeHash[type], TELEMETRY_OBJECTS_SAVED, 1);
+    REFL_TELEMETRY_COUNT(s_metadata->typeHash[type], TELEMETRY_MEMBERS_SAVED, numMembers);
+    REFL_TELEMETRY_COUNT(s_metadata->typeHash[type], TELEMETRY_BYTES_SAVED, 5 * sizeof(uint32) + numRecords * 3 * sizeof(uint32));
+
+    stream->Write<uint32>(s_metadata->typeHash[type]);
+    stream->Write<uint32>(s_metadata->typeVersion[type]);
+    stream->Write<uint32>(s_metadata->typeBinarySize[type] - 3 * sizeof(uint32));
+    stream->Write<uint32>(numParents);
+
+    bool result = true;
+    unsigned firstParent = s_metadata->typeFirstParent[type];
+    for (unsigned parent = firstParent; parent < firstParent + numParents; parent++) 
+        result = WriteMetadataBlock(stream, writer, s_metadata->parentType[parent], inst + s_metadata->parentOffset[parent]) && result;
+
+    result = stream->Write<uint32>(numRecords) == STREAM_ERROR_OK && result;
+
+    unsigned firstMember = s_metadata->typeFirstMember[type];
+    for (unsigned member = firstMember; member < firstMember + numMembers; member++) {
+        if (s_metadata->memberIndex[member] == REFL_INDEX_BITFIELD) 
+            continue;
+
+        uint32 target = s_metadata->memberTarget[member];
+        uint32 size   = s_metadata->memberSize[member];
+        if (s_metadata->memberIndex[member] == REFL_INDEX_CLASS) 
+            size = s_metadata->typeBinarySize[target];
+        else if (s_metadata->memberIndex[member] == REFL_INDEX_POINTER) 
+            size = sizeof(uint32);
+
+        stream->Write<uint32>(s_metadata->memberName[member]);
+        stream->Write<uint32>(s_metadata->memberType[member]);
+        stream->Write<uint32>(size);
+        REFL_TELEMETRY_COUNT(s_metadata->typeHash[type], TELEMETRY_BYTES_SAVED, s_metadata->memberIndex[member] == REFL_INDEX_CLASS ? 0 : size);
+
+        const byte * field = inst + s_metadata->memberOffset[member];
+        if (s_metadata->memberIndex[member] == REFL_INDEX_CLASS) 
+            result = WriteMetadataBlock(stream, writer, target, field) && result;
+        else if (s_metadata->memberIndex[member] == REFL_INDEX_POINTER) 
+            result = stream->Write<uint32>(writer->AddObject(ReadMetadataPointer(member, inst))) == STREAM_ERROR_OK && result;
+        else
+            result = stream->WriteBytes(field, size) == STREAM_ERROR_OK && result;
+    }
+
+    if (numBitfields > 0) 
+        result = WriteMetadataBitfields(stream, type, inst) && result;
+
+    return result;
+}
+
+#ifndef GOLD
+//====================================================
+static void WriteSchemaHash(IStructuredTextStreamPtr stream, const chargr * name, uint32 value) {
+    chargr str[16];
+    StrPrintf(str, 16, L"0x%08x", value);
+    stream->WriteNodeAttribute(name, str);
 }
 
 //====================================================
-template<>
-void ConvertToString<REFL_INDEX_INT8, int8>(const ReflMember * , const byte * data, const chargr * format, chargr * string, unsigned len) {
-    int value = *(reinterpret_cast<const int8 *>(data));
-    StrPrintf(string, len, L"%d", value);
+static void WriteSchemaValue(IStructuredTextStreamPtr stream, const chargr * name, unsigned value) {
+    chargr str[16];
+    StrPrintf(str, 16, L"%u", value);
+    stream->WriteNodeAttribute(name, str);
 }
 
 //====================================================
-template<>
-void ConvertToString<REFL_INDEX_UINT8, uint8>(const ReflMember * , const byte * data, const chargr * format, chargr * string, unsigned len) {
-    unsigned value = *(reinterpret_cast<const uint8 *>(data));
-    StrPrintf(string, len, L"%u", value);
+static const chargr * SchemaKindName(ReflIndex index) {
+    // Enums and strings are named by their declaration in the type table
+    if (index == REFL_INDEX_ENUM) 
+        return L"enum";
+    else if (index == REFL_INDEX_STRING) 
+        return L"string";
+    return s_typeDesc[index].GetTypeName(NULL);
 }
 
 //====================================================
-template<>
-void ConvertToString<REFL_INDEX_ENUM, char>(const ReflMember * memberDesc, const byte * data, const chargr * format, chargr * string, unsigned len) {
-    int64 idata = 0;
-    switch (memberDesc->GetSize()) {
-        case sizeof(char):
-            idata = *reinterpret_cast<const int8 *>(data);
-            break;
-        case sizeof(short):
-            idata = *reinterpret_cast<const int16 *>(data);
-            break;
-        case sizeof(int):
-            idata = *reinterpret_cast<const int32 *>(data);
-            break;
-        case sizeof(int64):
-            idata = *reinterpret_cast<const int64 *>(data);
-            break;
+static void ExportSchemaMember(IStructuredTextStreamPtr stream, const ReflMember * desc, unsigned member) {
+    ReflIndex index     = s_metadata->memberIndex[member];
+    uint32 target       = s_metadata->memberTarget[member];
+    unsigned binarySize = s_metadata->memberSize[member];
+    if (index == REFL_INDEX_CLASS) 
+        binarySize = MetadataBinarySize(target);
+    else if (index == REFL_INDEX_POINTER) 
+        binarySize = sizeof(uint32);
+
+    stream->WriteNode(L"Member");
+    stream->WriteNodeAttribute(L"Name", desc->Name());
+    WriteSchemaHash(stream, L"Hash", s_metadata->memberName[member]);
+    stream->WriteNodeAttribute(L"Kind", SchemaKindName(index));
+    WriteSchemaHash(stream, L"TypeHash", s_metadata->memberType[member]);
+
+    const ReflTypeDesc * targetDesc = NULL;
+    if (target != s_invalidMetadataIndex) 
+        targetDesc = s_metadata->typeDesc[target];
+    else if (index == REFL_INDEX_ENUM) 
+        targetDesc = ReflLibrary::GetClassDesc(desc->TypeHash());
+    if (targetDesc != NULL) {
+        stream->WriteNodeAttribute(L"Target", targetDesc->GetTypeName());
+        WriteSchemaHash(stream, L"TargetHash", targetDesc->GetHash().GetValue());
     }
-    const ReflTypeDesc * enumDesc = ReflLibrary::GetClassDesc(memberDesc->TypeHash());
-    ASSERTMSGGR(enumDesc != NULL, "Unregistered enum type");
-    const ReflTypeDesc::EnumValue * enumValue = enumDesc->GetEnumValue(idata);
-    if (enumValue != NULL) 
-        StrPrintf(string, len, L"%s", enumValue->name);
-    else {
-        ASSERTMSGGR(false, "Unhandled enum value");
-        //Need to log a message here?
+
+    WriteSchemaValue(stream, L"Offset", s_metadata->memberOffset[member]);
+    WriteSchemaValue(stream, L"Size", s_metadata->memberSize[member]);
+    if (index == REFL_INDEX_BITFIELD) {
+        WriteSchemaValue(stream, L"BitOffset", s_metadata->memberBitOffset[member]);
+        WriteSchemaValue(stream, L"BitWidth", s_metadata->memberBitWidth[member]);
+        stream->WriteNodeAttribute(L"Signed", desc->IsBitfieldSigned() ? L"true" : L"false");
     }
+    else
+        WriteSchemaValue(stream, L"BinarySize", binarySize);
+    stream->EndNode();
 }
 
 //====================================================
-template<>
-void ConvertToString<REFL_INDEX_PERCENTAGE, float>(const ReflMember * , const byte * data, const chargr * format, chargr * string, unsigned len) {
-    StrPrintf(string, len, L"%3.3f", 100.0f * (*((float *) data)));
+static void ExportSchemaType(IStructuredTextStreamPtr stream, unsigned type) {
+    const ReflTypeDesc * desc = s_metadata->typeDesc[type];
+
+    stream->WriteNode(L"Type");
+    stream->WriteNodeAttribute(L"Name", desc->GetTypeName());
+    WriteSchemaHash(stream, L"Hash", s_metadata->typeHash[type]);
+    stream->WriteNodeAttribute(L"Kind", desc->IsEnumType() ? L"enum" : L"class");
+    WriteSchemaValue(stream, L"Version", s_metadata->typeVersion[type]);
+    WriteSchemaValue(stream, L"Size", desc->GetSize());
+    if (!desc->IsEnumType()) 
+        WriteSchemaValue(stream, L"BinarySize", MetadataBinarySize(type));
+    if (s_metadata->typeNumBitfields[type] > 0) {
+        WriteSchemaHash(stream, L"BitfieldLayout", s_metadata->typeBitfieldLayout[type]);
+        WriteSchemaValue(stream, L"BitfieldBits", s_metadata->typeBitfieldBits[type]);
+    }
+
+    unsigned firstParent = s_metadata->typeFirstParent[type];
+    for (unsigned parent = firstParent; parent < firstParent + s_metadata->typeNumParents[type]; parent++) {
+        unsigned parentType = s_metadata->parentType[parent];
+        stream->WriteNode(L"Parent");
+        stream->WriteNodeAttribute(L"Name", s_metadata->typeDesc[parentType]->GetTypeName());
+        WriteSchemaHash(stream, L"Hash", s_metadata->typeHash[parentType]);
+        WriteSchemaValue(stream, L"Offset", s_metadata->parentOffset[parent]);
+        stream->EndNode();
+    }
+
+    // Metadata members are the non deprecated local members in the same order
+    unsigned member = s_metadata->typeFirstMember[type];
+    for (const ReflMember * memberDesc = desc->GetLocalMembers(); memberDesc != NULL; memberDesc = memberDesc->GetNext()) {
+        if (!memberDesc->IsDeprecated()) 
+            ExportSchemaMember(stream, memberDesc, member++);
+    }
+
+    for (const ReflTypeDesc::EnumValue * value = desc->GetEnumValues(); value != NULL; value = value->next) {
+        chargr str[32];
+        StrPrintf(str, 32, L"%lld", value->value);
+        stream->WriteNode(L"Value");
+        stream->WriteNodeAttribute(L"Name", value->name);
+        stream->WriteNodeAttribute(L"Value", str);
+        stream->EndNode();
+    }
+
+    stream->EndNode();
 }
+#endif
 
 //====================================================
-template<>
-void ConvertToString<REFL_INDEX_ANGLE, float>(const ReflMember * , const byte * data, const chargr * format, chargr * string, unsigned len) {
-    float * fdata = (float *) data;
-    StrPrintf(string, len, L"%3.3f", MathRadiansToDegrees(*fdata));
-}
+// Gold builds don't serialize text, so the converters aren't linked in
+#ifdef GOLD
+    #define REFL_TEXT_FUNCS(index, type)    NULL, NULL
+#else
+    #define REFL_TEXT_FUNCS(index, type)    &ConvertToString<index, type>, &ConvertFromString<index, type>
+#endif
+
+void InitializeTypeTable() {
+    s_typeDesc[REFL_INDEX_BOOL        ] = TypeDesc(REFL_INDEX_BOOL,          L"bool",            sizeof(bool),         NULL,      REFL_TEXT_FUNCS(REFL_INDEX_BOOL,           bool));
+    s_typeDesc[REFL_INDEX_INT8        ] = TypeDesc(REFL_INDEX_INT8,          L"int8",            sizeof(int8),         NULL,      REFL_TEXT_FUNCS(REFL_INDEX_INT8,           int8));
+    s_typeDesc[REFL_INDEX_UINT8       ] = TypeDesc(REFL_INDEX_UINT8,         L"uint8",           sizeof(uint8),        NULL,      REFL_TEXT_FUNCS(REFL_INDEX_UINT8,         uint8));
+    s_typeDesc[REFL_INDEX_INT16       ] = TypeDesc(REFL_INDEX_INT16,         L"int16",           sizeof(int16),        L"%hd",    REFL_TEXT_FUNCS(REFL_INDEX_INT16,         int16));
+    s_typeDesc[REFL_INDEX_UINT16      ] = TypeDesc(REFL_INDEX_UINT16,        L"uint16",          sizeof(uint16),       L"%hu",    REFL_TEXT_FUNCS(REFL_INDEX_UINT16,       uint16));
+    s_typeDesc[REFL_INDEX_INT32       ] = TypeDesc(REFL_INDEX_INT32,         L"int32",           sizeof(int32),        L"%d",     REFL_TEXT_FUNCS(REFL_INDEX_INT32,         int32));
+    s_typeDesc[REFL_INDEX_UINT32      ] = TypeDesc(REFL_INDEX_UINT32,        L"uint32",          sizeof(uint32),       L"%u",     REFL_TEXT_FUNCS(REFL_INDEX_UINT32,       uint32));
+    s_typeDesc[REFL_INDEX_INT64       ] = TypeDesc(REFL_INDEX_INT64,         L"int64",           sizeof(int64),        L"%lld",   REFL_TEXT_FUNCS(REFL_INDEX_INT64,         int64));
+    s_typeDesc[REFL_INDEX_UINT64      ] = TypeDesc(REFL_INDEX_UINT64,        L"uint64",          sizeof(uint64),       L"%llu",   REFL_TEXT_FUNCS(REFL_INDEX_UINT64,       uint64));
+    s_typeDesc[REFL_INDEX_INT128      ] = TypeDesc(REFL_INDEX_INT128,        L"int128",          sizeof(int128),       NULL,      REFL_TEXT_FUNCS(REFL_INDEX_INT128,       int128));
+    s_typeDesc[REFL_INDEX_UINT128     ] = TypeDesc(REFL_INDEX_UINT128,       L"uint128",         sizeof(uint128),      NULL,      REFL_TEXT_FUNCS(REFL_INDEX_UINT128,     uint128));
+    s_typeDesc[REFL_INDEX_FLOAT16     ] = TypeDesc(REFL_INDEX_FLOAT16,       L"float16",         sizeof(float16),      L"%f",     REFL_TEXT_FUNCS(REFL_INDEX_FLOAT16,       float));
+    s_typeDesc[REFL_INDEX_FLOAT32     ] = TypeDesc(REFL_INDEX_FLOAT32,       L"float32",         sizeof(float32),      L"%f",     REFL_TEXT_FUNCS(REFL_INDEX_FLOAT32,       float));
+    s_typeDesc[REFL_INDEX_STRING      ] = TypeDesc(REFL_INDEX_STRING,        L"chargr *",        sizeof(chargr *),     L"%s",     REFL_TEXT_FUNCS(REFL_INDEX_STRING, const chargr));
+    s_typeDesc[REFL_INDEX_CLASS       ] = TypeDesc(REFL_INDEX_CLASS,         L"class",           0,                    NULL,      REFL_TEXT_FUNCS(REFL_INDEX_CLASS,          char));
+    s_typeDesc[REFL_INDEX_ENUM        ] = TypeDesc(REFL_INDEX_ENUM,          L"enum",            sizeof(unsigned),     NULL,      REFL_TEXT_FUNCS(REFL_INDEX_ENUM,           char));
+    s_typeDesc[REFL_INDEX_FIXED_ARRAY ] = TypeDesc(REFL_INDEX_FIXED_ARRAY,   L"fixedarray",      0,                    NULL,      REFL_TEXT_FUNCS(REFL_INDEX_FIXED_ARRAY,    char));
+    s_typeDesc[REFL_INDEX_VAR_ARRAY   ] = TypeDesc(REFL_INDEX_VAR_ARRAY,     L"vararray",        0,                    NULL,      REFL_TEXT_FUNCS(REFL_INDEX_VAR_ARRAY,      char));
+    s_typeDesc[REFL_INDEX_POINTER     ] = TypeDesc(REFL_INDEX_POINTER,       L"pointer",         sizeof(void *),       NULL,      REFL_TEXT_FUNCS(REFL_INDEX_POINTER,        char));
+    s_typeDesc[REFL_INDEX_BITFIELD    ] = TypeDesc(REFL_INDEX_BITFIELD,      L"bitfield",        0,                    NULL,      REFL_TEXT_FUNCS(REFL_INDEX_BITFIELD,       char));
+    s_typeDesc[REFL_INDEX_COLOR       ] = TypeDesc(REFL_INDEX_COLOR,         L"color",           sizeof(color),        NULL,      REFL_TEXT_FUNCS(REFL_INDEX_COLOR,          char));
+    s_typeDesc[REFL_INDEX_ANGLE       ] = TypeDesc(REFL_INDEX_ANGLE,         L"angle",           sizeof(angle),        NULL,      REFL_TEXT_FUNCS(REFL_INDEX_ANGLE,         float));
+    s_typeDesc[REFL_INDEX_PERCENTAGE  ] = TypeDesc(REFL_INDEX_PERCENTAGE,    L"percentage",      sizeof(percentage),   NULL,      REFL_TEXT_FUNCS(REFL_INDEX_PERCENTAGE,    float));
+    s_typeDesc[REFL_INDEX_EULER_ANGLES] = TypeDesc(REFL_INDEX_EULER_ANGLES,  L"eulers",          sizeof(eulers),       NULL,      REFL_TEXT_FUNCS(REFL_INDEX_EULER_ANGLES,  float));
+    s_typeDesc[REFL_INDEX_VEC3        ] = TypeDesc(REFL_INDEX_VEC3,          L"vec3",            sizeof(vec3),         NULL,      REFL_TEXT_FUNCS(REFL_INDEX_VEC3,          float));
+    s_typeDesc[REFL_INDEX_VEC4        ] = TypeDesc(REFL_INDEX_VEC4,          L"vec4",            sizeof(vec4),         NULL,      REFL_TEXT_FUNCS(REFL_INDEX_VEC4,          float));
+    s_typeDesc[REFL_INDEX_QUATERNION  ] = TypeDesc(REFL_INDEX_QUATERNION,    L"quaternion",      sizeof(quaternion),   NULL,      REFL_TEXT_FUNCS(REFL_INDEX_QUATERNION,    float));
+
+};
+
+#ifndef GOLD
+//////////////////////////////////////////////////////
+//
+// Numeric batch conversion. Each pair of numeric types gets a strided loop,
+//  and the contiguous float32 and int32 cases that migrations hit most use
+//  SSE2. Whenever a float32 is involved the math is single precision, so 
+//  the vector and scalar loops give the same results.
+//
+
+enum ENumericType {
+    NUMERIC_INT8,
+    NUMERIC_UINT8,
+    NUMERIC_INT16,
+    NUMERIC_UINT16,
+    NUMERIC_INT32,
+    NUMERIC_UINT32,
+    NUMERIC_INT64,
+    NUMERIC_UINT64,
+    NUMERIC_FLOAT32,
+    NUMERIC_TYPES
+};
+
+typedef void (*NumericConvertFunc)(
+    const byte    * oldValues, 
+    unsigned        oldStride, 
+    byte          * newValues, 
+    unsigned        newStride, 
+    unsigned        count, 
+    float32         scale
+);
+
+template<typename t_type> 
+struct NumericLimits {
+};
+
+#define REFL_NUMERIC_LIMITS(type, minValue, maxValue, isFloat)             \
+    template<>                                                              \
+    struct NumericLimits<type> {                                            \
+        static type Min() {                                                 \
+            return minValue;                                                \
+        }                                                                   \
+        static type Max() {                                                 \
+            return maxValue;                                                \
+        }                                                                   \
+        static const bool s_float = isFloat;                                \
+    }
+
+REFL_NUMERIC_LIMITS(int8,       -128,                           127,                        false);
+REFL_NUMERIC_LIMITS(uint8,      0,                              255,                        false);
+REFL_NUMERIC_LIMITS(int16,      -32768,                         32767,                      false);
+REFL_NUMERIC_LIMITS(uint16,     0,                              65535,                      false);
+REFL_NUMERIC_LIMITS(int32,      -2147483647 - 1,                2147483647,                 false);
+REFL_NUMERIC_LIMITS(uint32,     0,                              0xffffffffU,                false);
+REFL_NUMERIC_LIMITS(int64,      -9223372036854775807LL - 1,     9223372036854775807LL,      false);
+REFL_NUMERIC_LIMITS(uint64,     0,                              0xffffffffffffffffULL,      false);
+REFL_NUMERIC_LIMITS(float32,    -3.402823466e+38f,              3.402823466e+38f,           true);
 
 //====================================================
-template<EReflIndex t_reflType, typename t_dataType>
-void ConvertFromString(const ReflMember * , byte * data, const chargr * format, const chargr * string, unsigned len) {
-    ASSERTMSGGR(format != NULL, "Need to handle this type via specialization");
-    StrReadValue(string, len, format, (t_dataType *) data);
+// Matches the default rounding of the SSE conversions
+static double RoundHalfEven(double value) {
+    double rounded = floor(value + 0.5);
+    if (rounded - value == 0.5 && fmod(rounded, 2.0) != 0.0) 
+        rounded -= 1.0;
+    return rounded;
 }
 
 //====================================================
-template<>
-void ConvertFromString<REFL_INDEX_BOOL, bool>(const ReflMember * , byte * data, const chargr * , const chargr * string, unsigned len) {
-    if (StrICmp(string, "true", 4) == 0) 
-        *((bool *) data) = true;
-    else
-        *((bool *) data) = false;
+template<typename t_to>
+static t_to SaturateDouble(double value) {
+    if (NumericLimits<t_to>::s_float) 
+        return static_cast<t_to>(value);
+
+    if (value != value) 
+        return 0;
+    value = RoundHalfEven(value);
+    if (value <= static_cast<double>(NumericLimits<t_to>::Min())) 
+        return NumericLimits<t_to>::Min();
+    if (value >= static_cast<double>(NumericLimits<t_to>::Max())) 
+        return NumericLimits<t_to>::Max();
+    return static_cast<t_to>(value);
 }
 
 //====================================================
-template<>
-void ConvertFromString<REFL_INDEX_INT8, int8>(const ReflMember * , byte * data, const chargr * , const chargr * string, unsigned len) {
-    int value;
-    StrReadValue(string, len, L"%d", &value);
-    *(reinterpret_cast<int8 *>(data)) = value;
+template<typename t_to, typename t_from>
+static t_to SaturateInteger(t_from value) {
+    if (value < 0) {
+        int64 wide = static_cast<int64>(value);
+        if (wide < static_cast<int64>(NumericLimits<t_to>::Min())) 
+            return NumericLimits<t_to>::Min();
+        return static_cast<t_to>(wide);
+    }
+
+    uint64 wide = static_cast<uint64>(value);
+    if (wide > static_cast<uint64>(NumericLimits<t_to>::Max())) 
+        return NumericLimits<t_to>::Max();
+    return static_cast<t_to>(wide);
 }
 
 //====================================================
-template<>
-void ConvertFromString<REFL_INDEX_UINT8, uint8>(const ReflMember * , byte * data, const chargr * , const chargr * string, unsigned len) {
-    unsigned value;
-    StrReadValue(string, len, L"%u", &value);
-    *(reinterpret_cast<uint8 *>(data)) = value;
+template<typename t_to, typename t_from>
+static t_to ConvertNumericValue(t_from value, float32 scale) {
+    if (NumericLimits<t_from>::s_float || NumericLimits<t_to>::s_float) 
+        return SaturateDouble<t_to>(static_cast<float32>(value) * scale);
+    if (scale != 1.0f) 
+        return SaturateDouble<t_to>(static_cast<double>(value) * scale);
+    return SaturateInteger<t_to>(value);
 }
 
 //====================================================
-template<>
-void ConvertFromString<REFL_INDEX_ENUM, char>(const ReflMember * memberDesc, byte * data, const chargr * , const chargr * string, unsigned len) {
-    const ReflTypeDesc * enumDesc = ReflLibrary::GetClassDesc(memberDesc->TypeHash());
-    ASSERTMSGGR(enumDesc != NULL, "Unregistered enum type");
-    const ReflTypeDesc::EnumValue * enumValue = enumDesc->GetEnumValue(string, len);
-    if (enumValue != NULL) {
-        switch (memberDesc->GetSize()) {
-            case sizeof(char):
-                *reinterpret_cast<int8 *>(data) = static_cast<int8>(enumValue->value);
-                break;
-            case sizeof(short):
-                *reinterpret_cast<int16 *>(data) = static_cast<int16>(enumValue->value);
-                break;
-            case sizeof(int):
-                *reinterpret_cast<int32 *>(data) = static_cast<int32>(enumValue->value);
-                break;
-            case sizeof(int64):
-                *reinterpret_cast<int64 *>(data) = static_cast<int64>(enumValue->value);
-                break;
-        }
-    }
-    else {
-        ASSERTMSGGR(false, "Unregistered enum value");
+template<typename t_from, typename t_to>
+static void ConvertNumericValues(
+    const byte    * oldValues, 
+    unsigned        oldStride, 
+    byte          * newValues, 
+    unsigned        newStride, 
+    unsigned        count, 
+    float32         scale
+) {
+    for (unsigned i = 0; i < count; i++) {
+        t_from value = *reinterpret_cast<const t_from *>(oldValues);
+        *reinterpret_cast<t_to *>(newValues) = ConvertNumericValue<t_to>(value, scale);
+        oldValues += oldStride;
+        newValues += newStride;
     }
 }
 
+#define REFL_NUMERIC_ROW(from)                                              \
+    {                                                                       \
+        ConvertNumericValues<from, int8>,                                   \
+        ConvertNumericValues<from, uint8>,                                  \
+        ConvertNumericValues<from, int16>,                                  \
+        ConvertNumericValues<from, uint16>,                                 \
+        ConvertNumericValues<from, int32>,                                  \
+        ConvertNumericValues<from, uint32>,                                 \
+        ConvertNumericValues<from, int64>,                                  \
+        ConvertNumericValues<from, uint64>,                                 \
+        ConvertNumericValues<from, float32>                                 \
+    }
+
+static const unsigned s_numericSize[NUMERIC_TYPES] = { 1, 1, 2, 2, 4, 4, 8, 8, 4 };
+
+static const NumericConvertFunc s_numericConvert[NUMERIC_TYPES][NUMERIC_TYPES] = {
+    REFL_NUMERIC_ROW(int8),
+    REFL_NUMERIC_ROW(uint8),
+    REFL_NUMERIC_ROW(int16),
+    REFL_NUMERIC_ROW(uint16),
+    REFL_NUMERIC_ROW(int32),
+    REFL_NUMERIC_ROW(uint32),
+    REFL_NUMERIC_ROW(int64),
+    REFL_NUMERIC_ROW(uint64),
+    REFL_NUMERIC_ROW(float32),
+};
+
 //====================================================
-template<>
-void ConvertFromString<REFL_INDEX_PERCENTAGE, float>(const ReflMember * , byte * data, const chargr * , const chargr * string, unsigned len) {
-    float * fdata = (float *) data;
-    StrReadValue(string, len, L"%f", fdata);
-    *fdata /= 100.0f;
+// Angles and percentages are stored as float32
+static unsigned NumericTypeFromIndex(ReflIndex index) {
+    if (index >= REFL_INDEX_INT8 && index <= REFL_INDEX_UINT64) 
+        return NUMERIC_INT8 + (index - REFL_INDEX_INT8);
+    if (index == REFL_INDEX_FLOAT32 || index == REFL_INDEX_ANGLE || index == REFL_INDEX_PERCENTAGE) 
+        return NUMERIC_FLOAT32;
+    return NUMERIC_TYPES;
 }
 
 //====================================================
-template<>
-void ConvertFromString<REFL_INDEX_ANGLE, float>(const ReflMember * , byte * data, const chargr * , const chargr * string, unsigned len) {
-    float * fdata = (float *) data;
-    StrReadValue(string, len, L"%f", fdata);
-    *fdata = MathDegreesToRadians(*fdata);
+static unsigned NumericTypeFromHash(ReflHash typeHash) {
+    for (unsigned index = 0; index < REFL_INDEX_ENDTYPE; index++) {
+        if (s_typeDesc[index].typeHash == typeHash) 
+            return NumericTypeFromIndex(static_cast<ReflIndex>(index));
+    }
+    return NUMERIC_TYPES;
 }
 
+#ifdef REFL_SSE2
 //====================================================
-/*template<>
-void ConvertFromString<REFL_INDEX_CHAR>(byte * data, const chargr * string, unsigned len) {
-    swscanf(string, L"%c", (char *) data);
-}*/
+// Zeroes NaN lanes, which the scalar path converts to zero
+static inline __m128 MaskNaN(__m128 values) {
+    return _mm_and_ps(values, _mm_cmpeq_ps(values, values));
+}
 
 //====================================================
-void InitializeTypeTable() {
-    s_typeDesc[REFL_INDEX_BOOL        ] = TypeDesc(REFL_INDEX_BOOL,          L"bool",            sizeof(bool),         NULL,      &ConvertToString<REFL_INDEX_BOOL,           bool>, &ConvertFromString<REFL_INDEX_BOOL,           bool>);
-    s_typeDesc[REFL_INDEX_INT8        ] = TypeDesc(REFL_INDEX_INT8,          L"int8",            sizeof(int8),         NULL,      &ConvertToString<REFL_INDEX_INT8,           int8>, &ConvertFromString<REFL_INDEX_INT8,           int8>);
-    s_typeDesc[REFL_INDEX_UINT8       ] = TypeDesc(REFL_INDEX_UINT8,         L"uint8",           sizeof(uint8),        NULL,      &ConvertToString<REFL_INDEX_UINT8,         uint8>, &ConvertFromString<REFL_INDEX_UINT8,         uint8>);
-    s_typeDesc[REFL_INDEX_INT16       ] = TypeDesc(REFL_INDEX_INT16,         L"int16",           sizeof(int16),        L"%hd",    &ConvertToString<REFL_INDEX_INT16,         int16>, &ConvertFromString<REFL_INDEX_INT16,         int16>);
-    s_typeDesc[REFL_INDEX_UINT16      ] = TypeDesc(REFL_INDEX_UINT16,        L"uint16",          sizeof(uint16),       L"%hu",    &ConvertToString<REFL_INDEX_UINT16,       uint16>, &ConvertFromString<REFL_INDEX_UINT16,       uint16>);
-    s_typeDesc[REFL_INDEX_INT32       ] = TypeDesc(REFL_INDEX_INT32,         L"int32",           sizeof(int32),        L"%d",     &ConvertToString<REFL_INDEX_INT32,         int32>, &ConvertFromString<REFL_INDEX_INT32,         int32>);
-    s_typeDesc[REFL_INDEX_UINT32      ] = TypeDesc(REFL_INDEX_UINT32,        L"uint32",          sizeof(uint32),       L"%u",     &ConvertToString<REFL_INDEX_UINT32,       uint32>, &ConvertFromString<REFL_INDEX_UINT32,       uint32>);
-    s_typeDesc[REFL_INDEX_INT64       ] = TypeDesc(REFL_INDEX_INT64,         L"int64",           sizeof(int64),        L"%lld",   &ConvertToString<REFL_INDEX_INT64,         int64>, &ConvertFromString<REFL_INDEX_INT64,         int64>);
-    s_typeDesc[REFL_INDEX_UINT64      ] = TypeDesc(REFL_INDEX_UINT64,        L"uint64",          sizeof(uint64),       L"%llu",   &ConvertToString<REFL_INDEX_UINT64,       uint64>, &ConvertFromString<REFL_INDEX_UINT64,       uint64>);
-    s_typeDesc[REFL_INDEX_INT128      ] = TypeDesc(REFL_INDEX_INT128,        L"int128",          sizeof(int128),       NULL,      &ConvertToString<REFL_INDEX_INT128,       int128>, &ConvertFromString<REFL_INDEX_INT128,       int128>);
-    s_typeDesc[REFL_INDEX_UINT128     ] = TypeDesc(REFL_INDEX_UINT128,       L"uint128",         sizeof(uint128),      NULL,      &ConvertToString<REFL_INDEX_UINT128,     uint128>, &ConvertFromString<REFL_INDEX_UINT128,     uint128>);
-    s_typeDesc[REFL_INDEX_FLOAT16     ] = TypeDesc(REFL_INDEX_FLOAT16,       L"float16",         sizeof(float16),      L"%f",     &ConvertToString<REFL_INDEX_FLOAT16,       float>, &ConvertFromString<REFL_INDEX_FLOAT16,       float>);
-    s_typeDesc[REFL_INDEX_FLOAT32     ] = TypeDesc(REFL_INDEX_FLOAT32,       L"float32",         sizeof(float32),      L"%f",     &ConvertToString<REFL_INDEX_FLOAT32,       float>, &ConvertFromString<REFL_INDEX_FLOAT32,       float>);
-    s_typeDesc[REFL_INDEX_STRING      ] = TypeDesc(REFL_INDEX_STRING,        L"chargr *",        sizeof(chargr *),     L"%s",     &ConvertToString<REFL_INDEX_STRING, const chargr>, &ConvertFromString<REFL_INDEX_STRING, const chargr>);
-    s_typeDesc[REFL_INDEX_CLASS       ] = TypeDesc(REFL_INDEX_CLASS,         L"class",           0,                    NULL,      &ConvertToString<REFL_INDEX_CLASS,          char>, &ConvertFromString<REFL_INDEX_CLASS,          char>);
-    s_typeDesc[REFL_INDEX_ENUM        ] = TypeDesc(REFL_INDEX_ENUM,          L"enum",            sizeof(unsigned),     NULL,      &ConvertToString<REFL_INDEX_ENUM,           char>, &ConvertFromString<REFL_INDEX_ENUM,           char>);
-    s_typeDesc[REFL_INDEX_FIXED_ARRAY ] = TypeDesc(REFL_INDEX_FIXED_ARRAY,   L"fixedarray",      0,                    NULL,      &ConvertToString<REFL_INDEX_FIXED_ARRAY,    char>, &ConvertFromString<REFL_INDEX_FIXED_ARRAY,    char>);
-    s_typeDesc[REFL_INDEX_VAR_ARRAY   ] = TypeDesc(REFL_INDEX_VAR_ARRAY,     L"vararray",        0,                    NULL,      &ConvertToString<REFL_INDEX_VAR_ARRAY,      char>, &ConvertFromString<REFL_INDEX_VAR_ARRAY,      char>);
-    s_typeDesc[REFL_INDEX_POINTER     ] = TypeDesc(REFL_INDEX_POINTER,       L"pointer",         sizeof(void *),       NULL,      &ConvertToString<REFL_INDEX_POINTER,        char>, &ConvertFromString<REFL_INDEX_POINTER,        char>);
-    s_typeDesc[REFL_INDEX_COLOR       ] = TypeDesc(REFL_INDEX_COLOR,         L"color",           sizeof(color),        NULL,      &ConvertToString<REFL_INDEX_COLOR,          char>, &ConvertFromString<REFL_INDEX_COLOR,          char>);
-    s_typeDesc[REFL_INDEX_ANGLE       ] = TypeDesc(REFL_INDEX_ANGLE,         L"angle",           sizeof(angle),        NULL,      &ConvertToString<REFL_INDEX_ANGLE,         float>, &ConvertFromString<REFL_INDEX_ANGLE,         float>);
-    s_typeDesc[REFL_INDEX_PERCENTAGE  ] = TypeDesc(REFL_INDEX_PERCENTAGE,    L"percentage",      sizeof(percentage),   NULL,      &ConvertToString<REFL_INDEX_PERCENTAGE,    float>, &ConvertFromString<REFL_INDEX_PERCENTAGE,    float>);
-    s_typeDesc[REFL_INDEX_EULER_ANGLES] = TypeDesc(REFL_INDEX_EULER_ANGLES,  L"eulers",          sizeof(eulers),       NULL,      &ConvertToString<REFL_INDEX_EULER_ANGLES,  float>, &ConvertFromString<REFL_INDEX_EULER_ANGLES,  float>);
-    s_typeDesc[REFL_INDEX_VEC3        ] = TypeDesc(REFL_INDEX_VEC3,          L"vec3",            sizeof(vec3),         NULL,      &ConvertToString<REFL_INDEX_VEC3,          float>, &ConvertFromString<REFL_INDEX_VEC3,          float>);
-    s_typeDesc[REFL_INDEX_VEC4        ] = TypeDesc(REFL_INDEX_VEC4,          L"vec4",            sizeof(vec4),         NULL,      &ConvertToString<REFL_INDEX_VEC4,          float>, &ConvertFromString<REFL_INDEX_VEC4,          float>);
-    s_typeDesc[REFL_INDEX_QUATERNION  ] = TypeDesc(REFL_INDEX_QUATERNION,    L"quaternion",      sizeof(quaternion),   NULL,      &ConvertToString<REFL_INDEX_QUATERNION,    float>, &ConvertFromString<REFL_INDEX_QUATERNION,    float>);
+// Contiguous conversions, returns the number of values converted
+static unsigned ConvertNumericSSE2(
+    unsigned        from, 
+    unsigned        to, 
+    const byte    * oldValues, 
+    byte          * newValues, 
+    unsigned        count, 
+    float32         scale
+) {
+    const __m128 scales = _mm_set1_ps(scale);
+    unsigned i = 0;
+    if (from == NUMERIC_FLOAT32 && to == NUMERIC_FLOAT32) {
+        const float32 * src = reinterpret_cast<const float32 *>(oldValues);
+        float32 * dest      = reinterpret_cast<float32 *>(newValues);
+        for (; i + 4 <= count; i += 4) 
+            _mm_storeu_ps(dest + i, _mm_mul_ps(_mm_loadu_ps(src + i), scales));
+    }
+    else if (from == NUMERIC_INT32 && to == NUMERIC_FLOAT32) {
+        const int32 * src   = reinterpret_cast<const int32 *>(oldValues);
+        float32 * dest      = reinterpret_cast<float32 *>(newValues);
+        for (; i + 4 <= count; i += 4) {
+            __m128i values = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+            _mm_storeu_ps(dest + i, _mm_mul_ps(_mm_cvtepi32_ps(values), scales));
+        }
+    }
+    else if (from == NUMERIC_FLOAT32 && to == NUMERIC_INT32) {
+        // Out of range lanes convert to 0x80000000, flip the positive ones
+        const float32 * src = reinterpret_cast<const float32 *>(oldValues);
+        int32 * dest        = reinterpret_cast<int32 *>(newValues);
+        const __m128 limit  = _mm_set1_ps(2147483648.0f);
+        for (; i + 4 <= count; i += 4) {
+            __m128 values   = MaskNaN(_mm_mul_ps(_mm_loadu_ps(src + i), scales));
+            __m128i over    = _mm_castps_si128(_mm_cmpge_ps(values, limit));
+            __m128i result  = _mm_xor_si128(_mm_cvtps_epi32(values), over);
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dest + i), result);
+        }
+    }
+    else if (from == NUMERIC_FLOAT32 && to == NUMERIC_INT16) {
+        const float32 * src = reinterpret_cast<const float32 *>(oldValues);
+        int16 * dest        = reinterpret_cast<int16 *>(newValues);
+        const __m128 low    = _mm_set1_ps(-32768.0f);
+        const __m128 high   = _mm_set1_ps(32767.0f);
+        for (; i + 8 <= count; i += 8) {
+            __m128 values0  = MaskNaN(_mm_mul_ps(_mm_loadu_ps(src + i), scales));
+            __m128 values1  = MaskNaN(_mm_mul_ps(_mm_loadu_ps(src + i + 4), scales));
+            values0         = _mm_min_ps(_mm_max_ps(values0, low), high);
+            values1         = _mm_min_ps(_mm_max_ps(values1, low), high);
+            __m128i result  = _mm_packs_epi32(_mm_cvtps_epi32(values0), _mm_cvtps_epi32(values1));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dest + i), result);
+        }
+    }
+    else if (from == NUMERIC_INT16 && to == NUMERIC_INT32 && scale == 1.0f) {
+        const int16 * src   = reinterpret_cast<const int16 *>(oldValues);
+        int32 * dest        = reinterpret_cast<int32 *>(newValues);
+        for (; i + 8 <= count; i += 8) {
+            __m128i values  = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+            __m128i low     = _mm_srai_epi32(_mm_unpacklo_epi16(values, values), 16);
+            __m128i high    = _mm_srai_epi32(_mm_unpackhi_epi16(values, values), 16);
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dest + i), low);
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dest + i + 4), high);
+        }
+    }
 
-};
+    return i;
+}
+#endif
+#endif
 
 //////////////////////////////////////////////////////
 //
@@ -336,15 +2379,24 @@ ReflMember::ReflMember(
     unsigned        offset
 ) :
     m_nameHash(name),
+    m_typeHash(typeHash),
+    m_pointeeHash(),
+#ifndef GOLD
     m_name(name),
+#endif
     m_index(REFL_INDEX_ENDTYPE),
-    m_typeHash(typeHash),
     m_offset(offset),
     m_size(size),
     m_next(NULL),
+#ifndef GOLD
     m_convFunc(NULL),
+    m_batchConvFunc(NULL),
+    m_convScale(1.0f),
+#endif
     m_deprecated(false),
-    m_tempBinding(NULL)
+    m_bitSigned(false),
+    m_bitOffset(0),
+    m_bitWidth(0)
 {
     m_index = DetermineTypeIndex(typeHash);
 
@@ -353,17 +2405,68 @@ ReflMember::ReflMember(
         m_index = REFL_INDEX_CLASS;
     }
     else{
-        ASSERTMSGGR(size == s_typeDesc[m_index].typeSize, "Type size doesn't match for member: %s::%s", container->GetTypeName(), m_name);
+        ASSERTMSGGR(size == s_typeDesc[m_index].typeSize, "Type size doesn't match for member: %s::%s", container->GetTypeName(), Name());
     }
 
     container->RegisterMember(this);
 }
 
+//====================================================
+ReflMember::ReflMember(
+    ReflTypeDesc  * container,
+    ReflHash        typeHash,
+    const chargr  * name,
+    const byte    * layout,
+    unsigned        layoutSize,
+    bool            isSigned
+) :
+    m_nameHash(name),
+    m_typeHash(typeHash),
+    m_pointeeHash(),
+#ifndef GOLD
+    m_name(name),
+#endif
+    m_index(REFL_INDEX_BITFIELD),
+    m_offset(0),
+    m_size(0),
+    m_next(NULL),
+#ifndef GOLD
+    m_convFunc(NULL),
+    m_batchConvFunc(NULL),
+    m_convScale(1.0f),
+#endif
+    m_deprecated(false),
+    m_bitSigned(isSigned),
+    m_bitOffset(0),
+    m_bitWidth(0)
+{
+    // Make sure the type table is built before any member refers to it
+    DetermineTypeIndex(typeHash);
+
+    unsigned bit = 0;
+    while (bit < layoutSize * 8 && (layout[bit / 8] & (1 << (bit % 8))) == 0) 
+        bit++;
+    ASSERTMSGGR(bit < layoutSize * 8, "Bitfield member(%s::%s) has no bits", container->GetTypeName(), Name());
+
+    unsigned first = bit;
+    while (bit < layoutSize * 8 && (layout[bit / 8] & (1 << (bit % 8))) != 0) 
+        bit++;
+
+    m_offset    = first / 8;
+    m_bitOffset = static_cast<uint8>(first % 8);
+    m_bitWidth  = static_cast<uint8>(bit - first);
+    m_size      = (m_bitOffset + m_bitWidth + 7) / 8;
+    ASSERTMSGGR(m_bitWidth <= 64, "Bitfield member(%s::%s) is wider than 64 bits", container->GetTypeName(), Name());
+
+    container->RegisterMember(this);
+}
+
 //====================================================
 void ReflMember::AdjustOffset(unsigned offset) {
     m_offset -= offset;
 }
 
+#ifndef GOLD
 //====================================================
 bool ReflMember::ConvertClassMember(
     IStructuredTextStreamPtr    stream, 
@@ -375,19 +2478,17 @@ bool ReflMember::ConvertClassMember(
         return true;
 
     do {
-        chargr nodeName[64];
-        stream->ReadNodeName(nodeName, 64);
+        ReflHash nodeName;
+        stream->ReadNodeNameHash(&nodeName);
 
-        if (StrICmp(nodeName, L"DataMember", 10) == 0) {
-            chargr name[256];
-            EStreamError result = stream->ReadNodeAttribute(L"Name", 4, name, 256);
+        if (nodeName == s_dataMemberNode) {
+            ReflHash nameHash;
+            EStreamError result = stream->ReadNodeAttributeHash(s_nameAttribute, &nameHash);
             ASSERTMSGGR(result == STREAM_ERROR_OK, "Malformed XML file: %s. DetaMember(%s) node is missing Name attribute", stream->GetName(), m_name);
-            ReflHash nameHash(name);
 
-            chargr type[256];
-            result = stream->ReadNodeAttribute(L"Type", 4, type, 256);
+            ReflHash typeHash;
+            result = stream->ReadNodeAttributeHash(s_typeAttribute, &typeHash);
             ASSERTMSGGR(result == STREAM_ERROR_OK, "Malformed XML file: %s. DataMember(%s) node is missing Type attribute", stream->GetName(), m_name);
-            ReflHash typeHash(type);
 
             ReflIndex oldType = DetermineTypeIndex(typeHash);
             if (oldType == REFL_INDEX_ENDTYPE) 
@@ -395,7 +2496,7 @@ bool ReflMember::ConvertClassMember(
 
             ConvertDataMember(stream, nameHash, inst, oldType);
         }
-        else if (StrICmp(nodeName, L"BaseClass", 9) == 0) {
+        else if (nodeName == s_baseClassNode) {
             ConvertClassMember(stream, nameHash, inst, oldType);
         }
     } while (stream->ReadNextNode() != STREAM_ERROR_NODEDOESNTEXIST);
@@ -412,16 +2513,52 @@ bool ReflMember::ConvertDataMember(
     ReflClass                 * inst, 
     ReflIndex                   oldType
 ) const {
-    chargr value[256];
-    stream->ReadNodeValue(value, 256);
-    byte container[16];
+    StreamTextView value;
+    stream->ReadNodeValueView(&value);
+    byte container[s_maxConversionBytes];
     ASSERTMSGGR(sizeof(container) >= s_typeDesc[oldType].typeSize, "Array is too small");
-    s_typeDesc[oldType].fromString(this, container, s_typeDesc[oldType].format, value, 255);
+    s_typeDesc[oldType].FromView(this, container, value);
     m_convFunc(inst, nameHash, s_typeDesc[oldType].typeHash, container);
 
     return true;
 }
 
+//====================================================
+void ReflMember::ConvertValues(
+    ReflHash        oldType, 
+    const void    * oldValues, 
+    unsigned        oldStride, 
+    void          * newValues, 
+    unsigned        newStride, 
+    unsigned        count
+) const {
+    ASSERTMSGGR(m_batchConvFunc != NULL, "No batch conversion function registered for member(%s)", m_name);
+    m_batchConvFunc(this, oldType, oldValues, oldStride, newValues, newStride, count);
+}
+#endif
+
+
+//====================================================
+void ReflMember::Copy(const void * src, void * dest, unsigned offset) const {
+    if (m_deprecated) 
+        return;
+
+    const byte * srcMember  = reinterpret_cast<const byte *>(src) + m_offset + offset;
+    byte * destMember       = reinterpret_cast<byte *>(dest) + m_offset + offset;
+    if (m_index == REFL_INDEX_CLASS) {
+        const ReflTypeDesc * subClass = ReflLibrary::GetClassDesc(m_typeHash);
+        ASSERTMSGGR(subClass != NULL, "Unregistered class type for member: %s", Name());
+        subClass->CopyInst(srcMember, destMember);
+    }
+    else if (m_index == REFL_INDEX_BITFIELD) {
+        // Neighbouring bits may belong to unreflected fields
+        WriteBits(destMember, m_bitOffset, m_bitWidth, ReadBits(srcMember, m_bitOffset, m_bitWidth));
+    }
+    else 
+        memcpy(destMember, srcMember, m_size);
+}
+
+#ifndef GOLD
 //====================================================
 void ReflMember::Deserialize(
     IStructuredTextStreamPtr    stream, 
@@ -430,31 +2567,80 @@ void ReflMember::Deserialize(
     void                      * base, 
     unsigned                    offset
 ) const {
-    chargr type[256];
-    EStreamError result = stream->ReadNodeAttribute(L"Type", 4, type, 256);
+    ReflHash typeHash;
+    EStreamError result = stream->ReadNodeAttributeHash(s_typeAttribute, &typeHash);
     ASSERTMSGGR(result == STREAM_ERROR_OK, "Malformed XML File: %s. Member(%s) is missing Type attribute", stream->GetName(), m_name);
-    ReflHash typeHash(type);
 
     if (s_typeDesc[TypeIndex()].TypeMatches(typeHash, m_typeHash)) {
         if (m_index == REFL_INDEX_CLASS) {
             DeserializeClassMember(stream, base, offset);
         }
+        else if (m_index == REFL_INDEX_POINTER) {
+            if (m_deprecated) 
+                return;
+
+            StreamTextView value;
+            stream->ReadNodeValueView(&value);
+            uint32 id = s_nullObjectId;
+            if (!StreamViewEquals(value, "null")) {
+                chargr idStr[32];
+                StreamViewToCharGr(value, idStr, 32);
+                StrReadValue(idStr, 32, L"%u", &id);
+            }
+
+            void ** field = reinterpret_cast<void **>(reinterpret_cast<byte *>(base) + m_offset + offset);
+            if (s_graphReader != NULL) 
+                s_graphReader->ResolvePointer(field, id, m_pointeeHash);
+            else {
+                LOG(LOG_PRIORITY_WARN, "Pointer member(%S) read outside of an object graph load", m_name);
+                *field = NULL;
+            }
+        }
         else {
-            chargr value[256];
-            stream->ReadNodeValue(value, 256);
+            StreamTextView value;
+            stream->ReadNodeValueView(&value);
             byte * member = reinterpret_cast<byte *>(base);
             if (!m_deprecated) 
                 member += m_offset + offset;
             else {
-                ASSERTMSGGR(m_tempBinding != NULL, "No temp binding or conversion function supplied for deprecated member(%s)", m_name);
-                member = reinterpret_cast<byte *>(m_tempBinding);
+                void * binding = FindTempBinding(this);
+                ASSERTMSGGR(binding != NULL, "No temp binding or conversion function supplied for deprecated member(%s)", m_name);
+                member = reinterpret_cast<byte *>(binding);
             }
-            s_typeDesc[TypeIndex()].fromString(this, member, s_typeDesc[TypeIndex()].format, value, 256);
+            s_typeDesc[TypeIndex()].FromView(this, member, value);
+        }
+    }
+    else if (m_batchConvFunc != NULL) {
+        ReflIndex oldType = DetermineTypeIndex(typeHash);
+        if (oldType == REFL_INDEX_ENDTYPE || oldType == REFL_INDEX_CLASS) {
+            LOG(LOG_PRIORITY_INFO, "Skipping member(%s) that can't be batch converted", m_name);
+            return;
         }
+        if (s_loadReport != NULL) 
+            s_loadReport->convertedMembers++;
+        REFL_TELEMETRY_COUNT_CURRENT(TELEMETRY_CONVERSIONS, 1);
+
+        StreamTextView value;
+        stream->ReadNodeValueView(&value);
+        byte container[s_maxConversionBytes];
+        ASSERTMSGGR(sizeof(container) >= s_typeDesc[oldType].typeSize, "Array is too small");
+        s_typeDesc[oldType].FromView(this, container, value);
+
+        // Deprecated members only have storage while their binding is set
+        byte * field = reinterpret_cast<byte *>(base) + m_offset + offset;
+        if (m_deprecated) 
+            field = reinterpret_cast<byte *>(FindTempBinding(this));
+        if (s_graphReader != NULL && !m_deprecated) 
+            s_graphReader->DeferConversion(this, typeHash, container, field);
+        else if (field != NULL) 
+            m_batchConvFunc(this, typeHash, container, 0, field, 0, 1);
     }
     else if (m_convFunc != NULL) {
         ReflIndex oldType = DetermineTypeIndex(typeHash);
         ASSERTMSGGR(oldType != REFL_INDEX_ENDTYPE, "Trying to convert from unsupported type");
+        if (s_loadReport != NULL) 
+            s_loadReport->convertedMembers++;
+        REFL_TELEMETRY_COUNT_CURRENT(TELEMETRY_CONVERSIONS, 1);
 
         if (oldType == REFL_INDEX_CLASS) {
             if (stream->ReadChildNode() == STREAM_ERROR_NODEDOESNTEXIST) 
@@ -476,16 +2662,16 @@ bool ReflMember::DeserializeClassMember(IStructuredTextStreamPtr stream, void *
             ASSERTMSGGR(false, "Malformed XML file: %s. DataMember node of type Class(%s) is missing", stream->GetName(), m_name);
             return true;
         }
-        chargr nodeName[64];
-        stream->ReadNodeName(nodeName, 64);
-        if (StrICmp(nodeName, L"Class", 5) != 0) {
+        ReflHash nodeName;
+        stream->ReadNodeNameHash(&nodeName);
+        if (nodeName != s_classNode) {
             ASSERTMSGGR(false, "Malformed XML file: %s. DataMember node of type Class(%s) is not named Class", stream->GetName(), subClass->GetTypeName());
             return true;
         }
 
-        chargr typeName[256];
-        if (stream->ReadNodeAttribute(L"Type", 4, typeName, 256) == STREAM_ERROR_OK) {
-            if (ReflHash(typeName) == m_typeHash) 
+        ReflHash typeHash;
+        if (stream->ReadNodeAttributeHash(s_typeAttribute, &typeHash) == STREAM_ERROR_OK) {
+            if (typeHash == m_typeHash) 
                 subClass->Deserialize(stream, base, offset + m_offset);
         }
         else 
@@ -500,6 +2686,7 @@ bool ReflMember::DeserializeClassMember(IStructuredTextStreamPtr stream, void *
 
     return true;
 }
+#endif
 
 //====================================================
 ReflIndex ReflMember::DetermineTypeIndex(ReflHash typeHash) const {
@@ -524,10 +2711,86 @@ ReflIndex ReflMember::DetermineTypeIndex(ReflHash typeHash) const {
 void ReflMember::Finalize() {
     if (m_index == REFL_INDEX_CLASS) {
         const ReflTypeDesc * desc = ReflLibrary::GetClassDesc(m_typeHash);
-        ASSERTMSGGR(desc != NULL, "Unregistered class type for member: %s", m_name);
+        ASSERTMSGGR(desc != NULL, "Unregistered class type for member: %s", Name());
         if (desc->IsEnumType()) 
             m_index = REFL_INDEX_ENUM;
     }
+    else if (m_index == REFL_INDEX_POINTER) {
+        const ReflTypeDesc * desc = ReflLibrary::GetClassDesc(m_pointeeHash);
+        ASSERTMSGGR(desc != NULL, "Pointer member(%s) needs REFL_POINTER_MEMBER and a reflected target type", Name());
+    }
+}
+
+//====================================================
+void ReflMember::HashContents(ReflContentHasher * hasher, const void * base, unsigned offset) const {
+    if (m_deprecated) 
+        return;
+
+    uint32 nameHash = m_nameHash.GetValue();
+    hasher->Add(&nameHash, sizeof(nameHash));
+
+    const byte * member = reinterpret_cast<const byte *>(base) + m_offset + offset;
+    switch (m_index) {
+        case REFL_INDEX_CLASS: {
+            const ReflTypeDesc * subClass = ReflLibrary::GetClassDesc(m_typeHash);
+            ASSERTMSGGR(subClass != NULL, "Unregistered class type for member: %s", Name());
+            subClass->HashMembers(hasher, member, 0);
+            break;
+        }
+        case REFL_INDEX_BOOL: {
+            byte value = *reinterpret_cast<const bool *>(member) ? 1 : 0;
+            hasher->Add(&value, sizeof(value));
+            break;
+        }
+        case REFL_INDEX_ENUM: {
+            // Hash enums at a fixed width so storage size doesn't matter
+            int64 value = 0;
+            switch (m_size) {
+                case sizeof(int8):
+                    value = *reinterpret_cast<const int8 *>(member);
+                    break;
+                case sizeof(int16):
+                    value = *reinterpret_cast<const int16 *>(member);
+                    break;
+                case sizeof(int32):
+                    value = *reinterpret_cast<const int32 *>(member);
+                    break;
+                case sizeof(int64):
+                    value = *reinterpret_cast<const int64 *>(member);
+                    break;
+            }
+            hasher->Add(&value, sizeof(value));
+            break;
+        }
+        case REFL_INDEX_BITFIELD: {
+            int64 value = ReadBitfield(base, offset);
+            hasher->Add(&value, sizeof(value));
+            break;
+        }
+        case REFL_INDEX_POINTER: {
+            // Addresses change between loads, so targets hash by graph id
+            //  here and their contents are hashed after the root
+            uint32 id = hasher->AddObject(ReadPointer(base, offset));
+            hasher->Add(&id, sizeof(id));
+            break;
+        }
+        case REFL_INDEX_FLOAT32: {
+            // -0.0 and 0.0 serialize to the same value
+            float32 value = *reinterpret_cast<const float32 *>(member);
+            if (value == 0.0f) 
+                value = 0.0f;
+            hasher->Add(&value, sizeof(value));
+            break;
+        }
+        default:
+            hasher->Add(member, m_size);
+            break;
+    }
+}
+
+//====================================================
+bool ReflMember::IsBitfield() const {
+    return m_index == REFL_INDEX_BITFIELD;
 }
 
 //====================================================
@@ -535,17 +2798,78 @@ bool ReflMember::Matches(ReflHash hash) const {
     return m_nameHash == hash;
 }
 
+//====================================================
+int64 ReflMember::ReadBitfield(const void * base, unsigned offset) const {
+    ASSERTGR(m_index == REFL_INDEX_BITFIELD);
+    const byte * member = reinterpret_cast<const byte *>(base) + m_offset + offset;
+    uint64 value = ReadBits(member, m_bitOffset, m_bitWidth);
+    if (m_bitSigned && m_bitWidth < 64 && (value >> (m_bitWidth - 1)) != 0) 
+        value |= ~0ULL << m_bitWidth;
+    return static_cast<int64>(value);
+}
+
+//====================================================
+const ReflClass * ReflMember::ReadPointer(const void * base, unsigned offset) const {
+    ASSERTGR(m_index == REFL_INDEX_POINTER);
+    const byte * member = reinterpret_cast<const byte *>(base) + m_offset + offset;
+    void * target = *reinterpret_cast<void * const *>(member);
+    if (target == NULL) 
+        return NULL;
+
+    const ReflTypeDesc * pointeeDesc = ReflLibrary::GetClassDesc(m_pointeeHash);
+    return reinterpret_cast<const ReflClass *>(pointeeDesc->CastTo(target, m_pointeeHash, ReflClass::GetReflType()));
+}
+
+#ifndef GOLD
+//====================================================
+void ReflMember::ClearTempBinding() const {
+    for (unsigned i = 0; i < s_numTempBindings; i++) {
+        if (s_tempBindings[i].member == this) {
+            s_tempBindings[i] = s_tempBindings[--s_numTempBindings];
+            return;
+        }
+    }
+}
+
+//====================================================
+void ReflMember::RegisterTempBinding(void * data) const {
+    for (unsigned i = 0; i < s_numTempBindings; i++) {
+        if (s_tempBindings[i].member == this) {
+            s_tempBindings[i].data = data;
+            return;
+        }
+    }
+
+    ASSERTMSGGR(s_numTempBindings < s_maxTempBindings, "Too many temp bindings, member(%s)", m_name);
+    if (s_numTempBindings == s_maxTempBindings) 
+        return;
+
+    s_tempBindings[s_numTempBindings].member  = this;
+    s_tempBindings[s_numTempBindings].data    = data;
+    s_numTempBindings++;
+}
+
 //====================================================
 void ReflMember::RegisterConversionFunc(ReflConversionFunc func) {
     ASSERTMSGGR(m_convFunc == NULL, "Conversion fucntion already registered for member(%s)", m_name);
     m_convFunc = func;
 }
 
+//====================================================
+void ReflMember::RegisterBatchConversionFunc(ReflBatchConversionFunc func, float32 scale) {
+    ASSERTMSGGR(m_batchConvFunc == NULL, "Batch conversion function already registered for member(%s)", m_name);
+    ASSERTMSGGR(m_index != REFL_INDEX_CLASS && m_index != REFL_INDEX_BITFIELD, "Batch conversions need an addressable data member(%s)", m_name);
+    m_batchConvFunc = func;
+    m_convScale     = scale;
+}
+#endif
+
 //====================================================
 void ReflMember::SetNext(ReflMember * next) {
     m_next = next;
 }
 
+#ifndef GOLD
 //====================================================
 bool ReflMember::Serialize(
     IStructuredTextStreamPtr    stream, 
@@ -568,6 +2892,21 @@ bool ReflMember::Serialize(
             ASSERTMSGGR(false, "Unregistered type for member(%s)", Name());
         }
     }
+    else if (m_index == REFL_INDEX_POINTER) {
+        uint32 id = s_nullObjectId;
+        const ReflClass * target = ReadPointer(base, offset);
+        if (target != NULL && s_graphWriter != NULL) 
+            id = s_graphWriter->AddObject(target);
+        else if (target != NULL) 
+            LOG(LOG_PRIORITY_WARN, "Pointer member(%S) written outside of an object graph save", m_name);
+
+        chargr value[32];
+        if (id == s_nullObjectId) 
+            StrPrintf(value, 32, L"null");
+        else
+            StrPrintf(value, 32, L"%u", id);
+        stream->WriteNodeValue(value);
+    }
     else {
         chargr value[1024];
         const byte * member = reinterpret_cast<const byte *>(base);
@@ -580,24 +2919,47 @@ bool ReflMember::Serialize(
     
     return true;
 }
+#endif
+
+//====================================================
+void ReflMember::SetPointeeType(ReflHash pointeeHash) {
+    ASSERTMSGGR(m_index == REFL_INDEX_POINTER, "Member(%s) isn't a pointer", Name());
+    m_pointeeHash = pointeeHash;
+}
+
+//====================================================
+void ReflMember::WriteBitfield(void * base, unsigned offset, int64 value) const {
+    ASSERTGR(m_index == REFL_INDEX_BITFIELD);
+    byte * member = reinterpret_cast<byte *>(base) + m_offset + offset;
+    WriteBits(member, m_bitOffset, m_bitWidth, static_cast<uint64>(value));
+}
 
 //====================================================
 ReflTypeDesc::ReflTypeDesc(
     const chargr  * name, 
     unsigned        size,
     unsigned        baseOffset,
-    unsigned        reflOffset,
-    ReflCreateFunc  creationFunc
+    unsigned            reflOffset,
+    ReflCreateFunc      creationFunc,
+    ReflDestroyFunc     destroyFunc,
+    ReflConstructFunc   constructFunc,
+    ReflDestructFunc    destructFunc
 ) :
+#ifndef GOLD
     m_typeName(name),
+    m_versioningFunc(NULL),
+#endif
     m_typeHash(name),
     m_version(1),
+    m_manualVersioning(false),
     m_size(size),
     m_baseOffset(baseOffset),
     m_reflOffset(reflOffset),
     m_creationFunc(creationFunc),
+    m_destroyFunc(destroyFunc),
+    m_constructFunc(constructFunc),
+    m_destructFunc(destructFunc),
     m_finalizeFunc(NULL),
-    m_versioningFunc(NULL),
     m_members(NULL),
     m_next(NULL),
     m_parents(NULL),
@@ -754,9 +3116,23 @@ const void * ReflTypeDesc::CastTo(const void * inst, ReflHash givenType, ReflHas
             ret = reinterpret_cast<const void *>(ptr + offset);
     }
 
-    return ret;
+    return ret;
+}
+
+//====================================================
+void * ReflTypeDesc::Clone(const void * src, MemFlags memFlags) const {
+    ASSERTMSGGR(m_creationFunc != NULL, "Type(%s) can't be instantiated", GetTypeName());
+
+    void * dest = Create(1, memFlags);
+    if (dest != NULL) {
+        CopyInst(src, dest);
+        FinalizeInst(dest);
+    }
+
+    return dest;
 }
 
+#ifndef GOLD
 //====================================================
 void ReflTypeDesc::ClearAllTempBindings() {
     ReflMember * member = m_members;
@@ -774,7 +3150,25 @@ void ReflTypeDesc::ClearTempBinding(ReflHash memberHash, ReflHash typeHash) {
         member->ClearTempBinding();
     }
 }
+#endif
+
+//====================================================
+void ReflTypeDesc::CopyInst(const void * src, void * dest) const {
+    CopyMembers(src, dest, 0);
+}
+
+//====================================================
+void ReflTypeDesc::CopyMembers(const void * src, void * dest, unsigned offset) const {
+    for (Parent * parent = m_parents; parent != NULL; parent = parent->next) {
+        const ReflTypeDesc * parentDesc = ReflLibrary::GetClassDesc(parent->parentHash);
+        parentDesc->CopyMembers(src, dest, offset + parent->baseOffset);
+    }
+
+    for (const ReflMember * member = m_members; member != NULL; member = member->GetNext()) 
+        member->Copy(src, dest, offset);
+}
 
+#ifndef GOLD
 //====================================================
 bool ReflTypeDesc::Deserialize(
     IStructuredTextStreamPtr    stream, 
@@ -789,14 +3183,24 @@ bool ReflTypeDesc::Deserialize(
     void                      * inst, 
     unsigned                    offset
 ) const {
-    chargr versionStr[32];
+    REFL_TELEMETRY_SCOPE(GetHash().GetValue(), TELEMETRY_LOAD_TICKS);
+    REFL_TELEMETRY_COUNT(GetHash().GetValue(), TELEMETRY_OBJECTS_LOADED, 1);
+
+    StreamTextView versionView;
     unsigned version = 0;
-    if (stream->ReadNodeAttribute(L"Version", 7, versionStr, 32) == STREAM_ERROR_OK) {
+    if (stream->ReadNodeAttributeView("Version", &versionView) == STREAM_ERROR_OK) {
+        chargr versionStr[32];
+        StreamViewToCharGr(versionView, versionStr, 32);
         StrReadValue(versionStr, 32, L"%x", &version);
     }
     else 
         ASSERTMSGGR(false, "Malformed XML file: %s. Class node(%s) is missing Version attribute", stream->GetName(), GetTypeName());
 
+    if (s_loadReport != NULL && version < m_version) 
+        s_loadReport->oldVersions++;
+    else if (s_loadReport != NULL && version > m_version) 
+        s_loadReport->newerVersions++;
+
     if (m_versioningFunc != NULL) {
         m_versioningFunc(stream, const_cast<ReflTypeDesc *>(this), version, CastToReflClass(inst));
     }
@@ -804,7 +3208,10 @@ bool ReflTypeDesc::Deserialize(
         DeserializeMembers(stream, inst, offset);
     }
 
-    FinalizeInst(inst);
+    if (m_finalizeFunc != NULL && s_graphReader != NULL) 
+        s_graphReader->DeferFinalize(this, inst);
+    else
+        FinalizeInst(inst);
 
     return true;
 }
@@ -827,18 +3234,27 @@ bool ReflTypeDesc::DeserializeMembers(
         return true;
 
     do {
-        chargr nodeName[64];
-        stream->ReadNodeName(nodeName, 64);
+        ReflHash nodeName;
+        stream->ReadNodeNameHash(&nodeName);
 
-        if (StrICmp(nodeName, L"DataMember", 10) == 0) {
+        if (nodeName == s_dataMemberNode) {
 
-            chargr name[256];
-            EStreamError result = stream->ReadNodeAttribute(L"Name", 4, name, 256);
+            ReflHash nameHash;
+            EStreamError result = stream->ReadNodeAttributeHash(s_nameAttribute, &nameHash);
             ASSERTMSGGR(result == STREAM_ERROR_OK, "Malformed XML file: %s. DataMember node is missing Name attribute", stream->GetName());
-            ReflHash nameHash(name);
             unsigned memberOffset = 0;
             const ReflMember * member = FindMember(nameHash, &memberOffset);
+            if (s_loadReport != NULL) {
+                if (member == NULL) 
+                    s_loadReport->unknownMembers++;
+                else if (member->IsDeprecated()) 
+                    s_loadReport->deprecatedMembers++;
+                else if (!member->Matches(nameHash)) 
+                    s_loadReport->aliasedMembers++;
+            }
             if (member != NULL) {
+                REFL_TELEMETRY_COUNT(GetHash().GetValue(), TELEMETRY_MEMBERS_LOADED, 1);
+                REFL_TELEMETRY_COUNT(GetHash().GetValue(), TELEMETRY_ALIAS_HITS, member->Matches(nameHash) ? 0 : 1);
                 member->Deserialize(
                     stream, 
                     nameHash,
@@ -848,19 +3264,22 @@ bool ReflTypeDesc::DeserializeMembers(
                 );
             }
         }
-        else if (StrICmp(nodeName, L"BaseClass", 9) == 0) {
-            chargr baseClassName[256];
-            EStreamError result = stream->ReadNodeAttribute(L"Type", 4, baseClassName, 256);
+        else if (nodeName == s_baseClassNode) {
+            ReflHash baseClassHash;
+            EStreamError result = stream->ReadNodeAttributeHash(s_typeAttribute, &baseClassHash);
             if (result == STREAM_ERROR_OK) {
-                const ReflTypeDesc * parentDesc = ReflLibrary::GetClassDesc(ReflHash(baseClassName));
+                const ReflTypeDesc * parentDesc = ReflLibrary::GetClassDesc(baseClassHash);
+                if (s_loadReport != NULL && parentDesc != NULL && parentDesc->GetHash() != baseClassHash) 
+                    s_loadReport->aliasedClasses++;
                 if (parentDesc != NULL) {
+                    REFL_TELEMETRY_COUNT(parentDesc->GetHash().GetValue(), TELEMETRY_ALIAS_HITS, parentDesc->GetHash() != baseClassHash ? 1 : 0);
                     Parent * parent = FindParent(parentDesc->GetHash());
                     if (parent != NULL) 
                         parentDesc->Deserialize(stream, inst, offset + parent->baseOffset);
                 }
             }
             else {
-                ASSERTMSGGR(result == STREAM_ERROR_OK, "Malformed XML file: %s. BaseClass node(%s) is missing Type attribute", stream->GetName(), baseClassName);
+                ASSERTMSGGR(result == STREAM_ERROR_OK, "Malformed XML file: %s. BaseClass node of %s is missing Type attribute", stream->GetName(), GetTypeName());
             }
         }
     } while (stream->ReadNextNode() != STREAM_ERROR_NODEDOESNTEXIST);
@@ -869,6 +3288,7 @@ bool ReflTypeDesc::DeserializeMembers(
 
     return true;
 }
+#endif
 
 //====================================================
 void ReflTypeDesc::Finalize() {
@@ -902,11 +3322,13 @@ void ReflTypeDesc::Finalize() {
     m_members = head;
 
     if (head != NULL) {
-        unsigned offset = head->GetOffset();
+        // Bitfields can share a byte, so compare bit positions
+        unsigned bit = head->GetOffset() * 8 + head->GetBitOffset();
         head = head->GetNext();
         for (; head != NULL; head = head->GetNext()) {
-            ASSERTMSGGR(offset < head->GetOffset() || head->IsDeprecated(), "Members are misordered");
-            offset = head->GetOffset();
+            unsigned nextBit = head->GetOffset() * 8 + head->GetBitOffset();
+            ASSERTMSGGR(bit < nextBit || head->IsDeprecated(), "Members are misordered");
+            bit = nextBit;
         }
     }
 
@@ -922,7 +3344,9 @@ void ReflTypeDesc::Finalize() {
 
     for (ReflMember * memb = m_members; memb != NULL; memb = memb->GetNext()) {
         for (ReflMember * comp = memb->GetNext(); comp != NULL; comp = comp->GetNext()) {
+#ifndef GOLD
             ASSERTMSGGR(StrCmp(memb->Name(), comp->Name(), 256) != 0, "Duplicate members");
+#endif
             ASSERTMSGGR(memb->NameHash() != comp->NameHash(), "Hash Collision");
         }
 
@@ -1002,6 +3426,41 @@ const ReflMember * ReflTypeDesc::FindMember(ReflHash nameHash, unsigned * offset
     return member;
 }
 
+//====================================================
+bool ReflTypeDesc::FindMemberIndex(ReflHash nameHash, unsigned * index) const {
+    ASSERTGR(index != NULL);
+    unsigned memberIndex = 0;
+    for (Parent * parent = m_parents; parent != NULL; parent = parent->next) {
+        const ReflTypeDesc * parentDesc = ReflLibrary::GetClassDesc(parent->parentHash);
+        ASSERTMSGGR(parentDesc != NULL, "Missing parent descriptor");
+        unsigned parentIndex = 0;
+        if (parentDesc->FindMemberIndex(nameHash, &parentIndex)) {
+            *index = memberIndex + parentIndex;
+            return true;
+        }
+        memberIndex += parentDesc->NumMembers();
+    }
+
+    if (FindLocalMember(nameHash) == NULL) {
+        for (ReflAlias * alias = m_memberAliases; alias != NULL; alias = alias->next) {
+            if (nameHash == alias->oldHash) {
+                nameHash = alias->newHash;
+                break;
+            }
+        }
+    }
+
+    for (const ReflMember * member = m_members; member != NULL; member = member->GetNext()) {
+        if (member->Matches(nameHash)) {
+            *index = memberIndex;
+            return true;
+        }
+        memberIndex++;
+    }
+
+    return false;
+}
+
 //====================================================
 const ReflMember * ReflTypeDesc::FindLocalMember(ReflHash nameHash) const {
     const ReflMember * member = m_members;
@@ -1068,6 +3527,7 @@ const ReflTypeDesc::EnumValue * ReflTypeDesc::GetEnumValue(int64 value) const {
     return val;
 }
 
+#ifndef GOLD
 //====================================================
 const ReflTypeDesc::EnumValue * ReflTypeDesc::GetEnumValue(const chargr * str, unsigned len) const {
     const EnumValue * val = m_enumValues;
@@ -1080,11 +3540,61 @@ const ReflTypeDesc::EnumValue * ReflTypeDesc::GetEnumValue(const chargr * str, u
 
     return val;
 }
+#endif
 
 //====================================================
 const ReflMember & ReflTypeDesc::GetMember(unsigned index) const {
-    TESTME("Implement me");
-    return m_members[0];
+    unsigned offset = 0;
+    const ReflMember * member = GetMember(index, &offset);
+    ASSERTMSGGR(member != NULL, "Member index(%d) out of range for type: %s", index, GetTypeName());
+    return *member;
+}
+
+//====================================================
+const ReflMember * ReflTypeDesc::GetMember(unsigned index, unsigned * offset) const {
+    ASSERTGR(offset != NULL);
+    *offset = 0;
+
+    // Members are indexed in finalized order, parents first
+    for (Parent * parent = m_parents; parent != NULL; parent = parent->next) {
+        const ReflTypeDesc * parentDesc = ReflLibrary::GetClassDesc(parent->parentHash);
+        ASSERTMSGGR(parentDesc != NULL, "Missing parent descriptor");
+        unsigned parentCount = parentDesc->NumMembers();
+        if (index < parentCount) {
+            const ReflMember * member = parentDesc->GetMember(index, offset);
+            *offset += parent->baseOffset;
+            return member;
+        }
+        index -= parentCount;
+    }
+
+    const ReflMember * member = m_members;
+    for (; member != NULL && index > 0; member = member->GetNext()) 
+        index--;
+
+    return member;
+}
+
+//====================================================
+Hash64 ReflTypeDesc::HashContents(const void * inst) const {
+    ReflContentHasher hasher;
+    HashGraph(&hasher, this, inst);
+
+    return hasher.GetHash();
+}
+
+//====================================================
+void ReflTypeDesc::HashMembers(ReflContentHasher * hasher, const void * base, unsigned offset) const {
+    uint32 typeHash = m_typeHash.GetValue();
+    hasher->Add(&typeHash, sizeof(typeHash));
+
+    for (Parent * parent = m_parents; parent != NULL; parent = parent->next) {
+        const ReflTypeDesc * parentDesc = ReflLibrary::GetClassDesc(parent->parentHash);
+        parentDesc->HashMembers(hasher, base, offset + parent->baseOffset);
+    }
+
+    for (const ReflMember * member = m_members; member != NULL; member = member->GetNext()) 
+        member->HashContents(hasher, base, offset);
 }
 
 //====================================================
@@ -1110,7 +3620,6 @@ bool ReflTypeDesc::IsEnumType() const {
 
 //====================================================
 unsigned ReflTypeDesc::NumMembers() const {
-    TESTME("Implement me");
     unsigned memberCount = 0;
 
     const ReflTypeDesc::Parent * parent = m_parents;
@@ -1144,10 +3653,13 @@ void ReflTypeDesc::RegisterFinalizationFunc(ReflFinalizationFunc func) {
 
 //====================================================
 void ReflTypeDesc::RegisterManualVersioningFunc(ReflVersioningFunc func, unsigned currentVersion) {
-    ASSERTGR(m_versioningFunc == NULL);
+    ASSERTGR(!m_manualVersioning);
+#ifndef GOLD
     m_versioningFunc = func;
+#endif
 
-    m_version = currentVersion;
+    m_manualVersioning  = true;
+    m_version           = currentVersion;
 }
 
 //====================================================
@@ -1162,6 +3674,7 @@ void ReflTypeDesc::RegisterMember(ReflMember * member) {
     m_members = member;
 }
 
+#ifndef GOLD
 //====================================================
 bool ReflTypeDesc::RegisterTempBinding(ReflHash memberHash, ReflHash typeHash, void * data) {
     bool bound = false;
@@ -1197,6 +3710,7 @@ bool ReflTypeDesc::SerializeMembers(
     const ReflMember * member = m_members;
     while(member != NULL) {
         member->Serialize(stream, inst, base, offset);
+        REFL_TELEMETRY_COUNT(GetHash().GetValue(), TELEMETRY_MEMBERS_SAVED, 1);
 
         member = member->GetNext();
     }
@@ -1210,6 +3724,9 @@ bool ReflTypeDesc::Serialize(
     const ReflClass           * inst, 
     unsigned                    offset
 ) const {
+    REFL_TELEMETRY_SCOPE(GetHash().GetValue(), TELEMETRY_SAVE_TICKS);
+    REFL_TELEMETRY_COUNT(GetHash().GetValue(), TELEMETRY_OBJECTS_SAVED, 1);
+
     stream->WriteNode(L"Class");
     stream->WriteNodeAttribute(L"Type", this->m_typeName);
     chargr versionStr[32];
@@ -1222,6 +3739,7 @@ bool ReflTypeDesc::Serialize(
 
     return true;
 }
+#endif
 
 //====================================================
 void ReflTypeDesc::SetNext(ReflTypeDesc * next) {
@@ -1241,6 +3759,39 @@ ReflClass::ReflClass() :
 // External Functions
 //
 
+#ifndef GOLD
+//====================================================
+void ReflConvertNumeric(
+    const ReflMember  * member, 
+    ReflHash            oldType, 
+    const void        * oldValues, 
+    unsigned            oldStride, 
+    void              * newValues, 
+    unsigned            newStride, 
+    unsigned            count
+) {
+    unsigned from   = NumericTypeFromHash(oldType);
+    unsigned to     = NumericTypeFromIndex(member->TypeIndex());
+    if (from == NUMERIC_TYPES || to == NUMERIC_TYPES) {
+        LOG(LOG_PRIORITY_INFO, "Skipping numeric conversion of member(%s) from type(%x)", member->Name(), oldType.GetValue());
+        return;
+    }
+
+    const byte * src    = reinterpret_cast<const byte *>(oldValues);
+    byte * dest         = reinterpret_cast<byte *>(newValues);
+    float32 scale       = member->GetConversionScale();
+#ifdef REFL_SSE2
+    if (oldStride == s_numericSize[from] && newStride == s_numericSize[to]) {
+        unsigned converted = ConvertNumericSSE2(from, to, src, dest, count, scale);
+        src     += converted * oldStride;
+        dest    += converted * newStride;
+        count   -= converted;
+    }
+#endif
+    s_numericConvert[from][to](src, oldStride, dest, newStride, count, scale);
+}
+#endif
+
 //====================================================
 void * ReflCanCastTo(ReflClass * inst, ReflHash actualType, ReflHash givenType, ReflHash targetType) {
     void * ret = NULL;
@@ -1264,13 +3815,17 @@ const void * ReflCanCastTo(const ReflClass * inst, ReflHash actualType, ReflHash
 //====================================================
 void ReflInitialize() {
     LOG(LOG_PRIORITY_INFO, "Initializing Reflection Library");
+    LockRegistration();
+    ASSERTMSGGR(s_publishedMetadata == NULL, "Reflection is already initialized");
     for (ReflTypeDesc * desc = s_descHead; desc != NULL; desc = desc->GetNext()) {
         desc->Finalize();
     }
 
     for (ReflTypeDesc * desc = s_descHead; desc != NULL; desc = desc->GetNext()) {
         for (ReflTypeDesc * compare = desc->GetNext(); compare != NULL; compare = compare->GetNext()) {
+#ifndef GOLD
             ASSERTMSGGR(StrCmp(desc->GetTypeName(), compare->GetTypeName(), 256) != 0, "Duplicate class names: %s", desc->GetTypeName());
+#endif
             ASSERTMSGGR(desc->GetHash() != compare->GetHash(), "Hash conflict");
         }
 
@@ -1282,6 +3837,21 @@ void ReflInitialize() {
         const ReflTypeDesc * desc = ReflLibrary::GetClassDesc(alias->newHash);
         ASSERTMSGGR(desc != NULL, "Missing class for alias");
     }
+
+    PublishMetadata(BuildMetadata());
+    UnlockRegistration();
+
+    ReflMetadataStats stats;
+    ReflLibrary::GetMetadataStats(&stats);
+    LOG(
+        LOG_PRIORITY_INFO, 
+        "Reflection metadata: %u types, %u members, %u descriptor bytes, %u name bytes, %u table bytes",
+        stats.numTypes,
+        stats.numMembers,
+        stats.descBytes,
+        stats.nameBytes,
+        stats.tableBytes
+    );
 }
 
 //====================================================
@@ -1291,35 +3861,68 @@ void ReflInitType(void * inst, ReflHash type) {
         desc->InitInst(inst);
 }
 
+#ifndef GOLD
 //====================================================
 ReflClass * ReflLibrary::Deserialize(IStructuredTextStreamPtr stream, MemFlags memFlags) {
-    ReflClass * ret = NULL;
+    // Objects are identified by their position in the file
+    ReflGraphReader reader;
+    ReflGraphReader * prevReader = s_graphReader;
+    s_graphReader = &reader;
 
     do {
-        chargr nodeName[64];
-        stream->ReadNodeName(nodeName, 64);
-        if (StrICmp(nodeName, L"Class", 5) != 0) 
+        ReflHash nodeName;
+        stream->ReadNodeNameHash(&nodeName);
+        if (nodeName != s_classNode) 
             continue;
 
-        chargr typeName[256];
-        if (stream->ReadNodeAttribute(L"Type", 4, typeName, 256) == STREAM_ERROR_OK) {
-            const ReflTypeDesc * desc = GetClassDesc(ReflHash(typeName));
+        ReflHash typeHash;
+        if (stream->ReadNodeAttributeHash(s_typeAttribute, &typeHash) == STREAM_ERROR_OK) {
+            const ReflTypeDesc * desc = GetClassDesc(typeHash);
+            if (s_loadReport != NULL) {
+                if (desc == NULL) 
+                    s_loadReport->unknownClasses++;
+                else if (desc->GetHash() != typeHash) 
+                    s_loadReport->aliasedClasses++;
+            }
 
             if (desc != NULL) {
+                REFL_TELEMETRY_COUNT(desc->GetHash().GetValue(), TELEMETRY_ALIAS_HITS, desc->GetHash() != typeHash ? 1 : 0);
                 void * base = desc->Create(1, memFlags);
-
+                reader.AddObject(desc, base);
                 desc->Deserialize(stream, base, 0);
-                void * refl = desc->CastTo(base, desc->GetHash(), ReflClass::GetReflType());
-                ret = reinterpret_cast<ReflClass *>(refl);
-
+            }
+            else {
+                LOG(LOG_PRIORITY_INFO, "XML File %S contains unregistered class type", stream->GetName());
+                reader.AddObject(NULL, NULL);
             }
         }
         else {
-            ASSERTMSGGR(false, "Malformed XML file: %s. Class node(%s) is missing Type attribute", stream->GetName(), nodeName);
+            StreamTextView nodeView;
+            stream->ReadNodeNameView(&nodeView);
+            ASSERTMSGGR(false, "Malformed XML file: %s. Class node(%.*s) is missing Type attribute", stream->GetName(), nodeView.len, nodeView.str);
         }
     } while (stream->ReadNextNode() != STREAM_ERROR_NODEDOESNTEXIST);
 
     stream->ReadParentNode();
+
+    reader.Finish();
+    s_graphReader = prevReader;
+
+    ReflClass * ret = NULL;
+    if (reader.NumObjects() > 0) 
+        ret = reader.GetObject(0);
+    return ret;
+}
+
+//====================================================
+ReflClass * ReflLibrary::Deserialize(IStructuredTextStreamPtr stream, MemFlags memFlags, ReflLoadReport * report) {
+    memset(report, 0, sizeof(*report));
+    ReflLoadReport * prevReport = s_loadReport;
+    s_loadReport = report;
+
+    ReflClass * ret = Deserialize(stream, memFlags);
+
+    s_loadReport = prevReport;
     return ret;
 }
 
@@ -1329,10 +3932,210 @@ bool ReflLibrary::Deserialize(IStructuredTextStreamPtr stream, ReflClass * inst)
 
     return desc->Deserialize(stream, inst);
 }
+#endif
 
 //====================================================
-const ReflTypeDesc * ReflLibrary::GetClassDesc(ReflHash nameHash) {
-    const ReflTypeDesc * classDesc = s_descHead;
+ReflClass * ReflLibrary::Deserialize(DataStream * stream, MemFlags memFlags) {
+    uint32 magic       = 0;
+    uint32 version     = 0;
+    uint32 numObjects  = 0;
+    stream->Read(magic);
+    stream->Read(version);
+    if (magic != s_binaryMagic || version != s_binaryVersion) {
+        LOG(LOG_PRIORITY_WARN, "Unsupported binary reflection file, version %u", version);
+        return NULL;
+    }
+    if (stream->Read(numObjects) != STREAM_ERROR_OK || numObjects == 0) 
+        return NULL;
+    MetadataScope scope;
+    ASSERTMSGGR(s_metadata != NULL, "Binary loads need ReflInitialize");
+
+    // Size every object from the type table so they all fit in one block. 
+    //  The table grows as it's read, so a corrupt count runs out of file 
+    //  before it runs out of memory.
+    uint64 tableSize = static_cast<uint64>(numObjects) * sizeof(BatchObject) + sizeof(BatchHeader);
+    if (tableSize > s_maxBatchBytes) {
+        LOG(LOG_PRIORITY_WARN, "Binary file has too many objects, %u", numObjects);
+        return NULL;
+    }
+
+    uint32 * types          = NULL;
+    unsigned typesCapacity  = 0;
+    unsigned dataOffset     = AlignBatch(static_cast<unsigned>(tableSize));
+    uint64 blockSize        = dataOffset;
+    bool validTable         = true;
+    for (unsigned i = 0; i < numObjects && validTable; i++) {
+        uint32 typeHash = 0;
+        if (stream->Read(typeHash) != STREAM_ERROR_OK) {
+            validTable = false;
+            break;
+        }
+
+        GrowArray(&types, &typesCapacity, i);
+        types[i] = FindMetadataType(typeHash);
+        if (types[i] != s_invalidMetadataIndex) 
+            blockSize += AlignBatch(s_metadata->typeDesc[types[i]]->GetSize());
+        else
+            LOG(LOG_PRIORITY_INFO, "Binary file contains unregistered class type %x", typeHash);
+        validTable = blockSize <= s_maxBatchBytes;
+    }
+
+    if (!validTable || types[0] == s_invalidMetadataIndex) {
+        if (!validTable) 
+            LOG(LOG_PRIORITY_WARN, "Binary file object table is truncated or too large");
+        if (types != NULL) 
+            delete [] types;
+        return NULL;
+    }
+
+    byte * block = new(memFlags) byte[static_cast<unsigned>(blockSize)];
+    BatchObject * objects   = reinterpret_cast<BatchObject *>(block);
+    BatchHeader * header    = reinterpret_cast<BatchHeader *>(block + dataOffset - sizeof(BatchHeader));
+    header->magic       = s_batchMagic;
+    header->numObjects  = numObjects;
+    header->objects     = objects;
+
+    ReflGraphReader reader;
+    unsigned offset = dataOffset;
+    for (unsigned i = 0; i < numObjects; i++) {
+        const ReflTypeDesc * desc = NULL;
+        if (types[i] != s_invalidMetadataIndex) 
+            desc = s_metadata->typeDesc[types[i]];
+
+        objects[i].desc     = desc;
+        objects[i].offset   = offset;
+        if (desc != NULL) {
+            desc->Construct(block + offset);
+            reader.AddObject(desc, block + offset);
+            offset += AlignBatch(desc->GetSize());
+        }
+        else
+            reader.AddObject(NULL, NULL);
+    }
+
+    // Every object exists, so references resolve as they're read. Blocks
+    //  that don't match are skipped, but running out of file fails the load.
+    bool truncated = false;
+    for (unsigned i = 0; i < numObjects && !truncated; i++) {
+        uint32 typeHash = 0;
+        uint32 size     = 0;
+        stream->Read(typeHash);
+        stream->Read(version);
+        if (stream->Read(size) != STREAM_ERROR_OK) 
+            truncated = true;
+        else if (types[i] != s_invalidMetadataIndex) 
+            ReadMetadataBlockContents(stream, &reader, types[i], block + objects[i].offset, typeHash, version, size);
+        else
+            truncated = stream->Skip(size) != STREAM_ERROR_OK;
+    }
+    delete [] types;
+
+    if (truncated) {
+        LOG(LOG_PRIORITY_WARN, "Binary file is truncated");
+        DestroyBatchBlock(header);
+        return NULL;
+    }
+
+    reader.Finish();
+
+    return reader.GetObject(0);
+}
+
+#ifndef GOLD
+//====================================================
+const ReflClass * ReflLibrary::DeserializeShared(IStructuredTextStreamPtr stream, MemFlags memFlags) {
+    ReflClass * inst = Deserialize(stream, memFlags);
+    if (inst == NULL) 
+        return NULL;
+
+    if ((s_sharedCount + 1) * 4 > s_sharedCapacity * 3) 
+        GrowSharedTable();
+
+    const ReflTypeDesc * desc = GetClassDesc(inst);
+    ReflContentHasher contents;
+    contents.KeepContents();
+    HashGraph(&contents, desc, CastToObjectBase(inst, desc));
+
+    Hash64 contentHash  = contents.GetHash();
+    unsigned slot       = FindSharedSlot(contentHash, contents);
+    SharedInstance & entry = s_sharedInstances[slot];
+    if (entry.inst != NULL) {
+        DestroyGraph(inst);
+        entry.refCount++;
+    }
+    else {
+        entry.contentHash   = contentHash;
+        entry.inst          = inst;
+        entry.refCount      = 1;
+        s_sharedCount++;
+    }
+
+    return entry.inst;
+}
+#endif
+
+//====================================================
+void ReflLibrary::DestroyBatch(ReflClass * root) {
+    if (root == NULL) 
+        return;
+
+    const ReflTypeDesc * desc = GetClassDesc(root);
+    byte * base = reinterpret_cast<byte *>(CastToObjectBase(root, desc));
+    BatchHeader * header = reinterpret_cast<BatchHeader *>(base - sizeof(BatchHeader));
+    ASSERTMSGGR(header->magic == s_batchMagic, "Destroying an object that wasn't loaded from a binary file");
+    if (header->magic != s_batchMagic) 
+        return;
+
+    DestroyBatchBlock(header);
+}
+
+//====================================================
+void ReflLibrary::DestroyGraph(ReflClass * root) {
+    if (root == NULL) 
+        return;
+
+    MetadataScope scope;
+    ASSERTMSGGR(s_metadata != NULL, "Destroying graphs needs ReflInitialize");
+
+    ReflGraphWriter writer;
+    writer.AddObject(root);
+    for (unsigned id = 0; id < writer.NumObjects(); id++) {
+        const ReflClass * object = writer.GetObject(id);
+        unsigned type = FindMetadataType(object->GetType().GetValue());
+        ASSERTMSGGR(type != s_invalidMetadataIndex, "Unregistered class type");
+        const byte * base = reinterpret_cast<const byte *>(CastToObjectBase(object, s_metadata->typeDesc[type]));
+        GatherMetadataPointers(&writer, type, base);
+    }
+
+    // Everything is gathered before the first object goes away
+    for (unsigned id = writer.NumObjects(); id > 0; id--) 
+        DestroyInst(const_cast<ReflClass *>(writer.GetObject(id - 1)));
+}
+
+#ifndef GOLD
+//====================================================
+bool ReflLibrary::ExportSchema(IStructuredTextStreamPtr stream) {
+    MetadataScope scope;
+    ASSERTMSGGR(s_metadata != NULL, "Schema export needs ReflInitialize");
+
+    stream->WriteNode(L"Schema");
+    WriteSchemaValue(stream, L"Version", s_schemaVersion);
+    WriteSchemaHash(stream, L"BinaryMagic", s_binaryMagic);
+    WriteSchemaValue(stream, L"BinaryVersion", s_binaryVersion);
+    WriteSchemaHash(stream, L"NullObject", s_nullObjectId);
+    WriteSchemaHash(stream, L"BitfieldName", s_bitfieldRecordName.GetValue());
+    WriteSchemaHash(stream, L"BitfieldType", ReflTypeBitfield.GetValue());
+
+    for (unsigned type = 0; type < s_metadata->numTypes; type++) 
+        ExportSchemaType(stream, type);
+
+    return stream->EndNode() == STREAM_ERROR_OK;
+}
+#endif
+
+//====================================================
+static const ReflTypeDesc * FindRegisteredDesc(const ReflTypeDesc * descHead, const ReflAlias * aliasHead, ReflHash nameHash) {
+    const ReflTypeDesc * classDesc = descHead;
     while(classDesc != NULL) {
         if (classDesc->NameMatches(nameHash))
             break;
@@ -1340,10 +4143,10 @@ const ReflTypeDesc * ReflLibrary::GetClassDesc(ReflHash nameHash) {
     }
 
     if (classDesc == NULL) {
-        const ReflAlias * alias = s_classAliasHead;
+        const ReflAlias * alias = aliasHead;
         for (; alias != NULL; alias = alias->next) {
             if (alias->oldHash == nameHash) {
-                classDesc = GetClassDesc(alias->newHash);
+                classDesc = ReflLibrary::GetClassDesc(alias->newHash);
                 break;
             }
         }
@@ -1351,27 +4154,524 @@ const ReflTypeDesc * ReflLibrary::GetClassDesc(ReflHash nameHash) {
     return classDesc;
 }
 
+//====================================================
+const ReflTypeDesc * ReflLibrary::GetClassDesc(ReflHash nameHash) {
+    MetadataScope scope;
+    if (s_metadata == NULL) 
+        return FindRegisteredDesc(s_descHead, s_classAliasHead, nameHash);
+
+    unsigned type = FindMetadataType(nameHash.GetValue());
+    if (type != s_invalidMetadataIndex) 
+        return s_metadata->typeDesc[type];
+
+    // The staging heads are thread local, so only the thread inside 
+    //  RegisterTypeBatch sees its batch before it's published
+    if (s_stagingDescHead != NULL || s_stagingAliasHead != NULL) 
+        return FindRegisteredDesc(s_stagingDescHead, s_stagingAliasHead, nameHash);
+
+    return NULL;
+}
+
 //====================================================
 const ReflTypeDesc * ReflLibrary::GetClassDesc(const ReflClass * inst) {
     return GetClassDesc(inst->GetType());
 }
 
+//====================================================
+void ReflLibrary::GetMetadataStats(ReflMetadataStats * stats) {
+    MetadataScope scope;
+    memset(stats, 0, sizeof(*stats));
+    ASSERTMSGGR(s_metadata != NULL, "Metadata stats need ReflInitialize");
+
+    for (unsigned type = 0; type < s_metadata->numTypes; type++) {
+        const ReflTypeDesc * desc = s_metadata->typeDesc[type];
+        stats->numTypes++;
+        stats->descBytes += sizeof(ReflTypeDesc);
+        stats->nameBytes += NameBytes(desc->GetTypeName());
+
+        for (const ReflTypeDesc::Parent * parent = desc->GetParents(); parent != NULL; parent = parent->next) 
+            stats->descBytes += sizeof(ReflTypeDesc::Parent);
+
+        for (const ReflMember * member = desc->GetLocalMembers(); member != NULL; member = member->GetNext()) {
+            stats->numMembers++;
+            stats->descBytes += sizeof(ReflMember);
+            stats->nameBytes += NameBytes(member->Name());
+        }
+
+        for (const ReflAlias * alias = desc->GetMemberAliases(); alias != NULL; alias = alias->next) 
+            stats->descBytes += sizeof(ReflAlias);
+
+        for (const ReflTypeDesc::EnumValue * value = desc->GetEnumValues(); value != NULL; value = value->next) {
+            stats->numEnumValues++;
+            stats->descBytes += sizeof(ReflTypeDesc::EnumValue);
+            stats->nameBytes += NameBytes(value->name);
+        }
+    }
+
+    stats->descBytes += s_metadata->numClassAliases * sizeof(ReflAlias);
+    stats->descBytes += sizeof(MetadataTables);
+    stats->tableBytes = s_metadata->bytes;
+}
+
+//====================================================
+unsigned ReflLibrary::GetTelemetry(ReflTypeTelemetry * telemetry, unsigned maxTypes) {
+#ifdef REFL_TELEMETRY
+    // Tables of an older generation are cleared by their thread when it next counts
+    int32 generation    = s_telemetryGeneration;
+    unsigned numTypes   = 0;
+    for (const TelemetryTable * table = s_telemetryTables; table != NULL; table = table->next) {
+        if (table->generation != generation) 
+            continue;
+
+        for (unsigned index = 0; index < s_telemetrySlots; index++) {
+            const TelemetrySlot * slot = &table->slots[index];
+            if (slot->typeHash == 0) 
+                continue;
+
+            unsigned type = 0;
+            while (type < numTypes && telemetry[type].typeHash.GetValue() != slot->typeHash) 
+                type++;
+            if (type == maxTypes) 
+                continue;
+            if (type == numTypes) {
+                memset(&telemetry[type], 0, sizeof(telemetry[type]));
+                telemetry[type].typeHash = HashFromValue(slot->typeHash);
+                numTypes++;
+            }
+
+            ReflTypeTelemetry * dest = &telemetry[type];
+            dest->objectsLoaded     += slot->counters[TELEMETRY_OBJECTS_LOADED];
+            dest->objectsSaved      += slot->counters[TELEMETRY_OBJECTS_SAVED];
+            dest->membersLoaded     += slot->counters[TELEMETRY_MEMBERS_LOADED];
+            dest->membersSaved      += slot->counters[TELEMETRY_MEMBERS_SAVED];
+            dest->bytesLoaded       += slot->counters[TELEMETRY_BYTES_LOADED];
+            dest->bytesSaved        += slot->counters[TELEMETRY_BYTES_SAVED];
+            dest->conversions       += slot->counters[TELEMETRY_CONVERSIONS];
+            dest->aliasHits         += slot->counters[TELEMETRY_ALIAS_HITS];
+            dest->loadNanoseconds   += TimerTicksToNanoseconds(slot->counters[TELEMETRY_LOAD_TICKS]);
+            dest->saveNanoseconds   += TimerTicksToNanoseconds(slot->counters[TELEMETRY_SAVE_TICKS]);
+        }
+    }
+
+    qsort(telemetry, numTypes, sizeof(ReflTypeTelemetry), CompareTelemetryTime);
+    return numTypes;
+#else
+    return 0;
+#endif
+}
+
+//====================================================
+Hash64 ReflLibrary::HashContents(const ReflClass * inst) {
+    const ReflTypeDesc * desc = GetClassDesc(inst);
+    ASSERTMSGGR(desc != NULL, "Hashing an instance of an unregistered type");
+
+    ReflClass * refl = const_cast<ReflClass *>(inst);
+    return desc->HashContents(desc->CastTo(refl, ReflClass::GetReflType(), desc->GetHash()));
+}
+
+//====================================================
+unsigned ReflLibrary::NumSharedInstances() {
+    return s_sharedCount;
+}
+
+//====================================================
+void ReflLibrary::LogTelemetry() {
+#ifdef REFL_TELEMETRY
+    ReflTypeTelemetry * telemetry = new(REFL_TEMP_MEM_FLAGS) ReflTypeTelemetry[s_telemetrySlots];
+    unsigned numTypes = GetTelemetry(telemetry, s_telemetrySlots);
+    for (unsigned type = 0; type < numTypes; type++) {
+        const ReflTypeTelemetry & entry = telemetry[type];
+        const ReflTypeDesc * desc = GetClassDesc(entry.typeHash);
+        LOG(
+            LOG_PRIORITY_INFO,
+            "Reflection telemetry %x(%s): %llu/%llu objects, %llu/%llu members, %llu/%llu bytes, %llu conversions, %llu alias hits, %llu/%llu ns loading/saving",
+            entry.typeHash.GetValue(),
+            desc != NULL ? desc->GetTypeName() : L"",
+            entry.objectsLoaded,
+            entry.objectsSaved,
+            entry.membersLoaded,
+            entry.membersSaved,
+            entry.bytesLoaded,
+            entry.bytesSaved,
+            entry.conversions,
+            entry.aliasHits,
+            entry.loadNanoseconds,
+            entry.saveNanoseconds
+        );
+    }
+    delete [] telemetry;
+#endif
+}
+
 //====================================================
 void ReflLibrary::RegisterClassDesc(ReflTypeDesc * classDesc) {
-    classDesc->SetNext(s_descHead);
-    s_descHead = classDesc;
+    LockRegistration();
+    ReflTypeDesc ** head = s_publishedMetadata != NULL ? &s_pendingDescHead : &s_descHead;
+    classDesc->SetNext(*head);
+    *head = classDesc;
+    UnlockRegistration();
+}
+
+//====================================================
+ReflPrototype * ReflLibrary::FindPrototype(ReflHash nameHash) {
+    ReflPrototype * prototype = s_prototypeHead;
+    for (; prototype != NULL; prototype = prototype->GetNext()) {
+        if (prototype->GetNameHash() == nameHash) 
+            break;
+    }
+
+    return prototype;
 }
 
 //====================================================
 void ReflLibrary::RegisterDeprecatedClassDesc(ReflAlias * classDescAlias) {
-    classDescAlias->next = s_classAliasHead;
-    s_classAliasHead = classDescAlias;
+    LockRegistration();
+    ReflAlias ** head = s_publishedMetadata != NULL ? &s_pendingAliasHead : &s_classAliasHead;
+    classDescAlias->next = *head;
+    *head = classDescAlias;
+    UnlockRegistration();
+}
+
+//====================================================
+ReflTypeBatch * ReflLibrary::RegisterTypeBatch() {
+    LockRegistration();
+    ASSERTMSGGR(s_publishedMetadata != NULL, "Type batches need ReflInitialize");
+
+    // Finalizing resolves parents, which may live in the same batch
+    s_stagingDescHead  = s_pendingDescHead;
+    s_stagingAliasHead = s_pendingAliasHead;
+    s_pendingDescHead  = NULL;
+    s_pendingAliasHead = NULL;
+
+    ReflTypeBatch * batch = new(REFL_MEM_FLAGS) ReflTypeBatch;
+    memset(batch, 0, sizeof(*batch));
+    for (ReflTypeDesc * desc = s_stagingDescHead; desc != NULL; desc = desc->GetNext()) 
+        batch->numDescs++;
+    for (ReflAlias * alias = s_stagingAliasHead; alias != NULL; alias = alias->next) 
+        batch->numAliases++;
+
+    batch->descs   = new(REFL_MEM_FLAGS) ReflTypeDesc *[batch->numDescs];
+    batch->aliases = new(REFL_MEM_FLAGS) ReflAlias *[batch->numAliases];
+
+    unsigned index = 0;
+    for (ReflTypeDesc * desc = s_stagingDescHead; desc != NULL; desc = desc->GetNext()) {
+        desc->Finalize();
+        batch->descs[index++] = desc;
+    }
+
+    index = 0;
+    for (ReflAlias * alias = s_stagingAliasHead; alias != NULL; alias = alias->next) {
+        const ReflTypeDesc * desc = GetClassDesc(alias->newHash);
+        ASSERTMSGGR(desc != NULL, "Missing class for alias");
+        ASSERTMSGGR(GetClassDesc(alias->oldHash) == desc, "Alias conflicts with existing class");
+        batch->aliases[index++] = alias;
+    }
+
+    for (unsigned desc = 0; desc < batch->numDescs; desc++) {
+        ReflTypeDesc * typeDesc = batch->descs[desc];
+        ASSERTMSGGR(GetClassDesc(typeDesc->GetHash()) == typeDesc, "Hash conflict");
+        typeDesc->SetNext(s_descHead);
+        s_descHead = typeDesc;
+    }
+
+    for (unsigned alias = 0; alias < batch->numAliases; alias++) {
+        batch->aliases[alias]->next = s_classAliasHead;
+        s_classAliasHead = batch->aliases[alias];
+    }
+
+    s_stagingDescHead  = NULL;
+    s_stagingAliasHead = NULL;
+    PublishMetadata(BuildMetadata());
+    UnlockRegistration();
+
+    return batch;
+}
+
+//====================================================
+void ReflLibrary::UnregisterTypeBatch(ReflTypeBatch * batch) {
+    LockRegistration();
+
+    for (unsigned desc = 0; desc < batch->numDescs; desc++) {
+        ReflTypeDesc * typeDesc = batch->descs[desc];
+        if (s_descHead == typeDesc) {
+            s_descHead = typeDesc->GetNext();
+            continue;
+        }
+
+        ReflTypeDesc * prev = s_descHead;
+        while (prev->GetNext() != typeDesc) {
+            prev = prev->GetNext();
+            ASSERTMSGGR(prev != NULL, "Type batch was not registered");
+        }
+        prev->SetNext(typeDesc->GetNext());
+    }
+
+    for (unsigned alias = 0; alias < batch->numAliases; alias++) {
+        ReflAlias ** link = &s_classAliasHead;
+        while (*link != batch->aliases[alias]) {
+            ASSERTMSGGR(*link != NULL, "Type batch was not registered");
+            link = &(*link)->next;
+        }
+        *link = batch->aliases[alias]->next;
+    }
+
+    // Returns once no reader can still see the batch
+    PublishMetadata(BuildMetadata());
+    UnlockRegistration();
+
+    delete [] batch->descs;
+    delete [] batch->aliases;
+    delete batch;
+}
+
+//====================================================
+void ReflLibrary::RegisterPrototype(ReflPrototype * prototype) {
+    ASSERTMSGGR(FindPrototype(prototype->GetNameHash()) == NULL, "Duplicate prototype: %s", prototype->GetName());
+
+    // The library holds a reference until the prototype is unregistered
+    prototype->AddRef();
+    prototype->SetNext(s_prototypeHead);
+    s_prototypeHead = prototype;
+}
+
+//====================================================
+void ReflLibrary::ResetTelemetry() {
+#ifdef REFL_TELEMETRY
+    AtomicIncrement(&s_telemetryGeneration);
+#endif
 }
 
+//====================================================
+void ReflLibrary::ReleaseShared(const ReflClass * inst) {
+    if (inst == NULL || s_sharedCount == 0) 
+        return;
+
+    // Shared instances are immutable, so the hash still finds where their
+    //  probe starts
+    unsigned slot = FindSharedSlot(HashContents(inst), inst);
+    SharedInstance & entry = s_sharedInstances[slot];
+    ASSERTMSGGR(entry.inst == inst, "Releasing an instance that isn't shared");
+    if (entry.inst != inst) 
+        return;
+
+    ASSERTGR(entry.refCount > 0);
+    entry.refCount--;
+    if (entry.refCount == 0) {
+        ReflClass * shared = entry.inst;
+        RemoveSharedSlot(slot);
+        DestroyGraph(shared);
+    }
+}
+
+#ifndef GOLD
 //====================================================
 bool ReflLibrary::Serialize(IStructuredTextStreamPtr stream, const ReflClass * inst) {
-    const ReflTypeDesc * desc = GetClassDesc(inst);
+    ReflGraphWriter writer;
+    ReflGraphWriter * prevWriter = s_graphWriter;
+    s_graphWriter = &writer;
+
+    // Objects referenced while writing get the next id and are written after
+    writer.AddObject(inst);
+    bool result = true;
+    for (unsigned id = 0; id < writer.NumObjects() && result; id++) {
+        const ReflClass * object = writer.GetObject(id);
+        const ReflTypeDesc * desc = GetClassDesc(object);
+        result = desc->Serialize(stream, object);
+    }
+
+    s_graphWriter = prevWriter;
+    return result;
+}
+#endif
+
+//====================================================
+bool ReflLibrary::Serialize(DataStream * stream, const ReflClass * inst) {
+    MetadataScope scope;
+    ASSERTMSGGR(s_metadata != NULL, "Binary saves need ReflInitialize");
+
+    // The object table comes first, so gather the whole graph up front
+    ReflGraphWriter writer;
+    writer.AddObject(inst);
+    for (unsigned id = 0; id < writer.NumObjects(); id++) {
+        const ReflClass * object = writer.GetObject(id);
+        unsigned type = FindMetadataType(object->GetType().GetValue());
+        ASSERTMSGGR(type != s_invalidMetadataIndex, "Unregistered class type");
+        const byte * base = reinterpret_cast<const byte *>(CastToObjectBase(object, s_metadata->typeDesc[type]));
+        GatherMetadataPointers(&writer, type, base);
+    }
+
+    stream->Write<uint32>(s_binaryMagic);
+    stream->Write<uint32>(s_binaryVersion);
+    stream->Write<uint32>(writer.NumObjects());
+    for (unsigned id = 0; id < writer.NumObjects(); id++) 
+        stream->Write<uint32>(writer.GetObject(id)->GetType().GetValue());
+
+    bool result = true;
+    for (unsigned id = 0; id < writer.NumObjects() && result; id++) {
+        const ReflClass * object = writer.GetObject(id);
+        unsigned type = FindMetadataType(object->GetType().GetValue());
+        const byte * base = reinterpret_cast<const byte *>(CastToObjectBase(object, s_metadata->typeDesc[type]));
+        result = WriteMetadataBlock(stream, &writer, type, base);
+    }
+
+    // Buffered streams only report write errors once flushed
+    return stream->Flush() == STREAM_ERROR_OK && result;
+}
+
+//====================================================
+bool ReflLibrary::SerializeChunked(IChunkWriterPtr writer, const ReflClass * const * roots, unsigned numRoots) {
+    MetadataScope scope;
+    ASSERTMSGGR(s_metadata != NULL, "Binary saves need ReflInitialize");
+
+    // Every class of every graph goes in the schema, along with the parents
+    //  and class members their records are made of
+    bool * used = new(REFL_TEMP_MEM_FLAGS) bool[s_metadata->numTypes];
+    memset(used, 0, s_metadata->numTypes * sizeof(bool));
+    for (unsigned root = 0; root < numRoots; root++) {
+        ReflGraphWriter graph;
+        graph.AddObject(roots[root]);
+        for (unsigned id = 0; id < graph.NumObjects(); id++) {
+            const ReflClass * object = graph.GetObject(id);
+            unsigned type = FindMetadataType(object->GetType().GetValue());
+            ASSERTMSGGR(type != s_invalidMetadataIndex, "Unregistered class type");
+            MarkSchemaType(used, type);
+            const byte * base = reinterpret_cast<const byte *>(CastToObjectBase(object, s_metadata->typeDesc[type]));
+            GatherMetadataPointers(&graph, type, base);
+        }
+    }
+
+    // Names come first so readers over streams have them for the schema
+    uint32 * nameOffsets = new(REFL_TEMP_MEM_FLAGS) uint32[s_metadata->numTypes];
+    uint32 numUsed = 0;
+    {
+        DataStream stream(writer->BeginChunk(REFL_CHUNK_STRINGS, s_chunkStringsVersion));
+        uint32 offset = 0;
+        for (unsigned type = 0; type < s_metadata->numTypes; type++) {
+            if (!used[type]) 
+                continue;
+
+            const chargr * name = s_metadata->typeDesc[type]->GetTypeName();
+            charsys * utf8 = StrCreateUtf8(name != NULL ? name : L"", REFL_TEMP_MEM_FLAGS);
+            unsigned len = strlen(utf8) + 1;
+            stream.WriteBytes(utf8, len);
+            delete [] utf8;
+
+            nameOffsets[type] = offset;
+            offset += len;
+            numUsed++;
+        }
+    }
+    {
+        DataStream stream(writer->BeginChunk(REFL_CHUNK_SCHEMA, s_chunkSchemaVersion));
+        stream.Write<uint32>(numUsed);
+        for (unsigned type = 0; type < s_metadata->numTypes; type++) {
+            if (!used[type]) 
+                continue;
+            stream.Write<uint32>(s_metadata->typeHash[type]);
+            stream.Write<uint32>(s_metadata->typeVersion[type]);
+            stream.Write<uint32>(nameOffsets[type]);
+        }
+    }
+    delete [] nameOffsets;
+    delete [] used;
+
+    bool result = true;
+    for (unsigned root = 0; root < numRoots && result; root++) {
+        DataStream stream(writer->BeginChunk(REFL_CHUNK_OBJECTS, s_binaryVersion));
+        result = Serialize(&stream, roots[root]);
+    }
+
+    return result;
+}
+
+//====================================================
+bool ReflLibrary::CheckChunkedSchema(IChunkReaderPtr reader, ReflLoadReport * report) {
+    memset(report, 0, sizeof(*report));
+    const ChunkDesc * stringsChunk  = reader->FindChunk(REFL_CHUNK_STRINGS);
+    const ChunkDesc * schemaChunk   = reader->FindChunk(REFL_CHUNK_SCHEMA);
+    if (stringsChunk == NULL || schemaChunk == NULL || stringsChunk->size > s_maxChunkStrings) 
+        return false;
+    if (stringsChunk->version != s_chunkStringsVersion || schemaChunk->version != s_chunkSchemaVersion) {
+        LOG(LOG_PRIORITY_WARN, "Unsupported chunked reflection schema, version %u", schemaChunk->version);
+        return false;
+    }
+    MetadataScope scope;
+    ASSERTMSGGR(s_metadata != NULL, "Binary loads need ReflInitialize");
+
+    // Names are only needed to report classes that aren't registered
+    IRawStreamPtr stringsStream = reader->OpenChunk(stringsChunk);
+    if (stringsStream == NULL) 
+        return false;
+    unsigned stringsSize = static_cast<unsigned>(stringsChunk->size);
+    charsys * strings = new(REFL_TEMP_MEM_FLAGS) charsys[stringsSize + 1];
+    strings[stringsSize] = 0;
+    bool result = DataStream(stringsStream).ReadBytes(strings, stringsSize) == STREAM_ERROR_OK;
+    stringsStream = IRawStreamPtr(NULL);
+
+    IRawStreamPtr schemaStream = result ? reader->OpenChunk(schemaChunk) : IRawStreamPtr(NULL);
+    if (schemaStream != NULL) {
+        DataStream stream(schemaStream);
+        uint32 numTypes = 0;
+        result = stream.Read(numTypes) == STREAM_ERROR_OK;
+        for (unsigned i = 0; i < numTypes && result; i++) {
+            uint32 typeHash     = 0;
+            uint32 version      = 0;
+            uint32 nameOffset   = 0;
+            stream.Read(typeHash);
+            stream.Read(version);
+            result = stream.Read(nameOffset) == STREAM_ERROR_OK;
+
+            unsigned type = FindMetadataType(typeHash);
+            if (type == s_invalidMetadataIndex) {
+                LOG(LOG_PRIORITY_INFO, "Chunked file contains unregistered class %s", nameOffset < stringsSize ? strings + nameOffset : "");
+                report->unknownClasses++;
+                continue;
+            }
+
+            if (s_metadata->typeHash[type] != typeHash) 
+                report->aliasedClasses++;
+            if (version < s_metadata->typeVersion[type]) 
+                report->oldVersions++;
+            else if (version > s_metadata->typeVersion[type]) 
+                report->newerVersions++;
+        }
+    }
+    else
+        result = false;
+    delete [] strings;
+
+    return result;
+}
 
-    return desc->Serialize(stream, inst);
+//====================================================
+ReflClass * ReflLibrary::DeserializeChunk(IChunkReaderPtr reader, const ChunkDesc * chunk, MemFlags memFlags) {
+    if (chunk == NULL || chunk->type != REFL_CHUNK_OBJECTS) 
+        return NULL;
+
+    IRawStreamPtr rawStream = reader->OpenChunk(chunk);
+    if (rawStream == NULL) 
+        return NULL;
+
+    DataStream stream(rawStream);
+    return Deserialize(&stream, memFlags);
 }
 
+//====================================================
+void ReflLibrary::UnregisterPrototype(ReflPrototype * prototype) {
+    ReflPrototype * prev = NULL;
+    for (ReflPrototype * curr = s_prototypeHead; curr != NULL; curr = curr->GetNext()) {
+        if (curr == prototype) {
+            if (prev != NULL) 
+                prev->SetNext(curr->GetNext());
+            else
+                s_prototypeHead = curr->GetNext();
+            curr->SetNext(NULL);
+
+            // Drop the library's reference
+            ReflPrototypePtr release(curr);
+            curr->ReleaseRef();
+            break;
+        }
+        prev = curr;
+    }
+}
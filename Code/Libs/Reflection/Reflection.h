@@ -29,20 +29,47 @@
 
 class ReflClass;
 class ReflTypeDesc;
+class ReflMember;
+class ReflPrototype;
+class ReflContentHasher;
 class DataStream;
 class IStructuredTextStream;
+class IChunkReader;
+class IChunkWriter;
+struct ChunkDesc;
+struct ReflTypeBatch;
 DECLARE_SMARTPTR(IStructuredTextStream);
+DECLARE_SMARTPTR(IChunkReader);
+DECLARE_SMARTPTR(IChunkWriter);
 
 typedef unsigned    ReflIndex;
 typedef Hash32      ReflHash;
 
 typedef void * (*ReflCreateFunc)(unsigned count, MemFlags memFlags);
+typedef void (*ReflDestroyFunc)(void * inst);
+typedef void (*ReflConstructFunc)(void * mem);
+typedef void (*ReflDestructFunc)(void * inst);
 typedef void (*ReflFinalizationFunc)(ReflClass * inst);
 typedef void (*ReflConversionFunc)(ReflClass * inst, ReflHash name, ReflHash oldType, void * data);
+
+// Converts count old values of a member into new member values. Each array
+//  is stride bytes between values, so the new values can be the member 
+//  slots of an array of instances.
+typedef void (*ReflBatchConversionFunc)(
+    const ReflMember  * member, 
+    ReflHash            oldType, 
+    const void        * oldValues, 
+    unsigned            oldStride, 
+    void              * newValues, 
+    unsigned            newStride, 
+    unsigned            count
+);
 typedef void (*ReflVersioningFunc)(IStructuredTextStreamPtr stream, ReflTypeDesc * desc, unsigned version, ReflClass * inst);
 
 const ReflHash ReflTypeBool(L"bool");
 const ReflHash ReflTypeInt32(L"int32");
+const ReflHash ReflTypePointer(L"pointer");
+const ReflHash ReflTypeBitfield(L"bitfield");
 
 struct ReflAlias {
     ReflAlias *             next;
@@ -60,8 +87,24 @@ public:
         unsigned        offset
     );
 
+    // Bitfields can't be addressed, so the position is found from a zeroed
+    //  layout of the containing type with only this field's bits set
+    ReflMember(
+        ReflTypeDesc  * container,
+        ReflHash        typeHash,
+        const chargr  * name,
+        const byte    * layout,
+        unsigned        layoutSize,
+        bool            isSigned
+    );
+
+    // Names are compiled out of gold builds
     const chargr * Name() const {
+#ifdef GOLD
+        return L"";
+#else
         return m_name;
+#endif
     }
 
     bool Matches(ReflHash hash) const;
@@ -74,6 +117,13 @@ public:
         return m_typeHash;
     }
 
+    // Type pointer members point to, empty for other members
+    ReflHash PointeeTypeHash() const {
+        return m_pointeeHash;
+    }
+    void SetPointeeType(ReflHash pointeeHash);
+    const ReflClass * ReadPointer(const void * base, unsigned offset) const;
+
     const ReflMember * GetNext() const {
         return m_next;
     }
@@ -89,23 +139,40 @@ public:
 
     void Finalize();
 
+#ifndef GOLD
     bool ConvertToString(const byte * data, chargr * str, unsigned len) const;
     bool ConvertFromString(const byte * data, chargr * str, unsigned len) const;
 
     bool Serialize(IStructuredTextStreamPtr stream, const ReflClass * inst, const void * base, unsigned offset) const;
     void Deserialize(IStructuredTextStreamPtr stream, ReflHash nameHash, ReflClass * inst, void * base, unsigned offset) const;
+#endif
 
-    bool Serialize(DataStream * stream, const ReflClass * inst, unsigned offset) const;
-    void Deserialize(DataStream * stream, ReflHash nameHash, ReflClass * inst, void * base, unsigned offset) const;
+    void Copy(const void * src, void * dest, unsigned offset) const;
+    void HashContents(ReflContentHasher * hasher, const void * base, unsigned offset) const;
 
+#ifndef GOLD
     void RegisterConversionFunc(ReflConversionFunc func);
 
-    void RegisterTempBinding(void * data) {
-        m_tempBinding = data;
-    }
-    void ClearTempBinding() {
-        m_tempBinding = NULL;
+    // Batch conversions of a graph load run together once the file is read,
+    //  before finalization. Scale is applied by ReflConvertNumeric.
+    void RegisterBatchConversionFunc(ReflBatchConversionFunc func, float32 scale);
+    float32 GetConversionScale() const {
+        return m_convScale;
     }
+    void ConvertValues(
+        ReflHash        oldType, 
+        const void    * oldValues, 
+        unsigned        oldStride, 
+        void          * newValues, 
+        unsigned        newStride, 
+        unsigned        count
+    ) const;
+
+    // Bindings are per thread, so versioning functions can run for loads 
+    //  on several threads at once
+    void RegisterTempBinding(void * data) const;
+    void ClearTempBinding() const;
+#endif
 
     void MarkDeprecated() {
         m_deprecated = true;
@@ -117,8 +184,28 @@ public:
     unsigned GetSize() const {
         return m_size;
     }
+
+    ReflIndex TypeIndex() const {
+        return m_index;
+    }
+
+    // Bitfields start m_bitOffset bits into the byte at GetOffset and are 
+    //  sign extended when read if the declared type is signed
+    bool IsBitfield() const;
+    unsigned GetBitOffset() const {
+        return m_bitOffset;
+    }
+    unsigned GetBitWidth() const {
+        return m_bitWidth;
+    }
+    bool IsBitfieldSigned() const {
+        return m_bitSigned;
+    }
+    int64 ReadBitfield(const void * base, unsigned offset) const;
+    void WriteBitfield(void * base, unsigned offset, int64 value) const;
 private:
 
+#ifndef GOLD
     bool DeserializeClassMember(IStructuredTextStreamPtr stream, void * inst, unsigned offset) const;
     bool ConvertDataMember(
         IStructuredTextStreamPtr    stream, 
@@ -132,18 +219,18 @@ private:
         ReflClass                 * inst, 
         ReflIndex                   oldType
     ) const;
+#endif
 
     ReflIndex DetermineTypeIndex(ReflHash typeHash) const;
 
-    ReflIndex TypeIndex() const {
-        return m_index;
-    }
-
 private:
     ReflHash            m_nameHash;
     ReflHash            m_typeHash;
+    ReflHash            m_pointeeHash;
 
+#ifndef GOLD
     const chargr      * m_name;
+#endif
     ReflIndex           m_index;
 
     unsigned            m_offset;
@@ -151,10 +238,16 @@ private:
 
     ReflMember        * m_next;
 
-    ReflConversionFunc  m_convFunc;
+#ifndef GOLD
+    ReflConversionFunc      m_convFunc;
+    ReflBatchConversionFunc m_batchConvFunc;
+    float32                 m_convScale;
+#endif
 
     bool                m_deprecated; // Need bit flags class
-    void              * m_tempBinding;
+    bool                m_bitSigned;
+    uint8               m_bitOffset;
+    uint8               m_bitWidth;
 };
 
 class ReflTypeDesc {
@@ -164,7 +257,10 @@ public:
         unsigned        size,
         unsigned        baseOffset,
         unsigned        reflOffset,
-        ReflCreateFunc  creationFunc
+        ReflCreateFunc      creationFunc,
+        ReflDestroyFunc     destroyFunc,
+        ReflConstructFunc   constructFunc,
+        ReflDestructFunc    destructFunc
     );
 
     void Finalize();
@@ -174,22 +270,39 @@ public:
     }
 
     const chargr * GetTypeName() const {
+#ifdef GOLD
+        return L"";
+#else
         return m_typeName;
+#endif
     }
 
     unsigned GetVersion() const {
         return m_version;
     }
 
+    unsigned GetSize() const {
+        return m_size;
+    }
+
     unsigned            NumMembers() const;
     const ReflMember  & GetMember(unsigned index) const;
+    const ReflMember  * GetMember(unsigned index, unsigned * offset) const;
     const ReflMember  * FindMember(ReflHash name) const;
+    bool                FindMemberIndex(ReflHash name, unsigned * index) const;
 
     void RegisterMember(ReflMember * member);
 
     void RegisterFinalizationFunc(ReflFinalizationFunc finalFunc);
     void RegisterManualVersioningFunc(ReflVersioningFunc loadFunc, unsigned currentVersion);
 
+    bool HasFinalizationFunc() const {
+        return m_finalizeFunc != NULL;
+    }
+    bool HasManualVersioning() const {
+        return m_manualVersioning;
+    }
+
     bool NameMatches(const ReflHash rhs) const {
         return m_typeHash == rhs;
     }
@@ -197,9 +310,30 @@ public:
     void * Create(unsigned count, MemFlags memFlags) const {
         return m_creationFunc(count, memFlags);
     }
+    void Destroy(void * inst) const {
+        m_destroyFunc(inst);
+    }
+
+    // In place construction, used when many instances share one allocation
+    void Construct(void * mem) const {
+        m_constructFunc(mem);
+    }
+    void Destruct(void * inst) const {
+        m_destructFunc(inst);
+    }
 
     void InitInst(void * inst) const;
+    void FinalizeInst(void * inst) const;
+
+    // Copies reflected members from one instance to another, base pointers
+    void CopyInst(const void * src, void * dest) const;
+    void * Clone(const void * src, MemFlags memFlags) const;
 
+    // Hashes reflected member values in finalized order, base pointers
+    Hash64 HashContents(const void * inst) const;
+    void HashMembers(ReflContentHasher * hasher, const void * base, unsigned offset) const;
+
+#ifndef GOLD
     bool Serialize(IStructuredTextStreamPtr stream, const ReflClass * inst, unsigned offset = 0) const;
     bool Deserialize(IStructuredTextStreamPtr stream, ReflClass * inst) const;
     bool Deserialize(IStructuredTextStreamPtr stream, void * inst, unsigned offset) const;
@@ -209,6 +343,7 @@ public:
     bool RegisterTempBinding(ReflHash memberHash, ReflHash typeHash, void * data);
     void ClearTempBinding(ReflHash memberHash, ReflHash typeHash);
     void ClearAllTempBindings();
+#endif
 
     struct Parent {
         Parent    * next;
@@ -217,6 +352,9 @@ public:
         ReflHash    parentHash;
     };
     void AddParent(Parent * parent);
+    const Parent * GetParents() const {
+        return m_parents;
+    }
 
     ReflTypeDesc * GetNext() {
         return m_next;
@@ -226,8 +364,17 @@ public:
     }
     void SetNext(ReflTypeDesc * next);
 
+    // Members declared by this type only, in finalized order
+    const ReflMember * GetLocalMembers() const {
+        return m_members;
+    }
+
     void RegisterMemberAlias(ReflAlias * alias);
+    const ReflAlias * GetMemberAliases() const {
+        return m_memberAliases;
+    }
 
+    // Display names are NULL in gold builds
     struct EnumValue {
         EnumValue     * next;
         int64           value;
@@ -237,7 +384,12 @@ public:
 
     void RegisterEnumValue(EnumValue * value);
     const EnumValue * GetEnumValue(int64 value) const;
+#ifndef GOLD
     const EnumValue * GetEnumValue(const chargr * str, unsigned len) const;
+#endif
+    const EnumValue * GetEnumValues() const {
+        return m_enumValues;
+    }
     bool IsEnumType() const;
 
     void * CastTo(ReflClass * inst, ReflHash givenType, ReflHash targetType) const;
@@ -252,8 +404,6 @@ private:
     const void * CastToBase(const ReflClass * inst) const;
     ReflClass * CastToReflClass(void * inst) const;
 
-    void FinalizeInst(void * inst) const;
-
     const ReflMember  * FindMember(const chargr * name, unsigned * offset) const;
     const ReflMember  * FindMember(ReflHash name, unsigned * offset) const;
     ReflMember        * FindMember(ReflHash name);
@@ -263,25 +413,37 @@ private:
     Parent * FindParentRecursive(ReflHash parentHash) const;
     bool FindParentOffset(ReflHash parentHash, unsigned * offset, unsigned * reflOffset) const;
 
+    void CopyMembers(const void * src, void * dest, unsigned offset) const;
+
+#ifndef GOLD
     bool SerializeMembers(
         IStructuredTextStreamPtr    stream, 
         const ReflClass           * inst,
         const void                * base, 
         unsigned                    offset
     ) const;
+#endif
 
 private:
     ReflHash                m_typeHash;
+#ifndef GOLD
     const chargr          * m_typeName;
+#endif
 
     unsigned                m_version;
+    bool                    m_manualVersioning;
     unsigned                m_size;
     unsigned                m_baseOffset;
     unsigned                m_reflOffset;
 
     ReflCreateFunc          m_creationFunc;
+    ReflDestroyFunc         m_destroyFunc;
+    ReflConstructFunc       m_constructFunc;
+    ReflDestructFunc        m_destructFunc;
     ReflFinalizationFunc    m_finalizeFunc;
+#ifndef GOLD
     ReflVersioningFunc      m_versioningFunc;
+#endif
 
     ReflTypeDesc          * m_next;
 
@@ -320,6 +482,83 @@ private:
 template<typename t_Type>
     ReflHash ReflGetTypeHash(const t_Type & reflType);
 
+// Pointers to reflected classes are serialized as object ids
+template<typename t_Type>
+    ReflHash ReflGetTypeHash(t_Type * const & reflType) {
+        return ReflTypePointer;
+    }
+
+template<typename t_Type>
+    ReflHash ReflGetPointeeTypeHash(t_Type * const & reflType) {
+        return ::ReflGetTypeHash(*((t_Type *) 0x0));
+    }
+
+// Used by REFL_BITFIELD_MEMBER, bitfields only bind to const references
+template<typename t_Type>
+    t_Type ReflBitfieldAllBits(const t_Type & reflType) {
+        return static_cast<t_Type>(~0);
+    }
+
+template<typename t_Type>
+    bool ReflBitfieldIsSigned(const t_Type & reflType) {
+        return reflType < static_cast<t_Type>(0);
+    }
+
+inline bool ReflBitfieldAllBits(const bool & reflType) {
+    return true;
+}
+
+inline bool ReflBitfieldIsSigned(const bool & reflType) {
+    return false;
+}
+
+// Memory used by registered reflection metadata, see ReflLibrary::GetMetadataStats
+struct ReflMetadataStats {
+    unsigned    numTypes;
+    unsigned    numMembers;
+    unsigned    numEnumValues;
+
+    unsigned    descBytes;      // Type descriptors, members and enum values
+    unsigned    nameBytes;      // Stored names, zero in gold builds
+    unsigned    tableBytes;     // Dense tables used by binary serialization
+};
+
+// Load and save counters of one type summed over every thread, see 
+//  ReflLibrary::GetTelemetry. Only counted in builds defining REFL_TELEMETRY.
+//  Times and bytes exclude nested class blocks, which count for their own 
+//  type, so they add up to the totals of a load.
+struct ReflTypeTelemetry {
+    ReflHash    typeHash;
+    uint64      objectsLoaded;
+    uint64      objectsSaved;
+    uint64      membersLoaded;
+    uint64      membersSaved;
+    uint64      bytesLoaded;        // Binary only
+    uint64      bytesSaved;         // Binary only
+    uint64      conversions;        // Members converted from an older type
+    uint64      aliasHits;          // Class and member names resolved through an alias
+    uint64      loadNanoseconds;
+    uint64      saveNanoseconds;
+};
+
+// Everything a text load had to convert, see ReflLibrary::Deserialize. Data
+//  with none of these loads without any versioning work.
+struct ReflLoadReport {
+    unsigned    oldVersions;        // Classes saved at an older version
+    unsigned    newerVersions;      // Classes saved by a newer build
+    unsigned    aliasedClasses;     // Class names resolved through an alias
+    unsigned    aliasedMembers;     // Member names resolved through an alias
+    unsigned    convertedMembers;   // Members loaded through a conversion function
+    unsigned    deprecatedMembers;  // Members only kept for versioning
+    unsigned    unknownMembers;     // Members that are dropped
+    unsigned    unknownClasses;     // Objects of unregistered classes
+};
+
+// Chunk types of chunked reflection files, see ReflLibrary::SerializeChunked
+const uint32 REFL_CHUNK_STRINGS = 0x53525453;   // 'STRS'
+const uint32 REFL_CHUNK_SCHEMA  = 0x4d484353;   // 'SCHM'
+const uint32 REFL_CHUNK_OBJECTS = 0x534a424f;   // 'OBJS'
+
 class ReflLibrary {
 public:
     static const ReflTypeDesc * GetClassDesc(ReflHash nameHash);
@@ -328,15 +567,98 @@ public:
     static void RegisterClassDesc(ReflTypeDesc * classDesc);
     static void RegisterDeprecatedClassDesc(ReflAlias * classDescAlias);
 
+    // Types registered after ReflInitialize, such as by the static 
+    //  initializers of a plugin, stay hidden until they are published 
+    //  together as a batch. Lookups never wait on registration. A batch must
+    //  be unregistered before its module unloads, once no instances, 
+    //  prototypes or shared instances of its types are left.
+    static ReflTypeBatch * RegisterTypeBatch();
+    static void UnregisterTypeBatch(ReflTypeBatch * batch);
+
+#ifndef GOLD
     static ReflClass * Deserialize(IStructuredTextStreamPtr stream, MemFlags memFlags);
+    static ReflClass * Deserialize(IStructuredTextStreamPtr stream, MemFlags memFlags, ReflLoadReport * report);
     static bool Serialize(IStructuredTextStreamPtr stream, const ReflClass * inst);
     static bool Deserialize(IStructuredTextStreamPtr stream, ReflClass * inst);
+#endif
+
+    // Object graphs. Every object reachable through pointer members is 
+    //  written once, and references are restored after the whole file is 
+    //  loaded. The root is the first object in the file.
+    static bool Serialize(DataStream * stream, const ReflClass * inst);
+
+    // Binary loads allocate every object of the file in a single block,
+    //  so the root has to be released with DestroyBatch.
+    static ReflClass * Deserialize(DataStream * stream, MemFlags memFlags);
+    static void DestroyBatch(ReflClass * root);
+
+    // Several graphs in one chunked file. A schema chunk lists every class
+    //  the objects use with its version, names are in a strings chunk, and 
+    //  each graph is written to an objects chunk of its own, in the order 
+    //  given. Readers over streams check the schema before opening objects.
+    static bool SerializeChunked(IChunkWriterPtr writer, const ReflClass * const * roots, unsigned numRoots);
+    static bool CheckChunkedSchema(IChunkReaderPtr reader, ReflLoadReport * report);
+    static ReflClass * DeserializeChunk(IChunkReaderPtr reader, const ChunkDesc * chunk, MemFlags memFlags);
+
+    // Destroys every object reachable from root that was created separately,
+    //  such as the results of a text load. Needs ReflInitialize.
+    static void DestroyGraph(ReflClass * root);
+
+    // Stable hash of an instance's reflected member values, and those of 
+    //  every object it points to. Padding, unreflected members and pointer
+    //  addresses don't contribute.
+    static Hash64 HashContents(const ReflClass * inst);
+
+    // Hash-consing load, returns an already loaded instance with identical
+    //  contents if there is one. Shared instances must be treated as 
+    //  immutable and are returned with ReleaseShared, which destroys the 
+    //  whole graph with the last reference.
+#ifndef GOLD
+    static const ReflClass * DeserializeShared(IStructuredTextStreamPtr stream, MemFlags memFlags);
+#endif
+    static void ReleaseShared(const ReflClass * inst);
+    static unsigned NumSharedInstances();
+
+    // Valid after ReflInitialize
+    static void GetMetadataStats(ReflMetadataStats * stats);
+
+    // Writes every registered type with the layout of its binary records,
+    //  sorted by hash, so tools can read cooked files without the runtime.
+    //  Needs ReflInitialize.
+#ifndef GOLD
+    static bool ExportSchema(IStructuredTextStreamPtr stream);
+#endif
+
+    // Fills at most maxTypes entries, sorted by total time, and returns the 
+    //  number filled. Counts of threads still loading may be slightly stale.
+    static unsigned GetTelemetry(ReflTypeTelemetry * telemetry, unsigned maxTypes);
+    static void ResetTelemetry();
+    static void LogTelemetry();
+
+    static void RegisterPrototype(ReflPrototype * prototype);
+    static void UnregisterPrototype(ReflPrototype * prototype);
+    static ReflPrototype * FindPrototype(ReflHash nameHash);
 };
 
 void ReflInitialize();
 
 void ReflInitType(void * inst, ReflHash type);
 
+#ifndef GOLD
+// Batch conversion between the integer and float32 member types. Values are
+//  scaled by the member's conversion scale, floats are rounded to the 
+//  nearest integer and integers saturate when narrowing.
+void ReflConvertNumeric(
+    const ReflMember  * member, 
+    ReflHash            oldType, 
+    const void        * oldValues, 
+    unsigned            oldStride, 
+    void              * newValues, 
+    unsigned            newStride, 
+    unsigned            count
+);
+#endif
+
 void * ReflCanCastTo(ReflClass * inst, ReflHash actualType, ReflHash givenType, ReflHash targetType);
 const void * ReflCanCastTo(const ReflClass * inst, ReflHash actualType, ReflHash givenType, ReflHash targetType);
 
@@ -364,6 +686,243 @@ const t_cast * ReflCast(const t_given * inst) {
     return ret;
 }
 
+//////////////////////////////////////////////////////
+//
+// Prototype instancing
+//
+// A prototype owns an immutable body that any number of instances share. An
+//  instance only clones the body the first time it's written to, and records 
+//  which members it overrides by their reflection member index.
+//
+
+class ReflPrototype : public RefCounted {
+public:
+    ReflPrototype(const chargr * name, const ReflClass * body, MemFlags memFlags);
+    ~ReflPrototype();
+
+    const chargr * GetName() const {
+        return m_name;
+    }
+    ReflHash GetNameHash() const {
+        return m_nameHash;
+    }
+
+    const ReflTypeDesc * GetTypeDesc() const {
+        return m_desc;
+    }
+
+    const ReflClass * GetBody() const;
+    const void * GetBodyBase() const {
+        return m_body;
+    }
+
+    unsigned NumMembers() const {
+        return m_numMembers;
+    }
+
+    MemFlags GetMemFlags() const {
+        return m_memFlags;
+    }
+
+    ReflPrototype * GetNext() {
+        return m_next;
+    }
+    void SetNext(ReflPrototype * next) {
+        m_next = next;
+    }
+
+private:
+    chargr                  m_name[64];
+    ReflHash                m_nameHash;
+    const ReflTypeDesc    * m_desc;
+    void                  * m_body;
+    unsigned                m_numMembers;
+    MemFlags                m_memFlags;
+    ReflPrototype         * m_next;
+};
+
+DECLARE_SMARTPTR(ReflPrototype);
+
+class ReflInstance {
+public:
+    ReflInstance();
+    ReflInstance(ReflPrototypePtr prototype);
+    ReflInstance(const ReflInstance & rhs);
+    ~ReflInstance();
+
+    ReflInstance & operator=(const ReflInstance & rhs);
+
+    const ReflPrototypePtr & GetPrototype() const {
+        return m_prototype;
+    }
+
+    // Returns the private copy if there is one, otherwise the shared body
+    const ReflClass * Read() const;
+
+    // Creates the private copy if needed and marks the member as overridden
+    ReflClass * Write(ReflHash memberName);
+    ReflClass * Write(unsigned memberIndex);
+
+    template<typename t_type>
+    const t_type * Read() const {
+        return ReflCast<t_type>(Read());
+    }
+    template<typename t_type>
+    t_type * Write(ReflHash memberName) {
+        return ReflCast<t_type>(Write(memberName));
+    }
+
+    bool IsShared() const {
+        return m_body == NULL;
+    }
+    bool IsOverridden(unsigned memberIndex) const;
+    unsigned NumOverrides() const;
+
+    // Drops the private copy and all overrides
+    void Revert();
+
+    // Only overridden members are written, everything else comes from the prototype
+#ifndef GOLD
+    bool Serialize(IStructuredTextStreamPtr stream) const;
+    bool Deserialize(IStructuredTextStreamPtr stream);
+#endif
+
+private:
+
+    void CopyFrom(const ReflInstance & rhs);
+    void Materialize();
+    void Release();
+
+private:
+    ReflPrototypePtr    m_prototype;
+    void              * m_body;
+    uint32            * m_overrides;
+};
+
+//////////////////////////////////////////////////////
+//
+// Structure of arrays
+//
+// Stores each reflected member of a type in its own contiguous column, at 
+//  the finalized member sizes, so passes over a few members only pull those
+//  columns through the cache. Columns hold raw member values, so member 
+//  types must be safe to copy with memcpy. Bitfields are unpacked into int64
+//  columns and deprecated members have no column. Instances are base 
+//  pointers, as with ReflTypeDesc::CopyInst.
+//
+
+class ReflColumnStore {
+public:
+    ReflColumnStore(const ReflTypeDesc * desc, MemFlags memFlags);
+    ~ReflColumnStore();
+
+    const ReflTypeDesc * GetTypeDesc() const {
+        return m_desc;
+    }
+
+    unsigned Size() const {
+        return m_size;
+    }
+    unsigned Capacity() const {
+        return m_capacity;
+    }
+    void Reserve(unsigned capacity);
+
+    // New rows take the values of a default constructed instance
+    void Resize(unsigned size);
+    void Clear() {
+        m_size = 0;
+    }
+
+    unsigned NumColumns() const {
+        return m_numColumns;
+    }
+    bool FindColumn(ReflHash memberName, unsigned * column) const;
+    const ReflMember * GetColumnMember(unsigned column) const;
+    unsigned GetColumnStride(unsigned column) const;
+    void * GetColumn(unsigned column);
+    const void * GetColumn(unsigned column) const;
+
+    // Scatter copies an instance's members out to a row, gather copies a 
+    //  row back into an instance. Returns the new row.
+    unsigned Add(const void * inst);
+    void Scatter(unsigned row, const void * inst);
+    void Gather(unsigned row, void * inst) const;
+
+    // Arrays of count instances, stride bytes apart, copied a column at a time
+    void Scatter(unsigned firstRow, const void * insts, unsigned stride, unsigned count);
+    void Gather(unsigned firstRow, void * insts, unsigned stride, unsigned count) const;
+
+    // Moves the last row into the removed one
+    void RemoveSwap(unsigned row);
+
+    // Each column is written as one block. Pointer and class member columns
+    //  aren't written, and loading keeps the defaults of missing columns.
+    bool Serialize(DataStream * stream) const;
+    bool Deserialize(DataStream * stream);
+
+private:
+    ReflColumnStore(const ReflColumnStore & rhs);
+    ReflColumnStore & operator=(const ReflColumnStore & rhs);
+
+    struct ColumnDesc;
+
+    void CopyToRow(const ColumnDesc & column, const byte * base, byte * dest) const;
+    void CopyFromRow(const ColumnDesc & column, const byte * src, byte * base) const;
+    void FillDefaults(unsigned firstRow, unsigned count);
+
+private:
+    const ReflTypeDesc    * m_desc;
+    MemFlags                m_memFlags;
+    ColumnDesc            * m_columns;
+    unsigned                m_numColumns;
+    void                  * m_defaults;
+    byte                  * m_memory;
+    unsigned                m_size;
+    unsigned                m_capacity;
+};
+
+template<typename t_type>
+class ReflColumns : public ReflColumnStore {
+public:
+    ReflColumns(MemFlags memFlags) :
+        ReflColumnStore(t_type::GetReflectionInfo(), memFlags)
+    {
+    }
+
+    unsigned Add(const t_type & inst) {
+        return ReflColumnStore::Add(&inst);
+    }
+    void Scatter(unsigned row, const t_type & inst) {
+        ReflColumnStore::Scatter(row, &inst);
+    }
+    void Gather(unsigned row, t_type * inst) const {
+        ReflColumnStore::Gather(row, inst);
+    }
+    void Scatter(unsigned firstRow, const t_type * insts, unsigned count) {
+        ReflColumnStore::Scatter(firstRow, insts, sizeof(t_type), count);
+    }
+    void Gather(unsigned firstRow, t_type * insts, unsigned count) const {
+        ReflColumnStore::Gather(firstRow, insts, sizeof(t_type), count);
+    }
+
+    // NULL if the member has no column or isn't a t_member
+    template<typename t_member>
+    t_member * Column(ReflHash memberName) {
+        unsigned column = 0;
+        if (!FindColumn(memberName, &column) || GetColumnStride(column) != sizeof(t_member)) 
+            return NULL;
+        return reinterpret_cast<t_member *>(GetColumn(column));
+    }
+    template<typename t_member>
+    const t_member * Column(ReflHash memberName) const {
+        unsigned column = 0;
+        if (!FindColumn(memberName, &column) || GetColumnStride(column) != sizeof(t_member)) 
+            return NULL;
+        return reinterpret_cast<const t_member *>(GetColumn(column));
+    }
+};
+
 #define REFL_DEFINE_USER_TYPE(type)                                         \
     template<typename t_Type>                                               \
         ReflHash ReflGetTypeHash(const t_Type & reflType);                  \
@@ -377,6 +936,9 @@ const t_cast * ReflCast(const t_given * inst) {
         static ReflHash s_className;                                        \
     public:                                                                 \
         static void * Create(unsigned count, MemFlags memFlags);            \
+        static void Destroy(void * inst);                                   \
+        static void Construct(void * mem);                                  \
+        static void Destruct(void * inst);                                  \
         static const ReflTypeDesc * GetReflectionInfo();                    \
         template<typename t_reflType>                                       \
         static ReflTypeDesc * ReflCreateClassDesc();                        \
@@ -390,6 +952,15 @@ const t_cast * ReflCast(const t_given * inst) {
         name * inst = new(memFlags) name;                                   \
         return inst;                                                        \
     }                                                                       \
+    void name::Destroy(void * inst) {                                       \
+        delete reinterpret_cast<name *>(inst);                              \
+    }                                                                       \
+    void name::Construct(void * mem) {                                      \
+        new(mem) name;                                                      \
+    }                                                                       \
+    void name::Destruct(void * inst) {                                      \
+        reinterpret_cast<name *>(inst)->~name();                            \
+    }                                                                       \
     const ReflTypeDesc * name::GetReflectionInfo() {                        \
         return ReflLibrary::GetClassDesc(s_className);                      \
     }                                                                       \
@@ -408,7 +979,10 @@ const t_cast * ReflCast(const t_given * inst) {
             sizeof(t_reflType),                                             \
             CLASSOFFSETOF(base, t_reflType),                                \
             CLASSOFFSETOF(ReflClass, base),                                 \
-            t_reflType::Create                                              \
+            t_reflType::Create,                                             \
+            t_reflType::Destroy,                                            \
+            t_reflType::Construct,                                          \
+            t_reflType::Destruct                                            \
         )
                                 
 #define REFL_IMPL_CLASS_BEGIN_NAMESPACE(base, ns, name)                     \
@@ -423,7 +997,10 @@ const t_cast * ReflCast(const t_given * inst) {
             sizeof(t_reflType),                                             \
             CLASSOFFSETOF(base, t_reflType),                                \
             CLASSOFFSETOF(ReflClass, base),                                 \
-            t_reflType::Create                                              \
+            t_reflType::Create,                                             \
+            t_reflType::Destroy,                                            \
+            t_reflType::Construct,                                          \
+            t_reflType::Destruct                                            \
         )
                                 
 #define REFL_IMPL_CLASS_END(name)                                           \
@@ -438,11 +1015,21 @@ const t_cast * ReflCast(const t_given * inst) {
     };                                                                      \
     static ReflAutoRegister##name s_autoRegister##name
 
-#define REFL_DO_MANUAL_VERSIONING(func, version)                            \
+#ifdef GOLD
+    // Versioning functions read text, gold builds only load cooked data
+    #define REFL_DO_MANUAL_VERSIONING(func, version)                        \
+        s_reflInfo.RegisterManualVersioningFunc(                            \
+            NULL,                                                           \
+            version                                                         \
+        )
+#else
+    #define REFL_DO_MANUAL_VERSIONING(func, version)                        \
         s_reflInfo.RegisterManualVersioningFunc(                            \
             func,                                                           \
             version                                                         \
         )
+#endif
+
 #define REFL_ADD_DEPRECATED_CLASS(name, alias)                              \
             static ReflAlias s_alias##alias = {                             \
                 NULL,                                                       \
@@ -495,6 +1082,33 @@ const t_cast * ReflCast(const t_given * inst) {
                 ::ReflGetTypeHash((((t_reflType *)(0x0))->name))            \
             )                           
 
+#define REFL_POINTER_MEMBER(name)                                           \
+            REFL_MEMBER(name);                                              \
+            s_member##name.SetPointeeType(                                  \
+                ::ReflGetPointeeTypeHash((((t_reflType *)(0x0))->name))     \
+            )
+
+// Members declared with a bit width, e.g. "uint32 m_visible : 1". Single
+//  bit fields are written to text as true/false and enum fields by name.
+#define REFL_BITFIELD_MEMBER(name)                                          \
+            static byte s_bitfield##name[sizeof(t_reflType)];               \
+            reinterpret_cast<t_reflType *>(s_bitfield##name)->name =        \
+                ::ReflBitfieldAllBits(                                      \
+                    reinterpret_cast<t_reflType *>(s_bitfield##name)->name  \
+                );                                                          \
+            static ReflMember s_member##name(                               \
+                &s_reflInfo,                                                \
+                ::ReflGetTypeHash(                                          \
+                    reinterpret_cast<t_reflType *>(s_bitfield##name)->name  \
+                ),                                                          \
+                TOWSTR(name),                                               \
+                s_bitfield##name,                                           \
+                sizeof(t_reflType),                                         \
+                ::ReflBitfieldIsSigned(                                     \
+                    reinterpret_cast<t_reflType *>(s_bitfield##name)->name  \
+                )                                                           \
+            )
+
 #define REFL_MEMBER_DEPRECATED(name, type)                                  \
             static ReflMember s_member##name(                               \
                 &s_reflInfo,                                                \
@@ -505,8 +1119,22 @@ const t_cast * ReflCast(const t_given * inst) {
             );                                                              \
             s_member##name.MarkDeprecated()
 
-#define REFL_ADD_MEMBER_CONVERSION(name, conv)                              \
+#ifdef GOLD
+    // Conversions are applied when cooking from text
+    #define REFL_ADD_MEMBER_CONVERSION(name, conv)
+    #define REFL_ADD_MEMBER_BATCH_CONVERSION(name, conv)
+    #define REFL_ADD_MEMBER_NUMERIC_CONVERSION(name)
+    #define REFL_ADD_MEMBER_SCALED_CONVERSION(name, scale)
+#else
+    #define REFL_ADD_MEMBER_CONVERSION(name, conv)                          \
             s_member##name.RegisterConversionFunc(conv)
+    #define REFL_ADD_MEMBER_BATCH_CONVERSION(name, conv)                    \
+            s_member##name.RegisterBatchConversionFunc(conv, 1.0f)
+    #define REFL_ADD_MEMBER_NUMERIC_CONVERSION(name)                        \
+            s_member##name.RegisterBatchConversionFunc(ReflConvertNumeric, 1.0f)
+    #define REFL_ADD_MEMBER_SCALED_CONVERSION(name, scale)                  \
+            s_member##name.RegisterBatchConversionFunc(ReflConvertNumeric, scale)
+#endif
 
 #define REFL_ADD_MEMBER_ALIAS(name, alias)                                  \
             static ReflAlias s_alias##alias = {                             \
@@ -529,6 +1157,9 @@ const t_cast * ReflCast(const t_given * inst) {
             sizeof(t_reflType),                                             \
             0,                                                              \
             0,                                                              \
+            NULL,                                                           \
+            NULL,                                                           \
+            NULL,                                                           \
             NULL                                                            \
         )
 
@@ -536,7 +1167,7 @@ const t_cast * ReflCast(const t_given * inst) {
         static ReflTypeDesc::EnumValue s_enumValue##value = {               \
             NULL,                                                           \
             scope::value,                                                   \
-            TOWSTR(displayName),                                            \
+            TOWSTR_NOGOLD(displayName),                                     \
             ReflHash(TOWSTR(scope::value))                                  \
         };                                                                  \
         s_typeDesc.RegisterEnumValue(&s_enumValue##value)
@@ -562,6 +1193,9 @@ const t_cast * ReflCast(const t_given * inst) {
             sizeof(t_reflType),                                             \
             0,                                                              \
             0,                                                              \
+            NULL,                                                           \
+            NULL,                                                           \
+            NULL,                                                           \
             NULL                                                            \
         )
 
@@ -569,7 +1203,7 @@ const t_cast * ReflCast(const t_given * inst) {
         static ReflTypeDesc::EnumValue s_enumValue##value = {               \
             NULL,                                                           \
             value,                                                          \
-            TOWSTR(displayName),                                            \
+            TOWSTR_NOGOLD(displayName),                                     \
             ReflHash(TOWSTR(value))                                         \
         };                                                                  \
         s_typeDesc.RegisterEnumValue(&s_enumValue##value)
@@ -578,7 +1212,7 @@ const t_cast * ReflCast(const t_given * inst) {
         static ReflTypeDesc::EnumValue s_enumValue##oldValue = {            \
             NULL,                                                           \
             value,                                                          \
-            TOWSTR(oldDisplay),                                             \
+            TOWSTR_NOGOLD(oldDisplay),                                      \
             ReflHash(TOWSTR(oldValue))                                      \
         };                                                                  \
         s_typeDesc.RegisterEnumValue(&s_enumValue##oldValue)
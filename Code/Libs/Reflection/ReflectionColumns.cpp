@@ -0,0 +1,454 @@
+/*
+   GameRiff - Framework for creating various video game services
+   Reflection driven structure of arrays storage
+   Copyright (C) 2011, Shaun Leach.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are
+   met:
+  
+       * Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+       * Redistributions in binary form must reproduce the above
+   copyright notice, this list of conditions and the following disclaimer
+   in the documentation and/or other materials provided with the
+   distribution.
+  
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include "Pch.h"
+
+LOG_DEFINE_MODULE(Reflection);
+
+//////////////////////////////////////////////////////
+//
+// Constants
+//
+
+// Column files start with the magic, format version, type and row count
+static const uint32 s_columnMagic       = 0x534c4f43; // 'COLS'
+static const uint32 s_columnVersion     = 1;
+static const unsigned s_columnAlignment = 16;
+static const unsigned s_minCapacity     = 16;
+
+//////////////////////////////////////////////////////
+//
+// Internal Types
+//
+
+enum EColumnKind {
+    COLUMN_VALUE,
+    COLUMN_BITFIELD,
+    COLUMN_POINTER,
+    COLUMN_CLASS,
+};
+
+struct ReflColumnStore::ColumnDesc {
+    const ReflMember      * member;
+    const ReflTypeDesc    * classDesc;     // Class members only
+    EColumnKind             kind;
+    unsigned                parentOffset;  // Of the parent declaring the member
+    unsigned                fieldOffset;   // From the instance base
+    unsigned                stride;
+    byte                  * data;
+};
+
+//////////////////////////////////////////////////////
+//
+// Internal Functions
+//
+
+//====================================================
+static unsigned AlignColumn(unsigned size) {
+    return (size + s_columnAlignment - 1) & ~(s_columnAlignment - 1);
+}
+
+//====================================================
+template<typename t_type>
+static void CopyStrided(const byte * src, unsigned srcStride, byte * dest, unsigned destStride, unsigned count) {
+    for (unsigned i = 0; i < count; i++) {
+        *reinterpret_cast<t_type *>(dest) = *reinterpret_cast<const t_type *>(src);
+        src     += srcStride;
+        dest    += destStride;
+    }
+}
+
+//====================================================
+// Word sized members copy as words, which the compiler can keep in registers
+static void CopyValues(const byte * src, unsigned srcStride, byte * dest, unsigned destStride, unsigned size, unsigned count) {
+    switch (size) {
+        case 1:
+            CopyStrided<uint8>(src, srcStride, dest, destStride, count);
+            break;
+        case 2:
+            CopyStrided<uint16>(src, srcStride, dest, destStride, count);
+            break;
+        case 4:
+            CopyStrided<uint32>(src, srcStride, dest, destStride, count);
+            break;
+        case 8:
+            CopyStrided<uint64>(src, srcStride, dest, destStride, count);
+            break;
+        default:
+            for (unsigned i = 0; i < count; i++) 
+                memcpy(dest + i * destStride, src + i * srcStride, size);
+            break;
+    }
+}
+
+//====================================================
+static ReflHash ColumnTypeHash(const ReflMember * member, EColumnKind kind) {
+    return kind == COLUMN_BITFIELD ? ReflTypeBitfield : member->TypeHash();
+}
+
+//////////////////////////////////////////////////////
+//
+// Member Functions
+//
+
+//====================================================
+ReflColumnStore::ReflColumnStore(const ReflTypeDesc * desc, MemFlags memFlags) :
+    m_desc(desc),
+    m_memFlags(memFlags),
+    m_columns(NULL),
+    m_numColumns(0),
+    m_defaults(NULL),
+    m_memory(NULL),
+    m_size(0),
+    m_capacity(0)
+{
+    ASSERTMSGGR(m_desc != NULL, "Columns need a registered type");
+    m_defaults = m_desc->Create(1, memFlags);
+
+    unsigned numMembers = m_desc->NumMembers();
+    m_columns = new(memFlags) ColumnDesc[numMembers > 0 ? numMembers : 1];
+    for (unsigned index = 0; index < numMembers; index++) {
+        unsigned offset = 0;
+        const ReflMember * member = m_desc->GetMember(index, &offset);
+        if (member->IsDeprecated()) 
+            continue;
+
+        ColumnDesc & column     = m_columns[m_numColumns++];
+        column.member           = member;
+        column.classDesc        = NULL;
+        column.kind             = COLUMN_VALUE;
+        column.parentOffset     = offset;
+        column.fieldOffset      = offset + member->GetOffset();
+        column.stride           = member->GetSize();
+        column.data             = NULL;
+
+        if (member->IsBitfield()) {
+            column.kind         = COLUMN_BITFIELD;
+            column.stride       = sizeof(int64);
+        }
+        else if (member->TypeHash() == ReflTypePointer) 
+            column.kind         = COLUMN_POINTER;
+        else {
+            const ReflTypeDesc * classDesc = ReflLibrary::GetClassDesc(member->TypeHash());
+            if (classDesc != NULL && !classDesc->IsEnumType()) {
+                column.kind         = COLUMN_CLASS;
+                column.classDesc    = classDesc;
+            }
+        }
+    }
+}
+
+//====================================================
+ReflColumnStore::~ReflColumnStore() {
+    if (m_memory != NULL) 
+        delete [] m_memory;
+    if (m_columns != NULL) 
+        delete [] m_columns;
+    if (m_defaults != NULL) 
+        m_desc->Destroy(m_defaults);
+}
+
+//====================================================
+void ReflColumnStore::Reserve(unsigned capacity) {
+    if (capacity <= m_capacity) 
+        return;
+
+    // One block holds every column, each starting on its own alignment
+    unsigned bytes = s_columnAlignment;
+    for (unsigned i = 0; i < m_numColumns; i++) 
+        bytes += AlignColumn(m_columns[i].stride * capacity);
+
+    byte * memory   = new(m_memFlags) byte[bytes];
+    size_t address  = reinterpret_cast<size_t>(memory);
+    byte * data     = memory + ((s_columnAlignment - address % s_columnAlignment) % s_columnAlignment);
+    for (unsigned i = 0; i < m_numColumns; i++) {
+        ColumnDesc & column = m_columns[i];
+        if (column.data != NULL) 
+            memcpy(data, column.data, column.stride * m_size);
+        column.data = data;
+        data += AlignColumn(column.stride * capacity);
+    }
+
+    if (m_memory != NULL) 
+        delete [] m_memory;
+    m_memory    = memory;
+    m_capacity  = capacity;
+}
+
+//====================================================
+void ReflColumnStore::Resize(unsigned size) {
+    if (size > m_capacity) 
+        Reserve(size);
+    if (size > m_size) 
+        FillDefaults(m_size, size - m_size);
+    m_size = size;
+}
+
+//====================================================
+bool ReflColumnStore::FindColumn(ReflHash memberName, unsigned * column) const {
+    for (unsigned i = 0; i < m_numColumns; i++) {
+        if (m_columns[i].member->Matches(memberName)) {
+            *column = i;
+            return true;
+        }
+    }
+    return false;
+}
+
+//====================================================
+const ReflMember * ReflColumnStore::GetColumnMember(unsigned column) const {
+    ASSERTGR(column < m_numColumns);
+    return m_columns[column].member;
+}
+
+//====================================================
+unsigned ReflColumnStore::GetColumnStride(unsigned column) const {
+    ASSERTGR(column < m_numColumns);
+    return m_columns[column].stride;
+}
+
+//====================================================
+void * ReflColumnStore::GetColumn(unsigned column) {
+    ASSERTGR(column < m_numColumns);
+    return m_columns[column].data;
+}
+
+//====================================================
+const void * ReflColumnStore::GetColumn(unsigned column) const {
+    ASSERTGR(column < m_numColumns);
+    return m_columns[column].data;
+}
+
+//====================================================
+unsigned ReflColumnStore::Add(const void * inst) {
+    if (m_size == m_capacity) 
+        Reserve(m_capacity > 0 ? 2 * m_capacity : s_minCapacity);
+
+    // Defaults first, class columns copy into constructed members
+    unsigned row = m_size++;
+    FillDefaults(row, 1);
+    Scatter(row, inst);
+    return row;
+}
+
+//====================================================
+void ReflColumnStore::Scatter(unsigned row, const void * inst) {
+    ASSERTMSGGR(row < m_size, "Row(%u) is out of range", row);
+    const byte * base = reinterpret_cast<const byte *>(inst);
+    for (unsigned i = 0; i < m_numColumns; i++) 
+        CopyToRow(m_columns[i], base, m_columns[i].data + row * m_columns[i].stride);
+}
+
+//====================================================
+void ReflColumnStore::Gather(unsigned row, void * inst) const {
+    ASSERTMSGGR(row < m_size, "Row(%u) is out of range", row);
+    byte * base = reinterpret_cast<byte *>(inst);
+    for (unsigned i = 0; i < m_numColumns; i++) 
+        CopyFromRow(m_columns[i], m_columns[i].data + row * m_columns[i].stride, base);
+}
+
+//====================================================
+void ReflColumnStore::Scatter(unsigned firstRow, const void * insts, unsigned stride, unsigned count) {
+    ASSERTMSGGR(firstRow + count <= m_size, "Rows(%u) are out of range", firstRow + count);
+    const byte * bases = reinterpret_cast<const byte *>(insts);
+    for (unsigned i = 0; i < m_numColumns; i++) {
+        const ColumnDesc & column = m_columns[i];
+        byte * dest = column.data + firstRow * column.stride;
+        if (column.kind == COLUMN_VALUE || column.kind == COLUMN_POINTER) {
+            CopyValues(bases + column.fieldOffset, stride, dest, column.stride, column.stride, count);
+            continue;
+        }
+
+        for (unsigned row = 0; row < count; row++) 
+            CopyToRow(column, bases + row * stride, dest + row * column.stride);
+    }
+}
+
+//====================================================
+void ReflColumnStore::Gather(unsigned firstRow, void * insts, unsigned stride, unsigned count) const {
+    ASSERTMSGGR(firstRow + count <= m_size, "Rows(%u) are out of range", firstRow + count);
+    byte * bases = reinterpret_cast<byte *>(insts);
+    for (unsigned i = 0; i < m_numColumns; i++) {
+        const ColumnDesc & column = m_columns[i];
+        const byte * src = column.data + firstRow * column.stride;
+        if (column.kind == COLUMN_VALUE || column.kind == COLUMN_POINTER) {
+            CopyValues(src, column.stride, bases + column.fieldOffset, stride, column.stride, count);
+            continue;
+        }
+
+        for (unsigned row = 0; row < count; row++) 
+            CopyFromRow(column, src + row * column.stride, bases + row * stride);
+    }
+}
+
+//====================================================
+void ReflColumnStore::RemoveSwap(unsigned row) {
+    ASSERTMSGGR(row < m_size, "Row(%u) is out of range", row);
+    unsigned last = --m_size;
+    if (row == last) 
+        return;
+
+    for (unsigned i = 0; i < m_numColumns; i++) {
+        const ColumnDesc & column = m_columns[i];
+        memcpy(column.data + row * column.stride, column.data + last * column.stride, column.stride);
+    }
+}
+
+//====================================================
+bool ReflColumnStore::Serialize(DataStream * stream) const {
+    unsigned numWritten = 0;
+    for (unsigned i = 0; i < m_numColumns; i++) {
+        if (m_columns[i].kind == COLUMN_VALUE || m_columns[i].kind == COLUMN_BITFIELD) 
+            numWritten++;
+    }
+
+    stream->Write<uint32>(s_columnMagic);
+    stream->Write<uint32>(s_columnVersion);
+    stream->Write<uint32>(m_desc->GetHash().GetValue());
+    stream->Write<uint32>(m_desc->GetVersion());
+    stream->Write<uint32>(m_size);
+    bool result = stream->Write<uint32>(numWritten) == STREAM_ERROR_OK;
+
+    for (unsigned i = 0; i < m_numColumns; i++) {
+        const ColumnDesc & column = m_columns[i];
+        if (column.kind != COLUMN_VALUE && column.kind != COLUMN_BITFIELD) 
+            continue;
+
+        stream->Write<uint32>(column.member->NameHash().GetValue());
+        stream->Write<uint32>(ColumnTypeHash(column.member, column.kind).GetValue());
+        stream->Write<uint32>(column.stride * m_size);
+        result = stream->WriteBytes(column.data, column.stride * m_size) == STREAM_ERROR_OK && result;
+    }
+
+    return stream->Flush() == STREAM_ERROR_OK && result;
+}
+
+//====================================================
+bool ReflColumnStore::Deserialize(DataStream * stream) {
+    uint32 magic        = 0;
+    uint32 version      = 0;
+    uint32 typeHash     = 0;
+    uint32 typeVersion  = 0;
+    uint32 numRows      = 0;
+    uint32 numColumns   = 0;
+    stream->Read(magic);
+    stream->Read(version);
+    stream->Read(typeHash);
+    stream->Read(typeVersion);
+    stream->Read(numRows);
+    if (stream->Read(numColumns) != STREAM_ERROR_OK) 
+        return false;
+
+    if (magic != s_columnMagic || version != s_columnVersion) {
+        LOG(LOG_PRIORITY_WARN, "Unsupported column file version(%u)", version);
+        return false;
+    }
+    if (typeHash != m_desc->GetHash().GetValue()) {
+        LOG(LOG_PRIORITY_WARN, "Column file of type(%x) doesn't match type(%s)", typeHash, m_desc->GetTypeName());
+        return false;
+    }
+
+    // Columns are matched by name and type, so older files still load
+    Clear();
+    Resize(numRows);
+    for (unsigned i = 0; i < numColumns; i++) {
+        uint32 nameHash     = 0;
+        uint32 columnType   = 0;
+        uint32 bytes        = 0;
+        stream->Read(nameHash);
+        stream->Read(columnType);
+        if (stream->Read(bytes) != STREAM_ERROR_OK) 
+            return false;
+
+        unsigned index = 0;
+        while (index < m_numColumns && m_columns[index].member->NameHash().GetValue() != nameHash) 
+            index++;
+
+        if (index < m_numColumns) {
+            const ColumnDesc & column = m_columns[index];
+            bool matches = (column.kind == COLUMN_VALUE || column.kind == COLUMN_BITFIELD) 
+                && ColumnTypeHash(column.member, column.kind).GetValue() == columnType 
+                && column.stride * numRows == bytes;
+            if (matches) {
+                if (stream->ReadBytes(column.data, bytes) != STREAM_ERROR_OK) 
+                    return false;
+                continue;
+            }
+            LOG(LOG_PRIORITY_INFO, "Skipping column(%s) of type(%x)", column.member->Name(), columnType);
+        }
+        stream->Skip(bytes);
+    }
+
+    return true;
+}
+
+//====================================================
+void ReflColumnStore::CopyToRow(const ColumnDesc & column, const byte * base, byte * dest) const {
+    const byte * field = base + column.fieldOffset;
+    if (column.kind == COLUMN_BITFIELD) {
+        int64 value = column.member->ReadBitfield(base, column.parentOffset);
+        memcpy(dest, &value, sizeof(value));
+    }
+    else if (column.kind == COLUMN_CLASS) 
+        column.classDesc->CopyInst(field, dest);
+    else
+        memcpy(dest, field, column.stride);
+}
+
+//====================================================
+void ReflColumnStore::CopyFromRow(const ColumnDesc & column, const byte * src, byte * base) const {
+    byte * field = base + column.fieldOffset;
+    if (column.kind == COLUMN_BITFIELD) {
+        int64 value = 0;
+        memcpy(&value, src, sizeof(value));
+        column.member->WriteBitfield(base, column.parentOffset, value);
+    }
+    else if (column.kind == COLUMN_CLASS) 
+        column.classDesc->CopyInst(src, field);
+    else
+        memcpy(field, src, column.stride);
+}
+
+//====================================================
+void ReflColumnStore::FillDefaults(unsigned firstRow, unsigned count) {
+    // Class columns copy the whole default member so unreflected state is 
+    //  constructed too
+    const byte * defaults = reinterpret_cast<const byte *>(m_defaults);
+    for (unsigned i = 0; i < m_numColumns; i++) {
+        const ColumnDesc & column = m_columns[i];
+        byte * dest = column.data + firstRow * column.stride;
+        if (column.kind == COLUMN_BITFIELD) {
+            for (unsigned row = 0; row < count; row++) 
+                CopyToRow(column, defaults, dest + row * column.stride);
+        }
+        else
+            CopyValues(defaults + column.fieldOffset, 0, dest, column.stride, column.stride, count);
+    }
+}
@@ -0,0 +1,346 @@
+/*
+   GameRiff - Framework for creating various video game services
+   Copy-on-write prototype instancing for reflected classes
+   Copyright (C) 2011, Shaun Leach.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are
+   met:
+  
+       * Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+       * Redistributions in binary form must reproduce the above
+   copyright notice, this list of conditions and the following disclaimer
+   in the documentation and/or other materials provided with the
+   distribution.
+  
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "Pch.h"
+
+LOG_DEFINE_MODULE(Reflection);
+
+//////////////////////////////////////////////////////
+//
+// Constants
+//
+
+// Node and attribute names of instance files, loads dispatch on their hashes
+static const ReflHash s_classNode(L"Class");
+static const ReflHash s_dataMemberNode(L"DataMember");
+static const ReflHash s_nameAttribute(L"Name");
+static const ReflHash s_typeAttribute(L"Type");
+static const ReflHash s_prototypeAttribute(L"Prototype");
+
+//////////////////////////////////////////////////////
+//
+// Internal Functions
+//
+
+//====================================================
+static unsigned OverrideWords(unsigned numMembers) {
+    return (numMembers + 31) / 32;
+}
+
+//====================================================
+static ReflClass * BaseToReflClass(const ReflTypeDesc * desc, void * base) {
+    return reinterpret_cast<ReflClass *>(desc->CastTo(base, desc->GetHash(), ReflClass::GetReflType()));
+}
+
+//////////////////////////////////////////////////////
+//
+// Member Functions
+//
+
+//====================================================
+ReflPrototype::ReflPrototype(const chargr * name, const ReflClass * body, MemFlags memFlags) :
+    m_nameHash(name),
+    m_desc(NULL),
+    m_body(NULL),
+    m_numMembers(0),
+    m_memFlags(memFlags),
+    m_next(NULL)
+{
+    StrCopy(m_name, 64, name);
+
+    m_desc = ReflLibrary::GetClassDesc(body);
+    ASSERTMSGGR(m_desc != NULL, "Prototype(%s) has an unregistered type", name);
+
+    // The prototype keeps its own copy so the source can't change underneath us
+    ReflClass * src = const_cast<ReflClass *>(body);
+    void * srcBase  = m_desc->CastTo(src, ReflClass::GetReflType(), m_desc->GetHash());
+    m_body          = m_desc->Clone(srcBase, memFlags);
+    m_numMembers    = m_desc->NumMembers();
+}
+
+//====================================================
+ReflPrototype::~ReflPrototype() {
+    if (m_body != NULL) {
+        m_desc->Destroy(m_body);
+        m_body = NULL;
+    }
+}
+
+//====================================================
+const ReflClass * ReflPrototype::GetBody() const {
+    return BaseToReflClass(m_desc, m_body);
+}
+
+//====================================================
+ReflInstance::ReflInstance() :
+    m_prototype(NULL),
+    m_body(NULL),
+    m_overrides(NULL)
+{
+}
+
+//====================================================
+ReflInstance::ReflInstance(ReflPrototypePtr prototype) :
+    m_prototype(prototype),
+    m_body(NULL),
+    m_overrides(NULL)
+{
+}
+
+//====================================================
+ReflInstance::ReflInstance(const ReflInstance & rhs) :
+    m_prototype(NULL),
+    m_body(NULL),
+    m_overrides(NULL)
+{
+    CopyFrom(rhs);
+}
+
+//====================================================
+ReflInstance::~ReflInstance() {
+    Release();
+}
+
+//====================================================
+ReflInstance & ReflInstance::operator=(const ReflInstance & rhs) {
+    if (this != &rhs) {
+        Release();
+        CopyFrom(rhs);
+    }
+
+    return *this;
+}
+
+//====================================================
+void ReflInstance::CopyFrom(const ReflInstance & rhs) {
+    m_prototype = rhs.m_prototype;
+    if (rhs.m_body != NULL) {
+        const ReflTypeDesc * desc = m_prototype->GetTypeDesc();
+        m_body = desc->Clone(rhs.m_body, m_prototype->GetMemFlags());
+
+        unsigned words  = OverrideWords(m_prototype->NumMembers());
+        m_overrides     = new(m_prototype->GetMemFlags()) uint32[words];
+        memcpy(m_overrides, rhs.m_overrides, words * sizeof(uint32));
+    }
+}
+
+#ifndef GOLD
+//====================================================
+bool ReflInstance::Deserialize(IStructuredTextStreamPtr stream) {
+    ReflHash nodeName;
+    stream->ReadNodeNameHash(&nodeName);
+    if (nodeName != s_classNode) {
+        ASSERTMSGGR(false, "Malformed XML file: %S. Instance node is not named Class", stream->GetName());
+        return false;
+    }
+
+    ReflHash prototypeHash;
+    if (stream->ReadNodeAttributeHash(s_prototypeAttribute, &prototypeHash) != STREAM_ERROR_OK) {
+        ASSERTMSGGR(false, "Malformed XML file: %s. Class node is missing Prototype attribute", stream->GetName());
+        return false;
+    }
+
+    // Names are only read back for messages
+    ReflPrototype * prototype = ReflLibrary::FindPrototype(prototypeHash);
+    if (prototype == NULL) {
+        StreamTextView prototypeName;
+        stream->ReadNodeAttributeView("Prototype", &prototypeName);
+        LOG(LOG_PRIORITY_WARN, "XML File %S references unregistered prototype: %.*s", stream->GetName(), prototypeName.len, prototypeName.str);
+        return false;
+    }
+
+    const ReflTypeDesc * desc = prototype->GetTypeDesc();
+    ReflHash typeHash;
+    if (stream->ReadNodeAttributeHash(s_typeAttribute, &typeHash) == STREAM_ERROR_OK) {
+        if (ReflLibrary::GetClassDesc(typeHash) != desc) {
+            StreamTextView prototypeName;
+            StreamTextView typeName;
+            stream->ReadNodeAttributeView("Prototype", &prototypeName);
+            stream->ReadNodeAttributeView("Type", &typeName);
+            ASSERTMSGGR(false, "XML File %S: prototype(%.*s) is not of type %.*s", stream->GetName(), prototypeName.len, prototypeName.str, typeName.len, typeName.str);
+            return false;
+        }
+    }
+
+    Release();
+    m_prototype = ReflPrototypePtr(prototype);
+
+    if (stream->ReadChildNode() == STREAM_ERROR_NODEDOESNTEXIST) 
+        return true;
+
+    Materialize();
+    ReflClass * inst = BaseToReflClass(desc, m_body);
+
+    do {
+        stream->ReadNodeNameHash(&nodeName);
+        if (nodeName != s_dataMemberNode) 
+            continue;
+
+        ReflHash nameHash;
+        EStreamError result = stream->ReadNodeAttributeHash(s_nameAttribute, &nameHash);
+        ASSERTMSGGR(result == STREAM_ERROR_OK, "Malformed XML file: %s. DataMember node is missing Name attribute", stream->GetName());
+
+        unsigned index = 0;
+        if (desc->FindMemberIndex(nameHash, &index)) {
+            unsigned offset = 0;
+            const ReflMember * member = desc->GetMember(index, &offset);
+            member->Deserialize(stream, nameHash, inst, m_body, offset);
+            m_overrides[index / 32] |= 1u << (index % 32);
+        }
+    } while (stream->ReadNextNode() != STREAM_ERROR_NODEDOESNTEXIST);
+
+    stream->ReadParentNode();
+
+    desc->FinalizeInst(m_body);
+
+    return true;
+}
+#endif
+
+//====================================================
+bool ReflInstance::IsOverridden(unsigned memberIndex) const {
+    if (m_overrides == NULL) 
+        return false;
+
+    ASSERTGR(memberIndex < m_prototype->NumMembers());
+    return (m_overrides[memberIndex / 32] & (1u << (memberIndex % 32))) != 0;
+}
+
+//====================================================
+void ReflInstance::Materialize() {
+    if (m_body != NULL) 
+        return;
+
+    ASSERTMSGGR(m_prototype != NULL, "Writing to an instance without a prototype");
+    const ReflTypeDesc * desc = m_prototype->GetTypeDesc();
+    m_body = desc->Clone(m_prototype->GetBodyBase(), m_prototype->GetMemFlags());
+
+    unsigned words  = OverrideWords(m_prototype->NumMembers());
+    m_overrides     = new(m_prototype->GetMemFlags()) uint32[words];
+    memset(m_overrides, 0, words * sizeof(uint32));
+}
+
+//====================================================
+unsigned ReflInstance::NumOverrides() const {
+    unsigned count = 0;
+    if (m_overrides != NULL) {
+        unsigned words = OverrideWords(m_prototype->NumMembers());
+        for (unsigned i = 0; i < words; i++) {
+            for (uint32 bits = m_overrides[i]; bits != 0; bits &= bits - 1) 
+                count++;
+        }
+    }
+
+    return count;
+}
+
+//====================================================
+const ReflClass * ReflInstance::Read() const {
+    if (m_prototype == NULL) 
+        return NULL;
+
+    if (m_body != NULL) 
+        return BaseToReflClass(m_prototype->GetTypeDesc(), m_body);
+
+    return m_prototype->GetBody();
+}
+
+//====================================================
+void ReflInstance::Release() {
+    if (m_body != NULL) {
+        m_prototype->GetTypeDesc()->Destroy(m_body);
+        m_body = NULL;
+    }
+    if (m_overrides != NULL) {
+        delete [] m_overrides;
+        m_overrides = NULL;
+    }
+}
+
+//====================================================
+void ReflInstance::Revert() {
+    Release();
+}
+
+#ifndef GOLD
+//====================================================
+bool ReflInstance::Serialize(IStructuredTextStreamPtr stream) const {
+    if (m_prototype == NULL) 
+        return false;
+
+    const ReflTypeDesc * desc = m_prototype->GetTypeDesc();
+
+    stream->WriteNode(L"Class");
+    stream->WriteNodeAttribute(L"Type", desc->GetTypeName());
+    chargr versionStr[32];
+    StrPrintf(versionStr, 32, L"0x%x", desc->GetVersion());
+    stream->WriteNodeAttribute(L"Version", versionStr);
+    stream->WriteNodeAttribute(L"Prototype", m_prototype->GetName());
+
+    if (m_body != NULL) {
+        const ReflClass * inst = Read();
+        for (unsigned i = 0; i < m_prototype->NumMembers(); i++) {
+            if (!IsOverridden(i)) 
+                continue;
+
+            unsigned offset = 0;
+            const ReflMember * member = desc->GetMember(i, &offset);
+            member->Serialize(stream, inst, m_body, offset);
+        }
+    }
+
+    stream->EndNode();
+
+    return true;
+}
+#endif
+
+//====================================================
+ReflClass * ReflInstance::Write(ReflHash memberName) {
+    ASSERTMSGGR(m_prototype != NULL, "Writing to an instance without a prototype");
+
+    unsigned index = 0;
+    bool found = m_prototype->GetTypeDesc()->FindMemberIndex(memberName, &index);
+    ASSERTMSGGR(found, "Writing unknown member of prototype(%s)", m_prototype->GetName());
+    if (!found) 
+        return NULL;
+
+    return Write(index);
+}
+
+//====================================================
+ReflClass * ReflInstance::Write(unsigned memberIndex) {
+    Materialize();
+
+    ASSERTGR(memberIndex < m_prototype->NumMembers());
+    m_overrides[memberIndex / 32] |= 1u << (memberIndex % 32);
+
+    return BaseToReflClass(m_prototype->GetTypeDesc(), m_body);
+}
+
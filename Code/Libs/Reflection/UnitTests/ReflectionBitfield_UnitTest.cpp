@@ -0,0 +1,190 @@
+/*
+   GameRiff - Framework for creating various video game services
+   Unit tests for reflected bitfield members
+   Copyright (C) 2011, Shaun Leach.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are
+   met:
+  
+       * Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+       * Redistributions in binary form must reproduce the above
+   copyright notice, this list of conditions and the following disclaimer
+   in the documentation and/or other materials provided with the
+   distribution.
+  
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+
+#include <gtest/gtest.h>
+
+#include "Pch.h"
+
+//////////////////////////////////////////////////////
+//
+// Internal constants
+//
+static const uint32    s_uint32Value     =  320000;
+static const int32     s_countValue      =  -3;
+
+//////////////////////////////////////////////////////
+//
+// Test bitfield members, packed binary and named text values
+//
+
+enum EBitfieldMode {
+    BITFIELD_MODE_OFF,
+    BITFIELD_MODE_LOW,
+    BITFIELD_MODE_HIGH,
+};
+
+REFL_ENUM_IMPL_BEGIN(EBitfieldMode);
+    REFL_ENUM_VALUE(BITFIELD_MODE_OFF, Off);
+    REFL_ENUM_VALUE(BITFIELD_MODE_LOW, Low);
+    REFL_ENUM_VALUE(BITFIELD_MODE_HIGH, High);
+REFL_ENUM_IMPL_END(EBitfieldMode);
+
+class BitfieldClass : public ReflClass {
+public:
+    REFL_DEFINE_CLASS(BitfieldClass);
+    BitfieldClass() :
+        visibleTest(false),
+        shadowTest(0),
+        modeTest(BITFIELD_MODE_OFF),
+        countTest(0),
+        unreflectedTest(0),
+        uint32Test(0)
+    {
+        InitReflType();
+    }
+
+//private:
+    bool            visibleTest     : 1;
+    uint32          shadowTest      : 1;
+    EBitfieldMode   modeTest        : 3;
+    int32           countTest       : 5;
+    uint32          unreflectedTest : 4;
+    uint32          uint32Test;
+};
+
+REFL_IMPL_CLASS_BEGIN(ReflClass, BitfieldClass);
+    REFL_BITFIELD_MEMBER(visibleTest);
+    REFL_BITFIELD_MEMBER(shadowTest);
+    REFL_BITFIELD_MEMBER(modeTest);
+    REFL_BITFIELD_MEMBER(countTest);
+    REFL_MEMBER(uint32Test);
+REFL_IMPL_CLASS_END(BitfieldClass);
+
+//====================================================
+static void FillBitfields(BitfieldClass * inst) {
+    inst->visibleTest       = true;
+    inst->shadowTest        = 0;
+    inst->modeTest          = BITFIELD_MODE_HIGH;
+    inst->countTest         = s_countValue;
+    inst->unreflectedTest   = 0;
+    inst->uint32Test        = s_uint32Value;
+}
+
+//====================================================
+static void CheckBitfields(const BitfieldClass * inst) {
+    ASSERT_TRUE(inst != NULL);
+    EXPECT_EQ(true,                 inst->visibleTest);
+    EXPECT_EQ(0u,                   inst->shadowTest);
+    EXPECT_EQ(BITFIELD_MODE_HIGH,   inst->modeTest);
+    EXPECT_EQ(s_countValue,         inst->countTest);
+    EXPECT_EQ(s_uint32Value,        inst->uint32Test);
+}
+
+//====================================================
+TEST(ReflectionTest, TestBitfieldLayout) {
+    const ReflTypeDesc * desc = BitfieldClass::GetReflectionInfo();
+    ASSERT_TRUE(desc != NULL);
+
+    const ReflMember * visible  = desc->FindMember(ReflHash(L"visibleTest"));
+    const ReflMember * mode     = desc->FindMember(ReflHash(L"modeTest"));
+    const ReflMember * count    = desc->FindMember(ReflHash(L"countTest"));
+    ASSERT_TRUE(visible != NULL && mode != NULL && count != NULL);
+    EXPECT_TRUE(visible->IsBitfield());
+    EXPECT_EQ(1u, visible->GetBitWidth());
+    EXPECT_EQ(3u, mode->GetBitWidth());
+    EXPECT_EQ(5u, count->GetBitWidth());
+    EXPECT_FALSE(desc->FindMember(ReflHash(L"uint32Test"))->IsBitfield());
+
+    BitfieldClass inst;
+    FillBitfields(&inst);
+    EXPECT_EQ(s_countValue, count->ReadBitfield(&inst, 0));
+    EXPECT_EQ(BITFIELD_MODE_HIGH, mode->ReadBitfield(&inst, 0));
+
+    // Writing a field leaves its neighbours alone
+    inst.unreflectedTest = 0xf;
+    mode->WriteBitfield(&inst, 0, BITFIELD_MODE_LOW);
+    EXPECT_EQ(BITFIELD_MODE_LOW, inst.modeTest);
+    EXPECT_EQ(s_countValue, inst.countTest);
+    EXPECT_EQ(0xfu, inst.unreflectedTest);
+}
+
+//====================================================
+TEST(ReflectionTest, TestBitfieldCopy) {
+    BitfieldClass inst;
+    FillBitfields(&inst);
+
+    BitfieldClass copy;
+    copy.unreflectedTest = 0xa;
+    BitfieldClass::GetReflectionInfo()->CopyInst(&inst, &copy);
+    CheckBitfields(&copy);
+    EXPECT_EQ(0xau, copy.unreflectedTest);
+    EXPECT_EQ(ReflLibrary::HashContents(&inst), ReflLibrary::HashContents(&copy));
+
+    copy.shadowTest = 1;
+    EXPECT_NE(ReflLibrary::HashContents(&inst), ReflLibrary::HashContents(&copy));
+}
+
+//====================================================
+TEST(ReflectionTest, TestBitfieldBinary) {
+    BitfieldClass inst;
+    FillBitfields(&inst);
+
+    byte memory[256];
+    DataStream writeStream(StreamOpenMemory(memory, sizeof(memory)));
+    EXPECT_EQ(true, ReflLibrary::Serialize(&writeStream, &inst));
+
+    DataStream readStream(StreamOpenMemory(memory, sizeof(memory)));
+    ReflClass * loadInst = ReflLibrary::Deserialize(&readStream, MemFlags(MEM_ARENA_DEFAULT, MEM_CAT_TEST));
+    CheckBitfields(ReflCast<BitfieldClass>(loadInst));
+
+    ReflLibrary::DestroyBatch(loadInst);
+}
+
+#ifndef GOLD
+//====================================================
+TEST(ReflectionTest, TestBitfieldText) {
+    BitfieldClass inst;
+    FillBitfields(&inst);
+
+    IStructuredTextStreamPtr testStream = StreamCreateXML(L"testBitfield.xml");
+    ASSERT_TRUE(testStream != NULL);
+    EXPECT_EQ(true, ReflLibrary::Serialize(testStream, &inst));
+    testStream->Save();
+
+    testStream = StreamOpenXML(L"testBitfield.xml");
+    ASSERT_TRUE(testStream != NULL);
+    ReflClass * loadInst = ReflLibrary::Deserialize(testStream, MemFlags(MEM_ARENA_DEFAULT, MEM_CAT_TEST));
+    BitfieldClass * loadBitfield = ReflCast<BitfieldClass>(loadInst);
+    CheckBitfields(loadBitfield);
+
+    delete loadBitfield;
+}
+#endif
@@ -0,0 +1,355 @@
+/*
+   GameRiff - Framework for creating various video game services
+   Reflection unit tests
+   Copyright (C) 2011, Shaun Leach.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are
+   met:
+  
+       * Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+       * Redistributions in binary form must reproduce the above
+   copyright notice, this list of conditions and the following disclaimer
+   in the documentation and/or other materials provided with the
+   distribution.
+  
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include <gtest/gtest.h>
+
+#include "Pch.h"
+
+LOG_DEFINE_MODULE(Reflection Unit Tests);
+
+//////////////////////////////////////////////////////
+//
+// Internal constants
+//
+static const unsigned  s_numParticles    = 1000;
+static const unsigned  s_numBenchmark    = 65536;
+static const unsigned  s_numFrames       = 64;
+static const float32   s_frameTime       = 1.0f / 60.0f;
+
+//////////////////////////////////////////////////////
+//
+// Test structure of arrays storage
+//
+
+class ColumnBodyClass : public ReflClass {
+public:
+    REFL_DEFINE_CLASS(ColumnBodyClass);
+    ColumnBodyClass() :
+        massTest(1.0f),
+        dragTest(0.5f)
+    {
+        InitReflType();
+    }
+
+//private:
+    float32     massTest;
+    float32     dragTest;
+};
+
+REFL_IMPL_CLASS_BEGIN(ReflClass, ColumnBodyClass);
+    REFL_MEMBER(massTest);
+    REFL_MEMBER(dragTest);
+REFL_IMPL_CLASS_END(ColumnBodyClass);
+
+// Typical simulation type, a frame only touches the positions and velocities
+class ColumnParticleClass : public ColumnBodyClass {
+public:
+    REFL_DEFINE_CLASS(ColumnParticleClass);
+    ColumnParticleClass() :
+        posXTest(0.0f),
+        posYTest(0.0f),
+        posZTest(0.0f),
+        velXTest(0.0f),
+        velYTest(0.0f),
+        velZTest(0.0f),
+        idTest(0),
+        activeTest(false),
+        layerTest(0),
+        targetTest(NULL)
+    {
+        InitReflType();
+        memset(spareTest, 0, sizeof(spareTest));
+    }
+
+//private:
+    float32                 posXTest;
+    float32                 posYTest;
+    float32                 posZTest;
+    float32                 velXTest;
+    float32                 velYTest;
+    float32                 velZTest;
+    uint32                  idTest;
+    bool                    activeTest  : 1;
+    uint32                  layerTest   : 4;
+    ColumnParticleClass   * targetTest;
+    uint32                  spareTest[8];
+};
+
+REFL_IMPL_CLASS_BEGIN(ColumnBodyClass, ColumnParticleClass);
+    REFL_ADD_PARENT(ColumnBodyClass);
+    REFL_MEMBER(posXTest);
+    REFL_MEMBER(posYTest);
+    REFL_MEMBER(posZTest);
+    REFL_MEMBER(velXTest);
+    REFL_MEMBER(velYTest);
+    REFL_MEMBER(velZTest);
+    REFL_MEMBER(idTest);
+    REFL_BITFIELD_MEMBER(activeTest);
+    REFL_BITFIELD_MEMBER(layerTest);
+    REFL_POINTER_MEMBER(targetTest);
+REFL_IMPL_CLASS_END(ColumnParticleClass);
+
+//====================================================
+static void FillParticle(ColumnParticleClass * particle, unsigned index) {
+    particle->massTest      = 1.0f + index;
+    particle->dragTest      = 0.25f * index;
+    particle->posXTest      = static_cast<float32>(index);
+    particle->posYTest      = 2.0f * index;
+    particle->posZTest      = -1.0f * index;
+    particle->velXTest      = 0.5f;
+    particle->velYTest      = -0.25f * (index % 7);
+    particle->velZTest      = 1.0f;
+    particle->idTest        = 1000 + index;
+    particle->activeTest    = (index % 3) == 0;
+    particle->layerTest     = index % 16;
+    particle->targetTest    = particle;
+}
+
+//====================================================
+static void CheckParticle(const ColumnParticleClass & expected, const ColumnParticleClass & actual) {
+    EXPECT_EQ(expected.massTest,    actual.massTest);
+    EXPECT_EQ(expected.dragTest,    actual.dragTest);
+    EXPECT_EQ(expected.posXTest,    actual.posXTest);
+    EXPECT_EQ(expected.posYTest,    actual.posYTest);
+    EXPECT_EQ(expected.posZTest,    actual.posZTest);
+    EXPECT_EQ(expected.velXTest,    actual.velXTest);
+    EXPECT_EQ(expected.velYTest,    actual.velYTest);
+    EXPECT_EQ(expected.velZTest,    actual.velZTest);
+    EXPECT_EQ(expected.idTest,      actual.idTest);
+    EXPECT_EQ(expected.activeTest,  actual.activeTest);
+    EXPECT_EQ(expected.layerTest,   actual.layerTest);
+}
+
+//====================================================
+TEST(ReflectionTest, TestColumnsGatherScatter) {
+    ReflColumns<ColumnParticleClass> columns(MemFlags(MEM_ARENA_DEFAULT, MEM_CAT_TEST));
+    EXPECT_EQ(12u, columns.NumColumns());
+
+    ColumnParticleClass * particles = new ColumnParticleClass[s_numParticles];
+    for (unsigned i = 0; i < s_numParticles; i++) {
+        FillParticle(&particles[i], i);
+        EXPECT_EQ(i, columns.Add(particles[i]));
+    }
+    ASSERT_EQ(s_numParticles, columns.Size());
+
+    // Parent members come first and every column is contiguous
+    const float32 * mass    = columns.Column<float32>(ReflHash(L"massTest"));
+    const float32 * posY    = columns.Column<float32>(ReflHash(L"posYTest"));
+    const int64 * layer     = columns.Column<int64>(ReflHash(L"layerTest"));
+    ASSERT_TRUE(mass != NULL);
+    ASSERT_TRUE(posY != NULL);
+    ASSERT_TRUE(layer != NULL);
+    EXPECT_TRUE(columns.Column<uint16>(ReflHash(L"posYTest")) == NULL);
+    EXPECT_EQ(0, reinterpret_cast<size_t>(posY) % 16);
+    for (unsigned i = 0; i < s_numParticles; i++) {
+        EXPECT_EQ(particles[i].massTest,    mass[i]);
+        EXPECT_EQ(particles[i].posYTest,    posY[i]);
+        EXPECT_EQ(particles[i].layerTest,   layer[i]);
+    }
+
+    ColumnParticleClass single;
+    columns.Gather(17, &single);
+    CheckParticle(particles[17], single);
+    EXPECT_EQ(&particles[17], single.targetTest);
+
+    ColumnParticleClass * gathered = new ColumnParticleClass[s_numParticles];
+    columns.Gather(0, gathered, s_numParticles);
+    for (unsigned i = 0; i < s_numParticles; i++) 
+        CheckParticle(particles[i], gathered[i]);
+
+    // Bulk scatter over the second half, rows are unchanged elsewhere
+    for (unsigned i = 0; i < s_numParticles; i++) 
+        FillParticle(&particles[i], 3 * i);
+    columns.Scatter(s_numParticles / 2, particles + s_numParticles / 2, s_numParticles / 2);
+    columns.Gather(0, gathered, s_numParticles);
+    for (unsigned i = 0; i < s_numParticles; i++) {
+        ColumnParticleClass expected;
+        FillParticle(&expected, i < s_numParticles / 2 ? i : 3 * i);
+        CheckParticle(expected, gathered[i]);
+    }
+
+    columns.RemoveSwap(0);
+    EXPECT_EQ(s_numParticles - 1, columns.Size());
+    columns.Gather(0, &single);
+    CheckParticle(particles[s_numParticles - 1], single);
+
+    // New rows take the defaults of the type
+    columns.Resize(s_numParticles + 10);
+    columns.Gather(s_numParticles + 5, &single);
+    CheckParticle(ColumnParticleClass(), single);
+    EXPECT_TRUE(single.targetTest == NULL);
+
+    delete [] gathered;
+    delete [] particles;
+}
+
+//====================================================
+TEST(ReflectionTest, TestColumnsBinary) {
+    ReflColumns<ColumnParticleClass> columns(MemFlags(MEM_ARENA_DEFAULT, MEM_CAT_TEST));
+    ColumnParticleClass particle;
+    for (unsigned i = 0; i < s_numParticles; i++) {
+        FillParticle(&particle, i);
+        columns.Add(particle);
+    }
+
+    {
+        IRawStreamPtr rawStream = StreamCreateFile(L"testColumns.bin");
+        ASSERT_TRUE(rawStream != NULL);
+        DataStream stream(rawStream);
+        EXPECT_EQ(true, columns.Serialize(&stream));
+    }
+
+    ReflColumns<ColumnParticleClass> loaded(MemFlags(MEM_ARENA_DEFAULT, MEM_CAT_TEST));
+    IRawStreamPtr rawStream = StreamOpenFile(L"testColumns.bin");
+    ASSERT_TRUE(rawStream != NULL);
+    DataStream stream(rawStream);
+    EXPECT_EQ(true, loaded.Deserialize(&stream));
+    ASSERT_EQ(s_numParticles, loaded.Size());
+
+    // Pointers aren't written and keep their defaults
+    ColumnParticleClass expected;
+    for (unsigned i = 0; i < s_numParticles; i++) {
+        FillParticle(&expected, i);
+        loaded.Gather(i, &particle);
+        CheckParticle(expected, particle);
+        EXPECT_TRUE(particle.targetTest == NULL);
+    }
+
+    // Files of another type are rejected
+    ReflColumns<ColumnBodyClass> bodies(MemFlags(MEM_ARENA_DEFAULT, MEM_CAT_TEST));
+    IRawStreamPtr otherStream = StreamOpenFile(L"testColumns.bin");
+    ASSERT_TRUE(otherStream != NULL);
+    DataStream other(otherStream);
+    EXPECT_EQ(false, bodies.Deserialize(&other));
+}
+
+//====================================================
+static void IntegrateParticles(ColumnParticleClass * particles, unsigned count) {
+    for (unsigned i = 0; i < count; i++) {
+        particles[i].posXTest += particles[i].velXTest * s_frameTime;
+        particles[i].posYTest += particles[i].velYTest * s_frameTime;
+        particles[i].posZTest += particles[i].velZTest * s_frameTime;
+    }
+}
+
+//====================================================
+static void IntegrateColumn(float32 * pos, const float32 * vel, unsigned count) {
+    for (unsigned i = 0; i < count; i++) 
+        pos[i] += vel[i] * s_frameTime;
+}
+
+//====================================================
+// Columns updated in place gather back to the same structs as updating the
+//  structs directly
+TEST(ReflectionTest, TestColumnsUpdate) {
+    ColumnParticleClass * particles = new ColumnParticleClass[s_numParticles];
+    for (unsigned i = 0; i < s_numParticles; i++) 
+        FillParticle(&particles[i], i);
+
+    ReflColumns<ColumnParticleClass> columns(MemFlags(MEM_ARENA_DEFAULT, MEM_CAT_TEST));
+    columns.Resize(s_numParticles);
+    columns.Scatter(0, particles, s_numParticles);
+    IntegrateParticles(particles, s_numParticles);
+
+    float32 * posX = columns.Column<float32>(ReflHash(L"posXTest"));
+    float32 * posY = columns.Column<float32>(ReflHash(L"posYTest"));
+    float32 * posZ = columns.Column<float32>(ReflHash(L"posZTest"));
+    const float32 * velX = columns.Column<float32>(ReflHash(L"velXTest"));
+    const float32 * velY = columns.Column<float32>(ReflHash(L"velYTest"));
+    const float32 * velZ = columns.Column<float32>(ReflHash(L"velZTest"));
+    IntegrateColumn(posX, velX, s_numParticles);
+    IntegrateColumn(posY, velY, s_numParticles);
+    IntegrateColumn(posZ, velZ, s_numParticles);
+
+    ColumnParticleClass * gathered = new ColumnParticleClass[s_numParticles];
+    columns.Gather(0, gathered, s_numParticles);
+    for (unsigned i = 0; i < s_numParticles; i++) 
+        CheckParticle(particles[i], gathered[i]);
+
+    delete [] gathered;
+    delete [] particles;
+}
+
+//====================================================
+// Compares a position update over arrays of structs and columns. Timings
+//  go to the log. Disabled, run with --gtest_also_run_disabled_tests.
+TEST(ReflectionTest, DISABLED_TestColumnsBenchmark) {
+    ColumnParticleClass * particles = new ColumnParticleClass[s_numBenchmark];
+    for (unsigned i = 0; i < s_numBenchmark; i++) 
+        FillParticle(&particles[i], i);
+
+    ReflColumns<ColumnParticleClass> columns(MemFlags(MEM_ARENA_DEFAULT, MEM_CAT_TEST));
+    columns.Resize(s_numBenchmark);
+
+    uint64 start = TimerGetTicks();
+    columns.Scatter(0, particles, s_numBenchmark);
+    uint64 scatterTicks = TimerGetTicks() - start;
+
+    start = TimerGetTicks();
+    for (unsigned frame = 0; frame < s_numFrames; frame++) 
+        IntegrateParticles(particles, s_numBenchmark);
+    uint64 structTicks = TimerGetTicks() - start;
+
+    float32 * posX = columns.Column<float32>(ReflHash(L"posXTest"));
+    float32 * posY = columns.Column<float32>(ReflHash(L"posYTest"));
+    float32 * posZ = columns.Column<float32>(ReflHash(L"posZTest"));
+    const float32 * velX = columns.Column<float32>(ReflHash(L"velXTest"));
+    const float32 * velY = columns.Column<float32>(ReflHash(L"velYTest"));
+    const float32 * velZ = columns.Column<float32>(ReflHash(L"velZTest"));
+    start = TimerGetTicks();
+    for (unsigned frame = 0; frame < s_numFrames; frame++) {
+        IntegrateColumn(posX, velX, s_numBenchmark);
+        IntegrateColumn(posY, velY, s_numBenchmark);
+        IntegrateColumn(posZ, velZ, s_numBenchmark);
+    }
+    uint64 columnTicks = TimerGetTicks() - start;
+
+    ColumnParticleClass * gathered = new ColumnParticleClass[s_numBenchmark];
+    start = TimerGetTicks();
+    columns.Gather(0, gathered, s_numBenchmark);
+    uint64 gatherTicks = TimerGetTicks() - start;
+
+    for (unsigned i = 0; i < s_numBenchmark; i++) 
+        CheckParticle(particles[i], gathered[i]);
+
+    LOG(
+        LOG_PRIORITY_INFO, 
+        L"%u particles, %u frames: structs %llu ns, columns %llu ns, scatter %llu ns, gather %llu ns", 
+        s_numBenchmark, 
+        s_numFrames,
+        TimerTicksToNanoseconds(structTicks),
+        TimerTicksToNanoseconds(columnTicks),
+        TimerTicksToNanoseconds(scatterTicks),
+        TimerTicksToNanoseconds(gatherTicks)
+    );
+
+    delete [] gathered;
+    delete [] particles;
+}
@@ -226,3 +226,169 @@ TEST(ReflectionTest, TestClassConversion) {
 }
 
 
+
+//////////////////////////////////////////////////////
+//
+// Test batch numeric member conversion
+//
+
+class BatchConversionClass : public ReflClass {
+public:
+    REFL_DEFINE_CLASS(BatchConversionClass);
+    BatchConversionClass() :
+        scaledInt16Test(0),
+        wideInt32Test(0),
+        narrowUint8Test(0),
+        nextTest(NULL)
+    {
+        InitReflType();
+    }
+
+//private:
+    int16                   scaledInt16Test;
+    int32                   wideInt32Test;
+    uint8                   narrowUint8Test;
+    BatchConversionClass  * nextTest;
+};
+
+REFL_IMPL_CLASS_BEGIN(ReflClass, BatchConversionClass);
+    REFL_MEMBER(scaledInt16Test);
+        REFL_ADD_MEMBER_SCALED_CONVERSION(scaledInt16Test, 100.0f);
+    REFL_MEMBER(wideInt32Test);
+        REFL_ADD_MEMBER_NUMERIC_CONVERSION(wideInt32Test);
+    REFL_MEMBER(narrowUint8Test);
+        REFL_ADD_MEMBER_NUMERIC_CONVERSION(narrowUint8Test);
+    REFL_POINTER_MEMBER(nextTest);
+REFL_IMPL_CLASS_END(BatchConversionClass);
+
+//====================================================
+static const ReflMember * FindBatchMember(const chargr * name) {
+    const ReflTypeDesc * desc = ReflLibrary::GetClassDesc(ReflHash(L"BatchConversionClass"));
+    if (desc == NULL) 
+        return NULL;
+    return desc->FindMember(ReflHash(name));
+}
+
+//====================================================
+TEST(ReflectionTest, TestBatchNumericConversion) {
+    const ReflMember * scaledMember = FindBatchMember(L"scaledInt16Test");
+    const ReflMember * wideMember   = FindBatchMember(L"wideInt32Test");
+    const ReflMember * narrowMember = FindBatchMember(L"narrowUint8Test");
+    ASSERT_TRUE(scaledMember != NULL);
+    ASSERT_TRUE(wideMember != NULL);
+    ASSERT_TRUE(narrowMember != NULL);
+    EXPECT_EQ(100.0f, scaledMember->GetConversionScale());
+
+    // Odd counts leave a scalar tail after the vector loop
+    static const unsigned s_count = 67;
+    float32 floats[s_count];
+    int16   shorts[s_count];
+    int32   ints[s_count];
+    for (unsigned i = 0; i < s_count; i++) {
+        floats[i]   = (static_cast<float32>(i) - 30.0f) * 12.5f;
+        shorts[i]   = static_cast<int16>((i * 977) - 32768);
+        ints[i]     = static_cast<int32>(i * 11) - 100;
+    }
+    floats[3]   = 1e9f;
+    floats[4]   = -1e9f;
+    floats[5]   = 0.125f;
+    floats[6]   = 0.375f;
+    floats[7]   = 0.0f;
+    floats[7]   = floats[7] / floats[7];
+
+    int16 scaled[s_count];
+    scaledMember->ConvertValues(ReflHash(L"float32"), floats, sizeof(float32), scaled, sizeof(int16), s_count);
+    EXPECT_EQ(32767,    scaled[3]);
+    EXPECT_EQ(-32768,   scaled[4]);
+    EXPECT_EQ(12,       scaled[5]);
+    EXPECT_EQ(38,       scaled[6]);
+    EXPECT_EQ(0,        scaled[7]);
+    for (unsigned i = 8; i < s_count; i++) {
+        float32 value = floats[i] * 100.0f;
+        EXPECT_EQ(value > 32767.0f ? 32767 : static_cast<int16>(value), scaled[i]);
+    }
+
+    int32 wide[s_count];
+    wideMember->ConvertValues(ReflHash(L"int16"), shorts, sizeof(int16), wide, sizeof(int32), s_count);
+    for (unsigned i = 0; i < s_count; i++) 
+        EXPECT_EQ(shorts[i], wide[i]);
+
+    uint8 narrow[s_count];
+    narrowMember->ConvertValues(ReflHash(L"int32"), ints, sizeof(int32), narrow, sizeof(uint8), s_count);
+    for (unsigned i = 0; i < s_count; i++) 
+        EXPECT_EQ(ints[i] < 0 ? 0 : (ints[i] > 255 ? 255 : ints[i]), narrow[i]);
+
+    // Strided values convert in place inside objects
+    BatchConversionClass objects[s_count];
+    scaledMember->ConvertValues(ReflHash(L"float32"), floats, sizeof(float32), &objects[0].scaledInt16Test, sizeof(BatchConversionClass), s_count);
+    wideMember->ConvertValues(ReflHash(L"int16"), shorts, sizeof(int16), &objects[0].wideInt32Test, sizeof(BatchConversionClass), s_count);
+    for (unsigned i = 0; i < s_count; i++) {
+        EXPECT_EQ(scaled[i],    objects[i].scaledInt16Test);
+        EXPECT_EQ(wide[i],      objects[i].wideInt32Test);
+    }
+}
+
+//====================================================
+TEST(ReflectionTest, TestBatchConversionGraph) {
+    // Write version 1 of the class by hand, when every member was a float32
+    static const unsigned s_count = 21;
+    IStructuredTextStreamPtr testStream = StreamCreateXML(L"testBatchConversion.xml");
+    ASSERT_TRUE(testStream != NULL);
+    for (unsigned i = 0; i < s_count; i++) {
+        chargr value[32];
+        testStream->WriteNode(L"Class");
+        testStream->WriteNodeAttribute(L"Type", L"BatchConversionClass");
+        testStream->WriteNodeAttribute(L"Version", L"0x1");
+
+        testStream->WriteNode(L"DataMember");
+        testStream->WriteNodeAttribute(L"Name", L"scaledInt16Test");
+        testStream->WriteNodeAttribute(L"Type", L"float32");
+        StrPrintf(value, 32, L"%f", 0.25f * i);
+        testStream->WriteNodeValue(value);
+        testStream->EndNode();
+
+        testStream->WriteNode(L"DataMember");
+        testStream->WriteNodeAttribute(L"Name", L"wideInt32Test");
+        testStream->WriteNodeAttribute(L"Type", L"int16");
+        StrPrintf(value, 32, L"%d", -1000 * static_cast<int>(i));
+        testStream->WriteNodeValue(value);
+        testStream->EndNode();
+
+        testStream->WriteNode(L"DataMember");
+        testStream->WriteNodeAttribute(L"Name", L"narrowUint8Test");
+        testStream->WriteNodeAttribute(L"Type", L"int32");
+        StrPrintf(value, 32, L"%d", 20 * static_cast<int>(i));
+        testStream->WriteNodeValue(value);
+        testStream->EndNode();
+
+        testStream->WriteNode(L"DataMember");
+        testStream->WriteNodeAttribute(L"Name", L"nextTest");
+        testStream->WriteNodeAttribute(L"Type", L"pointer");
+        if (i + 1 < s_count) {
+            StrPrintf(value, 32, L"%u", i + 1);
+            testStream->WriteNodeValue(value);
+        }
+        else 
+            testStream->WriteNodeValue(L"null");
+        testStream->EndNode();
+
+        testStream->EndNode();
+    }
+    testStream->Save();
+
+    testStream = StreamOpenXML(L"testBatchConversion.xml");
+    ASSERT_TRUE(testStream != NULL);
+    ReflClass * inst = ReflLibrary::Deserialize(testStream, MemFlags(MEM_ARENA_DEFAULT, MEM_CAT_TEST));
+    BatchConversionClass * node = ReflCast<BatchConversionClass>(inst);
+    ASSERT_TRUE(node != NULL);
+
+    unsigned count = 0;
+    for (; node != NULL; node = node->nextTest, count++) {
+        EXPECT_EQ(static_cast<int16>(25 * count),                       node->scaledInt16Test);
+        EXPECT_EQ(-1000 * static_cast<int32>(count),                    node->wideInt32Test);
+        EXPECT_EQ(20 * count > 255 ? 255 : 20 * count,                  node->narrowUint8Test);
+    }
+    EXPECT_EQ(s_count, count);
+
+    ReflLibrary::DestroyGraph(inst);
+}
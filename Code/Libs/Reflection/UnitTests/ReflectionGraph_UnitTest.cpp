@@ -0,0 +1,435 @@
+/*
+   GameRiff - Framework for creating various video game services
+   Unit tests for object graph serialization
+   Copyright (C) 2011, Shaun Leach.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are
+   met:
+  
+       * Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+       * Redistributions in binary form must reproduce the above
+   copyright notice, this list of conditions and the following disclaimer
+   in the documentation and/or other materials provided with the
+   distribution.
+  
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include <gtest/gtest.h>
+
+#include "Pch.h"
+
+//////////////////////////////////////////////////////
+//
+// Internal constants
+//
+static const uint32    s_uint32Value     =  320000;
+static const float32   s_float32Value    =  32.32f;
+
+//////////////////////////////////////////////////////
+//
+// Test pointer members
+//
+
+class GraphLeafClass : public ReflClass {
+public:
+    REFL_DEFINE_CLASS(GraphLeafClass);
+    GraphLeafClass() :
+        leafFloat32Test(0.0f)
+    {
+        InitReflType();
+    }
+
+//private:
+    float32     leafFloat32Test;
+};
+
+REFL_IMPL_CLASS_BEGIN(ReflClass, GraphLeafClass);
+    REFL_MEMBER(leafFloat32Test);
+REFL_IMPL_CLASS_END(GraphLeafClass);
+
+class GraphNodeClass : public ReflClass {
+public:
+    REFL_DEFINE_CLASS(GraphNodeClass);
+    GraphNodeClass() :
+        nodeUint32Test(0),
+        nextTest(NULL),
+        leafTest(NULL),
+        finalizedLeafValue(0.0f)
+    {
+        InitReflType();
+    }
+
+    static void Finalize(ReflClass * inst) {
+        GraphNodeClass * node = ReflCast<GraphNodeClass>(inst);
+        if (node != NULL && node->leafTest != NULL) 
+            node->finalizedLeafValue = node->leafTest->leafFloat32Test;
+    }
+
+//private:
+    uint32              nodeUint32Test;
+    GraphNodeClass    * nextTest;
+    GraphLeafClass    * leafTest;
+    float32             finalizedLeafValue;
+};
+
+REFL_IMPL_CLASS_BEGIN(ReflClass, GraphNodeClass);
+    REFL_FINALIZATION_FUNC(GraphNodeClass::Finalize);
+    REFL_MEMBER(nodeUint32Test);
+    REFL_POINTER_MEMBER(nextTest);
+    REFL_POINTER_MEMBER(leafTest);
+REFL_IMPL_CLASS_END(GraphNodeClass);
+
+//====================================================
+static void BuildGraph(GraphNodeClass * nodeA, GraphNodeClass * nodeB, GraphLeafClass * leaf) {
+    // Both nodes share the leaf, and the nodes point at each other
+    leaf->leafFloat32Test   = s_float32Value;
+    nodeA->nodeUint32Test   = s_uint32Value;
+    nodeA->nextTest         = nodeB;
+    nodeA->leafTest         = leaf;
+    nodeB->nodeUint32Test   = 2 * s_uint32Value;
+    nodeB->nextTest         = nodeA;
+    nodeB->leafTest         = leaf;
+}
+
+//====================================================
+static void CheckGraph(GraphNodeClass * nodeA) {
+    ASSERT_TRUE(nodeA != NULL);
+    GraphNodeClass * nodeB = nodeA->nextTest;
+    ASSERT_TRUE(nodeB != NULL);
+    ASSERT_TRUE(nodeA->leafTest != NULL);
+
+    EXPECT_EQ(s_uint32Value,        nodeA->nodeUint32Test);
+    EXPECT_EQ(2 * s_uint32Value,    nodeB->nodeUint32Test);
+    EXPECT_EQ(nodeA,                nodeB->nextTest);
+    EXPECT_EQ(nodeA->leafTest,      nodeB->leafTest);
+    EXPECT_EQ(s_float32Value,       nodeA->leafTest->leafFloat32Test);
+
+    // References are restored before finalization
+    EXPECT_EQ(s_float32Value,       nodeA->finalizedLeafValue);
+    EXPECT_EQ(s_float32Value,       nodeB->finalizedLeafValue);
+}
+
+//====================================================
+TEST(ReflectionTest, TestGraphText) {
+    GraphNodeClass nodeA;
+    GraphNodeClass nodeB;
+    GraphLeafClass leaf;
+    BuildGraph(&nodeA, &nodeB, &leaf);
+
+    IStructuredTextStreamPtr testStream = StreamCreateXML(L"testGraph.xml");
+    ASSERT_TRUE(testStream != NULL);
+    EXPECT_EQ(true, ReflLibrary::Serialize(testStream, &nodeA));
+    testStream->Save();
+
+    testStream = StreamOpenXML(L"testGraph.xml");
+    ASSERT_TRUE(testStream != NULL);
+    ReflClass * inst = ReflLibrary::Deserialize(testStream, MemFlags(MEM_ARENA_DEFAULT, MEM_CAT_TEST));
+    GraphNodeClass * loadNode = ReflCast<GraphNodeClass>(inst);
+    CheckGraph(loadNode);
+
+    ReflLibrary::DestroyGraph(inst);
+}
+
+//====================================================
+TEST(ReflectionTest, TestGraphTextReader) {
+    GraphNodeClass nodeA;
+    GraphNodeClass nodeB;
+    GraphLeafClass leaf;
+    BuildGraph(&nodeA, &nodeB, &leaf);
+
+    IStructuredTextStreamPtr testStream = StreamCreateXMLWriter(L"testGraphReader.xml");
+    ASSERT_TRUE(testStream != NULL);
+    EXPECT_EQ(true, ReflLibrary::Serialize(testStream, &nodeA));
+    testStream->Save();
+
+    testStream = StreamOpenXMLReader(L"testGraphReader.xml");
+    ASSERT_TRUE(testStream != NULL);
+    ReflClass * inst = ReflLibrary::Deserialize(testStream, MemFlags(MEM_ARENA_DEFAULT, MEM_CAT_TEST));
+    GraphNodeClass * loadNode = ReflCast<GraphNodeClass>(inst);
+    CheckGraph(loadNode);
+
+    ReflLibrary::DestroyGraph(inst);
+}
+
+//====================================================
+TEST(ReflectionTest, TestGraphInSitu) {
+    GraphNodeClass nodeA;
+    GraphNodeClass nodeB;
+    GraphLeafClass leaf;
+    BuildGraph(&nodeA, &nodeB, &leaf);
+
+    IStructuredTextStreamPtr testStream = StreamCreateXMLWriter(L"testGraphInSitu.xml");
+    ASSERT_TRUE(testStream != NULL);
+    EXPECT_EQ(true, ReflLibrary::Serialize(testStream, &nodeA));
+    testStream->Save();
+
+    testStream = StreamOpenXMLInSitu(L"testGraphInSitu.xml");
+    ASSERT_TRUE(testStream != NULL);
+    ReflClass * inst = ReflLibrary::Deserialize(testStream, MemFlags(MEM_ARENA_DEFAULT, MEM_CAT_TEST));
+    GraphNodeClass * loadNode = ReflCast<GraphNodeClass>(inst);
+    CheckGraph(loadNode);
+
+    ReflLibrary::DestroyGraph(inst);
+}
+
+//====================================================
+TEST(ReflectionTest, TestGraphJSON) {
+    GraphNodeClass nodeA;
+    GraphNodeClass nodeB;
+    GraphLeafClass leaf;
+    BuildGraph(&nodeA, &nodeB, &leaf);
+
+    IStructuredTextStreamPtr testStream = StreamCreateJSON(L"testGraph.json");
+    ASSERT_TRUE(testStream != NULL);
+    EXPECT_EQ(true, ReflLibrary::Serialize(testStream, &nodeA));
+    testStream->Save();
+
+    testStream = StreamOpenJSON(L"testGraph.json");
+    ASSERT_TRUE(testStream != NULL);
+    ReflClass * inst = ReflLibrary::Deserialize(testStream, MemFlags(MEM_ARENA_DEFAULT, MEM_CAT_TEST));
+    GraphNodeClass * loadNode = ReflCast<GraphNodeClass>(inst);
+    CheckGraph(loadNode);
+
+    ReflLibrary::DestroyGraph(inst);
+}
+
+//====================================================
+TEST(ReflectionTest, TestGraphBinary) {
+    GraphNodeClass nodeA;
+    GraphNodeClass nodeB;
+    GraphLeafClass leaf;
+    BuildGraph(&nodeA, &nodeB, &leaf);
+
+    {
+        IRawStreamPtr rawStream = StreamCreateFile(L"testGraph.bin");
+        ASSERT_TRUE(rawStream != NULL);
+        DataStream stream(rawStream);
+        EXPECT_EQ(true, ReflLibrary::Serialize(&stream, &nodeA));
+    }
+
+    IRawStreamPtr rawStream = StreamOpenFile(L"testGraph.bin");
+    ASSERT_TRUE(rawStream != NULL);
+    DataStream stream(rawStream);
+    ReflClass * inst = ReflLibrary::Deserialize(&stream, MemFlags(MEM_ARENA_DEFAULT, MEM_CAT_TEST));
+    GraphNodeClass * loadNode = ReflCast<GraphNodeClass>(inst);
+    CheckGraph(loadNode);
+
+    ReflLibrary::DestroyBatch(inst);
+}
+
+//====================================================
+TEST(ReflectionTest, TestGraphBinaryDamaged) {
+    GraphNodeClass nodeA;
+    GraphNodeClass nodeB;
+    GraphLeafClass leaf;
+    BuildGraph(&nodeA, &nodeB, &leaf);
+
+    {
+        DataStream stream(StreamCreateFile(L"testGraphDamaged.bin"));
+        EXPECT_EQ(true, ReflLibrary::Serialize(&stream, &nodeA));
+    }
+
+    EFileResult result;
+    IMappedFilePtr file = FileOpenMapped(L"testGraphDamaged.bin", FILE_MAP_HINT_SEQUENTIAL, &result);
+    ASSERT_EQ(FILE_RESULT_OK, result);
+    IFileViewPtr view = file->MapView(0, static_cast<unsigned>(file->GetSize()));
+    ASSERT_TRUE(view != NULL);
+
+    const unsigned size = view->GetSize();
+    byte * data = new byte[size];
+
+    // A corrupt object count fails instead of allocating for it
+    memcpy(data, view->GetData(), size);
+    const uint32 numObjects = 0xffffffff;
+    memcpy(data + 2 * sizeof(uint32), &numObjects, sizeof(numObjects));
+    {
+        DataStream stream(StreamOpenMemory(data, size));
+        EXPECT_EQ(true, ReflLibrary::Deserialize(&stream, MemFlags(MEM_ARENA_DEFAULT, MEM_CAT_TEST)) == NULL);
+    }
+
+    // Files cut short in the object table or a block header don't load
+    //  half an object graph
+    memcpy(data, view->GetData(), size);
+    const unsigned firstBlock = 3 * sizeof(uint32) + 3 * sizeof(uint32);
+    for (unsigned cut = 0; cut < size; cut++) {
+        DataStream stream(StreamOpenMemory(data, cut));
+        ReflClass * inst = ReflLibrary::Deserialize(&stream, MemFlags(MEM_ARENA_DEFAULT, MEM_CAT_TEST));
+        if (cut < firstBlock + 3 * sizeof(uint32)) 
+            EXPECT_EQ(true, inst == NULL);
+        ReflLibrary::DestroyBatch(inst);
+    }
+
+    delete [] data;
+}
+
+//====================================================
+TEST(ReflectionTest, TestGraphBinaryMapped) {
+    GraphNodeClass nodeA;
+    GraphNodeClass nodeB;
+    GraphLeafClass leaf;
+    BuildGraph(&nodeA, &nodeB, &leaf);
+
+    {
+        DataStream stream(StreamCreateFile(L"testGraphMapped.bin"));
+        EXPECT_EQ(true, ReflLibrary::Serialize(&stream, &nodeA));
+    }
+
+    IRawStreamPtr rawStream = StreamOpenMapped(L"testGraphMapped.bin");
+    ASSERT_TRUE(rawStream != NULL);
+    DataStream stream(rawStream);
+    ReflClass * inst = ReflLibrary::Deserialize(&stream, MemFlags(MEM_ARENA_DEFAULT, MEM_CAT_TEST));
+    GraphNodeClass * loadNode = ReflCast<GraphNodeClass>(inst);
+    CheckGraph(loadNode);
+
+    ReflLibrary::DestroyBatch(inst);
+}
+
+//====================================================
+TEST(ReflectionTest, TestGraphNullPointer) {
+    GraphNodeClass node;
+    node.nodeUint32Test = s_uint32Value;
+
+    byte memory[256];
+    DataStream writeStream(StreamOpenMemory(memory, sizeof(memory)));
+    EXPECT_EQ(true, ReflLibrary::Serialize(&writeStream, &node));
+
+    DataStream readStream(StreamOpenMemory(memory, sizeof(memory)));
+    ReflClass * inst = ReflLibrary::Deserialize(&readStream, MemFlags(MEM_ARENA_DEFAULT, MEM_CAT_TEST));
+    GraphNodeClass * loadNode = ReflCast<GraphNodeClass>(inst);
+    ASSERT_TRUE(loadNode != NULL);
+    EXPECT_EQ(s_uint32Value,    loadNode->nodeUint32Test);
+    EXPECT_TRUE(loadNode->nextTest == NULL);
+    EXPECT_TRUE(loadNode->leafTest == NULL);
+
+    ReflLibrary::DestroyBatch(inst);
+}
+
+//====================================================
+TEST(ReflectionTest, TestGraphChunked) {
+    GraphNodeClass nodeA;
+    GraphNodeClass nodeB;
+    GraphLeafClass leaf;
+    BuildGraph(&nodeA, &nodeB, &leaf);
+
+    GraphNodeClass single;
+    single.nodeUint32Test = s_uint32Value + 1;
+
+    {
+        IChunkWriterPtr writer = StreamCreateChunked(StreamCreateFile(L"testGraphChunked.bin"));
+        const ReflClass * roots[] = { &nodeA, &single };
+        EXPECT_EQ(true, ReflLibrary::SerializeChunked(writer, roots, 2));
+
+        // Chunks of newer builds are passed over
+        DataStream stream(writer->BeginChunk(STREAM_CHUNK_TYPE('N', 'E', 'W', 'R'), 1));
+        stream.Write<uint32>(0);
+    }
+
+    {
+        IChunkReaderPtr reader = StreamOpenChunked(StreamOpenFile(L"testGraphChunked.bin"));
+        ASSERT_TRUE(reader != NULL);
+        ReflLoadReport report;
+        EXPECT_EQ(true, ReflLibrary::CheckChunkedSchema(reader, &report));
+        EXPECT_EQ(0, report.unknownClasses);
+        EXPECT_EQ(0, report.oldVersions);
+        EXPECT_EQ(0, report.newerVersions);
+
+        ReflClass * insts[2] = { NULL, NULL };
+        unsigned numInsts = 0;
+        for (unsigned i = 0; i < reader->GetNumChunks(); i++) {
+            const ChunkDesc * chunk = reader->GetChunk(i);
+            if (chunk->type == REFL_CHUNK_OBJECTS && numInsts < 2) 
+                insts[numInsts++] = ReflLibrary::DeserializeChunk(reader, chunk, MemFlags(MEM_ARENA_DEFAULT, MEM_CAT_TEST));
+        }
+        ASSERT_EQ(2, numInsts);
+        CheckGraph(ReflCast<GraphNodeClass>(insts[0]));
+        GraphNodeClass * loadSingle = ReflCast<GraphNodeClass>(insts[1]);
+        ASSERT_TRUE(loadSingle != NULL);
+        EXPECT_EQ(s_uint32Value + 1, loadSingle->nodeUint32Test);
+
+        ReflLibrary::DestroyBatch(insts[0]);
+        ReflLibrary::DestroyBatch(insts[1]);
+    }
+
+    // Mapped files load objects in any order
+    IChunkReaderPtr reader = StreamOpenChunked(L"testGraphChunked.bin");
+    ASSERT_TRUE(reader != NULL);
+    ASSERT_EQ(5, reader->GetNumChunks());
+    ReflClass * second = ReflLibrary::DeserializeChunk(reader, reader->GetChunk(3), MemFlags(MEM_ARENA_DEFAULT, MEM_CAT_TEST));
+    ReflClass * first  = ReflLibrary::DeserializeChunk(reader, reader->GetChunk(2), MemFlags(MEM_ARENA_DEFAULT, MEM_CAT_TEST));
+    EXPECT_EQ(true, ReflLibrary::DeserializeChunk(reader, reader->GetChunk(4), MemFlags(MEM_ARENA_DEFAULT, MEM_CAT_TEST)) == NULL);
+    CheckGraph(ReflCast<GraphNodeClass>(first));
+    EXPECT_EQ(s_uint32Value + 1, ReflCast<GraphNodeClass>(second)->nodeUint32Test);
+
+    ReflLibrary::DestroyBatch(first);
+    ReflLibrary::DestroyBatch(second);
+}
+
+//====================================================
+TEST(ReflectionTest, TestGraphHashContents) {
+    GraphNodeClass nodeA;
+    GraphNodeClass nodeB;
+    GraphLeafClass leaf;
+    BuildGraph(&nodeA, &nodeB, &leaf);
+
+    GraphNodeClass copyA;
+    GraphNodeClass copyB;
+    GraphLeafClass copyLeaf;
+    BuildGraph(&copyA, &copyB, &copyLeaf);
+
+    // Cycles end, and equal graphs at other addresses hash the same
+    Hash64 hashA = ReflLibrary::HashContents(&nodeA);
+    EXPECT_EQ(hashA, ReflLibrary::HashContents(&copyA));
+    EXPECT_NE(hashA, ReflLibrary::HashContents(&nodeB));
+
+    // Targets contribute their contents, not just their type
+    copyLeaf.leafFloat32Test = 2.0f * s_float32Value;
+    EXPECT_NE(hashA, ReflLibrary::HashContents(&copyA));
+    copyLeaf.leafFloat32Test = s_float32Value;
+
+    // So does the shape of the graph
+    GraphLeafClass otherLeaf;
+    otherLeaf.leafFloat32Test = s_float32Value;
+    copyB.leafTest = &otherLeaf;
+    EXPECT_NE(hashA, ReflLibrary::HashContents(&copyA));
+}
+
+//====================================================
+TEST(ReflectionTest, TestGraphShared) {
+    GraphNodeClass nodeA;
+    GraphNodeClass nodeB;
+    GraphLeafClass leaf;
+    BuildGraph(&nodeA, &nodeB, &leaf);
+
+    IStructuredTextStreamPtr testStream = StreamCreateXML(L"testGraphShared.xml");
+    ASSERT_TRUE(testStream != NULL);
+    EXPECT_EQ(true, ReflLibrary::Serialize(testStream, &nodeA));
+    testStream->Save();
+
+    // The duplicate graph is destroyed whole and the first one handed back
+    unsigned startShared = ReflLibrary::NumSharedInstances();
+    testStream = StreamOpenXML(L"testGraphShared.xml");
+    const ReflClass * instA = ReflLibrary::DeserializeShared(testStream, MemFlags(MEM_ARENA_DEFAULT, MEM_CAT_TEST));
+    testStream = StreamOpenXML(L"testGraphShared.xml");
+    const ReflClass * instB = ReflLibrary::DeserializeShared(testStream, MemFlags(MEM_ARENA_DEFAULT, MEM_CAT_TEST));
+    EXPECT_EQ(instA, instB);
+    EXPECT_EQ(startShared + 1, ReflLibrary::NumSharedInstances());
+    CheckGraph(ReflCast<GraphNodeClass>(const_cast<ReflClass *>(instA)));
+
+    ReflLibrary::ReleaseShared(instB);
+    ReflLibrary::ReleaseShared(instA);
+    EXPECT_EQ(startShared, ReflLibrary::NumSharedInstances());
+}
@@ -0,0 +1,177 @@
+/*
+   GameRiff - Framework for creating various video game services
+   Unit tests for content hashing and shared instances
+   Copyright (C) 2011, Shaun Leach.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are
+   met:
+  
+       * Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+       * Redistributions in binary form must reproduce the above
+   copyright notice, this list of conditions and the following disclaimer
+   in the documentation and/or other materials provided with the
+   distribution.
+  
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include <gtest/gtest.h>
+
+#include "Pch.h"
+
+//////////////////////////////////////////////////////
+//
+// Internal constants
+//
+static const uint32    s_uint32Value     =  640000;
+static const float32   s_float32Value    =  64.64f;
+static const int8      s_int8Value       = -8;
+
+//////////////////////////////////////////////////////
+//
+// Test content hashing
+//
+
+class HashingMemberClass : public ReflClass {
+public:
+    REFL_DEFINE_CLASS(HashingMemberClass);
+    HashingMemberClass() :
+        memberInt8Test(0)
+    {
+        InitReflType();
+    }
+
+//private:
+    int8        memberInt8Test;
+};
+
+REFL_IMPL_CLASS_BEGIN(ReflClass, HashingMemberClass);
+    REFL_MEMBER(memberInt8Test);
+REFL_IMPL_CLASS_END(HashingMemberClass);
+
+class HashingTestClass : public ReflClass {
+public:
+    REFL_DEFINE_CLASS(HashingTestClass);
+    HashingTestClass() :
+        boolTest(false),
+        uint32Test(0),
+        float32Test(0.0f)
+    {
+        InitReflType();
+    }
+
+//private:
+    bool                boolTest;
+    uint32              uint32Test;
+    float32             float32Test;
+    HashingMemberClass  classTest;
+};
+
+REFL_IMPL_CLASS_BEGIN(ReflClass, HashingTestClass);
+    REFL_MEMBER(boolTest);
+    REFL_MEMBER(uint32Test);
+    REFL_MEMBER(float32Test);
+    REFL_MEMBER(classTest);
+REFL_IMPL_CLASS_END(HashingTestClass);
+
+//====================================================
+static void FillHashingTest(HashingTestClass * test) {
+    test->boolTest                  = true;
+    test->uint32Test                = s_uint32Value;
+    test->float32Test               = s_float32Value;
+    test->classTest.memberInt8Test  = s_int8Value;
+}
+
+//====================================================
+TEST(ReflectionTest, TestHashContents) {
+    HashingTestClass testA;
+    HashingTestClass testB;
+    FillHashingTest(&testA);
+    FillHashingTest(&testB);
+
+    Hash64 hashA = ReflLibrary::HashContents(&testA);
+    EXPECT_EQ(hashA, ReflLibrary::HashContents(&testB));
+
+    // Any member, including ones in class members, changes the hash
+    testB.classTest.memberInt8Test++;
+    EXPECT_NE(hashA, ReflLibrary::HashContents(&testB));
+
+    testB.classTest.memberInt8Test = s_int8Value;
+    testB.float32Test = 2.0f * s_float32Value;
+    EXPECT_NE(hashA, ReflLibrary::HashContents(&testB));
+
+    // Values that serialize the same hash the same
+    testA.float32Test = 0.0f;
+    testB.float32Test = -0.0f;
+    EXPECT_EQ(ReflLibrary::HashContents(&testA), ReflLibrary::HashContents(&testB));
+
+    // Same contents in a different type hash differently
+    HashingMemberClass member;
+    EXPECT_NE(ReflLibrary::HashContents(&member), ReflLibrary::HashContents(&testA.classTest));
+    member.memberInt8Test = s_int8Value;
+    EXPECT_EQ(ReflLibrary::HashContents(&member), ReflLibrary::HashContents(&testA.classTest));
+}
+
+//====================================================
+TEST(ReflectionTest, TestSharedInstances) {
+    HashingTestClass testTypes;
+    FillHashingTest(&testTypes);
+
+    IStructuredTextStreamPtr testStream = StreamCreateXML(L"testHashing.xml");
+    ASSERT_TRUE(testStream != NULL);
+    EXPECT_EQ(true, ReflLibrary::Serialize(testStream, &testTypes));
+    testStream->Save();
+
+    unsigned startShared = ReflLibrary::NumSharedInstances();
+
+    testStream = StreamOpenXML(L"testHashing.xml");
+    ASSERT_TRUE(testStream != NULL);
+    const ReflClass * instA = ReflLibrary::DeserializeShared(testStream, MemFlags(MEM_ARENA_DEFAULT, MEM_CAT_TEST));
+    ASSERT_TRUE(instA != NULL);
+
+    testStream = StreamOpenXML(L"testHashing.xml");
+    ASSERT_TRUE(testStream != NULL);
+    const ReflClass * instB = ReflLibrary::DeserializeShared(testStream, MemFlags(MEM_ARENA_DEFAULT, MEM_CAT_TEST));
+    EXPECT_EQ(instA, instB);
+    EXPECT_EQ(startShared + 1, ReflLibrary::NumSharedInstances());
+    EXPECT_EQ(ReflLibrary::HashContents(&testTypes), ReflLibrary::HashContents(instA));
+
+    const HashingTestClass * loadTypes = ReflCast<HashingTestClass>(const_cast<ReflClass *>(instA));
+    ASSERT_TRUE(loadTypes != NULL);
+    EXPECT_EQ(s_uint32Value,    loadTypes->uint32Test);
+    EXPECT_EQ(s_int8Value,      loadTypes->classTest.memberInt8Test);
+
+    // Different contents get their own instance, and release by identity
+    testTypes.uint32Test++;
+    testStream = StreamCreateXML(L"testHashingOther.xml");
+    ASSERT_TRUE(testStream != NULL);
+    EXPECT_EQ(true, ReflLibrary::Serialize(testStream, &testTypes));
+    testStream->Save();
+
+    testStream = StreamOpenXML(L"testHashingOther.xml");
+    ASSERT_TRUE(testStream != NULL);
+    const ReflClass * instC = ReflLibrary::DeserializeShared(testStream, MemFlags(MEM_ARENA_DEFAULT, MEM_CAT_TEST));
+    ASSERT_TRUE(instC != NULL);
+    EXPECT_NE(instA, instC);
+    EXPECT_EQ(startShared + 2, ReflLibrary::NumSharedInstances());
+    ReflLibrary::ReleaseShared(instC);
+    EXPECT_EQ(startShared + 1, ReflLibrary::NumSharedInstances());
+
+    ReflLibrary::ReleaseShared(instB);
+    EXPECT_EQ(startShared + 1, ReflLibrary::NumSharedInstances());
+    ReflLibrary::ReleaseShared(instA);
+    EXPECT_EQ(startShared, ReflLibrary::NumSharedInstances());
+}
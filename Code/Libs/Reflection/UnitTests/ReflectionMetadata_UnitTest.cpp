@@ -0,0 +1,341 @@
+/*
+   GameRiff - Framework for creating various video game services
+   Unit tests for compact reflection metadata
+   Copyright (C) 2011, Shaun Leach.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are
+   met:
+  
+       * Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+       * Redistributions in binary form must reproduce the above
+   copyright notice, this list of conditions and the following disclaimer
+   in the documentation and/or other materials provided with the
+   distribution.
+  
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include <gtest/gtest.h>
+
+#include "Pch.h"
+
+//////////////////////////////////////////////////////
+//
+// Internal constants
+//
+static const uint32    s_uint32Value     =  320000;
+static const int16     s_int16Value      =  -1600;
+static const float32   s_float32Value    =  32.32f;
+
+//////////////////////////////////////////////////////
+//
+// Test binary serialization through the metadata tables
+//
+
+class MetadataMemberClass : public ReflClass {
+public:
+    REFL_DEFINE_CLASS(MetadataMemberClass);
+    MetadataMemberClass() :
+        memberFloat32Test(0.0f)
+    {
+        InitReflType();
+    }
+
+//private:
+    float32     memberFloat32Test;
+};
+
+REFL_IMPL_CLASS_BEGIN(ReflClass, MetadataMemberClass);
+    REFL_MEMBER(memberFloat32Test);
+REFL_IMPL_CLASS_END(MetadataMemberClass);
+
+class MetadataBaseClass : public ReflClass {
+public:
+    REFL_DEFINE_CLASS(MetadataBaseClass);
+    MetadataBaseClass() :
+        baseUint32Test(0)
+    {
+        InitReflType();
+    }
+
+//private:
+    uint32      baseUint32Test;
+};
+
+REFL_IMPL_CLASS_BEGIN(ReflClass, MetadataBaseClass);
+    REFL_MEMBER(baseUint32Test);
+REFL_IMPL_CLASS_END(MetadataBaseClass);
+
+class MetadataDerivedClass : public MetadataBaseClass {
+public:
+    REFL_DEFINE_CLASS(MetadataDerivedClass);
+    MetadataDerivedClass() :
+        derivedInt16Test(0)
+    {
+        InitReflType();
+    }
+
+//private:
+    MetadataMemberClass     classTest;
+    int16                   derivedInt16Test;
+};
+
+REFL_IMPL_CLASS_BEGIN(MetadataBaseClass, MetadataDerivedClass);
+    REFL_ADD_PARENT(MetadataBaseClass);
+    REFL_ADD_DEPRECATED_CLASS(MetadataDerivedClass, OldMetadataDerivedClass);
+    REFL_MEMBER(classTest);
+    REFL_MEMBER(derivedInt16Test);
+REFL_IMPL_CLASS_END(MetadataDerivedClass);
+
+// Stands in for a type from a plugin, registered after ReflInitialize
+class MetadataPluginClass : public MetadataBaseClass {
+public:
+    REFL_DEFINE_CLASS(MetadataPluginClass);
+    MetadataPluginClass() :
+        pluginInt16Test(0)
+    {
+        InitReflType();
+    }
+
+//private:
+    int16       pluginInt16Test;
+};
+
+REFL_IMPL_CLASS_BEGIN(MetadataBaseClass, MetadataPluginClass);
+    REFL_ADD_PARENT(MetadataBaseClass);
+    REFL_ADD_DEPRECATED_CLASS(MetadataPluginClass, OldMetadataPluginClass);
+    REFL_MEMBER(pluginInt16Test);
+    return &s_reflInfo;
+}
+
+struct MetadataLookupThread {
+    volatile int32  done;
+    volatile int32  lookups;
+    volatile int32  failures;
+};
+
+//====================================================
+static void MetadataLookupThreadFunc(void * param) {
+    MetadataLookupThread * lookup = reinterpret_cast<MetadataLookupThread *>(param);
+    const ReflTypeDesc * derived = MetadataDerivedClass::GetReflectionInfo();
+    while (lookup->done == 0) {
+        if (ReflLibrary::GetClassDesc(ReflHash(L"MetadataDerivedClass")) != derived) 
+            AtomicIncrement(&lookup->failures);
+
+        const ReflTypeDesc * plugin = ReflLibrary::GetClassDesc(ReflHash(L"OldMetadataPluginClass"));
+        if (plugin != NULL && plugin->GetHash() != MetadataPluginClass::GetReflType()) 
+            AtomicIncrement(&lookup->failures);
+
+        AtomicIncrement(&lookup->lookups);
+    }
+}
+
+//====================================================
+TEST(ReflectionTest, TestMetadataStats) {
+    ReflMetadataStats stats;
+    ReflLibrary::GetMetadataStats(&stats);
+
+    EXPECT_LT(0u, stats.numTypes);
+    EXPECT_LT(0u, stats.numMembers);
+    EXPECT_LT(0u, stats.descBytes);
+    EXPECT_LT(0u, stats.tableBytes);
+#ifdef GOLD
+    EXPECT_EQ(0u, stats.nameBytes);
+#else
+    EXPECT_LT(0u, stats.nameBytes);
+#endif
+}
+
+//====================================================
+TEST(ReflectionTest, TestMetadataClassLookup) {
+    const ReflTypeDesc * desc = MetadataDerivedClass::GetReflectionInfo();
+    ASSERT_TRUE(desc != NULL);
+    EXPECT_EQ(desc, ReflLibrary::GetClassDesc(ReflHash(L"MetadataDerivedClass")));
+    EXPECT_EQ(desc, ReflLibrary::GetClassDesc(ReflHash(L"OldMetadataDerivedClass")));
+    EXPECT_TRUE(ReflLibrary::GetClassDesc(ReflHash(L"MetadataMissingClass")) == NULL);
+}
+
+//====================================================
+TEST(ReflectionTest, TestMetadataBinary) {
+    MetadataDerivedClass derived;
+    derived.baseUint32Test                  = s_uint32Value;
+    derived.classTest.memberFloat32Test     = s_float32Value;
+    derived.derivedInt16Test                = s_int16Value;
+
+    byte memory[256];
+    DataStream writeStream(StreamOpenMemory(memory, sizeof(memory)));
+    EXPECT_EQ(true, ReflLibrary::Serialize(&writeStream, &derived));
+
+    DataStream readStream(StreamOpenMemory(memory, sizeof(memory)));
+    ReflClass * inst = ReflLibrary::Deserialize(&readStream, MemFlags(MEM_ARENA_DEFAULT, MEM_CAT_TEST));
+    MetadataDerivedClass * loadDerived = ReflCast<MetadataDerivedClass>(inst);
+    ASSERT_TRUE(loadDerived != NULL);
+    EXPECT_EQ(s_uint32Value,    loadDerived->baseUint32Test);
+    EXPECT_EQ(s_float32Value,   loadDerived->classTest.memberFloat32Test);
+    EXPECT_EQ(s_int16Value,     loadDerived->derivedInt16Test);
+
+    ReflLibrary::DestroyBatch(inst);
+}
+
+//====================================================
+TEST(ReflectionTest, TestMetadataTypeBatch) {
+    ReflMetadataStats stats;
+    ReflLibrary::GetMetadataStats(&stats);
+
+    MetadataLookupThread lookup;
+    lookup.done     = 0;
+    lookup.lookups  = 0;
+    lookup.failures = 0;
+    IThreadPtr thread = ThreadCreate(MetadataLookupThreadFunc, &lookup);
+
+    // Hidden until the batch is published
+    ReflTypeDesc * desc = MetadataPluginClass::ReflCreateClassDesc<MetadataPluginClass>();
+    ReflLibrary::RegisterClassDesc(desc);
+    EXPECT_TRUE(ReflLibrary::GetClassDesc(MetadataPluginClass::GetReflType()) == NULL);
+
+    ReflTypeBatch * batch = ReflLibrary::RegisterTypeBatch();
+    ASSERT_TRUE(batch != NULL);
+    EXPECT_EQ(desc, ReflLibrary::GetClassDesc(MetadataPluginClass::GetReflType()));
+    EXPECT_EQ(desc, ReflLibrary::GetClassDesc(ReflHash(L"OldMetadataPluginClass")));
+
+    ReflMetadataStats batchStats;
+    ReflLibrary::GetMetadataStats(&batchStats);
+    EXPECT_EQ(stats.numTypes + 1, batchStats.numTypes);
+
+    MetadataPluginClass plugin;
+    plugin.baseUint32Test   = s_uint32Value;
+    plugin.pluginInt16Test  = s_int16Value;
+
+    byte memory[256];
+    DataStream writeStream(StreamOpenMemory(memory, sizeof(memory)));
+    EXPECT_EQ(true, ReflLibrary::Serialize(&writeStream, &plugin));
+
+    DataStream readStream(StreamOpenMemory(memory, sizeof(memory)));
+    ReflClass * inst = ReflLibrary::Deserialize(&readStream, MemFlags(MEM_ARENA_DEFAULT, MEM_CAT_TEST));
+    MetadataPluginClass * loadPlugin = ReflCast<MetadataPluginClass>(inst);
+    ASSERT_TRUE(loadPlugin != NULL);
+    EXPECT_EQ(s_uint32Value,    loadPlugin->baseUint32Test);
+    EXPECT_EQ(s_int16Value,     loadPlugin->pluginInt16Test);
+    ReflLibrary::DestroyBatch(inst);
+
+    ReflLibrary::UnregisterTypeBatch(batch);
+    EXPECT_TRUE(ReflLibrary::GetClassDesc(MetadataPluginClass::GetReflType()) == NULL);
+    EXPECT_TRUE(ReflLibrary::GetClassDesc(ReflHash(L"OldMetadataPluginClass")) == NULL);
+
+    ReflLibrary::GetMetadataStats(&batchStats);
+    EXPECT_EQ(stats.numTypes, batchStats.numTypes);
+
+    while (lookup.lookups == 0) 
+        ThreadYield();
+    AtomicExchange(&lookup.done, 1);
+    thread->Join();
+    EXPECT_EQ(0, lookup.failures);
+}
+
+#ifdef REFL_TELEMETRY
+//====================================================
+static const ReflTypeTelemetry * FindTelemetry(const ReflTypeTelemetry * telemetry, unsigned numTypes, ReflHash typeHash) {
+    for (unsigned type = 0; type < numTypes; type++) {
+        if (telemetry[type].typeHash == typeHash) 
+            return &telemetry[type];
+    }
+    return NULL;
+}
+
+//====================================================
+TEST(ReflectionTest, TestMetadataTelemetry) {
+    MetadataDerivedClass derived;
+    ReflLibrary::ResetTelemetry();
+
+    byte memory[256];
+    DataStream writeStream(StreamOpenMemory(memory, sizeof(memory)));
+    EXPECT_EQ(true, ReflLibrary::Serialize(&writeStream, &derived));
+    DataStream readStream(StreamOpenMemory(memory, sizeof(memory)));
+    ReflClass * inst = ReflLibrary::Deserialize(&readStream, MemFlags(MEM_ARENA_DEFAULT, MEM_CAT_TEST));
+    ReflLibrary::DestroyBatch(inst);
+
+    ReflTypeTelemetry telemetry[16];
+    unsigned numTypes = ReflLibrary::GetTelemetry(telemetry, 16);
+    EXPECT_EQ(3u, numTypes);
+
+    // Parents and class members count their own blocks
+    const ReflTypeTelemetry * derivedTelemetry  = FindTelemetry(telemetry, numTypes, MetadataDerivedClass::GetReflType());
+    const ReflTypeTelemetry * baseTelemetry     = FindTelemetry(telemetry, numTypes, MetadataBaseClass::GetReflType());
+    ASSERT_TRUE(derivedTelemetry != NULL);
+    ASSERT_TRUE(baseTelemetry != NULL);
+    EXPECT_EQ(1u, derivedTelemetry->objectsLoaded);
+    EXPECT_EQ(1u, derivedTelemetry->objectsSaved);
+    EXPECT_EQ(2u, derivedTelemetry->membersLoaded);
+    EXPECT_EQ(1u, baseTelemetry->objectsLoaded);
+    EXPECT_LT(0u, derivedTelemetry->bytesLoaded);
+    EXPECT_EQ(derivedTelemetry->bytesSaved, derivedTelemetry->bytesLoaded);
+    EXPECT_EQ(baseTelemetry->bytesSaved, baseTelemetry->bytesLoaded);
+    ReflLibrary::LogTelemetry();
+
+    ReflLibrary::ResetTelemetry();
+    EXPECT_EQ(0u, ReflLibrary::GetTelemetry(telemetry, 16));
+}
+#endif
+
+#ifndef GOLD
+//====================================================
+TEST(ReflectionTest, TestMetadataSchema) {
+    IStructuredTextStreamPtr testStream = StreamCreateXML(L"testSchema.xml");
+    EXPECT_EQ(true, ReflLibrary::ExportSchema(testStream));
+    testStream->Save();
+
+    testStream = StreamOpenXML(L"testSchema.xml");
+    chargr name[256];
+    testStream->ReadNodeName(name, 256);
+    EXPECT_EQ(0, StrCmp(name, L"Schema", 7));
+    ASSERT_EQ(STREAM_ERROR_OK, testStream->ReadChildNode());
+
+    // Types are sorted by hash, so search for the derived class
+    bool found = false;
+    do {
+        testStream->ReadNodeAttribute(L"Name", 4, name, 256);
+        found = StrCmp(name, L"MetadataDerivedClass", 21) == 0;
+    } while (!found && testStream->ReadNextNode() != STREAM_ERROR_NODEDOESNTEXIST);
+    ASSERT_TRUE(found);
+
+    chargr value[32];
+    unsigned binarySize = 0;
+    testStream->ReadNodeAttribute(L"BinarySize", 10, value, 32);
+    StrReadValue(value, 32, L"%u", &binarySize);
+    EXPECT_LT(0u, binarySize);
+
+    ASSERT_EQ(STREAM_ERROR_OK, testStream->ReadChildNode());
+    testStream->ReadNodeName(name, 256);
+    EXPECT_EQ(0, StrCmp(name, L"Parent", 7));
+    testStream->ReadNodeAttribute(L"Name", 4, name, 256);
+    EXPECT_EQ(0, StrCmp(name, L"MetadataBaseClass", 18));
+
+    ASSERT_EQ(STREAM_ERROR_OK, testStream->ReadNextNode());
+    testStream->ReadNodeAttribute(L"Name", 4, name, 256);
+    EXPECT_EQ(0, StrCmp(name, L"classTest", 10));
+    testStream->ReadNodeAttribute(L"Kind", 4, name, 256);
+    EXPECT_EQ(0, StrCmp(name, L"class", 6));
+    testStream->ReadNodeAttribute(L"Target", 6, name, 256);
+    EXPECT_EQ(0, StrCmp(name, L"MetadataMemberClass", 20));
+
+    ASSERT_EQ(STREAM_ERROR_OK, testStream->ReadNextNode());
+    testStream->ReadNodeAttribute(L"Name", 4, name, 256);
+    EXPECT_EQ(0, StrCmp(name, L"derivedInt16Test", 17));
+    testStream->ReadNodeAttribute(L"Kind", 4, name, 256);
+    EXPECT_EQ(0, StrCmp(name, L"int16", 6));
+    EXPECT_EQ(STREAM_ERROR_NODEDOESNTEXIST, testStream->ReadNextNode());
+}
+#endif
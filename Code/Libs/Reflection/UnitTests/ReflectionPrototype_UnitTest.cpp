@@ -0,0 +1,199 @@
+/*
+   GameRiff - Framework for creating various video game services
+   Unit tests for prototype instancing
+   Copyright (C) 2011, Shaun Leach.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are
+   met:
+  
+       * Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+       * Redistributions in binary form must reproduce the above
+   copyright notice, this list of conditions and the following disclaimer
+   in the documentation and/or other materials provided with the
+   distribution.
+  
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <gtest/gtest.h>
+
+#include "Pch.h"
+
+//////////////////////////////////////////////////////
+//
+// Internal constants
+//
+static const uint32    s_uint32Value     =  320000;
+static const float32   s_float32Value    =  32.32f;
+static const int16     s_int16Value      = -1600;
+
+//////////////////////////////////////////////////////
+//
+// Test prototype instancing
+//
+
+class PrototypeBaseClass : public ReflClass {
+public:
+    REFL_DEFINE_CLASS(PrototypeBaseClass);
+    PrototypeBaseClass() :
+        baseUint32Test(0),
+        baseFloat32Test(0.0f)
+    {
+        InitReflType();
+    }
+
+//private:
+    uint32      baseUint32Test;
+    float32     baseFloat32Test;
+};
+
+REFL_IMPL_CLASS_BEGIN(ReflClass, PrototypeBaseClass);
+    REFL_MEMBER(baseUint32Test);
+    REFL_MEMBER(baseFloat32Test);
+REFL_IMPL_CLASS_END(PrototypeBaseClass);
+
+class PrototypeDerivedClass : public PrototypeBaseClass {
+public:
+    REFL_DEFINE_CLASS(PrototypeDerivedClass);
+    PrototypeDerivedClass() :
+        derivedBoolTest(false),
+        derivedInt16Test(0)
+    {
+        InitReflType();
+    }
+
+//private:
+    bool        derivedBoolTest;
+    int16       derivedInt16Test;
+};
+
+REFL_IMPL_CLASS_BEGIN(PrototypeBaseClass, PrototypeDerivedClass);
+    REFL_ADD_PARENT(PrototypeBaseClass);
+    REFL_MEMBER(derivedBoolTest);
+    REFL_MEMBER(derivedInt16Test);
+REFL_IMPL_CLASS_END(PrototypeDerivedClass);
+
+//====================================================
+TEST(ReflectionTest, TestPrototypeMemberIndex) {
+    const ReflTypeDesc * desc = PrototypeDerivedClass::GetReflectionInfo();
+    ASSERT_TRUE(desc != NULL);
+    EXPECT_EQ(4, desc->NumMembers());
+
+    // Parent members come first
+    unsigned index = 0;
+    EXPECT_EQ(true, desc->FindMemberIndex(ReflHash(L"baseUint32Test"), &index));
+    EXPECT_EQ(0, index);
+    EXPECT_EQ(true, desc->FindMemberIndex(ReflHash(L"derivedInt16Test"), &index));
+    EXPECT_EQ(3, index);
+    EXPECT_EQ(false, desc->FindMemberIndex(ReflHash(L"missingTest"), &index));
+
+    unsigned offset = 0;
+    const ReflMember * member = desc->GetMember(3, &offset);
+    ASSERT_TRUE(member != NULL);
+    EXPECT_EQ(ReflHash(L"derivedInt16Test"), member->NameHash());
+}
+
+//====================================================
+TEST(ReflectionTest, TestPrototypeCopyOnWrite) {
+    PrototypeDerivedClass source;
+    source.baseUint32Test   = s_uint32Value;
+    source.baseFloat32Test  = s_float32Value;
+    source.derivedBoolTest  = true;
+    source.derivedInt16Test = s_int16Value;
+
+    ReflPrototypePtr prototype(new(MemFlags(MEM_ARENA_DEFAULT, MEM_CAT_TEST)) ReflPrototype(
+        L"TestCopyOnWrite", 
+        &source, 
+        MemFlags(MEM_ARENA_DEFAULT, MEM_CAT_TEST)
+    ));
+
+    ReflInstance instA(prototype);
+    ReflInstance instB(prototype);
+    EXPECT_EQ(true, instA.IsShared());
+    EXPECT_EQ(instA.Read(), instB.Read());
+
+    const PrototypeDerivedClass * readA = instA.Read<PrototypeDerivedClass>();
+    ASSERT_TRUE(readA != NULL);
+    EXPECT_EQ(s_uint32Value, readA->baseUint32Test);
+
+    PrototypeDerivedClass * writeA = instA.Write<PrototypeDerivedClass>(ReflHash(L"baseFloat32Test"));
+    ASSERT_TRUE(writeA != NULL);
+    writeA->baseFloat32Test = 2.0f * s_float32Value;
+
+    EXPECT_EQ(false, instA.IsShared());
+    EXPECT_EQ(true, instB.IsShared());
+    EXPECT_NE(instA.Read(), instB.Read());
+    EXPECT_EQ(1, instA.NumOverrides());
+    EXPECT_EQ(true, instA.IsOverridden(1));
+    EXPECT_EQ(false, instA.IsOverridden(0));
+
+    const PrototypeDerivedClass * readB = instB.Read<PrototypeDerivedClass>();
+    EXPECT_EQ(s_float32Value,       readB->baseFloat32Test);
+    EXPECT_EQ(2.0f * s_float32Value, writeA->baseFloat32Test);
+    EXPECT_EQ(s_uint32Value,        writeA->baseUint32Test);
+    EXPECT_EQ(s_int16Value,         writeA->derivedInt16Test);
+
+    // Copies of a written instance get their own body
+    ReflInstance instC(instA);
+    EXPECT_NE(instA.Read(), instC.Read());
+    EXPECT_EQ(true, instC.IsOverridden(1));
+
+    instA.Revert();
+    EXPECT_EQ(true, instA.IsShared());
+    EXPECT_EQ(0, instA.NumOverrides());
+}
+
+//====================================================
+TEST(ReflectionTest, TestPrototypeSerialization) {
+    PrototypeDerivedClass source;
+    source.baseUint32Test   = s_uint32Value;
+    source.baseFloat32Test  = s_float32Value;
+    source.derivedBoolTest  = false;
+    source.derivedInt16Test = s_int16Value;
+
+    ReflPrototype * registered = new(MemFlags(MEM_ARENA_DEFAULT, MEM_CAT_TEST)) ReflPrototype(
+        L"TestSerialization", 
+        &source, 
+        MemFlags(MEM_ARENA_DEFAULT, MEM_CAT_TEST)
+    );
+    ReflPrototypePtr prototype(registered);
+    ReflLibrary::RegisterPrototype(registered);
+
+    ReflInstance inst(prototype);
+    inst.Write<PrototypeDerivedClass>(ReflHash(L"derivedBoolTest"))->derivedBoolTest = true;
+
+    IStructuredTextStreamPtr testStream = StreamCreateXML(L"testPrototype.xml");
+    ASSERT_TRUE(testStream != NULL);
+    EXPECT_EQ(true, inst.Serialize(testStream));
+    testStream->Save();
+
+    testStream = StreamOpenXML(L"testPrototype.xml");
+    ASSERT_TRUE(testStream != NULL);
+
+    ReflInstance loaded;
+    EXPECT_EQ(true, loaded.Deserialize(testStream));
+    EXPECT_EQ(false, loaded.IsShared());
+    EXPECT_EQ(1, loaded.NumOverrides());
+
+    const PrototypeDerivedClass * loadTypes = loaded.Read<PrototypeDerivedClass>();
+    ASSERT_TRUE(loadTypes != NULL);
+    EXPECT_EQ(s_uint32Value,    loadTypes->baseUint32Test);
+    EXPECT_EQ(s_float32Value,   loadTypes->baseFloat32Test);
+    EXPECT_EQ(true,             loadTypes->derivedBoolTest);
+    EXPECT_EQ(s_int16Value,     loadTypes->derivedInt16Test);
+
+    ReflLibrary::UnregisterPrototype(registered);
+}
+
@@ -124,3 +124,34 @@ TEST(ReflectionTest, TestSimpleVersioning) {
 }
 
 
+
+//====================================================
+TEST(ReflectionTest, TestVersioningReport) {
+    IStructuredTextStreamPtr testStream = StreamOpenXML(L"testSimpleVersioning.xml");
+    ASSERT_TRUE(testStream != NULL);
+
+    ReflLoadReport report;
+    ReflClass * inst = ReflLibrary::Deserialize(testStream, MemFlags(MEM_ARENA_DEFAULT, MEM_CAT_TEST), &report);
+    ASSERT_TRUE(inst != NULL);
+    EXPECT_EQ(1u, report.oldVersions);
+    EXPECT_EQ(2u, report.deprecatedMembers);
+    EXPECT_EQ(0u, report.unknownMembers);
+
+    // Saving again migrates the data to the current version
+    testStream = StreamCreateXML(L"testSimpleVersioningMigrated.xml");
+    ASSERT_TRUE(testStream != NULL);
+    EXPECT_EQ(true, ReflLibrary::Serialize(testStream, inst));
+    testStream->Save();
+    delete inst;
+
+    testStream = StreamOpenXML(L"testSimpleVersioningMigrated.xml");
+    ASSERT_TRUE(testStream != NULL);
+    inst = ReflLibrary::Deserialize(testStream, MemFlags(MEM_ARENA_DEFAULT, MEM_CAT_TEST), &report);
+    SimpleVersioningClass * loadTypes = ReflCast<SimpleVersioningClass>(inst);
+    ASSERT_TRUE(loadTypes != NULL);
+    EXPECT_EQ(0u, report.oldVersions);
+    EXPECT_EQ(0u, report.deprecatedMembers);
+    EXPECT_EQ(2 * s_uint32Value,  loadTypes->baseUint32Test);
+
+    delete loadTypes;
+}
@@ -0,0 +1,433 @@
+/*
+   GameRiff - Framework for creating various video game services
+   Streams with a checksum for each block
+   Copyright (C) 2011, Shaun Leach.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are
+   met:
+  
+       * Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+       * Redistributions in binary form must reproduce the above
+   copyright notice, this list of conditions and the following disclaimer
+   in the documentation and/or other materials provided with the
+   distribution.
+  
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include "Pch.h"
+
+namespace NSCheckedStream {
+
+//////////////////////////////////////////////////////
+//
+// Constants
+//
+
+#define CHECKED_MEM_FLAGS (MemFlags(MEM_ARENA_DEFAULT, MEM_CAT_FILEIO))
+
+static const uint32     s_checkedMagic      = 0x4b435247;   // "GRCK"
+static const uint32     s_checkedVersion    = 1;
+static const unsigned   s_maxBlockSize      = 16 * 1024 * 1024;
+
+//////////////////////////////////////////////////////
+//
+// Internal Types
+//
+
+// On disk the header is followed by blocks that each start with their size 
+//  and the HashCrc32c of their data. A size of zero ends the stream and 
+//  holds the number of blocks in place of the checksum, so streams cut 
+//  short between blocks are caught as well.
+struct CheckedHeader {
+    uint32  magic;
+    uint32  version;
+    uint32  blockSize;
+    uint32  reserved;
+};
+
+struct BlockHeader {
+    uint32  size;
+    uint32  crc;
+};
+
+class RawCheckedReadStream : public IRawStream {
+public:
+    RawCheckedReadStream(IRawStreamPtr source);
+    ~RawCheckedReadStream();
+
+    bool Open();
+
+    virtual EStreamError ReadBytes(void * bytes, unsigned count, unsigned * bytesRead);
+    virtual EStreamError WriteBytes(const void * bytes, unsigned count, unsigned * bytesWritten);
+
+    virtual unsigned LendReadBlock(const byte ** block);
+    virtual void ReturnBlock(unsigned unused);
+
+private:
+    bool NextBlock(byte * direct, unsigned directSize);
+
+private:
+    DataStream      m_source;
+    byte          * m_buffer;       // Only for blocks the source can't lend in place
+    unsigned        m_blockSize;
+    const byte    * m_block;        // NULL once read straight to the caller
+    unsigned        m_size;
+    unsigned        m_pos;
+    unsigned        m_numBlocks;
+    EStreamError    m_result;       // Set once the end or a bad block is reached
+};
+
+class RawCheckedWriteStream : public IRawStream {
+public:
+    RawCheckedWriteStream(IRawStreamPtr target, unsigned blockSize);
+    ~RawCheckedWriteStream();
+
+    bool Open();
+
+    virtual EStreamError ReadBytes(void * bytes, unsigned count, unsigned * bytesRead);
+    virtual EStreamError WriteBytes(const void * bytes, unsigned count, unsigned * bytesWritten);
+
+    virtual unsigned LendWriteBlock(byte ** block);
+    virtual void ReturnBlock(unsigned unused);
+    virtual EStreamError Flush();
+
+private:
+    void WriteBlock(const byte * data, unsigned size);
+    void Write(const void * bytes, unsigned count);
+
+private:
+    IRawStreamPtr   m_target;
+    byte          * m_buffer;
+    unsigned        m_blockSize;
+    unsigned        m_pos;          // Bytes in the block being filled
+    unsigned        m_numBlocks;
+    EStreamError    m_writeError;   // Held until the next flush
+};
+
+//////////////////////////////////////////////////////
+//
+// RawCheckedReadStream
+//
+
+//====================================================
+RawCheckedReadStream::RawCheckedReadStream(IRawStreamPtr source) :
+    m_source(source),
+    m_buffer(NULL),
+    m_blockSize(0),
+    m_block(NULL),
+    m_size(0),
+    m_pos(0),
+    m_numBlocks(0),
+    m_result(STREAM_ERROR_OK)
+{
+}
+
+//====================================================
+RawCheckedReadStream::~RawCheckedReadStream() {
+    delete [] m_buffer;
+}
+
+//====================================================
+bool RawCheckedReadStream::Open() {
+    CheckedHeader header;
+    unsigned read = 0;
+    m_source.ReadBytes(&header, sizeof(header), &read);
+    if (read != sizeof(header) || header.magic != s_checkedMagic || header.version != s_checkedVersion) 
+        return false;
+    if (header.blockSize == 0 || header.blockSize > s_maxBlockSize) 
+        return false;
+
+    m_blockSize = header.blockSize;
+    return true;
+}
+
+//====================================================
+// Blocks are only checked once they're needed, so nothing is read ahead 
+//  and none of a bad block is counted as read. Blocks the source can't lend
+//  are read straight into the caller's memory when they fit, which may be 
+//  left holding a bad block past the bytes read.
+bool RawCheckedReadStream::NextBlock(byte * direct, unsigned directSize) {
+    if (m_result != STREAM_ERROR_OK) 
+        return false;
+
+    m_block = NULL;
+    m_size  = 0;
+    m_pos   = 0;
+
+    BlockHeader header;
+    unsigned read = 0;
+    m_source.ReadBytes(&header, sizeof(header), &read);
+    if (read == sizeof(header) && header.size == 0) {
+        m_result = header.crc == m_numBlocks ? STREAM_ERROR_EOF : STREAM_ERROR_BADDATA;
+        return false;
+    }
+
+    m_result = STREAM_ERROR_BADDATA;
+    if (read != sizeof(header) || header.size > m_blockSize) 
+        return false;
+
+    // Sources that lend their data are checked in place
+    const byte * data = m_source.ReadInPlace(header.size);
+    byte * dest = direct;
+    if (data == NULL) {
+        if (header.size > directSize) {
+            if (m_buffer == NULL) 
+                m_buffer = new(CHECKED_MEM_FLAGS) byte[m_blockSize];
+            dest = m_buffer;
+        }
+
+        m_source.ReadBytes(dest, header.size, &read);
+        if (read != header.size) 
+            return false;
+        data = dest;
+    }
+
+    if (HashCrc32c(data, header.size) != header.crc) 
+        return false;
+
+    m_block     = data == direct ? NULL : data;
+    m_size      = header.size;
+    m_result    = STREAM_ERROR_OK;
+    m_numBlocks++;
+    return true;
+}
+
+//====================================================
+EStreamError RawCheckedReadStream::ReadBytes(void * bytes, unsigned count, unsigned * bytesRead) {
+    byte * dest = reinterpret_cast<byte *>(bytes);
+    unsigned total = 0;
+    EStreamError result = STREAM_ERROR_OK;
+    while (total < count) {
+        if (m_pos == m_size) {
+            if (!NextBlock(dest + total, count - total)) {
+                result = m_result;
+                break;
+            }
+
+            if (m_block == NULL) {
+                m_pos = m_size;
+                total += m_size;
+                continue;
+            }
+        }
+
+        unsigned available  = m_size - m_pos;
+        unsigned chunk      = count - total < available ? count - total : available;
+        memcpy(dest + total, m_block + m_pos, chunk);
+        m_pos += chunk;
+        total += chunk;
+    }
+
+    if (bytesRead != NULL) 
+        *bytesRead = total;
+    return result;
+}
+
+//====================================================
+EStreamError RawCheckedReadStream::WriteBytes(const void * bytes, unsigned count, unsigned * bytesWritten) {
+    ASSERTMSGGR(false, "Checked read streams can't be written");
+    if (bytesWritten != NULL) 
+        *bytesWritten = 0;
+    return STREAM_ERROR_FILENOTOPENED;
+}
+
+//====================================================
+unsigned RawCheckedReadStream::LendReadBlock(const byte ** block) {
+    if (m_pos == m_size && !NextBlock(NULL, 0)) 
+        return 0;
+
+    *block          = m_block + m_pos;
+    unsigned size   = m_size - m_pos;
+    m_pos           = m_size;
+    return size;
+}
+
+//====================================================
+void RawCheckedReadStream::ReturnBlock(unsigned unused) {
+    ASSERTGR(unused <= m_pos);
+    m_pos -= unused;
+}
+
+//////////////////////////////////////////////////////
+//
+// RawCheckedWriteStream
+//
+
+//====================================================
+RawCheckedWriteStream::RawCheckedWriteStream(IRawStreamPtr target, unsigned blockSize) :
+    m_target(target),
+    m_buffer(NULL),
+    m_blockSize(blockSize),
+    m_pos(0),
+    m_numBlocks(0),
+    m_writeError(STREAM_ERROR_OK)
+{
+}
+
+//====================================================
+RawCheckedWriteStream::~RawCheckedWriteStream() {
+    if (m_buffer != NULL) {
+        Flush();
+        BlockHeader end = { 0, m_numBlocks };
+        m_target->WriteBytes(&end, sizeof(end), NULL);
+        m_target->Flush();
+        delete [] m_buffer;
+    }
+}
+
+//====================================================
+bool RawCheckedWriteStream::Open() {
+    if (m_blockSize == 0 || m_blockSize > s_maxBlockSize) 
+        return false;
+
+    CheckedHeader header;
+    header.magic        = s_checkedMagic;
+    header.version      = s_checkedVersion;
+    header.blockSize    = m_blockSize;
+    header.reserved     = 0;
+    if (m_target->WriteBytes(&header, sizeof(header), NULL) != STREAM_ERROR_OK) 
+        return false;
+
+    m_buffer = new(CHECKED_MEM_FLAGS) byte[m_blockSize];
+    return true;
+}
+
+//====================================================
+void RawCheckedWriteStream::Write(const void * bytes, unsigned count) {
+    EStreamError result = m_target->WriteBytes(bytes, count, NULL);
+    if (m_writeError == STREAM_ERROR_OK) 
+        m_writeError = result;
+}
+
+//====================================================
+void RawCheckedWriteStream::WriteBlock(const byte * data, unsigned size) {
+    BlockHeader header = { size, HashCrc32c(data, size) };
+    Write(&header, sizeof(header));
+    Write(data, size);
+    m_numBlocks++;
+}
+
+//====================================================
+EStreamError RawCheckedWriteStream::ReadBytes(void * bytes, unsigned count, unsigned * bytesRead) {
+    ASSERTMSGGR(false, "Checked write streams can't be read");
+    if (bytesRead != NULL) 
+        *bytesRead = 0;
+    return STREAM_ERROR_FILENOTOPENED;
+}
+
+//====================================================
+EStreamError RawCheckedWriteStream::WriteBytes(const void * bytes, unsigned count, unsigned * bytesWritten) {
+    const byte * src = reinterpret_cast<const byte *>(bytes);
+    unsigned total = 0;
+    while (total < count) {
+        if (m_pos == m_blockSize) {
+            WriteBlock(m_buffer, m_pos);
+            m_pos = 0;
+        }
+
+        // Whole blocks are checksummed where they are
+        unsigned chunk = count - total;
+        if (m_pos == 0 && chunk >= m_blockSize) {
+            WriteBlock(src + total, m_blockSize);
+            total += m_blockSize;
+            continue;
+        }
+
+        if (chunk > m_blockSize - m_pos) 
+            chunk = m_blockSize - m_pos;
+        memcpy(m_buffer + m_pos, src + total, chunk);
+        m_pos += chunk;
+        total += chunk;
+    }
+
+    if (bytesWritten != NULL) 
+        *bytesWritten = total;
+    return STREAM_ERROR_OK;
+}
+
+//====================================================
+unsigned RawCheckedWriteStream::LendWriteBlock(byte ** block) {
+    if (m_pos == m_blockSize) {
+        WriteBlock(m_buffer, m_pos);
+        m_pos = 0;
+    }
+
+    *block          = m_buffer + m_pos;
+    unsigned size   = m_blockSize - m_pos;
+    m_pos           = m_blockSize;
+    return size;
+}
+
+//====================================================
+void RawCheckedWriteStream::ReturnBlock(unsigned unused) {
+    ASSERTGR(unused <= m_pos);
+    m_pos -= unused;
+}
+
+//====================================================
+EStreamError RawCheckedWriteStream::Flush() {
+    if (m_pos > 0) {
+        WriteBlock(m_buffer, m_pos);
+        m_pos = 0;
+    }
+
+    EStreamError result = m_target->Flush();
+    if (m_writeError != STREAM_ERROR_OK) 
+        result = m_writeError;
+    m_writeError = STREAM_ERROR_OK;
+    return result;
+}
+
+} // namespace NSCheckedStream
+
+//////////////////////////////////////////////////////
+//
+// External functions
+//
+
+//====================================================
+IRawStreamPtr StreamOpenChecked(IRawStreamPtr source) {
+    if (source == NULL) 
+        return IRawStreamPtr(NULL);
+
+    NSCheckedStream::RawCheckedReadStream * stream = new(CHECKED_MEM_FLAGS) NSCheckedStream::RawCheckedReadStream(source);
+    if (!stream->Open()) {
+        delete stream;
+        stream = NULL;
+    }
+
+    return IRawStreamPtr(stream);
+}
+
+//====================================================
+IRawStreamPtr StreamCreateChecked(IRawStreamPtr target) {
+    return StreamCreateChecked(target, STREAM_CHECKED_BLOCK_SIZE);
+}
+
+//====================================================
+IRawStreamPtr StreamCreateChecked(IRawStreamPtr target, unsigned blockSize) {
+    if (target == NULL) 
+        return IRawStreamPtr(NULL);
+
+    NSCheckedStream::RawCheckedWriteStream * stream = new(CHECKED_MEM_FLAGS) NSCheckedStream::RawCheckedWriteStream(target, blockSize);
+    if (!stream->Open()) {
+        delete stream;
+        stream = NULL;
+    }
+
+    return IRawStreamPtr(stream);
+}
@@ -0,0 +1,717 @@
+/*
+   GameRiff - Framework for creating various video game services
+   Chunked container files with a directory of typed chunks
+   Copyright (C) 2011, Shaun Leach.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are
+   met:
+  
+       * Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+       * Redistributions in binary form must reproduce the above
+   copyright notice, this list of conditions and the following disclaimer
+   in the documentation and/or other materials provided with the
+   distribution.
+  
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include "Pch.h"
+
+namespace NSChunkFile {
+
+//////////////////////////////////////////////////////
+//
+// Constants
+//
+
+#define CHUNK_MEM_FLAGS (MemFlags(MEM_ARENA_DEFAULT, MEM_CAT_FILEIO))
+
+static const uint32     s_chunkMagic        = 0x46435247;   // "GRCF"
+static const uint32     s_chunkVersion      = 1;
+static const unsigned   s_chunkAlignment    = 8;
+
+// Directories bigger than this are taken as corrupt rather than allocated
+static const unsigned   s_maxChunks         = 1024 * 1024;
+
+//////////////////////////////////////////////////////
+//
+// Internal Types
+//
+
+// On disk the header is followed by the directory, a ChunkDesc per chunk 
+//  in file order, and then the chunk data
+struct ChunkHeader {
+    uint32      magic;
+    uint32      version;
+    uint32      numChunks;
+    uint32      reserved;
+};
+
+class ChunkReader : public IChunkReader {
+public:
+    ChunkReader();
+    virtual ~ChunkReader();
+
+    virtual unsigned GetNumChunks() const;
+    virtual const ChunkDesc * GetChunk(unsigned index) const;
+    virtual const ChunkDesc * FindChunk(uint32 type) const;
+
+protected:
+    bool ReadDirectory(DataStream * stream, uint64 fileSize);
+
+protected:
+    ChunkDesc     * m_chunks;
+    unsigned        m_numChunks;
+};
+
+// Chunks are opened in file order, one at a time, since streams only move
+//  forward
+class StreamChunkReader : public ChunkReader {
+public:
+    StreamChunkReader(IRawStreamPtr source);
+
+    bool Open();
+
+    virtual IRawStreamPtr OpenChunk(const ChunkDesc * chunk);
+
+    void CloseChunk(uint64 end);
+
+private:
+    IRawStreamPtr   m_source;
+    uint64          m_pos;
+    bool            m_chunkOpen;
+};
+
+class MappedChunkReader : public ChunkReader {
+public:
+    bool Open(const chargr * fileName);
+
+    virtual IRawStreamPtr OpenChunk(const ChunkDesc * chunk);
+
+private:
+    IMappedFilePtr  m_file;
+};
+
+// Reads one chunk of the source and leaves the source at the chunk's end 
+//  when released
+class RawChunkReadStream : public IRawStream {
+public:
+    RawChunkReadStream(StreamChunkReader * reader, IRawStreamPtr source, const ChunkDesc * chunk);
+    ~RawChunkReadStream();
+
+    virtual EStreamError ReadBytes(void * bytes, unsigned count, unsigned * bytesRead);
+    virtual EStreamError WriteBytes(const void * bytes, unsigned count, unsigned * bytesWritten);
+
+    virtual unsigned LendReadBlock(const byte ** block);
+    virtual void ReturnBlock(unsigned unused);
+
+private:
+    StreamChunkReader * m_reader;
+    IChunkReaderPtr     m_readerRef;    // Keeps the reader alive
+    IRawStreamPtr       m_source;
+    uint64              m_offset;
+    uint64              m_remaining;
+};
+
+// Lends a mapped chunk out in place as a single block
+class RawViewStream : public IRawStream {
+public:
+    RawViewStream(IFileViewPtr view);
+
+    virtual EStreamError ReadBytes(void * bytes, unsigned count, unsigned * bytesRead);
+    virtual EStreamError WriteBytes(const void * bytes, unsigned count, unsigned * bytesWritten);
+
+    virtual unsigned LendReadBlock(const byte ** block);
+    virtual void ReturnBlock(unsigned unused);
+
+private:
+    IFileViewPtr    m_view;
+    const byte    * m_data;
+    unsigned        m_size;
+    unsigned        m_pos;
+};
+
+class ChunkWriter : public IChunkWriter {
+public:
+    ChunkWriter(IRawStreamPtr target);
+    ~ChunkWriter();
+
+    virtual IRawStreamPtr BeginChunk(uint32 type, uint32 version);
+    virtual EStreamError Close();
+
+    void Append(const void * bytes, unsigned count);
+    unsigned LendBlock(byte ** block);
+    void ReturnBlock(unsigned unused);
+    void EndChunk();
+
+private:
+    void Reserve(unsigned count);
+
+private:
+    IRawStreamPtr   m_target;
+    ChunkDesc     * m_chunks;
+    unsigned        m_numChunks;
+    unsigned        m_chunkCapacity;
+    byte          * m_data;         // Chunk data, offsets are from here until Close
+    unsigned        m_used;
+    unsigned        m_capacity;
+    bool            m_chunkOpen;
+    bool            m_closed;
+    EStreamError    m_result;
+};
+
+// Appends to the open chunk of a writer and ends it when released
+class RawChunkWriteStream : public IRawStream {
+public:
+    RawChunkWriteStream(ChunkWriter * writer);
+    ~RawChunkWriteStream();
+
+    virtual EStreamError ReadBytes(void * bytes, unsigned count, unsigned * bytesRead);
+    virtual EStreamError WriteBytes(const void * bytes, unsigned count, unsigned * bytesWritten);
+
+    virtual unsigned LendWriteBlock(byte ** block);
+    virtual void ReturnBlock(unsigned unused);
+
+private:
+    ChunkWriter       * m_writer;
+    IChunkWriterPtr     m_writerRef;    // Keeps the writer alive
+};
+
+//////////////////////////////////////////////////////
+//
+// ChunkReader
+//
+
+//====================================================
+ChunkReader::ChunkReader() :
+    m_chunks(NULL),
+    m_numChunks(0)
+{
+}
+
+//====================================================
+ChunkReader::~ChunkReader() {
+    if (m_chunks != NULL) 
+        delete [] m_chunks;
+}
+
+//====================================================
+// The file size is only known to mapped readers, streams pass zero
+bool ChunkReader::ReadDirectory(DataStream * stream, uint64 fileSize) {
+    ChunkHeader header;
+    if (stream->Read(header) != STREAM_ERROR_OK) 
+        return false;
+    if (header.magic != s_chunkMagic || header.version != s_chunkVersion || header.numChunks > s_maxChunks) 
+        return false;
+
+    m_numChunks = header.numChunks;
+    m_chunks    = new(CHUNK_MEM_FLAGS) ChunkDesc[m_numChunks + 1];
+    if (m_numChunks > 0 && stream->ReadBytes(m_chunks, m_numChunks * sizeof(ChunkDesc)) != STREAM_ERROR_OK) 
+        return false;
+
+    // Chunks are in file order and don't overlap, so readers that only move
+    //  forward can reach each one
+    uint64 end = sizeof(ChunkHeader) + m_numChunks * sizeof(ChunkDesc);
+    for (unsigned i = 0; i < m_numChunks; i++) {
+        const ChunkDesc & chunk = m_chunks[i];
+        if (chunk.offset < end || chunk.offset % s_chunkAlignment != 0 || chunk.size > ~0ULL - chunk.offset) 
+            return false;
+        end = chunk.offset + chunk.size;
+    }
+
+    return fileSize == 0 || end <= fileSize;
+}
+
+//====================================================
+unsigned ChunkReader::GetNumChunks() const {
+    return m_numChunks;
+}
+
+//====================================================
+const ChunkDesc * ChunkReader::GetChunk(unsigned index) const {
+    ASSERTGR(index < m_numChunks);
+    return &m_chunks[index];
+}
+
+//====================================================
+const ChunkDesc * ChunkReader::FindChunk(uint32 type) const {
+    for (unsigned i = 0; i < m_numChunks; i++) {
+        if (m_chunks[i].type == type) 
+            return &m_chunks[i];
+    }
+
+    return NULL;
+}
+
+//////////////////////////////////////////////////////
+//
+// StreamChunkReader
+//
+
+//====================================================
+StreamChunkReader::StreamChunkReader(IRawStreamPtr source) :
+    m_source(source),
+    m_pos(0),
+    m_chunkOpen(false)
+{
+}
+
+//====================================================
+bool StreamChunkReader::Open() {
+    DataStream stream(m_source);
+    if (!ReadDirectory(&stream, 0)) 
+        return false;
+
+    m_pos = sizeof(ChunkHeader) + m_numChunks * sizeof(ChunkDesc);
+    return true;
+}
+
+//====================================================
+IRawStreamPtr StreamChunkReader::OpenChunk(const ChunkDesc * chunk) {
+    ASSERTMSGGR(chunk >= m_chunks && chunk < m_chunks + m_numChunks, "Chunk is from another file");
+    ASSERTMSGGR(!m_chunkOpen, "Release the open chunk before opening the next one");
+    if (m_chunkOpen || chunk->offset < m_pos) 
+        return IRawStreamPtr(NULL);
+
+    // Whatever lies in between, chunks that weren't opened and any unread 
+    //  part of the last one, is skipped
+    {
+        DataStream stream(m_source);
+        while (m_pos < chunk->offset) {
+            uint64 gap = chunk->offset - m_pos;
+            unsigned skip = gap < 0x40000000 ? static_cast<unsigned>(gap) : 0x40000000;
+            if (stream.Skip(skip) != STREAM_ERROR_OK) 
+                return IRawStreamPtr(NULL);
+            m_pos += skip;
+        }
+    }
+
+    m_chunkOpen = true;
+    return IRawStreamPtr(new(CHUNK_MEM_FLAGS) RawChunkReadStream(this, m_source, chunk));
+}
+
+//====================================================
+void StreamChunkReader::CloseChunk(uint64 end) {
+    m_pos       = end;
+    m_chunkOpen = false;
+}
+
+//////////////////////////////////////////////////////
+//
+// MappedChunkReader
+//
+
+//====================================================
+bool MappedChunkReader::Open(const chargr * fileName) {
+    EFileResult result;
+    m_file = FileOpenMapped(fileName, FILE_MAP_HINT_RANDOM, &result);
+    if (result != FILE_RESULT_OK) 
+        return false;
+
+    IFileViewPtr view = m_file->MapView(0, sizeof(ChunkHeader));
+    if (view == NULL || view->GetSize() < sizeof(ChunkHeader)) 
+        return false;
+
+    ChunkHeader header;
+    memcpy(&header, view->GetData(), sizeof(header));
+    if (header.numChunks > s_maxChunks) 
+        return false;
+
+    // Mapped again to take in the directory
+    view = IFileViewPtr(NULL);
+    view = m_file->MapView(0, sizeof(ChunkHeader) + header.numChunks * sizeof(ChunkDesc));
+    if (view == NULL) 
+        return false;
+
+    DataStream stream(IRawStreamPtr(new(CHUNK_MEM_FLAGS) RawViewStream(view)));
+    return ReadDirectory(&stream, m_file->GetSize());
+}
+
+//====================================================
+IRawStreamPtr MappedChunkReader::OpenChunk(const ChunkDesc * chunk) {
+    ASSERTMSGGR(chunk >= m_chunks && chunk < m_chunks + m_numChunks, "Chunk is from another file");
+
+    // Views are limited to 4GB
+    if (chunk->size > 0xffffffffULL) 
+        return IRawStreamPtr(NULL);
+
+    IFileViewPtr view;
+    if (chunk->size > 0) {
+        view = m_file->MapView(chunk->offset, static_cast<unsigned>(chunk->size));
+        if (view == NULL) 
+            return IRawStreamPtr(NULL);
+    }
+
+    return IRawStreamPtr(new(CHUNK_MEM_FLAGS) RawViewStream(view));
+}
+
+//////////////////////////////////////////////////////
+//
+// RawChunkReadStream
+//
+
+//====================================================
+RawChunkReadStream::RawChunkReadStream(StreamChunkReader * reader, IRawStreamPtr source, const ChunkDesc * chunk) :
+    m_reader(reader),
+    m_readerRef(reader),
+    m_source(source),
+    m_offset(chunk->offset),
+    m_remaining(chunk->size)
+{
+}
+
+//====================================================
+RawChunkReadStream::~RawChunkReadStream() {
+    m_reader->CloseChunk(m_offset);
+}
+
+//====================================================
+EStreamError RawChunkReadStream::ReadBytes(void * bytes, unsigned count, unsigned * bytesRead) {
+    EStreamError result = STREAM_ERROR_OK;
+    if (count > m_remaining) {
+        count   = static_cast<unsigned>(m_remaining);
+        result  = STREAM_ERROR_EOF;
+    }
+
+    unsigned read = 0;
+    EStreamError sourceResult = m_source->ReadBytes(bytes, count, &read);
+    if (sourceResult != STREAM_ERROR_OK) 
+        result = sourceResult;
+
+    m_offset    += read;
+    m_remaining -= read;
+    if (bytesRead != NULL) 
+        *bytesRead = read;
+    return result;
+}
+
+//====================================================
+EStreamError RawChunkReadStream::WriteBytes(const void * bytes, unsigned count, unsigned * bytesWritten) {
+    ASSERTMSGGR(false, "Chunk streams of readers are read only");
+    if (bytesWritten != NULL) 
+        *bytesWritten = 0;
+    return STREAM_ERROR_FILENOTOPENED;
+}
+
+//====================================================
+unsigned RawChunkReadStream::LendReadBlock(const byte ** block) {
+    if (m_remaining == 0) 
+        return 0;
+
+    // Whatever the source lends past the chunk goes straight back
+    unsigned size = m_source->LendReadBlock(block);
+    if (size > m_remaining) {
+        m_source->ReturnBlock(size - static_cast<unsigned>(m_remaining));
+        size = static_cast<unsigned>(m_remaining);
+    }
+
+    m_offset    += size;
+    m_remaining -= size;
+    return size;
+}
+
+//====================================================
+void RawChunkReadStream::ReturnBlock(unsigned unused) {
+    m_source->ReturnBlock(unused);
+    m_offset    -= unused;
+    m_remaining += unused;
+}
+
+//////////////////////////////////////////////////////
+//
+// RawViewStream
+//
+
+//====================================================
+RawViewStream::RawViewStream(IFileViewPtr view) :
+    m_view(view),
+    m_data(NULL),
+    m_size(0),
+    m_pos(0)
+{
+    if (m_view != NULL) {
+        m_data = m_view->GetData();
+        m_size = m_view->GetSize();
+    }
+}
+
+//====================================================
+EStreamError RawViewStream::ReadBytes(void * bytes, unsigned count, unsigned * bytesRead) {
+    EStreamError result = STREAM_ERROR_OK;
+    if (count > m_size - m_pos) {
+        count   = m_size - m_pos;
+        result  = STREAM_ERROR_EOF;
+    }
+
+    if (count > 0) 
+        memcpy(bytes, m_data + m_pos, count);
+    m_pos += count;
+
+    if (bytesRead != NULL) 
+        *bytesRead = count;
+    return result;
+}
+
+//====================================================
+EStreamError RawViewStream::WriteBytes(const void * bytes, unsigned count, unsigned * bytesWritten) {
+    ASSERTMSGGR(false, "Mapped chunks are read only");
+    if (bytesWritten != NULL) 
+        *bytesWritten = 0;
+    return STREAM_ERROR_FILENOTOPENED;
+}
+
+//====================================================
+unsigned RawViewStream::LendReadBlock(const byte ** block) {
+    *block          = m_data + m_pos;
+    unsigned size   = m_size - m_pos;
+    m_pos           = m_size;
+    return size;
+}
+
+//====================================================
+void RawViewStream::ReturnBlock(unsigned unused) {
+    ASSERTGR(unused <= m_pos);
+    m_pos -= unused;
+}
+
+//////////////////////////////////////////////////////
+//
+// ChunkWriter
+//
+
+//====================================================
+ChunkWriter::ChunkWriter(IRawStreamPtr target) :
+    m_target(target),
+    m_chunks(NULL),
+    m_numChunks(0),
+    m_chunkCapacity(0),
+    m_data(NULL),
+    m_used(0),
+    m_capacity(0),
+    m_chunkOpen(false),
+    m_closed(false),
+    m_result(STREAM_ERROR_OK)
+{
+}
+
+//====================================================
+ChunkWriter::~ChunkWriter() {
+    Close();
+    if (m_chunks != NULL) 
+        delete [] m_chunks;
+    if (m_data != NULL) 
+        delete [] m_data;
+}
+
+//====================================================
+void ChunkWriter::Reserve(unsigned count) {
+    if (count <= m_capacity - m_used) 
+        return;
+
+    unsigned newCapacity = m_capacity == 0 ? 64 * 1024 : 2 * m_capacity;
+    while (newCapacity - m_used < count) 
+        newCapacity *= 2;
+
+    byte * newData = new(CHUNK_MEM_FLAGS) byte[newCapacity];
+    if (m_used > 0) 
+        memcpy(newData, m_data, m_used);
+    if (m_data != NULL) 
+        delete [] m_data;
+    m_data      = newData;
+    m_capacity  = newCapacity;
+}
+
+//====================================================
+IRawStreamPtr ChunkWriter::BeginChunk(uint32 type, uint32 version) {
+    ASSERTMSGGR(!m_chunkOpen, "Release the open chunk before beginning the next one");
+    ASSERTMSGGR(!m_closed, "Adding to a closed chunked file");
+    if (m_chunkOpen || m_closed) 
+        return IRawStreamPtr(NULL);
+
+    if (m_numChunks == m_chunkCapacity) {
+        unsigned newCapacity = m_chunkCapacity == 0 ? 16 : 2 * m_chunkCapacity;
+        ChunkDesc * newChunks = new(CHUNK_MEM_FLAGS) ChunkDesc[newCapacity];
+        if (m_numChunks > 0) 
+            memcpy(newChunks, m_chunks, m_numChunks * sizeof(ChunkDesc));
+        if (m_chunks != NULL) 
+            delete [] m_chunks;
+        m_chunks        = newChunks;
+        m_chunkCapacity = newCapacity;
+    }
+
+    unsigned padding = (s_chunkAlignment - m_used % s_chunkAlignment) % s_chunkAlignment;
+    Reserve(padding);
+    memset(m_data + m_used, 0, padding);
+    m_used += padding;
+
+    ChunkDesc & chunk   = m_chunks[m_numChunks++];
+    chunk.type          = type;
+    chunk.version       = version;
+    chunk.offset        = m_used;
+    chunk.size          = 0;
+
+    m_chunkOpen = true;
+    return IRawStreamPtr(new(CHUNK_MEM_FLAGS) RawChunkWriteStream(this));
+}
+
+//====================================================
+void ChunkWriter::Append(const void * bytes, unsigned count) {
+    Reserve(count);
+    memcpy(m_data + m_used, bytes, count);
+    m_used += count;
+}
+
+//====================================================
+unsigned ChunkWriter::LendBlock(byte ** block) {
+    if (m_used == m_capacity) 
+        Reserve(1);
+
+    *block          = m_data + m_used;
+    unsigned size   = m_capacity - m_used;
+    m_used          = m_capacity;
+    return size;
+}
+
+//====================================================
+void ChunkWriter::ReturnBlock(unsigned unused) {
+    ASSERTGR(unused <= m_used);
+    m_used -= unused;
+}
+
+//====================================================
+void ChunkWriter::EndChunk() {
+    ChunkDesc & chunk = m_chunks[m_numChunks - 1];
+    chunk.size  = m_used - chunk.offset;
+    m_chunkOpen = false;
+}
+
+//====================================================
+EStreamError ChunkWriter::Close() {
+    ASSERTMSGGR(!m_chunkOpen, "Closing a chunked file with a chunk still open");
+    if (m_closed) 
+        return m_result;
+    m_closed = true;
+
+    ChunkHeader header;
+    header.magic        = s_chunkMagic;
+    header.version      = s_chunkVersion;
+    header.numChunks    = m_numChunks;
+    header.reserved     = 0;
+
+    // The header and directory keep the data aligned
+    uint64 dataOffset = sizeof(ChunkHeader) + m_numChunks * sizeof(ChunkDesc);
+    for (unsigned i = 0; i < m_numChunks; i++) 
+        m_chunks[i].offset += dataOffset;
+
+    DataStream stream(m_target);
+    stream.Write(header);
+    if (m_numChunks > 0) 
+        stream.WriteBytes(m_chunks, m_numChunks * sizeof(ChunkDesc));
+    m_result = stream.WriteBytes(m_data, m_used);
+
+    EStreamError result = stream.Flush();
+    if (m_result == STREAM_ERROR_OK) 
+        m_result = result;
+    return m_result;
+}
+
+//////////////////////////////////////////////////////
+//
+// RawChunkWriteStream
+//
+
+//====================================================
+RawChunkWriteStream::RawChunkWriteStream(ChunkWriter * writer) :
+    m_writer(writer),
+    m_writerRef(writer)
+{
+}
+
+//====================================================
+RawChunkWriteStream::~RawChunkWriteStream() {
+    m_writer->EndChunk();
+}
+
+//====================================================
+EStreamError RawChunkWriteStream::ReadBytes(void * bytes, unsigned count, unsigned * bytesRead) {
+    ASSERTMSGGR(false, "Chunk streams of writers are write only");
+    if (bytesRead != NULL) 
+        *bytesRead = 0;
+    return STREAM_ERROR_FILENOTOPENED;
+}
+
+//====================================================
+EStreamError RawChunkWriteStream::WriteBytes(const void * bytes, unsigned count, unsigned * bytesWritten) {
+    m_writer->Append(bytes, count);
+    if (bytesWritten != NULL) 
+        *bytesWritten = count;
+    return STREAM_ERROR_OK;
+}
+
+//====================================================
+unsigned RawChunkWriteStream::LendWriteBlock(byte ** block) {
+    return m_writer->LendBlock(block);
+}
+
+//====================================================
+void RawChunkWriteStream::ReturnBlock(unsigned unused) {
+    m_writer->ReturnBlock(unused);
+}
+
+} // namespace NSChunkFile
+
+//////////////////////////////////////////////////////
+//
+// External functions
+//
+
+//====================================================
+IChunkReaderPtr StreamOpenChunked(IRawStreamPtr source) {
+    if (source == NULL) 
+        return IChunkReaderPtr(NULL);
+
+    NSChunkFile::StreamChunkReader * reader = new(CHUNK_MEM_FLAGS) NSChunkFile::StreamChunkReader(source);
+    if (!reader->Open()) {
+        delete reader;
+        reader = NULL;
+    }
+
+    return IChunkReaderPtr(reader);
+}
+
+//====================================================
+IChunkReaderPtr StreamOpenChunked(const chargr * fileName) {
+    // Files in mounted packs are already mapped, but only move forward
+    IRawStreamPtr packed = StreamOpenPacked(fileName);
+    if (packed != NULL) 
+        return StreamOpenChunked(packed);
+
+    NSChunkFile::MappedChunkReader * reader = new(CHUNK_MEM_FLAGS) NSChunkFile::MappedChunkReader();
+    if (!reader->Open(fileName)) {
+        delete reader;
+        reader = NULL;
+    }
+
+    return IChunkReaderPtr(reader);
+}
+
+//====================================================
+IChunkWriterPtr StreamCreateChunked(IRawStreamPtr target) {
+    if (target == NULL) 
+        return IChunkWriterPtr(NULL);
+
+    return IChunkWriterPtr(new(CHUNK_MEM_FLAGS) NSChunkFile::ChunkWriter(target));
+}
@@ -0,0 +1,934 @@
+/*
+   GameRiff - Framework for creating various video game services
+   JSON reader with SIMD structural scanning
+   Copyright (C) 2011, Shaun Leach.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are
+   met:
+  
+       * Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+       * Redistributions in binary form must reproduce the above
+   copyright notice, this list of conditions and the following disclaimer
+   in the documentation and/or other materials provided with the
+   distribution.
+  
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include "Pch.h"
+
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+    #define JSON_USE_SSE2
+    #include <emmintrin.h>
+#endif
+
+#ifdef _MSC_VER
+    #include <intrin.h>
+#endif
+
+namespace NSJSONReader {
+
+//////////////////////////////////////////////////////
+//
+// Constants
+//
+
+#define JSON_READER_MEM_FLAGS (MemFlags(MEM_ARENA_DEFAULT, MEM_CAT_JSON))
+
+static const unsigned   s_readSize      = 64 * 1024;
+static const unsigned   s_blockSize     = 64;
+static const unsigned   s_maxDepth      = 256;
+static const unsigned   s_noNode        = 0xffffffff;
+static const uint64     s_evenBits      = 0x5555555555555555ULL;
+static const uint64     s_oddBits       = ~s_evenBits;
+
+//////////////////////////////////////////////////////
+//
+// Internal
+//
+
+// Decoded text in the buffer
+struct Token {
+    unsigned    start;
+    unsigned    len;
+};
+
+// Members can come in any order, so the attributes of a node are chained
+struct JSONAttribute {
+    Hash32      nameHash;
+    Token       name;
+    Token       value;
+    unsigned    next;
+};
+
+// Nodes are indexed in document order, the document itself first
+struct JSONNode {
+    Hash32      nameHash;
+    Token       name;
+    Token       value;          // start is s_noNode without a "#value"
+    unsigned    firstAttribute;
+    unsigned    parent;
+    unsigned    firstChild;
+    unsigned    nextSibling;
+};
+
+// A bit for each byte of a block in each class
+struct BlockMasks {
+    uint64      quote;
+    uint64      backslash;
+    uint64      op;
+    uint64      space;
+};
+
+class JSONReader : public IStructuredTextStream {
+public:
+    JSONReader(charsys * text, unsigned size, bool ownsText, const chargr * name);
+    ~JSONReader();
+
+    bool Open();
+
+    const chargr * GetName() const;
+
+    EStreamError Save();
+
+    EStreamError WriteNode(const chargr * name);
+    EStreamError WriteNodeValue(const chargr * value);
+    EStreamError EndNode();
+    EStreamError WriteNodeAttribute(const chargr * name, const chargr * value);
+
+    EStreamError ReadNodeName(chargr * name, unsigned len);
+    EStreamError ReadNextNode();
+    EStreamError ReadParentNode();
+    EStreamError ReadNodeValue(chargr * value, unsigned len) const;
+    EStreamError ReadNodeAttribute(
+        const chargr  * name, 
+        unsigned        nameLen,
+        chargr        * value, 
+        unsigned        len
+    ) const;
+    EStreamError ReadChildNode();
+
+    EStreamError ReadNodeNameView(StreamTextView * name) const;
+    EStreamError ReadNodeValueView(StreamTextView * value) const;
+    EStreamError ReadNodeAttributeView(const charsys * name, StreamTextView * value) const;
+
+    EStreamError ReadNodeNameHash(Hash32 * name) const;
+    EStreamError ReadNodeAttributeHash(Hash32 name, Hash32 * value) const;
+
+private:
+    bool Scan();
+
+    bool Parse();
+    bool ParseNode(unsigned parent, unsigned depth);
+    bool ParseNodeArray(unsigned parent, unsigned depth);
+    bool ParseString(Token * token);
+    bool ParseText(Token * token);
+    bool DecodeEscape(charsys ** in, charsys ** out);
+
+    charsys Peek() const {
+        return m_next < m_numStructurals ? m_text[m_structurals[m_next]] : 0;
+    }
+    bool Expect(charsys c) {
+        if (Peek() != c) 
+            return false;
+        m_next++;
+        return true;
+    }
+    Token MakeToken(const charsys * start, const charsys * end) const {
+        Token token = { static_cast<unsigned>(start - m_text), static_cast<unsigned>(end - start) };
+        return token;
+    }
+    bool TokenEquals(const Token & token, const char * str) const {
+        return token.len == strlen(str) && memcmp(m_text + token.start, str, token.len) == 0;
+    }
+    Hash32 HashToken(const Token & token) const {
+        return HashUtf8String32(m_text + token.start, token.len);
+    }
+
+private:
+    chargr            m_name[256];
+
+    charsys         * m_text;
+    unsigned          m_size;
+    bool              m_ownsText;
+    charsys         * m_end;
+
+    unsigned        * m_structurals;    // Positions found by the scan, only kept while parsing
+    unsigned          m_numStructurals;
+    unsigned          m_next;
+
+    JSONNode        * m_nodes;
+    unsigned          m_numNodes;
+    unsigned          m_maxNodes;
+    JSONAttribute   * m_attributes;
+    unsigned          m_numAttributes;
+    unsigned          m_maxAttributes;
+
+    unsigned          m_current;
+};
+
+//====================================================
+static bool IsTextEnd(int c) {
+    switch (c) {
+        case ' ':   case '\t':  case '\r':  case '\n':
+        case '{':   case '}':   case '[':   case ']':
+        case ':':   case ',':   case '"':
+            return true;
+        default:
+            return false;
+    }
+}
+
+//====================================================
+static int HexDigit(int c) {
+    if (c >= '0' && c <= '9') 
+        return c - '0';
+    if (c >= 'a' && c <= 'f') 
+        return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') 
+        return c - 'A' + 10;
+    return -1;
+}
+
+//====================================================
+static unsigned LowestBit(uint64 bits) {
+#ifdef _MSC_VER
+    unsigned long index;
+    if (_BitScanForward(&index, static_cast<unsigned long>(bits))) 
+        return index;
+    _BitScanForward(&index, static_cast<unsigned long>(bits >> 32));
+    return index + 32;
+#else
+    return __builtin_ctzll(bits);
+#endif
+}
+
+//====================================================
+// Each bit is the xor of itself and every bit below it, which turns the 
+//  quotes into the spans between them
+static uint64 PrefixXor(uint64 bits) {
+    bits ^= bits << 1;
+    bits ^= bits << 2;
+    bits ^= bits << 4;
+    bits ^= bits << 8;
+    bits ^= bits << 16;
+    bits ^= bits << 32;
+    return bits;
+}
+
+//====================================================
+// Bytes after a run of an odd number of backslashes are escaped. Adding a 
+//  run's first bit to the run carries past its end, and the run's length is
+//  odd when the carry lands on the other parity of bit it started on. Runs
+//  starting on even and odd bits are added separately so each is checked 
+//  against its own parity.
+static uint64 FindEscaped(uint64 backslash, uint64 * prevEndsOdd) {
+    uint64 starts           = backslash & ~(backslash << 1);
+    uint64 evenStartMask    = s_evenBits ^ *prevEndsOdd;
+    uint64 evenStarts       = starts & evenStartMask;
+    uint64 oddStarts        = starts & ~evenStartMask;
+    uint64 evenCarries      = backslash + evenStarts;
+    uint64 oddCarries       = backslash + oddStarts;
+    bool   endsOdd          = oddCarries < backslash;
+
+    oddCarries |= *prevEndsOdd;
+    *prevEndsOdd = endsOdd ? 1 : 0;
+
+    uint64 evenCarryEnds    = evenCarries & ~backslash;
+    uint64 oddCarryEnds     = oddCarries & ~backslash;
+    return (evenCarryEnds & s_oddBits) | (oddCarryEnds & s_evenBits);
+}
+
+#ifdef JSON_USE_SSE2
+
+//====================================================
+// Sixteen bytes a compare. '[' and ']' only differ from '{' and '}' by the 
+//  0x20 bit, so setting it finds both with one compare.
+static void ClassifyBlock(const charsys * block, BlockMasks * masks) {
+    const __m128i quote         = _mm_set1_epi8('"');
+    const __m128i backslash     = _mm_set1_epi8('\\');
+    const __m128i caseBit       = _mm_set1_epi8(0x20);
+    const __m128i openBrace     = _mm_set1_epi8('{');
+    const __m128i closeBrace    = _mm_set1_epi8('}');
+    const __m128i colon         = _mm_set1_epi8(':');
+    const __m128i comma         = _mm_set1_epi8(',');
+    const __m128i space         = _mm_set1_epi8(' ');
+    const __m128i tab           = _mm_set1_epi8('\t');
+    const __m128i carriage      = _mm_set1_epi8('\r');
+    const __m128i newline       = _mm_set1_epi8('\n');
+
+    masks->quote        = 0;
+    masks->backslash    = 0;
+    masks->op           = 0;
+    masks->space        = 0;
+    for (unsigned i = 0; i < s_blockSize; i += 16) {
+        __m128i bytes   = _mm_loadu_si128(reinterpret_cast<const __m128i *>(block + i));
+        __m128i folded  = _mm_or_si128(bytes, caseBit);
+        __m128i ops     = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(folded, openBrace), _mm_cmpeq_epi8(folded, closeBrace)),
+            _mm_or_si128(_mm_cmpeq_epi8(bytes, colon), _mm_cmpeq_epi8(bytes, comma))
+        );
+        __m128i spaces  = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(bytes, space), _mm_cmpeq_epi8(bytes, tab)),
+            _mm_or_si128(_mm_cmpeq_epi8(bytes, carriage), _mm_cmpeq_epi8(bytes, newline))
+        );
+
+        masks->quote        |= static_cast<uint64>(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, quote))) << i;
+        masks->backslash    |= static_cast<uint64>(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, backslash))) << i;
+        masks->op           |= static_cast<uint64>(_mm_movemask_epi8(ops)) << i;
+        masks->space        |= static_cast<uint64>(_mm_movemask_epi8(spaces)) << i;
+    }
+}
+
+//====================================================
+static charsys * FindStringEnd(charsys * pos, const charsys * end) {
+    const __m128i quote     = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    while (end - pos >= 16) {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(pos));
+        unsigned found = _mm_movemask_epi8(
+            _mm_or_si128(_mm_cmpeq_epi8(bytes, quote), _mm_cmpeq_epi8(bytes, backslash))
+        );
+        if (found != 0) 
+            return pos + LowestBit(found);
+        pos += 16;
+    }
+
+    while (pos < end && *pos != '"' && *pos != '\\') 
+        pos++;
+    return pos;
+}
+
+#else
+
+//====================================================
+static void ClassifyBlock(const charsys * block, BlockMasks * masks) {
+    masks->quote        = 0;
+    masks->backslash    = 0;
+    masks->op           = 0;
+    masks->space        = 0;
+    for (unsigned i = 0; i < s_blockSize; i++) {
+        uint64 bit = static_cast<uint64>(1) << i;
+        switch (block[i]) {
+            case '"':
+                masks->quote |= bit;
+                break;
+            case '\\':
+                masks->backslash |= bit;
+                break;
+            case '{':   case '}':   case '[':   case ']':   case ':':   case ',':
+                masks->op |= bit;
+                break;
+            case ' ':   case '\t':  case '\r':  case '\n':
+                masks->space |= bit;
+                break;
+        }
+    }
+}
+
+//====================================================
+static charsys * FindStringEnd(charsys * pos, const charsys * end) {
+    while (pos < end && *pos != '"' && *pos != '\\') 
+        pos++;
+    return pos;
+}
+
+#endif
+
+//====================================================
+static void EncodeUtf8(unsigned code, charsys ** out) {
+    charsys * dest = *out;
+    if (code < 0x80) 
+        *dest++ = static_cast<charsys>(code);
+    else if (code < 0x800) {
+        *dest++ = static_cast<charsys>(0xc0 | (code >> 6));
+        *dest++ = static_cast<charsys>(0x80 | (code & 0x3f));
+    }
+    else if (code < 0x10000) {
+        *dest++ = static_cast<charsys>(0xe0 | (code >> 12));
+        *dest++ = static_cast<charsys>(0x80 | ((code >> 6) & 0x3f));
+        *dest++ = static_cast<charsys>(0x80 | (code & 0x3f));
+    }
+    else {
+        *dest++ = static_cast<charsys>(0xf0 | (code >> 18));
+        *dest++ = static_cast<charsys>(0x80 | ((code >> 12) & 0x3f));
+        *dest++ = static_cast<charsys>(0x80 | ((code >> 6) & 0x3f));
+        *dest++ = static_cast<charsys>(0x80 | (code & 0x3f));
+    }
+
+    *out = dest;
+}
+
+//====================================================
+// Reads the rest of a stream into one buffer
+static charsys * ReadAll(IRawStreamPtr source, unsigned * size) {
+    unsigned capacity = s_readSize;
+    charsys * text = new(JSON_READER_MEM_FLAGS) charsys[capacity];
+    unsigned used = 0;
+    for (;;) {
+        if (used == capacity) {
+            charsys * newText = new(JSON_READER_MEM_FLAGS) charsys[2 * capacity];
+            memcpy(newText, text, used);
+            delete [] text;
+            text        = newText;
+            capacity    = 2 * capacity;
+        }
+
+        unsigned read = 0;
+        source->ReadBytes(text + used, capacity - used, &read);
+        if (read == 0) 
+            break;
+        used += read;
+    }
+
+    *size = used;
+    return text;
+}
+
+//====================================================
+JSONReader::JSONReader(charsys * text, unsigned size, bool ownsText, const chargr * name) :
+    m_text(text),
+    m_size(size),
+    m_ownsText(ownsText),
+    m_end(text + size),
+    m_structurals(NULL),
+    m_numStructurals(0),
+    m_next(0),
+    m_nodes(NULL),
+    m_numNodes(0),
+    m_maxNodes(0),
+    m_attributes(NULL),
+    m_numAttributes(0),
+    m_maxAttributes(0),
+    m_current(0)
+{
+    StrCopy(m_name, 256, name);
+}
+
+//====================================================
+JSONReader::~JSONReader() {
+    if (m_ownsText) 
+        delete [] m_text;
+    if (m_structurals != NULL) 
+        delete [] m_structurals;
+    if (m_nodes != NULL) 
+        delete [] m_nodes;
+    if (m_attributes != NULL) 
+        delete [] m_attributes;
+}
+
+//====================================================
+bool JSONReader::Open() {
+    if (!Scan()) 
+        return false;
+
+    // Every node is an object and every attribute a member, so counting 
+    //  their operators sizes the index once
+    m_maxNodes      = 1;
+    m_maxAttributes = 0;
+    for (unsigned i = 0; i < m_numStructurals; i++) {
+        charsys c = m_text[m_structurals[i]];
+        if (c == '{') 
+            m_maxNodes++;
+        else if (c == ':') 
+            m_maxAttributes++;
+    }
+    m_nodes = new(JSON_READER_MEM_FLAGS) JSONNode[m_maxNodes];
+    if (m_maxAttributes > 0) 
+        m_attributes = new(JSON_READER_MEM_FLAGS) JSONAttribute[m_maxAttributes];
+
+    bool parsed = Parse();
+    delete [] m_structurals;
+    m_structurals = NULL;
+    if (!parsed) 
+        return false;
+
+    m_current = m_nodes[0].firstChild;
+    return m_current != s_noNode;
+}
+
+//====================================================
+const chargr * JSONReader::GetName() const {
+    return m_name;
+}
+
+//====================================================
+EStreamError JSONReader::Save() {
+    ASSERTMSGGR(false, "JSON readers are read only");
+    return STREAM_ERROR_FILENOTOPENED;
+}
+
+//====================================================
+EStreamError JSONReader::WriteNode(const chargr * name) {
+    ASSERTMSGGR(false, "JSON readers are read only");
+    return STREAM_ERROR_FILENOTOPENED;
+}
+
+//====================================================
+EStreamError JSONReader::WriteNodeValue(const chargr * value) {
+    ASSERTMSGGR(false, "JSON readers are read only");
+    return STREAM_ERROR_FILENOTOPENED;
+}
+
+//====================================================
+EStreamError JSONReader::EndNode() {
+    ASSERTMSGGR(false, "JSON readers are read only");
+    return STREAM_ERROR_FILENOTOPENED;
+}
+
+//====================================================
+EStreamError JSONReader::WriteNodeAttribute(const chargr * name, const chargr * value) {
+    ASSERTMSGGR(false, "JSON readers are read only");
+    return STREAM_ERROR_FILENOTOPENED;
+}
+
+//====================================================
+EStreamError JSONReader::ReadNodeName(chargr * name, unsigned len) {
+    StreamTextView view;
+    ReadNodeNameView(&view);
+    StreamViewToCharGr(view, name, len);
+
+    return STREAM_ERROR_OK;
+}
+
+//====================================================
+EStreamError JSONReader::ReadChildNode() {
+    unsigned child = m_nodes[m_current].firstChild;
+    if (child == s_noNode) 
+        return STREAM_ERROR_NODEDOESNTEXIST;
+
+    m_current = child;
+    return STREAM_ERROR_OK;
+}
+
+//====================================================
+EStreamError JSONReader::ReadNextNode() {
+    unsigned sibling = m_nodes[m_current].nextSibling;
+    if (sibling == s_noNode) 
+        return STREAM_ERROR_NODEDOESNTEXIST;
+
+    m_current = sibling;
+    return STREAM_ERROR_OK;
+}
+
+//====================================================
+EStreamError JSONReader::ReadParentNode() {
+    if (m_current == 0) 
+        return STREAM_ERROR_NODEDOESNTEXIST;
+
+    m_current = m_nodes[m_current].parent;
+    return STREAM_ERROR_OK;
+}
+
+//====================================================
+EStreamError JSONReader::ReadNodeValue(chargr * value, unsigned len) const {
+    StreamTextView view;
+    EStreamError result = ReadNodeValueView(&view);
+    StreamViewToCharGr(view, value, len);
+
+    return result;
+}
+
+//====================================================
+EStreamError JSONReader::ReadNodeAttribute(
+    const chargr  * name, 
+    unsigned        nameLen, 
+    chargr        * value, 
+    unsigned        valueLen
+) const {
+    StrStackConverter sysName(name, nameLen);
+    StreamTextView view;
+    EStreamError result = ReadNodeAttributeView(sysName, &view);
+    StreamViewToCharGr(view, value, valueLen);
+
+    return result;
+}
+
+//====================================================
+EStreamError JSONReader::ReadNodeNameView(StreamTextView * name) const {
+    const Token & token = m_nodes[m_current].name;
+    name->str = m_text + token.start;
+    name->len = token.len;
+
+    return STREAM_ERROR_OK;
+}
+
+//====================================================
+EStreamError JSONReader::ReadNodeValueView(StreamTextView * value) const {
+    const Token & token = m_nodes[m_current].value;
+    if (token.start == s_noNode) {
+        value->str = "";
+        value->len = 0;
+        return STREAM_ERROR_NODEDOESNTEXIST;
+    }
+
+    value->str = m_text + token.start;
+    value->len = token.len;
+
+    return STREAM_ERROR_OK;
+}
+
+//====================================================
+EStreamError JSONReader::ReadNodeAttributeView(const charsys * name, StreamTextView * value) const {
+    unsigned nameLen = strlen(name);
+    for (unsigned i = m_nodes[m_current].firstAttribute; i != s_noNode; i = m_attributes[i].next) {
+        const JSONAttribute & attribute = m_attributes[i];
+        if (attribute.name.len == nameLen && memcmp(m_text + attribute.name.start, name, nameLen) == 0) {
+            value->str = m_text + attribute.value.start;
+            value->len = attribute.value.len;
+            return STREAM_ERROR_OK;
+        }
+    }
+
+    value->str = "";
+    value->len = 0;
+    return STREAM_ERROR_BADDATA;
+}
+
+//====================================================
+EStreamError JSONReader::ReadNodeNameHash(Hash32 * name) const {
+    *name = m_nodes[m_current].nameHash;
+
+    return STREAM_ERROR_OK;
+}
+
+//====================================================
+EStreamError JSONReader::ReadNodeAttributeHash(Hash32 name, Hash32 * value) const {
+    for (unsigned i = m_nodes[m_current].firstAttribute; i != s_noNode; i = m_attributes[i].next) {
+        const JSONAttribute & attribute = m_attributes[i];
+        if (attribute.nameHash == name) {
+            *value = HashToken(attribute.value);
+            return STREAM_ERROR_OK;
+        }
+    }
+
+    return STREAM_ERROR_BADDATA;
+}
+
+//====================================================
+// Finds the positions the parse visits, a block of 64 bytes at a time the 
+//  way simdjson's first stage does. Each byte is classified into bit masks,
+//  escaped quotes are taken out, and a prefix xor of the quotes that are 
+//  left gives the insides of the strings. Operators and the first bytes of
+//  numbers and literals outside of strings are kept, along with the quotes
+//  that open strings. State carried between blocks is a bit each.
+bool JSONReader::Scan() {
+    unsigned start = 0;
+    if (m_size >= 3 && memcmp(m_text, "\xef\xbb\xbf", 3) == 0) 
+        start = 3;
+
+    m_structurals = new(JSON_READER_MEM_FLAGS) unsigned[m_size + 1];
+
+    uint64 prevEscaped  = 0;
+    uint64 prevInString = 0;
+    uint64 prevText     = 0;
+    unsigned count = 0;
+    for (unsigned base = start; base < m_size; base += s_blockSize) {
+        // The last block is padded with spaces
+        charsys padded[s_blockSize];
+        const charsys * block = m_text + base;
+        if (m_size - base < s_blockSize) {
+            memset(padded, ' ', s_blockSize);
+            memcpy(padded, block, m_size - base);
+            block = padded;
+        }
+
+        BlockMasks masks;
+        ClassifyBlock(block, &masks);
+
+        uint64 quote        = masks.quote & ~FindEscaped(masks.backslash, &prevEscaped);
+        uint64 inString     = PrefixXor(quote) ^ prevInString;
+        prevInString        = 0 - (inString >> 63);
+
+        uint64 text         = ~(masks.op | masks.space | quote);
+        uint64 textStart    = text & ~((text << 1) | prevText);
+        prevText            = text >> 63;
+
+        uint64 structurals  = ((masks.op | textStart) & ~inString) | (quote & inString);
+        while (structurals != 0) {
+            m_structurals[count++] = base + LowestBit(structurals);
+            structurals &= structurals - 1;
+        }
+    }
+
+    m_numStructurals = count;
+    return prevInString == 0;
+}
+
+//====================================================
+bool JSONReader::Parse() {
+    JSONNode & document     = m_nodes[m_numNodes++];
+    document.name           = MakeToken(m_text, m_text);
+    document.nameHash       = HashToken(document.name);
+    document.value.start    = s_noNode;
+    document.value.len      = 0;
+    document.firstAttribute = s_noNode;
+    document.parent         = s_noNode;
+    document.firstChild     = s_noNode;
+    document.nextSibling    = s_noNode;
+
+    bool parsed = false;
+    if (Peek() == '[') 
+        parsed = ParseNodeArray(0, 0);
+    else {
+        document.firstChild = m_numNodes;
+        parsed = ParseNode(0, 0);
+    }
+
+    return parsed && m_next == m_numStructurals;
+}
+
+//====================================================
+// Members other than the ones starting with '#' are attributes
+bool JSONReader::ParseNode(unsigned parent, unsigned depth) {
+    if (depth == s_maxDepth || !Expect('{')) 
+        return false;
+
+    ASSERTGR(m_numNodes < m_maxNodes);
+    unsigned index      = m_numNodes++;
+    JSONNode & node     = m_nodes[index];
+    node.name.start     = s_noNode;
+    node.name.len       = 0;
+    node.value.start    = s_noNode;
+    node.value.len      = 0;
+    node.firstAttribute = s_noNode;
+    node.parent         = parent;
+    node.firstChild     = s_noNode;
+    node.nextSibling    = s_noNode;
+
+    if (Peek() != '}') {
+        do {
+            Token key;
+            if (!ParseString(&key) || !Expect(':')) 
+                return false;
+
+            if (key.len > 0 && m_text[key.start] == '#') {
+                if (TokenEquals(key, "#name")) {
+                    if (!ParseString(&node.name)) 
+                        return false;
+                }
+                else if (TokenEquals(key, "#value")) {
+                    if (!ParseText(&node.value)) 
+                        return false;
+                }
+                else if (TokenEquals(key, "#children")) {
+                    if (node.firstChild != s_noNode || !ParseNodeArray(index, depth + 1)) 
+                        return false;
+                }
+                else
+                    return false;
+                continue;
+            }
+
+            ASSERTGR(m_numAttributes < m_maxAttributes);
+            JSONAttribute & attribute = m_attributes[m_numAttributes];
+            attribute.name      = key;
+            attribute.nameHash  = HashToken(key);
+            attribute.next      = node.firstAttribute;
+            if (!ParseText(&attribute.value)) 
+                return false;
+            node.firstAttribute = m_numAttributes++;
+        } while (Expect(','));
+    }
+
+    if (!Expect('}') || node.name.start == s_noNode) 
+        return false;
+
+    node.nameHash = HashToken(node.name);
+    return true;
+}
+
+//====================================================
+// A node's children, or the top level nodes
+bool JSONReader::ParseNodeArray(unsigned parent, unsigned depth) {
+    if (!Expect('[')) 
+        return false;
+
+    unsigned lastChild = s_noNode;
+    if (Peek() != ']') {
+        do {
+            unsigned index = m_numNodes;
+            if (!ParseNode(parent, depth)) 
+                return false;
+
+            if (lastChild == s_noNode) 
+                m_nodes[parent].firstChild = index;
+            else
+                m_nodes[lastChild].nextSibling = index;
+            lastChild = index;
+        } while (Expect(','));
+    }
+
+    return Expect(']');
+}
+
+//====================================================
+// Escapes are decoded over the string itself, which never grows. Strings 
+//  without any are left where they are.
+bool JSONReader::ParseString(Token * token) {
+    if (Peek() != '"') 
+        return false;
+
+    charsys * start = m_text + m_structurals[m_next++] + 1;
+    charsys * in    = FindStringEnd(start, m_end);
+    charsys * out   = in;
+    while (in < m_end) {
+        if (*in == '"') {
+            *token = MakeToken(start, out);
+            return true;
+        }
+
+        in++;
+        if (!DecodeEscape(&in, &out)) 
+            return false;
+
+        // Copies up to the next quote or escape
+        charsys * end = FindStringEnd(in, m_end);
+        memmove(out, in, end - in);
+        out += end - in;
+        in   = end;
+    }
+
+    return false;
+}
+
+//====================================================
+// Strings, or numbers and literals as their text
+bool JSONReader::ParseText(Token * token) {
+    charsys c = Peek();
+    if (c == '"') 
+        return ParseString(token);
+    if (c == 0 || IsTextEnd(c)) 
+        return false;
+
+    charsys * start = m_text + m_structurals[m_next++];
+    charsys * end   = start;
+    while (end < m_end && !IsTextEnd(*end)) 
+        end++;
+    *token = MakeToken(start, end);
+
+    if (c == 't') 
+        return TokenEquals(*token, "true");
+    if (c == 'f') 
+        return TokenEquals(*token, "false");
+    if (c == 'n') 
+        return TokenEquals(*token, "null");
+    if (c != '-' && (c < '0' || c > '9')) 
+        return false;
+
+    for (const charsys * pos = start; pos < end; pos++) {
+        if (*pos == 0 || strchr("0123456789+-.eE", *pos) == NULL) 
+            return false;
+    }
+    return true;
+}
+
+//====================================================
+// Left after the backslash
+bool JSONReader::DecodeEscape(charsys ** in, charsys ** out) {
+    charsys * pos = *in;
+    if (pos == m_end) 
+        return false;
+
+    unsigned code = 0;
+    switch (*pos++) {
+        case '"':   code = '"';     break;
+        case '\\':  code = '\\';    break;
+        case '/':   code = '/';     break;
+        case 'b':   code = '\b';    break;
+        case 'f':   code = '\f';    break;
+        case 'n':   code = '\n';    break;
+        case 'r':   code = '\r';    break;
+        case 't':   code = '\t';    break;
+        case 'u':
+            for (unsigned pair = 0; ; pair++) {
+                if (m_end - pos < 4) 
+                    return false;
+
+                unsigned unit = 0;
+                for (unsigned i = 0; i < 4; i++) {
+                    int digit = HexDigit(*pos++);
+                    if (digit < 0) 
+                        return false;
+                    unit = (unit << 4) | digit;
+                }
+
+                // Characters past the first plane come as two surrogates
+                if (pair == 0 && unit >= 0xd800 && unit < 0xdc00) {
+                    if (m_end - pos < 2 || pos[0] != '\\' || pos[1] != 'u') 
+                        return false;
+                    pos += 2;
+                    code = unit;
+                    continue;
+                }
+                if (pair == 0 && unit >= 0xdc00 && unit < 0xe000) 
+                    return false;
+                if (pair == 1) {
+                    if (unit < 0xdc00 || unit >= 0xe000) 
+                        return false;
+                    unit = 0x10000 + ((code - 0xd800) << 10) + (unit - 0xdc00);
+                }
+
+                code = unit;
+                break;
+            }
+            break;
+        default:
+            return false;
+    }
+
+    EncodeUtf8(code, out);
+    *in = pos;
+    return true;
+}
+
+} // namespace NSJSONReader
+
+//////////////////////////////////////////////////////
+//
+// External functions
+//
+
+//====================================================
+static IStructuredTextStreamPtr OpenJSON(charsys * text, unsigned size, bool ownsText, const chargr * name) {
+    NSJSONReader::JSONReader * reader = new(JSON_READER_MEM_FLAGS) NSJSONReader::JSONReader(text, size, ownsText, name);
+    if (!reader->Open()) {
+        delete reader;
+        reader = NULL;
+    }
+
+    return IStructuredTextStreamPtr(reader);
+}
+
+//====================================================
+IStructuredTextStreamPtr StreamOpenJSON(charsys * text, unsigned size, const chargr * name) {
+    return OpenJSON(text, size, false, name);
+}
+
+//====================================================
+IStructuredTextStreamPtr StreamOpenJSON(IRawStreamPtr source, const chargr * name) {
+    if (source == NULL) 
+        return IStructuredTextStreamPtr(NULL);
+
+    unsigned size = 0;
+    charsys * text = NSJSONReader::ReadAll(source, &size);
+    return OpenJSON(text, size, true, name);
+}
+
+//====================================================
+IStructuredTextStreamPtr StreamOpenJSON(const chargr * fileName) {
+    return StreamOpenJSON(StreamOpenFile(fileName), fileName);
+}
@@ -0,0 +1,371 @@
+/*
+   GameRiff - Framework for creating various video game services
+   Streaming JSON writer
+   Copyright (C) 2011, Shaun Leach.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are
+   met:
+  
+       * Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+       * Redistributions in binary form must reproduce the above
+   copyright notice, this list of conditions and the following disclaimer
+   in the documentation and/or other materials provided with the
+   distribution.
+  
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include "Pch.h"
+
+namespace NSJSONWriter {
+
+//////////////////////////////////////////////////////
+//
+// Constants
+//
+
+#define JSON_WRITER_MEM_FLAGS (MemFlags(MEM_ARENA_DEFAULT, MEM_CAT_JSON))
+
+static const unsigned   s_maxDepth          = 256;
+static const char       s_indent[]          = "    ";
+
+//////////////////////////////////////////////////////
+//
+// Internal
+//
+
+// Writes each node as it's given, the members of a node on one line and 
+//  each child on a line of its own. Only whether each open node has 
+//  children is kept, for the commas and closing brackets.
+class JSONWriter : public IStructuredTextStream {
+public:
+    JSONWriter(IRawStreamPtr target, const chargr * name);
+
+    const chargr * GetName() const;
+
+    EStreamError Save();
+
+    EStreamError WriteNode(const chargr * name);
+    EStreamError WriteNodeValue(const chargr * value);
+    EStreamError EndNode();
+    EStreamError WriteNodeAttribute(const chargr * name, const chargr * value);
+
+    EStreamError ReadNodeName(chargr * name, unsigned len);
+    EStreamError ReadNextNode();
+    EStreamError ReadParentNode();
+    EStreamError ReadNodeValue(chargr * value, unsigned len) const;
+    EStreamError ReadNodeAttribute(
+        const chargr  * name, 
+        unsigned        nameLen,
+        chargr        * value, 
+        unsigned        len
+    ) const;
+    EStreamError ReadChildNode();
+
+    EStreamError ReadNodeNameView(StreamTextView * name) const;
+    EStreamError ReadNodeValueView(StreamTextView * value) const;
+    EStreamError ReadNodeAttributeView(const charsys * name, StreamTextView * value) const;
+
+    EStreamError ReadNodeNameHash(Hash32 * name) const;
+    EStreamError ReadNodeAttributeHash(Hash32 name, Hash32 * value) const;
+
+private:
+    void Write(const char * str, unsigned len);
+    void WriteIndent(unsigned depth);
+    void WriteString(const chargr * str);
+
+private:
+    DataStream      m_stream;
+    chargr          m_name[256];
+    EStreamError    m_result;
+
+    bool            m_hasChildren[s_maxDepth + 1];  // The document's are the top level nodes
+    unsigned        m_depth;
+    unsigned        m_skipDepth;        // Nodes past the limits that aren't written
+    bool            m_hasValue;         // Whether the current node has a value
+    bool            m_closed;           // The top level array was closed by Save
+};
+
+//====================================================
+JSONWriter::JSONWriter(IRawStreamPtr target, const chargr * name) :
+    m_stream(target),
+    m_result(STREAM_ERROR_OK),
+    m_depth(0),
+    m_skipDepth(0),
+    m_hasValue(false),
+    m_closed(false)
+{
+    StrCopy(m_name, 256, name);
+    m_hasChildren[0] = false;
+    Write("[", 1);
+}
+
+//====================================================
+const chargr * JSONWriter::GetName() const {
+    return m_name;
+}
+
+//====================================================
+// Closes the top level array, so no nodes can be added after
+EStreamError JSONWriter::Save() {
+    ASSERTMSGGR(m_depth == 0, "Saving a JSON file with nodes still open");
+
+    if (!m_closed) {
+        if (m_hasChildren[0]) 
+            Write("\n", 1);
+        Write("]\n", 2);
+        m_closed = true;
+    }
+
+    EStreamError result = m_stream.Flush();
+    if (m_result == STREAM_ERROR_OK) 
+        m_result = result;
+    return m_result;
+}
+
+//====================================================
+EStreamError JSONWriter::WriteNode(const chargr * name) {
+    ASSERTMSGGR(!m_closed, "Writing to a saved JSON file");
+    if (m_skipDepth > 0 || m_depth == s_maxDepth || m_closed) {
+        m_skipDepth++;
+        return STREAM_ERROR_BADDATA;
+    }
+
+    if (m_hasChildren[m_depth]) 
+        Write(",", 1);
+    else if (m_depth > 0) 
+        Write(", \"#children\": [", 16);
+    m_hasChildren[m_depth] = true;
+
+    Write("\n", 1);
+    WriteIndent(m_depth + 1);
+    Write("{ \"#name\": ", 11);
+    WriteString(name);
+
+    m_depth++;
+    m_hasChildren[m_depth]  = false;
+    m_hasValue              = false;
+    return m_result;
+}
+
+//====================================================
+EStreamError JSONWriter::WriteNodeValue(const chargr * value) {
+    if (m_depth == 0 || m_skipDepth > 0) 
+        return STREAM_ERROR_BADDATA;
+
+    // Members can't follow the children, and a key only comes once
+    ASSERTMSGGR(!m_hasChildren[m_depth], "Values must be written before the node's children");
+    ASSERTMSGGR(!m_hasValue, "Nodes only have one value");
+    if (m_hasChildren[m_depth] || m_hasValue) 
+        return STREAM_ERROR_BADDATA;
+
+    Write(", \"#value\": ", 12);
+    WriteString(value);
+    m_hasValue = true;
+    return m_result;
+}
+
+//====================================================
+EStreamError JSONWriter::EndNode() {
+    if (m_skipDepth > 0) {
+        m_skipDepth--;
+        return STREAM_ERROR_OK;
+    }
+    if (m_depth == 0) 
+        return STREAM_ERROR_BADDATA;
+
+    if (m_hasChildren[m_depth]) {
+        Write("\n", 1);
+        WriteIndent(m_depth);
+        Write("] }", 3);
+    }
+    else
+        Write(" }", 2);
+
+    m_depth--;
+    return m_result;
+}
+
+//====================================================
+EStreamError JSONWriter::WriteNodeAttribute(const chargr * name, const chargr * value) {
+    if (m_depth == 0 || m_skipDepth > 0) 
+        return STREAM_ERROR_BADDATA;
+
+    ASSERTMSGGR(!m_hasChildren[m_depth], "Attributes must be written before the node's children");
+    ASSERTMSGGR(name[0] != L'#', "Attribute names can't start with '#'");
+    if (m_hasChildren[m_depth] || name[0] == L'#') 
+        return STREAM_ERROR_BADDATA;
+
+    Write(", ", 2);
+    WriteString(name);
+    Write(": ", 2);
+    WriteString(value);
+    return m_result;
+}
+
+//====================================================
+EStreamError JSONWriter::ReadNodeName(chargr * name, unsigned len) {
+    ASSERTMSGGR(false, "JSON writers are write only");
+    return STREAM_ERROR_FILENOTOPENED;
+}
+
+//====================================================
+EStreamError JSONWriter::ReadNextNode() {
+    ASSERTMSGGR(false, "JSON writers are write only");
+    return STREAM_ERROR_NODEDOESNTEXIST;
+}
+
+//====================================================
+EStreamError JSONWriter::ReadParentNode() {
+    ASSERTMSGGR(false, "JSON writers are write only");
+    return STREAM_ERROR_NODEDOESNTEXIST;
+}
+
+//====================================================
+EStreamError JSONWriter::ReadNodeValue(chargr * value, unsigned len) const {
+    ASSERTMSGGR(false, "JSON writers are write only");
+    return STREAM_ERROR_FILENOTOPENED;
+}
+
+//====================================================
+EStreamError JSONWriter::ReadNodeAttribute(
+    const chargr  * name, 
+    unsigned        nameLen, 
+    chargr        * value, 
+    unsigned        valueLen
+) const {
+    ASSERTMSGGR(false, "JSON writers are write only");
+    return STREAM_ERROR_FILENOTOPENED;
+}
+
+//====================================================
+EStreamError JSONWriter::ReadChildNode() {
+    ASSERTMSGGR(false, "JSON writers are write only");
+    return STREAM_ERROR_NODEDOESNTEXIST;
+}
+
+//====================================================
+EStreamError JSONWriter::ReadNodeNameView(StreamTextView * name) const {
+    ASSERTMSGGR(false, "JSON writers are write only");
+    return STREAM_ERROR_FILENOTOPENED;
+}
+
+//====================================================
+EStreamError JSONWriter::ReadNodeValueView(StreamTextView * value) const {
+    ASSERTMSGGR(false, "JSON writers are write only");
+    return STREAM_ERROR_FILENOTOPENED;
+}
+
+//====================================================
+EStreamError JSONWriter::ReadNodeAttributeView(const charsys * name, StreamTextView * value) const {
+    ASSERTMSGGR(false, "JSON writers are write only");
+    return STREAM_ERROR_FILENOTOPENED;
+}
+
+//====================================================
+EStreamError JSONWriter::ReadNodeNameHash(Hash32 * name) const {
+    ASSERTMSGGR(false, "JSON writers are write only");
+    return STREAM_ERROR_FILENOTOPENED;
+}
+
+//====================================================
+EStreamError JSONWriter::ReadNodeAttributeHash(Hash32 name, Hash32 * value) const {
+    ASSERTMSGGR(false, "JSON writers are write only");
+    return STREAM_ERROR_FILENOTOPENED;
+}
+
+//====================================================
+void JSONWriter::Write(const char * str, unsigned len) {
+    EStreamError result = m_stream.WriteBytes(str, len);
+    if (m_result == STREAM_ERROR_OK) 
+        m_result = result;
+}
+
+//====================================================
+void JSONWriter::WriteIndent(unsigned depth) {
+    for (unsigned i = 0; i < depth; i++) 
+        Write(s_indent, sizeof(s_indent) - 1);
+}
+
+//====================================================
+// Quoted and encoded to UTF-8, a byte at a time through the stream's lent 
+//  block. Only quotes, backslashes and control characters are escaped.
+void JSONWriter::WriteString(const chargr * str) {
+    Write("\"", 1);
+    for (; *str != 0; str++) {
+        unsigned c = static_cast<unsigned>(*str);
+        if (c >= 0xd800 && c < 0xdc00 && str[1] >= 0xdc00 && str[1] < 0xe000) {
+            str++;
+            c = 0x10000 + ((c - 0xd800) << 10) + (static_cast<unsigned>(*str) - 0xdc00);
+        }
+
+        if (c < 0x80) {
+            switch (c) {
+                case '"':   Write("\\\"", 2);   break;
+                case '\\':  Write("\\\\", 2);   break;
+                case '\b':  Write("\\b", 2);    break;
+                case '\f':  Write("\\f", 2);    break;
+                case '\n':  Write("\\n", 2);    break;
+                case '\r':  Write("\\r", 2);    break;
+                case '\t':  Write("\\t", 2);    break;
+                default:
+                    if (c < 32) {
+                        char code[8];
+                        StrPrintf(code, 8, "\\u%04x", c);
+                        Write(code, 6);
+                    }
+                    else
+                        m_stream.Write<uint8>(static_cast<uint8>(c));
+            }
+        }
+        else if (c < 0x800) {
+            m_stream.Write<uint8>(static_cast<uint8>(0xc0 | (c >> 6)));
+            m_stream.Write<uint8>(static_cast<uint8>(0x80 | (c & 0x3f)));
+        }
+        else if (c < 0x10000) {
+            m_stream.Write<uint8>(static_cast<uint8>(0xe0 | (c >> 12)));
+            m_stream.Write<uint8>(static_cast<uint8>(0x80 | ((c >> 6) & 0x3f)));
+            m_stream.Write<uint8>(static_cast<uint8>(0x80 | (c & 0x3f)));
+        }
+        else {
+            m_stream.Write<uint8>(static_cast<uint8>(0xf0 | (c >> 18)));
+            m_stream.Write<uint8>(static_cast<uint8>(0x80 | ((c >> 12) & 0x3f)));
+            m_stream.Write<uint8>(static_cast<uint8>(0x80 | ((c >> 6) & 0x3f)));
+            m_stream.Write<uint8>(static_cast<uint8>(0x80 | (c & 0x3f)));
+        }
+    }
+    Write("\"", 1);
+}
+
+} // namespace NSJSONWriter
+
+//////////////////////////////////////////////////////
+//
+// External functions
+//
+
+//====================================================
+IStructuredTextStreamPtr StreamCreateJSON(IRawStreamPtr target, const chargr * name) {
+    if (target == NULL) 
+        return IStructuredTextStreamPtr(NULL);
+
+    return IStructuredTextStreamPtr(new(JSON_WRITER_MEM_FLAGS) NSJSONWriter::JSONWriter(target, name));
+}
+
+//====================================================
+IStructuredTextStreamPtr StreamCreateJSON(const chargr * fileName) {
+    return StreamCreateJSON(StreamCreateFile(fileName), fileName);
+}
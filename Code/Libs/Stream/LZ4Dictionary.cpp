@@ -0,0 +1,449 @@
+/*
+   GameRiff - Framework for creating various video game services
+   LZ4 blocks compressed against a shared dictionary, and dictionary training
+   Copyright (C) 2011, Shaun Leach.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are
+   met:
+  
+       * Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+       * Redistributions in binary form must reproduce the above
+   copyright notice, this list of conditions and the following disclaimer
+   in the documentation and/or other materials provided with the
+   distribution.
+  
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include "Pch.h"
+
+namespace NSLZ4Dictionary {
+
+//////////////////////////////////////////////////////
+//
+// Constants
+//
+
+#define LZ4_DICT_MEM_FLAGS (MemFlags(MEM_ARENA_DEFAULT, MEM_CAT_FILEIO))
+
+// Blocks are in Ext/lz4's format. Each sequence is a token with the literal 
+//  count in its high nibble and the match length less s_minMatch in its low 
+//  one, the rest of the count, the literals, a little endian offset and the 
+//  rest of the length. A full nibble carries on in bytes of 255 until a 
+//  smaller one. The last sequence is literals alone.
+static const unsigned   s_minMatch          = 4;
+static const unsigned   s_maxOffset         = 0xffff;
+static const unsigned   s_runMask           = 15;
+static const unsigned   s_lastLiterals      = 5;    // Matches end at least this far from the end
+static const unsigned   s_matchStartLimit   = 12;   // and start at least this far
+static const unsigned   s_hashBits          = 14;
+static const unsigned   s_skipShift         = 6;    // Steps faster through data that doesn't match
+
+// Positions are found by a hash of more than s_minMatch bytes. Objects 
+//  built from the same few strings and values are full of short matches 
+//  that lead to the wrong place, and hiding those lets the long ones through.
+static const unsigned   s_hashLength        = 8;
+
+// Training keeps the windows of s_segmentSize bytes whose s_hashLength byte 
+//  strings turn up in the most samples
+static const unsigned   s_segmentSize       = 64;
+static const unsigned   s_frequencyBits     = 20;
+
+//////////////////////////////////////////////////////
+//
+// Internal Types
+//
+
+class LZ4Dictionary : public ILZ4Dictionary {
+public:
+    LZ4Dictionary();
+    ~LZ4Dictionary();
+
+    bool Open(const void * data, unsigned size);
+
+    virtual const byte * GetData() const;
+    virtual unsigned GetSize() const;
+
+    virtual unsigned Compress(const void * raw, unsigned rawSize, void * packed);
+    virtual bool Decompress(const void * packed, unsigned packedSize, void * raw, unsigned rawSize) const;
+
+private:
+    byte      * m_data;
+    unsigned    m_size;
+
+    // Compression works on a copy of the raw data placed just after the 
+    //  dictionary, starting from a hash table of the dictionary's positions.
+    //  Readers never compress, so they're made on the first Compress.
+    uint32    * m_primed;
+    uint32    * m_table;
+    byte      * m_scratch;
+    unsigned    m_scratchSize;
+};
+
+//////////////////////////////////////////////////////
+//
+// Internal Functions
+//
+
+//====================================================
+static uint32 Read32(const byte * data) {
+    uint32 value;
+    memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+//====================================================
+// Hashes s_hashLength bytes
+static unsigned Hash(const byte * data, unsigned bits) {
+    uint64 value;
+    memcpy(&value, data, sizeof(value));
+    return static_cast<unsigned>((value * 0x9e3779b97f4a7c15ULL) >> (64 - bits));
+}
+
+//====================================================
+static unsigned MatchLength(const byte * ip, const byte * match, const byte * limit) {
+    const byte * start = ip;
+    while (ip + sizeof(uint32) <= limit && Read32(ip) == Read32(match)) {
+        ip      += sizeof(uint32);
+        match   += sizeof(uint32);
+    }
+    while (ip < limit && *ip == *match) {
+        ip++;
+        match++;
+    }
+    return static_cast<unsigned>(ip - start);
+}
+
+//====================================================
+// The part of a length past its token's nibble
+static byte * WriteLength(byte * op, unsigned length) {
+    for (length -= s_runMask; length >= 255; length -= 255) 
+        *op++ = 255;
+    *op++ = static_cast<byte>(length);
+    return op;
+}
+
+//====================================================
+// An offset of zero writes the last literals alone. NULL when the sequence
+//  doesn't fit before end.
+static byte * WriteSequence(
+    byte          * op, 
+    const byte    * end, 
+    const byte    * literals, 
+    unsigned        numLiterals, 
+    unsigned        offset, 
+    unsigned        matchLength
+) {
+    unsigned needed = 1 + numLiterals / 255 + 1 + numLiterals;
+    if (offset != 0) 
+        needed += 2 + matchLength / 255 + 1;
+    if (needed > static_cast<unsigned>(end - op)) 
+        return NULL;
+
+    byte * token = op++;
+    *token = static_cast<byte>((numLiterals < s_runMask ? numLiterals : s_runMask) << 4);
+    if (numLiterals >= s_runMask) 
+        op = WriteLength(op, numLiterals);
+    memcpy(op, literals, numLiterals);
+    op += numLiterals;
+
+    if (offset == 0) 
+        return op;
+
+    *op++ = static_cast<byte>(offset);
+    *op++ = static_cast<byte>(offset >> 8);
+
+    matchLength -= s_minMatch;
+    *token |= static_cast<byte>(matchLength < s_runMask ? matchLength : s_runMask);
+    if (matchLength >= s_runMask) 
+        op = WriteLength(op, matchLength);
+    return op;
+}
+
+//====================================================
+// Number of samples each string of s_hashLength bytes turns up in, less one,
+//  since a string only one sample holds is no use to the others
+static uint32 * CountStrings(const byte * samples, const unsigned * sampleSizes, unsigned numSamples) {
+    const unsigned numSlots = 1 << s_frequencyBits;
+    uint32 * frequencies = new(LZ4_DICT_MEM_FLAGS) uint32[numSlots];
+    uint32 * lastSample  = new(LZ4_DICT_MEM_FLAGS) uint32[numSlots];
+    memset(frequencies, 0, numSlots * sizeof(uint32));
+    memset(lastSample, 0xff, numSlots * sizeof(uint32));
+
+    const byte * sample = samples;
+    for (unsigned i = 0; i < numSamples; i++) {
+        for (unsigned pos = 0; pos + s_hashLength <= sampleSizes[i]; pos++) {
+            unsigned slot = Hash(sample + pos, s_frequencyBits);
+            if (lastSample[slot] != i) {
+                lastSample[slot] = i;
+                frequencies[slot]++;
+            }
+        }
+        sample += sampleSizes[i];
+    }
+
+    for (unsigned slot = 0; slot < numSlots; slot++) {
+        if (frequencies[slot] > 0) 
+            frequencies[slot]--;
+    }
+
+    delete [] lastSample;
+    return frequencies;
+}
+
+//====================================================
+// The best scoring window between start and end, sliding the score along
+//  one string at a time
+static const byte * FindSegment(const byte * start, const byte * end, const uint32 * frequencies, uint64 * bestScore) {
+    const unsigned numStrings = s_segmentSize - s_hashLength + 1;
+
+    uint64 score = 0;
+    for (unsigned i = 0; i < numStrings; i++) 
+        score += frequencies[Hash(start + i, s_frequencyBits)];
+
+    const byte * best = start;
+    *bestScore = score;
+    for (const byte * pos = start + 1; pos + s_segmentSize <= end; pos++) {
+        score -= frequencies[Hash(pos - 1, s_frequencyBits)];
+        score += frequencies[Hash(pos + numStrings - 1, s_frequencyBits)];
+        if (score > *bestScore) {
+            *bestScore  = score;
+            best        = pos;
+        }
+    }
+
+    return best;
+}
+
+//====================================================
+// The corpus is split in an epoch for each segment the dictionary holds and 
+//  the best segment of each is kept, so every part of the corpus gets a 
+//  say. Strings already kept score nothing after, and passes repeat until 
+//  the dictionary fills or no epoch has anything left to add.
+static ILZ4DictionaryPtr Train(const byte * samples, const unsigned * sampleSizes, unsigned numSamples, unsigned maxSize) {
+    if (maxSize > STREAM_LZ4_DICT_MAX_SIZE) 
+        maxSize = STREAM_LZ4_DICT_MAX_SIZE;
+
+    uint64 total = 0;
+    for (unsigned i = 0; i < numSamples; i++) 
+        total += sampleSizes[i];
+
+    // Small corpora fit whole
+    if (total == 0) 
+        return ILZ4DictionaryPtr(NULL);
+    if (total <= maxSize) 
+        return StreamCreateLZ4Dictionary(samples, static_cast<unsigned>(total));
+    if (maxSize < s_segmentSize) 
+        return ILZ4DictionaryPtr(NULL);
+
+    uint32 * frequencies = CountStrings(samples, sampleSizes, numSamples);
+    byte * dictionary = new(LZ4_DICT_MEM_FLAGS) byte[maxSize];
+
+    // Filled from the back
+    unsigned numEpochs  = maxSize / s_segmentSize;
+    uint64 epochSize    = total / numEpochs;
+    unsigned start      = maxSize;
+    unsigned numMisses  = 0;
+    for (unsigned epoch = 0; start >= s_segmentSize && numMisses < numEpochs; epoch = (epoch + 1) % numEpochs) {
+        const byte * epochStart = samples + static_cast<size_t>(epoch * epochSize);
+        uint64 score = 0;
+        const byte * segment = FindSegment(epochStart, epochStart + epochSize, frequencies, &score);
+        if (score == 0) {
+            numMisses++;
+            continue;
+        }
+
+        numMisses = 0;
+        start -= s_segmentSize;
+        memcpy(dictionary + start, segment, s_segmentSize);
+        for (unsigned i = 0; i + s_hashLength <= s_segmentSize; i++) 
+            frequencies[Hash(segment + i, s_frequencyBits)] = 0;
+    }
+
+    ILZ4DictionaryPtr result(NULL);
+    if (start < maxSize) 
+        result = StreamCreateLZ4Dictionary(dictionary + start, maxSize - start);
+
+    delete [] dictionary;
+    delete [] frequencies;
+    return result;
+}
+
+//////////////////////////////////////////////////////
+//
+// LZ4Dictionary
+//
+
+//====================================================
+LZ4Dictionary::LZ4Dictionary() :
+    m_data(NULL),
+    m_size(0),
+    m_primed(NULL),
+    m_table(NULL),
+    m_scratch(NULL),
+    m_scratchSize(0)
+{
+}
+
+//====================================================
+LZ4Dictionary::~LZ4Dictionary() {
+    delete [] m_data;
+    delete [] m_primed;
+    delete [] m_table;
+    delete [] m_scratch;
+}
+
+//====================================================
+bool LZ4Dictionary::Open(const void * data, unsigned size) {
+    if (size > STREAM_LZ4_DICT_MAX_SIZE) 
+        return false;
+
+    m_data = new(LZ4_DICT_MEM_FLAGS) byte[size > 0 ? size : 1];
+    m_size = size;
+    if (size > 0) 
+        memcpy(m_data, data, size);
+    return true;
+}
+
+//====================================================
+const byte * LZ4Dictionary::GetData() const {
+    return m_data;
+}
+
+//====================================================
+unsigned LZ4Dictionary::GetSize() const {
+    return m_size;
+}
+
+//====================================================
+unsigned LZ4Dictionary::Compress(const void * raw, unsigned rawSize, void * packed) {
+    // Too short for a match to leave it any smaller
+    if (rawSize <= s_matchStartLimit) 
+        return 0;
+
+    const unsigned tableSize = 1 << s_hashBits;
+    if (m_primed == NULL) {
+        m_primed = new(LZ4_DICT_MEM_FLAGS) uint32[tableSize];
+        m_table  = new(LZ4_DICT_MEM_FLAGS) uint32[tableSize];
+        memset(m_primed, 0, tableSize * sizeof(uint32));
+        for (unsigned pos = 0; pos + s_hashLength <= m_size; pos++) 
+            m_primed[Hash(m_data + pos, s_hashBits)] = pos;
+    }
+
+    if (m_scratchSize < m_size + rawSize) {
+        delete [] m_scratch;
+        m_scratchSize   = m_size + rawSize;
+        m_scratch       = new(LZ4_DICT_MEM_FLAGS) byte[m_scratchSize];
+        memcpy(m_scratch, m_data, m_size);
+    }
+
+    memcpy(m_scratch + m_size, raw, rawSize);
+    memcpy(m_table, m_primed, tableSize * sizeof(uint32));
+
+    const byte * base       = m_scratch;
+    const byte * ip         = base + m_size;
+    const byte * anchor     = ip;
+    const byte * end        = ip + rawSize;
+    const byte * startLimit = end - s_matchStartLimit;
+    const byte * matchLimit = end - s_lastLiterals;
+    byte * op               = static_cast<byte *>(packed);
+    byte * opEnd            = op + rawSize - 1;
+
+    unsigned lastOffset = 0;
+    while (ip < startLimit) {
+        uint32 sequence     = Read32(ip);
+        uint32 * slot       = &m_table[Hash(ip, s_hashBits)];
+        const byte * match  = base + *slot;
+        *slot = static_cast<uint32>(ip - base);
+
+        // Objects that share a layout keep matching at the last offset once 
+        //  past the bytes that differ, whatever the hash table holds
+        bool found = match < ip && ip - match <= s_maxOffset && Read32(match) == sequence;
+        if (lastOffset != 0 && static_cast<unsigned>(ip - base) >= lastOffset && Read32(ip - lastOffset) == sequence) {
+            const byte * repeat = ip - lastOffset;
+            if (!found || MatchLength(ip, repeat, matchLimit) >= MatchLength(ip, match, matchLimit)) 
+                match = repeat;
+            found = true;
+        }
+        if (!found) {
+            ip += 1 + ((ip - anchor) >> s_skipShift);
+            continue;
+        }
+
+        while (ip > anchor && match > base && ip[-1] == match[-1]) {
+            ip--;
+            match--;
+        }
+
+        const byte * matchEnd = ip + MatchLength(ip, match, matchLimit);
+        lastOffset = static_cast<unsigned>(ip - match);
+
+        op = WriteSequence(
+            op, 
+            opEnd, 
+            anchor, 
+            static_cast<unsigned>(ip - anchor), 
+            static_cast<unsigned>(ip - match), 
+            static_cast<unsigned>(matchEnd - ip)
+        );
+        if (op == NULL) 
+            return 0;
+
+        // Catches a match starting just inside this one
+        ip      = matchEnd;
+        anchor  = ip;
+        if (ip < startLimit) 
+            m_table[Hash(ip - 2, s_hashBits)] = static_cast<uint32>(ip - 2 - base);
+    }
+
+    op = WriteSequence(op, opEnd, anchor, static_cast<unsigned>(end - anchor), 0, 0);
+    if (op == NULL) 
+        return 0;
+    return static_cast<unsigned>(op - static_cast<byte *>(packed));
+}
+
+//====================================================
+bool LZ4Dictionary::Decompress(const void * packed, unsigned packedSize, void * raw, unsigned rawSize) const {
+    return StreamDecodeLZ4(packed, packedSize, raw, rawSize, m_data, m_size);
+}
+
+} // namespace NSLZ4Dictionary
+
+//////////////////////////////////////////////////////
+//
+// External functions
+//
+
+//====================================================
+ILZ4DictionaryPtr StreamCreateLZ4Dictionary(const void * data, unsigned size) {
+    NSLZ4Dictionary::LZ4Dictionary * dictionary = new(LZ4_DICT_MEM_FLAGS) NSLZ4Dictionary::LZ4Dictionary();
+    if (!dictionary->Open(data, size)) {
+        delete dictionary;
+        dictionary = NULL;
+    }
+
+    return ILZ4DictionaryPtr(dictionary);
+}
+
+//====================================================
+ILZ4DictionaryPtr StreamTrainLZ4Dictionary(const void * samples, const unsigned * sampleSizes, unsigned numSamples) {
+    return StreamTrainLZ4Dictionary(samples, sampleSizes, numSamples, STREAM_LZ4_DICT_SIZE);
+}
+
+//====================================================
+ILZ4DictionaryPtr StreamTrainLZ4Dictionary(const void * samples, const unsigned * sampleSizes, unsigned numSamples, unsigned maxSize) {
+    return NSLZ4Dictionary::Train(static_cast<const byte *>(samples), sampleSizes, numSamples, maxSize);
+}
@@ -0,0 +1,732 @@
+/*
+   GameRiff - Framework for creating various video game services
+   LZ4 block compressed streams
+   Copyright (C) 2011, Shaun Leach.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are
+   met:
+  
+       * Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+       * Redistributions in binary form must reproduce the above
+   copyright notice, this list of conditions and the following disclaimer
+   in the documentation and/or other materials provided with the
+   distribution.
+  
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include "Pch.h"
+
+namespace NSLZ4Stream {
+
+//////////////////////////////////////////////////////
+//
+// Constants
+//
+
+#define LZ4_MEM_FLAGS (MemFlags(MEM_ARENA_DEFAULT, MEM_CAT_FILEIO))
+
+static const uint32     s_lz4Magic          = 0x42345a4c; // 'LZ4B'
+static const uint32     s_lz4Version        = 1;
+static const unsigned   s_maxBlockSize      = 16 * 1024 * 1024;
+static const unsigned   s_defaultAhead      = 2;
+
+// The coder copies in words, so it reads and writes a few bytes past the
+//  end of its buffers
+static const unsigned   s_padding           = 8;
+
+// Each sequence of a block is a token with the literal count in its high 
+//  nibble and the match length less s_minMatch in its low one, the rest of
+//  the count, the literals, a little endian offset and the rest of the 
+//  length. A full nibble carries on in bytes of 255 until a smaller one. 
+//  The last sequence is literals alone.
+static const unsigned   s_minMatch          = 4;
+static const unsigned   s_runMask           = 15;
+static const unsigned   s_maxLength         = 0x7fffffff;
+
+//////////////////////////////////////////////////////
+//
+// Internal Types
+//
+
+enum EBlockState {
+    BLOCK_EMPTY,
+    BLOCK_PENDING,      // Waiting for a thread to compress it
+    BLOCK_READY,        // Compressed when writing, decompressed when reading
+    BLOCK_END,
+    BLOCK_BADDATA
+};
+
+// On disk each block starts with its raw and packed sizes. Blocks that 
+//  didn't compress are stored with both sizes equal, and a raw size of zero
+//  ends the stream.
+struct BlockHeader {
+    uint32  rawSize;
+    uint32  packedSize;
+};
+
+struct Block {
+    byte          * raw;
+    byte          * packed;
+    unsigned        rawSize;
+    unsigned        packedSize;
+    volatile int32  state;
+};
+
+class RawLZ4ReadStream : public IRawStream {
+public:
+    RawLZ4ReadStream(IRawStreamPtr source, unsigned numAhead);
+    ~RawLZ4ReadStream();
+
+    bool Open();
+
+    virtual EStreamError ReadBytes(void * bytes, unsigned count, unsigned * bytesRead);
+    virtual EStreamError WriteBytes(const void * bytes, unsigned count, unsigned * bytesWritten);
+
+    virtual unsigned LendReadBlock(const byte ** block);
+    virtual void ReturnBlock(unsigned unused);
+
+private:
+    static void DecodeThread(void * param);
+
+    void DecodeBlock(Block * block);
+    bool NextBlock();
+
+private:
+    IRawStreamPtr   m_source;
+    IThreadPtr      m_thread;
+    ISemaphorePtr   m_free;         // Blocks the thread can decode into
+    ISemaphorePtr   m_full;         // Blocks decoded ahead of the reader
+    Block         * m_blocks;
+    unsigned        m_numAhead;
+    unsigned        m_numBlocks;
+    unsigned        m_blockSize;
+    byte          * m_packed;       // Only touched by whoever decodes
+    unsigned        m_current;
+    unsigned        m_size;         // Zero until the first block is taken
+    unsigned        m_pos;
+    EStreamError    m_result;       // Set once the last block is taken
+    volatile int32  m_stop;
+};
+
+class RawLZ4WriteStream : public IRawStream {
+public:
+    RawLZ4WriteStream(IRawStreamPtr target, unsigned blockSize, unsigned numThreads);
+    ~RawLZ4WriteStream();
+
+    bool Open();
+
+    virtual EStreamError ReadBytes(void * bytes, unsigned count, unsigned * bytesRead);
+    virtual EStreamError WriteBytes(const void * bytes, unsigned count, unsigned * bytesWritten);
+
+    virtual unsigned LendWriteBlock(byte ** block);
+    virtual void ReturnBlock(unsigned unused);
+    virtual EStreamError Flush();
+
+private:
+    static void CompressThread(void * param);
+
+    void SubmitBlock();
+    void WriteNextBlock();
+
+private:
+    IRawStreamPtr   m_target;
+    IThreadPtr    * m_threads;
+    unsigned        m_numThreads;
+    ISemaphorePtr   m_jobs;
+    ISemaphorePtr   m_done;
+    Block         * m_blocks;
+    unsigned        m_numBlocks;
+    unsigned        m_blockSize;
+    unsigned        m_pos;          // Bytes in the block being filled
+    unsigned        m_numSubmitted;
+    unsigned        m_numWritten;
+    void          * m_context;      // Match tables when compressing inline
+    EStreamError    m_writeError;   // Held until the next flush
+    volatile int32  m_nextJob;
+    volatile int32  m_stop;
+};
+
+//////////////////////////////////////////////////////
+//
+// Internal Functions
+//
+
+//====================================================
+static unsigned PackedBound(unsigned size) {
+    // Incompressible data grows by a run length byte every 255 bytes
+    return size + size / 255 + 16;
+}
+
+//====================================================
+static void AllocBlocks(Block * blocks, unsigned numBlocks, unsigned blockSize, bool packed) {
+    for (unsigned i = 0; i < numBlocks; i++) {
+        blocks[i].raw           = new(LZ4_MEM_FLAGS) byte[blockSize + s_padding];
+        blocks[i].packed        = packed ? new(LZ4_MEM_FLAGS) byte[PackedBound(blockSize) + s_padding] : NULL;
+        blocks[i].rawSize       = 0;
+        blocks[i].packedSize    = 0;
+        blocks[i].state         = BLOCK_EMPTY;
+    }
+}
+
+//====================================================
+static void FreeBlocks(Block * blocks, unsigned numBlocks) {
+    for (unsigned i = 0; i < numBlocks; i++) {
+        delete [] blocks[i].raw;
+        delete [] blocks[i].packed;
+    }
+    delete [] blocks;
+}
+
+//====================================================
+static bool ReadLength(const byte ** ip, const byte * end, unsigned * length) {
+    unsigned extra = 255;
+    while (extra == 255) {
+        if (*ip == end || *length > s_maxLength) 
+            return false;
+        extra    = *(*ip)++;
+        *length += extra;
+    }
+    return true;
+}
+
+//====================================================
+// Stored data isn't trusted, so unlike Ext/lz4's decoder every length and
+//  offset is checked against both buffers
+static bool DecodeLZ4(
+    const byte    * packed, 
+    unsigned        packedSize, 
+    byte          * raw, 
+    unsigned        rawSize,
+    const byte    * dict,
+    unsigned        dictSize
+) {
+    const byte * ip     = packed;
+    const byte * ipEnd  = ip + packedSize;
+    byte * op           = raw;
+    byte * opEnd        = op + rawSize;
+
+    for (;;) {
+        if (ip == ipEnd) 
+            return false;
+        unsigned token = *ip++;
+
+        unsigned numLiterals = token >> 4;
+        if (numLiterals == s_runMask && !ReadLength(&ip, ipEnd, &numLiterals)) 
+            return false;
+        if (numLiterals > static_cast<unsigned>(ipEnd - ip) || numLiterals > static_cast<unsigned>(opEnd - op)) 
+            return false;
+        memcpy(op, ip, numLiterals);
+        ip += numLiterals;
+        op += numLiterals;
+
+        // Only the last sequence has no match
+        if (ip == ipEnd) 
+            return op == opEnd;
+        if (ipEnd - ip < 2) 
+            return false;
+
+        unsigned offset = ip[0] | (ip[1] << 8);
+        ip += 2;
+
+        unsigned matchLength = token & s_runMask;
+        if (matchLength == s_runMask && !ReadLength(&ip, ipEnd, &matchLength)) 
+            return false;
+        matchLength += s_minMatch;
+
+        unsigned written = static_cast<unsigned>(op - raw);
+        if (offset == 0 || offset > written + dictSize || matchLength > static_cast<unsigned>(opEnd - op)) 
+            return false;
+
+        // Matches that start in the dictionary can run on into the output
+        const byte * match = NULL;
+        if (offset > written) {
+            unsigned back  = offset - written;
+            unsigned count = back < matchLength ? back : matchLength;
+            memcpy(op, dict + dictSize - back, count);
+            op          += count;
+            matchLength -= count;
+            match        = raw;
+        }
+        else {
+            match = op - offset;
+        }
+
+        // Overlapping matches repeat what they've just written
+        if (static_cast<unsigned>(op - match) >= matchLength) {
+            memcpy(op, match, matchLength);
+            op += matchLength;
+        }
+        else {
+            while (matchLength-- > 0) 
+                *op++ = *match++;
+        }
+    }
+}
+
+//====================================================
+static void CompressBlock(Block * block, void ** context) {
+    int packed = LZ4_compressCtx(
+        context, 
+        reinterpret_cast<char *>(block->raw), 
+        reinterpret_cast<char *>(block->packed), 
+        block->rawSize
+    );
+
+    // Stored blocks are copied straight through when reading
+    if (packed <= 0 || static_cast<unsigned>(packed) >= block->rawSize) {
+        memcpy(block->packed, block->raw, block->rawSize);
+        packed = block->rawSize;
+    }
+    block->packedSize = packed;
+}
+
+//////////////////////////////////////////////////////
+//
+// RawLZ4ReadStream
+//
+
+//====================================================
+RawLZ4ReadStream::RawLZ4ReadStream(IRawStreamPtr source, unsigned numAhead) :
+    m_source(source),
+    m_blocks(NULL),
+    m_numAhead(numAhead),
+    m_numBlocks(numAhead + 1),
+    m_blockSize(0),
+    m_packed(NULL),
+    m_current(0),
+    m_size(0),
+    m_pos(0),
+    m_result(STREAM_ERROR_OK),
+    m_stop(0)
+{
+}
+
+//====================================================
+RawLZ4ReadStream::~RawLZ4ReadStream() {
+    if (m_thread != NULL) {
+        AtomicExchange(&m_stop, 1);
+        m_free->Signal(m_numBlocks);
+        m_thread->Join();
+    }
+
+    if (m_blocks != NULL) 
+        FreeBlocks(m_blocks, m_numBlocks);
+    delete [] m_packed;
+}
+
+//====================================================
+bool RawLZ4ReadStream::Open() {
+    uint32 header[3];
+    if (m_source->ReadBytes(header, sizeof(header), NULL) != STREAM_ERROR_OK) 
+        return false;
+    if (header[0] != s_lz4Magic || header[1] != s_lz4Version || header[2] == 0 || header[2] > s_maxBlockSize) 
+        return false;
+
+    m_blockSize = header[2];
+    m_packed    = new(LZ4_MEM_FLAGS) byte[PackedBound(m_blockSize) + s_padding];
+    m_blocks    = new(LZ4_MEM_FLAGS) Block[m_numBlocks];
+    AllocBlocks(m_blocks, m_numBlocks, m_blockSize, false);
+
+    if (m_numAhead == 0) 
+        return true;
+
+    m_free      = SemaphoreCreate(m_numBlocks);
+    m_full      = SemaphoreCreate(0);
+    m_thread    = ThreadCreate(DecodeThread, this);
+    return m_free != NULL && m_full != NULL && m_thread != NULL;
+}
+
+//====================================================
+void RawLZ4ReadStream::DecodeThread(void * param) {
+    RawLZ4ReadStream * stream = reinterpret_cast<RawLZ4ReadStream *>(param);
+    for (unsigned index = 0; ; index = (index + 1) % stream->m_numBlocks) {
+        stream->m_free->Wait();
+        if (stream->m_stop) 
+            break;
+
+        Block * block = &stream->m_blocks[index];
+        stream->DecodeBlock(block);
+        stream->m_full->Signal(1);
+        if (block->state != BLOCK_READY) 
+            break;
+    }
+}
+
+//====================================================
+void RawLZ4ReadStream::DecodeBlock(Block * block) {
+    BlockHeader header;
+    unsigned read = 0;
+    EStreamError result = m_source->ReadBytes(&header, sizeof(header), &read);
+
+    // Streams cut short after a whole block end there as well
+    if ((result == STREAM_ERROR_EOF && read == 0) || (result == STREAM_ERROR_OK && header.rawSize == 0)) {
+        block->rawSize  = 0;
+        block->state    = BLOCK_END;
+        return;
+    }
+
+    // Sizes are checked here, lengths and offsets as the block decodes
+    block->rawSize  = 0;
+    block->state    = BLOCK_BADDATA;
+    if (result != STREAM_ERROR_OK || header.rawSize > m_blockSize || header.packedSize > header.rawSize) 
+        return;
+
+    if (header.packedSize == header.rawSize) {
+        if (m_source->ReadBytes(block->raw, header.rawSize, NULL) != STREAM_ERROR_OK) 
+            return;
+    }
+    else {
+        if (m_source->ReadBytes(m_packed, header.packedSize, NULL) != STREAM_ERROR_OK) 
+            return;
+
+        if (!DecodeLZ4(m_packed, header.packedSize, block->raw, header.rawSize, NULL, 0)) 
+            return;
+    }
+
+    block->rawSize  = header.rawSize;
+    block->state    = BLOCK_READY;
+}
+
+//====================================================
+bool RawLZ4ReadStream::NextBlock() {
+    if (m_result != STREAM_ERROR_OK) 
+        return false;
+
+    if (m_numAhead == 0) {
+        DecodeBlock(&m_blocks[0]);
+    }
+    else {
+        // The block just read goes back to the thread
+        if (m_size > 0) {
+            m_free->Signal(1);
+            m_current = (m_current + 1) % m_numBlocks;
+        }
+        m_full->Wait();
+    }
+
+    const Block & block = m_blocks[m_current];
+    m_pos   = 0;
+    m_size  = block.rawSize;
+    if (block.state == BLOCK_READY) 
+        return true;
+
+    m_result = block.state == BLOCK_END ? STREAM_ERROR_EOF : STREAM_ERROR_BADDATA;
+    return false;
+}
+
+//====================================================
+EStreamError RawLZ4ReadStream::ReadBytes(void * bytes, unsigned count, unsigned * bytesRead) {
+    byte * dest = reinterpret_cast<byte *>(bytes);
+    unsigned total = 0;
+    EStreamError result = STREAM_ERROR_OK;
+    while (total < count) {
+        if (m_pos == m_size && !NextBlock()) {
+            result = m_result;
+            break;
+        }
+
+        unsigned available  = m_size - m_pos;
+        unsigned chunk      = count - total < available ? count - total : available;
+        memcpy(dest + total, m_blocks[m_current].raw + m_pos, chunk);
+        m_pos += chunk;
+        total += chunk;
+    }
+
+    if (bytesRead != NULL) 
+        *bytesRead = total;
+    return result;
+}
+
+//====================================================
+EStreamError RawLZ4ReadStream::WriteBytes(const void * bytes, unsigned count, unsigned * bytesWritten) {
+    ASSERTMSGGR(false, "LZ4 read streams can't be written");
+    if (bytesWritten != NULL) 
+        *bytesWritten = 0;
+    return STREAM_ERROR_FILENOTOPENED;
+}
+
+//====================================================
+unsigned RawLZ4ReadStream::LendReadBlock(const byte ** block) {
+    if (m_pos == m_size && !NextBlock()) 
+        return 0;
+
+    *block          = m_blocks[m_current].raw + m_pos;
+    unsigned size   = m_size - m_pos;
+    m_pos           = m_size;
+    return size;
+}
+
+//====================================================
+void RawLZ4ReadStream::ReturnBlock(unsigned unused) {
+    ASSERTGR(unused <= m_pos);
+    m_pos -= unused;
+}
+
+//////////////////////////////////////////////////////
+//
+// RawLZ4WriteStream
+//
+
+//====================================================
+RawLZ4WriteStream::RawLZ4WriteStream(IRawStreamPtr target, unsigned blockSize, unsigned numThreads) :
+    m_target(target),
+    m_threads(NULL),
+    m_numThreads(numThreads),
+    m_blocks(NULL),
+    m_numBlocks(numThreads > 0 ? 2 * numThreads + 1 : 1),
+    m_blockSize(blockSize),
+    m_pos(0),
+    m_numSubmitted(0),
+    m_numWritten(0),
+    m_context(NULL),
+    m_writeError(STREAM_ERROR_OK),
+    m_nextJob(0),
+    m_stop(0)
+{
+}
+
+//====================================================
+RawLZ4WriteStream::~RawLZ4WriteStream() {
+    if (m_blocks != NULL) {
+        Flush();
+        BlockHeader end = { 0, 0 };
+        m_target->WriteBytes(&end, sizeof(end), NULL);
+        m_target->Flush();
+    }
+
+    if (m_threads != NULL) {
+        AtomicExchange(&m_stop, 1);
+        m_jobs->Signal(m_numThreads);
+        for (unsigned i = 0; i < m_numThreads; i++) {
+            if (m_threads[i] != NULL) 
+                m_threads[i]->Join();
+        }
+        delete [] m_threads;
+    }
+
+    if (m_blocks != NULL) 
+        FreeBlocks(m_blocks, m_numBlocks);
+    free(m_context);
+}
+
+//====================================================
+bool RawLZ4WriteStream::Open() {
+    if (m_blockSize == 0 || m_blockSize > s_maxBlockSize) 
+        return false;
+
+    uint32 header[3] = { s_lz4Magic, s_lz4Version, m_blockSize };
+    if (m_target->WriteBytes(header, sizeof(header), NULL) != STREAM_ERROR_OK) 
+        return false;
+
+    m_blocks = new(LZ4_MEM_FLAGS) Block[m_numBlocks];
+    AllocBlocks(m_blocks, m_numBlocks, m_blockSize, true);
+
+    if (m_numThreads == 0) 
+        return true;
+
+    m_jobs      = SemaphoreCreate(0);
+    m_done      = SemaphoreCreate(0);
+    m_threads   = new(LZ4_MEM_FLAGS) IThreadPtr[m_numThreads];
+    bool result = m_jobs != NULL && m_done != NULL;
+    for (unsigned i = 0; i < m_numThreads && result; i++) {
+        m_threads[i] = ThreadCreate(CompressThread, this);
+        result = m_threads[i] != NULL;
+    }
+    return result;
+}
+
+//====================================================
+void RawLZ4WriteStream::CompressThread(void * param) {
+    RawLZ4WriteStream * stream = reinterpret_cast<RawLZ4WriteStream *>(param);
+    void * context = NULL;
+    for (;;) {
+        stream->m_jobs->Wait();
+        if (stream->m_stop) 
+            break;
+
+        // Jobs are signaled in the order blocks are submitted
+        unsigned job = AtomicIncrement(&stream->m_nextJob) - 1;
+        Block * block = &stream->m_blocks[job % stream->m_numBlocks];
+        CompressBlock(block, &context);
+        AtomicExchange(&block->state, BLOCK_READY);
+        stream->m_done->Signal(1);
+    }
+    free(context);
+}
+
+//====================================================
+void RawLZ4WriteStream::SubmitBlock() {
+    Block * block = &m_blocks[m_numSubmitted % m_numBlocks];
+    block->rawSize = m_pos;
+    if (m_numThreads == 0) {
+        CompressBlock(block, &m_context);
+        block->state = BLOCK_READY;
+    }
+    else {
+        block->state = BLOCK_PENDING;
+        m_jobs->Signal(1);
+    }
+
+    m_pos = 0;
+    m_numSubmitted++;
+
+    // The next block to fill has to be written out first
+    if (m_numSubmitted - m_numWritten == m_numBlocks) 
+        WriteNextBlock();
+}
+
+//====================================================
+void RawLZ4WriteStream::WriteNextBlock() {
+    // Completions can arrive out of order, waits for other blocks are 
+    //  simply used up early
+    Block * block = &m_blocks[m_numWritten % m_numBlocks];
+    while (block->state != BLOCK_READY) 
+        m_done->Wait();
+
+    BlockHeader header = { block->rawSize, block->packedSize };
+    EStreamError result = m_target->WriteBytes(&header, sizeof(header), NULL);
+    if (result == STREAM_ERROR_OK) 
+        result = m_target->WriteBytes(block->packed, block->packedSize, NULL);
+    if (result != STREAM_ERROR_OK && m_writeError == STREAM_ERROR_OK) 
+        m_writeError = result;
+
+    block->state = BLOCK_EMPTY;
+    m_numWritten++;
+}
+
+//====================================================
+EStreamError RawLZ4WriteStream::ReadBytes(void * bytes, unsigned count, unsigned * bytesRead) {
+    ASSERTMSGGR(false, "LZ4 write streams can't be read");
+    if (bytesRead != NULL) 
+        *bytesRead = 0;
+    return STREAM_ERROR_FILENOTOPENED;
+}
+
+//====================================================
+EStreamError RawLZ4WriteStream::WriteBytes(const void * bytes, unsigned count, unsigned * bytesWritten) {
+    const byte * src = reinterpret_cast<const byte *>(bytes);
+    unsigned total = 0;
+    while (total < count) {
+        if (m_pos == m_blockSize) 
+            SubmitBlock();
+
+        unsigned available  = m_blockSize - m_pos;
+        unsigned chunk      = count - total < available ? count - total : available;
+        memcpy(m_blocks[m_numSubmitted % m_numBlocks].raw + m_pos, src + total, chunk);
+        m_pos += chunk;
+        total += chunk;
+    }
+
+    EStreamError result = m_writeError;
+    if (bytesWritten != NULL) 
+        *bytesWritten = result == STREAM_ERROR_OK ? count : 0;
+    return result;
+}
+
+//====================================================
+unsigned RawLZ4WriteStream::LendWriteBlock(byte ** block) {
+    if (m_pos == m_blockSize) 
+        SubmitBlock();
+
+    *block          = m_blocks[m_numSubmitted % m_numBlocks].raw + m_pos;
+    unsigned size   = m_blockSize - m_pos;
+    m_pos           = m_blockSize;
+    return size;
+}
+
+//====================================================
+void RawLZ4WriteStream::ReturnBlock(unsigned unused) {
+    ASSERTGR(unused <= m_pos);
+    m_pos -= unused;
+}
+
+//====================================================
+EStreamError RawLZ4WriteStream::Flush() {
+    if (m_pos > 0) 
+        SubmitBlock();
+    while (m_numWritten < m_numSubmitted) 
+        WriteNextBlock();
+
+    EStreamError result = m_target->Flush();
+    if (m_writeError != STREAM_ERROR_OK) 
+        result = m_writeError;
+    m_writeError = STREAM_ERROR_OK;
+    return result;
+}
+
+} // namespace NSLZ4Stream
+
+//////////////////////////////////////////////////////
+//
+// External functions
+//
+
+//====================================================
+IRawStreamPtr StreamOpenLZ4(IRawStreamPtr source) {
+    return StreamOpenLZ4(source, NSLZ4Stream::s_defaultAhead);
+}
+
+//====================================================
+IRawStreamPtr StreamOpenLZ4(IRawStreamPtr source, unsigned numAhead) {
+    if (source == NULL) 
+        return IRawStreamPtr(NULL);
+
+    NSLZ4Stream::RawLZ4ReadStream * stream = new(LZ4_MEM_FLAGS) NSLZ4Stream::RawLZ4ReadStream(source, numAhead);
+    if (!stream->Open()) {
+        delete stream;
+        stream = NULL;
+    }
+
+    return IRawStreamPtr(stream);
+}
+
+//====================================================
+IRawStreamPtr StreamCreateLZ4(IRawStreamPtr target) {
+    unsigned numCores = ThreadNumCores();
+    return StreamCreateLZ4(target, STREAM_LZ4_BLOCK_SIZE, numCores > 1 ? numCores - 1 : 0);
+}
+
+//====================================================
+IRawStreamPtr StreamCreateLZ4(IRawStreamPtr target, unsigned blockSize, unsigned numThreads) {
+    if (target == NULL) 
+        return IRawStreamPtr(NULL);
+
+    NSLZ4Stream::RawLZ4WriteStream * stream = new(LZ4_MEM_FLAGS) NSLZ4Stream::RawLZ4WriteStream(target, blockSize, numThreads);
+    if (!stream->Open()) {
+        delete stream;
+        stream = NULL;
+    }
+
+    return IRawStreamPtr(stream);
+}
+
+//====================================================
+bool StreamDecodeLZ4(const void * packed, unsigned packedSize, void * raw, unsigned rawSize) {
+    return StreamDecodeLZ4(packed, packedSize, raw, rawSize, NULL, 0);
+}
+
+//====================================================
+bool StreamDecodeLZ4(const void * packed, unsigned packedSize, void * raw, unsigned rawSize, const void * dict, unsigned dictSize) {
+    return NSLZ4Stream::DecodeLZ4(
+        static_cast<const byte *>(packed), 
+        packedSize, 
+        static_cast<byte *>(raw), 
+        rawSize, 
+        static_cast<const byte *>(dict), 
+        dictSize
+    );
+}
@@ -0,0 +1,976 @@
+/*
+   GameRiff - Framework for creating various video game services
+   Hash indexed pack files and the virtual file layer over them
+   Copyright (C) 2011, Shaun Leach.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are
+   met:
+  
+       * Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+       * Redistributions in binary form must reproduce the above
+   copyright notice, this list of conditions and the following disclaimer
+   in the documentation and/or other materials provided with the
+   distribution.
+  
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include "Pch.h"
+
+namespace NSPackFile {
+
+//////////////////////////////////////////////////////
+//
+// Constants
+//
+
+#define PACK_MEM_FLAGS (MemFlags(MEM_ARENA_DEFAULT, MEM_CAT_FILEIO))
+
+static const uint32     s_packMagic         = 0x4B505247;   // "GRPK"
+static const uint32     s_packVersion       = 3;            // Entry flags added in 2, dictionaries in 3
+static const uint32     s_packMinVersion    = 1;
+static const unsigned   s_maxMounts         = 16;
+
+// The table of contents is read in place, so it's aligned for its members
+static const unsigned   s_tocAlignment      = 8;
+
+//////////////////////////////////////////////////////
+//
+// Internal Types
+//
+
+// On disk a pack is the header, the entry data each aligned to the header's
+//  alignment, the table of contents sorted by path hash and the footer. 
+//  From version 3 the dictionary's location comes between the table and 
+//  the footer, and its data somewhere before the table.
+struct PackHeader {
+    uint32      magic;
+    uint32      version;
+    uint32      alignment;
+    uint32      reserved;
+};
+
+struct PackDictionary {
+    uint64      offset;
+    uint32      size;           // Zero without a dictionary
+    uint32      reserved;
+};
+
+struct PackFooter {
+    uint64      tocOffset;
+    uint32      numEntries;
+    uint32      magic;
+};
+
+class PackFile : public IPackFile {
+public:
+    PackFile();
+    ~PackFile();
+
+    bool Open(const chargr * fileName);
+
+    virtual unsigned GetNumEntries() const;
+    virtual const PackEntry * GetEntry(unsigned index) const;
+    virtual const PackEntry * FindEntry(Hash64 pathHash) const;
+    virtual IRawStreamPtr OpenEntry(const PackEntry * entry);
+    virtual bool VerifyEntry(const PackEntry * entry);
+    virtual ILZ4DictionaryPtr GetDictionary() const;
+
+    void AddStream();
+    void RemoveStream();
+
+private:
+    IRawStreamPtr OpenDictEntry(IRawStreamPtr stream, const PackEntry * entry);
+
+private:
+    IMappedFilePtr      m_file;
+    IFileViewPtr        m_view;         // The whole pack
+    const byte        * m_data;
+    const PackEntry   * m_entries;
+    unsigned            m_numEntries;
+    ILZ4DictionaryPtr   m_dictionary;
+    volatile int32      m_openStreams;
+};
+
+// Reads an entry in place from the pack's view
+class RawPackStream : public IRawStream {
+public:
+    RawPackStream(PackFile * pack, const byte * data, unsigned size);
+    ~RawPackStream();
+
+    virtual EStreamError ReadBytes(void * bytes, unsigned count, unsigned * bytesRead);
+    virtual EStreamError WriteBytes(const void * bytes, unsigned count, unsigned * bytesWritten);
+
+    virtual unsigned LendReadBlock(const byte ** block);
+    virtual void ReturnBlock(unsigned unused);
+
+private:
+    PackFile      * m_pack;
+    const byte    * m_data;
+    unsigned        m_size;
+    unsigned        m_pos;
+};
+
+// Lends out an entry that was decoded whole when it was opened, or fails 
+//  every read when it didn't decode
+class RawDecodedStream : public IRawStream {
+public:
+    RawDecodedStream(byte * data, unsigned size);
+    ~RawDecodedStream();
+
+    virtual EStreamError ReadBytes(void * bytes, unsigned count, unsigned * bytesRead);
+    virtual EStreamError WriteBytes(const void * bytes, unsigned count, unsigned * bytesWritten);
+
+    virtual unsigned LendReadBlock(const byte ** block);
+    virtual void ReturnBlock(unsigned unused);
+
+private:
+    byte          * m_data;         // NULL when the entry didn't decode
+    unsigned        m_size;
+    unsigned        m_pos;
+};
+
+// Collects compressed entries, overflowing when they grow past the raw size
+class RawBufferStream : public IRawStream {
+public:
+    RawBufferStream(byte * buffer, unsigned size);
+
+    virtual EStreamError ReadBytes(void * bytes, unsigned count, unsigned * bytesRead);
+    virtual EStreamError WriteBytes(const void * bytes, unsigned count, unsigned * bytesWritten);
+
+    unsigned GetUsed() const { return m_used; }
+    bool HasOverflowed() const { return m_overflowed; }
+
+private:
+    byte      * m_buffer;
+    unsigned    m_size;
+    unsigned    m_used;
+    bool        m_overflowed;
+};
+
+class PackWriter : public IPackWriter {
+public:
+    PackWriter(unsigned alignment);
+    ~PackWriter();
+
+    bool Open(const chargr * fileName);
+
+    virtual EStreamError AddEntry(
+        const chargr      * path, 
+        const void        * data, 
+        unsigned            size, 
+        EPackCompression    compression
+    );
+    virtual EStreamError AddEntry(
+        const chargr      * path, 
+        const void        * data, 
+        unsigned            size, 
+        EPackCompression    compression,
+        unsigned            flags
+    );
+    virtual EStreamError SetDictionary(ILZ4DictionaryPtr dictionary);
+    virtual EStreamError Close();
+
+private:
+    void WriteData(const void * data, unsigned size);
+    void WritePadding(unsigned alignment);
+
+private:
+    IRawStreamPtr   m_file;
+    uint64          m_offset;
+    unsigned        m_alignment;
+    PackEntry     * m_entries;
+    unsigned        m_numEntries;
+    unsigned        m_capacity;
+    ILZ4DictionaryPtr m_dictionary;
+    PackDictionary  m_dictionaryInfo;
+    EStreamError    m_result;       // First error, returned by Close
+    bool            m_closed;
+};
+
+struct Mount {
+    IPackFilePtr    pack;
+    chargr          root[FILE_PATH_LENGTH];
+    unsigned        rootLen;
+};
+
+//////////////////////////////////////////////////////
+//
+// Internal Data
+//
+
+// Searched last to first so later mounts override earlier ones
+static Mount    s_mounts[s_maxMounts];
+static unsigned s_numMounts = 0;
+
+//////////////////////////////////////////////////////
+//
+// Internal Functions
+//
+
+//====================================================
+// Drops empty and "." components, resolves ".." where it can and uses '/' 
+//  separators. Case is left alone, path hashes and mount points ignore it.
+static bool NormalizePath(const chargr * path, chargr * normalized, unsigned len) {
+    unsigned used = 0;
+    const chargr * pos = path;
+    while (*pos != 0) {
+        while (*pos == L'/' || *pos == L'\\') 
+            pos++;
+        const chargr * start = pos;
+        while (*pos != 0 && *pos != L'/' && *pos != L'\\') 
+            pos++;
+
+        unsigned componentLen = static_cast<unsigned>(pos - start);
+        if (componentLen == 0 || (componentLen == 1 && start[0] == L'.')) 
+            continue;
+
+        if (componentLen == 2 && start[0] == L'.' && start[1] == L'.') {
+            bool previousIsParent = used >= 2 
+                && normalized[used - 1] == L'.' 
+                && normalized[used - 2] == L'.' 
+                && (used == 2 || normalized[used - 3] == L'/');
+            if (used > 0 && !previousIsParent) {
+                while (used > 0 && normalized[used - 1] != L'/') 
+                    used--;
+                if (used > 0) 
+                    used--;
+                continue;
+            }
+        }
+
+        unsigned needed = used + (used > 0 ? 1 : 0) + componentLen + 1;
+        if (needed > len) 
+            return false;
+
+        if (used > 0) 
+            normalized[used++] = L'/';
+        for (unsigned i = 0; i < componentLen; i++) 
+            normalized[used++] = start[i];
+    }
+
+    if (len == 0) 
+        return false;
+    normalized[used] = 0;
+    return true;
+}
+
+//====================================================
+static int CompareEntries(const void * lhs, const void * rhs) {
+    uint64 lhsHash = reinterpret_cast<const PackEntry *>(lhs)->pathHash;
+    uint64 rhsHash = reinterpret_cast<const PackEntry *>(rhs)->pathHash;
+    if (lhsHash < rhsHash) 
+        return -1;
+    return lhsHash > rhsHash ? 1 : 0;
+}
+
+//====================================================
+static IRawStreamPtr OpenPacked(const chargr * fileName, unsigned * rawSize) {
+    if (s_numMounts == 0) 
+        return IRawStreamPtr(NULL);
+
+    chargr path[FILE_PATH_LENGTH];
+    if (!NormalizePath(fileName, path, FILE_PATH_LENGTH)) 
+        return IRawStreamPtr(NULL);
+
+    for (unsigned i = s_numMounts; i-- > 0; ) {
+        const Mount & mount = s_mounts[i];
+        const chargr * relative = path;
+        if (mount.rootLen > 0) {
+            if (StrICmp(path, mount.root, mount.rootLen) != 0 || path[mount.rootLen] != L'/') 
+                continue;
+            relative = path + mount.rootLen + 1;
+        }
+
+        const PackEntry * entry = mount.pack->FindEntry(HashString64(relative));
+        if (entry == NULL) 
+            continue;
+
+        if (rawSize != NULL) 
+            *rawSize = entry->rawSize;
+        return mount.pack->OpenEntry(entry);
+    }
+
+    return IRawStreamPtr(NULL);
+}
+
+//////////////////////////////////////////////////////
+//
+// PackFile
+//
+
+//====================================================
+PackFile::PackFile() :
+    m_data(NULL),
+    m_entries(NULL),
+    m_numEntries(0),
+    m_openStreams(0)
+{
+}
+
+//====================================================
+PackFile::~PackFile() {
+    ASSERTMSGGR(m_openStreams == 0, "Pack released while streams still read from it");
+}
+
+//====================================================
+bool PackFile::Open(const chargr * fileName) {
+    EFileResult result;
+    m_file = FileOpenMapped(fileName, FILE_MAP_HINT_RANDOM, &result);
+    if (result != FILE_RESULT_OK) 
+        return false;
+
+    // The whole pack is a single view, which limits packs to 4GB
+    uint64 size = m_file->GetSize();
+    if (size < sizeof(PackHeader) + sizeof(PackFooter) || size > 0xffffffffULL) 
+        return false;
+
+    m_view = m_file->MapView(0, static_cast<unsigned>(size));
+    if (m_view == NULL || m_view->GetSize() != size) 
+        return false;
+    m_data = m_view->GetData();
+
+    const PackHeader * header = reinterpret_cast<const PackHeader *>(m_data);
+    if (header->magic != s_packMagic) 
+        return false;
+    if (header->version < s_packMinVersion || header->version > s_packVersion) 
+        return false;
+
+    PackFooter footer;
+    memcpy(&footer, m_data + size - sizeof(PackFooter), sizeof(PackFooter));
+    uint64 tocEnd = size - sizeof(PackFooter);
+
+    PackDictionary dictionary;
+    memset(&dictionary, 0, sizeof(dictionary));
+    if (header->version >= 3) {
+        if (tocEnd < sizeof(PackHeader) + sizeof(PackDictionary)) 
+            return false;
+        tocEnd -= sizeof(PackDictionary);
+        memcpy(&dictionary, m_data + tocEnd, sizeof(PackDictionary));
+    }
+
+    if (footer.magic != s_packMagic || footer.tocOffset % s_tocAlignment != 0) 
+        return false;
+    if (footer.tocOffset < sizeof(PackHeader) || footer.tocOffset > tocEnd) 
+        return false;
+    if ((tocEnd - footer.tocOffset) != footer.numEntries * static_cast<uint64>(sizeof(PackEntry))) 
+        return false;
+
+    m_entries       = reinterpret_cast<const PackEntry *>(m_data + footer.tocOffset);
+    m_numEntries    = footer.numEntries;
+
+    if (dictionary.size > 0) {
+        if (dictionary.offset > footer.tocOffset || dictionary.size > footer.tocOffset - dictionary.offset) 
+            return false;
+        m_dictionary = StreamCreateLZ4Dictionary(m_data + dictionary.offset, dictionary.size);
+        if (m_dictionary == NULL) 
+            return false;
+    }
+
+    // Checked once here so lookups and opens can trust the table
+    for (unsigned i = 0; i < m_numEntries; i++) {
+        const PackEntry & entry = m_entries[i];
+        if (entry.offset > footer.tocOffset || entry.size > footer.tocOffset - entry.offset) 
+            return false;
+        if ((entry.flags & ~PACK_ENTRY_CHECKED) != 0) 
+            return false;
+        bool stored = entry.compression == PACK_COMPRESSION_NONE && (entry.flags & PACK_ENTRY_CHECKED) == 0;
+        if (stored && entry.size != entry.rawSize) 
+            return false;
+        if (entry.compression > PACK_COMPRESSION_LZ4_DICT) 
+            return false;
+        if (entry.compression == PACK_COMPRESSION_LZ4_DICT && (m_dictionary == NULL || entry.rawSize > PACK_DICT_MAX_ENTRY_SIZE)) 
+            return false;
+        if (i > 0 && m_entries[i - 1].pathHash >= entry.pathHash) 
+            return false;
+    }
+
+    return true;
+}
+
+//====================================================
+unsigned PackFile::GetNumEntries() const {
+    return m_numEntries;
+}
+
+//====================================================
+const PackEntry * PackFile::GetEntry(unsigned index) const {
+    ASSERTGR(index < m_numEntries);
+    return &m_entries[index];
+}
+
+//====================================================
+const PackEntry * PackFile::FindEntry(Hash64 pathHash) const {
+    uint64 hash = pathHash.GetValue();
+    unsigned low  = 0;
+    unsigned high = m_numEntries;
+    while (low < high) {
+        unsigned mid = (low + high) / 2;
+        const PackEntry & entry = m_entries[mid];
+        if (entry.pathHash == hash) 
+            return &entry;
+        if (entry.pathHash < hash) 
+            low = mid + 1;
+        else
+            high = mid;
+    }
+
+    return NULL;
+}
+
+//====================================================
+IRawStreamPtr PackFile::OpenEntry(const PackEntry * entry) {
+    ASSERTMSGGR(entry >= m_entries && entry < m_entries + m_numEntries, "Entry is from another pack");
+
+    IRawStreamPtr stream(new(PACK_MEM_FLAGS) RawPackStream(
+        this, 
+        m_data + entry->offset, 
+        entry->size
+    ));
+
+    // Blocks are checked as they're read, before they're decompressed
+    if (entry->flags & PACK_ENTRY_CHECKED) 
+        stream = StreamOpenChecked(stream);
+
+    // Entries are small enough that a read ahead thread would cost more 
+    //  than it hides
+    if (entry->compression == PACK_COMPRESSION_LZ4 && stream != NULL) 
+        stream = StreamOpenLZ4(stream, 0);
+    if (entry->compression == PACK_COMPRESSION_LZ4_DICT && stream != NULL) 
+        stream = OpenDictEntry(stream, entry);
+    return stream;
+}
+
+//====================================================
+// Dictionary entries are a single block, so they're decoded whole. Only 
+//  checked entries need a copy of their packed data first.
+IRawStreamPtr PackFile::OpenDictEntry(IRawStreamPtr stream, const PackEntry * entry) {
+    const byte * packed = m_data + entry->offset;
+    unsigned packedSize = entry->size;
+    byte * checked      = NULL;
+    bool result         = true;
+    if (entry->flags & PACK_ENTRY_CHECKED) {
+        checked = new(PACK_MEM_FLAGS) byte[entry->size];
+        result  = stream->ReadBytes(checked, entry->size, &packedSize) == STREAM_ERROR_EOF;
+        packed  = checked;
+    }
+
+    byte * raw = new(PACK_MEM_FLAGS) byte[entry->rawSize > 0 ? entry->rawSize : 1];
+    result = result && m_dictionary->Decompress(packed, packedSize, raw, entry->rawSize);
+    if (checked != NULL) 
+        delete [] checked;
+    if (!result) {
+        delete [] raw;
+        raw = NULL;
+    }
+
+    return IRawStreamPtr(new(PACK_MEM_FLAGS) RawDecodedStream(raw, entry->rawSize));
+}
+
+//====================================================
+bool PackFile::VerifyEntry(const PackEntry * entry) {
+    if (entry->compression == PACK_COMPRESSION_NONE && (entry->flags & PACK_ENTRY_CHECKED) == 0) 
+        return HashData64(m_data + entry->offset, entry->size).GetValue() == entry->contentHash;
+
+    IRawStreamPtr stream = OpenEntry(entry);
+    if (stream == NULL) 
+        return false;
+
+    byte * raw = new(PACK_MEM_FLAGS) byte[entry->rawSize + 1];
+    unsigned bytesRead = 0;
+    stream->ReadBytes(raw, entry->rawSize + 1, &bytesRead);
+    bool result = bytesRead == entry->rawSize 
+        && HashData64(raw, entry->rawSize).GetValue() == entry->contentHash;
+    delete [] raw;
+    return result;
+}
+
+//====================================================
+ILZ4DictionaryPtr PackFile::GetDictionary() const {
+    return m_dictionary;
+}
+
+//====================================================
+void PackFile::AddStream() {
+    AtomicIncrement(&m_openStreams);
+}
+
+//====================================================
+void PackFile::RemoveStream() {
+    AtomicAdd(&m_openStreams, -1);
+}
+
+//////////////////////////////////////////////////////
+//
+// RawPackStream
+//
+
+//====================================================
+RawPackStream::RawPackStream(PackFile * pack, const byte * data, unsigned size) :
+    m_pack(pack),
+    m_data(data),
+    m_size(size),
+    m_pos(0)
+{
+    m_pack->AddStream();
+}
+
+//====================================================
+RawPackStream::~RawPackStream() {
+    m_pack->RemoveStream();
+}
+
+//====================================================
+EStreamError RawPackStream::ReadBytes(void * bytes, unsigned count, unsigned * bytesRead) {
+    EStreamError result = STREAM_ERROR_OK;
+    if (count > m_size - m_pos) {
+        count   = m_size - m_pos;
+        result  = STREAM_ERROR_EOF;
+    }
+
+    memcpy(bytes, m_data + m_pos, count);
+    m_pos += count;
+
+    if (bytesRead != NULL) 
+        *bytesRead = count;
+    return result;
+}
+
+//====================================================
+EStreamError RawPackStream::WriteBytes(const void * bytes, unsigned count, unsigned * bytesWritten) {
+    ASSERTMSGGR(false, "Packed streams are read only");
+    if (bytesWritten != NULL) 
+        *bytesWritten = 0;
+    return STREAM_ERROR_FILENOTOPENED;
+}
+
+//====================================================
+unsigned RawPackStream::LendReadBlock(const byte ** block) {
+    *block          = m_data + m_pos;
+    unsigned size   = m_size - m_pos;
+    m_pos           = m_size;
+    return size;
+}
+
+//====================================================
+void RawPackStream::ReturnBlock(unsigned unused) {
+    ASSERTGR(unused <= m_pos);
+    m_pos -= unused;
+}
+
+//////////////////////////////////////////////////////
+//
+// RawDecodedStream
+//
+
+//====================================================
+RawDecodedStream::RawDecodedStream(byte * data, unsigned size) :
+    m_data(data),
+    m_size(data != NULL ? size : 0),
+    m_pos(0)
+{
+}
+
+//====================================================
+RawDecodedStream::~RawDecodedStream() {
+    if (m_data != NULL) 
+        delete [] m_data;
+}
+
+//====================================================
+EStreamError RawDecodedStream::ReadBytes(void * bytes, unsigned count, unsigned * bytesRead) {
+    EStreamError result = m_data != NULL ? STREAM_ERROR_OK : STREAM_ERROR_BADDATA;
+    if (count > m_size - m_pos) {
+        count = m_size - m_pos;
+        if (result == STREAM_ERROR_OK) 
+            result = STREAM_ERROR_EOF;
+    }
+
+    memcpy(bytes, m_data + m_pos, count);
+    m_pos += count;
+
+    if (bytesRead != NULL) 
+        *bytesRead = count;
+    return result;
+}
+
+//====================================================
+EStreamError RawDecodedStream::WriteBytes(const void * bytes, unsigned count, unsigned * bytesWritten) {
+    ASSERTMSGGR(false, "Packed streams are read only");
+    if (bytesWritten != NULL) 
+        *bytesWritten = 0;
+    return STREAM_ERROR_FILENOTOPENED;
+}
+
+//====================================================
+unsigned RawDecodedStream::LendReadBlock(const byte ** block) {
+    *block          = m_data + m_pos;
+    unsigned size   = m_size - m_pos;
+    m_pos           = m_size;
+    return size;
+}
+
+//====================================================
+void RawDecodedStream::ReturnBlock(unsigned unused) {
+    ASSERTGR(unused <= m_pos);
+    m_pos -= unused;
+}
+
+//////////////////////////////////////////////////////
+//
+// RawBufferStream
+//
+
+//====================================================
+RawBufferStream::RawBufferStream(byte * buffer, unsigned size) :
+    m_buffer(buffer),
+    m_size(size),
+    m_used(0),
+    m_overflowed(false)
+{
+}
+
+//====================================================
+EStreamError RawBufferStream::ReadBytes(void * bytes, unsigned count, unsigned * bytesRead) {
+    ASSERTMSGGR(false, "Buffer streams are write only");
+    if (bytesRead != NULL) 
+        *bytesRead = 0;
+    return STREAM_ERROR_FILENOTOPENED;
+}
+
+//====================================================
+EStreamError RawBufferStream::WriteBytes(const void * bytes, unsigned count, unsigned * bytesWritten) {
+    if (m_overflowed || count > m_size - m_used) {
+        m_overflowed = true;
+        if (bytesWritten != NULL) 
+            *bytesWritten = 0;
+        return STREAM_ERROR_EOF;
+    }
+
+    memcpy(m_buffer + m_used, bytes, count);
+    m_used += count;
+
+    if (bytesWritten != NULL) 
+        *bytesWritten = count;
+    return STREAM_ERROR_OK;
+}
+
+//////////////////////////////////////////////////////
+//
+// PackWriter
+//
+
+//====================================================
+PackWriter::PackWriter(unsigned alignment) :
+    m_offset(0),
+    m_alignment(alignment),
+    m_entries(NULL),
+    m_numEntries(0),
+    m_capacity(0),
+    m_result(STREAM_ERROR_OK),
+    m_closed(false)
+{
+    ASSERTMSGGR(alignment > 0, "Pack alignment can't be zero");
+    memset(&m_dictionaryInfo, 0, sizeof(m_dictionaryInfo));
+}
+
+//====================================================
+PackWriter::~PackWriter() {
+    Close();
+    if (m_entries != NULL) 
+        delete [] m_entries;
+}
+
+//====================================================
+bool PackWriter::Open(const chargr * fileName) {
+    m_file = StreamCreateFile(fileName);
+    if (m_file == NULL) {
+        m_result = STREAM_ERROR_FILENOTOPENED;
+        return false;
+    }
+
+    PackHeader header;
+    header.magic        = s_packMagic;
+    header.version      = s_packVersion;
+    header.alignment    = m_alignment;
+    header.reserved     = 0;
+    WriteData(&header, sizeof(header));
+    return m_result == STREAM_ERROR_OK;
+}
+
+//====================================================
+void PackWriter::WriteData(const void * data, unsigned size) {
+    if (m_result != STREAM_ERROR_OK) 
+        return;
+
+    m_result  = m_file->WriteBytes(data, size, NULL);
+    m_offset += size;
+}
+
+//====================================================
+void PackWriter::WritePadding(unsigned alignment) {
+    static const byte s_zeros[256] = { 0 };
+
+    unsigned padding = static_cast<unsigned>((alignment - m_offset % alignment) % alignment);
+    while (padding > 0) {
+        unsigned chunk = padding < sizeof(s_zeros) ? padding : sizeof(s_zeros);
+        WriteData(s_zeros, chunk);
+        padding -= chunk;
+    }
+}
+
+//====================================================
+EStreamError PackWriter::AddEntry(
+    const chargr      * path, 
+    const void        * data, 
+    unsigned            size, 
+    EPackCompression    compression
+) {
+    return AddEntry(path, data, size, compression, 0);
+}
+
+//====================================================
+EStreamError PackWriter::AddEntry(
+    const chargr      * path, 
+    const void        * data, 
+    unsigned            size, 
+    EPackCompression    compression,
+    unsigned            flags
+) {
+    ASSERTMSGGR(!m_closed, "Adding to a closed pack");
+    if (m_closed) 
+        return STREAM_ERROR_FILENOTOPENED;
+
+    if (m_numEntries == m_capacity) {
+        unsigned newCapacity = m_capacity == 0 ? 256 : 2 * m_capacity;
+        PackEntry * newEntries = new(PACK_MEM_FLAGS) PackEntry[newCapacity];
+        if (m_numEntries > 0) 
+            memcpy(newEntries, m_entries, m_numEntries * sizeof(PackEntry));
+        if (m_entries != NULL) 
+            delete [] m_entries;
+        m_entries   = newEntries;
+        m_capacity  = newCapacity;
+    }
+
+    PackEntry & entry   = m_entries[m_numEntries++];
+    entry.pathHash      = StreamHashPath(path).GetValue();
+    entry.contentHash   = HashData64(data, size).GetValue();
+    entry.size          = size;
+    entry.rawSize       = size;
+    entry.compression   = PACK_COMPRESSION_NONE;
+    entry.flags         = flags & PACK_ENTRY_CHECKED;
+
+    WritePadding(m_alignment);
+    entry.offset = m_offset;
+
+    // Entries that don't get smaller overflow the buffer and are stored 
+    //  as they are
+    if (compression == PACK_COMPRESSION_LZ4_DICT && (m_dictionary == NULL || size > PACK_DICT_MAX_ENTRY_SIZE)) 
+        compression = PACK_COMPRESSION_LZ4;
+
+    const void * stored = data;
+    byte * packed = NULL;
+    if (compression == PACK_COMPRESSION_LZ4_DICT) {
+        packed = new(PACK_MEM_FLAGS) byte[size > 0 ? size : 1];
+        unsigned packedSize = m_dictionary->Compress(data, size, packed);
+        if (packedSize > 0) {
+            entry.size          = packedSize;
+            entry.compression   = PACK_COMPRESSION_LZ4_DICT;
+            stored              = packed;
+        }
+    }
+    else if (compression == PACK_COMPRESSION_LZ4) {
+        packed = new(PACK_MEM_FLAGS) byte[size];
+        RawBufferStream * buffer = new(PACK_MEM_FLAGS) RawBufferStream(packed, size);
+        IRawStreamPtr bufferStream(buffer);
+        {
+            IRawStreamPtr stream = StreamCreateLZ4(bufferStream, STREAM_LZ4_BLOCK_SIZE, 0);
+            if (stream != NULL) 
+                stream->WriteBytes(data, size, NULL);
+        }
+
+        if (!buffer->HasOverflowed() && buffer->GetUsed() < size) {
+            entry.size          = buffer->GetUsed();
+            entry.compression   = PACK_COMPRESSION_LZ4;
+            stored              = packed;
+        }
+    }
+
+    // Room for the stream header, a header for each block and the end
+    if (entry.flags & PACK_ENTRY_CHECKED) {
+        unsigned numBlocks  = (entry.size + STREAM_CHECKED_BLOCK_SIZE - 1) / STREAM_CHECKED_BLOCK_SIZE;
+        unsigned maxSize    = entry.size + 16 + 8 * (numBlocks + 1);
+        byte * checked = new(PACK_MEM_FLAGS) byte[maxSize];
+        RawBufferStream * buffer = new(PACK_MEM_FLAGS) RawBufferStream(checked, maxSize);
+        IRawStreamPtr bufferStream(buffer);
+        {
+            IRawStreamPtr stream = StreamCreateChecked(bufferStream);
+            if (stream != NULL) 
+                stream->WriteBytes(stored, entry.size, NULL);
+        }
+
+        ASSERTGR(!buffer->HasOverflowed());
+        if (buffer->HasOverflowed() && m_result == STREAM_ERROR_OK) 
+            m_result = STREAM_ERROR_BADDATA;
+        entry.size = buffer->GetUsed();
+        WriteData(checked, entry.size);
+        delete [] checked;
+    }
+    else {
+        WriteData(stored, entry.size);
+    }
+
+    if (packed != NULL) 
+        delete [] packed;
+    return m_result;
+}
+
+//====================================================
+EStreamError PackWriter::SetDictionary(ILZ4DictionaryPtr dictionary) {
+    ASSERTMSGGR(!m_closed && m_dictionary == NULL, "Pack dictionary set twice or after closing");
+    if (m_closed || m_dictionary != NULL) 
+        return STREAM_ERROR_FILENOTOPENED;
+    if (dictionary == NULL || dictionary->GetSize() == 0) 
+        return m_result;
+
+    m_dictionary                = dictionary;
+    m_dictionaryInfo.offset     = m_offset;
+    m_dictionaryInfo.size       = dictionary->GetSize();
+    WriteData(dictionary->GetData(), dictionary->GetSize());
+    return m_result;
+}
+
+//====================================================
+EStreamError PackWriter::Close() {
+    if (m_closed || m_file == NULL) 
+        return m_result;
+    m_closed = true;
+
+    // The same path added twice, or two paths that hash the same, can't be 
+    //  told apart when looking them up
+    qsort(m_entries, m_numEntries, sizeof(PackEntry), CompareEntries);
+    for (unsigned i = 1; i < m_numEntries && m_result == STREAM_ERROR_OK; i++) {
+        if (m_entries[i - 1].pathHash == m_entries[i].pathHash) 
+            m_result = STREAM_ERROR_BADDATA;
+    }
+
+    WritePadding(s_tocAlignment);
+
+    PackFooter footer;
+    footer.tocOffset    = m_offset;
+    footer.numEntries   = m_numEntries;
+    footer.magic        = s_packMagic;
+    WriteData(m_entries, m_numEntries * sizeof(PackEntry));
+    WriteData(&m_dictionaryInfo, sizeof(m_dictionaryInfo));
+    WriteData(&footer, sizeof(footer));
+
+    EStreamError result = m_file->Flush();
+    if (m_result == STREAM_ERROR_OK) 
+        m_result = result;
+
+    m_file = IRawStreamPtr(NULL);
+    return m_result;
+}
+
+} // namespace NSPackFile
+
+//////////////////////////////////////////////////////
+//
+// External functions
+//
+
+//====================================================
+Hash64 StreamHashPath(const chargr * path) {
+    chargr normalized[FILE_PATH_LENGTH];
+    bool result = NSPackFile::NormalizePath(path, normalized, FILE_PATH_LENGTH);
+    ASSERTMSGGR(result, "Path is too long to hash");
+    return HashString64(normalized);
+}
+
+//====================================================
+IPackFilePtr StreamOpenPack(const chargr * fileName) {
+    NSPackFile::PackFile * pack = new(PACK_MEM_FLAGS) NSPackFile::PackFile();
+    if (!pack->Open(fileName)) {
+        delete pack;
+        pack = NULL;
+    }
+
+    return IPackFilePtr(pack);
+}
+
+//====================================================
+IPackWriterPtr StreamCreatePack(const chargr * fileName) {
+    return StreamCreatePack(fileName, PACK_DEFAULT_ALIGNMENT);
+}
+
+//====================================================
+IPackWriterPtr StreamCreatePack(const chargr * fileName, unsigned alignment) {
+    NSPackFile::PackWriter * writer = new(PACK_MEM_FLAGS) NSPackFile::PackWriter(alignment);
+    if (!writer->Open(fileName)) {
+        delete writer;
+        writer = NULL;
+    }
+
+    return IPackWriterPtr(writer);
+}
+
+//====================================================
+bool StreamMountPack(IPackFilePtr pack, const chargr * mountPoint) {
+    using namespace NSPackFile;
+
+    if (pack == NULL || s_numMounts == s_maxMounts) 
+        return false;
+
+    Mount & mount = s_mounts[s_numMounts];
+    if (!NormalizePath(mountPoint, mount.root, FILE_PATH_LENGTH)) 
+        return false;
+
+    mount.pack      = pack;
+    mount.rootLen   = StrLen(mount.root, FILE_PATH_LENGTH);
+    s_numMounts++;
+    return true;
+}
+
+//====================================================
+void StreamUnmountPack(IPackFilePtr pack) {
+    using namespace NSPackFile;
+
+    unsigned used = 0;
+    for (unsigned i = 0; i < s_numMounts; i++) {
+        if (s_mounts[i].pack != pack) {
+            if (used != i) {
+                s_mounts[used].pack     = s_mounts[i].pack;
+                s_mounts[used].rootLen  = s_mounts[i].rootLen;
+                StrCopy(s_mounts[used].root, FILE_PATH_LENGTH, s_mounts[i].root);
+            }
+            used++;
+        }
+    }
+
+    for (unsigned i = used; i < s_numMounts; i++) 
+        s_mounts[i].pack = IPackFilePtr(NULL);
+    s_numMounts = used;
+}
+
+//====================================================
+IRawStreamPtr StreamOpenPacked(const chargr * fileName) {
+    return NSPackFile::OpenPacked(fileName, NULL);
+}
+
+//====================================================
+IRawStreamPtr StreamOpenPacked(const chargr * fileName, unsigned * rawSize) {
+    return NSPackFile::OpenPacked(fileName, rawSize);
+}
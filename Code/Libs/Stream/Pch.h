@@ -29,7 +29,10 @@
 
 #pragma once
 
+#include <string.h>
+
 #include "Ext/tinyxml/tinyxml.h"
+#include "Ext/lz4/LZ4.h"
 
 #define USES_LIBS_STREAM
 
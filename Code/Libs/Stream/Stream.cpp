@@ -34,11 +34,819 @@
 // Internal
 //
 
+#define STREAM_MEM_FLAGS (MemFlags(MEM_ARENA_DEFAULT, MEM_CAT_FILEIO))
 
+// Reads at least this big skip the lent blocks and go to the raw stream
+static const unsigned s_directBytes = 4 * 1024;
+
+class RawFileStream : public IRawStream {
+public:
+    RawFileStream(IRawFilePtr file, EFileMode mode, unsigned blockSize);
+    ~RawFileStream();
+
+    virtual EStreamError ReadBytes(void * bytes, unsigned count, unsigned * bytesRead);
+    virtual EStreamError WriteBytes(const void * bytes, unsigned count, unsigned * bytesWritten);
+
+    virtual unsigned LendReadBlock(const byte ** block);
+    virtual unsigned LendWriteBlock(byte ** block);
+    virtual void ReturnBlock(unsigned unused);
+    virtual EStreamError Flush();
+
+private:
+    EStreamError ReadFile(byte * bytes, unsigned count, unsigned * bytesRead);
+    void FillBlock();
+    void FlushBlock();
+
+private:
+    IRawFilePtr     m_file;
+    EFileMode       m_mode;
+    byte          * m_block;
+    unsigned        m_blockSize;
+    unsigned        m_pos;          // Next unread byte or end of pending writes
+    unsigned        m_end;          // End of read data
+    EStreamError    m_writeError;   // Held until the next flush
+};
+
+// Keeps a read in flight for each block past the one being read, and lends
+//  the blocks out as they finish in order
+class RawAheadStream : public IRawStream {
+public:
+    RawAheadStream(IAsyncIOPtr io, IAsyncFilePtr file, unsigned blockSize, unsigned numAhead);
+    ~RawAheadStream();
+
+    bool Open();
+
+    virtual EStreamError ReadBytes(void * bytes, unsigned count, unsigned * bytesRead);
+    virtual EStreamError WriteBytes(const void * bytes, unsigned count, unsigned * bytesWritten);
+
+    virtual unsigned LendReadBlock(const byte ** block);
+    virtual void ReturnBlock(unsigned unused);
+
+private:
+    struct Slot {
+        AsyncRead       read;
+        ISemaphorePtr   finished;
+        bool            pending;    // Submitted and not yet waited for
+    };
+
+    static void OnRead(AsyncRead * read);
+    void SubmitNext(Slot * slot);
+    bool NextBlock();
+
+private:
+    IAsyncIOPtr     m_io;
+    IAsyncFilePtr   m_file;
+    Slot          * m_slots;
+    byte          * m_buffers;
+    unsigned        m_numSlots;
+    unsigned        m_current;      // Slot of the block being read
+    unsigned        m_blockSize;
+    uint64          m_nextOffset;   // Of the next block to submit
+    const byte    * m_block;
+    unsigned        m_pos;
+    unsigned        m_end;
+    EStreamError    m_result;       // Set once the end or a failed read is reached
+};
+
+class RawMemoryStream : public IRawStream {
+public:
+    RawMemoryStream(void * memory, unsigned size);
+
+    virtual EStreamError ReadBytes(void * bytes, unsigned count, unsigned * bytesRead);
+    virtual EStreamError WriteBytes(const void * bytes, unsigned count, unsigned * bytesWritten);
+
+    virtual unsigned LendReadBlock(const byte ** block);
+    virtual unsigned LendWriteBlock(byte ** block);
+    virtual void ReturnBlock(unsigned unused);
+
+private:
+    byte      * m_memory;
+    unsigned    m_size;
+    unsigned    m_pos;
+};
+
+class RawMappedStream : public IRawStream {
+public:
+    RawMappedStream(IMappedFilePtr file, unsigned windowSize);
+
+    virtual EStreamError ReadBytes(void * bytes, unsigned count, unsigned * bytesRead);
+    virtual EStreamError WriteBytes(const void * bytes, unsigned count, unsigned * bytesWritten);
+
+    virtual unsigned LendReadBlock(const byte ** block);
+    virtual void ReturnBlock(unsigned unused);
+
+private:
+    bool MapNextWindow();
+
+private:
+    IMappedFilePtr  m_file;
+    IFileViewPtr    m_view;
+    const byte    * m_data;
+    uint64          m_viewOffset;
+    unsigned        m_viewSize;
+    unsigned        m_windowSize;
+    unsigned        m_pos;
+};
+
+//====================================================
+RawFileStream::RawFileStream(IRawFilePtr file, EFileMode mode, unsigned blockSize) :
+    m_file(file),
+    m_mode(mode),
+    m_block(NULL),
+    m_blockSize(blockSize),
+    m_pos(0),
+    m_end(0),
+    m_writeError(STREAM_ERROR_OK)
+{
+    ASSERTMSGGR(blockSize > 0, "Stream block size can't be zero");
+    m_block = new(STREAM_MEM_FLAGS) byte[blockSize];
+}
+
+//====================================================
+RawFileStream::~RawFileStream() {
+    if (m_mode == FILE_MODE_WRITE) 
+        FlushBlock();
+    delete [] m_block;
+}
+
+//====================================================
+EStreamError RawFileStream::ReadFile(byte * bytes, unsigned count, unsigned * bytesRead) {
+    EFileResult result = m_file->Read(bytes, count, bytesRead);
+
+    EStreamError ret = STREAM_ERROR_OK;
+    if (result == FILE_RESULT_EOF) 
+        ret = STREAM_ERROR_EOF;
+    else if (result != FILE_RESULT_OK) 
+        ret = STREAM_ERROR_BADDATA;
+    return ret;
+}
+
+//====================================================
+void RawFileStream::FillBlock() {
+    unsigned bytesRead = 0;
+    ReadFile(m_block, m_blockSize, &bytesRead);
+    m_pos = 0;
+    m_end = bytesRead;
+}
+
+//====================================================
+void RawFileStream::FlushBlock() {
+    if (m_pos == 0) 
+        return;
+
+    if (m_file->Write(m_block, m_pos) != FILE_RESULT_OK) 
+        m_writeError = STREAM_ERROR_FILENOTOPENED;
+    m_pos = 0;
+}
+
+//====================================================
+EStreamError RawFileStream::ReadBytes(void * bytes, unsigned count, unsigned * bytesRead) {
+    ASSERTGR(m_mode == FILE_MODE_READ);
+    byte * dest = reinterpret_cast<byte *>(bytes);
+    unsigned total = 0;
+    EStreamError result = STREAM_ERROR_OK;
+    while (total < count) {
+        unsigned available = m_end - m_pos;
+        if (available == 0) {
+            // Reads bigger than a block go straight into the destination
+            unsigned rest = count - total;
+            if (rest >= m_blockSize) {
+                unsigned read = 0;
+                result = ReadFile(dest + total, rest, &read);
+                total += read;
+                break;
+            }
+
+            FillBlock();
+            if (m_end == 0) {
+                result = STREAM_ERROR_EOF;
+                break;
+            }
+            continue;
+        }
+
+        unsigned chunk = count - total < available ? count - total : available;
+        memcpy(dest + total, m_block + m_pos, chunk);
+        m_pos += chunk;
+        total += chunk;
+    }
+
+    if (bytesRead != NULL) 
+        *bytesRead = total;
+    return result;
+}
+
+//====================================================
+EStreamError RawFileStream::WriteBytes(const void * bytes, unsigned count, unsigned * bytesWritten) {
+    ASSERTGR(m_mode == FILE_MODE_WRITE);
+    EStreamError result = STREAM_ERROR_OK;
+    if (count > m_blockSize - m_pos) 
+        FlushBlock();
+
+    if (count >= m_blockSize) {
+        if (m_file->Write(reinterpret_cast<const byte *>(bytes), count) != FILE_RESULT_OK) 
+            result = STREAM_ERROR_FILENOTOPENED;
+    }
+    else {
+        memcpy(m_block + m_pos, bytes, count);
+        m_pos += count;
+    }
+
+    // Errors of earlier blocks are reported by the first write that sees them
+    if (m_writeError != STREAM_ERROR_OK) 
+        result = m_writeError;
+    if (bytesWritten != NULL) 
+        *bytesWritten = result == STREAM_ERROR_OK ? count : 0;
+    return result;
+}
+
+//====================================================
+unsigned RawFileStream::LendReadBlock(const byte ** block) {
+    ASSERTGR(m_mode == FILE_MODE_READ);
+    if (m_pos == m_end) 
+        FillBlock();
+
+    *block          = m_block + m_pos;
+    unsigned size   = m_end - m_pos;
+    m_pos           = m_end;
+    return size;
+}
+
+//====================================================
+unsigned RawFileStream::LendWriteBlock(byte ** block) {
+    ASSERTGR(m_mode == FILE_MODE_WRITE);
+    if (m_pos == m_blockSize) 
+        FlushBlock();
+
+    *block          = m_block + m_pos;
+    unsigned size   = m_blockSize - m_pos;
+    m_pos           = m_blockSize;
+    return size;
+}
+
+//====================================================
+void RawFileStream::ReturnBlock(unsigned unused) {
+    ASSERTGR(unused <= m_pos);
+    m_pos -= unused;
+}
+
+//====================================================
+EStreamError RawFileStream::Flush() {
+    if (m_mode != FILE_MODE_WRITE) 
+        return STREAM_ERROR_OK;
+
+    FlushBlock();
+    if (m_file->Flush() != FILE_RESULT_OK) 
+        m_writeError = STREAM_ERROR_FILENOTOPENED;
+
+    EStreamError result = m_writeError;
+    m_writeError = STREAM_ERROR_OK;
+    return result;
+}
+
+//====================================================
+RawAheadStream::RawAheadStream(IAsyncIOPtr io, IAsyncFilePtr file, unsigned blockSize, unsigned numAhead) :
+    m_io(io),
+    m_file(file),
+    m_slots(NULL),
+    m_buffers(NULL),
+    m_numSlots(numAhead + 1),
+    m_current(numAhead),
+    m_blockSize(blockSize),
+    m_nextOffset(0),
+    m_block(NULL),
+    m_pos(0),
+    m_end(0),
+    m_result(STREAM_ERROR_OK)
+{
+    ASSERTMSGGR(blockSize > 0, "Stream block size can't be zero");
+}
+
+//====================================================
+RawAheadStream::~RawAheadStream() {
+    // The engine owns the buffers until their reads finish
+    if (m_slots != NULL) {
+        for (unsigned i = 0; i < m_numSlots; i++) {
+            if (m_slots[i].pending) 
+                m_slots[i].finished->Wait();
+        }
+    }
+
+    delete [] m_slots;
+    delete [] m_buffers;
+}
+
+//====================================================
+bool RawAheadStream::Open() {
+    m_slots     = new(STREAM_MEM_FLAGS) Slot[m_numSlots];
+    m_buffers   = new(STREAM_MEM_FLAGS) byte[m_numSlots * m_blockSize];
+    for (unsigned i = 0; i < m_numSlots; i++) {
+        Slot & slot         = m_slots[i];
+        slot.read.buffer    = m_buffers + i * m_blockSize;
+        slot.read.size      = m_blockSize;
+        slot.read.callback  = OnRead;
+        slot.read.param     = &slot;
+        slot.finished       = SemaphoreCreate(0);
+        slot.pending        = false;
+        if (slot.finished == NULL) 
+            return false;
+    }
+
+    for (unsigned i = 0; i < m_numSlots; i++) 
+        SubmitNext(&m_slots[i]);
+    return true;
+}
+
+//====================================================
+void RawAheadStream::OnRead(AsyncRead * read) {
+    Slot * slot = reinterpret_cast<Slot *>(read->param);
+    slot->finished->Signal(1);
+}
+
+//====================================================
+void RawAheadStream::SubmitNext(Slot * slot) {
+    if (m_nextOffset >= m_file->GetSize()) 
+        return;
+
+    slot->read.offset   = m_nextOffset;
+    slot->pending       = true;
+    m_nextOffset       += m_blockSize;
+    m_io->Submit(m_file, &slot->read);
+}
+
+//====================================================
+bool RawAheadStream::NextBlock() {
+    if (m_result != STREAM_ERROR_OK) 
+        return false;
+
+    // The block just read is free to read ahead into
+    if (m_block != NULL) 
+        SubmitNext(&m_slots[m_current]);
+
+    m_current   = (m_current + 1) % m_numSlots;
+    m_block     = NULL;
+    m_pos       = 0;
+    m_end       = 0;
+
+    Slot & slot = m_slots[m_current];
+    if (!slot.pending) {
+        m_result = STREAM_ERROR_EOF;
+        return false;
+    }
+
+    slot.finished->Wait();
+    slot.pending = false;
+    if (slot.read.result == FILE_RESULT_FAIL) {
+        m_result = STREAM_ERROR_BADDATA;
+        return false;
+    }
+    if (slot.read.bytesRead == 0) {
+        m_result = STREAM_ERROR_EOF;
+        return false;
+    }
+
+    m_block = slot.read.buffer;
+    m_end   = slot.read.bytesRead;
+    return true;
+}
+
+//====================================================
+EStreamError RawAheadStream::ReadBytes(void * bytes, unsigned count, unsigned * bytesRead) {
+    byte * dest = reinterpret_cast<byte *>(bytes);
+    unsigned total = 0;
+    EStreamError result = STREAM_ERROR_OK;
+    while (total < count) {
+        if (m_pos == m_end && !NextBlock()) {
+            result = m_result;
+            break;
+        }
+
+        unsigned available  = m_end - m_pos;
+        unsigned chunk      = count - total < available ? count - total : available;
+        memcpy(dest + total, m_block + m_pos, chunk);
+        m_pos += chunk;
+        total += chunk;
+    }
+
+    if (bytesRead != NULL) 
+        *bytesRead = total;
+    return result;
+}
+
+//====================================================
+EStreamError RawAheadStream::WriteBytes(const void * bytes, unsigned count, unsigned * bytesWritten) {
+    ASSERTMSGGR(false, "Read ahead streams are read only");
+    if (bytesWritten != NULL) 
+        *bytesWritten = 0;
+    return STREAM_ERROR_FILENOTOPENED;
+}
+
+//====================================================
+unsigned RawAheadStream::LendReadBlock(const byte ** block) {
+    if (m_pos == m_end && !NextBlock()) 
+        return 0;
+
+    *block          = m_block + m_pos;
+    unsigned size   = m_end - m_pos;
+    m_pos           = m_end;
+    return size;
+}
+
+//====================================================
+void RawAheadStream::ReturnBlock(unsigned unused) {
+    ASSERTGR(unused <= m_pos);
+    m_pos -= unused;
+}
+
+//====================================================
+RawMemoryStream::RawMemoryStream(void * memory, unsigned size) :
+    m_memory(reinterpret_cast<byte *>(memory)),
+    m_size(size),
+    m_pos(0)
+{
+}
+
+//====================================================
+EStreamError RawMemoryStream::ReadBytes(void * bytes, unsigned count, unsigned * bytesRead) {
+    EStreamError result = STREAM_ERROR_OK;
+    if (count > m_size - m_pos) {
+        count   = m_size - m_pos;
+        result  = STREAM_ERROR_EOF;
+    }
+
+    memcpy(bytes, m_memory + m_pos, count);
+    m_pos += count;
+
+    if (bytesRead != NULL) 
+        *bytesRead = count;
+    return result;
+}
+
+//====================================================
+EStreamError RawMemoryStream::WriteBytes(const void * bytes, unsigned count, unsigned * bytesWritten) {
+    EStreamError result = STREAM_ERROR_OK;
+    if (count > m_size - m_pos) {
+        count   = m_size - m_pos;
+        result  = STREAM_ERROR_EOF;
+    }
+
+    memcpy(m_memory + m_pos, bytes, count);
+    m_pos += count;
+
+    if (bytesWritten != NULL) 
+        *bytesWritten = count;
+    return result;
+}
+
+//====================================================
+unsigned RawMemoryStream::LendReadBlock(const byte ** block) {
+    *block          = m_memory + m_pos;
+    unsigned size   = m_size - m_pos;
+    m_pos           = m_size;
+    return size;
+}
+
+//====================================================
+unsigned RawMemoryStream::LendWriteBlock(byte ** block) {
+    *block          = m_memory + m_pos;
+    unsigned size   = m_size - m_pos;
+    m_pos           = m_size;
+    return size;
+}
+
+//====================================================
+void RawMemoryStream::ReturnBlock(unsigned unused) {
+    ASSERTGR(unused <= m_pos);
+    m_pos -= unused;
+}
+
+//====================================================
+RawMappedStream::RawMappedStream(IMappedFilePtr file, unsigned windowSize) :
+    m_file(file),
+    m_data(NULL),
+    m_viewOffset(0),
+    m_viewSize(0),
+    m_windowSize(windowSize),
+    m_pos(0)
+{
+    ASSERTMSGGR(windowSize > 0, "Stream window size can't be zero");
+}
+
+//====================================================
+bool RawMappedStream::MapNextWindow() {
+    uint64 offset = m_viewOffset + m_viewSize;
+
+    // Drop the old window first so only one is ever mapped
+    m_view          = IFileViewPtr(NULL);
+    m_data          = NULL;
+    m_viewOffset    = offset;
+    m_viewSize      = 0;
+    m_pos           = 0;
+    m_view          = m_file->MapView(offset, m_windowSize);
+    if (m_view == NULL) 
+        return false;
+
+    m_data      = m_view->GetData();
+    m_viewSize  = m_view->GetSize();
+    return true;
+}
+
+//====================================================
+EStreamError RawMappedStream::ReadBytes(void * bytes, unsigned count, unsigned * bytesRead) {
+    byte * dest = reinterpret_cast<byte *>(bytes);
+    unsigned total = 0;
+    EStreamError result = STREAM_ERROR_OK;
+    while (total < count) {
+        if (m_pos == m_viewSize && !MapNextWindow()) {
+            result = STREAM_ERROR_EOF;
+            break;
+        }
+
+        unsigned available  = m_viewSize - m_pos;
+        unsigned chunk      = count - total < available ? count - total : available;
+        memcpy(dest + total, m_data + m_pos, chunk);
+        m_pos += chunk;
+        total += chunk;
+    }
+
+    if (bytesRead != NULL) 
+        *bytesRead = total;
+    return result;
+}
+
+//====================================================
+EStreamError RawMappedStream::WriteBytes(const void * bytes, unsigned count, unsigned * bytesWritten) {
+    ASSERTMSGGR(false, "Mapped streams are read only");
+    if (bytesWritten != NULL) 
+        *bytesWritten = 0;
+    return STREAM_ERROR_FILENOTOPENED;
+}
+
+//====================================================
+unsigned RawMappedStream::LendReadBlock(const byte ** block) {
+    if (m_pos == m_viewSize && !MapNextWindow()) 
+        return 0;
+
+    *block          = m_data + m_pos;
+    unsigned size   = m_viewSize - m_pos;
+    m_pos           = m_viewSize;
+    return size;
+}
+
+//====================================================
+void RawMappedStream::ReturnBlock(unsigned unused) {
+    ASSERTGR(unused <= m_pos);
+    m_pos -= unused;
+}
+
+//////////////////////////////////////////////////////
+//
+// Member functions
+//
+
+//====================================================
+Stream::Stream(IRawStreamPtr rawStream) :
+    m_rawStream(rawStream)
+{
+}
+
+//====================================================
+DataStream::DataStream(IRawStreamPtr rawStream) :
+    Stream(rawStream),
+    m_readBlock(NULL),
+    m_writeBlock(NULL),
+    m_pos(0),
+    m_readEnd(0),
+    m_writeEnd(0)
+{
+}
+
+//====================================================
+DataStream::~DataStream() {
+    Flush();
+}
+
+//====================================================
+EStreamError DataStream::Flush() {
+    ReturnBlock();
+    return m_rawStream->Flush();
+}
+
+//====================================================
+EStreamError DataStream::ReadBytes(void * bytes, unsigned count, unsigned * bytesRead) {
+    if (m_writeEnd != 0) 
+        ReturnBlock();
+
+    byte * dest = reinterpret_cast<byte *>(bytes);
+    unsigned total = 0;
+    EStreamError result = STREAM_ERROR_OK;
+    while (total < count) {
+        unsigned available = m_readEnd - m_pos;
+        if (available == 0) {
+            // Streams that lend nothing, and big reads, go to the raw stream
+            unsigned rest = count - total;
+            if (rest < s_directBytes) {
+                m_pos       = 0;
+                m_readEnd   = m_rawStream->LendReadBlock(&m_readBlock);
+                if (m_readEnd > 0) 
+                    continue;
+            }
+
+            unsigned read = 0;
+            result = m_rawStream->ReadBytes(dest + total, rest, &read);
+            total += read;
+            break;
+        }
+
+        unsigned chunk = count - total < available ? count - total : available;
+        memcpy(dest + total, m_readBlock + m_pos, chunk);
+        m_pos += chunk;
+        total += chunk;
+    }
+
+    if (bytesRead != NULL) 
+        *bytesRead = total;
+    return result;
+}
+
+//====================================================
+EStreamError DataStream::Skip(unsigned count) {
+    if (m_writeEnd != 0) 
+        ReturnBlock();
+
+    // Whole lent blocks are skipped without copying
+    while (count > m_readEnd - m_pos) {
+        count      -= m_readEnd - m_pos;
+        m_pos       = 0;
+        m_readEnd   = m_rawStream->LendReadBlock(&m_readBlock);
+        if (m_readEnd == 0) 
+            break;
+    }
+
+    if (count <= m_readEnd - m_pos) {
+        m_pos += count;
+        return STREAM_ERROR_OK;
+    }
+
+    byte scratch[256];
+    EStreamError result = STREAM_ERROR_OK;
+    while (count > 0 && result == STREAM_ERROR_OK) {
+        unsigned chunk = count < sizeof(scratch) ? count : sizeof(scratch);
+        result = ReadBytes(scratch, chunk);
+        count -= chunk;
+    }
+
+    return result;
+}
+
+//====================================================
+EStreamError DataStream::WriteBytes(const void * bytes, unsigned count, unsigned * bytesWritten) {
+    if (m_readEnd != 0) 
+        ReturnBlock();
+
+    const byte * src = reinterpret_cast<const byte *>(bytes);
+    unsigned total = 0;
+    EStreamError result = STREAM_ERROR_OK;
+    while (total < count) {
+        unsigned available = m_writeEnd - m_pos;
+        if (available == 0) {
+            unsigned rest = count - total;
+            if (rest < s_directBytes) {
+                m_pos       = 0;
+                m_writeEnd  = m_rawStream->LendWriteBlock(&m_writeBlock);
+                if (m_writeEnd > 0) 
+                    continue;
+            }
+
+            unsigned written = 0;
+            result = m_rawStream->WriteBytes(src + total, rest, &written);
+            total += written;
+            break;
+        }
+
+        unsigned chunk = count - total < available ? count - total : available;
+        memcpy(m_writeBlock + m_pos, src + total, chunk);
+        m_pos += chunk;
+        total += chunk;
+    }
+
+    if (bytesWritten != NULL) 
+        *bytesWritten = total;
+    return result;
+}
+
+//====================================================
+const byte * DataStream::ReadInPlace(unsigned count) {
+    if (m_writeEnd != 0) 
+        ReturnBlock();
+
+    if (m_pos == m_readEnd) {
+        m_pos       = 0;
+        m_readEnd   = m_rawStream->LendReadBlock(&m_readBlock);
+    }
+
+    if (m_pos + count > m_readEnd) 
+        return NULL;
+
+    const byte * bytes = m_readBlock + m_pos;
+    m_pos += count;
+    return bytes;
+}
+
+//====================================================
+void DataStream::ReturnBlock() {
+    if (m_readEnd != 0) 
+        m_rawStream->ReturnBlock(m_readEnd - m_pos);
+    else if (m_writeEnd != 0) 
+        m_rawStream->ReturnBlock(m_writeEnd - m_pos);
+
+    m_readBlock     = NULL;
+    m_writeBlock    = NULL;
+    m_pos           = 0;
+    m_readEnd       = 0;
+    m_writeEnd      = 0;
+}
 
 //////////////////////////////////////////////////////
 //
 // External functions
 //
 
+//====================================================
+IRawStreamPtr StreamCreateFile(const chargr * fileName) {
+    return StreamCreateFile(fileName, STREAM_DEFAULT_BLOCK_SIZE);
+}
+
+//====================================================
+IRawStreamPtr StreamCreateFile(const chargr * fileName, unsigned blockSize) {
+    EFileResult result;
+    IRawFilePtr file = FileOpenRaw(fileName, FILE_MODE_WRITE, &result);
+    if (result != FILE_RESULT_OK) 
+        return IRawStreamPtr(NULL);
+
+    return IRawStreamPtr(new(STREAM_MEM_FLAGS) RawFileStream(file, FILE_MODE_WRITE, blockSize));
+}
+
+//====================================================
+IRawStreamPtr StreamOpenFile(const chargr * fileName) {
+    return StreamOpenFile(fileName, STREAM_DEFAULT_BLOCK_SIZE);
+}
+
+//====================================================
+IRawStreamPtr StreamOpenFile(const chargr * fileName, unsigned blockSize) {
+    IRawStreamPtr packed = StreamOpenPacked(fileName);
+    if (packed != NULL) 
+        return packed;
+
+    EFileResult result;
+    IRawFilePtr file = FileOpenRaw(fileName, FILE_MODE_READ, &result);
+    if (result != FILE_RESULT_OK) 
+        return IRawStreamPtr(NULL);
+
+    return IRawStreamPtr(new(STREAM_MEM_FLAGS) RawFileStream(file, FILE_MODE_READ, blockSize));
+}
+
+//====================================================
+IRawStreamPtr StreamOpenFile(const chargr * fileName, unsigned blockSize, IAsyncIOPtr io, unsigned numAhead) {
+    IRawStreamPtr packed = StreamOpenPacked(fileName);
+    if (packed != NULL) 
+        return packed;
+
+    EFileResult result;
+    IAsyncFilePtr file = io->OpenFile(fileName, &result);
+    if (result != FILE_RESULT_OK) 
+        return IRawStreamPtr(NULL);
+
+    RawAheadStream * stream = new(STREAM_MEM_FLAGS) RawAheadStream(io, file, blockSize, numAhead);
+    if (!stream->Open()) {
+        delete stream;
+        stream = NULL;
+    }
+
+    return IRawStreamPtr(stream);
+}
+
+//====================================================
+IRawStreamPtr StreamOpenMapped(const chargr * fileName) {
+    return StreamOpenMapped(fileName, FILE_MAP_HINT_SEQUENTIAL, STREAM_DEFAULT_MAP_WINDOW);
+}
+
+//====================================================
+IRawStreamPtr StreamOpenMapped(const chargr * fileName, unsigned hints, unsigned windowSize) {
+    // Packed files are already read in place from a mapping
+    IRawStreamPtr packed = StreamOpenPacked(fileName);
+    if (packed != NULL) 
+        return packed;
+
+    EFileResult result;
+    IMappedFilePtr file = FileOpenMapped(fileName, hints, &result);
+    if (result != FILE_RESULT_OK) 
+        return IRawStreamPtr(NULL);
+
+    return IRawStreamPtr(new(STREAM_MEM_FLAGS) RawMappedStream(file, windowSize));
+}
 
+//====================================================
+IRawStreamPtr StreamOpenMemory(void * memory, unsigned size) {
+    return IRawStreamPtr(new(STREAM_MEM_FLAGS) RawMemoryStream(memory, size));
+}
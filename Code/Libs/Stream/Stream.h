@@ -37,32 +37,119 @@ enum EStreamError {
     STREAM_ERROR_NODEDOESNTEXIST,
 };
 
-class IRawStream {
+// Block size of buffered file streams unless one is given
+const unsigned STREAM_DEFAULT_BLOCK_SIZE = 64 * 1024;
+
+// Size of the windows mapped streams map at a time unless one is given
+const unsigned STREAM_DEFAULT_MAP_WINDOW = 64 * 1024 * 1024;
+
+// Size of compressed blocks unless one is given
+const unsigned STREAM_LZ4_BLOCK_SIZE = 256 * 1024;
+
+// Size of checksummed blocks unless one is given
+const unsigned STREAM_CHECKED_BLOCK_SIZE = 64 * 1024;
+
+// Size of trained compression dictionaries unless one is given
+const unsigned STREAM_LZ4_DICT_SIZE = 32 * 1024;
+
+class IRawStream : public RefCounted {
 public:
-    virtual EStreamError Open(const chargr * fileName) = 0;
+    virtual ~IRawStream() { }
+
+    virtual EStreamError ReadBytes(void * bytes, unsigned count, unsigned * bytesRead) = 0;
+    virtual EStreamError WriteBytes(const void * bytes, unsigned count, unsigned * bytesWritten) = 0;
 
-    virtual EStreamError ReadBytes(void * bytes, unsigned * bytesRead) = 0;
-    virtual EStreamError WriteBytes(void * bytes, unsigned * bytesWritten) = 0;
+    // Buffered streams lend out the rest of their current block so callers 
+    //  can read or write it in place. Lending consumes the whole block, and
+    //  ReturnBlock gives back the bytes at its end that weren't used. 
+    //  Streams without a buffer lend nothing.
+    virtual unsigned LendReadBlock(const byte ** block) {
+        return 0;
+    }
+    virtual unsigned LendWriteBlock(byte ** block) {
+        return 0;
+    }
+    virtual void ReturnBlock(unsigned unused) {
+    }
+
+    // Writes buffered data through, returns any error held back until now
+    virtual EStreamError Flush() {
+        return STREAM_ERROR_OK;
+    }
 };
 
+DECLARE_SMARTPTR(IRawStream);
+
 class Stream {
 public:
-    Stream(IRawStream * rawStream);
+    Stream(IRawStreamPtr rawStream);
 
+protected:
+    IRawStreamPtr   m_rawStream;
 };
 
+// Reads and writes in place in blocks lent by the raw stream, so typed 
+//  values only make a virtual call when a block runs out. Unused bytes are
+//  returned on Flush and destruction, which keeps the raw stream's position
+//  exact. Write errors of buffered streams may only show up at Flush.
 class DataStream : public Stream {
 public:
-    DataStream(IRawStream * rawStream);
+    DataStream(IRawStreamPtr rawStream);
+    ~DataStream();
 
     template <typename T>
-    EStreamError Read(T & value, unsigned * bytesRead);
+    EStreamError Read(T & value, unsigned * bytesRead = NULL) {
+        if (m_pos + sizeof(T) > m_readEnd) 
+            return ReadBytes(&value, sizeof(T), bytesRead);
+
+        memcpy(&value, m_readBlock + m_pos, sizeof(T));
+        m_pos += sizeof(T);
+        if (bytesRead != NULL) 
+            *bytesRead = sizeof(T);
+        return STREAM_ERROR_OK;
+    }
 
     template <typename T>
-    EStreamError Write(T value, unsigned * bytesWritten);
+    EStreamError Write(T value, unsigned * bytesWritten = NULL) {
+        if (m_pos + sizeof(T) > m_writeEnd) 
+            return WriteBytes(&value, sizeof(T), bytesWritten);
+
+        memcpy(m_writeBlock + m_pos, &value, sizeof(T));
+        m_pos += sizeof(T);
+        if (bytesWritten != NULL) 
+            *bytesWritten = sizeof(T);
+        return STREAM_ERROR_OK;
+    }
+
+    EStreamError ReadBytes(void * bytes, unsigned count, unsigned * bytesRead = NULL);
+    EStreamError WriteBytes(const void * bytes, unsigned count, unsigned * bytesWritten = NULL);
+    EStreamError Skip(unsigned count);
+    EStreamError Flush();
+
+    // Points at the next count bytes and moves past them when they are 
+    //  contiguous in the lent block, otherwise returns NULL and reads nothing.
+    //  The memory is valid until the next call on the stream.
+    const byte * ReadInPlace(unsigned count);
 
-    EStreamError ReadBytes(void * bytes, unsigned * bytesRead);
-    EStreamError WriteBytes(void * bytes, unsigned * bytesWritten);
+private:
+    DataStream(const DataStream & rhs);
+    DataStream & operator=(const DataStream & rhs);
+
+    void ReturnBlock();
+
+private:
+    const byte    * m_readBlock;
+    byte          * m_writeBlock;
+    unsigned        m_pos;
+    unsigned        m_readEnd;      // Zero unless reading
+    unsigned        m_writeEnd;     // Zero unless writing
+};
+
+// UTF-8 text in a structured stream's own buffer, not null terminated. Only
+//  valid until the stream moves to another node.
+struct StreamTextView {
+    const charsys * str;
+    unsigned        len;
 };
 
 class IStructuredTextStream : public RefCounted {
@@ -89,12 +176,312 @@ public:
         unsigned        len
     ) const = 0;
     virtual EStreamError ReadChildNode() = 0;
+
+    // Reads without copying or converting the text
+    virtual EStreamError ReadNodeNameView(StreamTextView * name) const = 0;
+    virtual EStreamError ReadNodeValueView(StreamTextView * value) const = 0;
+    virtual EStreamError ReadNodeAttributeView(const charsys * name, StreamTextView * value) const = 0;
+
+    // Hashes are HashString32 of the decoded text, so they ignore case. 
+    //  Backends that index their text hash names once as they parse them. 
+    //  Attributes are found by the hash of their name and give the hash of
+    //  their value.
+    virtual EStreamError ReadNodeNameHash(Hash32 * name) const = 0;
+    virtual EStreamError ReadNodeAttributeHash(Hash32 name, Hash32 * value) const = 0;
 };
 
 DECLARE_SMARTPTR(IStructuredTextStream);
 
-IRawStream * StreamOpenFile(const chargr * fileName);
-IRawStream * StreamOpenMemory(void * memory);
+IRawStreamPtr StreamOpenFile(const chargr * fileName);
+IRawStreamPtr StreamOpenFile(const chargr * fileName, unsigned blockSize);
+
+// Keeps reads of the numAhead blocks after the one being read in flight on
+//  the engine, so decoding a block overlaps with reading the ones after it.
+//  Blocks are lent out in place. Files in mounted packs are opened as usual.
+IRawStreamPtr StreamOpenFile(const chargr * fileName, unsigned blockSize, IAsyncIOPtr io, unsigned numAhead);
+IRawStreamPtr StreamCreateFile(const chargr * fileName);
+IRawStreamPtr StreamCreateFile(const chargr * fileName, unsigned blockSize);
+
+// Memory is lent out in place as a single block
+IRawStreamPtr StreamOpenMemory(void * memory, unsigned size);
+
+// Read only streams over mapped files. Each window of the mapping is lent 
+//  out in place, so DataStream reads straight from the file cache. Hints 
+//  are EFileMapHint flags.
+IRawStreamPtr StreamOpenMapped(const chargr * fileName);
+IRawStreamPtr StreamOpenMapped(const chargr * fileName, unsigned hints, unsigned windowSize);
+
+// LZ4 compression over another raw stream, in independently compressed 
+//  blocks. Readers decompress numAhead blocks ahead on a thread of their 
+//  own and writers compress on numThreads threads, zero does the work on the 
+//  calling thread. The decorated stream belongs to the thread doing the work
+//  until the compressed stream is released.
+IRawStreamPtr StreamOpenLZ4(IRawStreamPtr source);
+IRawStreamPtr StreamOpenLZ4(IRawStreamPtr source, unsigned numAhead);
+IRawStreamPtr StreamCreateLZ4(IRawStreamPtr target);
+IRawStreamPtr StreamCreateLZ4(IRawStreamPtr target, unsigned blockSize, unsigned numThreads);
+
+// Decodes a single block in Ext/lz4's format, checking every length and 
+//  offset so damaged data fails rather than reaching past either buffer. 
+//  Matches can reach back into dict as though it came just before raw. 
+//  Fails unless the block decodes to exactly rawSize bytes.
+bool StreamDecodeLZ4(const void * packed, unsigned packedSize, void * raw, unsigned rawSize);
+bool StreamDecodeLZ4(const void * packed, unsigned packedSize, void * raw, unsigned rawSize, const void * dict, unsigned dictSize);
+
+// Stores a CRC32C with each block of another raw stream. Readers check a 
+//  block only when its first byte is read, and fail with 
+//  STREAM_ERROR_BADDATA before handing out any of a block that doesn't 
+//  match, or when the stream ends early. Blocks lent in place by the 
+//  source are checked without a copy.
+IRawStreamPtr StreamOpenChecked(IRawStreamPtr source);
+IRawStreamPtr StreamCreateChecked(IRawStreamPtr target);
+IRawStreamPtr StreamCreateChecked(IRawStreamPtr target, unsigned blockSize);
+
+// LZ4 for many small buffers that share content. Each buffer is a single 
+//  block whose matches can also reach into the dictionary, as though it came
+//  just before the buffer. Compress keeps scratch space and isn't thread 
+//  safe, Decompress is.
+class ILZ4Dictionary : public RefCounted {
+public:
+    virtual ~ILZ4Dictionary() { }
+
+    virtual const byte * GetData() const = 0;
+    virtual unsigned GetSize() const = 0;
+
+    // Packed holds rawSize bytes. Zero when the buffer doesn't get smaller.
+    virtual unsigned Compress(const void * raw, unsigned rawSize, void * packed) = 0;
+
+    // Fails unless the packed data decodes to exactly rawSize bytes
+    virtual bool Decompress(const void * packed, unsigned packedSize, void * raw, unsigned rawSize) const = 0;
+};
+
+DECLARE_SMARTPTR(ILZ4Dictionary);
+
+// Matches reach back at most 64KB
+const unsigned STREAM_LZ4_DICT_MAX_SIZE = 64 * 1024;
+
+// The data is copied
+ILZ4DictionaryPtr StreamCreateLZ4Dictionary(const void * data, unsigned size);
+
+// Trains on samples laid end to end, keeping the stretches with the most 
+//  strings that several samples share. NULL when there's nothing to keep.
+ILZ4DictionaryPtr StreamTrainLZ4Dictionary(const void * samples, const unsigned * sampleSizes, unsigned numSamples);
+ILZ4DictionaryPtr StreamTrainLZ4Dictionary(const void * samples, const unsigned * sampleSizes, unsigned numSamples, unsigned maxSize);
+
 IStructuredTextStreamPtr StreamOpenXML(const chargr * fileName);
 IStructuredTextStreamPtr StreamCreateXML(const chargr * fileName);
 
+// Forward only XML reader that never builds a document. Only the nodes from
+//  the document down to the current one are kept, so memory is bounded by 
+//  the nesting depth instead of the file size. Children are visited once, 
+//  in order, text after a node's first child is ignored, and writes fail.
+IStructuredTextStreamPtr StreamOpenXMLReader(const chargr * fileName);
+IStructuredTextStreamPtr StreamOpenXMLReader(IRawStreamPtr source, const chargr * name);
+
+// Writes nodes straight to the file as they're given, in the layout of 
+//  StreamCreateXML. Only the names of open nodes are kept, so memory stays
+//  constant, and Save just flushes. Attributes go before a node's children
+//  and values, and reads fail.
+IStructuredTextStreamPtr StreamCreateXMLWriter(const chargr * fileName);
+IStructuredTextStreamPtr StreamCreateXMLWriter(IRawStreamPtr target, const chargr * name);
+
+// Reads the whole file into one buffer and parses it there. Names, values 
+//  and attributes are decoded in place and the views lent out point into 
+//  the buffer, so nothing is copied after the load. Nodes are kept as an 
+//  index of the buffer and visited in any order, as with StreamOpenXML.
+//  Buffers given by the caller are parsed in place and have to outlive the
+//  stream. Writes fail.
+IStructuredTextStreamPtr StreamOpenXMLInSitu(const chargr * fileName);
+IStructuredTextStreamPtr StreamOpenXMLInSitu(IRawStreamPtr source, const chargr * name);
+IStructuredTextStreamPtr StreamOpenXMLInSitu(charsys * text, unsigned size, const chargr * name);
+
+// JSON with a node as an object: its name under "#name", its attributes as
+//  members, its value under "#value" and its children in order under 
+//  "#children". The file is an array of the top level nodes, or one node.
+//  Numbers and literals are read as their text.
+// Reading works like StreamOpenXMLInSitu, and finds the structure of the 
+//  file 64 bytes at a time with SSE2 where it's there, in the style of 
+//  simdjson. Writing works like StreamCreateXMLWriter, except values go 
+//  before children as well and Save closes the file.
+IStructuredTextStreamPtr StreamOpenJSON(const chargr * fileName);
+IStructuredTextStreamPtr StreamOpenJSON(IRawStreamPtr source, const chargr * name);
+IStructuredTextStreamPtr StreamOpenJSON(charsys * text, unsigned size, const chargr * name);
+IStructuredTextStreamPtr StreamCreateJSON(const chargr * fileName);
+IStructuredTextStreamPtr StreamCreateJSON(IRawStreamPtr target, const chargr * name);
+
+// Exact match, ignoring the case of ASCII letters
+bool StreamViewEquals(const StreamTextView & view, const charsys * str);
+
+// Decodes into a null terminated string cut short at len - 1 characters, 
+//  and returns the number of characters written
+unsigned StreamViewToCharGr(const StreamTextView & view, chargr * dest, unsigned len);
+
+// Same as HashString32 of the decoded string, see HashUtf8String32
+Hash32 StreamViewHash32(const StreamTextView & view);
+
+//////////////////////////////////////////////////////
+//
+// Packs
+//
+// Many files in one, found by the hash of their normalized path in a table
+//  of contents sorted by hash. Entry data is aligned so views of it start 
+//  on a page, and the pack is mapped so entries are read in place.
+//
+
+enum EPackCompression {
+    PACK_COMPRESSION_NONE,
+    PACK_COMPRESSION_LZ4,       // In the StreamCreateLZ4 format
+    PACK_COMPRESSION_LZ4_DICT,  // A single ILZ4Dictionary block against the pack's dictionary
+};
+
+enum EPackEntryFlags {
+    PACK_ENTRY_CHECKED  = 1 << 0,   // Stored data, after compression, is in the StreamCreateChecked format
+};
+
+// Alignment of entry data unless one is given
+const unsigned PACK_DEFAULT_ALIGNMENT = 4 * 1024;
+
+// The dictionary only helps the start of an entry, so bigger entries are 
+//  compressed as PACK_COMPRESSION_LZ4 instead
+const unsigned PACK_DICT_MAX_ENTRY_SIZE = 256 * 1024;
+
+struct PackEntry {
+    uint64      pathHash;       // StreamHashPath of the path in the pack
+    uint64      offset;         // From the start of the pack
+    uint64      contentHash;    // HashData64 of the uncompressed data
+    uint32      size;           // Stored size
+    uint32      rawSize;        // Uncompressed size
+    uint32      compression;    // EPackCompression
+    uint32      flags;          // EPackEntryFlags
+};
+
+class IPackFile : public RefCounted {
+public:
+    virtual ~IPackFile() { }
+
+    virtual unsigned GetNumEntries() const = 0;
+    virtual const PackEntry * GetEntry(unsigned index) const = 0;
+    virtual const PackEntry * FindEntry(Hash64 pathHash) const = 0;
+
+    // The pack has to outlive the streams opened from it
+    virtual IRawStreamPtr OpenEntry(const PackEntry * entry) = 0;
+
+    // Reads the entry and checks it against its content hash. Entries 
+    //  with PACK_ENTRY_CHECKED are checked block by block as they're read, 
+    //  which is enough for most loads.
+    virtual bool VerifyEntry(const PackEntry * entry) = 0;
+
+    // NULL when the pack was written without one
+    virtual ILZ4DictionaryPtr GetDictionary() const = 0;
+};
+
+DECLARE_SMARTPTR(IPackFile);
+
+class IPackWriter : public RefCounted {
+public:
+    virtual ~IPackWriter() { }
+
+    // Stored once for the whole pack. Set it before adding 
+    //  PACK_COMPRESSION_LZ4_DICT entries, which fall back to 
+    //  PACK_COMPRESSION_LZ4 without one.
+    virtual EStreamError SetDictionary(ILZ4DictionaryPtr dictionary) = 0;
+
+    // Compressed entries that don't get smaller are stored as they are
+    virtual EStreamError AddEntry(
+        const chargr      * path, 
+        const void        * data, 
+        unsigned            size, 
+        EPackCompression    compression
+    ) = 0;
+    virtual EStreamError AddEntry(
+        const chargr      * path, 
+        const void        * data, 
+        unsigned            size, 
+        EPackCompression    compression,
+        unsigned            flags       // EPackEntryFlags
+    ) = 0;
+
+    // Writes the table of contents, also done on release. Two paths that 
+    //  hash the same fail with STREAM_ERROR_BADDATA.
+    virtual EStreamError Close() = 0;
+};
+
+DECLARE_SMARTPTR(IPackWriter);
+
+// Ignores case, separator style, and empty and "." components
+Hash64 StreamHashPath(const chargr * path);
+
+IPackFilePtr StreamOpenPack(const chargr * fileName);
+IPackWriterPtr StreamCreatePack(const chargr * fileName);
+IPackWriterPtr StreamCreatePack(const chargr * fileName, unsigned alignment);
+
+// Files opened for reading by StreamOpenFile, StreamOpenMapped and 
+//  StreamOpenXML are looked for in the mounted packs before the disk, the 
+//  last mounted pack first. Paths below the mount point are looked up 
+//  relative to it, an empty mount point takes paths as they are. Mounting 
+//  isn't thread safe, so packs are mounted before other threads open files.
+bool StreamMountPack(IPackFilePtr pack, const chargr * mountPoint);
+void StreamUnmountPack(IPackFilePtr pack);
+
+// NULL when no mounted pack holds the file. rawSize is the size of the 
+//  data the stream reads.
+IRawStreamPtr StreamOpenPacked(const chargr * fileName);
+IRawStreamPtr StreamOpenPacked(const chargr * fileName, unsigned * rawSize);
+
+//////////////////////////////////////////////////////
+//
+// Chunked files
+//
+// Typed chunks behind a directory at the front of the file, so readers go
+//  straight to the chunks they know and pass over the rest. Chunk data is 
+//  8 byte aligned.
+//
+
+#define STREAM_CHUNK_TYPE(a, b, c, d) \
+    ((uint32) (a) | ((uint32) (b) << 8) | ((uint32) (c) << 16) | ((uint32) (d) << 24))
+
+struct ChunkDesc {
+    uint32      type;           // STREAM_CHUNK_TYPE
+    uint32      version;        // Of the chunk's own format
+    uint64      offset;         // From the start of the file
+    uint64      size;
+};
+
+class IChunkReader : public RefCounted {
+public:
+    virtual ~IChunkReader() { }
+
+    // In file order
+    virtual unsigned GetNumChunks() const = 0;
+    virtual const ChunkDesc * GetChunk(unsigned index) const = 0;
+
+    // The first chunk of the type or NULL
+    virtual const ChunkDesc * FindChunk(uint32 type) const = 0;
+
+    // Readers over streams open chunks in file order, one at a time, and 
+    //  return NULL for chunks they have passed. Mapped readers open any 
+    //  chunk at any time and lend it out in place.
+    virtual IRawStreamPtr OpenChunk(const ChunkDesc * chunk) = 0;
+};
+
+DECLARE_SMARTPTR(IChunkReader);
+
+class IChunkWriter : public RefCounted {
+public:
+    virtual ~IChunkWriter() { }
+
+    // Chunks are buffered and end when their stream is released
+    virtual IRawStreamPtr BeginChunk(uint32 type, uint32 version) = 0;
+
+    // Writes the directory and chunks to the target, also done on release
+    virtual EStreamError Close() = 0;
+};
+
+DECLARE_SMARTPTR(IChunkWriter);
+
+// The file name overload maps the file unless it's in a mounted pack
+IChunkReaderPtr StreamOpenChunked(IRawStreamPtr source);
+IChunkReaderPtr StreamOpenChunked(const chargr * fileName);
+IChunkWriterPtr StreamCreateChunked(IRawStreamPtr target);
+
+
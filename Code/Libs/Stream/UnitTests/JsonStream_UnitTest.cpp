@@ -0,0 +1,374 @@
+/*
+   GameRiff - Framework for creating various video game services
+   Unit tests for json stream service
+   Copyright (C) 2011, Shaun Leach.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are
+   met:
+  
+       * Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+       * Redistributions in binary form must reproduce the above
+   copyright notice, this list of conditions and the following disclaimer
+   in the documentation and/or other materials provided with the
+   distribution.
+  
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include <gtest/gtest.h>
+
+#include "Pch.h"
+#include "TextStream_UnitTest.h"
+
+//====================================================
+TEST(JsonStreamTest, TestReader) {
+    char text[] = 
+        "\xef\xbb\xbf[\n"
+        "    { \"#name\": \"Root\", \"a\": \"1\", \"b\": \"two \\\" \\\\ \\u0041\\u00e9\\ud83d\\ude00\",\n"
+        "      \"#children\": [\n"
+        "        { \"#name\": \"Leaf\", \"#value\": \"some\\ttext {[:,]}\" },\n"
+        "        { \"#name\": \"Empty\", \"#children\": [] },\n"
+        "        { \"#children\": [ { \"#name\": \"Deep\", \"x\": -1.5e3 } ], \"#name\": \"Late\", \"y\": true },\n"
+        "        {\"#name\":\"Tight\",\"#value\":42}\n"
+        "    ] },\n"
+        "    { \"#name\": \"Second\", \"#value\": null }\n"
+        "]\n";
+
+    IStructuredTextStreamPtr stream = StreamOpenJSON(text, sizeof(text) - 1, L"json");
+    ASSERT_TRUE(stream != NULL);
+    EXPECT_EQ(0, StrCmp(L"json", stream->GetName(), 64));
+
+    // Views point into the buffer that was parsed
+    StreamTextView view;
+    EXPECT_EQ(STREAM_ERROR_OK, stream->ReadNodeNameView(&view));
+    ExpectView(view, "Root");
+    EXPECT_EQ(true, view.str > text && view.str < text + sizeof(text));
+    EXPECT_EQ(STREAM_ERROR_OK, stream->ReadNodeAttributeView("b", &view));
+    ExpectView(view, "two \" \\ A\xc3\xa9\xf0\x9f\x98\x80");
+    EXPECT_EQ(STREAM_ERROR_BADDATA, stream->ReadNodeAttributeView("c", &view));
+    EXPECT_EQ(STREAM_ERROR_NODEDOESNTEXIST, stream->ReadNodeValueView(&view));
+
+    chargr value[64];
+    EXPECT_EQ(STREAM_ERROR_OK, stream->ReadNodeAttribute(L"a", 1, value, 64));
+    EXPECT_EQ(0, StrCmp(L"1", value, 64));
+
+    EXPECT_EQ(STREAM_ERROR_OK, stream->ReadChildNode());
+    ExpectName(stream, L"Leaf");
+    ExpectValue(stream, L"some\ttext {[:,]}");
+    EXPECT_EQ(STREAM_ERROR_OK, stream->ReadNextNode());
+    ExpectName(stream, L"Empty");
+    EXPECT_EQ(STREAM_ERROR_NODEDOESNTEXIST, stream->ReadChildNode());
+
+    // Members can come in any order, and numbers and literals are text
+    EXPECT_EQ(STREAM_ERROR_OK, stream->ReadNextNode());
+    ExpectName(stream, L"Late");
+    EXPECT_EQ(STREAM_ERROR_OK, stream->ReadNodeAttributeView("y", &view));
+    ExpectView(view, "true");
+    EXPECT_EQ(STREAM_ERROR_OK, stream->ReadChildNode());
+    ExpectName(stream, L"Deep");
+    EXPECT_EQ(STREAM_ERROR_OK, stream->ReadNodeAttributeView("x", &view));
+    ExpectView(view, "-1.5e3");
+    EXPECT_EQ(STREAM_ERROR_NODEDOESNTEXIST, stream->ReadNextNode());
+    EXPECT_EQ(STREAM_ERROR_OK, stream->ReadParentNode());
+    EXPECT_EQ(STREAM_ERROR_OK, stream->ReadNextNode());
+    ExpectName(stream, L"Tight");
+    ExpectValue(stream, L"42");
+    EXPECT_EQ(STREAM_ERROR_NODEDOESNTEXIST, stream->ReadNextNode());
+
+    EXPECT_EQ(STREAM_ERROR_OK, stream->ReadParentNode());
+    EXPECT_EQ(STREAM_ERROR_OK, stream->ReadNextNode());
+    ExpectName(stream, L"Second");
+    ExpectValue(stream, L"null");
+    EXPECT_EQ(STREAM_ERROR_OK, stream->ReadParentNode());
+    EXPECT_EQ(STREAM_ERROR_NODEDOESNTEXIST, stream->ReadParentNode());
+
+    // A single node doesn't need the array
+    char single[] = "{\"#name\":\"Only\"}";
+    stream = StreamOpenJSON(single, sizeof(single) - 1, L"single");
+    ASSERT_TRUE(stream != NULL);
+    ExpectName(stream, L"Only");
+    EXPECT_EQ(STREAM_ERROR_NODEDOESNTEXIST, stream->ReadNextNode());
+
+    // Malformed files don't open
+    const char * bad[] = {
+        "",
+        "[]",
+        "[{\"a\":\"1\"}]",
+        "[{\"#name\":\"A\"}",
+        "[{\"#name\":\"A\"}] x",
+        "[{\"#name\":\"A\",}]",
+        "[{\"#name\":\"A\" \"b\":\"1\"}]",
+        "[{\"#name\":\"A\",\"b\":{}}]",
+        "[{\"#name\":\"A\",\"#other\":\"1\"}]",
+        "[{\"#name\":\"A\",\"b\":tru}]",
+        "[{\"#name\":\"A\",\"b\":1x}]",
+        "[{\"#name\":\"A\",\"b\":\"\\x\"}]",
+        "[{\"#name\":\"A\",\"b\":\"\\ud83d\"}]",
+        "[{\"#name\":\"A\",\"b\":\"open}]",
+    };
+    for (unsigned i = 0; i < sizeof(bad) / sizeof(bad[0]); i++) {
+        char copy[64];
+        StrCopy(copy, 64, bad[i]);
+        EXPECT_EQ(true, StreamOpenJSON(copy, strlen(copy), L"bad") == NULL) << bad[i];
+    }
+    EXPECT_EQ(true, StreamOpenJSON(L"missing.json") == NULL);
+}
+
+//====================================================
+TEST(JsonStreamTest, TestBlockBoundaries) {
+    // Runs of backslashes and quotes are carried from one 64 byte block to 
+    //  the next, so move them over every position of a boundary
+    for (unsigned pad = 0; pad < 80; pad++) {
+        char text[256];
+        char spaces[128];
+        memset(spaces, ' ', pad);
+        spaces[pad] = 0;
+        StrPrintf(text, 256, 
+            "[%s{\"#name\":\"A\\\\\",\"v\":\"x\\\\\\\\\\\"y\\\\\\\\\",\"w\":12345}]", 
+            spaces
+        );
+
+        IStructuredTextStreamPtr stream = StreamOpenJSON(text, strlen(text), L"boundary");
+        ASSERT_TRUE(stream != NULL) << pad;
+
+        StreamTextView view;
+        EXPECT_EQ(STREAM_ERROR_OK, stream->ReadNodeNameView(&view));
+        ExpectView(view, "A\\");
+        EXPECT_EQ(STREAM_ERROR_OK, stream->ReadNodeAttributeView("v", &view));
+        ExpectView(view, "x\\\\\"y\\\\");
+        EXPECT_EQ(STREAM_ERROR_OK, stream->ReadNodeAttributeView("w", &view));
+        ExpectView(view, "12345");
+    }
+}
+
+//====================================================
+static void WriteTestNodes(IStructuredTextStreamPtr stream) {
+    stream->WriteNode(L"Root");
+    stream->WriteNodeAttribute(L"a", L"1 & <2>");
+    stream->WriteNodeAttribute(L"b", L"say \"hi\"\\");
+    stream->WriteNode(L"Leaf");
+    stream->WriteNodeValue(L"it's\ttext\x01\x00e9");
+    stream->EndNode();
+    stream->WriteNode(L"Empty");
+    stream->EndNode();
+    stream->WriteNode(L"Mixed");
+    stream->WriteNodeValue(L"before");
+    stream->WriteNode(L"Deep");
+    stream->EndNode();
+    stream->EndNode();
+    stream->EndNode();
+    stream->WriteNode(L"Second");
+    stream->EndNode();
+}
+
+//====================================================
+TEST(JsonStreamTest, TestWriter) {
+    IStructuredTextStreamPtr stream = StreamCreateJSON(L"testWriter.json");
+    ASSERT_TRUE(stream != NULL);
+    EXPECT_EQ(0, StrCmp(L"testWriter.json", stream->GetName(), 64));
+    WriteTestNodes(stream);
+    EXPECT_EQ(STREAM_ERROR_OK, stream->Save());
+    stream = NULL;
+
+    const char expected[] = 
+        "[\n"
+        "    { \"#name\": \"Root\", \"a\": \"1 & <2>\", \"b\": \"say \\\"hi\\\"\\\\\", \"#children\": [\n"
+        "        { \"#name\": \"Leaf\", \"#value\": \"it's\\ttext\\u0001\xc3\xa9\" },\n"
+        "        { \"#name\": \"Empty\" },\n"
+        "        { \"#name\": \"Mixed\", \"#value\": \"before\", \"#children\": [\n"
+        "            { \"#name\": \"Deep\" }\n"
+        "        ] }\n"
+        "    ] },\n"
+        "    { \"#name\": \"Second\" }\n"
+        "]\n";
+    char written[512];
+    unsigned size = 0;
+    DataStream file(StreamOpenFile(L"testWriter.json"));
+    file.ReadBytes(written, sizeof(written), &size);
+    EXPECT_EQ(sizeof(expected) - 1, size);
+    EXPECT_EQ(0, memcmp(expected, written, sizeof(expected) - 1));
+
+    stream = StreamOpenJSON(L"testWriter.json");
+    ASSERT_TRUE(stream != NULL);
+    chargr value[64];
+    EXPECT_EQ(STREAM_ERROR_OK, stream->ReadNodeAttribute(L"b", 1, value, 64));
+    EXPECT_EQ(0, StrCmp(L"say \"hi\"\\", value, 64));
+    EXPECT_EQ(STREAM_ERROR_OK, stream->ReadChildNode());
+    ExpectValue(stream, L"it's\ttext\x01\x00e9");
+    EXPECT_EQ(STREAM_ERROR_OK, stream->ReadNextNode());
+    EXPECT_EQ(STREAM_ERROR_OK, stream->ReadNextNode());
+    ExpectValue(stream, L"before");
+    EXPECT_EQ(STREAM_ERROR_OK, stream->ReadChildNode());
+    ExpectName(stream, L"Deep");
+
+    // Nothing can be added once the file is closed
+    stream = StreamCreateJSON(L"testWriterEmpty.json");
+    EXPECT_EQ(STREAM_ERROR_OK, stream->Save());
+    EXPECT_EQ(STREAM_ERROR_BADDATA, stream->WriteNodeAttribute(L"a", L"b"));
+}
+
+//====================================================
+TEST(JsonStreamTest, TestNameHashes) {
+    WriteText(L"testNameHashes.json", 
+        "[{ \"#name\": \"Root\", \"#children\": [\n"
+        "    { \"#name\": \"DataMember\", \"Name\": \"member & \\u003c1>\", \"Type\": \"uint32\", \"#value\": \"7\" }\n"
+        "] }]\n"
+    );
+
+    IStructuredTextStreamPtr stream = StreamOpenJSON(L"testNameHashes.json");
+    ASSERT_TRUE(stream != NULL);
+    Hash32 hash;
+    EXPECT_EQ(STREAM_ERROR_OK, stream->ReadNodeNameHash(&hash));
+    EXPECT_EQ(HashString32(L"root"), hash);
+    EXPECT_EQ(STREAM_ERROR_OK, stream->ReadChildNode());
+    EXPECT_EQ(STREAM_ERROR_OK, stream->ReadNodeNameHash(&hash));
+    EXPECT_EQ(HashString32(L"DataMember"), hash);
+    EXPECT_EQ(STREAM_ERROR_OK, stream->ReadNodeAttributeHash(HashString32(L"Name"), &hash));
+    EXPECT_EQ(HashString32(L"member & <1>"), hash);
+    EXPECT_EQ(STREAM_ERROR_OK, stream->ReadNodeAttributeHash(HashString32(L"TYPE"), &hash));
+    EXPECT_EQ(HashString32(L"uint32"), hash);
+    EXPECT_EQ(STREAM_ERROR_BADDATA, stream->ReadNodeAttributeHash(HashString32(L"Version"), &hash));
+}
+
+//====================================================
+// Visits every node the way reflection loads do and sums what it read
+static unsigned WalkNodes(IStructuredTextStreamPtr stream) {
+    unsigned sum = 0;
+    do {
+        chargr text[256];
+        chargr name[64];
+        stream->ReadNodeName(name, 64);
+        sum += name[0];
+        if (stream->ReadNodeAttribute(L"Name", 4, text, 256) == STREAM_ERROR_OK) 
+            sum += text[0] + text[6];
+        if (StrCmp(name, L"DataMember", 10) == 0) {
+            stream->ReadNodeValue(text, 256);
+            sum += text[0];
+        }
+        else if (stream->ReadChildNode() == STREAM_ERROR_OK) 
+            sum += WalkNodes(stream);
+        sum++;
+    } while (stream->ReadNextNode() != STREAM_ERROR_NODEDOESNTEXIST);
+
+    stream->ReadParentNode();
+    return sum;
+}
+
+//====================================================
+// Same as WalkNodes with hashes and views instead of converted text
+static unsigned WalkNodeHashes(IStructuredTextStreamPtr stream) {
+    static const Hash32 s_dataMember(HashString32(L"DataMember"));
+    static const Hash32 s_name(HashString32(L"Name"));
+
+    unsigned sum = 0;
+    do {
+        Hash32 hash;
+        StreamTextView text;
+        stream->ReadNodeNameHash(&hash);
+        stream->ReadNodeNameView(&text);
+        sum += text.str[0];
+        if (stream->ReadNodeAttributeView("Name", &text) == STREAM_ERROR_OK) 
+            sum += text.str[0] + (text.len > 6 ? text.str[6] : 0);
+        if (hash == s_dataMember) {
+            stream->ReadNodeValueView(&text);
+            sum += text.len > 0 ? text.str[0] : 0;
+        }
+        else if (stream->ReadChildNode() == STREAM_ERROR_OK) 
+            sum += WalkNodeHashes(stream);
+        sum++;
+    } while (stream->ReadNextNode() != STREAM_ERROR_NODEDOESNTEXIST);
+
+    stream->ReadParentNode();
+    return sum;
+}
+
+//====================================================
+static void WriteBenchmarkNodes(IStructuredTextStreamPtr stream, unsigned numClasses) {
+    stream->WriteNode(L"Objects");
+    for (unsigned i = 0; i < numClasses; i++) {
+        stream->WriteNode(L"Class");
+        stream->WriteNodeAttribute(L"Type", L"BenchmarkClass");
+        stream->WriteNodeAttribute(L"Version", L"1");
+        for (unsigned j = 0; j < 20; j++) {
+            chargr name[32];
+            chargr value[32];
+            StrPrintf(name, 32, L"member%u", j);
+            StrPrintf(value, 32, L"%u", i * j);
+            stream->WriteNode(L"DataMember");
+            stream->WriteNodeAttribute(L"Name", name);
+            stream->WriteNodeAttribute(L"Type", L"uint32");
+            stream->WriteNodeValue(value);
+            stream->EndNode();
+        }
+        stream->EndNode();
+    }
+    stream->EndNode();
+    EXPECT_EQ(STREAM_ERROR_OK, stream->Save());
+}
+
+//====================================================
+TEST(JsonStreamTest, TestReadersAgree) {
+    WriteBenchmarkNodes(StreamCreateXML(L"testJsonAgree.xml"), 20);
+    WriteBenchmarkNodes(StreamCreateJSON(L"testJsonAgree.json"), 20);
+
+    IStructuredTextStreamPtr document = StreamOpenXML(L"testJsonAgree.xml");
+    IStructuredTextStreamPtr json     = StreamOpenJSON(L"testJsonAgree.json");
+    IStructuredTextStreamPtr hashes   = StreamOpenJSON(L"testJsonAgree.json");
+    ASSERT_TRUE(document != NULL && json != NULL && hashes != NULL);
+    unsigned documentSum = WalkNodes(document);
+    EXPECT_EQ(documentSum, WalkNodes(json));
+    EXPECT_EQ(documentSum, WalkNodeHashes(hashes));
+}
+
+//====================================================
+// Disabled, run with --gtest_also_run_disabled_tests
+TEST(JsonStreamTest, DISABLED_TestReaderBenchmark) {
+    WriteBenchmarkNodes(StreamCreateXML(L"testJsonBenchmark.xml"), 2000);
+    WriteBenchmarkNodes(StreamCreateJSON(L"testJsonBenchmark.json"), 2000);
+
+    uint64 start = TimerGetTicks();
+    unsigned documentSum = 0;
+    {
+        IStructuredTextStreamPtr stream = StreamOpenXML(L"testJsonBenchmark.xml");
+        ASSERT_TRUE(stream != NULL);
+        documentSum = WalkNodes(stream);
+    }
+    uint64 documentTicks = TimerGetTicks() - start;
+
+    start = TimerGetTicks();
+    unsigned jsonSum = 0;
+    {
+        IStructuredTextStreamPtr stream = StreamOpenJSON(L"testJsonBenchmark.json");
+        ASSERT_TRUE(stream != NULL);
+        jsonSum = WalkNodes(stream);
+    }
+    uint64 jsonTicks = TimerGetTicks() - start;
+    EXPECT_EQ(documentSum, jsonSum);
+
+    start = TimerGetTicks();
+    unsigned hashSum = 0;
+    {
+        IStructuredTextStreamPtr stream = StreamOpenJSON(L"testJsonBenchmark.json");
+        ASSERT_TRUE(stream != NULL);
+        hashSum = WalkNodeHashes(stream);
+    }
+    uint64 hashTicks = TimerGetTicks() - start;
+    EXPECT_EQ(documentSum, hashSum);
+
+    RecordProperty("documentUs", static_cast<int>(TimerTicksToNanoseconds(documentTicks) / 1000));
+    RecordProperty("jsonUs", static_cast<int>(TimerTicksToNanoseconds(jsonTicks) / 1000));
+    RecordProperty("jsonViewsUs", static_cast<int>(TimerTicksToNanoseconds(hashTicks) / 1000));
+}
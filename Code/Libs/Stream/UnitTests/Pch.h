@@ -29,6 +29,8 @@
 
 #pragma once
 
+#include <string.h>
+
 #define USES_LIBS_STREAM
 
 #include "Core.h"
@@ -28,10 +28,1350 @@
 */
 
 #include <gtest/gtest.h>
+#include <windows.h>
 
 #include "Pch.h"
 
 TEST(StreamTest, TestOpen) {
+    IRawStreamPtr rawStream = StreamOpenFile(L"missingStream.bin");
+    EXPECT_EQ(true, rawStream == NULL);
 }
 
+//====================================================
+TEST(StreamTest, TestMemoryStream) {
+    byte memory[8];
+    DataStream writeStream(StreamOpenMemory(memory, sizeof(memory)));
+    EXPECT_EQ(STREAM_ERROR_OK, writeStream.Write<uint32>(0xdeadbeef));
+    EXPECT_EQ(STREAM_ERROR_OK, writeStream.Write<uint16>(0x1234));
 
+    unsigned bytesWritten = 0;
+    EXPECT_EQ(STREAM_ERROR_EOF, writeStream.Write<uint32>(0x5678, &bytesWritten));
+    EXPECT_EQ(2, bytesWritten);
+
+    DataStream readStream(StreamOpenMemory(memory, sizeof(memory)));
+    uint32 value32 = 0;
+    uint16 value16 = 0;
+    EXPECT_EQ(STREAM_ERROR_OK, readStream.Read(value32));
+    EXPECT_EQ(0xdeadbeef, value32);
+    EXPECT_EQ(STREAM_ERROR_OK, readStream.Read(value16));
+    EXPECT_EQ(0x1234, value16);
+    EXPECT_EQ(STREAM_ERROR_OK, readStream.Skip(2));
+    EXPECT_EQ(STREAM_ERROR_EOF, readStream.Read(value16));
+}
+
+//====================================================
+TEST(StreamTest, TestFileStream) {
+    {
+        IRawStreamPtr rawStream = StreamCreateFile(L"testStream.bin");
+        ASSERT_TRUE(rawStream != NULL);
+        DataStream stream(rawStream);
+        EXPECT_EQ(STREAM_ERROR_OK, stream.Write<uint64>(0x0123456789abcdefULL));
+        EXPECT_EQ(STREAM_ERROR_OK, stream.Write<float32>(32.32f));
+    }
+
+    IRawStreamPtr rawStream = StreamOpenFile(L"testStream.bin");
+    ASSERT_TRUE(rawStream != NULL);
+    DataStream stream(rawStream);
+
+    uint64  value64 = 0;
+    float32 valueFloat = 0.0f;
+    EXPECT_EQ(STREAM_ERROR_OK, stream.Read(value64));
+    EXPECT_EQ(0x0123456789abcdefULL, value64);
+    EXPECT_EQ(STREAM_ERROR_OK, stream.Read(valueFloat));
+    EXPECT_EQ(32.32f, valueFloat);
+    EXPECT_EQ(STREAM_ERROR_EOF, stream.Read(valueFloat));
+}
+
+
+
+//====================================================
+static void WriteMixed(const chargr * fileName, unsigned blockSize, const uint32 * bulk, unsigned bulkCount) {
+    IRawStreamPtr rawStream = StreamCreateFile(fileName, blockSize);
+    ASSERT_TRUE(rawStream != NULL);
+    DataStream stream(rawStream);
+    for (unsigned i = 0; i < 100; i++) {
+        EXPECT_EQ(STREAM_ERROR_OK, stream.Write<uint8>(static_cast<uint8>(i)));
+        EXPECT_EQ(STREAM_ERROR_OK, stream.Write<uint32>(i * 0x01010101));
+    }
+    EXPECT_EQ(STREAM_ERROR_OK, stream.WriteBytes(bulk, bulkCount * sizeof(uint32)));
+    EXPECT_EQ(STREAM_ERROR_OK, stream.Write<uint64>(0x0123456789abcdefULL));
+    EXPECT_EQ(STREAM_ERROR_OK, stream.Flush());
+}
+
+//====================================================
+static void ReadMixed(const chargr * fileName, unsigned blockSize, const uint32 * bulk, unsigned bulkCount) {
+    IRawStreamPtr rawStream = StreamOpenFile(fileName, blockSize);
+    ASSERT_TRUE(rawStream != NULL);
+    DataStream stream(rawStream);
+    for (unsigned i = 0; i < 100; i++) {
+        uint8   value8 = 0;
+        uint32  value32 = 0;
+        EXPECT_EQ(STREAM_ERROR_OK, stream.Read(value8));
+        EXPECT_EQ(i, value8);
+        EXPECT_EQ(STREAM_ERROR_OK, stream.Read(value32));
+        EXPECT_EQ(i * 0x01010101, value32);
+    }
+
+    uint32 * read = new uint32[bulkCount];
+    EXPECT_EQ(STREAM_ERROR_OK, stream.ReadBytes(read, bulkCount * sizeof(uint32)));
+    EXPECT_EQ(0, memcmp(bulk, read, bulkCount * sizeof(uint32)));
+    delete [] read;
+
+    uint64 value64 = 0;
+    EXPECT_EQ(STREAM_ERROR_OK, stream.Read(value64));
+    EXPECT_EQ(0x0123456789abcdefULL, value64);
+
+    unsigned bytesRead = 1;
+    EXPECT_EQ(STREAM_ERROR_EOF, stream.Read(value64, &bytesRead));
+    EXPECT_EQ(0, bytesRead);
+}
+
+//====================================================
+TEST(StreamTest, TestBufferedFileStream) {
+    const unsigned bulkCount = 5000;
+    uint32 * bulk = new uint32[bulkCount];
+    for (unsigned i = 0; i < bulkCount; i++) 
+        bulk[i] = i * 2654435761U;
+
+    // Blocks smaller than a value, smaller than the bulk data and the default
+    const unsigned blockSizes[] = { 3, 16, 4096, STREAM_DEFAULT_BLOCK_SIZE };
+    for (unsigned i = 0; i < sizeof(blockSizes) / sizeof(blockSizes[0]); i++) {
+        WriteMixed(L"testBufferedStream.bin", blockSizes[i], bulk, bulkCount);
+        ReadMixed(L"testBufferedStream.bin", blockSizes[i], bulk, bulkCount);
+        ReadMixed(L"testBufferedStream.bin", blockSizes[(i + 1) % 4], bulk, bulkCount);
+    }
+
+    delete [] bulk;
+}
+
+//====================================================
+TEST(StreamTest, TestBufferedHandOff) {
+    byte memory[16];
+    IRawStreamPtr rawStream = StreamOpenMemory(memory, sizeof(memory));
+    {
+        DataStream stream(rawStream);
+        EXPECT_EQ(STREAM_ERROR_OK, stream.Write<uint32>(1));
+    }
+    {
+        // The first stream gave back the rest of its block
+        DataStream stream(rawStream);
+        EXPECT_EQ(STREAM_ERROR_OK, stream.Write<uint32>(2));
+    }
+
+    {
+        IRawStreamPtr fileStream = StreamCreateFile(L"testHandOff.bin", 64);
+        ASSERT_TRUE(fileStream != NULL);
+        DataStream first(fileStream);
+        EXPECT_EQ(STREAM_ERROR_OK, first.Write<uint16>(0x1234));
+        EXPECT_EQ(STREAM_ERROR_OK, first.Flush());
+        DataStream second(fileStream);
+        EXPECT_EQ(STREAM_ERROR_OK, second.Write<uint16>(0x5678));
+    }
+
+    IRawStreamPtr fileStream = StreamOpenFile(L"testHandOff.bin", 64);
+    ASSERT_TRUE(fileStream != NULL);
+    uint16 value = 0;
+    {
+        DataStream stream(fileStream);
+        EXPECT_EQ(STREAM_ERROR_OK, stream.Read(value));
+        EXPECT_EQ(0x1234, value);
+    }
+
+    DataStream stream(fileStream);
+    EXPECT_EQ(STREAM_ERROR_OK, stream.Read(value));
+    EXPECT_EQ(0x5678, value);
+
+    DataStream memoryStream(StreamOpenMemory(memory, sizeof(memory)));
+    uint32 value32 = 0;
+    EXPECT_EQ(STREAM_ERROR_OK, memoryStream.Read(value32));
+    EXPECT_EQ(1, value32);
+    EXPECT_EQ(STREAM_ERROR_OK, memoryStream.Read(value32));
+    EXPECT_EQ(2, value32);
+}
+
+//====================================================
+TEST(StreamTest, TestMemoryStreamModes) {
+    byte memory[12];
+    DataStream stream(StreamOpenMemory(memory, sizeof(memory)));
+    EXPECT_EQ(STREAM_ERROR_OK, stream.Write<uint32>(0xdeadbeef));
+
+    // Switching to reads gives back the rest of the write block
+    uint32 value = 0;
+    EXPECT_EQ(STREAM_ERROR_OK, stream.Read(value));
+    EXPECT_EQ(STREAM_ERROR_OK, stream.Write<uint32>(0xfeedface));
+    EXPECT_EQ(STREAM_ERROR_EOF, stream.Read(value));
+
+    uint32 * values = reinterpret_cast<uint32 *>(memory);
+    EXPECT_EQ(0xdeadbeef, values[0]);
+    EXPECT_EQ(0xfeedface, values[2]);
+}
+
+//====================================================
+// Throughput of small typed values and bulk copies. Timings are recorded as
+//  test properties. Benchmarks are disabled, run them with 
+//  --gtest_also_run_disabled_tests.
+static const unsigned s_benchmarkValues = 1024 * 1024;
+
+//====================================================
+TEST(StreamTest, DISABLED_TestStreamBenchmark) {
+    const unsigned size = s_benchmarkValues * sizeof(uint32);
+    byte * memory = new byte[size];
+    uint32 * bulk = new uint32[s_benchmarkValues];
+    for (unsigned i = 0; i < s_benchmarkValues; i++) 
+        bulk[i] = i;
+
+    uint64 start = TimerGetTicks();
+    {
+        DataStream stream(StreamOpenMemory(memory, size));
+        for (unsigned i = 0; i < s_benchmarkValues; i++) 
+            stream.Write<uint32>(i);
+    }
+    uint64 memoryWriteTicks = TimerGetTicks() - start;
+
+    uint32 sum = 0;
+    start = TimerGetTicks();
+    {
+        DataStream stream(StreamOpenMemory(memory, size));
+        uint32 value = 0;
+        for (unsigned i = 0; i < s_benchmarkValues; i++) {
+            stream.Read(value);
+            sum += value;
+        }
+    }
+    uint64 memoryReadTicks = TimerGetTicks() - start;
+
+    start = TimerGetTicks();
+    {
+        DataStream stream(StreamCreateFile(L"testBenchmark.bin"));
+        for (unsigned i = 0; i < s_benchmarkValues; i++) 
+            stream.Write<uint32>(i);
+        EXPECT_EQ(STREAM_ERROR_OK, stream.Flush());
+    }
+    uint64 fileWriteTicks = TimerGetTicks() - start;
+
+    start = TimerGetTicks();
+    {
+        DataStream stream(StreamOpenFile(L"testBenchmark.bin"));
+        uint32 value = 0;
+        for (unsigned i = 0; i < s_benchmarkValues; i++) {
+            stream.Read(value);
+            sum -= value;
+        }
+    }
+    uint64 fileReadTicks = TimerGetTicks() - start;
+    EXPECT_EQ(0, sum);
+
+    start = TimerGetTicks();
+    {
+        DataStream stream(StreamOpenFile(L"testBenchmark.bin"));
+        EXPECT_EQ(STREAM_ERROR_OK, stream.ReadBytes(memory, size));
+    }
+    uint64 bulkReadTicks = TimerGetTicks() - start;
+    EXPECT_EQ(0, memcmp(memory, bulk, size));
+
+    RecordProperty("memoryWriteUs", static_cast<int>(TimerTicksToNanoseconds(memoryWriteTicks) / 1000));
+    RecordProperty("memoryReadUs", static_cast<int>(TimerTicksToNanoseconds(memoryReadTicks) / 1000));
+    RecordProperty("fileWriteUs", static_cast<int>(TimerTicksToNanoseconds(fileWriteTicks) / 1000));
+    RecordProperty("fileReadUs", static_cast<int>(TimerTicksToNanoseconds(fileReadTicks) / 1000));
+    RecordProperty("bulkReadUs", static_cast<int>(TimerTicksToNanoseconds(bulkReadTicks) / 1000));
+
+    delete [] bulk;
+    delete [] memory;
+}
+
+//====================================================
+TEST(StreamTest, TestMappedStream) {
+    EXPECT_EQ(true, StreamOpenMapped(L"missingStream.bin") == NULL);
+
+    const unsigned count = 10000;
+    {
+        DataStream stream(StreamCreateFile(L"testMapped.bin"));
+        for (unsigned i = 0; i < count; i++) 
+            EXPECT_EQ(STREAM_ERROR_OK, stream.Write<uint32>(i));
+    }
+
+    // Windows that split values and aren't aligned to anything
+    const unsigned windowSizes[] = { 7, 1000, STREAM_DEFAULT_MAP_WINDOW };
+    for (unsigned window = 0; window < sizeof(windowSizes) / sizeof(windowSizes[0]); window++) {
+        IRawStreamPtr rawStream = StreamOpenMapped(L"testMapped.bin", FILE_MAP_HINT_SEQUENTIAL, windowSizes[window]);
+        ASSERT_TRUE(rawStream != NULL);
+        DataStream stream(rawStream);
+        for (unsigned i = 0; i < count / 2; i++) {
+            uint32 value = 0;
+            EXPECT_EQ(STREAM_ERROR_OK, stream.Read(value));
+            EXPECT_EQ(i, value);
+        }
+
+        uint32 rest[count / 2];
+        EXPECT_EQ(STREAM_ERROR_OK, stream.ReadBytes(rest, sizeof(rest)));
+        EXPECT_EQ(count / 2, rest[0]);
+        EXPECT_EQ(count - 1, rest[count / 2 - 1]);
+
+        uint32 value = 0;
+        EXPECT_EQ(STREAM_ERROR_EOF, stream.Read(value));
+    }
+}
+
+//====================================================
+TEST(StreamTest, TestMappedViews) {
+    {
+        DataStream stream(StreamCreateFile(L"testMapped.bin"));
+        for (unsigned i = 0; i < 1000; i++) 
+            stream.Write<uint32>(i);
+    }
+
+    EFileResult result;
+    IMappedFilePtr file = FileOpenMapped(L"testMapped.bin", FILE_MAP_HINT_RANDOM, &result);
+    ASSERT_EQ(FILE_RESULT_OK, result);
+    EXPECT_EQ(4000, file->GetSize());
+
+    // Views need no alignment and are cut short at the end of the file
+    IFileViewPtr view = file->MapView(401 * sizeof(uint32), 10 * sizeof(uint32));
+    ASSERT_TRUE(view != NULL);
+    EXPECT_EQ(401 * sizeof(uint32), view->GetOffset());
+    EXPECT_EQ(10 * sizeof(uint32), view->GetSize());
+    uint32 value = 0;
+    memcpy(&value, view->GetData(), sizeof(value));
+    EXPECT_EQ(401, value);
+
+    view = file->MapView(3998, 100);
+    ASSERT_TRUE(view != NULL);
+    EXPECT_EQ(2, view->GetSize());
+    EXPECT_EQ(true, file->MapView(4000, 1) == NULL);
+
+    // Values inside a window are read without a copy
+    DataStream stream(StreamOpenMapped(L"testMapped.bin"));
+    const byte * bytes = stream.ReadInPlace(8 * sizeof(uint32));
+    ASSERT_TRUE(bytes != NULL);
+    memcpy(&value, bytes + 7 * sizeof(uint32), sizeof(value));
+    EXPECT_EQ(7, value);
+    EXPECT_EQ(STREAM_ERROR_OK, stream.Read(value));
+    EXPECT_EQ(8, value);
+    EXPECT_EQ(true, stream.ReadInPlace(4000) == NULL);
+    EXPECT_EQ(STREAM_ERROR_OK, stream.Read(value));
+    EXPECT_EQ(9, value);
+}
+
+//====================================================
+// Writes a value at the offset into an otherwise empty sparse file, so the 
+//  file can pass 4GB without the test writing gigabytes. Fails on file 
+//  systems without sparse files.
+static bool CreateSparseFile(const chargr * filename, uint64 offset, uint32 value) {
+    HANDLE file = CreateFileW(filename, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) 
+        return false;
+
+    LARGE_INTEGER position;
+    position.QuadPart = static_cast<long long>(offset);
+    DWORD bytes = 0;
+    bool result = DeviceIoControl(file, FSCTL_SET_SPARSE, NULL, 0, NULL, 0, &bytes, NULL)
+        && SetFilePointerEx(file, position, NULL, FILE_BEGIN)
+        && WriteFile(file, &value, sizeof(value), &bytes, NULL)
+        && bytes == sizeof(value);
+    CloseHandle(file);
+    return result;
+}
+
+//====================================================
+TEST(StreamTest, TestMappedViewsPast4GB) {
+    // Past 4GB and off the allocation granularity
+    const uint64 offset = (5ull << 30) + 3;
+    if (!CreateSparseFile(L"testMappedLarge.bin", offset, 0xdeadbeef)) {
+        DeleteFileW(L"testMappedLarge.bin");
+        return;
+    }
+
+    {
+        EFileResult result;
+        IMappedFilePtr file = FileOpenMapped(L"testMappedLarge.bin", FILE_MAP_HINT_RANDOM, &result);
+        ASSERT_EQ(FILE_RESULT_OK, result);
+        EXPECT_EQ(offset + sizeof(uint32), file->GetSize());
+
+        IFileViewPtr view = file->MapView(offset, 100);
+        ASSERT_TRUE(view != NULL);
+        EXPECT_EQ(offset, view->GetOffset());
+        EXPECT_EQ(sizeof(uint32), view->GetSize());
+        uint32 value = 0;
+        memcpy(&value, view->GetData(), sizeof(value));
+        EXPECT_EQ(0xdeadbeef, value);
+
+        // The aligned view can't pass 4GB, so the size is cut by the skip
+        if (sizeof(void *) == 8) {
+            view = file->MapView(3, 0xffffffff);
+            ASSERT_TRUE(view != NULL);
+            EXPECT_EQ(3, view->GetOffset());
+            EXPECT_EQ(0xffffffff - 3, view->GetSize());
+        }
+    }
+    DeleteFileW(L"testMappedLarge.bin");
+}
+
+//====================================================
+// Records that look like cooked assets: small counters, quantized floats 
+//  and repeated ids, with a stretch of noise that doesn't compress
+static void FillAssetData(uint32 * data, unsigned count) {
+    uint32 noise = 0x12345678;
+    for (unsigned i = 0; i < count; i++) {
+        noise = noise * 1664525 + 1013904223;
+        if (i % 4096 < 256) 
+            data[i] = noise;
+        else if (i % 4 == 0) 
+            data[i] = i / 4;
+        else if (i % 4 == 1) 
+            data[i] = 0x3f800000 + (noise >> 28);
+        else
+            data[i] = (i / 64) % 7;
+    }
+}
+
+//====================================================
+TEST(StreamTest, TestLZ4Stream) {
+    const unsigned count = 50000;
+    uint32 * data = new uint32[count];
+    FillAssetData(data, count);
+
+    EXPECT_EQ(true, StreamOpenLZ4(StreamOpenFile(L"missingStream.bin")) == NULL);
+    EXPECT_EQ(true, StreamOpenLZ4(StreamOpenFile(L"testBufferedStream.bin")) == NULL);
+
+    // Inline and threaded, with blocks that split values
+    const unsigned numThreads[] = { 0, 3 };
+    const unsigned numAhead[]   = { 0, 2 };
+    for (unsigned i = 0; i < 2; i++) {
+        {
+            DataStream stream(StreamCreateLZ4(StreamCreateFile(L"testLZ4.bin"), 1001, numThreads[i]));
+            EXPECT_EQ(STREAM_ERROR_OK, stream.Write<uint8>(0xab));
+            EXPECT_EQ(STREAM_ERROR_OK, stream.WriteBytes(data, count * sizeof(uint32)));
+            for (unsigned j = 0; j < 1000; j++) 
+                EXPECT_EQ(STREAM_ERROR_OK, stream.Write<uint32>(j));
+        }
+
+        for (unsigned j = 0; j < 2; j++) {
+            DataStream stream(StreamOpenLZ4(StreamOpenFile(L"testLZ4.bin"), numAhead[j]));
+            uint8 value8 = 0;
+            EXPECT_EQ(STREAM_ERROR_OK, stream.Read(value8));
+            EXPECT_EQ(0xab, value8);
+
+            uint32 * read = new uint32[count];
+            EXPECT_EQ(STREAM_ERROR_OK, stream.ReadBytes(read, count * sizeof(uint32)));
+            EXPECT_EQ(0, memcmp(data, read, count * sizeof(uint32)));
+            delete [] read;
+
+            uint32 value = 0;
+            for (unsigned k = 0; k < 1000; k++) {
+                EXPECT_EQ(STREAM_ERROR_OK, stream.Read(value));
+                EXPECT_EQ(k, value);
+            }
+            EXPECT_EQ(STREAM_ERROR_EOF, stream.Read(value));
+        }
+    }
+
+    // Releasing a reader while its thread is still decoding
+    {
+        DataStream stream(StreamOpenLZ4(StreamOpenFile(L"testLZ4.bin"), 2));
+        uint8 value8 = 0;
+        EXPECT_EQ(STREAM_ERROR_OK, stream.Read(value8));
+    }
+
+    // Asset like data at the default block size at least halves
+    {
+        DataStream stream(StreamCreateLZ4(StreamCreateFile(L"testLZ4.bin"), STREAM_LZ4_BLOCK_SIZE, 0));
+        EXPECT_EQ(STREAM_ERROR_OK, stream.WriteBytes(data, count * sizeof(uint32)));
+    }
+    EFileResult result;
+    IMappedFilePtr file = FileOpenMapped(L"testLZ4.bin", FILE_MAP_HINT_NONE, &result);
+    ASSERT_TRUE(file != NULL);
+    EXPECT_LT(file->GetSize() * 2, count * sizeof(uint32));
+
+    delete [] data;
+}
+
+//====================================================
+TEST(StreamTest, TestLZ4StreamCorrupt) {
+    const unsigned count = 20000;
+    uint32 * data = new uint32[count];
+    FillAssetData(data, count);
+    {
+        DataStream stream(StreamCreateLZ4(StreamCreateFile(L"testLZ4Corrupt.bin"), 1001, 0));
+        EXPECT_EQ(STREAM_ERROR_OK, stream.WriteBytes(data, count * sizeof(uint32)));
+    }
+
+    EFileResult result;
+    IMappedFilePtr file = FileOpenMapped(L"testLZ4Corrupt.bin", FILE_MAP_HINT_SEQUENTIAL, &result);
+    ASSERT_EQ(FILE_RESULT_OK, result);
+    IFileViewPtr view = file->MapView(0, static_cast<unsigned>(file->GetSize()));
+    ASSERT_TRUE(view != NULL);
+
+    const unsigned size = view->GetSize();
+    byte * packed = new byte[size];
+    uint32 * read = new uint32[count];
+
+    // Damaged blocks must fail cleanly, wherever the damage lands
+    for (unsigned pos = 12; pos < size; pos += 37) {
+        memcpy(packed, view->GetData(), size);
+        packed[pos] ^= static_cast<byte>(pos | 0x81);
+        DataStream stream(StreamOpenLZ4(StreamOpenMemory(packed, size), 0));
+        stream.ReadBytes(read, count * sizeof(uint32));
+    }
+
+    // Truncated streams run out before the data does, the last cut lands
+    //  inside the final block
+    const unsigned cuts[] = { 13, size / 3, size - sizeof(uint32) * 2 - 1 };
+    for (unsigned i = 0; i < sizeof(cuts) / sizeof(cuts[0]); i++) {
+        memcpy(packed, view->GetData(), size);
+        DataStream stream(StreamOpenLZ4(StreamOpenMemory(packed, cuts[i]), 0));
+        EXPECT_NE(STREAM_ERROR_OK, stream.ReadBytes(read, count * sizeof(uint32)));
+    }
+
+    delete [] read;
+    delete [] packed;
+    delete [] data;
+}
+
+//====================================================
+// Compression ratio and throughput, recorded as test properties
+static const unsigned s_lz4BenchmarkValues = 8 * 1024 * 1024;
+
+//====================================================
+TEST(StreamTest, DISABLED_TestLZ4Benchmark) {
+    const unsigned size = s_lz4BenchmarkValues * sizeof(uint32);
+    uint32 * data = new uint32[s_lz4BenchmarkValues];
+    uint32 * read = new uint32[s_lz4BenchmarkValues];
+    FillAssetData(data, s_lz4BenchmarkValues);
+
+    uint64 start = TimerGetTicks();
+    {
+        DataStream stream(StreamCreateLZ4(StreamCreateFile(L"testLZ4Benchmark.bin"), STREAM_LZ4_BLOCK_SIZE, 0));
+        EXPECT_EQ(STREAM_ERROR_OK, stream.WriteBytes(data, size));
+    }
+    uint64 compressTicks = TimerGetTicks() - start;
+
+    start = TimerGetTicks();
+    {
+        DataStream stream(StreamCreateLZ4(StreamCreateFile(L"testLZ4Benchmark.bin")));
+        EXPECT_EQ(STREAM_ERROR_OK, stream.WriteBytes(data, size));
+    }
+    uint64 parallelTicks = TimerGetTicks() - start;
+
+    start = TimerGetTicks();
+    {
+        DataStream stream(StreamOpenLZ4(StreamOpenFile(L"testLZ4Benchmark.bin"), 0));
+        EXPECT_EQ(STREAM_ERROR_OK, stream.ReadBytes(read, size));
+    }
+    uint64 decompressTicks = TimerGetTicks() - start;
+    EXPECT_EQ(0, memcmp(data, read, size));
+
+    memset(read, 0, size);
+    start = TimerGetTicks();
+    {
+        DataStream stream(StreamOpenLZ4(StreamOpenFile(L"testLZ4Benchmark.bin")));
+        EXPECT_EQ(STREAM_ERROR_OK, stream.ReadBytes(read, size));
+    }
+    uint64 aheadTicks = TimerGetTicks() - start;
+    EXPECT_EQ(0, memcmp(data, read, size));
+
+    EFileResult result;
+    IMappedFilePtr file = FileOpenMapped(L"testLZ4Benchmark.bin", FILE_MAP_HINT_NONE, &result);
+    ASSERT_TRUE(file != NULL);
+    uint64 packedSize = file->GetSize();
+    EXPECT_LT(packedSize * 2, size);
+
+    RecordProperty("ratioPercent", static_cast<int>(size * 100ULL / packedSize));
+    RecordProperty("compressMBs", static_cast<int>(size * 1000ULL / TimerTicksToNanoseconds(compressTicks)));
+    RecordProperty("parallelCompressMBs", static_cast<int>(size * 1000ULL / TimerTicksToNanoseconds(parallelTicks)));
+    RecordProperty("decompressMBs", static_cast<int>(size * 1000ULL / TimerTicksToNanoseconds(decompressTicks)));
+    RecordProperty("aheadDecompressMBs", static_cast<int>(size * 1000ULL / TimerTicksToNanoseconds(aheadTicks)));
+
+    delete [] read;
+    delete [] data;
+}
+
+//====================================================
+// Objects that look like small reflected assets. Objects of a class share 
+//  the names, types and default values of their members, and a quarter of 
+//  the members are changed in each. Within one object few names repeat, so
+//  most of what they have in common is with other objects.
+static const char * s_reflectedPrefixes[] = {
+    "Render", "Physics", "Audio", "Anim", "Script", "Light", "Nav", "Network", 
+};
+
+static const char * s_reflectedSuffixes[] = {
+    "Mass", "Scale", "Offset", "Radius", "Priority", "Layer", "Flags", "Target", 
+    "Speed", "Delay", "Volume", "Color", "Range", "Weight", "Resource", "Parent", 
+};
+
+//====================================================
+static unsigned FillReflectedObject(byte * data, uint32 seed) {
+    const unsigned numPrefixes = sizeof(s_reflectedPrefixes) / sizeof(s_reflectedPrefixes[0]);
+    const unsigned numSuffixes = sizeof(s_reflectedSuffixes) / sizeof(s_reflectedSuffixes[0]);
+    uint32 classId  = seed % 5;
+    uint32 noise    = seed * 2654435761U + 1;
+    unsigned size   = 1024 + seed * 7919 % 3072;
+
+    uint32 header[] = { 0x4c464552, 3, classId, seed };
+    memcpy(data, header, sizeof(header));
+    unsigned used = sizeof(header);
+    for (uint32 member = 0; used + 64 <= size; member++) {
+        uint32 layout = (classId * 131 + member) * 2654435761U;
+        char name[32];
+        sprintf(name, "%s%s%u", s_reflectedPrefixes[(layout >> 8) % numPrefixes], s_reflectedSuffixes[(layout >> 16) % numSuffixes], member);
+        uint16 len = static_cast<uint16>(strlen(name));
+        memcpy(data + used, &len, sizeof(len));
+        memcpy(data + used + sizeof(len), name, len);
+        used += sizeof(len) + len;
+
+        // Most members keep their class's default
+        noise = noise * 1664525 + 1013904223;
+        uint32 value[3] = { 0x3f800000 + ((layout >> 4) & 7) * 0x100000, (layout >> 12) & 15, seed };
+        if ((noise >> 30) == 0) {
+            value[0] = 0x3f800000 + (noise >> 12);
+            value[1] = noise >> 24;
+        }
+        data[used++] = static_cast<byte>(layout >> 30);
+        memcpy(data + used, value, sizeof(value));
+        used += (layout >> 30) < 3 ? 8 : 12;
+    }
+
+    return used;
+}
+
+//====================================================
+TEST(StreamTest, TestLZ4Dictionary) {
+    const unsigned numObjects = 600;
+    byte * objects = new byte[numObjects * 4096];
+    unsigned sizes[numObjects];
+    unsigned total = 0;
+    for (unsigned i = 0; i < numObjects; i++) {
+        sizes[i]    = FillReflectedObject(objects + total, i);
+        total      += sizes[i];
+    }
+
+    EXPECT_EQ(true, StreamCreateLZ4Dictionary(objects, STREAM_LZ4_DICT_MAX_SIZE + 1) == NULL);
+    EXPECT_EQ(true, StreamTrainLZ4Dictionary(objects, sizes, 0) == NULL);
+
+    // Trained on the first objects, used on the rest
+    unsigned trained = 0;
+    for (unsigned i = 0; i < 500; i++) 
+        trained += sizes[i];
+    ILZ4DictionaryPtr dictionary = StreamTrainLZ4Dictionary(objects, sizes, 500, 8 * 1024);
+    ASSERT_TRUE(dictionary != NULL);
+    EXPECT_LT(0, dictionary->GetSize());
+    EXPECT_GE(8 * 1024, dictionary->GetSize());
+
+    ILZ4DictionaryPtr empty = StreamCreateLZ4Dictionary(NULL, 0);
+    ASSERT_TRUE(empty != NULL);
+
+    byte packed[4096];
+    byte raw[4096];
+    const byte * object = objects + trained;
+    for (unsigned i = 500; i < numObjects; i++) {
+        unsigned packedSize = dictionary->Compress(object, sizes[i], packed);
+        ASSERT_LT(0, packedSize);
+        EXPECT_LT(packedSize * 2, sizes[i]);
+        EXPECT_LT(packedSize, empty->Compress(object, sizes[i], raw));
+
+        memset(raw, 0, sizeof(raw));
+        EXPECT_EQ(true, dictionary->Decompress(packed, packedSize, raw, sizes[i]));
+        EXPECT_EQ(0, memcmp(object, raw, sizes[i]));
+        EXPECT_EQ(false, dictionary->Decompress(packed, packedSize, raw, sizes[i] - 1));
+        EXPECT_EQ(false, dictionary->Decompress(packed, packedSize, raw, sizes[i] + 1));
+        EXPECT_EQ(false, dictionary->Decompress(packed, packedSize - 1, raw, sizes[i]));
+        EXPECT_EQ(false, empty->Decompress(packed, packedSize, raw, sizes[i]));
+
+        // Damaged blocks fail or decode to the wrong bytes, but stay in bounds
+        packed[i % packedSize] ^= 0x5a;
+        dictionary->Decompress(packed, packedSize, raw, sizes[i]);
+        object += sizes[i];
+    }
+
+    // Matches that start in the dictionary and run on into the data
+    byte pattern[100];
+    for (unsigned i = 0; i < sizeof(pattern); i++) 
+        pattern[i] = static_cast<byte>(i * 37);
+    for (unsigned i = 0; i < sizeof(raw); i++) 
+        raw[i] = pattern[i % sizeof(pattern)];
+    ILZ4DictionaryPtr repeated = StreamCreateLZ4Dictionary(pattern, sizeof(pattern));
+    unsigned packedSize = repeated->Compress(raw, sizeof(raw), packed);
+    EXPECT_LT(0, packedSize);
+    EXPECT_GT(32, packedSize);
+    byte decoded[4096];
+    EXPECT_EQ(true, repeated->Decompress(packed, packedSize, decoded, sizeof(decoded)));
+    EXPECT_EQ(0, memcmp(raw, decoded, sizeof(raw)));
+
+    // Nothing to gain from data that doesn't repeat, or from tiny buffers
+    uint32 noise = 1;
+    for (unsigned i = 0; i < sizeof(raw); i++) {
+        noise  = noise * 1664525 + 1013904223;
+        raw[i] = static_cast<byte>(noise >> 24);
+    }
+    EXPECT_EQ(0, empty->Compress(raw, sizeof(raw), packed));
+    EXPECT_EQ(0, dictionary->Compress(objects, 12, packed));
+
+    delete [] objects;
+}
+
+//====================================================
+TEST(StreamTest, TestAheadStream) {
+    const unsigned count = 50000;
+    uint32 * data = new uint32[count];
+    uint32 * read = new uint32[count];
+    FillAssetData(data, count);
+    {
+        DataStream stream(StreamCreateFile(L"testAhead.bin"));
+        EXPECT_EQ(STREAM_ERROR_OK, stream.Write<uint8>(0xab));
+        EXPECT_EQ(STREAM_ERROR_OK, stream.WriteBytes(data, count * sizeof(uint32)));
+    }
+    {
+        DataStream stream(StreamCreateFile(L"testAheadEmpty.bin"));
+    }
+
+    // Both backends, with blocks that split values and no blocks ahead
+    const EAsyncIOBackend backends[] = { ASYNC_IO_BACKEND_THREADS, ASYNC_IO_BACKEND_NATIVE };
+    const unsigned numAhead[] = { 0, 1, 4 };
+    for (unsigned i = 0; i < 2; i++) {
+        IAsyncIOPtr io = AsyncIOCreate(backends[i], 2, 4);
+        ASSERT_TRUE(io != NULL);
+        EXPECT_EQ(true, StreamOpenFile(L"missingStream.bin", 1001, io, 2) == NULL);
+
+        for (unsigned j = 0; j < 3; j++) {
+            DataStream stream(StreamOpenFile(L"testAhead.bin", 1001, io, numAhead[j]));
+            uint8 value8 = 0;
+            EXPECT_EQ(STREAM_ERROR_OK, stream.Read(value8));
+            EXPECT_EQ(0xab, value8);
+
+            const byte * inPlace = stream.ReadInPlace(500);
+            ASSERT_TRUE(inPlace != NULL);
+            EXPECT_EQ(0, memcmp(data, inPlace, 500));
+
+            memset(read, 0, count * sizeof(uint32));
+            EXPECT_EQ(STREAM_ERROR_OK, stream.ReadBytes(read, count * sizeof(uint32) - 500));
+            EXPECT_EQ(0, memcmp(reinterpret_cast<byte *>(data) + 500, read, count * sizeof(uint32) - 500));
+            EXPECT_EQ(STREAM_ERROR_EOF, stream.Read(value8));
+        }
+
+        // Released partway, with reads still in flight
+        {
+            DataStream stream(StreamOpenFile(L"testAhead.bin", 1001, io, 8));
+            EXPECT_EQ(STREAM_ERROR_OK, stream.ReadBytes(read, 3000));
+        }
+        {
+            DataStream stream(StreamOpenFile(L"testAheadEmpty.bin", 1001, io, 2));
+            uint8 value8 = 0;
+            EXPECT_EQ(STREAM_ERROR_EOF, stream.Read(value8));
+        }
+    }
+
+    delete [] read;
+    delete [] data;
+}
+
+//====================================================
+// Reading a file while decoding each block, with and without reading ahead,
+//  recorded as test properties. Hashing stands in for the decoding.
+static const unsigned s_aheadBenchmarkValues = 8 * 1024 * 1024;
+
+//====================================================
+static uint64 DecodeStream(IRawStreamPtr rawStream) {
+    DataStream stream(rawStream);
+    uint64 hash = 0;
+    const byte * block = NULL;
+    while ((block = stream.ReadInPlace(STREAM_DEFAULT_BLOCK_SIZE)) != NULL) {
+        for (unsigned pass = 0; pass < 4; pass++) 
+            hash ^= HashData64(block, STREAM_DEFAULT_BLOCK_SIZE).GetValue();
+    }
+    return hash;
+}
+
+//====================================================
+TEST(StreamTest, DISABLED_TestAheadBenchmark) {
+    const unsigned size = s_aheadBenchmarkValues * sizeof(uint32);
+    uint32 * data = new uint32[s_aheadBenchmarkValues];
+    FillAssetData(data, s_aheadBenchmarkValues);
+    {
+        DataStream stream(StreamCreateFile(L"testAheadBenchmark.bin"));
+        EXPECT_EQ(STREAM_ERROR_OK, stream.WriteBytes(data, size));
+    }
+    delete [] data;
+
+    uint64 start = TimerGetTicks();
+    uint64 hash = DecodeStream(StreamOpenFile(L"testAheadBenchmark.bin"));
+    uint64 syncTicks = TimerGetTicks() - start;
+
+    IAsyncIOPtr io = AsyncIOCreate();
+    ASSERT_TRUE(io != NULL);
+    start = TimerGetTicks();
+    EXPECT_EQ(hash, DecodeStream(StreamOpenFile(L"testAheadBenchmark.bin", STREAM_DEFAULT_BLOCK_SIZE, io, 4)));
+    uint64 aheadTicks = TimerGetTicks() - start;
+
+    RecordProperty("syncMBs", static_cast<int>(size * 1000ULL / TimerTicksToNanoseconds(syncTicks)));
+    RecordProperty("aheadMBs", static_cast<int>(size * 1000ULL / TimerTicksToNanoseconds(aheadTicks)));
+}
+
+//====================================================
+TEST(StreamTest, TestCheckedStream) {
+    const unsigned count        = 5000;
+    const unsigned blockSize    = 1000;
+    const unsigned size         = count * sizeof(uint32);
+    const unsigned numBlocks    = size / blockSize;
+    const unsigned storedSize   = 16 + numBlocks * (8 + blockSize) + 8;
+    uint32 * data = new uint32[count];
+    FillAssetData(data, count);
+
+    EXPECT_EQ(true, StreamOpenChecked(StreamOpenFile(L"missingStream.bin")) == NULL);
+    EXPECT_EQ(true, StreamOpenChecked(StreamOpenFile(L"testBufferedStream.bin")) == NULL);
+
+    // Files split blocks across their buffers, so these are copied out
+    {
+        DataStream stream(StreamCreateChecked(StreamCreateFile(L"testChecked.bin"), blockSize));
+        EXPECT_EQ(STREAM_ERROR_OK, stream.Write<uint8>(0xab));
+        EXPECT_EQ(STREAM_ERROR_OK, stream.WriteBytes(data, size));
+    }
+    {
+        DataStream stream(StreamOpenChecked(StreamOpenFile(L"testChecked.bin")));
+        uint8 value8 = 0;
+        EXPECT_EQ(STREAM_ERROR_OK, stream.Read(value8));
+        EXPECT_EQ(0xab, value8);
+
+        uint32 * read = new uint32[count];
+        EXPECT_EQ(STREAM_ERROR_OK, stream.ReadBytes(read, size));
+        EXPECT_EQ(0, memcmp(data, read, size));
+        delete [] read;
+        EXPECT_EQ(STREAM_ERROR_EOF, stream.Read(value8));
+    }
+
+    // Memory is checked in place
+    byte * stored = new byte[storedSize];
+    {
+        DataStream stream(StreamCreateChecked(StreamOpenMemory(stored, storedSize), blockSize));
+        EXPECT_EQ(STREAM_ERROR_OK, stream.WriteBytes(data, size));
+    }
+    {
+        DataStream stream(StreamOpenChecked(StreamOpenMemory(stored, storedSize)));
+        const byte * block = stream.ReadInPlace(blockSize);
+        ASSERT_TRUE(block != NULL);
+        EXPECT_EQ(0, memcmp(data, block, blockSize));
+
+        uint32 * read = new uint32[count];
+        EXPECT_EQ(STREAM_ERROR_OK, stream.ReadBytes(read, size - blockSize));
+        EXPECT_EQ(0, memcmp(reinterpret_cast<byte *>(data) + blockSize, read, size - blockSize));
+        delete [] read;
+        uint8 value8 = 0;
+        EXPECT_EQ(STREAM_ERROR_EOF, stream.Read(value8));
+    }
+
+    // A bad byte fails its block without touching the ones before it, both
+    //  in place and read straight into the caller's memory
+    byte * read = new byte[size];
+    stored[16 + 5 * (8 + blockSize) + 8 + 10] ^= 0x20;
+    {
+        DataStream stream(StreamCreateFile(L"testCheckedBad.bin"));
+        EXPECT_EQ(STREAM_ERROR_OK, stream.WriteBytes(stored, storedSize));
+    }
+    IRawStreamPtr sources[] = { StreamOpenMemory(stored, storedSize), StreamOpenFile(L"testCheckedBad.bin") };
+    for (unsigned i = 0; i < 2; i++) {
+        IRawStreamPtr stream = StreamOpenChecked(sources[i]);
+        ASSERT_TRUE(stream != NULL);
+        unsigned bytesRead = 0;
+        EXPECT_EQ(STREAM_ERROR_OK, stream->ReadBytes(read, 5 * blockSize, &bytesRead));
+        EXPECT_EQ(5 * blockSize, bytesRead);
+        EXPECT_EQ(0, memcmp(data, read, 5 * blockSize));
+        EXPECT_EQ(STREAM_ERROR_BADDATA, stream->ReadBytes(read, blockSize, &bytesRead));
+        EXPECT_EQ(0, bytesRead);
+        EXPECT_EQ(STREAM_ERROR_BADDATA, stream->ReadBytes(read, 1, &bytesRead));
+    }
+    sources[1] = IRawStreamPtr(NULL);
+    stored[16 + 5 * (8 + blockSize) + 8 + 10] ^= 0x20;
+
+    // Cut short inside a block, between blocks, and missing a whole block
+    const unsigned cuts[] = { 16 + 10 * (8 + blockSize) + 500, 16 + 10 * (8 + blockSize), storedSize - 8 - blockSize };
+    memmove(stored + 16 + 10 * (8 + blockSize), stored + 16 + 11 * (8 + blockSize), storedSize - 16 - 11 * (8 + blockSize));
+    for (unsigned i = 0; i < sizeof(cuts) / sizeof(cuts[0]); i++) {
+        IRawStreamPtr stream = StreamOpenChecked(StreamOpenMemory(stored, cuts[i]));
+        ASSERT_TRUE(stream != NULL);
+        unsigned bytesRead = 0;
+        EXPECT_EQ(STREAM_ERROR_BADDATA, stream->ReadBytes(read, size, &bytesRead));
+        EXPECT_EQ(i < 2 ? 10 * blockSize : size - blockSize, bytesRead);
+        EXPECT_EQ(0, memcmp(data, read, bytesRead < 10 * blockSize ? bytesRead : 10 * blockSize));
+    }
+
+    delete [] read;
+    delete [] stored;
+    delete [] data;
+}
+
+//====================================================
+// Cost of checking as a share of plain reads from memory and from a file,
+//  recorded as test properties
+static const unsigned s_checkedBenchmarkValues = 8 * 1024 * 1024;
+
+//====================================================
+TEST(StreamTest, DISABLED_TestCheckedBenchmark) {
+    const unsigned size = s_checkedBenchmarkValues * sizeof(uint32);
+    const unsigned storedSize = size + 16 + (size / STREAM_CHECKED_BLOCK_SIZE + 1) * 8;
+    uint32 * data = new uint32[s_checkedBenchmarkValues];
+    uint32 * read = new uint32[s_checkedBenchmarkValues];
+    byte * stored = new byte[storedSize];
+    FillAssetData(data, s_checkedBenchmarkValues);
+
+    {
+        DataStream stream(StreamCreateFile(L"testPlainBenchmark.bin"));
+        EXPECT_EQ(STREAM_ERROR_OK, stream.WriteBytes(data, size));
+    }
+    {
+        DataStream stream(StreamCreateChecked(StreamCreateFile(L"testCheckedBenchmark.bin")));
+        EXPECT_EQ(STREAM_ERROR_OK, stream.WriteBytes(data, size));
+    }
+    {
+        DataStream stream(StreamCreateChecked(StreamOpenMemory(stored, storedSize)));
+        EXPECT_EQ(STREAM_ERROR_OK, stream.WriteBytes(data, size));
+    }
+
+    memset(read, 0, size);
+    uint64 start = TimerGetTicks();
+    {
+        DataStream stream(StreamOpenMemory(data, size));
+        EXPECT_EQ(STREAM_ERROR_OK, stream.ReadBytes(read, size));
+    }
+    uint64 memoryTicks = TimerGetTicks() - start;
+
+    memset(read, 0, size);
+    start = TimerGetTicks();
+    {
+        DataStream stream(StreamOpenChecked(StreamOpenMemory(stored, storedSize)));
+        EXPECT_EQ(STREAM_ERROR_OK, stream.ReadBytes(read, size));
+    }
+    uint64 checkedMemoryTicks = TimerGetTicks() - start;
+    EXPECT_EQ(0, memcmp(data, read, size));
+
+    start = TimerGetTicks();
+    {
+        DataStream stream(StreamOpenFile(L"testPlainBenchmark.bin"));
+        EXPECT_EQ(STREAM_ERROR_OK, stream.ReadBytes(read, size));
+    }
+    uint64 fileTicks = TimerGetTicks() - start;
+
+    memset(read, 0, size);
+    start = TimerGetTicks();
+    {
+        DataStream stream(StreamOpenChecked(StreamOpenFile(L"testCheckedBenchmark.bin")));
+        EXPECT_EQ(STREAM_ERROR_OK, stream.ReadBytes(read, size));
+    }
+    uint64 checkedFileTicks = TimerGetTicks() - start;
+    EXPECT_EQ(0, memcmp(data, read, size));
+
+    start = TimerGetTicks();
+    uint32 crc = HashCrc32c(data, size);
+    uint64 crcTicks = TimerGetTicks() - start;
+    EXPECT_NE(0, crc);
+
+    RecordProperty("crcMBs", static_cast<int>(size * 1000ULL / TimerTicksToNanoseconds(crcTicks)));
+    RecordProperty("memoryReadUs", static_cast<int>(TimerTicksToNanoseconds(memoryTicks) / 1000));
+    RecordProperty("checkedMemoryReadUs", static_cast<int>(TimerTicksToNanoseconds(checkedMemoryTicks) / 1000));
+    RecordProperty("fileReadUs", static_cast<int>(TimerTicksToNanoseconds(fileTicks) / 1000));
+    RecordProperty("checkedFileReadUs", static_cast<int>(TimerTicksToNanoseconds(checkedFileTicks) / 1000));
+
+    delete [] stored;
+    delete [] read;
+    delete [] data;
+}
+
+//====================================================
+TEST(StreamTest, TestPackFile) {
+    const unsigned count = 20000;
+    uint32 * data = new uint32[count];
+    FillAssetData(data, count);
+    const char * xml = "<?xml version=\"1.0\" ?><Root value=\"7\" />";
+
+    EXPECT_EQ(true, StreamOpenPack(L"missingStream.bin") == NULL);
+    EXPECT_EQ(true, StreamOpenPack(L"testBufferedStream.bin") == NULL);
+    EXPECT_EQ(StreamHashPath(L"Dir/Sub/File.bin"), StreamHashPath(L"./dir\\\\sub/other/../file.BIN"));
+
+    {
+        IPackWriterPtr writer = StreamCreatePack(L"testPack.pack", 64);
+        ASSERT_TRUE(writer != NULL);
+        EXPECT_EQ(STREAM_ERROR_OK, writer->AddEntry(L"data/raw.bin", data, count * sizeof(uint32), PACK_COMPRESSION_NONE));
+        EXPECT_EQ(STREAM_ERROR_OK, writer->AddEntry(L"data/packed.bin", data, count * sizeof(uint32), PACK_COMPRESSION_LZ4));
+        EXPECT_EQ(STREAM_ERROR_OK, writer->AddEntry(L"data/tiny.bin", data, 3, PACK_COMPRESSION_LZ4));
+        EXPECT_EQ(STREAM_ERROR_OK, writer->AddEntry(L"data/empty.bin", NULL, 0, PACK_COMPRESSION_NONE));
+        EXPECT_EQ(STREAM_ERROR_OK, writer->AddEntry(L"test.xml", xml, strlen(xml), PACK_COMPRESSION_LZ4));
+        EXPECT_EQ(STREAM_ERROR_OK, writer->AddEntry(L"checked/raw.bin", data, count * sizeof(uint32), PACK_COMPRESSION_NONE, PACK_ENTRY_CHECKED));
+        EXPECT_EQ(STREAM_ERROR_OK, writer->AddEntry(L"checked/packed.bin", data, count * sizeof(uint32), PACK_COMPRESSION_LZ4, PACK_ENTRY_CHECKED));
+
+        // Plain LZ4 until there's a dictionary
+        EXPECT_EQ(STREAM_ERROR_OK, writer->AddEntry(L"dict/early.bin", data, 2048, PACK_COMPRESSION_LZ4_DICT));
+        EXPECT_EQ(STREAM_ERROR_OK, writer->SetDictionary(StreamCreateLZ4Dictionary(data, 4096)));
+        EXPECT_EQ(STREAM_ERROR_OK, writer->AddEntry(L"dict/packed.bin", data, 2048, PACK_COMPRESSION_LZ4_DICT));
+        EXPECT_EQ(STREAM_ERROR_OK, writer->AddEntry(L"dict/checked.bin", data, 2048, PACK_COMPRESSION_LZ4_DICT, PACK_ENTRY_CHECKED));
+        EXPECT_EQ(STREAM_ERROR_OK, writer->Close());
+    }
+
+    {
+        IPackWriterPtr writer = StreamCreatePack(L"testPackDuplicate.pack");
+        writer->AddEntry(L"a.bin", data, 4, PACK_COMPRESSION_NONE);
+        writer->AddEntry(L"A.bin", data, 4, PACK_COMPRESSION_NONE);
+        EXPECT_EQ(STREAM_ERROR_BADDATA, writer->Close());
+    }
+
+    IPackFilePtr pack = StreamOpenPack(L"testPack.pack");
+    ASSERT_TRUE(pack != NULL);
+    EXPECT_EQ(10, pack->GetNumEntries());
+    EXPECT_EQ(true, pack->FindEntry(StreamHashPath(L"data/missing.bin")) == NULL);
+
+    const PackEntry * raw    = pack->FindEntry(StreamHashPath(L"data/raw.bin"));
+    const PackEntry * packed = pack->FindEntry(StreamHashPath(L"DATA/Packed.bin"));
+    const PackEntry * tiny   = pack->FindEntry(StreamHashPath(L"data/tiny.bin"));
+    ASSERT_TRUE(raw != NULL && packed != NULL && tiny != NULL);
+    EXPECT_EQ(0, raw->offset % 64);
+    EXPECT_EQ(PACK_COMPRESSION_NONE, raw->compression);
+    EXPECT_EQ(PACK_COMPRESSION_LZ4, packed->compression);
+    EXPECT_LT(packed->size, packed->rawSize);
+    EXPECT_EQ(PACK_COMPRESSION_NONE, tiny->compression);
+    EXPECT_EQ(0, packed->flags);
+    for (unsigned i = 0; i < pack->GetNumEntries(); i++) 
+        EXPECT_EQ(true, pack->VerifyEntry(pack->GetEntry(i)));
+
+    const PackEntry * checked[] = {
+        pack->FindEntry(StreamHashPath(L"checked/raw.bin")),
+        pack->FindEntry(StreamHashPath(L"checked/packed.bin")),
+    };
+    ASSERT_TRUE(checked[0] != NULL && checked[1] != NULL);
+    EXPECT_EQ(PACK_ENTRY_CHECKED, checked[0]->flags);
+    EXPECT_EQ(PACK_COMPRESSION_NONE, checked[0]->compression);
+    EXPECT_GT(checked[0]->size, checked[0]->rawSize);
+    EXPECT_EQ(PACK_COMPRESSION_LZ4, checked[1]->compression);
+    EXPECT_LT(checked[1]->size, checked[1]->rawSize);
+
+    uint32 * read = new uint32[count];
+    const PackEntry * streamed[] = { packed, checked[0], checked[1] };
+    for (unsigned i = 0; i < 3; i++) {
+        memset(read, 0, count * sizeof(uint32));
+        DataStream stream(pack->OpenEntry(streamed[i]));
+        EXPECT_EQ(STREAM_ERROR_OK, stream.ReadBytes(read, count * sizeof(uint32)));
+        EXPECT_EQ(0, memcmp(data, read, count * sizeof(uint32)));
+        uint8 value = 0;
+        EXPECT_EQ(STREAM_ERROR_EOF, stream.Read(value));
+    }
+
+    ILZ4DictionaryPtr dictionary = pack->GetDictionary();
+    ASSERT_TRUE(dictionary != NULL);
+    EXPECT_EQ(4096, dictionary->GetSize());
+
+    const PackEntry * dict[] = {
+        pack->FindEntry(StreamHashPath(L"dict/early.bin")),
+        pack->FindEntry(StreamHashPath(L"dict/packed.bin")),
+        pack->FindEntry(StreamHashPath(L"dict/checked.bin")),
+    };
+    ASSERT_TRUE(dict[0] != NULL && dict[1] != NULL && dict[2] != NULL);
+    EXPECT_EQ(PACK_COMPRESSION_LZ4, dict[0]->compression);
+    EXPECT_EQ(PACK_COMPRESSION_LZ4_DICT, dict[1]->compression);
+    EXPECT_EQ(PACK_COMPRESSION_LZ4_DICT, dict[2]->compression);
+    EXPECT_EQ(PACK_ENTRY_CHECKED, dict[2]->flags);
+    EXPECT_GT(64, dict[1]->size);
+    for (unsigned i = 0; i < 3; i++) {
+        memset(read, 0, 2048);
+        DataStream stream(pack->OpenEntry(dict[i]));
+        EXPECT_EQ(STREAM_ERROR_OK, stream.ReadBytes(read, 2048));
+        EXPECT_EQ(0, memcmp(data, read, 2048));
+        uint8 value = 0;
+        EXPECT_EQ(STREAM_ERROR_EOF, stream.Read(value));
+    }
+
+    // Mounted packs are found before the disk, below their mount point
+    EXPECT_EQ(true, StreamOpenPacked(L"content/data/raw.bin") == NULL);
+    EXPECT_EQ(true, StreamMountPack(pack, L"content/"));
+    EXPECT_EQ(true, StreamOpenPacked(L"data/raw.bin") == NULL);
+    EXPECT_EQ(true, StreamOpenFile(L"content/data/missing.bin") == NULL);
+    {
+        memset(read, 0, count * sizeof(uint32));
+        DataStream stream(StreamOpenFile(L"Content\\data\\raw.bin"));
+        EXPECT_EQ(STREAM_ERROR_OK, stream.ReadBytes(read, count * sizeof(uint32)));
+        EXPECT_EQ(0, memcmp(data, read, count * sizeof(uint32)));
+    }
+    {
+        memset(read, 0, count * sizeof(uint32));
+        DataStream stream(StreamOpenMapped(L"content/data/packed.bin"));
+        EXPECT_EQ(STREAM_ERROR_OK, stream.ReadBytes(read, count * sizeof(uint32)));
+        EXPECT_EQ(0, memcmp(data, read, count * sizeof(uint32)));
+    }
+    {
+        unsigned rawSize = 1;
+        IRawStreamPtr stream = StreamOpenPacked(L"content/data/empty.bin", &rawSize);
+        ASSERT_TRUE(stream != NULL);
+        EXPECT_EQ(0, rawSize);
+    }
+    {
+        IStructuredTextStreamPtr stream = StreamOpenXML(L"content/test.xml");
+        ASSERT_TRUE(stream != NULL);
+        chargr value[16];
+        EXPECT_EQ(STREAM_ERROR_OK, stream->ReadNodeAttribute(L"value", 6, value, 16));
+        EXPECT_EQ(0, StrCmp(value, L"7", 16));
+    }
+
+    StreamUnmountPack(pack);
+    EXPECT_EQ(true, StreamOpenFile(L"content/data/raw.bin") == NULL);
+
+    delete [] read;
+    delete [] data;
+}
+
+//====================================================
+// Opening many small files loose and from a mounted pack, recorded as 
+//  test properties
+static const unsigned s_packBenchmarkFiles = 1000;
+
+//====================================================
+TEST(StreamTest, DISABLED_TestPackBenchmark) {
+    const unsigned size = 2048;
+    uint32 data[size / sizeof(uint32)];
+    FillAssetData(data, size / sizeof(uint32));
+
+    FileCreateDirectory(L"testPackFiles");
+    {
+        IPackWriterPtr writer = StreamCreatePack(L"testPackBenchmark.pack");
+        for (unsigned i = 0; i < s_packBenchmarkFiles; i++) {
+            chargr path[FILE_PATH_LENGTH];
+            StrPrintf(path, FILE_PATH_LENGTH, L"testPackFiles/file%u.bin", i);
+            data[0] = i;
+            DataStream stream(StreamCreateFile(path));
+            EXPECT_EQ(STREAM_ERROR_OK, stream.WriteBytes(data, size));
+            EXPECT_EQ(STREAM_ERROR_OK, writer->AddEntry(path, data, size, PACK_COMPRESSION_NONE));
+        }
+        EXPECT_EQ(STREAM_ERROR_OK, writer->Close());
+    }
+
+    uint32 read[size / sizeof(uint32)];
+    uint64 start = TimerGetTicks();
+    for (unsigned i = 0; i < s_packBenchmarkFiles; i++) {
+        chargr path[FILE_PATH_LENGTH];
+        StrPrintf(path, FILE_PATH_LENGTH, L"testPackFiles/file%u.bin", i);
+        DataStream stream(StreamOpenFile(path));
+        EXPECT_EQ(STREAM_ERROR_OK, stream.ReadBytes(read, size));
+        EXPECT_EQ(i, read[0]);
+    }
+    uint64 looseTicks = TimerGetTicks() - start;
+
+    start = TimerGetTicks();
+    IPackFilePtr pack = StreamOpenPack(L"testPackBenchmark.pack");
+    ASSERT_TRUE(pack != NULL);
+    StreamMountPack(pack, L"");
+    uint64 mountTicks = TimerGetTicks() - start;
+
+    start = TimerGetTicks();
+    for (unsigned i = 0; i < s_packBenchmarkFiles; i++) {
+        chargr path[FILE_PATH_LENGTH];
+        StrPrintf(path, FILE_PATH_LENGTH, L"testPackFiles/file%u.bin", i);
+        DataStream stream(StreamOpenFile(path));
+        EXPECT_EQ(STREAM_ERROR_OK, stream.ReadBytes(read, size));
+        EXPECT_EQ(i, read[0]);
+    }
+    uint64 packedTicks = TimerGetTicks() - start;
+
+    start = TimerGetTicks();
+    unsigned found = 0;
+    for (unsigned i = 0; i < s_packBenchmarkFiles; i++) {
+        chargr path[FILE_PATH_LENGTH];
+        StrPrintf(path, FILE_PATH_LENGTH, L"testPackFiles/file%u.bin", i);
+        if (pack->FindEntry(StreamHashPath(path)) != NULL) 
+            found++;
+    }
+    uint64 lookupTicks = TimerGetTicks() - start;
+    EXPECT_EQ(s_packBenchmarkFiles, found);
+
+    StreamUnmountPack(pack);
+
+    RecordProperty("looseOpenNs", static_cast<int>(TimerTicksToNanoseconds(looseTicks) / s_packBenchmarkFiles));
+    RecordProperty("packedOpenNs", static_cast<int>(TimerTicksToNanoseconds(packedTicks) / s_packBenchmarkFiles));
+    RecordProperty("lookupNs", static_cast<int>(TimerTicksToNanoseconds(lookupTicks) / s_packBenchmarkFiles));
+    RecordProperty("mountUs", static_cast<int>(TimerTicksToNanoseconds(mountTicks) / 1000));
+}
+
+//====================================================
+// Many small reflected objects packed with plain LZ4 per entry and against 
+//  a trained dictionary, recorded as test properties
+static const unsigned s_dictBenchmarkObjects = 4000;
+
+//====================================================
+static uint64 ReadPackEntries(IPackFilePtr pack, byte * read) {
+    uint64 sum = 0;
+    for (unsigned i = 0; i < pack->GetNumEntries(); i++) {
+        const PackEntry * entry = pack->GetEntry(i);
+        DataStream stream(pack->OpenEntry(entry));
+        EXPECT_EQ(STREAM_ERROR_OK, stream.ReadBytes(read, entry->rawSize));
+        sum += read[entry->rawSize - 1];
+    }
+    return sum;
+}
+
+//====================================================
+TEST(StreamTest, DISABLED_TestLZ4DictionaryBenchmark) {
+    byte * objects = new byte[s_dictBenchmarkObjects * 4096];
+    unsigned * sizes = new unsigned[s_dictBenchmarkObjects];
+    uint64 total = 0;
+    for (unsigned i = 0; i < s_dictBenchmarkObjects; i++) {
+        sizes[i]    = FillReflectedObject(objects + total, i);
+        total      += sizes[i];
+    }
+
+    const EPackCompression compression[] = { PACK_COMPRESSION_LZ4, PACK_COMPRESSION_LZ4_DICT };
+    const chargr * packNames[] = { L"testLZ4Entries.pack", L"testLZ4Dictionary.pack" };
+    uint64 trainTicks = 0;
+    uint64 compressTicks[2];
+    uint64 storedSize[2];
+    for (unsigned i = 0; i < 2; i++) {
+        IPackWriterPtr writer = StreamCreatePack(packNames[i], 16);
+        ASSERT_TRUE(writer != NULL);
+
+        uint64 start = TimerGetTicks();
+        if (compression[i] == PACK_COMPRESSION_LZ4_DICT) {
+            EXPECT_EQ(STREAM_ERROR_OK, writer->SetDictionary(StreamTrainLZ4Dictionary(objects, sizes, s_dictBenchmarkObjects)));
+            trainTicks = TimerGetTicks() - start;
+        }
+
+        start = TimerGetTicks();
+        const byte * object = objects;
+        for (unsigned j = 0; j < s_dictBenchmarkObjects; j++) {
+            chargr path[FILE_PATH_LENGTH];
+            StrPrintf(path, FILE_PATH_LENGTH, L"objects/object%u.bin", j);
+            EXPECT_EQ(STREAM_ERROR_OK, writer->AddEntry(path, object, sizes[j], compression[i]));
+            object += sizes[j];
+        }
+        EXPECT_EQ(STREAM_ERROR_OK, writer->Close());
+        compressTicks[i] = TimerGetTicks() - start;
+
+        IPackFilePtr pack = StreamOpenPack(packNames[i]);
+        ASSERT_TRUE(pack != NULL);
+        storedSize[i] = pack->GetDictionary() != NULL ? pack->GetDictionary()->GetSize() : 0;
+        for (unsigned j = 0; j < pack->GetNumEntries(); j++) 
+            storedSize[i] += pack->GetEntry(j)->size;
+    }
+    EXPECT_LT(storedSize[1] * 2, storedSize[0]);
+
+    byte read[4096];
+    uint64 readTicks[2];
+    uint64 sums[2];
+    for (unsigned i = 0; i < 2; i++) {
+        IPackFilePtr pack = StreamOpenPack(packNames[i]);
+        ASSERT_TRUE(pack != NULL);
+        for (unsigned j = 0; j < pack->GetNumEntries(); j++) 
+            EXPECT_EQ(true, pack->VerifyEntry(pack->GetEntry(j)));
+
+        uint64 start = TimerGetTicks();
+        sums[i] = ReadPackEntries(pack, read);
+        readTicks[i] = TimerGetTicks() - start;
+    }
+    EXPECT_EQ(sums[0], sums[1]);
+
+    RecordProperty("lz4RatioPercent", static_cast<int>(total * 100ULL / storedSize[0]));
+    RecordProperty("dictRatioPercent", static_cast<int>(total * 100ULL / storedSize[1]));
+    RecordProperty("trainUs", static_cast<int>(TimerTicksToNanoseconds(trainTicks) / 1000));
+    RecordProperty("lz4CompressMBs", static_cast<int>(total * 1000ULL / TimerTicksToNanoseconds(compressTicks[0])));
+    RecordProperty("dictCompressMBs", static_cast<int>(total * 1000ULL / TimerTicksToNanoseconds(compressTicks[1])));
+    RecordProperty("lz4ReadMBs", static_cast<int>(total * 1000ULL / TimerTicksToNanoseconds(readTicks[0])));
+    RecordProperty("dictReadMBs", static_cast<int>(total * 1000ULL / TimerTicksToNanoseconds(readTicks[1])));
+
+    delete [] sizes;
+    delete [] objects;
+}
+
+//====================================================
+TEST(StreamTest, TestChunkedFile) {
+    const uint32 typeData    = STREAM_CHUNK_TYPE('D', 'A', 'T', 'A');
+    const uint32 typeNewer   = STREAM_CHUNK_TYPE('N', 'E', 'W', 'R');
+    const uint32 typeEmpty   = STREAM_CHUNK_TYPE('E', 'M', 'P', 'T');
+    const uint32 typeTail    = STREAM_CHUNK_TYPE('T', 'A', 'I', 'L');
+
+    const unsigned count = 5000;
+    uint32 * data = new uint32[count];
+    FillAssetData(data, count);
+
+    EXPECT_EQ(true, StreamOpenChunked(L"missingStream.bin") == NULL);
+    EXPECT_EQ(true, StreamOpenChunked(StreamOpenFile(L"testBufferedStream.bin")) == NULL);
+
+    {
+        IChunkWriterPtr writer = StreamCreateChunked(StreamCreateFile(L"testChunked.bin", 64));
+        ASSERT_TRUE(writer != NULL);
+        {
+            DataStream stream(writer->BeginChunk(typeData, 1));
+            for (unsigned i = 0; i < count; i++) 
+                EXPECT_EQ(STREAM_ERROR_OK, stream.Write(data[i]));
+        }
+        {
+            // Chunks a reader doesn't know about are passed over
+            DataStream stream(writer->BeginChunk(typeNewer, 3));
+            EXPECT_EQ(STREAM_ERROR_OK, stream.WriteBytes(data, 13));
+        }
+        writer->BeginChunk(typeEmpty, 1);
+        {
+            DataStream stream(writer->BeginChunk(typeTail, 2));
+            EXPECT_EQ(STREAM_ERROR_OK, stream.Write(uint32(0x12345678)));
+            EXPECT_EQ(STREAM_ERROR_OK, stream.Write(uint16(0x9abc)));
+        }
+        EXPECT_EQ(STREAM_ERROR_OK, writer->Close());
+    }
+
+    {
+        IChunkReaderPtr reader = StreamOpenChunked(StreamOpenFile(L"testChunked.bin", 64));
+        ASSERT_TRUE(reader != NULL);
+        EXPECT_EQ(4, reader->GetNumChunks());
+        EXPECT_EQ(true, reader->FindChunk(STREAM_CHUNK_TYPE('M', 'I', 'S', 'S')) == NULL);
+
+        const ChunkDesc * chunk = reader->FindChunk(typeData);
+        ASSERT_TRUE(chunk != NULL);
+        EXPECT_EQ(1, chunk->version);
+        EXPECT_EQ(count * sizeof(uint32), chunk->size);
+        for (unsigned i = 0; i < reader->GetNumChunks(); i++) 
+            EXPECT_EQ(0, reader->GetChunk(i)->offset % 8);
+
+        // Only part of the chunk is read, the reader skips the rest
+        {
+            DataStream stream(reader->OpenChunk(chunk));
+            for (unsigned i = 0; i < count / 2; i++) {
+                uint32 value = 0;
+                EXPECT_EQ(STREAM_ERROR_OK, stream.Read(value));
+                EXPECT_EQ(data[i], value);
+            }
+        }
+
+        const ChunkDesc * empty = reader->FindChunk(typeEmpty);
+        ASSERT_TRUE(empty != NULL);
+        EXPECT_EQ(0, empty->size);
+        {
+            DataStream stream(reader->OpenChunk(empty));
+            uint32 value = 0;
+            EXPECT_EQ(STREAM_ERROR_EOF, stream.Read(value));
+        }
+
+        {
+            DataStream stream(reader->OpenChunk(reader->FindChunk(typeTail)));
+            uint32 value = 0;
+            uint16 value16 = 0;
+            EXPECT_EQ(STREAM_ERROR_OK, stream.Read(value));
+            EXPECT_EQ(STREAM_ERROR_OK, stream.Read(value16));
+            EXPECT_EQ(0x12345678, value);
+            EXPECT_EQ(0x9abc, value16);
+            EXPECT_EQ(STREAM_ERROR_EOF, stream.Read(value16));
+        }
+
+        // Streams don't go back
+        EXPECT_EQ(true, reader->OpenChunk(chunk) == NULL);
+    }
+
+    {
+        IChunkReaderPtr reader = StreamOpenChunked(L"testChunked.bin");
+        ASSERT_TRUE(reader != NULL);
+        EXPECT_EQ(4, reader->GetNumChunks());
+
+        // Mapped chunks open in any order, and at the same time
+        IRawStreamPtr tail = reader->OpenChunk(reader->FindChunk(typeTail));
+        DataStream stream(reader->OpenChunk(reader->FindChunk(typeData)));
+        const byte * inPlace = stream.ReadInPlace(count * sizeof(uint32));
+        ASSERT_TRUE(inPlace != NULL);
+        EXPECT_EQ(0, memcmp(data, inPlace, count * sizeof(uint32)));
+
+        uint32 value = 0;
+        EXPECT_EQ(STREAM_ERROR_EOF, stream.Read(value));
+        EXPECT_EQ(STREAM_ERROR_OK, DataStream(tail).Read(value));
+        EXPECT_EQ(0x12345678, value);
+    }
+
+    delete [] data;
+}
@@ -0,0 +1,56 @@
+/*
+   GameRiff - Framework for creating various video game services
+   Helpers shared by the text stream unit tests
+   Copyright (C) 2011, Shaun Leach.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are
+   met:
+  
+       * Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+       * Redistributions in binary form must reproduce the above
+   copyright notice, this list of conditions and the following disclaimer
+   in the documentation and/or other materials provided with the
+   distribution.
+  
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+//====================================================
+inline void WriteText(const chargr * fileName, const char * text) {
+    DataStream stream(StreamCreateFile(fileName));
+    EXPECT_EQ(STREAM_ERROR_OK, stream.WriteBytes(text, strlen(text)));
+}
+
+//====================================================
+inline void ExpectName(IStructuredTextStreamPtr stream, const chargr * expected) {
+    chargr name[64];
+    EXPECT_EQ(STREAM_ERROR_OK, stream->ReadNodeName(name, 64));
+    EXPECT_EQ(0, StrCmp(expected, name, 64));
+}
+
+//====================================================
+inline void ExpectValue(IStructuredTextStreamPtr stream, const chargr * expected) {
+    chargr value[64];
+    EXPECT_EQ(STREAM_ERROR_OK, stream->ReadNodeValue(value, 64));
+    EXPECT_EQ(0, StrCmp(expected, value, 64));
+}
+
+//====================================================
+inline void ExpectView(const StreamTextView & view, const char * expected) {
+    EXPECT_EQ(strlen(expected), view.len);
+    EXPECT_EQ(0, memcmp(expected, view.str, view.len));
+}
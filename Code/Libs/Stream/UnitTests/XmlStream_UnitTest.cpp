@@ -30,10 +30,442 @@
 #include <gtest/gtest.h>
 
 #include "Pch.h"
+#include "TextStream_UnitTest.h"
 
 TEST(XmlStreamTest, TestOpen) {
     //IStructuredTextStream * testStream = StreamOpenXML(L"test.xml");
     //ASSERT_TRUE(testStream == NULL);
 }
 
+//====================================================
+TEST(XmlStreamTest, TestReader) {
+    WriteText(L"testReader.xml", 
+        "\xef\xbb\xbf<?xml version=\"1.0\" ?>\n"
+        "<!-- Comments <Root> -->\n"
+        "<Root a=\"1\" b='two &amp; &#x41;&#66;'>\n"
+        "    <Leaf>  some \n  text &lt;x&gt; &unknown; </Leaf>\n"
+        "    <Empty />\n"
+        "    <Skipped><Deep><Deeper x=\"/>\">v</Deeper></Deep><Self/></Skipped>\n"
+        "    <Data><![CDATA[<raw>  ]]></Data>\n"
+        "    <Nested><Child>1</Child><Child>2</Child></Nested>\n"
+        "    <Last/>\n"
+        "</Root>\n"
+    );
 
+    IStructuredTextStreamPtr stream = StreamOpenXMLReader(L"testReader.xml");
+    ASSERT_TRUE(stream != NULL);
+    EXPECT_EQ(0, StrCmp(L"testReader.xml", stream->GetName(), 64));
+    ExpectName(stream, L"Root");
+
+    chargr value[64];
+    EXPECT_EQ(STREAM_ERROR_OK, stream->ReadNodeAttribute(L"a", 1, value, 64));
+    EXPECT_EQ(0, StrCmp(L"1", value, 64));
+    EXPECT_EQ(STREAM_ERROR_OK, stream->ReadNodeAttribute(L"b", 1, value, 64));
+    EXPECT_EQ(0, StrCmp(L"two & AB", value, 64));
+    EXPECT_EQ(STREAM_ERROR_BADDATA, stream->ReadNodeAttribute(L"c", 1, value, 64));
+    EXPECT_EQ(STREAM_ERROR_NODEDOESNTEXIST, stream->ReadNodeValue(value, 64));
+
+    EXPECT_EQ(STREAM_ERROR_OK, stream->ReadChildNode());
+    ExpectName(stream, L"Leaf");
+    ExpectValue(stream, L"some text <x> &unknown;");
+    EXPECT_EQ(STREAM_ERROR_NODEDOESNTEXIST, stream->ReadChildNode());
+    ExpectName(stream, L"Leaf");
+
+    EXPECT_EQ(STREAM_ERROR_OK, stream->ReadNextNode());
+    ExpectName(stream, L"Empty");
+    EXPECT_EQ(STREAM_ERROR_NODEDOESNTEXIST, stream->ReadChildNode());
+
+    // Nodes that aren't entered are passed over whole
+    EXPECT_EQ(STREAM_ERROR_OK, stream->ReadNextNode());
+    ExpectName(stream, L"Skipped");
+    EXPECT_EQ(STREAM_ERROR_OK, stream->ReadNextNode());
+    ExpectName(stream, L"Data");
+    ExpectValue(stream, L"<raw>  ");
+
+    EXPECT_EQ(STREAM_ERROR_OK, stream->ReadNextNode());
+    ExpectName(stream, L"Nested");
+    EXPECT_EQ(STREAM_ERROR_OK, stream->ReadChildNode());
+    ExpectName(stream, L"Child");
+    ExpectValue(stream, L"1");
+    EXPECT_EQ(STREAM_ERROR_OK, stream->ReadParentNode());
+    ExpectName(stream, L"Nested");
+
+    EXPECT_EQ(STREAM_ERROR_OK, stream->ReadNextNode());
+    ExpectName(stream, L"Last");
+    EXPECT_EQ(STREAM_ERROR_NODEDOESNTEXIST, stream->ReadNextNode());
+    ExpectName(stream, L"Last");
+
+    EXPECT_EQ(STREAM_ERROR_OK, stream->ReadParentNode());
+    ExpectName(stream, L"Root");
+    EXPECT_EQ(STREAM_ERROR_NODEDOESNTEXIST, stream->ReadNextNode());
+    EXPECT_EQ(STREAM_ERROR_OK, stream->ReadParentNode());
+    EXPECT_EQ(STREAM_ERROR_NODEDOESNTEXIST, stream->ReadParentNode());
+
+    // Malformed files end the traversal
+    WriteText(L"testReaderBad.xml", "<Root><A></B><C/></Root>");
+    stream = StreamOpenXMLReader(L"testReaderBad.xml");
+    ASSERT_TRUE(stream != NULL);
+    EXPECT_EQ(STREAM_ERROR_OK, stream->ReadChildNode());
+    EXPECT_EQ(STREAM_ERROR_NODEDOESNTEXIST, stream->ReadChildNode());
+    EXPECT_EQ(STREAM_ERROR_NODEDOESNTEXIST, stream->ReadNextNode());
+    ExpectName(stream, L"A");
+
+    WriteText(L"testReaderEmpty.xml", "<?xml version=\"1.0\" ?>\n<!-- Nothing -->\n");
+    EXPECT_EQ(true, StreamOpenXMLReader(L"testReaderEmpty.xml") == NULL);
+    EXPECT_EQ(true, StreamOpenXMLReader(L"missing.xml") == NULL);
+}
+
+//====================================================
+TEST(XmlStreamTest, TestInSitu) {
+    char text[] = 
+        "\xef\xbb\xbf<?xml version=\"1.0\" ?>\n"
+        "<!-- Comments <Root> -->\n"
+        "<Root a=\"1\" b='two &amp; &#x41;&#66;'>\n"
+        "    <Leaf>  some \n  text &lt;x&gt; &unknown; </Leaf>\n"
+        "    <Empty />\n"
+        "    <Skipped><Deep><Deeper x=\"/>\">v</Deeper></Deep><Self/></Skipped>\n"
+        "    <Data><![CDATA[<raw>  ]]></Data>\n"
+        "    <Last/>\n"
+        "</Root>\n";
+
+    IStructuredTextStreamPtr stream = StreamOpenXMLInSitu(text, sizeof(text) - 1, L"inSitu");
+    ASSERT_TRUE(stream != NULL);
+    EXPECT_EQ(0, StrCmp(L"inSitu", stream->GetName(), 64));
+
+    // Views point into the buffer that was parsed
+    StreamTextView view;
+    EXPECT_EQ(STREAM_ERROR_OK, stream->ReadNodeNameView(&view));
+    ExpectView(view, "Root");
+    EXPECT_EQ(true, view.str > text && view.str < text + sizeof(text));
+    EXPECT_EQ(true, StreamViewEquals(view, "root"));
+    EXPECT_EQ(false, StreamViewEquals(view, "Roo"));
+    EXPECT_EQ(false, StreamViewEquals(view, "Roots"));
+    EXPECT_EQ(STREAM_ERROR_OK, stream->ReadNodeAttributeView("b", &view));
+    ExpectView(view, "two & AB");
+    EXPECT_EQ(STREAM_ERROR_BADDATA, stream->ReadNodeAttributeView("c", &view));
+    EXPECT_EQ(STREAM_ERROR_NODEDOESNTEXIST, stream->ReadNodeValueView(&view));
+
+    chargr value[64];
+    EXPECT_EQ(STREAM_ERROR_OK, stream->ReadNodeAttribute(L"a", 1, value, 64));
+    EXPECT_EQ(0, StrCmp(L"1", value, 64));
+
+    EXPECT_EQ(STREAM_ERROR_OK, stream->ReadChildNode());
+    ExpectName(stream, L"Leaf");
+    EXPECT_EQ(STREAM_ERROR_OK, stream->ReadNodeValueView(&view));
+    ExpectView(view, "some text <x> &unknown;");
+    ExpectValue(stream, L"some text <x> &unknown;");
+
+    // Nodes can be entered after their siblings were read
+    EXPECT_EQ(STREAM_ERROR_OK, stream->ReadNextNode());
+    EXPECT_EQ(STREAM_ERROR_OK, stream->ReadNextNode());
+    ExpectName(stream, L"Skipped");
+    EXPECT_EQ(STREAM_ERROR_OK, stream->ReadNextNode());
+    ExpectName(stream, L"Data");
+    ExpectValue(stream, L"<raw>  ");
+    EXPECT_EQ(STREAM_ERROR_OK, stream->ReadParentNode());
+    EXPECT_EQ(STREAM_ERROR_OK, stream->ReadChildNode());
+    ExpectName(stream, L"Leaf");
+    EXPECT_EQ(STREAM_ERROR_OK, stream->ReadNextNode());
+    EXPECT_EQ(STREAM_ERROR_OK, stream->ReadNextNode());
+    EXPECT_EQ(STREAM_ERROR_OK, stream->ReadChildNode());
+    EXPECT_EQ(STREAM_ERROR_OK, stream->ReadChildNode());
+    EXPECT_EQ(STREAM_ERROR_OK, stream->ReadNodeAttributeView("x", &view));
+    ExpectView(view, "/>");
+    ExpectValue(stream, L"v");
+    EXPECT_EQ(STREAM_ERROR_OK, stream->ReadParentNode());
+    EXPECT_EQ(STREAM_ERROR_OK, stream->ReadNextNode());
+    ExpectName(stream, L"Self");
+    EXPECT_EQ(STREAM_ERROR_NODEDOESNTEXIST, stream->ReadNextNode());
+
+    EXPECT_EQ(STREAM_ERROR_OK, stream->ReadParentNode());
+    EXPECT_EQ(STREAM_ERROR_OK, stream->ReadParentNode());
+    ExpectName(stream, L"Root");
+    EXPECT_EQ(STREAM_ERROR_OK, stream->ReadParentNode());
+    EXPECT_EQ(STREAM_ERROR_NODEDOESNTEXIST, stream->ReadParentNode());
+
+    // Unlike the forward only reader, malformed files don't open
+    char bad[] = "<Root><A></B><C/></Root>";
+    EXPECT_EQ(true, StreamOpenXMLInSitu(bad, sizeof(bad) - 1, L"bad") == NULL);
+    char unclosed[] = "<Root><A>";
+    EXPECT_EQ(true, StreamOpenXMLInSitu(unclosed, sizeof(unclosed) - 1, L"unclosed") == NULL);
+    char noValue[] = "<Root c=\"1\" b/>";
+    EXPECT_EQ(true, StreamOpenXMLInSitu(noValue, sizeof(noValue) - 1, L"noValue") == NULL);
+    EXPECT_EQ(true, StreamOpenXMLInSitu(L"missing.xml") == NULL);
+
+    // Files are read into a buffer of the stream's own
+    WriteText(L"testInSitu.xml", "<Root><Leaf a='x'>y</Leaf></Root>");
+    stream = StreamOpenXMLInSitu(L"testInSitu.xml");
+    ASSERT_TRUE(stream != NULL);
+    EXPECT_EQ(STREAM_ERROR_OK, stream->ReadChildNode());
+    ExpectName(stream, L"Leaf");
+    ExpectValue(stream, L"y");
+
+    // The other backends lend views of their own text
+    stream = StreamOpenXML(L"testInSitu.xml");
+    ASSERT_TRUE(stream != NULL);
+    EXPECT_EQ(STREAM_ERROR_OK, stream->ReadChildNode());
+    EXPECT_EQ(STREAM_ERROR_OK, stream->ReadNodeNameView(&view));
+    ExpectView(view, "Leaf");
+    EXPECT_EQ(STREAM_ERROR_OK, stream->ReadNodeAttributeView("a", &view));
+    ExpectView(view, "x");
+    EXPECT_EQ(STREAM_ERROR_OK, stream->ReadNodeValueView(&view));
+    ExpectView(view, "y");
+    EXPECT_EQ(1u, StreamViewToCharGr(view, value, 64));
+    EXPECT_EQ(0, StrCmp(L"y", value, 64));
+    EXPECT_EQ(HashString32(L"y"), StreamViewHash32(view));
+
+    stream = StreamOpenXMLReader(L"testInSitu.xml");
+    ASSERT_TRUE(stream != NULL);
+    EXPECT_EQ(STREAM_ERROR_OK, stream->ReadChildNode());
+    EXPECT_EQ(STREAM_ERROR_OK, stream->ReadNodeValueView(&view));
+    ExpectView(view, "y");
+}
+
+//====================================================
+static void ExpectHashes(IStructuredTextStreamPtr stream) {
+    ASSERT_TRUE(stream != NULL);
+    Hash32 hash;
+    EXPECT_EQ(STREAM_ERROR_OK, stream->ReadNodeNameHash(&hash));
+    EXPECT_EQ(HashString32(L"root"), hash);
+    EXPECT_EQ(STREAM_ERROR_OK, stream->ReadChildNode());
+    EXPECT_EQ(STREAM_ERROR_OK, stream->ReadNodeNameHash(&hash));
+    EXPECT_EQ(HashString32(L"DataMember"), hash);
+    EXPECT_EQ(STREAM_ERROR_OK, stream->ReadNodeAttributeHash(HashString32(L"Name"), &hash));
+    EXPECT_EQ(HashString32(L"member & <1>"), hash);
+    EXPECT_EQ(STREAM_ERROR_OK, stream->ReadNodeAttributeHash(HashString32(L"TYPE"), &hash));
+    EXPECT_EQ(HashString32(L"uint32"), hash);
+    EXPECT_EQ(STREAM_ERROR_BADDATA, stream->ReadNodeAttributeHash(HashString32(L"Version"), &hash));
+    EXPECT_EQ(STREAM_ERROR_OK, stream->ReadNextNode());
+    EXPECT_EQ(STREAM_ERROR_OK, stream->ReadNodeNameHash(&hash));
+    EXPECT_EQ(HashString32(L"BaseClass"), hash);
+    EXPECT_EQ(STREAM_ERROR_OK, stream->ReadNodeAttributeHash(HashString32(L"Type"), &hash));
+    EXPECT_EQ(HashString32(L"Base"), hash);
+}
+
+//====================================================
+TEST(XmlStreamTest, TestNameHashes) {
+    WriteText(L"testNameHashes.xml", 
+        "<Root>\n"
+        "    <DataMember Name=\"member &amp; &lt;1>\" Type='uint32'>7</DataMember>\n"
+        "    <BaseClass Type=\"Base\" />\n"
+        "</Root>\n"
+    );
+
+    // Every backend gives the hashes of the decoded names
+    ExpectHashes(StreamOpenXML(L"testNameHashes.xml"));
+    ExpectHashes(StreamOpenXMLReader(L"testNameHashes.xml"));
+    ExpectHashes(StreamOpenXMLInSitu(L"testNameHashes.xml"));
+}
+
+//====================================================
+// Visits every node the way reflection loads do and sums what it read
+static unsigned WalkNodes(IStructuredTextStreamPtr stream) {
+    unsigned sum = 0;
+    do {
+        chargr text[256];
+        chargr name[64];
+        stream->ReadNodeName(name, 64);
+        sum += name[0];
+        if (stream->ReadNodeAttribute(L"Name", 4, text, 256) == STREAM_ERROR_OK) 
+            sum += text[0] + text[6];
+        if (StrCmp(name, L"DataMember", 10) == 0) {
+            stream->ReadNodeValue(text, 256);
+            sum += text[0];
+        }
+        else if (stream->ReadChildNode() == STREAM_ERROR_OK) 
+            sum += WalkNodes(stream);
+        sum++;
+    } while (stream->ReadNextNode() != STREAM_ERROR_NODEDOESNTEXIST);
+
+    stream->ReadParentNode();
+    return sum;
+}
+
+//====================================================
+// Same as WalkNodes without converting any of the text
+static unsigned WalkNodeViews(IStructuredTextStreamPtr stream) {
+    unsigned sum = 0;
+    do {
+        StreamTextView text;
+        StreamTextView name;
+        stream->ReadNodeNameView(&name);
+        sum += name.str[0];
+        if (stream->ReadNodeAttributeView("Name", &text) == STREAM_ERROR_OK) 
+            sum += text.str[0] + (text.len > 6 ? text.str[6] : 0);
+        if (StreamViewEquals(name, "DataMember")) {
+            stream->ReadNodeValueView(&text);
+            sum += text.len > 0 ? text.str[0] : 0;
+        }
+        else if (stream->ReadChildNode() == STREAM_ERROR_OK) 
+            sum += WalkNodeViews(stream);
+        sum++;
+    } while (stream->ReadNextNode() != STREAM_ERROR_NODEDOESNTEXIST);
+
+    stream->ReadParentNode();
+    return sum;
+}
+
+//====================================================
+// Benchmarks are disabled, run them with --gtest_also_run_disabled_tests
+static const unsigned s_benchmarkClasses = 2000;
+static const unsigned s_benchmarkMembers = 20;
+
+//====================================================
+static void WriteBenchmarkNodes(IStructuredTextStreamPtr stream, unsigned numClasses) {
+    stream->WriteNode(L"Objects");
+    for (unsigned i = 0; i < numClasses; i++) {
+        stream->WriteNode(L"Class");
+        stream->WriteNodeAttribute(L"Type", L"BenchmarkClass");
+        stream->WriteNodeAttribute(L"Version", L"1");
+        for (unsigned j = 0; j < s_benchmarkMembers; j++) {
+            chargr name[32];
+            chargr value[32];
+            StrPrintf(name, 32, L"member%u", j);
+            StrPrintf(value, 32, L"%u", i * j);
+            stream->WriteNode(L"DataMember");
+            stream->WriteNodeAttribute(L"Name", name);
+            stream->WriteNodeAttribute(L"Type", L"uint32");
+            stream->WriteNodeValue(value);
+            stream->EndNode();
+        }
+        stream->EndNode();
+    }
+    stream->EndNode();
+    EXPECT_EQ(STREAM_ERROR_OK, stream->Save());
+}
+
+//====================================================
+TEST(XmlStreamTest, TestReadersAgree) {
+    WriteBenchmarkNodes(StreamCreateXML(L"testReadersAgree.xml"), 20);
+
+    IStructuredTextStreamPtr document = StreamOpenXML(L"testReadersAgree.xml");
+    IStructuredTextStreamPtr reader   = StreamOpenXMLReader(L"testReadersAgree.xml");
+    IStructuredTextStreamPtr inSitu   = StreamOpenXMLInSitu(L"testReadersAgree.xml");
+    ASSERT_TRUE(document != NULL && reader != NULL && inSitu != NULL);
+    unsigned documentSum = WalkNodes(document);
+    EXPECT_EQ(documentSum, WalkNodes(reader));
+    EXPECT_EQ(documentSum, WalkNodeViews(inSitu));
+}
+
+//====================================================
+TEST(XmlStreamTest, DISABLED_TestReaderBenchmark) {
+    WriteBenchmarkNodes(StreamCreateXML(L"testReaderBenchmark.xml"), s_benchmarkClasses);
+
+    uint64 start = TimerGetTicks();
+    unsigned documentSum = 0;
+    {
+        IStructuredTextStreamPtr stream = StreamOpenXML(L"testReaderBenchmark.xml");
+        ASSERT_TRUE(stream != NULL);
+        documentSum = WalkNodes(stream);
+    }
+    uint64 documentTicks = TimerGetTicks() - start;
+
+    start = TimerGetTicks();
+    unsigned readerSum = 0;
+    {
+        IStructuredTextStreamPtr stream = StreamOpenXMLReader(L"testReaderBenchmark.xml");
+        ASSERT_TRUE(stream != NULL);
+        readerSum = WalkNodes(stream);
+    }
+    uint64 readerTicks = TimerGetTicks() - start;
+    EXPECT_EQ(documentSum, readerSum);
+
+    start = TimerGetTicks();
+    unsigned inSituSum = 0;
+    {
+        IStructuredTextStreamPtr stream = StreamOpenXMLInSitu(L"testReaderBenchmark.xml");
+        ASSERT_TRUE(stream != NULL);
+        inSituSum = WalkNodeViews(stream);
+    }
+    uint64 inSituTicks = TimerGetTicks() - start;
+    EXPECT_EQ(documentSum, inSituSum);
+
+    RecordProperty("documentUs", static_cast<int>(TimerTicksToNanoseconds(documentTicks) / 1000));
+    RecordProperty("readerUs", static_cast<int>(TimerTicksToNanoseconds(readerTicks) / 1000));
+    RecordProperty("inSituUs", static_cast<int>(TimerTicksToNanoseconds(inSituTicks) / 1000));
+}
+
+//====================================================
+static bool FilesEqual(const chargr * fileNameA, const chargr * fileNameB) {
+    DataStream streamA(StreamOpenFile(fileNameA));
+    DataStream streamB(StreamOpenFile(fileNameB));
+    for (;;) {
+        byte blockA[1024];
+        byte blockB[1024];
+        unsigned readA = 0;
+        unsigned readB = 0;
+        streamA.ReadBytes(blockA, sizeof(blockA), &readA);
+        streamB.ReadBytes(blockB, sizeof(blockB), &readB);
+        if (readA != readB || memcmp(blockA, blockB, readA) != 0) 
+            return false;
+        if (readA < sizeof(blockA)) 
+            return true;
+    }
+}
+
+//====================================================
+static void WriteTestNodes(IStructuredTextStreamPtr stream) {
+    stream->WriteNode(L"Root");
+    stream->WriteNodeAttribute(L"a", L"1 & <2>");
+    stream->WriteNodeAttribute(L"b", L"say \"hi\"");
+    stream->WriteNode(L"Leaf");
+    stream->WriteNodeValue(L"it's\ttext");
+    stream->EndNode();
+    stream->WriteNode(L"Empty");
+    stream->EndNode();
+    stream->WriteNode(L"Mixed");
+    stream->WriteNodeValue(L"before");
+    stream->WriteNode(L"Deep");
+    stream->WriteNode(L"Deeper");
+    stream->WriteNodeAttribute(L"x", L"y");
+    stream->EndNode();
+    stream->EndNode();
+    stream->EndNode();
+    stream->EndNode();
+    stream->WriteNode(L"Second");
+    stream->EndNode();
+}
+
+//====================================================
+TEST(XmlStreamTest, TestWriter) {
+    IStructuredTextStreamPtr stream = StreamCreateXMLWriter(L"testWriter.xml");
+    ASSERT_TRUE(stream != NULL);
+    EXPECT_EQ(0, StrCmp(L"testWriter.xml", stream->GetName(), 64));
+    WriteTestNodes(stream);
+    EXPECT_EQ(STREAM_ERROR_OK, stream->Save());
+    stream = NULL;
+
+    stream = StreamCreateXML(L"testWriterDocument.xml");
+    WriteTestNodes(stream);
+    EXPECT_EQ(STREAM_ERROR_OK, stream->Save());
+    stream = NULL;
+
+    // Files match the document backend byte for byte
+    EXPECT_EQ(true, FilesEqual(L"testWriterDocument.xml", L"testWriter.xml"));
+
+    stream = StreamOpenXMLReader(L"testWriter.xml");
+    ASSERT_TRUE(stream != NULL);
+    chargr value[64];
+    EXPECT_EQ(STREAM_ERROR_OK, stream->ReadNodeAttribute(L"a", 1, value, 64));
+    EXPECT_EQ(0, StrCmp(L"1 & <2>", value, 64));
+    EXPECT_EQ(STREAM_ERROR_OK, stream->ReadNodeAttribute(L"b", 1, value, 64));
+    EXPECT_EQ(0, StrCmp(L"say \"hi\"", value, 64));
+    EXPECT_EQ(STREAM_ERROR_OK, stream->ReadChildNode());
+    ExpectValue(stream, L"it's\ttext");
+}
+
+//====================================================
+TEST(XmlStreamTest, DISABLED_TestWriterBenchmark) {
+    uint64 start = TimerGetTicks();
+    WriteBenchmarkNodes(StreamCreateXML(L"testWriterBenchmarkDocument.xml"), s_benchmarkClasses);
+    uint64 documentTicks = TimerGetTicks() - start;
+
+    start = TimerGetTicks();
+    WriteBenchmarkNodes(StreamCreateXMLWriter(L"testWriterBenchmark.xml"), s_benchmarkClasses);
+    uint64 writerTicks = TimerGetTicks() - start;
+
+    EXPECT_EQ(true, FilesEqual(L"testWriterBenchmarkDocument.xml", L"testWriterBenchmark.xml"));
+
+    RecordProperty("documentUs", static_cast<int>(TimerTicksToNanoseconds(documentTicks) / 1000));
+    RecordProperty("writerUs", static_cast<int>(TimerTicksToNanoseconds(writerTicks) / 1000));
+}
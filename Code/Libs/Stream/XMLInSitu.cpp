@@ -0,0 +1,757 @@
+/*
+   GameRiff - Framework for creating various video game services
+   In place XML parser
+   Copyright (C) 2011, Shaun Leach.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are
+   met:
+  
+       * Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+       * Redistributions in binary form must reproduce the above
+   copyright notice, this list of conditions and the following disclaimer
+   in the documentation and/or other materials provided with the
+   distribution.
+  
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include "Pch.h"
+
+namespace NSXMLInSitu {
+
+//////////////////////////////////////////////////////
+//
+// Constants
+//
+
+#define XML_INSITU_MEM_FLAGS (MemFlags(MEM_ARENA_DEFAULT, MEM_CAT_XML))
+
+static const unsigned   s_readSize          = 64 * 1024;
+static const unsigned   s_maxDepth          = 256;
+static const unsigned   s_noNode            = 0xffffffff;
+static const unsigned   s_maxEntityLength   = 10;
+
+//////////////////////////////////////////////////////
+//
+// Internal
+//
+
+// Decoded text in the buffer
+struct Token {
+    unsigned    start;
+    unsigned    len;
+};
+
+// Names are hashed once as they're parsed
+struct InSituAttribute {
+    Hash32      nameHash;
+    Token       name;
+    Token       value;
+};
+
+// Nodes are indexed in document order, the document itself first
+struct InSituNode {
+    Hash32      nameHash;
+    Token       name;
+    Token       value;          // start is s_noNode without text before the first child
+    unsigned    firstAttribute;
+    unsigned    numAttributes;
+    unsigned    parent;
+    unsigned    firstChild;
+    unsigned    nextSibling;
+};
+
+class XMLInSituReader : public IStructuredTextStream {
+public:
+    XMLInSituReader(charsys * text, unsigned size, bool ownsText, const chargr * name);
+    ~XMLInSituReader();
+
+    bool Open();
+
+    const chargr * GetName() const;
+
+    EStreamError Save();
+
+    EStreamError WriteNode(const chargr * name);
+    EStreamError WriteNodeValue(const chargr * value);
+    EStreamError EndNode();
+    EStreamError WriteNodeAttribute(const chargr * name, const chargr * value);
+
+    EStreamError ReadNodeName(chargr * name, unsigned len);
+    EStreamError ReadNextNode();
+    EStreamError ReadParentNode();
+    EStreamError ReadNodeValue(chargr * value, unsigned len) const;
+    EStreamError ReadNodeAttribute(
+        const chargr  * name, 
+        unsigned        nameLen,
+        chargr        * value, 
+        unsigned        len
+    ) const;
+    EStreamError ReadChildNode();
+
+    EStreamError ReadNodeNameView(StreamTextView * name) const;
+    EStreamError ReadNodeValueView(StreamTextView * value) const;
+    EStreamError ReadNodeAttributeView(const charsys * name, StreamTextView * value) const;
+
+    EStreamError ReadNodeNameHash(Hash32 * name) const;
+    EStreamError ReadNodeAttributeHash(Hash32 name, Hash32 * value) const;
+
+private:
+    bool Match(const char * str) const;
+    bool SkipPast(const char * terminator);
+    void SkipSpace();
+
+    bool Parse();
+    bool ParseStartTag(unsigned parent, bool * selfClosed);
+    bool ParseEndTag(unsigned node);
+    bool ParseName(Token * token);
+    bool ParseAttributeValue(Token * token);
+    void ParseValue(InSituNode * node);
+    void DecodeEntity(charsys ** out);
+
+    Token MakeToken(const charsys * start, const charsys * end) const {
+        Token token = { static_cast<unsigned>(start - m_text), static_cast<unsigned>(end - start) };
+        return token;
+    }
+    Hash32 HashToken(const Token & token) const {
+        return HashUtf8String32(m_text + token.start, token.len);
+    }
+
+private:
+    chargr            m_name[256];
+
+    charsys         * m_text;
+    unsigned          m_size;
+    bool              m_ownsText;
+    charsys         * m_pos;
+    charsys         * m_end;
+
+    InSituNode      * m_nodes;
+    unsigned          m_numNodes;
+    unsigned          m_maxNodes;
+    InSituAttribute * m_attributes;
+    unsigned          m_numAttributes;
+    unsigned          m_maxAttributes;
+
+    unsigned          m_current;
+};
+
+//====================================================
+static bool IsSpace(int c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+//====================================================
+static bool IsNameEnd(int c) {
+    return IsSpace(c) || c == '/' || c == '>' || c == '=';
+}
+
+//====================================================
+static unsigned CountBytes(const charsys * text, unsigned size, int c) {
+    unsigned count = 0;
+    const charsys * end = text + size;
+    for (const void * found = memchr(text, c, size); found != NULL; found = memchr(text, c, end - text)) {
+        text = reinterpret_cast<const charsys *>(found) + 1;
+        count++;
+    }
+
+    return count;
+}
+
+//====================================================
+// Reads the rest of a stream into one buffer
+static charsys * ReadAll(IRawStreamPtr source, unsigned * size) {
+    unsigned capacity = s_readSize;
+    charsys * text = new(XML_INSITU_MEM_FLAGS) charsys[capacity];
+    unsigned used = 0;
+    for (;;) {
+        if (used == capacity) {
+            charsys * newText = new(XML_INSITU_MEM_FLAGS) charsys[2 * capacity];
+            memcpy(newText, text, used);
+            delete [] text;
+            text        = newText;
+            capacity    = 2 * capacity;
+        }
+
+        unsigned read = 0;
+        source->ReadBytes(text + used, capacity - used, &read);
+        if (read == 0) 
+            break;
+        used += read;
+    }
+
+    *size = used;
+    return text;
+}
+
+//====================================================
+XMLInSituReader::XMLInSituReader(charsys * text, unsigned size, bool ownsText, const chargr * name) :
+    m_text(text),
+    m_size(size),
+    m_ownsText(ownsText),
+    m_pos(text),
+    m_end(text + size),
+    m_nodes(NULL),
+    m_numNodes(0),
+    m_maxNodes(0),
+    m_attributes(NULL),
+    m_numAttributes(0),
+    m_maxAttributes(0),
+    m_current(0)
+{
+    StrCopy(m_name, 256, name);
+}
+
+//====================================================
+XMLInSituReader::~XMLInSituReader() {
+    if (m_ownsText) 
+        delete [] m_text;
+    if (m_nodes != NULL) 
+        delete [] m_nodes;
+    if (m_attributes != NULL) 
+        delete [] m_attributes;
+}
+
+//====================================================
+bool XMLInSituReader::Open() {
+    // Every element starts with a '<' and every attribute has an '=', so 
+    //  counting them sizes the index once
+    m_maxNodes      = CountBytes(m_text, m_size, '<') + 1;
+    m_maxAttributes = CountBytes(m_text, m_size, '=');
+    m_nodes         = new(XML_INSITU_MEM_FLAGS) InSituNode[m_maxNodes];
+    if (m_maxAttributes > 0) 
+        m_attributes = new(XML_INSITU_MEM_FLAGS) InSituAttribute[m_maxAttributes];
+
+    if (!Parse()) 
+        return false;
+
+    m_current = m_nodes[0].firstChild;
+    return m_current != s_noNode;
+}
+
+//====================================================
+const chargr * XMLInSituReader::GetName() const {
+    return m_name;
+}
+
+//====================================================
+EStreamError XMLInSituReader::Save() {
+    ASSERTMSGGR(false, "XML readers are read only");
+    return STREAM_ERROR_FILENOTOPENED;
+}
+
+//====================================================
+EStreamError XMLInSituReader::WriteNode(const chargr * name) {
+    ASSERTMSGGR(false, "XML readers are read only");
+    return STREAM_ERROR_FILENOTOPENED;
+}
+
+//====================================================
+EStreamError XMLInSituReader::WriteNodeValue(const chargr * value) {
+    ASSERTMSGGR(false, "XML readers are read only");
+    return STREAM_ERROR_FILENOTOPENED;
+}
+
+//====================================================
+EStreamError XMLInSituReader::EndNode() {
+    ASSERTMSGGR(false, "XML readers are read only");
+    return STREAM_ERROR_FILENOTOPENED;
+}
+
+//====================================================
+EStreamError XMLInSituReader::WriteNodeAttribute(const chargr * name, const chargr * value) {
+    ASSERTMSGGR(false, "XML readers are read only");
+    return STREAM_ERROR_FILENOTOPENED;
+}
+
+//====================================================
+EStreamError XMLInSituReader::ReadNodeName(chargr * name, unsigned len) {
+    StreamTextView view;
+    ReadNodeNameView(&view);
+    StreamViewToCharGr(view, name, len);
+
+    return STREAM_ERROR_OK;
+}
+
+//====================================================
+EStreamError XMLInSituReader::ReadChildNode() {
+    unsigned child = m_nodes[m_current].firstChild;
+    if (child == s_noNode) 
+        return STREAM_ERROR_NODEDOESNTEXIST;
+
+    m_current = child;
+    return STREAM_ERROR_OK;
+}
+
+//====================================================
+EStreamError XMLInSituReader::ReadNextNode() {
+    unsigned sibling = m_nodes[m_current].nextSibling;
+    if (sibling == s_noNode) 
+        return STREAM_ERROR_NODEDOESNTEXIST;
+
+    m_current = sibling;
+    return STREAM_ERROR_OK;
+}
+
+//====================================================
+EStreamError XMLInSituReader::ReadParentNode() {
+    if (m_current == 0) 
+        return STREAM_ERROR_NODEDOESNTEXIST;
+
+    m_current = m_nodes[m_current].parent;
+    return STREAM_ERROR_OK;
+}
+
+//====================================================
+EStreamError XMLInSituReader::ReadNodeValue(chargr * value, unsigned len) const {
+    StreamTextView view;
+    EStreamError result = ReadNodeValueView(&view);
+    StreamViewToCharGr(view, value, len);
+
+    return result;
+}
+
+//====================================================
+EStreamError XMLInSituReader::ReadNodeAttribute(
+    const chargr  * name, 
+    unsigned        nameLen, 
+    chargr        * value, 
+    unsigned        valueLen
+) const {
+    StrStackConverter sysName(name, nameLen);
+    StreamTextView view;
+    EStreamError result = ReadNodeAttributeView(sysName, &view);
+    StreamViewToCharGr(view, value, valueLen);
+
+    return result;
+}
+
+//====================================================
+EStreamError XMLInSituReader::ReadNodeNameView(StreamTextView * name) const {
+    const Token & token = m_nodes[m_current].name;
+    name->str = m_text + token.start;
+    name->len = token.len;
+
+    return STREAM_ERROR_OK;
+}
+
+//====================================================
+EStreamError XMLInSituReader::ReadNodeValueView(StreamTextView * value) const {
+    const Token & token = m_nodes[m_current].value;
+    if (token.start == s_noNode) {
+        value->str = "";
+        value->len = 0;
+        return STREAM_ERROR_NODEDOESNTEXIST;
+    }
+
+    value->str = m_text + token.start;
+    value->len = token.len;
+
+    return STREAM_ERROR_OK;
+}
+
+//====================================================
+EStreamError XMLInSituReader::ReadNodeAttributeView(const charsys * name, StreamTextView * value) const {
+    const InSituNode & node = m_nodes[m_current];
+    unsigned nameLen = strlen(name);
+    const InSituAttribute * attribute = m_attributes + node.firstAttribute;
+    for (unsigned i = 0; i < node.numAttributes; i++, attribute++) {
+        if (attribute->name.len == nameLen && memcmp(m_text + attribute->name.start, name, nameLen) == 0) {
+            value->str = m_text + attribute->value.start;
+            value->len = attribute->value.len;
+            return STREAM_ERROR_OK;
+        }
+    }
+
+    value->str = "";
+    value->len = 0;
+    return STREAM_ERROR_BADDATA;
+}
+
+//====================================================
+EStreamError XMLInSituReader::ReadNodeNameHash(Hash32 * name) const {
+    *name = m_nodes[m_current].nameHash;
+
+    return STREAM_ERROR_OK;
+}
+
+//====================================================
+EStreamError XMLInSituReader::ReadNodeAttributeHash(Hash32 name, Hash32 * value) const {
+    const InSituNode & node = m_nodes[m_current];
+    const InSituAttribute * attribute = m_attributes + node.firstAttribute;
+    for (unsigned i = 0; i < node.numAttributes; i++, attribute++) {
+        if (attribute->nameHash == name) {
+            *value = HashToken(attribute->value);
+            return STREAM_ERROR_OK;
+        }
+    }
+
+    return STREAM_ERROR_BADDATA;
+}
+
+//====================================================
+bool XMLInSituReader::Match(const char * str) const {
+    unsigned len = strlen(str);
+    return static_cast<unsigned>(m_end - m_pos) >= len && memcmp(m_pos, str, len) == 0;
+}
+
+//====================================================
+bool XMLInSituReader::SkipPast(const char * terminator) {
+    while (m_pos < m_end) {
+        const void * found = memchr(m_pos, terminator[0], m_end - m_pos);
+        if (found == NULL) 
+            break;
+
+        m_pos = reinterpret_cast<charsys *>(const_cast<void *>(found));
+        if (Match(terminator)) {
+            m_pos += strlen(terminator);
+            return true;
+        }
+        m_pos++;
+    }
+
+    m_pos = m_end;
+    return false;
+}
+
+//====================================================
+void XMLInSituReader::SkipSpace() {
+    while (m_pos < m_end && IsSpace(*m_pos)) 
+        m_pos++;
+}
+
+//====================================================
+// Builds the whole index in one pass. Open nodes are kept on a stack with 
+//  the last child of each, which the next child is linked after.
+bool XMLInSituReader::Parse() {
+    unsigned open[s_maxDepth];
+    unsigned lastChild[s_maxDepth];
+    unsigned depth = 0;
+
+    InSituNode & document   = m_nodes[m_numNodes++];
+    document.name           = MakeToken(m_text, m_text);
+    document.nameHash       = HashToken(document.name);
+    document.value.start    = s_noNode;
+    document.value.len      = 0;
+    document.firstAttribute = 0;
+    document.numAttributes  = 0;
+    document.parent         = s_noNode;
+    document.firstChild     = s_noNode;
+    document.nextSibling    = s_noNode;
+    open[0]                 = 0;
+    lastChild[0]            = s_noNode;
+
+    for (;;) {
+        // Text after a node's first child is passed over
+        const void * found = memchr(m_pos, '<', m_end - m_pos);
+        if (found == NULL) 
+            break;
+        m_pos = reinterpret_cast<charsys *>(const_cast<void *>(found)) + 1;
+
+        if (Match("?")) {
+            if (!SkipPast("?>")) 
+                return false;
+        }
+        else if (Match("!--")) {
+            if (!SkipPast("-->")) 
+                return false;
+        }
+        else if (Match("![CDATA[")) {
+            if (!SkipPast("]]>")) 
+                return false;
+        }
+        else if (Match("!")) {
+            if (!SkipPast(">")) 
+                return false;
+        }
+        else if (Match("/")) {
+            m_pos++;
+            if (depth == 0 || !ParseEndTag(open[depth])) 
+                return false;
+            depth--;
+        }
+        else {
+            unsigned parent = open[depth];
+            unsigned index  = m_numNodes;
+            bool selfClosed = false;
+            if (!ParseStartTag(parent, &selfClosed)) 
+                return false;
+
+            if (lastChild[depth] == s_noNode) 
+                m_nodes[parent].firstChild = index;
+            else
+                m_nodes[lastChild[depth]].nextSibling = index;
+            lastChild[depth] = index;
+
+            if (!selfClosed) {
+                if (depth + 1 == s_maxDepth) 
+                    return false;
+                depth++;
+                open[depth]         = index;
+                lastChild[depth]    = s_noNode;
+                ParseValue(&m_nodes[index]);
+            }
+        }
+    }
+
+    return depth == 0;
+}
+
+//====================================================
+// Left after the '<' of the tag
+bool XMLInSituReader::ParseStartTag(unsigned parent, bool * selfClosed) {
+    ASSERTGR(m_numNodes < m_maxNodes);
+    InSituNode & node   = m_nodes[m_numNodes++];
+    node.value.start    = s_noNode;
+    node.value.len      = 0;
+    node.firstAttribute = m_numAttributes;
+    node.numAttributes  = 0;
+    node.parent         = parent;
+    node.firstChild     = s_noNode;
+    node.nextSibling    = s_noNode;
+    if (!ParseName(&node.name)) 
+        return false;
+    node.nameHash = HashToken(node.name);
+
+    for (;;) {
+        SkipSpace();
+        if (m_pos == m_end) 
+            return false;
+
+        if (*m_pos == '>') {
+            m_pos++;
+            *selfClosed = false;
+            return true;
+        }
+        if (Match("/>")) {
+            m_pos += 2;
+            *selfClosed = true;
+            return true;
+        }
+
+        // Attributes without a value weren't counted
+        if (m_numAttributes == m_maxAttributes) 
+            return false;
+        InSituAttribute & attribute = m_attributes[m_numAttributes];
+        if (!ParseName(&attribute.name)) 
+            return false;
+        attribute.nameHash = HashToken(attribute.name);
+        SkipSpace();
+        if (m_pos == m_end || *m_pos++ != '=') 
+            return false;
+        SkipSpace();
+        if (!ParseAttributeValue(&attribute.value)) 
+            return false;
+        m_numAttributes++;
+        node.numAttributes++;
+    }
+}
+
+//====================================================
+// Left after the "</" of the tag
+bool XMLInSituReader::ParseEndTag(unsigned node) {
+    Token name;
+    if (!ParseName(&name)) 
+        return false;
+
+    const Token & openName = m_nodes[node].name;
+    if (name.len != openName.len || memcmp(m_text + name.start, m_text + openName.start, name.len) != 0) 
+        return false;
+
+    return SkipPast(">");
+}
+
+//====================================================
+bool XMLInSituReader::ParseName(Token * token) {
+    charsys * start = m_pos;
+    while (m_pos < m_end && !IsNameEnd(*m_pos)) 
+        m_pos++;
+
+    *token = MakeToken(start, m_pos);
+    return m_pos > start;
+}
+
+//====================================================
+// Entities are decoded over the value itself, which never grows
+bool XMLInSituReader::ParseAttributeValue(Token * token) {
+    if (m_pos == m_end || (*m_pos != '"' && *m_pos != '\'')) 
+        return false;
+    charsys quote = *m_pos++;
+
+    charsys * start = m_pos;
+    charsys * out   = m_pos;
+    while (m_pos < m_end) {
+        charsys c = *m_pos++;
+        if (c == quote) {
+            *token = MakeToken(start, out);
+            return true;
+        }
+
+        if (c == '&') 
+            DecodeEntity(&out);
+        else
+            *out++ = c;
+    }
+
+    return false;
+}
+
+//====================================================
+// Text up to the first child is the value, condensed over itself the way 
+//  the DOM backend condenses white space. CDATA is kept as it is.
+void XMLInSituReader::ParseValue(InSituNode * node) {
+    charsys * start = m_pos;
+    charsys * out   = m_pos;
+    bool space = false;
+    while (m_pos < m_end) {
+        charsys c = *m_pos;
+        if (c == '<') {
+            if (Match("<!--")) {
+                SkipPast("-->");
+                continue;
+            }
+            if (!Match("<![CDATA[")) 
+                break;
+
+            if (space && out > start) 
+                *out++ = ' ';
+            space = false;
+            m_pos += 9;
+            while (m_pos < m_end && !Match("]]>")) 
+                *out++ = *m_pos++;
+            if (m_pos < m_end) 
+                m_pos += 3;
+            continue;
+        }
+
+        m_pos++;
+        if (IsSpace(c)) {
+            space = true;
+            continue;
+        }
+        if (space && out > start) 
+            *out++ = ' ';
+        space = false;
+
+        if (c == '&') 
+            DecodeEntity(&out);
+        else
+            *out++ = c;
+    }
+
+    if (out > start) 
+        node->value = MakeToken(start, out);
+}
+
+//====================================================
+// Decodes the entity after a '&' into UTF-8 at out, which trails the read 
+//  position. Unknown entities are kept as text.
+void XMLInSituReader::DecodeEntity(charsys ** out) {
+    charsys * dest = *out;
+    char entity[s_maxEntityLength + 1];
+    unsigned len = 0;
+    while (len < s_maxEntityLength && m_pos < m_end) {
+        charsys c = *m_pos;
+        if (c == ';' || c == '<' || c == '&' || IsSpace(c)) 
+            break;
+        entity[len++] = c;
+        m_pos++;
+    }
+    entity[len] = 0;
+
+    unsigned code = 0;
+    bool terminated = m_pos < m_end && *m_pos == ';';
+    if (terminated) {
+        m_pos++;
+        if (strcmp(entity, "amp") == 0) 
+            code = '&';
+        else if (strcmp(entity, "lt") == 0) 
+            code = '<';
+        else if (strcmp(entity, "gt") == 0) 
+            code = '>';
+        else if (strcmp(entity, "quot") == 0) 
+            code = '"';
+        else if (strcmp(entity, "apos") == 0) 
+            code = '\'';
+        else if (entity[0] == '#') 
+            code = entity[1] == 'x' ? strtoul(entity + 2, NULL, 16) : strtoul(entity + 1, NULL, 10);
+    }
+
+    if (code == 0 || code > 0x10ffff) {
+        *dest++ = '&';
+        for (unsigned i = 0; i < len; i++) 
+            *dest++ = entity[i];
+        if (terminated) 
+            *dest++ = ';';
+    }
+    else if (code < 0x80) 
+        *dest++ = static_cast<charsys>(code);
+    else if (code < 0x800) {
+        *dest++ = static_cast<charsys>(0xc0 | (code >> 6));
+        *dest++ = static_cast<charsys>(0x80 | (code & 0x3f));
+    }
+    else if (code < 0x10000) {
+        *dest++ = static_cast<charsys>(0xe0 | (code >> 12));
+        *dest++ = static_cast<charsys>(0x80 | ((code >> 6) & 0x3f));
+        *dest++ = static_cast<charsys>(0x80 | (code & 0x3f));
+    }
+    else {
+        *dest++ = static_cast<charsys>(0xf0 | (code >> 18));
+        *dest++ = static_cast<charsys>(0x80 | ((code >> 12) & 0x3f));
+        *dest++ = static_cast<charsys>(0x80 | ((code >> 6) & 0x3f));
+        *dest++ = static_cast<charsys>(0x80 | (code & 0x3f));
+    }
+
+    *out = dest;
+}
+
+} // namespace NSXMLInSitu
+
+//////////////////////////////////////////////////////
+//
+// External functions
+//
+
+//====================================================
+static IStructuredTextStreamPtr OpenInSitu(charsys * text, unsigned size, bool ownsText, const chargr * name) {
+    NSXMLInSitu::XMLInSituReader * reader = new(XML_INSITU_MEM_FLAGS) NSXMLInSitu::XMLInSituReader(text, size, ownsText, name);
+    if (!reader->Open()) {
+        delete reader;
+        reader = NULL;
+    }
+
+    return IStructuredTextStreamPtr(reader);
+}
+
+//====================================================
+IStructuredTextStreamPtr StreamOpenXMLInSitu(charsys * text, unsigned size, const chargr * name) {
+    return OpenInSitu(text, size, false, name);
+}
+
+//====================================================
+IStructuredTextStreamPtr StreamOpenXMLInSitu(IRawStreamPtr source, const chargr * name) {
+    if (source == NULL) 
+        return IStructuredTextStreamPtr(NULL);
+
+    unsigned size = 0;
+    charsys * text = NSXMLInSitu::ReadAll(source, &size);
+    return OpenInSitu(text, size, true, name);
+}
+
+//====================================================
+IStructuredTextStreamPtr StreamOpenXMLInSitu(const chargr * fileName) {
+    return StreamOpenXMLInSitu(StreamOpenFile(fileName), fileName);
+}
@@ -0,0 +1,810 @@
+/*
+   GameRiff - Framework for creating various video game services
+   Forward only XML reader
+   Copyright (C) 2011, Shaun Leach.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are
+   met:
+  
+       * Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+       * Redistributions in binary form must reproduce the above
+   copyright notice, this list of conditions and the following disclaimer
+   in the documentation and/or other materials provided with the
+   distribution.
+  
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include "Pch.h"
+
+namespace NSXMLReader {
+
+//////////////////////////////////////////////////////
+//
+// Constants
+//
+
+#define XML_READER_MEM_FLAGS (MemFlags(MEM_ARENA_DEFAULT, MEM_CAT_XML))
+
+static const unsigned   s_readBlockSize     = 16 * 1024;
+static const unsigned   s_maxDepth          = 256;
+static const unsigned   s_noValue           = 0xffffffff;
+static const unsigned   s_maxEntityLength   = 10;
+
+//////////////////////////////////////////////////////
+//
+// Internal
+//
+
+// Strings of a node are kept in the text stack, name first, then the 
+//  attributes as name and value pairs, each after the hash of its name, 
+//  then the value
+struct XMLNode {
+    Hash32      nameHash;
+    unsigned    textStart;
+    unsigned    firstAttribute;
+    unsigned    numAttributes;
+    unsigned    value;          // s_noValue without text before the first child
+    bool        closed;         // End tag read or the tag closed itself
+};
+
+// Only the chain of nodes from the document to the current node is held. 
+//  Every node in the chain but the last is open, and the reader is inside 
+//  the deepest open node, past whatever was read of it.
+class XMLReader : public IStructuredTextStream {
+public:
+    XMLReader(IRawStreamPtr source, const chargr * name);
+    ~XMLReader();
+
+    bool Open();
+
+    const chargr * GetName() const;
+
+    EStreamError Save();
+
+    EStreamError WriteNode(const chargr * name);
+    EStreamError WriteNodeValue(const chargr * value);
+    EStreamError EndNode();
+    EStreamError WriteNodeAttribute(const chargr * name, const chargr * value);
+
+    EStreamError ReadNodeName(chargr * name, unsigned len);
+    EStreamError ReadNextNode();
+    EStreamError ReadParentNode();
+    EStreamError ReadNodeValue(chargr * value, unsigned len) const;
+    EStreamError ReadNodeAttribute(
+        const chargr  * name, 
+        unsigned        nameLen,
+        chargr        * value, 
+        unsigned        len
+    ) const;
+    EStreamError ReadChildNode();
+
+    EStreamError ReadNodeNameView(StreamTextView * name) const;
+    EStreamError ReadNodeValueView(StreamTextView * value) const;
+    EStreamError ReadNodeAttributeView(const charsys * name, StreamTextView * value) const;
+
+    EStreamError ReadNodeNameHash(Hash32 * name) const;
+    EStreamError ReadNodeAttributeHash(Hash32 name, Hash32 * value) const;
+
+private:
+    enum EMarkup {
+        MARKUP_START,   // Left after the '<' of a start tag
+        MARKUP_END,     // Tag name is at m_endName
+        MARKUP_EOF,
+    };
+
+    int Peek() {
+        if (m_pos == m_end && !Fill(1)) 
+            return -1;
+        return m_block[m_pos];
+    }
+    int Next() {
+        if (m_pos == m_end && !Fill(1)) 
+            return -1;
+        return m_block[m_pos++];
+    }
+    void Append(int c) {
+        if (m_textUsed == m_textCapacity) 
+            GrowText();
+        m_text[m_textUsed++] = static_cast<charsys>(c);
+    }
+
+    bool Fill(unsigned count);
+    bool Match(const char * str);
+    bool SkipPast(const char * terminator);
+    void SkipSpace();
+    void GrowText();
+
+    EMarkup ReadMarkup();
+    bool ReadStartTag(XMLNode * node);
+    bool ReadName();
+    bool ReadAttributeName();
+    const charsys * FindAttribute(const XMLNode & node, Hash32 name) const;
+    bool ReadAttributeValue(int quote);
+    void ReadValue(XMLNode * node);
+    void ReadEntity();
+    bool SkipTag(bool * selfClosed);
+    bool SkipNode(XMLNode * node);
+    void CloseNode(unsigned depth, EMarkup markup);
+    void Fail();
+
+private:
+    IRawStreamPtr   m_source;
+    chargr          m_name[256];
+
+    byte            m_block[s_readBlockSize];
+    unsigned        m_pos;
+    unsigned        m_end;
+    bool            m_eof;
+
+    charsys       * m_text;
+    unsigned        m_textUsed;
+    unsigned        m_textCapacity;
+    unsigned        m_endName;
+
+    XMLNode         m_nodes[s_maxDepth];
+    unsigned        m_depth;
+};
+
+//====================================================
+static bool IsSpace(int c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+//====================================================
+static bool IsNameEnd(int c) {
+    return c == -1 || IsSpace(c) || c == '/' || c == '>' || c == '=';
+}
+
+//====================================================
+XMLReader::XMLReader(IRawStreamPtr source, const chargr * name) :
+    m_source(source),
+    m_pos(0),
+    m_end(0),
+    m_eof(false),
+    m_text(NULL),
+    m_textUsed(0),
+    m_textCapacity(0),
+    m_endName(0),
+    m_depth(0)
+{
+    StrCopy(m_name, 256, name);
+}
+
+//====================================================
+XMLReader::~XMLReader() {
+    if (m_text != NULL) 
+        delete [] m_text;
+}
+
+//====================================================
+bool XMLReader::Open() {
+    // The document is the root of the chain and has no name
+    XMLNode & document      = m_nodes[0];
+    document.nameHash       = HashUtf8String32("", 0);
+    document.textStart      = 0;
+    document.firstAttribute = 1;
+    document.numAttributes  = 0;
+    document.value          = s_noValue;
+    document.closed         = false;
+    Append(0);
+
+    return ReadChildNode() == STREAM_ERROR_OK;
+}
+
+//====================================================
+const chargr * XMLReader::GetName() const {
+    return m_name;
+}
+
+//====================================================
+EStreamError XMLReader::Save() {
+    ASSERTMSGGR(false, "XML readers are read only");
+    return STREAM_ERROR_FILENOTOPENED;
+}
+
+//====================================================
+EStreamError XMLReader::WriteNode(const chargr * name) {
+    ASSERTMSGGR(false, "XML readers are read only");
+    return STREAM_ERROR_FILENOTOPENED;
+}
+
+//====================================================
+EStreamError XMLReader::WriteNodeValue(const chargr * value) {
+    ASSERTMSGGR(false, "XML readers are read only");
+    return STREAM_ERROR_FILENOTOPENED;
+}
+
+//====================================================
+EStreamError XMLReader::EndNode() {
+    ASSERTMSGGR(false, "XML readers are read only");
+    return STREAM_ERROR_FILENOTOPENED;
+}
+
+//====================================================
+EStreamError XMLReader::WriteNodeAttribute(const chargr * name, const chargr * value) {
+    ASSERTMSGGR(false, "XML readers are read only");
+    return STREAM_ERROR_FILENOTOPENED;
+}
+
+//====================================================
+EStreamError XMLReader::ReadNodeName(chargr * name, unsigned len) {
+    StrUtf8ConvertToCharGr(m_text + m_nodes[m_depth].textStart, name, len);
+
+    return STREAM_ERROR_OK;
+}
+
+//====================================================
+EStreamError XMLReader::ReadChildNode() {
+    XMLNode & node = m_nodes[m_depth];
+    if (node.closed) 
+        return STREAM_ERROR_NODEDOESNTEXIST;
+
+    EMarkup markup = ReadMarkup();
+    if (markup != MARKUP_START) {
+        CloseNode(m_depth, markup);
+        return STREAM_ERROR_NODEDOESNTEXIST;
+    }
+
+    if (m_depth + 1 == s_maxDepth || !ReadStartTag(&m_nodes[m_depth + 1])) {
+        Fail();
+        return STREAM_ERROR_NODEDOESNTEXIST;
+    }
+
+    m_depth++;
+    return STREAM_ERROR_OK;
+}
+
+//====================================================
+EStreamError XMLReader::ReadNextNode() {
+    if (m_depth == 0 || m_nodes[m_depth - 1].closed) 
+        return STREAM_ERROR_NODEDOESNTEXIST;
+
+    // Children that weren't visited are passed over
+    XMLNode & node = m_nodes[m_depth];
+    if (!node.closed && !SkipNode(&node)) {
+        Fail();
+        return STREAM_ERROR_NODEDOESNTEXIST;
+    }
+
+    EMarkup markup = ReadMarkup();
+    if (markup != MARKUP_START) {
+        CloseNode(m_depth - 1, markup);
+        return STREAM_ERROR_NODEDOESNTEXIST;
+    }
+
+    // The sibling takes the node's place in the chain
+    m_textUsed = node.textStart;
+    if (!ReadStartTag(&node)) {
+        Fail();
+        return STREAM_ERROR_NODEDOESNTEXIST;
+    }
+
+    return STREAM_ERROR_OK;
+}
+
+//====================================================
+EStreamError XMLReader::ReadParentNode() {
+    if (m_depth == 0) 
+        return STREAM_ERROR_NODEDOESNTEXIST;
+
+    XMLNode & node = m_nodes[m_depth];
+    if (!node.closed && !SkipNode(&node)) 
+        Fail();
+
+    m_textUsed = node.textStart;
+    m_depth--;
+    return STREAM_ERROR_OK;
+}
+
+//====================================================
+EStreamError XMLReader::ReadNodeValue(chargr * value, unsigned len) const {
+    const XMLNode & node = m_nodes[m_depth];
+    if (node.value == s_noValue) {
+        value[0] = L'\0';
+        return STREAM_ERROR_NODEDOESNTEXIST;
+    }
+
+    StrUtf8ConvertToCharGr(m_text + node.value, value, len);
+
+    return STREAM_ERROR_OK;
+}
+
+//====================================================
+EStreamError XMLReader::ReadNodeAttribute(
+    const chargr  * name, 
+    unsigned        nameLen, 
+    chargr        * value, 
+    unsigned        valueLen
+) const {
+    value[0] = L'\0';
+
+    StreamTextView view;
+    StrStackConverter sysName(name, nameLen);
+    if (ReadNodeAttributeView(sysName, &view) != STREAM_ERROR_OK) 
+        return STREAM_ERROR_BADDATA;
+
+    StrUtf8ConvertToCharGr(view.str, value, valueLen);
+    return STREAM_ERROR_OK;
+}
+
+//====================================================
+EStreamError XMLReader::ReadNodeNameView(StreamTextView * name) const {
+    name->str = m_text + m_nodes[m_depth].textStart;
+    name->len = strlen(name->str);
+
+    return STREAM_ERROR_OK;
+}
+
+//====================================================
+EStreamError XMLReader::ReadNodeValueView(StreamTextView * value) const {
+    const XMLNode & node = m_nodes[m_depth];
+    if (node.value == s_noValue) {
+        value->str = "";
+        value->len = 0;
+        return STREAM_ERROR_NODEDOESNTEXIST;
+    }
+
+    value->str = m_text + node.value;
+    value->len = strlen(value->str);
+
+    return STREAM_ERROR_OK;
+}
+
+//====================================================
+EStreamError XMLReader::ReadNodeAttributeView(const charsys * name, StreamTextView * value) const {
+    const XMLNode & node = m_nodes[m_depth];
+    const charsys * attribute = m_text + node.firstAttribute;
+    for (unsigned i = 0; i < node.numAttributes; i++) {
+        const charsys * attributeName   = attribute + sizeof(uint32);
+        const charsys * attributeValue  = attributeName + strlen(attributeName) + 1;
+        if (strcmp(attributeName, name) == 0) {
+            value->str = attributeValue;
+            value->len = strlen(attributeValue);
+            return STREAM_ERROR_OK;
+        }
+        attribute = attributeValue + strlen(attributeValue) + 1;
+    }
+
+    value->str = "";
+    value->len = 0;
+    return STREAM_ERROR_BADDATA;
+}
+
+//====================================================
+EStreamError XMLReader::ReadNodeNameHash(Hash32 * name) const {
+    *name = m_nodes[m_depth].nameHash;
+
+    return STREAM_ERROR_OK;
+}
+
+//====================================================
+EStreamError XMLReader::ReadNodeAttributeHash(Hash32 name, Hash32 * value) const {
+    const charsys * attributeValue = FindAttribute(m_nodes[m_depth], name);
+    if (attributeValue == NULL) 
+        return STREAM_ERROR_BADDATA;
+
+    *value = HashUtf8String32(attributeValue, strlen(attributeValue));
+    return STREAM_ERROR_OK;
+}
+
+//====================================================
+// The value of the attribute with the hashed name or NULL
+const charsys * XMLReader::FindAttribute(const XMLNode & node, Hash32 name) const {
+    const charsys * attribute = m_text + node.firstAttribute;
+    for (unsigned i = 0; i < node.numAttributes; i++) {
+        uint32 nameHash;
+        memcpy(&nameHash, attribute, sizeof(nameHash));
+        const charsys * attributeName   = attribute + sizeof(uint32);
+        const charsys * attributeValue  = attributeName + strlen(attributeName) + 1;
+        if (nameHash == name.GetValue()) 
+            return attributeValue;
+        attribute = attributeValue + strlen(attributeValue) + 1;
+    }
+
+    return NULL;
+}
+
+//====================================================
+// Makes count bytes available to look ahead, false if the file ends first
+bool XMLReader::Fill(unsigned count) {
+    if (m_end - m_pos >= count) 
+        return true;
+
+    memmove(m_block, m_block + m_pos, m_end - m_pos);
+    m_end -= m_pos;
+    m_pos  = 0;
+    while (m_end < count && !m_eof) {
+        unsigned read = 0;
+        m_source->ReadBytes(m_block + m_end, s_readBlockSize - m_end, &read);
+        if (read == 0) 
+            m_eof = true;
+        m_end += read;
+    }
+
+    return m_end >= count;
+}
+
+//====================================================
+bool XMLReader::Match(const char * str) {
+    unsigned len = strlen(str);
+    if (!Fill(len) || memcmp(m_block + m_pos, str, len) != 0) 
+        return false;
+
+    m_pos += len;
+    return true;
+}
+
+//====================================================
+bool XMLReader::SkipPast(const char * terminator) {
+    while (!Match(terminator)) {
+        if (Next() == -1) 
+            return false;
+    }
+
+    return true;
+}
+
+//====================================================
+void XMLReader::SkipSpace() {
+    while (IsSpace(Peek())) 
+        m_pos++;
+}
+
+//====================================================
+void XMLReader::GrowText() {
+    unsigned newCapacity = m_textCapacity == 0 ? 1024 : 2 * m_textCapacity;
+    charsys * newText = new(XML_READER_MEM_FLAGS) charsys[newCapacity];
+    if (m_textUsed > 0) 
+        memcpy(newText, m_text, m_textUsed);
+    if (m_text != NULL) 
+        delete [] m_text;
+    m_text          = newText;
+    m_textCapacity  = newCapacity;
+}
+
+//====================================================
+// Passes over text, comments, processing instructions and declarations to 
+//  the next tag of the deepest open node
+XMLReader::EMarkup XMLReader::ReadMarkup() {
+    for (;;) {
+        const void * found = memchr(m_block + m_pos, '<', m_end - m_pos);
+        while (found == NULL) {
+            m_pos = m_end;
+            if (!Fill(1)) 
+                return MARKUP_EOF;
+            found = memchr(m_block + m_pos, '<', m_end - m_pos);
+        }
+        m_pos = static_cast<unsigned>(reinterpret_cast<const byte *>(found) - m_block) + 1;
+
+        int c = Peek();
+        if (c == '?') 
+            SkipPast("?>");
+        else if (c == '!') {
+            if (Match("!--")) 
+                SkipPast("-->");
+            else if (Match("![CDATA[")) 
+                SkipPast("]]>");
+            else
+                SkipPast(">");
+        }
+        else if (c == '/') {
+            // The name is left above the text in use, the next node reuses it
+            m_pos++;
+            unsigned textUsed = m_textUsed;
+            m_endName = m_textUsed;
+            ReadName();
+            Append(0);
+            m_textUsed = textUsed;
+            SkipPast(">");
+            return MARKUP_END;
+        }
+        else
+            return MARKUP_START;
+    }
+}
+
+//====================================================
+bool XMLReader::ReadName() {
+    unsigned start = m_textUsed;
+    while (!IsNameEnd(Peek())) 
+        Append(m_block[m_pos++]);
+
+    return m_textUsed > start;
+}
+
+//====================================================
+// The name is kept after its hash
+bool XMLReader::ReadAttributeName() {
+    unsigned hashStart = m_textUsed;
+    for (unsigned i = 0; i < sizeof(uint32); i++) 
+        Append(0);
+
+    unsigned nameStart = m_textUsed;
+    if (!ReadName()) 
+        return false;
+
+    uint32 hash = HashUtf8String32(m_text + nameStart, m_textUsed - nameStart).GetValue();
+    memcpy(m_text + hashStart, &hash, sizeof(hash));
+    Append(0);
+    return true;
+}
+
+//====================================================
+bool XMLReader::ReadStartTag(XMLNode * node) {
+    node->textStart = m_textUsed;
+    node->value     = s_noValue;
+    node->closed    = false;
+    if (!ReadName()) 
+        return false;
+    node->nameHash = HashUtf8String32(m_text + node->textStart, m_textUsed - node->textStart);
+    Append(0);
+
+    node->firstAttribute    = m_textUsed;
+    node->numAttributes     = 0;
+    for (;;) {
+        SkipSpace();
+        int c = Peek();
+        if (c == '>') {
+            m_pos++;
+            break;
+        }
+        if (c == '/') {
+            m_pos++;
+            node->closed = true;
+            return Next() == '>';
+        }
+
+        if (!ReadAttributeName()) 
+            return false;
+        SkipSpace();
+        if (Next() != '=') 
+            return false;
+        SkipSpace();
+        if (!ReadAttributeValue(Next())) 
+            return false;
+        Append(0);
+        node->numAttributes++;
+    }
+
+    ReadValue(node);
+    return true;
+}
+
+//====================================================
+bool XMLReader::ReadAttributeValue(int quote) {
+    if (quote != '"' && quote != '\'') 
+        return false;
+
+    for (;;) {
+        int c = Next();
+        if (c == -1) 
+            return false;
+        if (c == quote) 
+            return true;
+
+        if (c == '&') 
+            ReadEntity();
+        else
+            Append(c);
+    }
+}
+
+//====================================================
+// Text up to the first child is the value. White space is condensed the 
+//  way the DOM backend does, and CDATA is kept as it is.
+void XMLReader::ReadValue(XMLNode * node) {
+    unsigned start = m_textUsed;
+    bool space = false;
+    for (;;) {
+        int c = Peek();
+        if (c == -1) 
+            break;
+
+        if (c == '<') {
+            if (Match("<!--")) {
+                SkipPast("-->");
+                continue;
+            }
+            if (!Match("<![CDATA[")) 
+                break;
+
+            if (space && m_textUsed > start) 
+                Append(' ');
+            space = false;
+            while (!Match("]]>") && (c = Next()) != -1) 
+                Append(c);
+            continue;
+        }
+
+        m_pos++;
+        if (IsSpace(c)) {
+            space = true;
+            continue;
+        }
+        if (space && m_textUsed > start) 
+            Append(' ');
+        space = false;
+
+        if (c == '&') 
+            ReadEntity();
+        else
+            Append(c);
+    }
+
+    if (m_textUsed > start) {
+        Append(0);
+        node->value = start;
+    }
+}
+
+//====================================================
+// Decodes the entity after a '&' into UTF-8, unknown ones are kept as text
+void XMLReader::ReadEntity() {
+    char entity[s_maxEntityLength + 1];
+    unsigned len = 0;
+    int c = Peek();
+    while (len < s_maxEntityLength && c != -1 && c != ';' && c != '<' && c != '&' && !IsSpace(c)) {
+        entity[len++] = static_cast<char>(c);
+        m_pos++;
+        c = Peek();
+    }
+    entity[len] = 0;
+
+    if (c != ';') {
+        Append('&');
+        for (unsigned i = 0; i < len; i++) 
+            Append(entity[i]);
+        return;
+    }
+    m_pos++;
+
+    unsigned code = 0;
+    if (strcmp(entity, "amp") == 0) 
+        code = '&';
+    else if (strcmp(entity, "lt") == 0) 
+        code = '<';
+    else if (strcmp(entity, "gt") == 0) 
+        code = '>';
+    else if (strcmp(entity, "quot") == 0) 
+        code = '"';
+    else if (strcmp(entity, "apos") == 0) 
+        code = '\'';
+    else if (entity[0] == '#') 
+        code = entity[1] == 'x' ? strtoul(entity + 2, NULL, 16) : strtoul(entity + 1, NULL, 10);
+
+    if (code == 0 || code > 0x10ffff) {
+        Append('&');
+        for (unsigned i = 0; i < len; i++) 
+            Append(entity[i]);
+        Append(';');
+    }
+    else if (code < 0x80) 
+        Append(code);
+    else if (code < 0x800) {
+        Append(0xc0 | (code >> 6));
+        Append(0x80 | (code & 0x3f));
+    }
+    else if (code < 0x10000) {
+        Append(0xe0 | (code >> 12));
+        Append(0x80 | ((code >> 6) & 0x3f));
+        Append(0x80 | (code & 0x3f));
+    }
+    else {
+        Append(0xf0 | (code >> 18));
+        Append(0x80 | ((code >> 12) & 0x3f));
+        Append(0x80 | ((code >> 6) & 0x3f));
+        Append(0x80 | (code & 0x3f));
+    }
+}
+
+//====================================================
+// Passes over a start tag without keeping it
+bool XMLReader::SkipTag(bool * selfClosed) {
+    int quote = 0;
+    int prev  = 0;
+    for (;;) {
+        int c = Next();
+        if (c == -1) 
+            return false;
+
+        if (quote != 0) {
+            if (c == quote) 
+                quote = 0;
+        }
+        else if (c == '"' || c == '\'') 
+            quote = c;
+        else if (c == '>') {
+            *selfClosed = prev == '/';
+            return true;
+        }
+        prev = c;
+    }
+}
+
+//====================================================
+// Reads to the end tag of an open node, only nesting is checked
+bool XMLReader::SkipNode(XMLNode * node) {
+    unsigned level = 0;
+    for (;;) {
+        EMarkup markup = ReadMarkup();
+        if (markup == MARKUP_EOF) 
+            return false;
+
+        if (markup == MARKUP_START) {
+            bool selfClosed = false;
+            if (!SkipTag(&selfClosed)) 
+                return false;
+            if (!selfClosed) 
+                level++;
+        }
+        else if (level == 0) {
+            node->closed = true;
+            return true;
+        }
+        else
+            level--;
+    }
+}
+
+//====================================================
+void XMLReader::CloseNode(unsigned depth, EMarkup markup) {
+    XMLNode & node = m_nodes[depth];
+    if (markup == MARKUP_EOF) {
+        // Only the document ends with the file
+        if (depth == 0) 
+            node.closed = true;
+        else
+            Fail();
+    }
+    else if (depth == 0 || strcmp(m_text + m_endName, m_text + node.textStart) != 0) 
+        Fail();
+    else
+        node.closed = true;
+}
+
+//====================================================
+// Malformed files end the traversal, the nodes already read stay readable
+void XMLReader::Fail() {
+    for (unsigned i = 0; i <= m_depth; i++) 
+        m_nodes[i].closed = true;
+}
+
+} // namespace NSXMLReader
+
+//////////////////////////////////////////////////////
+//
+// External functions
+//
+
+//====================================================
+IStructuredTextStreamPtr StreamOpenXMLReader(IRawStreamPtr source, const chargr * name) {
+    if (source == NULL) 
+        return IStructuredTextStreamPtr(NULL);
+
+    NSXMLReader::XMLReader * reader = new(XML_READER_MEM_FLAGS) NSXMLReader::XMLReader(source, name);
+    if (!reader->Open()) {
+        delete reader;
+        reader = NULL;
+    }
+
+    return IStructuredTextStreamPtr(reader);
+}
+
+//====================================================
+IStructuredTextStreamPtr StreamOpenXMLReader(const chargr * fileName) {
+    return StreamOpenXMLReader(StreamOpenFile(fileName), fileName);
+}
@@ -72,9 +72,17 @@ public:
     ) const;
     EStreamError ReadChildNode();
 
+    EStreamError ReadNodeNameView(StreamTextView * name) const;
+    EStreamError ReadNodeValueView(StreamTextView * value) const;
+    EStreamError ReadNodeAttributeView(const charsys * name, StreamTextView * value) const;
+
+    EStreamError ReadNodeNameHash(Hash32 * name) const;
+    EStreamError ReadNodeAttributeHash(Hash32 name, Hash32 * value) const;
+
 private:
 
     EStreamError DecodeTiXmlError();
+    EStreamError ParsePacked(IRawStreamPtr stream, unsigned size);
 
 private:
     chargr          m_name[256];
@@ -134,12 +142,19 @@ EStreamError XMLTextStream::Open(const chargr *fileName) {
 
     m_document = new(XML_MEM_FLAGS) TiXmlDocument();
 
-    charsys * sysfile = StrCreateUtf8(fileName, XML_MEM_FLAGS);
-    bool tiResult = m_document->LoadFile(sysfile, TIXML_ENCODING_UTF8);
-    if (!tiResult) {
-        delete m_document;
-        m_document = NULL;
-        result = DecodeTiXmlError();
+    unsigned packedSize = 0;
+    IRawStreamPtr packed = StreamOpenPacked(fileName, &packedSize);
+    if (packed != NULL) {
+        result = ParsePacked(packed, packedSize);
+    }
+    else {
+        charsys * sysfile = StrCreateUtf8(fileName, XML_MEM_FLAGS);
+        bool tiResult = m_document->LoadFile(sysfile, TIXML_ENCODING_UTF8);
+        if (!tiResult) {
+            delete m_document;
+            m_document = NULL;
+            result = DecodeTiXmlError();
+        }
     }
 
     if (result == STREAM_ERROR_OK) {
@@ -328,6 +343,109 @@ EStreamError XMLTextStream::ReadNodeAttribute(
     return result;
 }
 
+//====================================================
+EStreamError XMLTextStream::ReadNodeNameView(StreamTextView * name) const {
+    if (m_document == NULL || m_currentNode == NULL) 
+        return STREAM_ERROR_FILENOTOPENED;
+
+    name->str = m_currentNode->Value();
+    name->len = strlen(name->str);
+
+    return STREAM_ERROR_OK;
+}
+
+//====================================================
+EStreamError XMLTextStream::ReadNodeValueView(StreamTextView * value) const {
+    value->str = "";
+    value->len = 0;
+
+    if (m_document == NULL || m_currentNode == NULL) 
+        return STREAM_ERROR_FILENOTOPENED;
+
+    TiXmlNode * child = m_currentNode->FirstChild();
+    if (child == NULL || child->Type() != TiXmlNode::TEXT) 
+        return STREAM_ERROR_NODEDOESNTEXIST;
+
+    value->str = child->Value();
+    value->len = strlen(value->str);
+
+    return STREAM_ERROR_OK;
+}
+
+//====================================================
+EStreamError XMLTextStream::ReadNodeAttributeView(const charsys * name, StreamTextView * value) const {
+    value->str = "";
+    value->len = 0;
+
+    if (m_document == NULL || m_currentNode == NULL) 
+        return STREAM_ERROR_FILENOTOPENED;
+
+    TiXmlElement * node = m_currentNode->ToElement();
+    if (node == NULL) 
+        return STREAM_ERROR_BADDATA;
+
+    const char * attr = node->Attribute(name);
+    if (attr == NULL) 
+        return STREAM_ERROR_BADDATA;
+
+    value->str = attr;
+    value->len = strlen(attr);
+
+    return STREAM_ERROR_OK;
+}
+
+//====================================================
+EStreamError XMLTextStream::ReadNodeNameHash(Hash32 * name) const {
+    if (m_document == NULL || m_currentNode == NULL) 
+        return STREAM_ERROR_FILENOTOPENED;
+
+    // The document keeps no hashes, they're made as they're asked for
+    const char * nodeName = m_currentNode->Value();
+    *name = HashUtf8String32(nodeName, strlen(nodeName));
+
+    return STREAM_ERROR_OK;
+}
+
+//====================================================
+EStreamError XMLTextStream::ReadNodeAttributeHash(Hash32 name, Hash32 * value) const {
+    if (m_document == NULL || m_currentNode == NULL) 
+        return STREAM_ERROR_FILENOTOPENED;
+
+    TiXmlElement * node = m_currentNode->ToElement();
+    if (node == NULL) 
+        return STREAM_ERROR_BADDATA;
+
+    for (const TiXmlAttribute * attr = node->FirstAttribute(); attr != NULL; attr = attr->Next()) {
+        if (HashUtf8String32(attr->Name(), strlen(attr->Name())) == name) {
+            *value = HashUtf8String32(attr->Value(), strlen(attr->Value()));
+            return STREAM_ERROR_OK;
+        }
+    }
+
+    return STREAM_ERROR_BADDATA;
+}
+
+//====================================================
+EStreamError XMLTextStream::ParsePacked(IRawStreamPtr stream, unsigned size) {
+    // Packed files are parsed from memory, which needs a terminator
+    char * text = new(XML_MEM_FLAGS) char[size + 1];
+    EStreamError result = stream->ReadBytes(text, size, NULL);
+    text[size] = 0;
+
+    if (result == STREAM_ERROR_OK) {
+        m_document->Parse(text, NULL, TIXML_ENCODING_UTF8);
+        if (m_document->Error()) 
+            result = STREAM_ERROR_BADDATA;
+    }
+    delete [] text;
+
+    if (result != STREAM_ERROR_OK) {
+        delete m_document;
+        m_document = NULL;
+    }
+    return result;
+}
+
 //====================================================
 EStreamError XMLTextStream::DecodeTiXmlError() {
     EStreamError result = STREAM_ERROR_FILENOTOPENED;
@@ -377,4 +495,59 @@ IStructuredTextStreamPtr StreamCreateXML(const chargr * fileName) {
     return IStructuredTextStreamPtr(stream);
 }
 
+//====================================================
+bool StreamViewEquals(const StreamTextView & view, const charsys * str) {
+    for (unsigned i = 0; i < view.len; i++) {
+        charsys a = view.str[i];
+        charsys b = str[i];
+        if (b == 0) 
+            return false;
+        if (a >= 'A' && a <= 'Z') 
+            a += 'a' - 'A';
+        if (b >= 'A' && b <= 'Z') 
+            b += 'a' - 'A';
+        if (a != b) 
+            return false;
+    }
+
+    return str[view.len] == 0;
+}
+
+//====================================================
+unsigned StreamViewToCharGr(const StreamTextView & view, chargr * dest, unsigned len) {
+    const byte * src = reinterpret_cast<const byte *>(view.str);
+    const byte * end = src + view.len;
+    unsigned written = 0;
+    while (src < end && written + 1 < len) {
+        unsigned code = *src++;
+        unsigned extra = 0;
+        if (code >= 0xf0) {
+            code &= 0x07;
+            extra = 3;
+        }
+        else if (code >= 0xe0) {
+            code &= 0x0f;
+            extra = 2;
+        }
+        else if (code >= 0xc0) {
+            code &= 0x1f;
+            extra = 1;
+        }
+        for (; extra > 0 && src < end; extra--) 
+            code = (code << 6) | (*src++ & 0x3f);
+
+        // Characters outside of the basic plane don't fit in one chargr
+        dest[written++] = code < 0x10000 ? static_cast<chargr>(code) : L'?';
+    }
+    if (len > 0) 
+        dest[written] = L'\0';
+
+    return written;
+}
+
+//====================================================
+Hash32 StreamViewHash32(const StreamTextView & view) {
+    return HashUtf8String32(view.str, view.len);
+}
+
 
@@ -0,0 +1,382 @@
+/*
+   GameRiff - Framework for creating various video game services
+   Streaming XML writer
+   Copyright (C) 2011, Shaun Leach.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are
+   met:
+  
+       * Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+       * Redistributions in binary form must reproduce the above
+   copyright notice, this list of conditions and the following disclaimer
+   in the documentation and/or other materials provided with the
+   distribution.
+  
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include "Pch.h"
+
+namespace NSXMLWriter {
+
+//////////////////////////////////////////////////////
+//
+// Constants
+//
+
+#define XML_WRITER_MEM_FLAGS (MemFlags(MEM_ARENA_DEFAULT, MEM_CAT_XML))
+
+static const unsigned   s_maxDepth          = 256;
+static const unsigned   s_nameStackSize     = 4 * 1024;
+static const char       s_declaration[]     = "<?xml version=\"1.0\" ?>\n";
+static const char       s_indent[]          = "    ";
+
+//////////////////////////////////////////////////////
+//
+// Internal
+//
+
+// Writes each node as it's given in the layout TiXmlDocument::SaveFile 
+//  uses. Only the names of the open nodes are kept, for their end tags.
+class XMLWriter : public IStructuredTextStream {
+public:
+    XMLWriter(IRawStreamPtr target, const chargr * name);
+
+    const chargr * GetName() const;
+
+    EStreamError Save();
+
+    EStreamError WriteNode(const chargr * name);
+    EStreamError WriteNodeValue(const chargr * value);
+    EStreamError EndNode();
+    EStreamError WriteNodeAttribute(const chargr * name, const chargr * value);
+
+    EStreamError ReadNodeName(chargr * name, unsigned len);
+    EStreamError ReadNextNode();
+    EStreamError ReadParentNode();
+    EStreamError ReadNodeValue(chargr * value, unsigned len) const;
+    EStreamError ReadNodeAttribute(
+        const chargr  * name, 
+        unsigned        nameLen,
+        chargr        * value, 
+        unsigned        len
+    ) const;
+    EStreamError ReadChildNode();
+
+    EStreamError ReadNodeNameView(StreamTextView * name) const;
+    EStreamError ReadNodeValueView(StreamTextView * value) const;
+    EStreamError ReadNodeAttributeView(const charsys * name, StreamTextView * value) const;
+
+    EStreamError ReadNodeNameHash(Hash32 * name) const;
+    EStreamError ReadNodeAttributeHash(Hash32 name, Hash32 * value) const;
+
+private:
+    void Write(const char * str, unsigned len);
+    void WriteIndent(unsigned depth);
+    void WriteEscaped(const chargr * str);
+    void CloseStartTag();
+
+private:
+    DataStream      m_stream;
+    chargr          m_name[256];
+    EStreamError    m_result;
+
+    charsys         m_names[s_nameStackSize];
+    unsigned        m_nameStart[s_maxDepth + 1];
+    unsigned        m_depth;
+    unsigned        m_skipDepth;        // Nodes past the limits that aren't written
+    bool            m_startTagOpen;     // Attributes can still be added
+    bool            m_hasChildren;      // Whether the current node has child nodes
+};
+
+//====================================================
+XMLWriter::XMLWriter(IRawStreamPtr target, const chargr * name) :
+    m_stream(target),
+    m_result(STREAM_ERROR_OK),
+    m_depth(0),
+    m_skipDepth(0),
+    m_startTagOpen(false),
+    m_hasChildren(false)
+{
+    StrCopy(m_name, 256, name);
+    m_nameStart[0] = 0;
+    Write(s_declaration, sizeof(s_declaration) - 1);
+}
+
+//====================================================
+const chargr * XMLWriter::GetName() const {
+    return m_name;
+}
+
+//====================================================
+EStreamError XMLWriter::Save() {
+    ASSERTMSGGR(m_depth == 0, "Saving an XML file with nodes still open");
+
+    EStreamError result = m_stream.Flush();
+    if (m_result == STREAM_ERROR_OK) 
+        m_result = result;
+    return m_result;
+}
+
+//====================================================
+EStreamError XMLWriter::WriteNode(const chargr * name) {
+    // Names are kept as UTF-8, which takes at most three bytes a character
+    unsigned start = m_nameStart[m_depth];
+    unsigned len   = StrLen(name, s_nameStackSize);
+    if (m_skipDepth > 0 || m_depth == s_maxDepth || start + 3 * len + 1 > s_nameStackSize) {
+        m_skipDepth++;
+        return STREAM_ERROR_BADDATA;
+    }
+
+    StrConvertToUtf8(name, m_names + start, s_nameStackSize - start);
+    unsigned utf8Len = strlen(m_names + start);
+
+    CloseStartTag();
+    if (m_depth > 0) {
+        Write("\n", 1);
+        WriteIndent(m_depth);
+    }
+    Write("<", 1);
+    Write(m_names + start, utf8Len);
+
+    m_depth++;
+    m_nameStart[m_depth] = start + utf8Len + 1;
+    m_startTagOpen  = true;
+    m_hasChildren   = false;
+    return m_result;
+}
+
+//====================================================
+EStreamError XMLWriter::WriteNodeValue(const chargr * value) {
+    if (m_depth == 0 || m_skipDepth > 0) 
+        return STREAM_ERROR_BADDATA;
+
+    CloseStartTag();
+    WriteEscaped(value);
+    return m_result;
+}
+
+//====================================================
+EStreamError XMLWriter::EndNode() {
+    if (m_skipDepth > 0) {
+        m_skipDepth--;
+        return STREAM_ERROR_OK;
+    }
+    if (m_depth == 0) 
+        return STREAM_ERROR_BADDATA;
+
+    const charsys * name = m_names + m_nameStart[m_depth - 1];
+    if (m_startTagOpen) 
+        Write(" />", 3);
+    else {
+        if (m_hasChildren) {
+            Write("\n", 1);
+            WriteIndent(m_depth - 1);
+        }
+        Write("</", 2);
+        Write(name, strlen(name));
+        Write(">", 1);
+    }
+
+    m_depth--;
+    m_startTagOpen  = false;
+    m_hasChildren   = true;
+    if (m_depth == 0) 
+        Write("\n", 1);
+    return m_result;
+}
+
+//====================================================
+EStreamError XMLWriter::WriteNodeAttribute(const chargr * name, const chargr * value) {
+    if (m_skipDepth > 0) 
+        return STREAM_ERROR_BADDATA;
+
+    // The start tag is written once a child or value follows
+    ASSERTMSGGR(m_startTagOpen, "Attributes must be written before the node's children");
+    if (!m_startTagOpen) 
+        return STREAM_ERROR_BADDATA;
+
+    char quote = '"';
+    for (const chargr * c = value; *c != 0; c++) {
+        if (*c == L'"') 
+            quote = '\'';
+    }
+
+    Write(" ", 1);
+    WriteEscaped(name);
+    Write("=", 1);
+    Write(&quote, 1);
+    WriteEscaped(value);
+    Write(&quote, 1);
+    return m_result;
+}
+
+//====================================================
+EStreamError XMLWriter::ReadNodeName(chargr * name, unsigned len) {
+    ASSERTMSGGR(false, "XML writers are write only");
+    return STREAM_ERROR_FILENOTOPENED;
+}
+
+//====================================================
+EStreamError XMLWriter::ReadNextNode() {
+    ASSERTMSGGR(false, "XML writers are write only");
+    return STREAM_ERROR_NODEDOESNTEXIST;
+}
+
+//====================================================
+EStreamError XMLWriter::ReadParentNode() {
+    ASSERTMSGGR(false, "XML writers are write only");
+    return STREAM_ERROR_NODEDOESNTEXIST;
+}
+
+//====================================================
+EStreamError XMLWriter::ReadNodeValue(chargr * value, unsigned len) const {
+    ASSERTMSGGR(false, "XML writers are write only");
+    return STREAM_ERROR_FILENOTOPENED;
+}
+
+//====================================================
+EStreamError XMLWriter::ReadNodeAttribute(
+    const chargr  * name, 
+    unsigned        nameLen, 
+    chargr        * value, 
+    unsigned        valueLen
+) const {
+    ASSERTMSGGR(false, "XML writers are write only");
+    return STREAM_ERROR_FILENOTOPENED;
+}
+
+//====================================================
+EStreamError XMLWriter::ReadChildNode() {
+    ASSERTMSGGR(false, "XML writers are write only");
+    return STREAM_ERROR_NODEDOESNTEXIST;
+}
+
+//====================================================
+EStreamError XMLWriter::ReadNodeNameView(StreamTextView * name) const {
+    ASSERTMSGGR(false, "XML writers are write only");
+    return STREAM_ERROR_FILENOTOPENED;
+}
+
+//====================================================
+EStreamError XMLWriter::ReadNodeValueView(StreamTextView * value) const {
+    ASSERTMSGGR(false, "XML writers are write only");
+    return STREAM_ERROR_FILENOTOPENED;
+}
+
+//====================================================
+EStreamError XMLWriter::ReadNodeAttributeView(const charsys * name, StreamTextView * value) const {
+    ASSERTMSGGR(false, "XML writers are write only");
+    return STREAM_ERROR_FILENOTOPENED;
+}
+
+//====================================================
+EStreamError XMLWriter::ReadNodeNameHash(Hash32 * name) const {
+    ASSERTMSGGR(false, "XML writers are write only");
+    return STREAM_ERROR_FILENOTOPENED;
+}
+
+//====================================================
+EStreamError XMLWriter::ReadNodeAttributeHash(Hash32 name, Hash32 * value) const {
+    ASSERTMSGGR(false, "XML writers are write only");
+    return STREAM_ERROR_FILENOTOPENED;
+}
+
+//====================================================
+void XMLWriter::Write(const char * str, unsigned len) {
+    EStreamError result = m_stream.WriteBytes(str, len);
+    if (m_result == STREAM_ERROR_OK) 
+        m_result = result;
+}
+
+//====================================================
+void XMLWriter::WriteIndent(unsigned depth) {
+    for (unsigned i = 0; i < depth; i++) 
+        Write(s_indent, sizeof(s_indent) - 1);
+}
+
+//====================================================
+// Encodes to UTF-8 and escapes what tinyxml escapes, a byte at a time 
+//  through the stream's lent block
+void XMLWriter::WriteEscaped(const chargr * str) {
+    for (; *str != 0; str++) {
+        unsigned c = static_cast<unsigned>(*str);
+        if (c >= 0xd800 && c < 0xdc00 && str[1] >= 0xdc00 && str[1] < 0xe000) {
+            str++;
+            c = 0x10000 + ((c - 0xd800) << 10) + (static_cast<unsigned>(*str) - 0xdc00);
+        }
+
+        if (c < 0x80) {
+            switch (c) {
+                case '&':   Write("&amp;", 5);  break;
+                case '<':   Write("&lt;", 4);   break;
+                case '>':   Write("&gt;", 4);   break;
+                case '"':   Write("&quot;", 6); break;
+                case '\'':  Write("&apos;", 6); break;
+                default:
+                    if (c < 32) {
+                        char code[8];
+                        StrPrintf(code, 8, "&#x%02X;", c);
+                        Write(code, 6);
+                    }
+                    else
+                        m_stream.Write<uint8>(static_cast<uint8>(c));
+            }
+        }
+        else if (c < 0x800) {
+            m_stream.Write<uint8>(static_cast<uint8>(0xc0 | (c >> 6)));
+            m_stream.Write<uint8>(static_cast<uint8>(0x80 | (c & 0x3f)));
+        }
+        else if (c < 0x10000) {
+            m_stream.Write<uint8>(static_cast<uint8>(0xe0 | (c >> 12)));
+            m_stream.Write<uint8>(static_cast<uint8>(0x80 | ((c >> 6) & 0x3f)));
+            m_stream.Write<uint8>(static_cast<uint8>(0x80 | (c & 0x3f)));
+        }
+        else {
+            m_stream.Write<uint8>(static_cast<uint8>(0xf0 | (c >> 18)));
+            m_stream.Write<uint8>(static_cast<uint8>(0x80 | ((c >> 12) & 0x3f)));
+            m_stream.Write<uint8>(static_cast<uint8>(0x80 | ((c >> 6) & 0x3f)));
+            m_stream.Write<uint8>(static_cast<uint8>(0x80 | (c & 0x3f)));
+        }
+    }
+}
+
+//====================================================
+void XMLWriter::CloseStartTag() {
+    if (m_startTagOpen) 
+        Write(">", 1);
+    m_startTagOpen = false;
+}
+
+} // namespace NSXMLWriter
+
+//////////////////////////////////////////////////////
+//
+// External functions
+//
+
+//====================================================
+IStructuredTextStreamPtr StreamCreateXMLWriter(IRawStreamPtr target, const chargr * name) {
+    if (target == NULL) 
+        return IStructuredTextStreamPtr(NULL);
+
+    return IStructuredTextStreamPtr(new(XML_WRITER_MEM_FLAGS) NSXMLWriter::XMLWriter(target, name));
+}
+
+//====================================================
+IStructuredTextStreamPtr StreamCreateXMLWriter(const chargr * fileName) {
+    return StreamCreateXMLWriter(StreamCreateFile(fileName), fileName);
+}
@@ -29,6 +29,7 @@
 
 #include <stdio.h>
 #include <math.h>
+#include <string.h>
 
 #define USES_LIBS_REFLECTION
 #define USES_LIBS_STREAM